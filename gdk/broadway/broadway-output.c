@@ -4,6 +4,7 @@
 #include <assert.h>
 #include <errno.h>
 #include <cairo.h>
+#include <zlib.h>
 
 #include "broadway-output.h"
 
@@ -19,11 +20,19 @@ struct BroadwayOutput {
   GString *buf;
   int error;
   guint32 serial;
+
+  /* permessage-deflate (RFC 7692), with the context taken over
+   * from message to message, so repeated node trees get cheap */
+  gboolean compress;
+  z_stream zstream;
+  GByteArray *zbuf;
+  gsize texture_bytes; /* already compressed, in buf */
 };
 
 static void
 broadway_output_send_cmd (BroadwayOutput *output,
-                          gboolean fin, BroadwayWSOpCode code,
+                          gboolean fin, gboolean compressed,
+                          BroadwayWSOpCode code,
                           const void *buf, gsize count)
 {
   gboolean mask = FALSE;
@@ -34,7 +43,7 @@ broadway_output_send_cmd (BroadwayOutput *output,
   gboolean long_header = count > 65535;
 
   /* NB. big-endian spec => bit 0 == MSB */
-  header[0] = ( (fin ? 0x80 : 0) | (code & 0x0f) );
+  header[0] = ( (fin ? 0x80 : 0) | (compressed ? 0x40 : 0) | (code & 0x0f) );
   header[1] = ( (mask ? 0x80 : 0) |
                 (mid_header ? 126 : long_header ? 127 : count) );
   p = 2;
@@ -56,7 +65,32 @@ broadway_output_send_cmd (BroadwayOutput *output,
 
 void broadway_output_pong (BroadwayOutput *output)
 {
-  broadway_output_send_cmd (output, TRUE, BROADWAY_WS_CNX_PONG, NULL, 0);
+  broadway_output_send_cmd (output, TRUE, FALSE, BROADWAY_WS_CNX_PONG, NULL, 0);
+}
+
+static gboolean
+broadway_output_deflate (BroadwayOutput *output)
+{
+  z_stream *zs = &output->zstream;
+  gsize len;
+
+  g_byte_array_set_size (output->zbuf, deflateBound (zs, output->buf->len) + 16);
+
+  zs->next_in = (Bytef *) output->buf->str;
+  zs->avail_in = output->buf->len;
+  zs->next_out = output->zbuf->data;
+  zs->avail_out = output->zbuf->len;
+
+  if (deflate (zs, Z_SYNC_FLUSH) != Z_OK || zs->avail_in != 0)
+    return FALSE;
+
+  len = output->zbuf->len - zs->avail_out;
+
+  /* The message must not contain the 00 00 ff ff trailer of the flush */
+  g_assert (len >= 4);
+  g_byte_array_set_size (output->zbuf, len - 4);
+
+  return TRUE;
 }
 
 int
@@ -65,17 +99,25 @@ broadway_output_flush (BroadwayOutput *output)
   if (output->buf->len == 0)
     return TRUE;
 
-  broadway_output_send_cmd (output, TRUE, BROADWAY_WS_BINARY,
-                            output->buf->str, output->buf->len);
+  /* Textures are PNG or JPEG, compressing them again is a waste */
+  if (output->compress &&
+      output->texture_bytes < output->buf->len / 2 &&
+      broadway_output_deflate (output))
+    broadway_output_send_cmd (output, TRUE, TRUE, BROADWAY_WS_BINARY,
+                              output->zbuf->data, output->zbuf->len);
+  else
+    broadway_output_send_cmd (output, TRUE, FALSE, BROADWAY_WS_BINARY,
+                              output->buf->str, output->buf->len);
 
   g_string_set_size (output->buf, 0);
+  output->texture_bytes = 0;
 
   return !output->error;
 
 }
 
 BroadwayOutput *
-broadway_output_new (GOutputStream *out, guint32 serial)
+broadway_output_new (GOutputStream *out, guint32 serial, gboolean compress)
 {
   BroadwayOutput *output;
 
@@ -85,12 +127,26 @@ broadway_output_new (GOutputStream *out, guint32 serial)
   output->buf = g_string_new ("");
   output->serial = serial;
 
+  /* Raw deflate with the maximum window, as the extension requires */
+  if (compress &&
+      deflateInit2 (&output->zstream, Z_BEST_SPEED, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) == Z_OK)
+    {
+      output->compress = TRUE;
+      output->zbuf = g_byte_array_new ();
+    }
+
   return output;
 }
 
 void
 broadway_output_free (BroadwayOutput *output)
 {
+  if (output->compress)
+    {
+      deflateEnd (&output->zstream);
+      g_byte_array_unref (output->zbuf);
+    }
+
   g_object_unref (output->out);
   free (output);
 }
@@ -399,6 +455,12 @@ should_reuse_node (BroadwayOutput *output,
   if (node->type != old_node->type)
     return FALSE;
 
+  /* The browser wraps the children of these in extra divs, so
+   * we can't patch the children in place */
+  if (node->type == BROADWAY_NODE_BLEND ||
+      node->type == BROADWAY_NODE_CROSS_FADE)
+    return FALSE;
+
   if (broadway_node_equal (node, old_node))
     return TRUE;
 
@@ -609,6 +671,7 @@ broadway_output_upload_texture (BroadwayOutput *output,
   append_uint32 (output, id);
   append_uint32 (output, (guint32)len);
   g_string_append_len (output->buf, g_bytes_get_data (texture, NULL), len);
+  output->texture_bytes += len;
 }
 
 void
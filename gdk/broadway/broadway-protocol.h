@@ -23,6 +23,12 @@ typedef enum { /* Sync changes with broadway.js and node_type_is_container() */
   BROADWAY_NODE_TRANSFORM = 11,
   BROADWAY_NODE_DEBUG = 12,
   BROADWAY_NODE_REUSE = 13,
+  BROADWAY_NODE_RADIAL_GRADIENT = 14,
+  BROADWAY_NODE_CONIC_GRADIENT = 15,
+  BROADWAY_NODE_BLEND = 16,
+  BROADWAY_NODE_CROSS_FADE = 17,
+  BROADWAY_NODE_TEXT = 18,
+  BROADWAY_NODE_GLYPH = 19,
 } BroadwayNodeType;
 
 typedef enum { /* Sync changes with broadway.js */
@@ -48,6 +54,12 @@ static const char *broadway_node_type_names[] G_GNUC_UNUSED =  {
   "TRANSFORM",
   "DEBUG",
   "REUSE",
+  "RADIAL_GRADIENT",
+  "CONIC_GRADIENT",
+  "BLEND",
+  "CROSS_FADE",
+  "TEXT",
+  "GLYPH",
 };
 
 typedef enum {
@@ -66,6 +78,7 @@ typedef enum {
   BROADWAY_EVENT_SCREEN_SIZE_CHANGED = 12,
   BROADWAY_EVENT_FOCUS = 13,
   BROADWAY_EVENT_ROUNDTRIP_NOTIFY = 14,
+  BROADWAY_EVENT_FRAME_PRESENTED = 15, /* Only seen by broadwayd */
 } BroadwayEventType;
 
 typedef enum {
@@ -11,6 +11,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <errno.h>
+#include <zlib.h>
 
 #ifdef HAVE_UNISTD_H
 #include <unistd.h>
@@ -39,6 +40,7 @@
 typedef struct {
   int id;
   guint32 tag;
+  gboolean deferred; /* Not sent yet, waiting for the frame of the surface */
 } BroadwayOutstandingRoundtrip;
 
 typedef struct BroadwayInput BroadwayInput;
@@ -57,6 +59,7 @@ struct _BroadwayServer {
   guint64 last_seen_time;
   BroadwayInput *input;
   GList *input_messages;
+  guint n_input_messages;
   guint process_input_idle;
 
   GHashTable *surface_id_hash;
@@ -88,6 +91,13 @@ struct _BroadwayServer {
   int future_mouse_in_surface;
 
   GList *outstanding_roundtrips;
+
+  /* Statistics, reset every time they are printed */
+  guint stats_timeout;
+  guint frames_sent;
+  guint frames_coalesced;
+  guint motions_coalesced;
+  guint max_input_messages;
 };
 
 struct _BroadwayServerClass
@@ -112,6 +122,12 @@ struct BroadwayInput {
   gboolean seen_time;
   gint64 time_base;
   gboolean active;
+
+  /* permessage-deflate, we ask the client not to take over the
+   * context, so every message inflates on its own */
+  gboolean inflate;
+  z_stream zstream;
+  GByteArray *zbuf;
 };
 
 struct BroadwaySurface {
@@ -126,6 +142,13 @@ struct BroadwaySurface {
   guint32 texture;
   BroadwayNode *nodes;
   GHashTable *node_lookup;
+
+  /* We only send a new frame once the browser presented the last one,
+   * so nodes may be newer than what we diff against */
+  BroadwayNode *sent_nodes;
+  GHashTable *sent_node_lookup;
+  gboolean frame_pending; /* Waiting for the browser to present sent_nodes */
+  gboolean nodes_pending; /* nodes have not been sent yet */
 };
 
 struct _BroadwayTexture {
@@ -136,6 +159,10 @@ struct _BroadwayTexture {
 
 static void broadway_server_resync_surfaces (BroadwayServer *server);
 static void send_outstanding_roundtrips (BroadwayServer *server);
+static void frame_presented (BroadwayServer *server,
+                             guint32         id);
+static void send_deferred_roundtrips (BroadwayServer *server,
+                                     int             id);
 
 static void broadway_server_ref_texture (BroadwayServer   *server,
                                          guint32           id);
@@ -288,6 +315,8 @@ broadway_server_finalize (GObject *object)
   g_free (server->ssl_cert);
   g_free (server->ssl_key);
   g_hash_table_destroy (server->textures);
+  if (server->stats_timeout)
+    g_source_remove (server->stats_timeout);
 
   G_OBJECT_CLASS (broadway_server_parent_class)->finalize (object);
 }
@@ -306,7 +335,10 @@ broadway_surface_free (BroadwayServer *server,
 {
   if (surface->nodes)
     broadway_node_unref (server, surface->nodes);
+  if (surface->sent_nodes)
+    broadway_node_unref (server, surface->sent_nodes);
   g_hash_table_unref (surface->node_lookup);
+  g_hash_table_unref (surface->sent_node_lookup);
   g_free (surface);
 }
 
@@ -336,6 +368,11 @@ broadway_input_free (BroadwayInput *input)
   g_object_unref (input->connection);
   g_byte_array_free (input->buffer, FALSE);
   g_source_destroy (input->source);
+  if (input->inflate)
+    {
+      inflateEnd (&input->zstream);
+      g_byte_array_unref (input->zbuf);
+    }
   g_free (input);
 }
 
@@ -531,6 +568,7 @@ process_input_messages (BroadwayServer *server)
       server->input_messages =
         g_list_delete_link (server->input_messages,
                             server->input_messages);
+      server->n_input_messages--;
 
       if (message->base.serial == 0)
         {
@@ -605,7 +643,27 @@ update_future_pointer_info (BroadwayServer *server, BroadwayInputPointerMsg *dat
 static void
 queue_input_message (BroadwayServer *server, BroadwayInputMsg *msg)
 {
+  /* When the clients fall behind, only the last of a series of
+   * motions matters, so replace the queued one */
+  if (msg->base.type == BROADWAY_EVENT_POINTER_MOVE &&
+      server->input_messages != NULL)
+    {
+      BroadwayInputMsg *last = g_list_last (server->input_messages)->data;
+
+      if (last->base.type == BROADWAY_EVENT_POINTER_MOVE &&
+          last->pointer.mouse_surface_id == msg->pointer.mouse_surface_id &&
+          last->pointer.event_surface_id == msg->pointer.event_surface_id &&
+          last->pointer.state == msg->pointer.state)
+        {
+          *last = *msg;
+          server->motions_coalesced++;
+          return;
+        }
+    }
+
   server->input_messages = g_list_append (server->input_messages, g_memdup (msg, sizeof (BroadwayInputMsg)));
+  server->n_input_messages++;
+  server->max_input_messages = MAX (server->max_input_messages, server->n_input_messages);
 }
 
 static void
@@ -726,6 +784,10 @@ parse_input_message (BroadwayInput *input, const unsigned char *message)
     msg.screen_resize_notify.scale = ntohl (*p++);
     break;
 
+  case BROADWAY_EVENT_FRAME_PRESENTED:
+    frame_presented (server, ntohl (*p++));
+    return; /* Not for the clients */
+
   default:
     g_printerr ("parse_input_message - Unknown input command %c (%s)\n", msg.base.type, message);
     break;
@@ -763,6 +825,51 @@ hex_dump (guchar *data, gsize len)
 #endif
 }
 
+static gboolean
+inflate_input_message (BroadwayInput *input,
+                       const guchar  *data,
+                       gsize          len)
+{
+  static const guchar trailer[] = { 0x00, 0x00, 0xff, 0xff };
+  z_stream *zs = &input->zstream;
+  guchar out[4096];
+  int res;
+
+  if (!input->inflate)
+    return FALSE;
+
+  g_byte_array_set_size (input->zbuf, 0);
+  inflateReset (zs);
+
+  zs->next_in = (Bytef *) data;
+  zs->avail_in = len;
+  do
+    {
+      zs->next_out = out;
+      zs->avail_out = sizeof (out);
+      res = inflate (zs, Z_SYNC_FLUSH);
+      g_byte_array_append (input->zbuf, out, sizeof (out) - zs->avail_out);
+    }
+  while (res == Z_OK && zs->avail_in > 0);
+
+  if (res != Z_OK && res != Z_BUF_ERROR && res != Z_STREAM_END)
+    return FALSE;
+
+  /* The sender strips the end of the final flush, we add it back */
+  zs->next_in = (Bytef *) trailer;
+  zs->avail_in = sizeof (trailer);
+  do
+    {
+      zs->next_out = out;
+      zs->avail_out = sizeof (out);
+      res = inflate (zs, Z_SYNC_FLUSH);
+      g_byte_array_append (input->zbuf, out, sizeof (out) - zs->avail_out);
+    }
+  while (res == Z_OK && zs->avail_out == 0);
+
+  return input->zbuf->len > 0;
+}
+
 static void
 parse_input (BroadwayInput *input)
 {
@@ -775,7 +882,7 @@ parse_input (BroadwayInput *input)
     {
       gsize len, payload_len;
       BroadwayWSOpCode code;
-      gboolean is_mask, fin;
+      gboolean is_mask, fin, compressed;
       guchar *buf, *data, *mask;
 
       buf = input->buffer->data;
@@ -786,6 +893,7 @@ parse_input (BroadwayInput *input)
 #endif
 
       fin = buf[0] & 0x80;
+      compressed = buf[0] & 0x40;
       code = buf[0] & 0x0f;
       payload_len = buf[1] & 0x7f;
       is_mask = buf[1] & 0x80;
@@ -835,6 +943,11 @@ parse_input (BroadwayInput *input)
             g_warning ("can't yet accept fragmented input");
 #endif
           }
+        else if (compressed)
+          {
+            if (inflate_input_message (input, data, payload_len))
+              parse_input_message (input, input->zbuf->data);
+          }
         else
           {
             parse_input_message (input, data);
@@ -1007,11 +1120,17 @@ broadway_server_roundtrip (BroadwayServer *server,
   if (server->output)
     {
       BroadwayOutstandingRoundtrip *rt = g_new0 (BroadwayOutstandingRoundtrip, 1);
+      BroadwaySurface *surface = broadway_server_lookup_surface (server, id);
+
       rt->id = id;
       rt->tag = tag;
       server->outstanding_roundtrips = g_list_prepend (server->outstanding_roundtrips, rt);
 
-      broadway_output_roundtrip (server->output, id, tag);
+      /* Clients wait for the reply before drawing their next frame,
+       * so holding it back until the browser caught up paces them */
+      rt->deferred = surface != NULL && surface->frame_pending;
+      if (!rt->deferred)
+        broadway_output_roundtrip (server->output, id, tag);
     }
   else
     broadway_server_fake_roundtrip_reply (server, id, tag);
@@ -1090,6 +1209,7 @@ start_input (HttpRequest *request)
   int i;
   char *res;
   const char *origin, *host;
+  gboolean use_deflate;
   BroadwayInput *input;
   const void *data_buffer;
   gsize data_buffer_size;
@@ -1106,10 +1226,13 @@ start_input (HttpRequest *request)
   key = NULL;
   origin = NULL;
   host = NULL;
+  use_deflate = FALSE;
   for (i = 0; lines[i] != NULL; i++)
     {
       if ((p = parse_line (lines[i], "Sec-WebSocket-Key")))
         key = p;
+      else if ((p = parse_line (lines[i], "Sec-WebSocket-Extensions")))
+        use_deflate |= strstr (p, "permessage-deflate") != NULL;
       else if ((p = parse_line (lines[i], "Origin")))
         origin = p;
       else if ((p = parse_line (lines[i], "Host")))
@@ -1133,10 +1256,12 @@ start_input (HttpRequest *request)
                              "Connection: Upgrade\r\n"
                              "Sec-WebSocket-Accept: %s\r\n"
                              "%s%s%s"
+                             "%s"
                              "Sec-WebSocket-Location: ws://%s/socket\r\n"
                              "Sec-WebSocket-Protocol: broadway\r\n"
                              "\r\n", accept,
                              origin?"Sec-WebSocket-Origin: ":"", origin?origin:"", origin?"\r\n":"",
+                             use_deflate?"Sec-WebSocket-Extensions: permessage-deflate; client_no_context_takeover\r\n":"",
                              host);
       g_free (accept);
 
@@ -1167,8 +1292,14 @@ start_input (HttpRequest *request)
   input->buffer = g_byte_array_sized_new (data_buffer_size);
   g_byte_array_append (input->buffer, data_buffer, data_buffer_size);
 
+  if (use_deflate && inflateInit2 (&input->zstream, -15) == Z_OK)
+    {
+      input->inflate = TRUE;
+      input->zbuf = g_byte_array_new ();
+    }
+
   input->output =
-    broadway_output_new (g_io_stream_get_output_stream (request->connection), 0);
+    broadway_output_new (g_io_stream_get_output_stream (request->connection), 0, use_deflate);
 
   /* This will free and close the data input stream, but we got all the buffered content already */
   http_request_free (request);
@@ -1585,6 +1716,8 @@ broadway_server_destroy_surface (BroadwayServer *server,
   surface = broadway_server_lookup_surface (server, id);
   if (surface != NULL)
     {
+      send_deferred_roundtrips (server, id);
+
       server->surfaces = g_list_remove (server->surfaces, surface);
       g_hash_table_remove (server->surface_id_hash,
                            GINT_TO_POINTER (id));
@@ -1710,6 +1843,54 @@ broadway_server_surface_set_transient_for (BroadwayServer *server,
     }
 }
 
+static gboolean
+print_stats_cb (gpointer data)
+{
+  BroadwayServer *server = data;
+  guint frames_pending = 0;
+  GList *l;
+
+  for (l = server->surfaces; l != NULL; l = l->next)
+    {
+      BroadwaySurface *surface = l->data;
+
+      if (surface->frame_pending)
+        frames_pending++;
+    }
+
+  g_print ("frames: %u sent, %u coalesced, %u waiting for the browser; "
+           "input: %u motions coalesced, queue depth %u (max %u)\n",
+           server->frames_sent, server->frames_coalesced, frames_pending,
+           server->motions_coalesced, server->n_input_messages, server->max_input_messages);
+
+  server->frames_sent = 0;
+  server->frames_coalesced = 0;
+  server->motions_coalesced = 0;
+  server->max_input_messages = server->n_input_messages;
+
+  return G_SOURCE_CONTINUE;
+}
+
+/* Periodically prints how well the browser and the clients keep up */
+void
+broadway_server_set_print_stats (BroadwayServer *server,
+                                 gboolean        print_stats)
+{
+  if (print_stats == (server->stats_timeout != 0))
+    return;
+
+  if (print_stats)
+    {
+      server->stats_timeout = g_timeout_add_seconds (5, print_stats_cb, server);
+      g_source_set_name_by_id (server->stats_timeout, "[broadway] print stats");
+    }
+  else
+    {
+      g_source_remove (server->stats_timeout);
+      server->stats_timeout = 0;
+    }
+}
+
 gboolean
 broadway_server_has_client (BroadwayServer *server)
 {
@@ -1807,6 +1988,32 @@ decode_nodes (BroadwayServer *server,
     n_stops = data[*pos + size++];
     size += n_stops * NODE_SIZE_COLOR_STOP;
     break;
+  case BROADWAY_NODE_RADIAL_GRADIENT:
+    size = NODE_SIZE_RECT + NODE_SIZE_POINT + 4 * NODE_SIZE_FLOAT + 1;
+    n_stops = data[*pos + size++];
+    size += n_stops * NODE_SIZE_COLOR_STOP;
+    break;
+  case BROADWAY_NODE_CONIC_GRADIENT:
+    size = NODE_SIZE_RECT + NODE_SIZE_POINT + NODE_SIZE_FLOAT;
+    n_stops = data[*pos + size++];
+    size += n_stops * NODE_SIZE_COLOR_STOP;
+    break;
+  case BROADWAY_NODE_GLYPH:
+    texture_offset = 4;
+    size = 5;
+    break;
+  case BROADWAY_NODE_TEXT:
+    size = NODE_SIZE_COLOR + 1;
+    n_children = data[*pos + NODE_SIZE_COLOR];
+    break;
+  case BROADWAY_NODE_BLEND:
+    size = 1;
+    n_children = 2;
+    break;
+  case BROADWAY_NODE_CROSS_FADE:
+    size = NODE_SIZE_FLOAT;
+    n_children = 2;
+    break;
   case BROADWAY_NODE_SHADOW:
     size = 1;
     n_shadows = data[*pos];
@@ -1862,6 +2069,73 @@ decode_nodes (BroadwayServer *server,
   return node;
 }
 
+static void
+send_surface_nodes (BroadwayServer  *server,
+                    BroadwaySurface *surface)
+{
+  broadway_output_surface_set_nodes (server->output, surface->id,
+                                     surface->nodes,
+                                     surface->sent_nodes,
+                                     surface->sent_node_lookup);
+
+  if (surface->sent_nodes)
+    broadway_node_unref (server, surface->sent_nodes);
+  surface->sent_nodes = broadway_node_ref (surface->nodes);
+
+  g_hash_table_remove_all (surface->sent_node_lookup);
+  broadway_node_add_to_lookup (surface->nodes, surface->sent_node_lookup);
+
+  surface->nodes_pending = FALSE;
+  surface->frame_pending = TRUE;
+  server->frames_sent++;
+}
+
+static void
+send_deferred_roundtrips (BroadwayServer *server,
+                          int             id)
+{
+  GList *l;
+
+  if (server->output == NULL)
+    return;
+
+  /* Oldest first, the list is in reverse order */
+  for (l = g_list_last (server->outstanding_roundtrips); l != NULL; l = l->prev)
+    {
+      BroadwayOutstandingRoundtrip *rt = l->data;
+
+      if (rt->id == id && rt->deferred)
+        {
+          rt->deferred = FALSE;
+          broadway_output_roundtrip (server->output, rt->id, rt->tag);
+        }
+    }
+}
+
+/* The browser displayed the last nodes we sent for the surface */
+static void
+frame_presented (BroadwayServer *server,
+                 guint32         id)
+{
+  BroadwaySurface *surface;
+
+  surface = broadway_server_lookup_surface (server, id);
+  if (surface == NULL || !surface->frame_pending)
+    return;
+
+  surface->frame_pending = FALSE;
+
+  if (server->output == NULL)
+    return;
+
+  if (surface->nodes_pending)
+    send_surface_nodes (server, surface);
+
+  send_deferred_roundtrips (server, id);
+
+  broadway_server_flush (server);
+}
+
 /* passes ownership of nodes */
 void
 broadway_server_surface_update_nodes (BroadwayServer   *server,
@@ -1880,12 +2154,6 @@ broadway_server_surface_update_nodes (BroadwayServer   *server,
 
   root = decode_nodes (server, surface, len, data, client_texture_map, &pos);
 
-  if (server->output != NULL)
-    broadway_output_surface_set_nodes (server->output, surface->id,
-                                       root,
-                                       surface->nodes,
-                                       surface->node_lookup);
-
   if (surface->nodes)
     broadway_node_unref (server, surface->nodes);
 
@@ -1893,6 +2161,19 @@ broadway_server_surface_update_nodes (BroadwayServer   *server,
 
   g_hash_table_remove_all (surface->node_lookup);
   broadway_node_add_to_lookup (root, surface->node_lookup);
+
+  if (server->output == NULL)
+    return;
+
+  if (surface->frame_pending)
+    {
+      /* Replace the frame that is still waiting, if any */
+      if (surface->nodes_pending)
+        server->frames_coalesced++;
+      surface->nodes_pending = TRUE;
+    }
+  else
+    send_surface_nodes (server, surface);
 }
 
 guint32
@@ -2086,6 +2367,7 @@ broadway_server_new_surface (BroadwayServer *server,
   surface->width = width;
   surface->height = height;
   surface->node_lookup = g_hash_table_new (g_direct_hash, g_direct_equal);
+  surface->sent_node_lookup = g_hash_table_new (g_direct_hash, g_direct_equal);
 
   g_hash_table_insert (server->surface_id_hash,
                        GINT_TO_POINTER (surface->id),
@@ -2154,10 +2436,17 @@ broadway_server_resync_surfaces (BroadwayServer *server)
         broadway_output_set_transient_for (server->output, surface->id,
                                            surface->transient_for);
 
+      /* The new browser has no old nodes */
+      if (surface->sent_nodes)
+        {
+          broadway_node_unref (server, surface->sent_nodes);
+          surface->sent_nodes = NULL;
+          g_hash_table_remove_all (surface->sent_node_lookup);
+        }
+      surface->frame_pending = FALSE;
+
       if (surface->nodes)
-        broadway_output_surface_set_nodes (server->output, surface->id,
-                                           surface->nodes,
-                                           NULL, NULL);
+        send_surface_nodes (server, surface);
 
       if (surface->visible)
         broadway_output_show_surface (server->output, surface->id);
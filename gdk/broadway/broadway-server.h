@@ -57,6 +57,8 @@ BroadwayServer     *broadway_server_new                       (char            *
 BroadwayServer     *broadway_server_on_unix_socket_new        (char            *address,
                                                                GError         **error);
 gboolean            broadway_server_has_client                (BroadwayServer  *server);
+void                broadway_server_set_print_stats           (BroadwayServer  *server,
+                                                               gboolean         print_stats);
 void                broadway_server_flush                     (BroadwayServer  *server);
 void                broadway_server_sync                      (BroadwayServer  *server);
 void                broadway_server_roundtrip                 (BroadwayServer  *server,
@@ -14,6 +14,12 @@ const BROADWAY_NODE_CLIP = 10;
 const BROADWAY_NODE_TRANSFORM = 11;
 const BROADWAY_NODE_DEBUG = 12;
 const BROADWAY_NODE_REUSE = 13;
+const BROADWAY_NODE_RADIAL_GRADIENT = 14;
+const BROADWAY_NODE_CONIC_GRADIENT = 15;
+const BROADWAY_NODE_BLEND = 16;
+const BROADWAY_NODE_CROSS_FADE = 17;
+const BROADWAY_NODE_TEXT = 18;
+const BROADWAY_NODE_GLYPH = 19;
 
 const BROADWAY_NODE_OP_INSERT_NODE = 0;
 const BROADWAY_NODE_OP_REMOVE_NODE = 1;
@@ -54,6 +60,7 @@ const BROADWAY_EVENT_CONFIGURE_NOTIFY = 11;
 const BROADWAY_EVENT_SCREEN_SIZE_CHANGED = 12;
 const BROADWAY_EVENT_FOCUS = 13;
 const BROADWAY_EVENT_ROUNDTRIP_NOTIFY = 14;
+const BROADWAY_EVENT_FRAME_PRESENTED = 15;
 
 const DISPLAY_OP_REPLACE_CHILD = 0;
 const DISPLAY_OP_APPEND_CHILD = 1;
@@ -119,6 +126,13 @@ function encodeBase64Chunk (uint8, start, end) {
     return output.join('');
 }
 
+// Textures are PNG, or JPEG for photographic content
+function imageMimeType(uint8) {
+    if (uint8.length > 2 && uint8[0] == 0xFF && uint8[1] == 0xD8)
+        return "image/jpeg";
+    return "image/png";
+}
+
 function bytesToDataUri(uint8) {
     var tmp;
     var len = uint8.length;
@@ -126,7 +140,7 @@ function bytesToDataUri(uint8) {
     var parts = [];
     var maxChunkLength = 16383; // must be multiple of 3
 
-    parts.push("data:image/png;base64,");
+    parts.push("data:" + imageMimeType(uint8) + ";base64,");
 
     // go through the array every three bytes, we'll deal with trailing stuff later
     for (var i = 0, len2 = len - extraBytes; i < len2; i += maxChunkLength) {
@@ -232,6 +246,7 @@ var textures = {};
 var stackingOrder = [];
 var outstandingCommands = new Array();
 var outstandingDisplayCommands = null;
+var outstandingPresentedSurfaces = [];
 var inputSocket = null;
 var debugDecoding = false;
 var fakeInput = null;
@@ -258,7 +273,7 @@ function Texture(id, data) {
     if (useDataUrls) {
         url = bytesToDataUri(data);
     } else {
-        var blob = new Blob([data],{type: "image/png"});
+        var blob = new Blob([data],{type: imageMimeType(data)});
         url = window.URL.createObjectURL(blob);
     }
 
@@ -539,6 +554,26 @@ function args() {
     return strings.join(" ");
 }
 
+// In the order of GskBlendMode
+const blendModes = [
+    "normal",
+    "multiply",
+    "screen",
+    "overlay",
+    "darken",
+    "lighten",
+    "color-dodge",
+    "color-burn",
+    "hard-light",
+    "soft-light",
+    "difference",
+    "exclusion",
+    "color",
+    "hue",
+    "saturation",
+    "luminosity",
+];
+
 function px(x) {
     return x + "px";
 }
@@ -734,8 +769,142 @@ TransformNodes.prototype.insertNode = function(parent, previousSibling, is_tople
         break;
 
 
+    case BROADWAY_NODE_RADIAL_GRADIENT:
+        {
+            var rect = this.decode_rect();
+            var center = this.decode_point ();
+            var hradius = this.decode_float ();
+            var vradius = this.decode_float ();
+            var start = this.decode_float ();
+            var end = this.decode_float ();
+            var repeat = this.decode_uint32 ();
+            var stops = this.decode_color_stops ();
+            var div = this.createDiv(id);
+            div.style["position"] = "absolute";
+            set_rect_style(div, rect);
+
+            // Offsets are relative to the start..end range of the radii
+            var gradient = (repeat ? "repeating-radial-gradient(" : "radial-gradient(") +
+                args("ellipse", px(hradius), px(vradius), "at", px(center.x - rect.x), px(center.y - rect.y));
+            for (var i = 0; i < stops.length; i++) {
+                var stop = stops[i];
+                gradient = gradient + ", " + stop.color + " " + ((start + stop.offset * (end - start)) * 100) + "%";
+            }
+            gradient = gradient + ")";
+
+            div.style["background-image"] = gradient;
+            newNode = div;
+        }
+        break;
+
+    case BROADWAY_NODE_CONIC_GRADIENT:
+        {
+            var rect = this.decode_rect();
+            var center = this.decode_point ();
+            var rotation = this.decode_float ();
+            var stops = this.decode_color_stops ();
+            var div = this.createDiv(id);
+            div.style["position"] = "absolute";
+            set_rect_style(div, rect);
+
+            var gradient = "conic-gradient(" +
+                args("from", rotation + "deg", "at", px(center.x - rect.x), px(center.y - rect.y));
+            for (var i = 0; i < stops.length; i++) {
+                var stop = stops[i];
+                gradient = gradient + ", " + stop.color + " " + (stop.offset * 360) + "deg";
+            }
+            gradient = gradient + ")";
+
+            div.style["background-image"] = gradient;
+            newNode = div;
+        }
+        break;
+
+    case BROADWAY_NODE_GLYPH:
+        {
+            var rect = this.decode_rect();
+            var texture_id = this.decode_uint32();
+            var div = this.createDiv(id);
+            div.style["position"] = "absolute";
+            set_rect_style(div, rect);
+            // The glyph texture is only used as alpha mask, the color comes from the text node
+            var texture = textures[texture_id].ref();
+            div.style["background-color"] = "currentColor";
+            div.style["-webkit-mask-image"] = "url(" + texture.url + ")";
+            div.style["mask-image"] = "url(" + texture.url + ")";
+            div.style["-webkit-mask-size"] = "100% 100%";
+            div.style["mask-size"] = "100% 100%";
+            texture.decoded.then(function() { texture.unref(); });
+            newNode = div;
+        }
+        break;
+
     /* Bin nodes */
 
+    case BROADWAY_NODE_TEXT:
+        {
+            var color = this.decode_color();
+            var div = this.createDiv(id);
+            var len = this.decode_uint32();
+            div.style["position"] = "absolute";
+            div.style["left"] = px(0);
+            div.style["top"] = px(0);
+            div.style["color"] = color;
+            for (var i = 0; i < len; i++)
+                this.insertNode(div, null, false);
+            newNode = div;
+        }
+        break;
+
+    case BROADWAY_NODE_BLEND:
+        {
+            var mode = this.decode_uint32();
+            var div = this.createDiv(id);
+            div.style["position"] = "absolute";
+            div.style["left"] = px(0);
+            div.style["top"] = px(0);
+            div.style["isolation"] = "isolate";
+            this.insertNode(div, null, false);
+
+            // Wrap the top child, it may be a reused node
+            var top = document.createElement('div');
+            top.style["position"] = "absolute";
+            top.style["mix-blend-mode"] = blendModes[mode];
+            this.insertNode(top, null, false);
+            div.appendChild(top);
+
+            newNode = div;
+        }
+        break;
+
+    case BROADWAY_NODE_CROSS_FADE:
+        {
+            var progress = this.decode_float();
+            var div = this.createDiv(id);
+            div.style["position"] = "absolute";
+            div.style["left"] = px(0);
+            div.style["top"] = px(0);
+            div.style["isolation"] = "isolate";
+
+            // Both children get wrapped, they may be reused nodes, and
+            // then added up, so the result is start * (1 - progress) + end * progress
+            var start = document.createElement('div');
+            start.style["position"] = "absolute";
+            start.style["opacity"] = 1 - progress;
+            this.insertNode(start, null, false);
+            div.appendChild(start);
+
+            var end = document.createElement('div');
+            end.style["position"] = "absolute";
+            end.style["opacity"] = progress;
+            end.style["mix-blend-mode"] = "plus-lighter";
+            this.insertNode(end, null, false);
+            div.appendChild(end);
+
+            newNode = div;
+        }
+        break;
+
     case BROADWAY_NODE_TRANSFORM:
         {
             var transform_string = this.decode_transform();
@@ -1182,6 +1351,14 @@ function handleCommands(cmd, display_commands, new_textures, modified_trees)
     return res;
 }
 
+// Tells the server that it can send the next frame for these surfaces
+function sendFramesPresented()
+{
+    for (var i = 0; i < outstandingPresentedSurfaces.length; i++)
+        sendInput(BROADWAY_EVENT_FRAME_PRESENTED, [outstandingPresentedSurfaces[i]]);
+    outstandingPresentedSurfaces = [];
+}
+
 function handleOutstandingDisplayCommands()
 {
     if (outstandingDisplayCommands) {
@@ -1189,11 +1366,13 @@ function handleOutstandingDisplayCommands()
             function () {
                 handleDisplayCommands(outstandingDisplayCommands);
                 outstandingDisplayCommands = null;
+                sendFramesPresented();
 
                 if (outstandingCommands.length > 0)
                     setTimeout(handleOutstanding);
             });
     } else {
+        sendFramesPresented();
         if (outstandingCommands.length > 0)
             handleOutstanding ();
     }
@@ -1230,6 +1409,9 @@ function handleOutstanding()
     if (display_commands.length > 0)
         outstandingDisplayCommands = display_commands;
 
+    for (var id in modified_trees)
+        outstandingPresentedSurfaces.push(parseInt(id));
+
     if (new_textures.length > 0) {
         var decodes = [];
         for (var i = 0; i < new_textures.length; i++) {
@@ -537,6 +537,7 @@ main (int argc, char *argv[])
   char *ssl_key = NULL;
   const char *display;
   int port = 0;
+  gboolean print_stats = FALSE;
   const GOptionEntry entries[] = {
     { "port", 'p', 0, G_OPTION_ARG_INT, &http_port, "Httpd port", "PORT" },
     { "address", 'a', 0, G_OPTION_ARG_STRING, &http_address, "Ip address to bind to ", "ADDRESS" },
@@ -545,6 +546,7 @@ main (int argc, char *argv[])
 #endif
     { "cert", 'c', 0, G_OPTION_ARG_STRING, &ssl_cert, "SSL certificate path", "PATH" },
     { "key", 'k', 0, G_OPTION_ARG_STRING, &ssl_key, "SSL key path", "PATH" },
+    { "stats", 0, 0, G_OPTION_ARG_NONE, &print_stats, "Print frame and input statistics", NULL },
     { NULL }
   };
 
@@ -612,6 +614,8 @@ main (int argc, char *argv[])
       return 1;
     }
 
+  broadway_server_set_print_stats (server, print_stats);
+
   listener = g_socket_service_new ();
   if (!g_socket_listener_add_address (G_SOCKET_LISTENER (listener),
                                       address,
@@ -635,6 +635,59 @@ write_png_cb (void         *closure,
   return CAIRO_STATUS_SUCCESS;
 }
 
+static gboolean
+write_jpeg_cb (const char  *buf,
+               gsize        count,
+               GError     **error,
+               gpointer     data)
+{
+  return write_png_cb (data, (const guchar *) buf, count) == CAIRO_STATUS_SUCCESS;
+}
+
+/* PNG is lossless and great for UI elements, but photos and video frames
+ * come out many times bigger than as JPEG. We guess that from the number of
+ * distinct colors in a sample of the pixels, JPEG can't do alpha though.
+ */
+#define MIN_JPEG_SIZE 64
+#define JPEG_SAMPLES 32
+
+static gboolean
+surface_is_photographic (cairo_surface_t *surface)
+{
+  int width = cairo_image_surface_get_width (surface);
+  int height = cairo_image_surface_get_height (surface);
+  int stride = cairo_image_surface_get_stride (surface);
+  const guchar *data = cairo_image_surface_get_data (surface);
+  GHashTable *colors;
+  guint n_colors;
+  int x, y;
+
+  if (width < MIN_JPEG_SIZE || height < MIN_JPEG_SIZE)
+    return FALSE;
+
+  for (y = 0; y < height; y++)
+    {
+      const guint32 *row = (const guint32 *) (data + y * stride);
+
+      for (x = 0; x < width; x++)
+        if ((row[x] >> 24) != 0xff)
+          return FALSE;
+    }
+
+  colors = g_hash_table_new (NULL, NULL);
+  for (y = 0; y < JPEG_SAMPLES; y++)
+    {
+      const guint32 *row = (const guint32 *) (data + (y * height / JPEG_SAMPLES) * stride);
+
+      for (x = 0; x < JPEG_SAMPLES; x++)
+        g_hash_table_add (colors, GUINT_TO_POINTER (row[x * width / JPEG_SAMPLES]));
+    }
+  n_colors = g_hash_table_size (colors);
+  g_hash_table_unref (colors);
+
+  return n_colors > JPEG_SAMPLES * JPEG_SAMPLES / 2;
+}
+
 guint32
 gdk_broadway_server_upload_texture (GdkBroadwayServer *server,
                                     GdkTexture        *texture)
@@ -648,7 +701,28 @@ gdk_broadway_server_upload_texture (GdkBroadwayServer *server,
 
   data.fd = open_shared_memory ();
   data.size = 0;
-  cairo_surface_write_to_png_stream (surface, write_png_cb, &data);
+
+  if (surface_is_photographic (surface))
+    {
+      GdkPixbuf *pixbuf;
+
+      pixbuf = gdk_pixbuf_get_from_surface (surface, 0, 0,
+                                            cairo_image_surface_get_width (surface),
+                                            cairo_image_surface_get_height (surface));
+      if (!gdk_pixbuf_save_to_callback (pixbuf, write_jpeg_cb, &data,
+                                        "jpeg", NULL,
+                                        "quality", "85",
+                                        NULL))
+        {
+          /* Start over */
+          lseek (data.fd, 0, SEEK_SET);
+          data.size = 0;
+        }
+      g_object_unref (pixbuf);
+    }
+
+  if (data.size == 0)
+    cairo_surface_write_to_png_stream (surface, write_png_cb, &data);
 
   msg.id = id;
   msg.offset = 0;
@@ -37,6 +37,8 @@ void           gdk_surface_set_widget (GdkSurface *surface,
                                        gpointer    widget);
 gpointer       gdk_surface_get_widget (GdkSurface *surface);
 
+gint64         gdk_frame_timings_get_input_time (GdkFrameTimings *timings);
+
 typedef struct
 {
   const char *key;
@@ -150,6 +150,8 @@ static const GdkDebugKey gdk_debug_keys[] = {
   { "vulkan-disable",  GDK_DEBUG_VULKAN_DISABLE, "Disable Vulkan support" },
   { "vulkan-validate", GDK_DEBUG_VULKAN_VALIDATE, "Load the Vulkan validation layer" },
   { "default-settings",GDK_DEBUG_DEFAULT_SETTINGS, "Force default values for xsettings" },
+  { "no-event-compression", GDK_DEBUG_NO_EVENT_COMPRESSION, "Deliver every motion event" },
+  { "event-thread",    GDK_DEBUG_EVENT_THREAD, "Read events in a separate thread (Wayland)" },
 };
 
 
@@ -70,9 +70,16 @@ struct _GdkClipboardPrivate
   GdkContentFormats *formats;
   GdkContentProvider *content;
 
+  /* Values read from remote contents, most recently used first.
+   * Dropped whenever the clipboard is claimed again. */
+  GQueue cached_values;
+  guint content_serial;
+
   guint local : 1;
 };
 
+#define MAX_CACHED_VALUES 4
+
 enum {
   PROP_0,
   PROP_DISPLAY,
@@ -147,6 +154,71 @@ gdk_clipboard_get_property (GObject    *gobject,
     }
 }
 
+static void
+free_value (gpointer value)
+{
+  g_value_unset (value);
+  g_slice_free (GValue, value);
+}
+
+static void
+gdk_clipboard_clear_cached_values (GdkClipboard *clipboard)
+{
+  GdkClipboardPrivate *priv = gdk_clipboard_get_instance_private (clipboard);
+
+  g_queue_clear_full (&priv->cached_values, free_value);
+}
+
+static gboolean
+gdk_clipboard_lookup_cached_value (GdkClipboard *clipboard,
+                                   GValue       *value)
+{
+  GdkClipboardPrivate *priv = gdk_clipboard_get_instance_private (clipboard);
+  GList *l;
+
+  for (l = priv->cached_values.head; l; l = l->next)
+    {
+      GValue *cached = l->data;
+
+      if (G_VALUE_TYPE (cached) != G_VALUE_TYPE (value))
+        continue;
+
+      g_value_copy (cached, value);
+      g_queue_unlink (&priv->cached_values, l);
+      g_queue_push_head_link (&priv->cached_values, l);
+      return TRUE;
+    }
+
+  return FALSE;
+}
+
+static void
+gdk_clipboard_add_cached_value (GdkClipboard *clipboard,
+                                const GValue *value)
+{
+  GdkClipboardPrivate *priv = gdk_clipboard_get_instance_private (clipboard);
+  GValue *cached;
+  GList *l;
+
+  for (l = priv->cached_values.head; l; l = l->next)
+    {
+      if (G_VALUE_TYPE ((GValue *) l->data) == G_VALUE_TYPE (value))
+        {
+          free_value (l->data);
+          g_queue_delete_link (&priv->cached_values, l);
+          break;
+        }
+    }
+
+  if (priv->cached_values.length >= MAX_CACHED_VALUES)
+    free_value (g_queue_pop_tail (&priv->cached_values));
+
+  cached = g_slice_new0 (GValue);
+  g_value_init (cached, G_VALUE_TYPE (value));
+  g_value_copy (value, cached);
+  g_queue_push_head (&priv->cached_values, cached);
+}
+
 static void
 gdk_clipboard_finalize (GObject *object)
 {
@@ -154,6 +226,7 @@ gdk_clipboard_finalize (GObject *object)
   GdkClipboardPrivate *priv = gdk_clipboard_get_instance_private (clipboard);
 
   g_clear_pointer (&priv->formats, gdk_content_formats_unref);
+  gdk_clipboard_clear_cached_values (clipboard);
 
   G_OBJECT_CLASS (gdk_clipboard_parent_class)->finalize (object);
 }
@@ -704,21 +777,43 @@ gdk_clipboard_read_finish (GdkClipboard  *clipboard,
     }
 }
 
+typedef struct {
+  GValue value;
+  guint content_serial;
+} ReadValueData;
+
+static void
+read_value_data_free (gpointer data)
+{
+  ReadValueData *read = data;
+
+  g_value_unset (&read->value);
+  g_slice_free (ReadValueData, read);
+}
+
 static void
 gdk_clipboard_read_value_done (GObject      *source,
                                GAsyncResult *result,
                                gpointer      data)
 {
   GTask *task = data;
+  ReadValueData *read = g_task_get_task_data (task);
+  GdkClipboard *clipboard = g_task_get_source_object (task);
+  GdkClipboardPrivate *priv = gdk_clipboard_get_instance_private (clipboard);
   GError *error = NULL;
-  GValue *value;
 
-  value = g_task_get_task_data (task);
-
-  if (!gdk_content_deserialize_finish (result, value, &error))
-    g_task_return_error (task, error);
+  if (!gdk_content_deserialize_finish (result, &read->value, &error))
+    {
+      g_task_return_error (task, error);
+    }
   else
-    g_task_return_pointer (task, value, NULL);
+    {
+      /* Only remember the value if nobody claimed the clipboard meanwhile */
+      if (!priv->local && read->content_serial == priv->content_serial)
+        gdk_clipboard_add_cached_value (clipboard, &read->value);
+
+      g_task_return_pointer (task, &read->value, NULL);
+    }
 
   g_object_unref (task);
 }
@@ -742,7 +837,7 @@ gdk_clipboard_read_value_got_stream (GObject      *source,
 
   gdk_content_deserialize_async (stream,
                                  mime_type,
-                                 G_VALUE_TYPE (g_task_get_task_data (task)),
+                                 G_VALUE_TYPE (&((ReadValueData *) g_task_get_task_data (task))->value),
                                  g_task_get_priority (task),
                                  g_task_get_cancellable (task),
                                  gdk_clipboard_read_value_done,
@@ -750,13 +845,6 @@ gdk_clipboard_read_value_got_stream (GObject      *source,
   g_object_unref (stream);
 }
 
-static void
-free_value (gpointer value)
-{
-  g_value_unset (value);
-  g_slice_free (GValue, value);
-}
-
 static void
 gdk_clipboard_read_value_internal (GdkClipboard        *clipboard,
                                    GType                type,
@@ -769,15 +857,18 @@ gdk_clipboard_read_value_internal (GdkClipboard        *clipboard,
   GdkClipboardPrivate *priv = gdk_clipboard_get_instance_private (clipboard);
   GdkContentFormatsBuilder *builder;
   GdkContentFormats *formats;
+  ReadValueData *read;
   GValue *value;
   GTask *task;
  
   task = g_task_new (clipboard, cancellable, callback, user_data);
   g_task_set_priority (task, io_priority);
   g_task_set_source_tag (task, source_tag);
-  value = g_slice_new0 (GValue);
+  read = g_slice_new0 (ReadValueData);
+  read->content_serial = priv->content_serial;
+  value = &read->value;
   g_value_init (value, type);
-  g_task_set_task_data (task, value, free_value);
+  g_task_set_task_data (task, read, read_value_data_free);
 
   if (priv->local)
     {
@@ -809,6 +900,12 @@ gdk_clipboard_read_value_internal (GdkClipboard        *clipboard,
           g_clear_error (&error);
         }
     }
+  else if (gdk_clipboard_lookup_cached_value (clipboard, value))
+    {
+      g_task_return_pointer (task, value, NULL);
+      g_object_unref (task);
+      return;
+    }
 
   builder = gdk_content_formats_builder_new ();
   gdk_content_formats_builder_add_gtype (builder, type);
@@ -843,6 +940,10 @@ gdk_clipboard_read_value_internal (GdkClipboard        *clipboard,
  * For local clipboard contents that are available in the given #GType, the
  * value will be copied directly. Otherwise, GDK will try to use
  * gdk_content_deserialize_async() to convert the clipboard's data.
+ *
+ * Values read from other applications are remembered until the clipboard
+ * changes owners, so reading the same type again does not need another
+ * transfer.
  **/
 void
 gdk_clipboard_read_value_async (GdkClipboard        *clipboard,
@@ -1159,6 +1260,14 @@ gdk_clipboard_claim (GdkClipboard       *clipboard,
                      gboolean            local,
                      GdkContentProvider *content)
 {
+  GdkClipboardPrivate *priv = gdk_clipboard_get_instance_private (clipboard);
+
+  /* Backends claim the clipboard whenever its owner changes, be that
+   * a new Wayland offer or a new X11 selection timestamp, so anything
+   * we read before is stale now. */
+  gdk_clipboard_clear_cached_values (clipboard);
+  priv->content_serial++;
+
   return GDK_CLIPBOARD_GET_CLASS (clipboard)->claim (clipboard, formats, local, content);
 }
 
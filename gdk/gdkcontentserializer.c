@@ -639,54 +639,111 @@ pixbuf_serializer (GdkContentSerializer *serializer)
   g_object_unref (pixbuf);
 }
 
+/* Big strings get written in chunks, so that a charset converter
+ * never needs to hold a converted copy of the whole text */
+#define STRING_CHUNK_SIZE (64 * 1024)
+
+typedef struct {
+  GOutputStream *stream;
+  const char *text; /* owned by the value */
+  gsize len;
+  gsize pos;
+} StringSerializerData;
+
+static void
+string_serializer_data_free (gpointer data)
+{
+  StringSerializerData *self = data;
+
+  g_object_unref (self->stream);
+  g_free (self);
+}
+
+static void string_serializer_write_next (GdkContentSerializer *serializer);
+
 static void
 string_serializer_finish (GObject      *source,
                           GAsyncResult *result,
                           gpointer      serializer)
 {
   GOutputStream *stream = G_OUTPUT_STREAM (source);
+  StringSerializerData *data;
   GError *error = NULL;
+  gsize written;
 
-  if (!g_output_stream_write_all_finish (stream, result, NULL, &error))
-    gdk_content_serializer_return_error (serializer, error);
+  if (!g_output_stream_write_all_finish (stream, result, &written, &error))
+    {
+      gdk_content_serializer_return_error (serializer, error);
+      return;
+    }
+
+  data = gdk_content_serializer_get_task_data (serializer);
+  data->pos += written;
+
+  if (data->pos < data->len)
+    string_serializer_write_next (serializer);
   else
     gdk_content_serializer_return_success (serializer);
 }
 
+static void
+string_serializer_write_next (GdkContentSerializer *serializer)
+{
+  StringSerializerData *data = gdk_content_serializer_get_task_data (serializer);
+
+  g_output_stream_write_all_async (data->stream,
+                                   data->text + data->pos,
+                                   MIN (data->len - data->pos, STRING_CHUNK_SIZE),
+                                   gdk_content_serializer_get_priority (serializer),
+                                   gdk_content_serializer_get_cancellable (serializer),
+                                   string_serializer_finish,
+                                   serializer);
+}
+
 static void
 string_serializer (GdkContentSerializer *serializer)
 {
-  GOutputStream *filter;
-  GCharsetConverter *converter;
-  GError *error = NULL;
+  StringSerializerData *data;
+  const char *charset;
+  GOutputStream *stream;
   const char *text;
 
-  converter = g_charset_converter_new (gdk_content_serializer_get_user_data (serializer),
-                                       "utf-8",
-                                       &error);
-  if (converter == NULL)
+  charset = gdk_content_serializer_get_user_data (serializer);
+  stream = gdk_content_serializer_get_output_stream (serializer);
+
+  /* Our strings are utf-8 already, no need to run them through iconv */
+  if (g_ascii_strcasecmp (charset, "utf-8") == 0)
     {
-      gdk_content_serializer_return_error (serializer, error);
-      return;
+      g_object_ref (stream);
     }
-  g_charset_converter_set_use_fallback (converter, TRUE);
+  else
+    {
+      GCharsetConverter *converter;
+      GError *error = NULL;
 
-  filter = g_converter_output_stream_new (gdk_content_serializer_get_output_stream (serializer),
-                                          G_CONVERTER (converter));
-  g_object_unref (converter);
+      converter = g_charset_converter_new (charset, "utf-8", &error);
+      if (converter == NULL)
+        {
+          gdk_content_serializer_return_error (serializer, error);
+          return;
+        }
+      g_charset_converter_set_use_fallback (converter, TRUE);
+
+      stream = g_converter_output_stream_new (stream, G_CONVERTER (converter));
+      g_object_unref (converter);
+    }
 
   text = g_value_get_string (gdk_content_serializer_get_value (serializer));
   if (text == NULL)
     text = "";
 
-  g_output_stream_write_all_async (filter,
-                                   text,
-                                   strlen (text),
-                                   gdk_content_serializer_get_priority (serializer),
-                                   gdk_content_serializer_get_cancellable (serializer),
-                                   string_serializer_finish,
-                                   serializer);
-  g_object_unref (filter);
+  data = g_new0 (StringSerializerData, 1);
+  data->stream = stream;
+  data->text = text;
+  data->len = strlen (text);
+  gdk_content_serializer_set_task_data (serializer, data, string_serializer_data_free);
+
+  string_serializer_write_next (serializer);
 }
 
 static void
@@ -99,6 +99,8 @@ struct _GdkDisplay
   VkDevice vk_device;
   VkQueue vk_queue;
   uint32_t vk_queue_family_index;
+  guint vk_has_external_memory_capabilities : 1;
+  guint vk_has_dmabuf_import : 1;
 
   guint vulkan_refcount;
 #endif /* GDK_RENDERING_VULKAN */
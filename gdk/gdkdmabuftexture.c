@@ -0,0 +1,298 @@
+/* gdkdmabuftexture.c
+ *
+ * Copyright 2021  Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include "gdkdmabuftextureprivate.h"
+
+#include "gdkmemorytextureprivate.h"
+
+#include <errno.h>
+#include <string.h>
+
+#ifdef HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
+#ifdef HAVE_LINUX_DMA_BUF_H
+#include <sys/ioctl.h>
+#include <linux/dma-buf.h>
+#endif
+
+struct _GdkDmabufTexture {
+  GdkTexture parent_instance;
+
+  guint32 fourcc;
+  guint64 modifier;
+
+  guint n_planes;
+  int fds[GDK_DMABUF_MAX_PLANES];
+  guint32 strides[GDK_DMABUF_MAX_PLANES];
+  guint32 offsets[GDK_DMABUF_MAX_PLANES];
+
+  GDestroyNotify destroy;
+  gpointer data;
+};
+
+struct _GdkDmabufTextureClass {
+  GdkTextureClass parent_class;
+};
+
+G_DEFINE_TYPE (GdkDmabufTexture, gdk_dmabuf_texture, GDK_TYPE_TEXTURE)
+
+static void
+gdk_dmabuf_texture_dispose (GObject *object)
+{
+  GdkDmabufTexture *self = GDK_DMABUF_TEXTURE (object);
+
+  if (self->destroy)
+    {
+      self->destroy (self->data);
+      self->destroy = NULL;
+      self->data = NULL;
+    }
+
+  self->n_planes = 0;
+
+  G_OBJECT_CLASS (gdk_dmabuf_texture_parent_class)->dispose (object);
+}
+
+static void
+dmabuf_sync (int      fd,
+             gboolean start)
+{
+#ifdef HAVE_LINUX_DMA_BUF_H
+  struct dma_buf_sync sync = { (start ? DMA_BUF_SYNC_START : DMA_BUF_SYNC_END) | DMA_BUF_SYNC_READ };
+
+  while (ioctl (fd, DMA_BUF_IOCTL_SYNC, &sync) == -1 && errno == EINTR)
+    ;
+#endif
+}
+
+/* Renderers import the dma-buf directly, this is only used when they
+ * can't and for gdk_texture_download(). We can only map buffers that
+ * are laid out linearly, everything else downloads as transparent. */
+static void
+gdk_dmabuf_texture_download (GdkTexture         *texture,
+                             const GdkRectangle *area,
+                             guchar             *data,
+                             gsize               stride)
+{
+  GdkDmabufTexture *self = GDK_DMABUF_TEXTURE (texture);
+  GdkMemoryFormat format;
+  gboolean opaque;
+  gsize size;
+  guchar *map;
+  int y, x;
+
+  switch (self->fourcc)
+    {
+    case GDK_DRM_FORMAT_ARGB8888:
+    case GDK_DRM_FORMAT_XRGB8888:
+      format = GDK_MEMORY_B8G8R8A8_PREMULTIPLIED;
+      break;
+    case GDK_DRM_FORMAT_ABGR8888:
+    case GDK_DRM_FORMAT_XBGR8888:
+      format = GDK_MEMORY_R8G8B8A8_PREMULTIPLIED;
+      break;
+    default:
+      format = GDK_MEMORY_N_FORMATS;
+      break;
+    }
+  opaque = self->fourcc == GDK_DRM_FORMAT_XRGB8888 ||
+           self->fourcc == GDK_DRM_FORMAT_XBGR8888;
+
+#ifdef HAVE_SYS_MMAN_H
+  if (format != GDK_MEMORY_N_FORMATS &&
+      self->n_planes == 1 &&
+      self->modifier == GDK_DRM_FORMAT_MOD_LINEAR)
+    {
+      size = self->offsets[0] + (gsize) self->strides[0] * texture->height;
+      map = mmap (NULL, size, PROT_READ, MAP_SHARED, self->fds[0], 0);
+    }
+  else
+#endif
+    {
+      size = 0;
+      map = NULL;
+    }
+
+  if (map == NULL || map == (guchar *) -1)
+    {
+      g_warning_once ("Can't download dma-buf texture with format %.4s and modifier 0x%" G_GINT64_MODIFIER "x",
+                      (char *) &self->fourcc, self->modifier);
+      for (y = 0; y < area->height; y++)
+        memset (data + y * stride, 0, area->width * 4);
+      return;
+    }
+
+  dmabuf_sync (self->fds[0], TRUE);
+
+  gdk_memory_convert (data, stride,
+                      GDK_MEMORY_CAIRO_FORMAT_ARGB32,
+                      map + self->offsets[0] + area->y * self->strides[0] + area->x * 4,
+                      self->strides[0],
+                      format,
+                      area->width, area->height);
+
+  dmabuf_sync (self->fds[0], FALSE);
+
+#ifdef HAVE_SYS_MMAN_H
+  munmap (map, size);
+#endif
+
+  if (opaque)
+    {
+      for (y = 0; y < area->height; y++)
+        {
+          guint32 *row = (guint32 *) (data + y * stride);
+
+          for (x = 0; x < area->width; x++)
+            row[x] |= 0xFF000000;
+        }
+    }
+}
+
+static void
+gdk_dmabuf_texture_class_init (GdkDmabufTextureClass *klass)
+{
+  GdkTextureClass *texture_class = GDK_TEXTURE_CLASS (klass);
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+
+  texture_class->download = gdk_dmabuf_texture_download;
+  gobject_class->dispose = gdk_dmabuf_texture_dispose;
+}
+
+static void
+gdk_dmabuf_texture_init (GdkDmabufTexture *self)
+{
+}
+
+guint32
+gdk_dmabuf_texture_get_fourcc (GdkDmabufTexture *self)
+{
+  return self->fourcc;
+}
+
+guint64
+gdk_dmabuf_texture_get_modifier (GdkDmabufTexture *self)
+{
+  return self->modifier;
+}
+
+guint
+gdk_dmabuf_texture_get_n_planes (GdkDmabufTexture *self)
+{
+  return self->n_planes;
+}
+
+int
+gdk_dmabuf_texture_get_fd (GdkDmabufTexture *self,
+                           guint             plane)
+{
+  g_return_val_if_fail (plane < self->n_planes, -1);
+
+  return self->fds[plane];
+}
+
+guint32
+gdk_dmabuf_texture_get_stride (GdkDmabufTexture *self,
+                               guint             plane)
+{
+  g_return_val_if_fail (plane < self->n_planes, 0);
+
+  return self->strides[plane];
+}
+
+guint32
+gdk_dmabuf_texture_get_offset (GdkDmabufTexture *self,
+                               guint             plane)
+{
+  g_return_val_if_fail (plane < self->n_planes, 0);
+
+  return self->offsets[plane];
+}
+
+/**
+ * gdk_dmabuf_texture_new:
+ * @width: the width of the texture
+ * @height: the height of the texture
+ * @fourcc: the DRM fourcc of the buffer's format
+ * @modifier: the DRM format modifier of the buffer, or
+ *     DRM_FORMAT_MOD_INVALID if it has none
+ * @n_planes: the number of planes of the buffer
+ * @fds: (array length=n_planes): the file descriptor of each plane
+ * @strides: (array length=n_planes): the stride of each plane
+ * @offsets: (array length=n_planes): the offset of each plane
+ * @destroy: a destroy notify that will be called when the texture
+ *           is done with the buffer
+ * @data: data that gets passed to @destroy
+ *
+ * Creates a new texture for a Linux dma-buf, such as a frame that
+ * was produced by a video decoder.
+ *
+ * The GL and Vulkan renderers import the buffer without copying it
+ * if the driver can do that for the given format and modifier.
+ * Color values are assumed to be premultiplied with alpha.
+ *
+ * The file descriptors are not taken over by the texture. They, and
+ * the contents of the buffer, must stay valid until @destroy is called,
+ * which will happen when the #GdkTexture object is finalized.
+ *
+ * Return value: (transfer full): A newly-created #GdkTexture
+ */
+GdkTexture *
+gdk_dmabuf_texture_new (int             width,
+                        int             height,
+                        guint32         fourcc,
+                        guint64         modifier,
+                        guint           n_planes,
+                        const int      *fds,
+                        const guint32  *strides,
+                        const guint32  *offsets,
+                        GDestroyNotify  destroy,
+                        gpointer        data)
+{
+  GdkDmabufTexture *self;
+  guint i;
+
+  g_return_val_if_fail (width > 0, NULL);
+  g_return_val_if_fail (height > 0, NULL);
+  g_return_val_if_fail (n_planes > 0 && n_planes <= GDK_DMABUF_MAX_PLANES, NULL);
+  g_return_val_if_fail (fds != NULL, NULL);
+  g_return_val_if_fail (strides != NULL, NULL);
+  g_return_val_if_fail (offsets != NULL, NULL);
+
+  self = g_object_new (GDK_TYPE_DMABUF_TEXTURE,
+                       "width", width,
+                       "height", height,
+                       NULL);
+
+  self->fourcc = fourcc;
+  self->modifier = modifier;
+  self->n_planes = n_planes;
+  for (i = 0; i < n_planes; i++)
+    {
+      self->fds[i] = fds[i];
+      self->strides[i] = strides[i];
+      self->offsets[i] = offsets[i];
+    }
+  self->destroy = destroy;
+  self->data = data;
+
+  return GDK_TEXTURE (self);
+}
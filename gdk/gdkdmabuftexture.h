@@ -0,0 +1,69 @@
+/* gdkdmabuftexture.h
+ *
+ * Copyright 2021  Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GDK_DMABUF_TEXTURE_H__
+#define __GDK_DMABUF_TEXTURE_H__
+
+#if !defined (__GDK_H_INSIDE__) && !defined (GTK_COMPILATION)
+#error "Only <gdk/gdk.h> can be included directly."
+#endif
+
+#include <gdk/gdktexture.h>
+
+G_BEGIN_DECLS
+
+/**
+ * GDK_DMABUF_MAX_PLANES:
+ *
+ * The maximum number of planes a #GdkDmabufTexture can have.
+ */
+#define GDK_DMABUF_MAX_PLANES 4
+
+#define GDK_TYPE_DMABUF_TEXTURE (gdk_dmabuf_texture_get_type ())
+
+#define GDK_DMABUF_TEXTURE(obj)         (G_TYPE_CHECK_INSTANCE_CAST ((obj), GDK_TYPE_DMABUF_TEXTURE, GdkDmabufTexture))
+#define GDK_IS_DMABUF_TEXTURE(obj)      (G_TYPE_CHECK_INSTANCE_TYPE ((obj), GDK_TYPE_DMABUF_TEXTURE))
+
+/**
+ * GdkDmabufTexture:
+ *
+ * A #GdkTexture representing a Linux dma-buf.
+ */
+typedef struct _GdkDmabufTexture        GdkDmabufTexture;
+typedef struct _GdkDmabufTextureClass   GdkDmabufTextureClass;
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC(GdkDmabufTexture, g_object_unref)
+
+GDK_AVAILABLE_IN_ALL
+GType                   gdk_dmabuf_texture_get_type             (void) G_GNUC_CONST;
+
+GDK_AVAILABLE_IN_ALL
+GdkTexture *            gdk_dmabuf_texture_new                  (int              width,
+                                                                 int              height,
+                                                                 guint32          fourcc,
+                                                                 guint64          modifier,
+                                                                 guint            n_planes,
+                                                                 const int       *fds,
+                                                                 const guint32   *strides,
+                                                                 const guint32   *offsets,
+                                                                 GDestroyNotify   destroy,
+                                                                 gpointer         data);
+
+G_END_DECLS
+
+#endif /* __GDK_DMABUF_TEXTURE_H__ */
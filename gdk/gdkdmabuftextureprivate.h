@@ -0,0 +1,33 @@
+#ifndef __GDK_DMABUF_TEXTURE_PRIVATE_H__
+#define __GDK_DMABUF_TEXTURE_PRIVATE_H__
+
+#include "gdkdmabuftexture.h"
+
+#include "gdktextureprivate.h"
+
+G_BEGIN_DECLS
+
+/* The values from drm_fourcc.h, so we don't need to depend on it */
+#define GDK_DRM_FOURCC(a,b,c,d) ((guint32) (a) | ((guint32) (b) << 8) | ((guint32) (c) << 16) | ((guint32) (d) << 24))
+
+#define GDK_DRM_FORMAT_ARGB8888 GDK_DRM_FOURCC ('A', 'R', '2', '4')
+#define GDK_DRM_FORMAT_XRGB8888 GDK_DRM_FOURCC ('X', 'R', '2', '4')
+#define GDK_DRM_FORMAT_ABGR8888 GDK_DRM_FOURCC ('A', 'B', '2', '4')
+#define GDK_DRM_FORMAT_XBGR8888 GDK_DRM_FOURCC ('X', 'B', '2', '4')
+
+#define GDK_DRM_FORMAT_MOD_LINEAR  G_GUINT64_CONSTANT (0)
+#define GDK_DRM_FORMAT_MOD_INVALID G_GUINT64_CONSTANT (0x00ffffffffffffff)
+
+guint32                 gdk_dmabuf_texture_get_fourcc   (GdkDmabufTexture       *self);
+guint64                 gdk_dmabuf_texture_get_modifier (GdkDmabufTexture       *self);
+guint                   gdk_dmabuf_texture_get_n_planes (GdkDmabufTexture       *self);
+int                     gdk_dmabuf_texture_get_fd       (GdkDmabufTexture       *self,
+                                                         guint                   plane);
+guint32                 gdk_dmabuf_texture_get_stride   (GdkDmabufTexture       *self,
+                                                         guint                   plane);
+guint32                 gdk_dmabuf_texture_get_offset   (GdkDmabufTexture       *self,
+                                                         guint                   plane);
+
+G_END_DECLS
+
+#endif /* __GDK_DMABUF_TEXTURE_PRIVATE_H__ */
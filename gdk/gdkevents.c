@@ -31,6 +31,7 @@
 #include "gdkdragprivate.h"
 #include "gdkdropprivate.h"
 #include "gdkkeysprivate.h"
+#include "gdkframeclockprivate.h"
 #include "gdk-private.h"
 
 #include <gobject/gvaluecollector.h>
@@ -515,6 +516,7 @@ _gdk_event_queue_find_first (GdkDisplay *display)
 {
   GList *tmp_list;
   GList *pending_motion = NULL;
+  gboolean compression_disabled = gdk_display_get_debug_flags (display) & GDK_DEBUG_NO_EVENT_COMPRESSION;
 
   gboolean paused = display->event_pause_count > 0;
 
@@ -529,7 +531,8 @@ _gdk_event_queue_find_first (GdkDisplay *display)
           if (pending_motion)
             return pending_motion;
 
-          if (event->event_type == GDK_MOTION_NOTIFY && (event->flags & GDK_EVENT_FLUSHED) == 0)
+          if (event->event_type == GDK_MOTION_NOTIFY && (event->flags & GDK_EVENT_FLUSHED) == 0 &&
+              !compression_disabled)
             pending_motion = tmp_list;
           else
             return tmp_list;
@@ -541,6 +544,33 @@ _gdk_event_queue_find_first (GdkDisplay *display)
   return NULL;
 }
 
+static gboolean
+is_input_event (GdkEvent *event)
+{
+  switch ((guint) gdk_event_get_event_type (event))
+    {
+    case GDK_MOTION_NOTIFY:
+    case GDK_BUTTON_PRESS:
+    case GDK_BUTTON_RELEASE:
+    case GDK_KEY_PRESS:
+    case GDK_KEY_RELEASE:
+    case GDK_SCROLL:
+    case GDK_TOUCH_BEGIN:
+    case GDK_TOUCH_UPDATE:
+    case GDK_TOUCH_END:
+    case GDK_TOUCHPAD_SWIPE:
+    case GDK_TOUCHPAD_PINCH:
+    case GDK_PAD_BUTTON_PRESS:
+    case GDK_PAD_BUTTON_RELEASE:
+    case GDK_PAD_RING:
+    case GDK_PAD_STRIP:
+      return TRUE;
+
+    default:
+      return FALSE;
+    }
+}
+
 /**
  * _gdk_event_queue_append:
  * @display: a #GdkDisplay
@@ -554,6 +584,20 @@ GList *
 _gdk_event_queue_append (GdkDisplay *display,
 			 GdkEvent   *event)
 {
+  GdkSurface *surface;
+
+  /* Event timestamps use different clocks on different backends,
+   * so note when the event got queued to measure input latency
+   */
+  surface = gdk_event_get_surface (event);
+  if (surface != NULL && is_input_event (event))
+    {
+      GdkFrameClock *frame_clock = gdk_surface_get_frame_clock (surface);
+
+      if (frame_clock != NULL)
+        _gdk_frame_clock_add_input (frame_clock, g_get_monotonic_time ());
+    }
+
   g_queue_push_tail (&display->queued_events, event);
 
   return g_queue_peek_tail_link (&display->queued_events);
@@ -715,27 +759,37 @@ gdk_motion_event_push_history (GdkEvent *event,
                                GdkEvent *history_event)
 {
   GdkMotionEvent *self = (GdkMotionEvent *) event;
-  GdkDeviceTool *tool;
+  GdkMotionEvent *other = (GdkMotionEvent *) history_event;
   GdkTimeCoord hist;
   int i;
 
   g_assert (GDK_IS_EVENT_TYPE (event, GDK_MOTION_NOTIFY));
   g_assert (GDK_IS_EVENT_TYPE (history_event, GDK_MOTION_NOTIFY));
 
-  if (!self->tool)
-    return;
+  if (G_UNLIKELY (!self->history))
+    self->history = g_array_new (FALSE, TRUE, sizeof (GdkTimeCoord));
 
-  tool = gdk_event_get_device_tool (history_event);
+  /* history_event may carry samples from an earlier compression */
+  if (other->history)
+    g_array_append_vals (self->history, other->history->data, other->history->len);
 
   memset (&hist, 0, sizeof (GdkTimeCoord));
   hist.time = gdk_event_get_time (history_event);
-  hist.flags = gdk_device_tool_get_axes (tool);
 
-  for (i = GDK_AXIS_X; i < GDK_AXIS_LAST; i++)
-    gdk_event_get_axis (history_event, i, &hist.axes[i]);
+  if (other->tool && other->axes)
+    {
+      hist.flags = gdk_device_tool_get_axes (other->tool);
 
-  if (G_UNLIKELY (!self->history))
-    self->history = g_array_new (FALSE, TRUE, sizeof (GdkTimeCoord));
+      for (i = GDK_AXIS_X; i < GDK_AXIS_LAST; i++)
+        gdk_event_get_axis (history_event, i, &hist.axes[i]);
+    }
+  else
+    {
+      /* Plain pointer motion only has a position */
+      hist.flags = GDK_AXIS_FLAG_X | GDK_AXIS_FLAG_Y;
+      hist.axes[GDK_AXIS_X] = other->x;
+      hist.axes[GDK_AXIS_Y] = other->y;
+    }
 
   g_array_append_val (self->history, hist);
 }
@@ -750,7 +804,11 @@ _gdk_event_queue_handle_motion_compression (GdkDisplay *display)
   GdkEvent *last_motion = NULL;
 
   /* If the last N events in the event queue are motion notify
-   * events for the same surface, drop all but the last */
+   * events for the same surface, drop all but the last, and keep
+   * the dropped ones in its history */
+
+  if (gdk_display_get_debug_flags (display) & GDK_DEBUG_NO_EVENT_COMPRESSION)
+    return;
 
   tmp_list = g_queue_peek_tail_link (&display->queued_events);
 
@@ -787,14 +845,7 @@ _gdk_event_queue_handle_motion_compression (GdkDisplay *display)
       GList *next = pending_motions->next;
 
       if (last_motion != NULL)
-        {
-          GdkModifierType state = gdk_event_get_modifier_state (last_motion);
-
-          if (state &
-              (GDK_BUTTON1_MASK | GDK_BUTTON2_MASK | GDK_BUTTON3_MASK |
-               GDK_BUTTON4_MASK | GDK_BUTTON5_MASK))
-           gdk_motion_event_push_history (last_motion, pending_motions->data);
-        }
+        gdk_motion_event_push_history (last_motion, pending_motions->data);
 
       gdk_event_unref (pending_motions->data);
       g_queue_delete_link (&display->queued_events, pending_motions);
@@ -2851,8 +2902,9 @@ gdk_motion_event_new (GdkSurface      *surface,
  * The history includes events that are not delivered to the application
  * because they occurred in the same frame as @event.
  *
- * Note that only motion and scroll events record history, and motion
- * events only if one of the mouse buttons is down.
+ * Note that only motion and scroll events record history. For motion
+ * events of devices without a #GdkDeviceTool, only the %GDK_AXIS_X and
+ * %GDK_AXIS_Y axes are set.
  *
  * Returns: (transfer container) (array length=out_n_coords) (nullable): an
  *   array of time and coordinates
@@ -88,6 +88,8 @@ enum {
 static guint signals[LAST_SIGNAL];
 
 static guint fps_counter;
+static guint input_latency_counter;
+static guint phase_counters[GDK_FRAME_CLOCK_N_PHASES];
 
 #define FRAME_HISTORY_MAX_LENGTH 16
 
@@ -98,6 +100,7 @@ struct _GdkFrameClockPrivate
   int current;
   GdkFrameTimings *timings[FRAME_HISTORY_MAX_LENGTH];
   int n_freeze_inhibitors;
+  gint64 pending_input_time;
 };
 
 G_DEFINE_ABSTRACT_TYPE_WITH_PRIVATE (GdkFrameClock, gdk_frame_clock, G_TYPE_OBJECT)
@@ -262,7 +265,28 @@ gdk_frame_clock_init (GdkFrameClock *clock)
   priv->current = FRAME_HISTORY_MAX_LENGTH - 1;
 
   if (fps_counter == 0)
-    fps_counter = gdk_profiler_define_counter ("fps", "Frames per Second");
+    {
+      static const struct {
+        GdkFrameClockPhase phase;
+        const char *name;
+        const char *description;
+      } phases[] = {
+        { GDK_FRAME_CLOCK_PHASE_FLUSH_EVENTS, "flush-events time", "Time spent flushing events per frame (µs)" },
+        { GDK_FRAME_CLOCK_PHASE_BEFORE_PAINT, "before-paint time", "Time spent before painting per frame (µs)" },
+        { GDK_FRAME_CLOCK_PHASE_UPDATE, "update time", "Time spent updating animations per frame (µs)" },
+        { GDK_FRAME_CLOCK_PHASE_LAYOUT, "layout time", "Time spent in layout per frame (µs)" },
+        { GDK_FRAME_CLOCK_PHASE_PAINT, "paint time", "Time spent painting per frame (µs)" },
+        { GDK_FRAME_CLOCK_PHASE_RESUME_EVENTS, "resume-events time", "Time spent resuming events per frame (µs)" },
+        { GDK_FRAME_CLOCK_PHASE_AFTER_PAINT, "after-paint time", "Time spent after painting per frame (µs)" },
+      };
+      guint i;
+
+      fps_counter = gdk_profiler_define_counter ("fps", "Frames per Second");
+      input_latency_counter = gdk_profiler_define_int_counter ("input latency", "Time from queuing input to presentation (µs)");
+      for (i = 0; i < G_N_ELEMENTS (phases); i++)
+        phase_counters[g_bit_nth_lsf (phases[i].phase, -1)] =
+          gdk_profiler_define_int_counter (phases[i].name, phases[i].description);
+    }
 }
 
 /**
@@ -457,17 +481,41 @@ _gdk_frame_clock_begin_frame (GdkFrameClock *frame_clock)
   /* Try to steal the previous frame timing instead of discarding
    * and allocating a new one.
    */
-  if G_LIKELY (priv->n_timings == FRAME_HISTORY_MAX_LENGTH &&
-               _gdk_frame_timings_steal (priv->timings[priv->current],
-                                         priv->frame_counter))
-    return;
+  if G_UNLIKELY (priv->n_timings < FRAME_HISTORY_MAX_LENGTH ||
+                 !_gdk_frame_timings_steal (priv->timings[priv->current],
+                                            priv->frame_counter))
+    {
+      if (priv->n_timings < FRAME_HISTORY_MAX_LENGTH)
+        priv->n_timings++;
+      else
+        gdk_frame_timings_unref (priv->timings[priv->current]);
+
+      priv->timings[priv->current] = _gdk_frame_timings_new (priv->frame_counter);
+    }
+
+  /* Input is flushed before the frame begins, so whatever
+   * arrived since the last frame is handled by this one.
+   */
+  priv->timings[priv->current]->input_time = priv->pending_input_time;
+  priv->pending_input_time = 0;
+}
 
-  if (priv->n_timings < FRAME_HISTORY_MAX_LENGTH)
-    priv->n_timings++;
-  else
-    gdk_frame_timings_unref (priv->timings[priv->current]);
+/*
+ * _gdk_frame_clock_add_input:
+ * @frame_clock: a #GdkFrameClock
+ * @input_time: the monotonic time the input arrived at
+ *
+ * Notes that input arrived that will be handled in the next frame,
+ * to measure the latency until the frame is presented.
+ */
+void
+_gdk_frame_clock_add_input (GdkFrameClock *frame_clock,
+                            gint64         input_time)
+{
+  GdkFrameClockPrivate *priv = frame_clock->priv;
 
-  priv->timings[priv->current] = _gdk_frame_timings_new (priv->frame_counter);
+  if (priv->pending_input_time == 0 || input_time < priv->pending_input_time)
+    priv->pending_input_time = input_time;
 }
 
 /**
@@ -573,6 +621,9 @@ _gdk_frame_clock_debug_print_timings (GdkFrameClock   *clock,
     g_string_append_printf (str, " predicted=%-4.1f", (timings->predicted_presentation_time - timings->frame_time) / 1000.);
   if (timings->refresh_interval != 0)
     g_string_append_printf (str, " refresh_interval=%-4.1f", timings->refresh_interval / 1000.);
+  g_string_append_printf (str, " layout=%-4.1f paint=%-4.1f",
+                          timings->phase_durations[g_bit_nth_lsf (GDK_FRAME_CLOCK_PHASE_LAYOUT, -1)] / 1000.,
+                          timings->phase_durations[g_bit_nth_lsf (GDK_FRAME_CLOCK_PHASE_PAINT, -1)] / 1000.);
 
   g_message ("%s", str->str);
   g_string_free (str, TRUE);
@@ -801,6 +852,8 @@ void
 _gdk_frame_clock_add_timings_to_profiler (GdkFrameClock   *clock,
                                           GdkFrameTimings *timings)
 {
+  guint i;
+
   if (timings->drawn_time != 0)
     {
       gdk_profiler_add_mark (1000 * timings->drawn_time, 0, "drawn window", NULL);
@@ -809,7 +862,18 @@ _gdk_frame_clock_add_timings_to_profiler (GdkFrameClock   *clock,
   if (timings->presentation_time != 0)
     {
       gdk_profiler_add_mark (1000 * timings->presentation_time, 0, "presented window", NULL);
+
+      if (timings->input_time != 0)
+        {
+          gdk_profiler_set_int_counter (input_latency_counter, timings->presentation_time - timings->input_time);
+          gdk_profiler_add_mark (1000 * timings->input_time,
+                                 1000 * (timings->presentation_time - timings->input_time),
+                                 "input latency", NULL);
+        }
     }
 
   gdk_profiler_set_counter (fps_counter, gdk_frame_clock_get_fps (clock));
+
+  for (i = 0; i < GDK_FRAME_CLOCK_N_PHASES; i++)
+    gdk_profiler_set_int_counter (phase_counters[i], timings->phase_durations[i]);
 }
@@ -70,6 +70,10 @@ typedef enum {
   GDK_FRAME_CLOCK_PHASE_AFTER_PAINT   = 1 << 6
 } GdkFrameClockPhase;
 
+GDK_AVAILABLE_IN_ALL
+gint64           gdk_frame_timings_get_phase_duration (GdkFrameTimings    *timings,
+                                                       GdkFrameClockPhase  phase);
+
 GDK_AVAILABLE_IN_ALL
 GType    gdk_frame_clock_get_type             (void) G_GNUC_CONST;
 
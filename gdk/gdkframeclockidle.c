@@ -37,6 +37,12 @@
 
 #define FRAME_INTERVAL 16667 /* microseconds */
 
+/* With variable refresh, how many cycles have to miss their deadline
+ * before we throttle, or make it comfortably before we speed up again */
+#define THROTTLE_FRAMES 8
+#define UNTHROTTLE_FRAMES 60
+#define MAX_THROTTLE_FACTOR 4
+
 typedef enum {
   SMOOTH_PHASE_STATE_VALID = 0,    /* explicit, since we count on zero-init */
   SMOOTH_PHASE_STATE_AWAIT_FIRST,
@@ -50,7 +56,7 @@ struct _GdkFrameClockIdlePrivate
   gint64 smoothed_frame_time_period;   /* The grid size that smoothed_frame_time_base is aligned to */
   gint64 smoothed_frame_time_reported; /* Ensures we are always monotonic */
   gint64 smoothed_frame_time_phase;    /* The offset of the first reported frame time, in the current animation sequence, from the preceding vsync */
-  gint64 min_next_frame_time;          /* We're not synced to vblank, so wait at least until this before next cycle to avoid busy looping */
+  gint64 min_next_frame_time;          /* We're not synced to vblank, or throttled, so wait at least until this before next cycle */
   SmoothDeltaState smooth_phase_state; /* The state of smoothed_frame_time_phase - is it valid, awaiting vsync etc. Thanks to zero-init, the initial value
                                           of smoothed_frame_time_phase is `0`. This is valid, since we didn't get a "frame drawn" event yet. Accordingly,
                                           the initial value of smooth_phase_state is SMOOTH_PHASE_STATE_VALID. See the comment in gdk_frame_clock_paint_idle()
@@ -59,6 +65,15 @@ struct _GdkFrameClockIdlePrivate
   gint64 sleep_serial;
   gint64 freeze_time; /* in microseconds */
 
+  gint64 cycle_duration;               /* Smoothed time a clock cycle takes, 0 if unknown */
+  gint64 paint_delay;                  /* How long the current paint idle was delayed after the thaw */
+  gint64 flush_events_duration;        /* Time spent flushing events since the last frame began */
+
+  gint64 refresh_interval;             /* Of the monitors we're on, used until the backend reports one */
+  guint throttle_factor;               /* With variable refresh, the multiple of refresh_interval between cycles */
+  guint missed_frames;
+  guint early_frames;
+
   guint flush_idle_id;
   guint paint_idle_id;
   guint freeze_count;
@@ -69,6 +84,7 @@ struct _GdkFrameClockIdlePrivate
 
   guint in_paint_idle : 1;
   guint paint_is_thaw : 1;
+  guint variable_refresh : 1;
 #ifdef G_OS_WIN32
   guint begin_period : 1;
 #endif
@@ -81,6 +97,15 @@ G_DEFINE_TYPE_WITH_PRIVATE (GdkFrameClockIdle, gdk_frame_clock_idle, GDK_TYPE_FR
 
 static gint64 sleep_serial;
 static gint64 sleep_source_prepare_time;
+
+static inline void
+add_phase_duration (GdkFrameTimings    *timings,
+                    GdkFrameClockPhase  phase,
+                    gint64              start)
+{
+  if (timings)
+    timings->phase_durations[g_bit_nth_lsf (phase, -1)] += g_get_monotonic_time () - start;
+}
 static GSource *sleep_source;
 
 static gboolean
@@ -141,6 +166,8 @@ gdk_frame_clock_idle_init (GdkFrameClockIdle *frame_clock_idle)
 
   priv->freeze_count = 0;
   priv->smoothed_frame_time_period = FRAME_INTERVAL;
+  priv->refresh_interval = FRAME_INTERVAL;
+  priv->throttle_factor = 1;
 }
 
 static void
@@ -257,6 +284,13 @@ gdk_frame_clock_idle_get_frame_time (GdkFrameClock *clock)
   /* Outside a paint, pick something smoothed close to now */
   now = g_get_monotonic_time ();
 
+  /* There is no grid to align to with variable refresh */
+  if (priv->variable_refresh)
+    {
+      priv->smoothed_frame_time_reported = MAX (now, priv->smoothed_frame_time_reported);
+      return priv->smoothed_frame_time_reported;
+    }
+
   /* First time frame, just return something */
   if (priv->smoothed_frame_time_base == 0)
     {
@@ -288,6 +322,90 @@ gdk_frame_clock_idle_get_frame_time (GdkFrameClock *clock)
    (((priv)->requested & ~GDK_FRAME_CLOCK_PHASE_FLUSH_EVENTS) != 0 ||   \
     (priv)->updating_count > 0))
 
+/* Once the compositor tells us when frames actually get presented,
+ * we can start a frame cycle that was triggered by a thaw as late as
+ * possible while it still makes the next vblank. That way the frame
+ * shows the latest input. We leave the compositor half a refresh
+ * interval, and ourselves twice the time a cycle usually takes, so
+ * slow frames start right away.
+ */
+static gint64
+compute_paint_delay (GdkFrameClockIdle *clock_idle)
+{
+  GdkFrameClockIdlePrivate *priv = clock_idle->priv;
+  GdkFrameClock *clock = GDK_FRAME_CLOCK (clock_idle);
+  GdkFrameTimings *timings;
+  gint64 frame_counter, history_start;
+  gint64 now, refresh_interval, presentation_time, start;
+
+  if (priv->cycle_duration == 0 || priv->variable_refresh)
+    return 0;
+
+  history_start = gdk_frame_clock_get_history_start (clock);
+  for (frame_counter = gdk_frame_clock_get_frame_counter (clock);
+       frame_counter >= history_start;
+       frame_counter--)
+    {
+      timings = gdk_frame_clock_get_timings (clock, frame_counter);
+      if (timings && timings->complete && timings->presentation_time != 0)
+        break;
+    }
+
+  if (frame_counter < history_start || !timings->presentation_time_is_reported)
+    return 0;
+
+  now = g_get_monotonic_time ();
+  gdk_frame_clock_get_refresh_info (clock, now, &refresh_interval, &presentation_time);
+  if (presentation_time == 0)
+    return 0;
+
+  start = presentation_time - refresh_interval / 2 - 2 * priv->cycle_duration;
+
+  return CLAMP (start - now, 0, refresh_interval / 2);
+}
+
+/* With variable refresh, a frame is shown as soon as it is done, so
+ * frames that take a little too long make the animation judder. When
+ * that keeps happening, we pace the cycles to a multiple of the refresh
+ * interval instead, and speed up again once cycles have gotten short
+ * enough for the faster rate.
+ */
+static void
+update_throttling (GdkFrameClockIdle *clock_idle,
+                   gint64             interval)
+{
+  GdkFrameClockIdlePrivate *priv = clock_idle->priv;
+  gint64 target = priv->throttle_factor * priv->refresh_interval;
+
+  if (interval > target + target / 2)
+    {
+      priv->early_frames = 0;
+      if (++priv->missed_frames >= THROTTLE_FRAMES &&
+          priv->throttle_factor < MAX_THROTTLE_FACTOR)
+        {
+          priv->throttle_factor++;
+          priv->missed_frames = 0;
+        }
+    }
+  else
+    {
+      if (priv->missed_frames > 0)
+        priv->missed_frames--;
+
+      if (priv->throttle_factor > 1 &&
+          priv->cycle_duration < (priv->throttle_factor - 1) * priv->refresh_interval / 2)
+        {
+          if (++priv->early_frames >= UNTHROTTLE_FRAMES)
+            {
+              priv->throttle_factor--;
+              priv->early_frames = 0;
+            }
+        }
+      else
+        priv->early_frames = 0;
+    }
+}
+
 static void
 maybe_start_idle (GdkFrameClockIdle *clock_idle,
                   gboolean caused_by_thaw)
@@ -297,6 +415,7 @@ maybe_start_idle (GdkFrameClockIdle *clock_idle,
   if (RUN_FLUSH_IDLE (priv) || RUN_PAINT_IDLE (priv))
     {
       guint min_interval = 0;
+      gint64 paint_delay = 0;
 
       if (priv->min_next_frame_time != 0)
         {
@@ -304,6 +423,12 @@ maybe_start_idle (GdkFrameClockIdle *clock_idle,
           gint64 min_interval_us = MAX (priv->min_next_frame_time, now) - now;
           min_interval = (min_interval_us + 500) / 1000;
         }
+      else if (caused_by_thaw && !priv->in_paint_idle &&
+               priv->paint_idle_id == 0 && RUN_PAINT_IDLE (priv))
+        {
+          /* Timeouts have millisecond granularity */
+          paint_delay = compute_paint_delay (clock_idle) / 1000 * 1000;
+        }
 
       if (priv->flush_idle_id == 0 && RUN_FLUSH_IDLE (priv))
         {
@@ -319,8 +444,9 @@ maybe_start_idle (GdkFrameClockIdle *clock_idle,
 	  priv->paint_idle_id == 0 && RUN_PAINT_IDLE (priv))
         {
           priv->paint_is_thaw = caused_by_thaw;
+          priv->paint_delay = paint_delay;
           priv->paint_idle_id = g_timeout_add_full (GDK_PRIORITY_REDRAW,
-                                                    min_interval,
+                                                    MAX (min_interval, paint_delay / 1000),
                                                     gdk_frame_clock_paint_idle,
                                                     g_object_ref (clock_idle),
                                                     (GDestroyNotify) g_object_unref);
@@ -353,6 +479,7 @@ gdk_frame_clock_flush_idle (void *data)
   GdkFrameClock *clock = GDK_FRAME_CLOCK (data);
   GdkFrameClockIdle *clock_idle = GDK_FRAME_CLOCK_IDLE (clock);
   GdkFrameClockIdlePrivate *priv = clock_idle->priv;
+  gint64 start;
 
   priv->flush_idle_id = 0;
 
@@ -362,7 +489,9 @@ gdk_frame_clock_flush_idle (void *data)
   priv->phase = GDK_FRAME_CLOCK_PHASE_FLUSH_EVENTS;
   priv->requested &= ~GDK_FRAME_CLOCK_PHASE_FLUSH_EVENTS;
 
+  start = g_get_monotonic_time ();
   _gdk_frame_clock_emit_flush_events (clock);
+  priv->flush_events_duration += g_get_monotonic_time () - start;
 
   if ((priv->requested & ~GDK_FRAME_CLOCK_PHASE_FLUSH_EVENTS) != 0 ||
       priv->updating_count > 0)
@@ -401,6 +530,8 @@ gdk_frame_clock_paint_idle (void *data)
   gboolean skip_to_resume_events;
   GdkFrameTimings *timings = NULL;
   gint64 before G_GNUC_UNUSED;
+  gint64 cycle_start = 0;
+  gint64 start;
 
   before = GDK_PROFILER_CURRENT_TIME;
 
@@ -427,13 +558,27 @@ gdk_frame_clock_paint_idle (void *data)
         case GDK_FRAME_CLOCK_PHASE_BEFORE_PAINT:
           if (priv->freeze_count == 0)
             {
-              gint64 frame_interval = FRAME_INTERVAL;
+              gint64 frame_interval = priv->refresh_interval;
               GdkFrameTimings *prev_timings = gdk_frame_clock_get_current_timings (clock);
+              gint64 prev_frame_time = priv->frame_time;
 
-              if (prev_timings && prev_timings->refresh_interval)
+              /* With variable refresh, the backend reports the fastest rate, same as the monitor */
+              if (!priv->variable_refresh && prev_timings && prev_timings->refresh_interval)
                 frame_interval = prev_timings->refresh_interval;
 
               priv->frame_time = g_get_monotonic_time ();
+              /* The time at which the cycle would have started without compute_paint_delay() */
+              cycle_start = priv->frame_time - priv->paint_delay;
+
+              if (priv->variable_refresh && priv->updating_count > 0 && prev_frame_time != 0)
+                update_throttling (clock_idle, priv->frame_time - prev_frame_time);
+
+              /* The phase was relative to the old grid, e.g. after moving to
+               * a monitor with a different refresh rate, so find the new one.
+               */
+              if (frame_interval != priv->smoothed_frame_time_period &&
+                  priv->smooth_phase_state == SMOOTH_PHASE_STATE_VALID)
+                priv->smooth_phase_state = SMOOTH_PHASE_STATE_AWAIT_DRAWN;
 
               /*
                * The first clock cycle of an animation might have been triggered by some external event. An external
@@ -496,12 +641,18 @@ gdk_frame_clock_paint_idle (void *data)
                   /* First vsync-related animation cycle, we can now compute the phase. We want the phase to satisfy
                      0 <= phase < frame_interval */
                   priv->smoothed_frame_time_phase =
-                      positive_modulo (priv->smoothed_frame_time_base - priv->frame_time,
+                      positive_modulo (priv->smoothed_frame_time_base - cycle_start,
                                        frame_interval);
                   priv->smooth_phase_state = SMOOTH_PHASE_STATE_VALID;
                 }
 
-              if (priv->smoothed_frame_time_base == 0)
+              if (priv->variable_refresh)
+                {
+                  /* Frames get shown when they are done, there is no grid to align to */
+                  priv->smoothed_frame_time_base = MAX (priv->frame_time, priv->smoothed_frame_time_reported);
+                  priv->smoothed_frame_time_phase = 0;
+                }
+              else if (priv->smoothed_frame_time_base == 0)
                 {
                   /* First frame ever, or first cycle in a new animation sequence. Ensure monotonicity */
                   priv->smoothed_frame_time_base = MAX (priv->frame_time, priv->smoothed_frame_time_reported);
@@ -510,10 +661,10 @@ gdk_frame_clock_paint_idle (void *data)
                 {
                   /* compute_smooth_frame_time() ensures monotonicity */
                   priv->smoothed_frame_time_base =
-                      compute_smooth_frame_time (clock, priv->frame_time + priv->smoothed_frame_time_phase,
+                      compute_smooth_frame_time (clock, cycle_start + priv->smoothed_frame_time_phase,
                                                  priv->paint_is_thaw,
                                                  priv->smoothed_frame_time_base,
-                                                 priv->smoothed_frame_time_period);
+                                                 frame_interval);
                 }
 
               priv->smoothed_frame_time_period = frame_interval;
@@ -526,6 +677,8 @@ gdk_frame_clock_paint_idle (void *data)
               timings->frame_time = priv->frame_time;
               timings->smoothed_frame_time = priv->smoothed_frame_time_base;
               timings->slept_before = priv->sleep_serial != get_sleep_serial ();
+              timings->phase_durations[g_bit_nth_lsf (GDK_FRAME_CLOCK_PHASE_FLUSH_EVENTS, -1)] = priv->flush_events_duration;
+              priv->flush_events_duration = 0;
 
               priv->phase = GDK_FRAME_CLOCK_PHASE_BEFORE_PAINT;
 
@@ -535,7 +688,9 @@ gdk_frame_clock_paint_idle (void *data)
                * in them.
                */
               priv->requested &= ~GDK_FRAME_CLOCK_PHASE_BEFORE_PAINT;
+              start = g_get_monotonic_time ();
               _gdk_frame_clock_emit_before_paint (clock);
+              add_phase_duration (timings, GDK_FRAME_CLOCK_PHASE_BEFORE_PAINT, start);
               priv->phase = GDK_FRAME_CLOCK_PHASE_UPDATE;
             }
           G_GNUC_FALLTHROUGH;
@@ -547,7 +702,9 @@ gdk_frame_clock_paint_idle (void *data)
                   priv->updating_count > 0)
                 {
                   priv->requested &= ~GDK_FRAME_CLOCK_PHASE_UPDATE;
+                  start = g_get_monotonic_time ();
                   _gdk_frame_clock_emit_update (clock);
+                  add_phase_duration (timings, GDK_FRAME_CLOCK_PHASE_UPDATE, start);
                 }
             }
           G_GNUC_FALLTHROUGH;
@@ -572,12 +729,15 @@ gdk_frame_clock_paint_idle (void *data)
 	       * resizes and natural size changes.
 	       */
 	      iter = 0;
+              start = g_get_monotonic_time ();
               while ((priv->requested & GDK_FRAME_CLOCK_PHASE_LAYOUT) &&
 		     priv->freeze_count == 0 && iter++ < 4)
                 {
                   priv->requested &= ~GDK_FRAME_CLOCK_PHASE_LAYOUT;
                   _gdk_frame_clock_emit_layout (clock);
                 }
+              if (iter > 0)
+                add_phase_duration (timings, GDK_FRAME_CLOCK_PHASE_LAYOUT, start);
 	      if (iter == 5)
 		g_warning ("gdk-frame-clock: layout continuously requested, giving up after 4 tries");
             }
@@ -599,7 +759,9 @@ gdk_frame_clock_paint_idle (void *data)
               if (priv->requested & GDK_FRAME_CLOCK_PHASE_PAINT)
                 {
                   priv->requested &= ~GDK_FRAME_CLOCK_PHASE_PAINT;
+                  start = g_get_monotonic_time ();
                   _gdk_frame_clock_emit_paint (clock);
+                  add_phase_duration (timings, GDK_FRAME_CLOCK_PHASE_PAINT, start);
                 }
             }
           G_GNUC_FALLTHROUGH;
@@ -608,10 +770,22 @@ gdk_frame_clock_paint_idle (void *data)
           if (priv->freeze_count == 0)
             {
               priv->requested &= ~GDK_FRAME_CLOCK_PHASE_AFTER_PAINT;
+              start = g_get_monotonic_time ();
               _gdk_frame_clock_emit_after_paint (clock);
+              add_phase_duration (timings, GDK_FRAME_CLOCK_PHASE_AFTER_PAINT, start);
               /* the ::after-paint phase doesn't get repeated on freeze/thaw,
                */
               priv->phase = GDK_FRAME_CLOCK_PHASE_NONE;
+
+              if (cycle_start != 0)
+                {
+                  gint64 duration = g_get_monotonic_time () - priv->frame_time;
+
+                  if (priv->cycle_duration == 0)
+                    priv->cycle_duration = duration;
+                  else
+                    priv->cycle_duration = (priv->cycle_duration * 7 + duration) / 8;
+                }
             }
 #ifdef G_ENABLE_DEBUG
             if (GDK_DEBUG_CHECK (FRAMES))
@@ -628,18 +802,27 @@ gdk_frame_clock_paint_idle (void *data)
   if (priv->requested & GDK_FRAME_CLOCK_PHASE_RESUME_EVENTS)
     {
       priv->requested &= ~GDK_FRAME_CLOCK_PHASE_RESUME_EVENTS;
+      start = g_get_monotonic_time ();
       _gdk_frame_clock_emit_resume_events (clock);
+      add_phase_duration (timings, GDK_FRAME_CLOCK_PHASE_RESUME_EVENTS, start);
     }
 
   if (priv->freeze_count == 0)
     priv->phase = GDK_FRAME_CLOCK_PHASE_NONE;
 
   priv->in_paint_idle = FALSE;
+  priv->paint_delay = 0;
 
   /* If there is throttling in the backend layer, then we'll do another
    * update as soon as the backend unthrottles (if there is work to do),
    * otherwise we need to figure when the next frame should be.
+   *
+   * With variable refresh, we don't wait for a grid either way, we just
+   * don't start cycles faster than the monitor or the throttled rate.
    */
+  if (priv->variable_refresh)
+    priv->min_next_frame_time = priv->frame_time + priv->throttle_factor * priv->refresh_interval;
+
   if (priv->freeze_count == 0)
     {
       /*
@@ -652,8 +835,11 @@ gdk_frame_clock_paint_idle (void *data)
        * simply advanced in increments of the refresh interval, but this time we are in sync with the vsync. If we start
        * receiving "frame drawn" events shortly after losing them, then we should still be in sync.
        */
-      gint64 smooth_cycle_start = priv->smoothed_frame_time_base - priv->smoothed_frame_time_phase;
-      priv->min_next_frame_time = smooth_cycle_start + priv->smoothed_frame_time_period;
+      if (!priv->variable_refresh)
+        {
+          gint64 smooth_cycle_start = priv->smoothed_frame_time_base - priv->smoothed_frame_time_phase;
+          priv->min_next_frame_time = smooth_cycle_start + priv->smoothed_frame_time_period;
+        }
 
       maybe_start_idle (clock_idle, FALSE);
     }
@@ -790,6 +976,41 @@ gdk_frame_clock_idle_class_init (GdkFrameClockIdleClass *klass)
   frame_clock_class->thaw = gdk_frame_clock_idle_thaw;
 }
 
+/*
+ * _gdk_frame_clock_idle_set_refresh_rate:
+ * @clock_idle: a `GdkFrameClockIdle`
+ * @refresh_rate: the refresh rate of the monitor the surfaces of
+ *   the clock are shown on, in milli-Hertz, or 0 if unknown
+ * @variable_refresh: whether the monitor has a variable refresh rate,
+ *   in which case @refresh_rate is the fastest one
+ *
+ * Backends call this when their surfaces move to another monitor, or the
+ * monitor changes. The refresh interval reported in the frame timings
+ * still takes precedence for fixed refresh rates.
+ */
+void
+_gdk_frame_clock_idle_set_refresh_rate (GdkFrameClockIdle *clock_idle,
+                                        int                refresh_rate,
+                                        gboolean           variable_refresh)
+{
+  GdkFrameClockIdlePrivate *priv = clock_idle->priv;
+
+  priv->refresh_interval = refresh_rate > 0
+                           ? G_GINT64_CONSTANT (1000000000) / refresh_rate
+                           : FRAME_INTERVAL;
+
+  variable_refresh = !!variable_refresh;
+  if (priv->variable_refresh == variable_refresh)
+    return;
+
+  priv->variable_refresh = variable_refresh;
+  priv->throttle_factor = 1;
+  priv->missed_frames = 0;
+  priv->early_frames = 0;
+  priv->min_next_frame_time = 0;
+  priv->smoothed_frame_time_phase = 0;
+}
+
 GdkFrameClock *
 _gdk_frame_clock_idle_new (void)
 {
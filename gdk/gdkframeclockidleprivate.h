@@ -60,6 +60,10 @@ GType           gdk_frame_clock_idle_get_type       (void) G_GNUC_CONST;
 
 GdkFrameClock *_gdk_frame_clock_idle_new            (void);
 
+void           _gdk_frame_clock_idle_set_refresh_rate (GdkFrameClockIdle *clock_idle,
+                                                       int                refresh_rate,
+                                                       gboolean           variable_refresh);
+
 G_END_DECLS
 
 #endif /* __GDK_FRAME_CLOCK_IDLE_H__ */
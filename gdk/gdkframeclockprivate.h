@@ -82,6 +82,8 @@ struct _GdkFrameClockClass
   /* void (* resume_events)      (GdkFrameClock *clock); */
 };
 
+#define GDK_FRAME_CLOCK_N_PHASES 7
+
 struct _GdkFrameTimings
 {
   /*< private >*/
@@ -95,6 +97,11 @@ struct _GdkFrameTimings
   gint64 presentation_time;
   gint64 refresh_interval;
   gint64 predicted_presentation_time;
+  /* When the oldest input event handled in this frame was queued, or 0 */
+  gint64 input_time;
+
+  /* Time spent in each phase, indexed by the bit of the phase */
+  gint64 phase_durations[GDK_FRAME_CLOCK_N_PHASES];
 
 #ifdef G_ENABLE_DEBUG
   gint64 layout_start_time;
@@ -104,12 +111,16 @@ struct _GdkFrameTimings
 
   guint complete : 1;
   guint slept_before : 1;
+  /* presentation_time was reported by the compositor, not guessed */
+  guint presentation_time_is_reported : 1;
 };
 
 void _gdk_frame_clock_inhibit_freeze (GdkFrameClock *clock);
 void _gdk_frame_clock_uninhibit_freeze (GdkFrameClock *clock);
 
 void _gdk_frame_clock_begin_frame         (GdkFrameClock   *clock);
+void _gdk_frame_clock_add_input           (GdkFrameClock   *clock,
+                                           gint64           input_time);
 void _gdk_frame_clock_debug_print_timings (GdkFrameClock   *clock,
                                            GdkFrameTimings *timings);
 void _gdk_frame_clock_add_timings_to_profiler (GdkFrameClock *frame_clock,
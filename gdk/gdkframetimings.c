@@ -233,3 +233,52 @@ gdk_frame_timings_get_refresh_interval (GdkFrameTimings *timings)
 
   return timings->refresh_interval;
 }
+
+/**
+ * gdk_frame_timings_get_phase_duration:
+ * @timings: a #GdkFrameTimings
+ * @phase: a single #GdkFrameClockPhase
+ *
+ * Gets how long the frame clock spent in @phase for this frame,
+ * such as the time that layout or painting took. If a phase was
+ * run several times, for example because the frame clock was
+ * frozen in the middle of it, the durations are added up.
+ *
+ * The time of the flush-events phase is the time spent flushing
+ * events since the previous frame.
+ *
+ * Returns: the duration of @phase, in microseconds, or 0 if the
+ *   phase did not run
+ */
+gint64
+gdk_frame_timings_get_phase_duration (GdkFrameTimings    *timings,
+                                      GdkFrameClockPhase  phase)
+{
+  int i;
+
+  g_return_val_if_fail (timings != NULL, 0);
+
+  i = g_bit_nth_lsf (phase, -1);
+  g_return_val_if_fail (i >= 0 && i < GDK_FRAME_CLOCK_N_PHASES && phase == 1 << i, 0);
+
+  return timings->phase_durations[i];
+}
+
+/*< private >
+ * gdk_frame_timings_get_input_time:
+ * @timings: a #GdkFrameTimings
+ *
+ * Gets the time when the oldest input event that was handled
+ * for this frame was queued. Together with the presentation
+ * time, this gives the latency from input to display.
+ *
+ * Returns: the input time in the timescale of g_get_monotonic_time(),
+ *   or 0 if no input was handled for this frame
+ */
+gint64
+gdk_frame_timings_get_input_time (GdkFrameTimings *timings)
+{
+  g_return_val_if_fail (timings != NULL, 0);
+
+  return timings->input_time;
+}
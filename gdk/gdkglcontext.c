@@ -99,6 +99,8 @@
 
 #include <epoxy/gl.h>
 
+typedef struct _GdkGLUploadPool GdkGLUploadPool;
+
 typedef struct {
   GdkGLContext *shared_context;
 
@@ -116,12 +118,17 @@ typedef struct {
   guint debug_enabled : 1;
   guint forward_compatible : 1;
   guint is_legacy : 1;
+  guint has_sync : 1;
 
   int use_es;
 
   int max_debug_label_length;
 
   GdkGLContextPaintData *paint_data;
+
+  /* The pool this context was created for, or the pool of contexts
+   * created to upload textures for this paint context */
+  GdkGLUploadPool *upload_pool;
 } GdkGLContextPrivate;
 
 enum {
@@ -151,6 +158,139 @@ gdk_gl_context_clear_old_updated_area (GdkGLContext *context)
     }
 }
 
+/* Textures can be uploaded from other threads using contexts that
+ * share data with a surface's paint context. They get created on the
+ * main thread when needed and are reused afterwards. The pool is
+ * refcounted so that contexts that are in use by a thread or that
+ * still own textures can outlive their paint context. */
+#define MAX_UPLOAD_CONTEXTS 4
+
+struct _GdkGLUploadPool
+{
+  gatomicrefcount ref_count;
+
+  GMutex lock;
+  GCond cond;
+
+  GdkGLContext *paint_context; /* unowned, NULL after shutdown */
+  GPtrArray *idle;
+  guint n_contexts;
+  guint creating : 1;
+
+  GError *error;
+};
+
+static GdkGLUploadPool *
+gdk_gl_upload_pool_new (GdkGLContext *paint_context)
+{
+  GdkGLUploadPool *pool = g_new0 (GdkGLUploadPool, 1);
+
+  g_atomic_ref_count_init (&pool->ref_count);
+  g_mutex_init (&pool->lock);
+  g_cond_init (&pool->cond);
+  pool->paint_context = paint_context;
+  pool->idle = g_ptr_array_new_with_free_func (g_object_unref);
+
+  return pool;
+}
+
+static GdkGLUploadPool *
+gdk_gl_upload_pool_ref (GdkGLUploadPool *pool)
+{
+  g_atomic_ref_count_inc (&pool->ref_count);
+
+  return pool;
+}
+
+static void
+gdk_gl_upload_pool_unref (GdkGLUploadPool *pool)
+{
+  if (!g_atomic_ref_count_dec (&pool->ref_count))
+    return;
+
+  g_ptr_array_unref (pool->idle);
+  g_clear_error (&pool->error);
+  g_cond_clear (&pool->cond);
+  g_mutex_clear (&pool->lock);
+  g_free (pool);
+}
+
+static void
+gdk_gl_upload_pool_shutdown (GdkGLUploadPool *pool)
+{
+  GPtrArray *idle;
+
+  g_mutex_lock (&pool->lock);
+  pool->paint_context = NULL;
+  idle = pool->idle;
+  pool->idle = g_ptr_array_new_with_free_func (g_object_unref);
+  g_cond_broadcast (&pool->cond);
+  g_mutex_unlock (&pool->lock);
+
+  /* The contexts reference the pool, don't free it under the lock */
+  g_ptr_array_unref (idle);
+}
+
+/* Must be called on the main thread */
+static void
+gdk_gl_upload_pool_add_context (GdkGLUploadPool *pool)
+{
+  GdkGLContext *paint_context;
+  GdkGLContext *context = NULL;
+  GError *error = NULL;
+
+  g_mutex_lock (&pool->lock);
+  paint_context = pool->paint_context ? g_object_ref (pool->paint_context) : NULL;
+  g_mutex_unlock (&pool->lock);
+
+  if (paint_context == NULL)
+    return;
+
+  context = gdk_surface_create_gl_context (gdk_gl_context_get_surface (paint_context), &error);
+  if (context && !gdk_gl_context_realize (context, &error))
+    g_clear_object (&context);
+
+  if (context)
+    {
+      GdkGLContextPrivate *priv = gdk_gl_context_get_instance_private (context);
+
+      priv->upload_pool = gdk_gl_upload_pool_ref (pool);
+    }
+
+  g_object_unref (paint_context);
+
+  g_mutex_lock (&pool->lock);
+  if (context)
+    {
+      g_ptr_array_add (pool->idle, context);
+      pool->n_contexts++;
+    }
+  else
+    {
+      g_clear_error (&pool->error);
+      pool->error = error;
+    }
+  g_cond_broadcast (&pool->cond);
+  g_mutex_unlock (&pool->lock);
+}
+
+static gboolean
+gdk_gl_upload_pool_create_context_cb (gpointer data)
+{
+  GdkGLUploadPool *pool = data;
+
+  gdk_gl_upload_pool_add_context (pool);
+
+  g_mutex_lock (&pool->lock);
+  pool->creating = FALSE;
+  g_cond_broadcast (&pool->cond);
+  g_mutex_unlock (&pool->lock);
+
+  gdk_gl_upload_pool_unref (pool);
+
+  return G_SOURCE_REMOVE;
+}
+
 static void
 gdk_gl_context_dispose (GObject *gobject)
 {
@@ -164,6 +304,13 @@ gdk_gl_context_dispose (GObject *gobject)
   if (current == context)
     g_private_replace (&thread_current_context, NULL);
 
+  if (priv->upload_pool)
+    {
+      if (priv->upload_pool->paint_context == context)
+        gdk_gl_upload_pool_shutdown (priv->upload_pool);
+      g_clear_pointer (&priv->upload_pool, gdk_gl_upload_pool_unref);
+    }
+
   g_clear_object (&priv->shared_context);
 
   G_OBJECT_CLASS (gdk_gl_context_parent_class)->dispose (gobject);
@@ -222,6 +369,38 @@ gdk_gl_context_get_property (GObject    *gobject,
     }
 }
 
+/* Returns the format that gdk_gl_context_upload_texture() hands data
+ * in @data_format to GL in, any other format gets converted on the CPU */
+GdkMemoryFormat
+gdk_gl_context_get_upload_format (GdkGLContext    *context,
+                                  GdkMemoryFormat  data_format)
+{
+  GdkGLContextPrivate *priv = gdk_gl_context_get_instance_private (context);
+
+  if (priv->use_es)
+    {
+      /* GLES only supports rgba, and half floats since 3.0 */
+      if (data_format == GDK_MEMORY_R16G16B16A16_FLOAT_PREMULTIPLIED &&
+          priv->gl_version >= 30)
+        return data_format;
+
+      return GDK_MEMORY_R8G8B8A8_PREMULTIPLIED;
+    }
+
+  switch ((int) data_format)
+    {
+    case GDK_MEMORY_DEFAULT: /* Cairo surface format */
+    case GDK_MEMORY_R8G8B8: /* Pixmap non-alpha data */
+    case GDK_MEMORY_R16G16B16A16_PREMULTIPLIED:
+    case GDK_MEMORY_R16G16B16A16_FLOAT_PREMULTIPLIED:
+    case GDK_MEMORY_R32G32B32A32_FLOAT_PREMULTIPLIED:
+      return data_format;
+
+    default: /* Fall-back, convert to cairo-surface-format */
+      return GDK_MEMORY_DEFAULT;
+    }
+}
+
 void
 gdk_gl_context_upload_texture (GdkGLContext    *context,
                                const guchar    *data,
@@ -232,58 +411,67 @@ gdk_gl_context_upload_texture (GdkGLContext    *context,
                                guint            texture_target)
 {
   GdkGLContextPrivate *priv = gdk_gl_context_get_instance_private (context);
+  GdkMemoryFormat upload_format;
   guchar *copy = NULL;
+  guint gl_internal_format;
   guint gl_format;
   guint gl_type;
   guint bpp;
 
   g_return_if_fail (GDK_IS_GL_CONTEXT (context));
 
-  if (priv->use_es)
+  upload_format = gdk_gl_context_get_upload_format (context, data_format);
+  bpp = gdk_memory_format_bytes_per_pixel (upload_format);
+
+  if (upload_format != data_format)
     {
-      /* GLES only supports rgba, so convert if necessary */
-      if (data_format != GDK_MEMORY_R8G8B8A8_PREMULTIPLIED)
-        {
-          copy = g_malloc (width * height * 4);
-          gdk_memory_convert (copy, width * 4,
-                              GDK_MEMORY_R8G8B8A8_PREMULTIPLIED,
-                              data, stride, data_format,
-                              width, height);
-          stride = width * 4;
-          data = copy;
-        }
+      copy = g_malloc (width * height * bpp);
+      gdk_memory_convert (copy, width * bpp,
+                          upload_format,
+                          data, stride, data_format,
+                          width, height);
+      stride = width * bpp;
+      data = copy;
+    }
+
+  switch ((int) upload_format)
+    {
+    case GDK_MEMORY_R16G16B16A16_PREMULTIPLIED:
+      gl_internal_format = GL_RGBA16;
+      gl_format = GL_RGBA;
+      gl_type = GL_UNSIGNED_SHORT;
+      break;
 
-      bpp = 4;
+    case GDK_MEMORY_R16G16B16A16_FLOAT_PREMULTIPLIED:
+      gl_internal_format = GL_RGBA16F;
       gl_format = GL_RGBA;
+      gl_type = GL_HALF_FLOAT;
+      break;
+
+    case GDK_MEMORY_R32G32B32A32_FLOAT_PREMULTIPLIED:
+      gl_internal_format = GL_RGBA32F;
+      gl_format = GL_RGBA;
+      gl_type = GL_FLOAT;
+      break;
+
+    case GDK_MEMORY_R8G8B8:
+      gl_internal_format = GL_RGBA;
+      gl_format = GL_RGB;
       gl_type = GL_UNSIGNED_BYTE;
-    }
-  else
-    {
-      if (data_format == GDK_MEMORY_DEFAULT) /* Cairo surface format */
-        {
-          gl_format = GL_BGRA;
-          gl_type = GL_UNSIGNED_INT_8_8_8_8_REV;
-          bpp = 4;
-        }
-      else if (data_format == GDK_MEMORY_R8G8B8) /* Pixmap non-alpha data */
-        {
-          gl_format = GL_RGB;
-          gl_type = GL_UNSIGNED_BYTE;
-          bpp = 3;
-        }
-      else /* Fall-back, convert to cairo-surface-format */
-        {
-          copy = g_malloc (width * height * 4);
-          gdk_memory_convert (copy, width * 4,
-                              GDK_MEMORY_DEFAULT,
-                              data, stride, data_format,
-                              width, height);
-          stride = width * 4;
-          bpp = 4;
-          data = copy;
-          gl_format = GL_BGRA;
-          gl_type = GL_UNSIGNED_INT_8_8_8_8_REV;
-        }
+      break;
+
+    case GDK_MEMORY_R8G8B8A8_PREMULTIPLIED:
+      gl_internal_format = GL_RGBA;
+      gl_format = GL_RGBA;
+      gl_type = GL_UNSIGNED_BYTE;
+      break;
+
+    case GDK_MEMORY_DEFAULT:
+    default:
+      gl_internal_format = GL_RGBA;
+      gl_format = GL_BGRA;
+      gl_type = GL_UNSIGNED_INT_8_8_8_8_REV;
+      break;
     }
 
   /* GL_UNPACK_ROW_LENGTH is available on desktop GL, OpenGL ES >= 3.0, or if
@@ -293,7 +481,7 @@ gdk_gl_context_upload_texture (GdkGLContext    *context,
     {
       glPixelStorei (GL_UNPACK_ALIGNMENT, 1);
 
-      glTexImage2D (texture_target, 0, GL_RGBA, width, height, 0, gl_format, gl_type, data);
+      glTexImage2D (texture_target, 0, gl_internal_format, width, height, 0, gl_format, gl_type, data);
       glPixelStorei (GL_UNPACK_ALIGNMENT, 4);
     }
   else if ((!priv->use_es ||
@@ -301,14 +489,14 @@ gdk_gl_context_upload_texture (GdkGLContext    *context,
     {
       glPixelStorei (GL_UNPACK_ROW_LENGTH, stride / bpp);
 
-      glTexImage2D (texture_target, 0, GL_RGBA, width, height, 0, gl_format, gl_type, data);
+      glTexImage2D (texture_target, 0, gl_internal_format, width, height, 0, gl_format, gl_type, data);
 
       glPixelStorei (GL_UNPACK_ROW_LENGTH, 0);
     }
   else
     {
       int i;
-      glTexImage2D (texture_target, 0, GL_RGBA, width, height, 0, gl_format, gl_type, NULL);
+      glTexImage2D (texture_target, 0, gl_internal_format, width, height, 0, gl_format, gl_type, NULL);
       for (i = 0; i < height; i++)
         glTexSubImage2D (texture_target, 0, 0, i, width, 1, gl_format, gl_type, data + (i * stride));
     }
@@ -316,6 +504,22 @@ gdk_gl_context_upload_texture (GdkGLContext    *context,
   g_free (copy);
 }
 
+/* Makes the dma-buf the contents of the texture that is bound to
+ * @target, without copying it. Returns %FALSE if that isn't possible,
+ * so the texture needs to be uploaded like any other */
+gboolean
+gdk_gl_context_import_dmabuf (GdkGLContext     *context,
+                              GdkDmabufTexture *texture,
+                              guint             target)
+{
+  GdkGLContextClass *klass = GDK_GL_CONTEXT_GET_CLASS (context);
+
+  if (klass->import_dmabuf == NULL)
+    return FALSE;
+
+  return klass->import_dmabuf (context, texture, target);
+}
+
 static gboolean
 gdk_gl_context_real_realize (GdkGLContext  *self,
                              GError       **error)
@@ -1030,6 +1234,7 @@ gdk_gl_context_check_extensions (GdkGLContext *context)
 
       priv->has_unpack_subimage = epoxy_has_gl_extension ("GL_EXT_unpack_subimage");
       priv->has_khr_debug = epoxy_has_gl_extension ("GL_KHR_debug");
+      priv->has_sync = priv->gl_version >= 30;
     }
   else
     {
@@ -1038,6 +1243,7 @@ gdk_gl_context_check_extensions (GdkGLContext *context)
 
       priv->has_unpack_subimage = TRUE;
       priv->has_khr_debug = epoxy_has_gl_extension ("GL_KHR_debug");
+      priv->has_sync = priv->gl_version >= 32 || epoxy_has_gl_extension ("GL_ARB_sync");
 
       /* We asked for a core profile, but we didn't get one, so we're in legacy mode */
       if (priv->gl_version < 32)
@@ -1256,3 +1462,186 @@ gdk_gl_context_use_es_bgra (GdkGLContext *context)
 
   return FALSE;
 }
+
+gboolean
+gdk_gl_context_has_sync (GdkGLContext *context)
+{
+  GdkGLContextPrivate *priv = gdk_gl_context_get_instance_private (context);
+
+  return priv->has_sync;
+}
+
+/* Returns the context that textures uploaded for @context share
+ * data with, that is the paint context of its surface */
+static GdkGLContext *
+gdk_gl_context_get_paint_context (GdkGLContext *context)
+{
+  GdkGLContextPrivate *priv = gdk_gl_context_get_instance_private (context);
+
+  if (priv->upload_pool)
+    return priv->upload_pool->paint_context;
+
+  if (priv->shared_context)
+    return priv->shared_context;
+
+  return context;
+}
+
+/*< private >
+ * gdk_gl_context_acquire_upload_context:
+ * @context: a #GdkGLContext
+ * @error: return location for an error
+ *
+ * Takes a context out of the upload pool of @context's surface and
+ * makes it current. It shares data with @context, so textures that
+ * are created with it can be used by @context without copying them.
+ *
+ * This function can be called from any thread. If all contexts are
+ * in use, it blocks until one gets released, and if a new one needs
+ * to be created, it blocks until the main thread created it.
+ *
+ * Returns: (transfer full): the upload context, release it with
+ *   gdk_gl_context_release_upload_context()
+ */
+GdkGLContext *
+gdk_gl_context_acquire_upload_context (GdkGLContext  *context,
+                                       GError       **error)
+{
+  GdkGLContext *paint_context;
+  GdkGLContextPrivate *paint_priv;
+  GdkGLUploadPool *pool;
+  GdkGLContext *upload = NULL;
+
+  g_return_val_if_fail (GDK_IS_GL_CONTEXT (context), NULL);
+
+  paint_context = gdk_gl_context_get_paint_context (context);
+  if (paint_context == NULL)
+    {
+      g_set_error_literal (error, GDK_GL_ERROR, GDK_GL_ERROR_NOT_AVAILABLE,
+                           _("The surface has been destroyed"));
+      return NULL;
+    }
+
+  paint_priv = gdk_gl_context_get_instance_private (paint_context);
+
+  /* The pool is created along with the paint context */
+  pool = paint_priv->upload_pool;
+  if (pool == NULL)
+    {
+      g_set_error_literal (error, GDK_GL_ERROR, GDK_GL_ERROR_NOT_AVAILABLE,
+                           _("Texture uploads have not been enabled for this context"));
+      return NULL;
+    }
+
+  gdk_gl_upload_pool_ref (pool);
+
+  g_mutex_lock (&pool->lock);
+  while (upload == NULL)
+    {
+      if (pool->paint_context == NULL)
+        {
+          g_set_error_literal (error, GDK_GL_ERROR, GDK_GL_ERROR_NOT_AVAILABLE,
+                               _("The surface has been destroyed"));
+          break;
+        }
+
+      if (pool->idle->len > 0)
+        {
+          upload = g_ptr_array_steal_index_fast (pool->idle, pool->idle->len - 1);
+          break;
+        }
+
+      if (pool->error)
+        {
+          g_propagate_error (error, g_error_copy (pool->error));
+          break;
+        }
+
+      if (pool->n_contexts < MAX_UPLOAD_CONTEXTS)
+        {
+          /* The main thread can't wait for itself */
+          if (g_main_context_is_owner (g_main_context_default ()))
+            {
+              g_mutex_unlock (&pool->lock);
+              gdk_gl_upload_pool_add_context (pool);
+              g_mutex_lock (&pool->lock);
+              continue;
+            }
+
+          if (!pool->creating)
+            {
+              pool->creating = TRUE;
+              g_mutex_unlock (&pool->lock);
+              /* Runs right away if nobody is running the main loop */
+              g_main_context_invoke (NULL,
+                                     gdk_gl_upload_pool_create_context_cb,
+                                     gdk_gl_upload_pool_ref (pool));
+              g_mutex_lock (&pool->lock);
+              continue;
+            }
+        }
+
+      g_cond_wait (&pool->cond, &pool->lock);
+    }
+  g_mutex_unlock (&pool->lock);
+
+  gdk_gl_upload_pool_unref (pool);
+
+  if (upload)
+    gdk_gl_context_make_current (upload);
+
+  return upload;
+}
+
+/*< private >
+ * gdk_gl_context_release_upload_context:
+ * @upload: a context returned by gdk_gl_context_acquire_upload_context()
+ *
+ * Clears the current context and puts @upload back into its pool.
+ */
+void
+gdk_gl_context_release_upload_context (GdkGLContext *upload)
+{
+  GdkGLContextPrivate *priv = gdk_gl_context_get_instance_private (upload);
+  GdkGLUploadPool *pool = priv->upload_pool;
+
+  gdk_gl_context_clear_current ();
+
+  g_mutex_lock (&pool->lock);
+  if (pool->paint_context)
+    {
+      g_ptr_array_add (pool->idle, upload);
+      upload = NULL;
+      g_cond_signal (&pool->cond);
+    }
+  else
+    {
+      pool->n_contexts--;
+    }
+  g_mutex_unlock (&pool->lock);
+
+  g_clear_object (&upload);
+}
+
+/*< private >
+ * gdk_gl_context_ensure_upload_pool:
+ * @context: a #GdkGLContext
+ *
+ * Allows gdk_gl_context_acquire_upload_context() to be used for
+ * @context. This must be called on the main thread, GDK does it when
+ * it creates the paint context of a surface.
+ */
+void
+gdk_gl_context_ensure_upload_pool (GdkGLContext *context)
+{
+  GdkGLContext *paint_context;
+  GdkGLContextPrivate *paint_priv;
+
+  paint_context = gdk_gl_context_get_paint_context (context);
+  if (paint_context == NULL)
+    return;
+
+  paint_priv = gdk_gl_context_get_instance_private (paint_context);
+  if (paint_priv->upload_pool == NULL)
+    paint_priv->upload_pool = gdk_gl_upload_pool_new (paint_context);
+}
@@ -24,6 +24,7 @@
 #include "gdkglcontext.h"
 #include "gdkdrawcontextprivate.h"
 #include "gdkmemorytexture.h"
+#include "gdkdmabuftexture.h"
 
 G_BEGIN_DECLS
 
@@ -49,6 +50,10 @@ struct _GdkGLContextClass
                         GError **error);
 
   cairo_region_t * (* get_damage) (GdkGLContext *context);
+
+  gboolean (* import_dmabuf) (GdkGLContext     *context,
+                              GdkDmabufTexture *texture,
+                              guint             target);
 };
 
 typedef struct {
@@ -76,6 +81,8 @@ typedef struct {
 void                    gdk_gl_context_set_is_legacy            (GdkGLContext    *context,
                                                                  gboolean         is_legacy);
 
+GdkMemoryFormat         gdk_gl_context_get_upload_format        (GdkGLContext    *context,
+                                                                 GdkMemoryFormat  data_format);
 void                    gdk_gl_context_upload_texture           (GdkGLContext    *context,
                                                                  const guchar    *data,
                                                                  int              width,
@@ -83,6 +90,9 @@ void                    gdk_gl_context_upload_texture           (GdkGLContext
                                                                  int              stride,
                                                                  GdkMemoryFormat  data_format,
                                                                  guint            texture_target);
+gboolean                gdk_gl_context_import_dmabuf            (GdkGLContext    *context,
+                                                                 GdkDmabufTexture *texture,
+                                                                 guint            target);
 GdkGLContextPaintData * gdk_gl_context_get_paint_data           (GdkGLContext    *context);
 gboolean                gdk_gl_context_use_texture_rectangle    (GdkGLContext    *context);
 gboolean                gdk_gl_context_has_unpack_subimage      (GdkGLContext    *context);
@@ -105,6 +115,12 @@ void                    gdk_gl_context_label_object_printf      (GdkGLContext
 gboolean                gdk_gl_context_has_debug                (GdkGLContext    *self) G_GNUC_PURE;
 
 gboolean                gdk_gl_context_use_es_bgra              (GdkGLContext    *context);
+gboolean                gdk_gl_context_has_sync                 (GdkGLContext    *context);
+
+void                    gdk_gl_context_ensure_upload_pool       (GdkGLContext    *context);
+GdkGLContext *          gdk_gl_context_acquire_upload_context   (GdkGLContext    *context,
+                                                                 GError         **error);
+void                    gdk_gl_context_release_upload_context   (GdkGLContext    *upload);
 
 typedef struct {
   float x1, y1, x2, y2;
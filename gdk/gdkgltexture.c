@@ -21,6 +21,8 @@
 #include "gdkgltextureprivate.h"
 
 #include "gdkcairo.h"
+#include "gdkglcontextprivate.h"
+#include "gdkmemorytextureprivate.h"
 #include "gdktextureprivate.h"
 
 #include <epoxy/gl.h>
@@ -31,9 +33,15 @@ struct _GdkGLTexture {
   GdkGLContext *context;
   guint id;
 
+  /* Signaled when the producer is done writing the texture */
+  GLsync sync;
+  /* Signaled when GSK is done reading it, for @release */
+  GLsync release_sync;
+
   cairo_surface_t *saved;
 
   GDestroyNotify destroy;
+  GdkGLTextureReleaseFunc release;
   gpointer data;
 };
 
@@ -44,19 +52,37 @@ struct _GdkGLTextureClass {
 G_DEFINE_TYPE (GdkGLTexture, gdk_gl_texture, GDK_TYPE_TEXTURE)
 
 static void
-gdk_gl_texture_dispose (GObject *object)
+gdk_gl_texture_return (GdkGLTexture *self)
 {
-  GdkGLTexture *self = GDK_GL_TEXTURE (object);
-
-  if (self->destroy)
+  if (self->release)
+    {
+      self->release (self, self->release_sync, self->data);
+      self->release = NULL;
+    }
+  else if (self->destroy)
     {
       self->destroy (self->data);
-      self->destroy = NULL;
-      self->data = NULL;
     }
 
+  self->destroy = NULL;
+  self->data = NULL;
+  self->release_sync = NULL;
+}
+
+static void
+gdk_gl_texture_dispose (GObject *object)
+{
+  GdkGLTexture *self = GDK_GL_TEXTURE (object);
+
+  gdk_gl_texture_return (self);
+
+  /* Never drawn, so nobody waited for it */
+  if (self->sync && gdk_gl_context_get_current ())
+    glDeleteSync (self->sync);
+
   g_clear_object (&self->context);
   self->id = 0;
+  self->sync = NULL;
 
   if (self->saved)
     {
@@ -131,6 +157,39 @@ gdk_gl_texture_get_id (GdkGLTexture *self)
   return self->id;
 }
 
+/* Makes the current context wait until the texture's producer is done,
+ * for textures created with gdk_gl_texture_new_with_sync() and
+ * gdk_gl_texture_new_from_texture(). The current context must share
+ * data with the texture's context. */
+void
+gdk_gl_texture_wait_sync (GdkGLTexture *self)
+{
+  if (self->sync == NULL)
+    return;
+
+  glWaitSync (self->sync, 0, GL_TIMEOUT_IGNORED);
+  glDeleteSync (self->sync);
+  self->sync = NULL;
+}
+
+gboolean
+gdk_gl_texture_wants_release_sync (GdkGLTexture *self)
+{
+  return self->release != NULL;
+}
+
+/* Takes ownership of @sync, which must be signaled once the last
+ * command reading the texture has finished */
+void
+gdk_gl_texture_set_release_sync (GdkGLTexture *self,
+                                 gpointer      sync)
+{
+  if (self->release_sync)
+    glDeleteSync (self->release_sync);
+
+  self->release_sync = sync;
+}
+
 /**
  * gdk_gl_texture_release:
  * @self: a #GdkTexture wrapping a GL texture
@@ -164,12 +223,7 @@ gdk_gl_texture_release (GdkGLTexture *self)
 
   cairo_destroy (cr);
 
-  if (self->destroy)
-    {
-      self->destroy (self->data);
-      self->destroy = NULL;
-      self->data = NULL;
-    }
+  gdk_gl_texture_return (self);
 
   g_clear_object (&self->context);
   self->id = 0;
@@ -221,3 +275,222 @@ gdk_gl_texture_new (GdkGLContext   *context,
   return GDK_TEXTURE (self);
 }
 
+/**
+ * gdk_gl_texture_new_with_sync:
+ * @context: a #GdkGLContext
+ * @id: the ID of a texture that was created with @context
+ * @width: the nominal width of the texture
+ * @height: the nominal height of the texture
+ * @sync: (nullable): a GLsync that is signaled once the texture has been
+ *     fully written, or %NULL
+ * @release: a function that will be called when the GL resources are
+ *     released
+ * @data: data that gets passed to @release
+ *
+ * Creates a new texture for an existing GL texture that may still be
+ * being drawn to.
+ *
+ * Unlike with gdk_gl_texture_new(), @context does not need to wait for
+ * its rendering to finish with glFinish() before handing the texture to
+ * GTK. Instead, it can create a fence with glFenceSync() and pass it as
+ * @sync. GTK waits for it on the GPU before it reads the texture for the
+ * first time and deletes it afterwards.
+ *
+ * When GTK is done with the texture, @release is called with a GLsync
+ * that is signaled once the GPU has finished reading the texture, or
+ * %NULL if the texture has not been used by GTK's GL renderer. The
+ * receiver owns that fence; it can wait for it with glWaitSync() or
+ * glClientWaitSync() before reusing the texture, and must delete it with
+ * glDeleteSync().
+ *
+ * @context must share data with the GL contexts of GTK's renderer for
+ * the fences to be usable on both sides, which is the case for contexts
+ * created with gdk_surface_create_gl_context().
+ *
+ * Return value: (transfer full): A newly-created #GdkTexture
+ */
+GdkTexture *
+gdk_gl_texture_new_with_sync (GdkGLContext            *context,
+                              guint                    id,
+                              int                      width,
+                              int                      height,
+                              gpointer                 sync,
+                              GdkGLTextureReleaseFunc  release,
+                              gpointer                 data)
+{
+  GdkGLTexture *self;
+
+  g_return_val_if_fail (GDK_IS_GL_CONTEXT (context), NULL);
+  g_return_val_if_fail (id != 0, NULL);
+  g_return_val_if_fail (width > 0, NULL);
+  g_return_val_if_fail (height > 0, NULL);
+  g_return_val_if_fail (release != NULL, NULL);
+
+  self = (GdkGLTexture *) gdk_gl_texture_new (context, id, width, height, NULL, NULL);
+
+  self->sync = sync;
+  self->release = release;
+  self->data = data;
+
+  return GDK_TEXTURE (self);
+}
+
+typedef struct {
+  GdkGLContext *context;
+  guint id;
+} UploadedTexture;
+
+static void
+uploaded_texture_free (gpointer data)
+{
+  UploadedTexture *uploaded = data;
+  GdkGLContext *current, *upload = NULL;
+
+  /* Any context that shares data with the texture can delete it,
+   * usually that's the renderer's, which is current already */
+  current = gdk_gl_context_get_current ();
+  if (current)
+    g_object_ref (current);
+
+  if (current == NULL ||
+      (current != uploaded->context &&
+       gdk_gl_context_get_shared_context (current) != gdk_gl_context_get_shared_context (uploaded->context)))
+    {
+      upload = gdk_gl_context_acquire_upload_context (uploaded->context, NULL);
+      if (upload == NULL)
+        goto out;
+    }
+
+  glDeleteTextures (1, &uploaded->id);
+
+  if (upload)
+    {
+      gdk_gl_context_release_upload_context (upload);
+      if (current)
+        gdk_gl_context_make_current (current);
+    }
+
+out:
+  g_clear_object (&current);
+  g_object_unref (uploaded->context);
+  g_slice_free (UploadedTexture, uploaded);
+}
+
+/**
+ * gdk_gl_texture_new_from_texture:
+ * @context: a #GdkGLContext
+ * @texture: the #GdkTexture to upload
+ * @error: return location for an error
+ *
+ * Uploads @texture into a new GL texture that can be used by @context
+ * and the other contexts of its surface without copying it again.
+ *
+ * Unlike other GL functions, this function can be called from any
+ * thread, so images that are decoded in a worker thread can be
+ * uploaded there too. GDK keeps a small pool of GL contexts for that
+ * purpose. If a new one needs to be created, this function waits for
+ * the main loop to do it, so it must not be called from a thread that
+ * the main thread is blocked on.
+ *
+ * The upload is not necessarily finished when this function returns,
+ * GSK waits for it before the texture is first drawn.
+ *
+ * @texture must not be a #GdkGLTexture.
+ *
+ * Returns: (transfer full) (nullable): a new #GdkGLTexture, or %NULL
+ *   on error
+ */
+GdkTexture *
+gdk_gl_texture_new_from_texture (GdkGLContext  *context,
+                                 GdkTexture    *texture,
+                                 GError       **error)
+{
+  GdkGLContext *upload, *previous;
+  GdkTexture *memory_texture;
+  UploadedTexture *uploaded;
+  GdkGLTexture *self;
+  guint id;
+
+  g_return_val_if_fail (GDK_IS_GL_CONTEXT (context), NULL);
+  g_return_val_if_fail (GDK_IS_TEXTURE (texture), NULL);
+  g_return_val_if_fail (!GDK_IS_GL_TEXTURE (texture), NULL);
+  g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+  if (GDK_IS_MEMORY_TEXTURE (texture))
+    {
+      memory_texture = g_object_ref (texture);
+    }
+  else
+    {
+      GBytes *bytes;
+      guchar *data;
+      gsize stride;
+
+      stride = texture->width * 4;
+      data = g_malloc (stride * texture->height);
+      gdk_texture_download (texture, data, stride);
+      bytes = g_bytes_new_take (data, stride * texture->height);
+      memory_texture = gdk_memory_texture_new (texture->width, texture->height,
+                                               GDK_MEMORY_DEFAULT,
+                                               bytes, stride);
+      g_bytes_unref (bytes);
+    }
+
+  previous = gdk_gl_context_get_current ();
+  if (previous)
+    g_object_ref (previous);
+
+  upload = gdk_gl_context_acquire_upload_context (context, error);
+  if (upload == NULL)
+    {
+      g_clear_object (&previous);
+      g_object_unref (memory_texture);
+      return NULL;
+    }
+
+  glGenTextures (1, &id);
+  glBindTexture (GL_TEXTURE_2D, id);
+  glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+  gdk_gl_context_upload_texture (upload,
+                                 gdk_memory_texture_get_data (GDK_MEMORY_TEXTURE (memory_texture)),
+                                 texture->width, texture->height,
+                                 gdk_memory_texture_get_stride (GDK_MEMORY_TEXTURE (memory_texture)),
+                                 gdk_memory_texture_get_format (GDK_MEMORY_TEXTURE (memory_texture)),
+                                 GL_TEXTURE_2D);
+  glBindTexture (GL_TEXTURE_2D, 0);
+
+  uploaded = g_slice_new (UploadedTexture);
+  uploaded->context = g_object_ref (upload);
+  uploaded->id = id;
+
+  self = (GdkGLTexture *) gdk_gl_texture_new (upload, id,
+                                              texture->width, texture->height,
+                                              uploaded_texture_free, uploaded);
+
+  /* Let the renderer wait on the GPU instead of waiting here */
+  if (gdk_gl_context_has_sync (upload))
+    {
+      self->sync = glFenceSync (GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+      glFlush ();
+    }
+  else
+    {
+      glFinish ();
+    }
+
+  gdk_gl_context_release_upload_context (upload);
+
+  if (previous)
+    {
+      gdk_gl_context_make_current (previous);
+      g_object_unref (previous);
+    }
+
+  g_object_unref (memory_texture);
+
+  return GDK_TEXTURE (self);
+}
@@ -43,6 +43,20 @@ typedef struct _GdkGLTextureClass       GdkGLTextureClass;
 
 G_DEFINE_AUTOPTR_CLEANUP_FUNC(GdkGLTexture, g_object_unref)
 
+/**
+ * GdkGLTextureReleaseFunc:
+ * @texture: the #GdkGLTexture that is being released
+ * @sync: (nullable): a GLsync, owned by the callee, that is signaled
+ *     once GTK's reads from the texture have finished, or %NULL
+ * @data: the data passed to gdk_gl_texture_new_with_sync()
+ *
+ * The type of the function that is called when a texture that was
+ * created with gdk_gl_texture_new_with_sync() releases its GL resources.
+ */
+typedef void (* GdkGLTextureReleaseFunc) (GdkGLTexture *texture,
+                                          gpointer      sync,
+                                          gpointer      data);
+
 GDK_AVAILABLE_IN_ALL
 GType                   gdk_gl_texture_get_type                (void) G_GNUC_CONST;
 
@@ -54,6 +68,19 @@ GdkTexture *            gdk_gl_texture_new                     (GdkGLContext
                                                                 GDestroyNotify   destroy,
                                                                 gpointer         data);
 
+GDK_AVAILABLE_IN_ALL
+GdkTexture *            gdk_gl_texture_new_with_sync           (GdkGLContext    *context,
+                                                                guint            id,
+                                                                int              width,
+                                                                int              height,
+                                                                gpointer         sync,
+                                                                GdkGLTextureReleaseFunc release,
+                                                                gpointer         data);
+GDK_AVAILABLE_IN_ALL
+GdkTexture *            gdk_gl_texture_new_from_texture        (GdkGLContext    *context,
+                                                                GdkTexture      *texture,
+                                                                GError         **error);
+
 GDK_AVAILABLE_IN_ALL
 void                    gdk_gl_texture_release                 (GdkGLTexture    *self);
 
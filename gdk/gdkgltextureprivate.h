@@ -9,6 +9,10 @@ G_BEGIN_DECLS
 
 GdkGLContext *          gdk_gl_texture_get_context      (GdkGLTexture           *self);
 guint                   gdk_gl_texture_get_id           (GdkGLTexture           *self);
+void                    gdk_gl_texture_wait_sync        (GdkGLTexture           *self);
+gboolean                gdk_gl_texture_wants_release_sync (GdkGLTexture         *self);
+void                    gdk_gl_texture_set_release_sync (GdkGLTexture           *self,
+                                                         gpointer                sync);
 
 G_END_DECLS
 
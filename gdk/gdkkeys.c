@@ -195,6 +195,17 @@ gdk_keymap_set_property (GObject      *object,
     }
 }
 
+#define MAX_CACHED_TRANSLATIONS 1024
+
+typedef struct {
+  gint64 key; /* must be first, the hash table uses it as the key */
+  gboolean found;
+  guint keyval;
+  int effective_group;
+  int level;
+  GdkModifierType consumed_modifiers;
+} Translation;
+
 static void
 gdk_keymap_finalize (GObject *object)
 {
@@ -202,6 +213,7 @@ gdk_keymap_finalize (GObject *object)
 
   g_array_free (keymap->cached_keys, TRUE);
   g_hash_table_unref (keymap->cache);
+  g_hash_table_unref (keymap->translations);
 
   G_OBJECT_CLASS (gdk_keymap_parent_class)->finalize (object);
 }
@@ -220,6 +232,7 @@ gdk_keymap_keys_changed (GdkKeymap *keymap)
   g_array_append_val (keymap->cached_keys, key);
 
   g_hash_table_remove_all (keymap->cache);
+  g_hash_table_remove_all (keymap->translations);
 }
 
 static void
@@ -308,6 +321,7 @@ gdk_keymap_init (GdkKeymap *keymap)
   g_array_append_val (keymap->cached_keys, key);
 
   keymap->cache = g_hash_table_new (g_direct_hash, g_direct_equal);
+  keymap->translations = g_hash_table_new_full (g_int64_hash, g_int64_equal, NULL, g_free);
 }
 
 /**
@@ -729,16 +743,54 @@ gdk_keymap_translate_keyboard_state (GdkKeymap       *keymap,
                                      int             *level,
                                      GdkModifierType *consumed_modifiers)
 {
+  Translation *translation;
+  gint64 key;
+
   g_return_val_if_fail (GDK_IS_KEYMAP (keymap), FALSE);
 
-  return GDK_KEYMAP_GET_CLASS (keymap)->translate_keyboard_state (keymap,
-								  hardware_keycode,
-								  state,
-								  group,
-								  keyval,
-								  effective_group,
-								  level,
-								  consumed_modifiers);
+  /* Shortcut matching translates the same key with several modifier
+   * combinations for every key event, so remember the results. */
+  if (hardware_keycode > 0xffff || group < 0 || group > 0xff)
+    return GDK_KEYMAP_GET_CLASS (keymap)->translate_keyboard_state (keymap,
+                                                                    hardware_keycode,
+                                                                    state,
+                                                                    group,
+                                                                    keyval,
+                                                                    effective_group,
+                                                                    level,
+                                                                    consumed_modifiers);
+
+  key = ((gint64) (guint32) state << 32) | (hardware_keycode << 8) | group;
+
+  translation = g_hash_table_lookup (keymap->translations, &key);
+  if (translation == NULL)
+    {
+      if (g_hash_table_size (keymap->translations) >= MAX_CACHED_TRANSLATIONS)
+        g_hash_table_remove_all (keymap->translations);
+
+      translation = g_new0 (Translation, 1);
+      translation->key = key;
+      translation->found = GDK_KEYMAP_GET_CLASS (keymap)->translate_keyboard_state (keymap,
+                                                                                    hardware_keycode,
+                                                                                    state,
+                                                                                    group,
+                                                                                    &translation->keyval,
+                                                                                    &translation->effective_group,
+                                                                                    &translation->level,
+                                                                                    &translation->consumed_modifiers);
+      g_hash_table_insert (keymap->translations, &translation->key, translation);
+    }
+
+  if (keyval)
+    *keyval = translation->keyval;
+  if (effective_group)
+    *effective_group = translation->effective_group;
+  if (level)
+    *level = translation->level;
+  if (consumed_modifiers)
+    *consumed_modifiers = translation->consumed_modifiers;
+
+  return translation->found;
 }
 
 #include "gdkkeynames.c"
@@ -83,6 +83,10 @@ struct _GdkKeymap
    */
   GArray *cached_keys;
   GHashTable *cache;
+
+  /* Results of translate_keyboard_state, keyed by keycode, state
+   * and group. Cleared along with the cache above. */
+  GHashTable *translations;
 };
 
 GType gdk_keymap_get_type (void) G_GNUC_CONST;
@@ -56,6 +56,13 @@ gdk_memory_format_bytes_per_pixel (GdkMemoryFormat format)
     case GDK_MEMORY_B8G8R8:
       return 3;
 
+    case GDK_MEMORY_R16G16B16A16_PREMULTIPLIED:
+    case GDK_MEMORY_R16G16B16A16_FLOAT_PREMULTIPLIED:
+      return 8;
+
+    case GDK_MEMORY_R32G32B32A32_FLOAT_PREMULTIPLIED:
+      return 16;
+
     case GDK_MEMORY_N_FORMATS:
     default:
       g_assert_not_reached ();
@@ -173,6 +180,37 @@ convert_memcpy (guchar       *dest_data,
     memcpy (dest_data + y * dest_stride, src_data + y * src_stride, 4 * width);
 }
 
+/* The 4 byte converters work on whole pixels: they load a pixel into a
+ * guint32, move its bytes into place with shifts and store it in one go.
+ * That is a lot less work than moving the bytes one by one, and the loops
+ * are simple enough for the compiler to vectorize them. BYTE_SHIFT() gives
+ * the shift of the byte at offset i of a pixel loaded that way.
+ */
+#if G_BYTE_ORDER == G_LITTLE_ENDIAN
+#define BYTE_SHIFT(i) (8 * (i))
+#else
+#define BYTE_SHIFT(i) (8 * (3 - (i)))
+#endif
+
+#define GET_BYTE(p,i) (((p) >> BYTE_SHIFT (i)) & 0xFF)
+
+static inline guint32
+load_pixel (const guchar *data)
+{
+  guint32 pixel;
+
+  memcpy (&pixel, data, 4);
+
+  return pixel;
+}
+
+static inline void
+store_pixel (guchar  *data,
+             guint32  pixel)
+{
+  memcpy (data, &pixel, 4);
+}
+
 #define SWIZZLE(A,R,G,B) \
 static void \
 convert_swizzle ## A ## R ## G ## B (guchar       *dest_data, \
@@ -186,12 +224,17 @@ convert_swizzle ## A ## R ## G ## B (guchar       *dest_data, \
 \
   for (y = 0; y < height; y++) \
     { \
+      guchar * restrict dest = dest_data; \
+      const guchar * restrict src = src_data; \
+\
       for (x = 0; x < width; x++) \
         { \
-          dest_data[4 * x + A] = src_data[4 * x + 0]; \
-          dest_data[4 * x + R] = src_data[4 * x + 1]; \
-          dest_data[4 * x + G] = src_data[4 * x + 2]; \
-          dest_data[4 * x + B] = src_data[4 * x + 3]; \
+          guint32 p = load_pixel (src + 4 * x); \
+\
+          store_pixel (dest + 4 * x, (GET_BYTE (p, 0) << BYTE_SHIFT (A)) | \
+                                     (GET_BYTE (p, 1) << BYTE_SHIFT (R)) | \
+                                     (GET_BYTE (p, 2) << BYTE_SHIFT (G)) | \
+                                     (GET_BYTE (p, 3) << BYTE_SHIFT (B))); \
         } \
 \
       dest_data += dest_stride; \
@@ -217,12 +260,15 @@ convert_swizzle_opaque_## A ## R ## G ## B (guchar       *dest_data, \
 \
   for (y = 0; y < height; y++) \
     { \
+      guchar * restrict dest = dest_data; \
+      const guchar * restrict src = src_data; \
+\
       for (x = 0; x < width; x++) \
         { \
-          dest_data[4 * x + A] = 0xFF; \
-          dest_data[4 * x + R] = src_data[3 * x + 0]; \
-          dest_data[4 * x + G] = src_data[3 * x + 1]; \
-          dest_data[4 * x + B] = src_data[3 * x + 2]; \
+          store_pixel (dest + 4 * x, (0xFFu << BYTE_SHIFT (A)) | \
+                                     ((guint32) src[3 * x + 0] << BYTE_SHIFT (R)) | \
+                                     ((guint32) src[3 * x + 1] << BYTE_SHIFT (G)) | \
+                                     ((guint32) src[3 * x + 2] << BYTE_SHIFT (B))); \
         } \
 \
       dest_data += dest_stride; \
@@ -235,7 +281,27 @@ SWIZZLE_OPAQUE(3,0,1,2)
 SWIZZLE_OPAQUE(0,1,2,3)
 SWIZZLE_OPAQUE(0,3,2,1)
 
-#define PREMULTIPLY(d,c,a) G_STMT_START { guint t = c * a + 0x80; d = ((t >> 8) + t) >> 8; } G_STMT_END
+/* Multiplies all 4 bytes of a pixel with a and divides by 255 using
+ * t = c * a + 0x80; c = ((t >> 8) + t) >> 8 for each byte. Two bytes
+ * are done per multiplication, every intermediate result fits into
+ * its 16 bits.
+ */
+static inline guint32
+premultiply_pixel (guint32 p,
+                   guint32 a)
+{
+  guint32 rb, ag;
+
+  rb = (p & 0x00FF00FF) * a + 0x00800080;
+  rb = ((((rb >> 8) & 0x00FF00FF) + rb) >> 8) & 0x00FF00FF;
+
+  ag = ((p >> 8) & 0x00FF00FF) * a + 0x00800080;
+  ag = (((ag >> 8) & 0x00FF00FF) + ag) & 0xFF00FF00;
+
+  return rb | ag;
+}
+
+/* The alpha byte is set to 0xFF before premultiplying, which yields alpha */
 #define SWIZZLE_PREMULTIPLY(A,R,G,B, A2,R2,G2,B2) \
 static void \
 convert_swizzle_premultiply_ ## A ## R ## G ## B ## _ ## A2 ## R2 ## G2 ## B2 \
@@ -250,12 +316,19 @@ convert_swizzle_premultiply_ ## A ## R ## G ## B ## _ ## A2 ## R2 ## G2 ## B2 \
 \
   for (y = 0; y < height; y++) \
     { \
+      guchar * restrict dest = dest_data; \
+      const guchar * restrict src = src_data; \
+\
       for (x = 0; x < width; x++) \
         { \
-          dest_data[4 * x + A] = src_data[4 * x + A2]; \
-          PREMULTIPLY(dest_data[4 * x + R], src_data[4 * x + R2], src_data[4 * x + A2]); \
-          PREMULTIPLY(dest_data[4 * x + G], src_data[4 * x + G2], src_data[4 * x + A2]); \
-          PREMULTIPLY(dest_data[4 * x + B], src_data[4 * x + B2], src_data[4 * x + A2]); \
+          guint32 p = load_pixel (src + 4 * x); \
+\
+          store_pixel (dest + 4 * x, \
+                       premultiply_pixel ((0xFFu << BYTE_SHIFT (A)) | \
+                                          (GET_BYTE (p, R2) << BYTE_SHIFT (R)) | \
+                                          (GET_BYTE (p, G2) << BYTE_SHIFT (G)) | \
+                                          (GET_BYTE (p, B2) << BYTE_SHIFT (B)), \
+                                          GET_BYTE (p, A2))); \
         } \
 \
       dest_data += dest_stride; \
@@ -276,6 +349,97 @@ SWIZZLE_PREMULTIPLY (3,0,1,2, 0,1,2,3)
 SWIZZLE_PREMULTIPLY (3,0,1,2, 3,0,1,2)
 SWIZZLE_PREMULTIPLY (3,0,1,2, 0,3,2,1)
 
+/* The wide formats are premultiplied RGBA with a channel per element,
+ * so converting them to 8 bits per channel is just a swizzle and a
+ * conversion of each channel */
+static inline guchar
+u16_to_u8 (guint16 value)
+{
+  return (value + 128) / 257;
+}
+
+static inline float
+half_to_float (guint16 value)
+{
+  guint32 sign = (guint32) (value & 0x8000) << 16;
+  guint32 exponent = (value >> 10) & 0x1F;
+  guint32 mantissa = value & 0x3FF;
+  guint32 bits;
+  float f;
+
+  if (exponent == 0)
+    {
+      /* zero or subnormal */
+      f = mantissa / (float) (1 << 24);
+      return sign ? -f : f;
+    }
+  else if (exponent == 0x1F)
+    bits = sign | 0x7F800000 | (mantissa << 13);
+  else
+    bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+
+  memcpy (&f, &bits, sizeof (float));
+
+  return f;
+}
+
+static inline guchar
+float_to_u8 (float value)
+{
+  /* also takes care of NaNs */
+  if (!(value > 0.f))
+    return 0;
+  if (value >= 1.f)
+    return 255;
+
+  return value * 255.f + 0.5f;
+}
+
+static inline guchar
+f16_to_u8 (guint16 value)
+{
+  return float_to_u8 (half_to_float (value));
+}
+
+#define CONVERT_WIDE(NAME,TYPE,TO_U8,A,R,G,B) \
+static void \
+convert_ ## NAME ## _ ## A ## R ## G ## B (guchar       *dest_data, \
+                                           gsize         dest_stride, \
+                                           const guchar *src_data, \
+                                           gsize         src_stride, \
+                                           gsize         width, \
+                                           gsize         height) \
+{ \
+  gsize x, y; \
+\
+  for (y = 0; y < height; y++) \
+    { \
+      guchar * restrict dest = dest_data; \
+      const TYPE * restrict src = (const TYPE *) src_data; \
+\
+      for (x = 0; x < width; x++) \
+        { \
+          dest[4 * x + R] = TO_U8 (src[4 * x + 0]); \
+          dest[4 * x + G] = TO_U8 (src[4 * x + 1]); \
+          dest[4 * x + B] = TO_U8 (src[4 * x + 2]); \
+          dest[4 * x + A] = TO_U8 (src[4 * x + 3]); \
+        } \
+\
+      dest_data += dest_stride; \
+      src_data += src_stride; \
+    } \
+}
+
+CONVERT_WIDE (u16, guint16, u16_to_u8, 3,2,1,0)
+CONVERT_WIDE (u16, guint16, u16_to_u8, 0,1,2,3)
+CONVERT_WIDE (u16, guint16, u16_to_u8, 3,0,1,2)
+CONVERT_WIDE (f16, guint16, f16_to_u8, 3,2,1,0)
+CONVERT_WIDE (f16, guint16, f16_to_u8, 0,1,2,3)
+CONVERT_WIDE (f16, guint16, f16_to_u8, 3,0,1,2)
+CONVERT_WIDE (f32, float, float_to_u8, 3,2,1,0)
+CONVERT_WIDE (f32, float, float_to_u8, 0,1,2,3)
+CONVERT_WIDE (f32, float, float_to_u8, 3,0,1,2)
+
 typedef void (* ConversionFunc) (guchar       *dest_data,
                                  gsize         dest_stride,
                                  const guchar *src_data,
@@ -293,9 +457,76 @@ static ConversionFunc converters[GDK_MEMORY_N_FORMATS][3] =
   { convert_swizzle_premultiply_3210_3012, convert_swizzle_premultiply_0123_3012, convert_swizzle_premultiply_3012_3012 },
   { convert_swizzle_premultiply_3210_0321, convert_swizzle_premultiply_0123_0321, convert_swizzle_premultiply_3012_0321 },
   { convert_swizzle_opaque_3210, convert_swizzle_opaque_0123, convert_swizzle_opaque_3012 },
-  { convert_swizzle_opaque_3012, convert_swizzle_opaque_0321, convert_swizzle_opaque_3210 }
+  { convert_swizzle_opaque_3012, convert_swizzle_opaque_0321, convert_swizzle_opaque_3210 },
+  { convert_u16_3210, convert_u16_0123, convert_u16_3012 },
+  { convert_f16_3210, convert_f16_0123, convert_f16_3012 },
+  { convert_f32_3210, convert_f32_0123, convert_f32_3012 }
 };
 
+/* Big conversions are split into chunks of rows that are converted on
+ * a thread pool shared by all callers. Each call waits for its own
+ * chunks, so the interface stays synchronous.
+ */
+#define MIN_THREADED_PIXELS (512 * 512)
+#define MIN_ROWS_PER_CHUNK 16
+
+typedef struct
+{
+  GMutex lock;
+  GCond cond;
+  guint n_pending;
+} ConvertJob;
+
+typedef struct
+{
+  ConvertJob *job;
+  ConversionFunc func;
+  guchar *dest_data;
+  gsize dest_stride;
+  const guchar *src_data;
+  gsize src_stride;
+  gsize width;
+  gsize height;
+} ConvertChunk;
+
+static void
+convert_chunk (gpointer data,
+               gpointer user_data)
+{
+  ConvertChunk *chunk = data;
+  ConvertJob *job = chunk->job;
+
+  chunk->func (chunk->dest_data, chunk->dest_stride,
+               chunk->src_data, chunk->src_stride,
+               chunk->width, chunk->height);
+
+  g_mutex_lock (&job->lock);
+  job->n_pending--;
+  if (job->n_pending == 0)
+    g_cond_signal (&job->cond);
+  g_mutex_unlock (&job->lock);
+}
+
+/* Returns %NULL if we only have one processor */
+static GThreadPool *
+get_convert_pool (void)
+{
+  static GThreadPool *pool = NULL;
+  static gsize initialized = 0;
+
+  if (g_once_init_enter (&initialized))
+    {
+      guint n_processors = g_get_num_processors ();
+
+      if (n_processors > 1)
+        pool = g_thread_pool_new (convert_chunk, NULL, n_processors, FALSE, NULL);
+
+      g_once_init_leave (&initialized, 1);
+    }
+
+  return pool;
+}
+
 void
 gdk_memory_convert (guchar          *dest_data,
                     gsize            dest_stride,
@@ -306,8 +537,69 @@ gdk_memory_convert (guchar          *dest_data,
                     gsize            width,
                     gsize            height)
 {
-  g_assert (dest_format < 3);
+  ConversionFunc func;
+  GThreadPool *pool;
+  ConvertChunk *chunks;
+  ConvertJob job;
+  gsize rows_per_chunk, y;
+  guint i, n_chunks;
+
+  g_assert (dest_format < 3 || dest_format == src_format);
   g_assert (src_format < GDK_MEMORY_N_FORMATS);
 
-  converters[src_format][dest_format] (dest_data, dest_stride, src_data, src_stride, width, height);
+  if (dest_format == src_format)
+    {
+      gsize bpp = gdk_memory_format_bytes_per_pixel (src_format);
+
+      for (y = 0; y < height; y++)
+        memcpy (dest_data + y * dest_stride, src_data + y * src_stride, bpp * width);
+      return;
+    }
+
+  func = converters[src_format][dest_format];
+
+  if (width * height < MIN_THREADED_PIXELS ||
+      (pool = get_convert_pool ()) == NULL)
+    {
+      func (dest_data, dest_stride, src_data, src_stride, width, height);
+      return;
+    }
+
+  n_chunks = MIN (g_get_num_processors (), (height + MIN_ROWS_PER_CHUNK - 1) / MIN_ROWS_PER_CHUNK);
+  rows_per_chunk = (height + n_chunks - 1) / n_chunks;
+  n_chunks = (height + rows_per_chunk - 1) / rows_per_chunk;
+
+  chunks = g_newa (ConvertChunk, n_chunks);
+
+  g_mutex_init (&job.lock);
+  g_cond_init (&job.cond);
+  job.n_pending = n_chunks;
+
+  for (i = 0, y = 0; i < n_chunks; i++, y += rows_per_chunk)
+    {
+      chunks[i] = (ConvertChunk) {
+        .job = &job,
+        .func = func,
+        .dest_data = dest_data + y * dest_stride,
+        .dest_stride = dest_stride,
+        .src_data = src_data + y * src_stride,
+        .src_stride = src_stride,
+        .width = width,
+        .height = MIN (rows_per_chunk, height - y),
+      };
+    }
+
+  /* Convert the first chunk ourselves instead of idling */
+  for (i = 1; i < n_chunks; i++)
+    g_thread_pool_push (pool, &chunks[i], NULL);
+
+  convert_chunk (&chunks[0], NULL);
+
+  g_mutex_lock (&job.lock);
+  while (job.n_pending > 0)
+    g_cond_wait (&job.cond, &job.lock);
+  g_mutex_unlock (&job.lock);
+
+  g_mutex_clear (&job.lock);
+  g_cond_clear (&job.cond);
 }
@@ -551,6 +551,29 @@ gdk_monitor_set_subpixel_layout (GdkMonitor        *monitor,
   g_object_notify (G_OBJECT (monitor), "subpixel-layout");
 }
 
+/* Whether the monitor shows frames as soon as they are done, up to
+ * its refresh rate. There is no property for this, but it notifies
+ * ::refresh-rate, since the refresh behavior changes. */
+void
+gdk_monitor_set_variable_refresh (GdkMonitor *monitor,
+                                  gboolean    variable_refresh)
+{
+  variable_refresh = !!variable_refresh;
+
+  if (monitor->variable_refresh == variable_refresh)
+    return;
+
+  monitor->variable_refresh = variable_refresh;
+
+  g_object_notify (G_OBJECT (monitor), "refresh-rate");
+}
+
+gboolean
+gdk_monitor_get_variable_refresh (GdkMonitor *monitor)
+{
+  return monitor->variable_refresh;
+}
+
 void
 gdk_monitor_invalidate (GdkMonitor *monitor)
 {
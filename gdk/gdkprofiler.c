@@ -23,6 +23,7 @@
 #include "gdkprofilerprivate.h"
 
 #include <sys/types.h>
+#include <errno.h>
 #include <signal.h>
 
 #ifdef HAVE_UNISTD_H
@@ -32,12 +33,274 @@
 #include "gdkversionmacros.h"
 #include "gdkframeclockprivate.h"
 
+#ifdef HAVE_SYSPROF
+#include <glib-unix.h>
+#endif
+
+#ifdef HAVE_SYSPROF
+
+/* The history keeps the marks and counter values of the last seconds
+ * in memory, so they can be written to a capture file after the fact
+ * even if sysprof wasn't running. It is enabled by setting
+ * GDK_PROFILER_HISTORY to the number of seconds to keep, and dumped
+ * with SIGUSR2 or gdk_profiler_dump_history(). */
+
+#define HISTORY_SIZE 16384
+#define HISTORY_NAME_LEN 32
+#define HISTORY_MESSAGE_LEN 88
+
+/* Counter ids we hand out when no collector is active */
+#define HISTORY_COUNTER_BASE 0x10000
+
+typedef enum {
+  HISTORY_MARK,
+  HISTORY_COUNTER,
+} HistoryEventType;
+
+typedef struct {
+  gint64 time;
+  HistoryEventType type;
+  union {
+    struct {
+      gint64 duration;
+      char name[HISTORY_NAME_LEN];
+      char message[HISTORY_MESSAGE_LEN];
+    } mark;
+    struct {
+      guint id;
+      SysprofCaptureCounterValue value;
+    } counter;
+  } u;
+} HistoryEvent;
+
+static struct {
+  GMutex lock;
+  gint64 max_age; /* nsec, 0 if disabled */
+  HistoryEvent *events;
+  guint first;
+  guint n_events;
+  GArray *counters; /* SysprofCaptureCounter */
+} history;
+
+static gboolean gdk_profiler_dump_history_cb (gpointer data);
+
+static gboolean
+gdk_profiler_history_enabled (void)
+{
+  static gsize initialized = 0;
+
+  if (g_once_init_enter (&initialized))
+    {
+      const char *env = g_getenv ("GDK_PROFILER_HISTORY");
+      guint64 seconds = 0;
+
+      if (env && !g_ascii_string_to_unsigned (env, 10, 1, G_MAXINT, &seconds, NULL))
+        g_warning ("Failed to parse GDK_PROFILER_HISTORY, expected a number of seconds");
+
+      if (seconds > 0)
+        {
+          history.max_age = seconds * G_TIME_SPAN_SECOND * 1000;
+          history.events = g_new (HistoryEvent, HISTORY_SIZE);
+          history.counters = g_array_new (FALSE, FALSE, sizeof (SysprofCaptureCounter));
+          g_unix_signal_add (SIGUSR2, gdk_profiler_dump_history_cb, NULL);
+        }
+
+      g_once_init_leave (&initialized, 1);
+    }
+
+  return history.max_age > 0;
+}
+
+/* Must be called with the lock held */
+static HistoryEvent *
+gdk_profiler_history_append (HistoryEventType type,
+                             gint64           time)
+{
+  HistoryEvent *event;
+
+  if (history.n_events == HISTORY_SIZE)
+    {
+      history.first = (history.first + 1) % HISTORY_SIZE;
+      history.n_events--;
+    }
+
+  event = &history.events[(history.first + history.n_events) % HISTORY_SIZE];
+  history.n_events++;
+
+  event->type = type;
+  event->time = time;
+
+  return event;
+}
+
+static void
+gdk_profiler_history_add_mark (gint64      begin_time,
+                               gint64      duration,
+                               const char *name,
+                               const char *message)
+{
+  HistoryEvent *event;
+
+  if (!gdk_profiler_history_enabled ())
+    return;
+
+  g_mutex_lock (&history.lock);
+  event = gdk_profiler_history_append (HISTORY_MARK, begin_time);
+  event->u.mark.duration = duration;
+  g_strlcpy (event->u.mark.name, name, HISTORY_NAME_LEN);
+  g_strlcpy (event->u.mark.message, message ? message : "", HISTORY_MESSAGE_LEN);
+  g_mutex_unlock (&history.lock);
+}
+
+static void
+gdk_profiler_history_set_counter (guint                      id,
+                                  SysprofCaptureCounterValue value)
+{
+  HistoryEvent *event;
+
+  if (!gdk_profiler_history_enabled ())
+    return;
+
+  g_mutex_lock (&history.lock);
+  event = gdk_profiler_history_append (HISTORY_COUNTER, SYSPROF_CAPTURE_CURRENT_TIME);
+  event->u.counter.id = id;
+  event->u.counter.value = value;
+  g_mutex_unlock (&history.lock);
+}
+
+static void
+gdk_profiler_history_define_counter (SysprofCaptureCounter *counter)
+{
+  if (!gdk_profiler_history_enabled ())
+    return;
+
+  g_mutex_lock (&history.lock);
+  if (counter->id == 0)
+    counter->id = HISTORY_COUNTER_BASE + history.counters->len;
+  g_array_append_val (history.counters, *counter);
+  g_mutex_unlock (&history.lock);
+}
+
+/*< private >
+ * gdk_profiler_dump_history:
+ * @filename: the file to write
+ * @error: return location for an error
+ *
+ * Writes the events that the profiler history has collected to
+ * @filename, in the sysprof capture format.
+ *
+ * Returns: %TRUE if the file was written
+ */
+gboolean
+gdk_profiler_dump_history (const char  *filename,
+                           GError     **error)
+{
+  SysprofCaptureWriter *writer;
+  gint64 now, start;
+  int pid;
+  guint i;
+
+  if (!gdk_profiler_history_enabled ())
+    {
+      g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
+                           "GDK_PROFILER_HISTORY is not set");
+      return FALSE;
+    }
+
+  writer = sysprof_capture_writer_new (filename, 0);
+  if (writer == NULL)
+    {
+      int errsv = errno;
+
+      g_set_error (error, G_IO_ERROR, g_io_error_from_errno (errsv),
+                   "Could not create %s: %s", filename, g_strerror (errsv));
+      return FALSE;
+    }
+
+  pid = getpid ();
+  now = SYSPROF_CAPTURE_CURRENT_TIME;
+  start = now - history.max_age;
+
+  g_mutex_lock (&history.lock);
+
+  if (history.counters->len > 0)
+    sysprof_capture_writer_define_counters (writer, start, -1, pid,
+                                            (SysprofCaptureCounter *) history.counters->data,
+                                            history.counters->len);
+
+  for (i = 0; i < history.n_events; i++)
+    {
+      HistoryEvent *event = &history.events[(history.first + i) % HISTORY_SIZE];
+
+      if (event->time < start)
+        continue;
+
+      switch (event->type)
+        {
+        case HISTORY_MARK:
+          sysprof_capture_writer_add_mark (writer, event->time, -1, pid,
+                                           event->u.mark.duration,
+                                           "gtk", event->u.mark.name, event->u.mark.message);
+          break;
+
+        case HISTORY_COUNTER:
+          sysprof_capture_writer_set_counters (writer, event->time, -1, pid,
+                                               &event->u.counter.id, &event->u.counter.value, 1);
+          break;
+
+        default:
+          g_assert_not_reached ();
+        }
+    }
+
+  g_mutex_unlock (&history.lock);
+
+  sysprof_capture_writer_flush (writer);
+  sysprof_capture_writer_unref (writer);
+
+  return TRUE;
+}
+
+static gboolean
+gdk_profiler_dump_history_cb (gpointer data)
+{
+  GError *error = NULL;
+  char *filename;
+
+  filename = g_strdup_printf ("%s/gtk-%d-%" G_GINT64_FORMAT ".syscap",
+                              g_get_tmp_dir (), getpid (), g_get_real_time () / G_TIME_SPAN_SECOND);
+
+  if (gdk_profiler_dump_history (filename, &error))
+    g_message ("Profiler history written to %s", filename);
+  else
+    {
+      g_warning ("Failed to write profiler history: %s", error->message);
+      g_error_free (error);
+    }
+
+  g_free (filename);
+
+  return G_SOURCE_CONTINUE;
+}
+
+#else /* !HAVE_SYSPROF */
+
+gboolean
+gdk_profiler_dump_history (const char  *filename,
+                           GError     **error)
+{
+  g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
+                       "GTK was built without sysprof support");
+  return FALSE;
+}
+
+#endif /* HAVE_SYSPROF */
 
 gboolean
 gdk_profiler_is_running (void)
 {
 #ifdef HAVE_SYSPROF
-  return sysprof_collector_is_active ();
+  return sysprof_collector_is_active () || gdk_profiler_history_enabled ();
 #else
   return FALSE;
 #endif
@@ -51,6 +314,7 @@ void
 {
 #ifdef HAVE_SYSPROF
   sysprof_collector_mark (begin_time, duration, "gtk", name, message);
+  gdk_profiler_history_add_mark (begin_time, duration, name, message);
 #endif
 }
 
@@ -61,6 +325,7 @@ void
 {
 #ifdef HAVE_SYSPROF
   sysprof_collector_mark (begin_time, GDK_PROFILER_CURRENT_TIME - begin_time, "gtk", name, message);
+  gdk_profiler_history_add_mark (begin_time, GDK_PROFILER_CURRENT_TIME - begin_time, name, message);
 #endif
 }
 
@@ -73,6 +338,19 @@ void
 {
 #ifdef HAVE_SYSPROF
   va_list args;
+
+  if (gdk_profiler_history_enabled ())
+    {
+      char *message;
+
+      va_start (args, message_format);
+      message = g_strdup_vprintf (message_format, args);
+      va_end (args);
+      gdk_profiler_add_mark (begin_time, duration, name, message);
+      g_free (message);
+      return;
+    }
+
   va_start (args, message_format);
   sysprof_collector_mark_vprintf (begin_time, duration, "gtk", name, message_format, args);
   va_end (args);
@@ -87,6 +365,19 @@ void
 {
 #ifdef HAVE_SYSPROF
   va_list args;
+
+  if (gdk_profiler_history_enabled ())
+    {
+      char *message;
+
+      va_start (args, message_format);
+      message = g_strdup_vprintf (message_format, args);
+      va_end (args);
+      gdk_profiler_end_mark (begin_time, name, message);
+      g_free (message);
+      return;
+    }
+
   va_start (args, message_format);
   sysprof_collector_mark_vprintf (begin_time, GDK_PROFILER_CURRENT_TIME - begin_time, "gtk", name, message_format, args);
   va_end (args);
@@ -107,6 +398,7 @@ guint
   g_strlcpy (counter.name, name, sizeof counter.name);
   g_strlcpy (counter.description, description, sizeof counter.name);
 
+  gdk_profiler_history_define_counter (&counter);
   sysprof_collector_define_counters (&counter, 1);
 
   return counter.id;
@@ -129,6 +421,7 @@ guint
   g_strlcpy (counter.name, name, sizeof counter.name);
   g_strlcpy (counter.description, description, sizeof counter.name);
 
+  gdk_profiler_history_define_counter (&counter);
   sysprof_collector_define_counters (&counter, 1);
 
   return counter.id;
@@ -146,6 +439,7 @@ void
 
   value.vdbl = val;
   sysprof_collector_set_counters (&id, &value, 1);
+  gdk_profiler_history_set_counter (id, value);
 #endif
 }
 
@@ -158,5 +452,6 @@ void
 
   value.v64 = val;
   sysprof_collector_set_counters (&id, &value, 1);
+  gdk_profiler_history_set_counter (id, value);
 #endif
 }
@@ -42,6 +42,9 @@ G_BEGIN_DECLS
 
 gboolean gdk_profiler_is_running (void);
 
+gboolean gdk_profiler_dump_history (const char  *filename,
+                                    GError     **error);
+
 /* Note: Times and durations are in nanoseconds;
  * g_get_monotonic_time(), and GdkFrameClock times
  * are in microseconds, so multiply by 1000.
@@ -0,0 +1,117 @@
+/* GDK - The GIMP Drawing Kit
+ * Copyright (C) 2021 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include "gdksubsurfaceprivate.h"
+
+G_DEFINE_ABSTRACT_TYPE (GdkSubsurface, gdk_subsurface, G_TYPE_OBJECT)
+
+static void
+gdk_subsurface_finalize (GObject *object)
+{
+  GdkSubsurface *subsurface = GDK_SUBSURFACE (object);
+
+  g_clear_object (&subsurface->texture);
+
+  G_OBJECT_CLASS (gdk_subsurface_parent_class)->finalize (object);
+}
+
+static void
+gdk_subsurface_class_init (GdkSubsurfaceClass *class)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (class);
+
+  object_class->finalize = gdk_subsurface_finalize;
+}
+
+static void
+gdk_subsurface_init (GdkSubsurface *subsurface)
+{
+}
+
+GdkSurface *
+gdk_subsurface_get_parent (GdkSubsurface *subsurface)
+{
+  g_return_val_if_fail (GDK_IS_SUBSURFACE (subsurface), NULL);
+
+  return subsurface->parent;
+}
+
+/*< private >
+ * gdk_subsurface_attach:
+ * @subsurface: a #GdkSubsurface
+ * @texture: the texture to show
+ * @rect: the area of the parent surface to show it in, in
+ *     application pixels
+ *
+ * Shows @texture above the parent surface. The change takes effect
+ * with the next frame of the parent, or right away if only the
+ * texture changed.
+ *
+ * Returns: %TRUE if @texture is shown. Otherwise, the subsurface
+ *     is detached and the texture has to be drawn normally.
+ */
+gboolean
+gdk_subsurface_attach (GdkSubsurface         *subsurface,
+                       GdkTexture            *texture,
+                       const graphene_rect_t *rect)
+{
+  g_return_val_if_fail (GDK_IS_SUBSURFACE (subsurface), FALSE);
+  g_return_val_if_fail (GDK_IS_TEXTURE (texture), FALSE);
+  g_return_val_if_fail (rect != NULL, FALSE);
+
+  if (GDK_SUBSURFACE_GET_CLASS (subsurface)->attach (subsurface, texture, rect))
+    {
+      g_set_object (&subsurface->texture, texture);
+      subsurface->rect = *rect;
+      return TRUE;
+    }
+
+  gdk_subsurface_detach (subsurface);
+  return FALSE;
+}
+
+void
+gdk_subsurface_detach (GdkSubsurface *subsurface)
+{
+  g_return_if_fail (GDK_IS_SUBSURFACE (subsurface));
+
+  if (subsurface->texture == NULL)
+    return;
+
+  GDK_SUBSURFACE_GET_CLASS (subsurface)->detach (subsurface);
+
+  g_clear_object (&subsurface->texture);
+}
+
+GdkTexture *
+gdk_subsurface_get_texture (GdkSubsurface *subsurface)
+{
+  g_return_val_if_fail (GDK_IS_SUBSURFACE (subsurface), NULL);
+
+  return subsurface->texture;
+}
+
+void
+gdk_subsurface_get_rect (GdkSubsurface   *subsurface,
+                         graphene_rect_t *rect)
+{
+  g_return_if_fail (GDK_IS_SUBSURFACE (subsurface));
+
+  *rect = subsurface->rect;
+}
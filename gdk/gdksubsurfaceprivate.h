@@ -0,0 +1,76 @@
+/* GDK - The GIMP Drawing Kit
+ * Copyright (C) 2021 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GDK_SUBSURFACE_PRIVATE_H__
+#define __GDK_SUBSURFACE_PRIVATE_H__
+
+#include "gdksurface.h"
+#include "gdktexture.h"
+
+#include <graphene.h>
+
+G_BEGIN_DECLS
+
+/* A GdkSubsurface shows a texture on top of its parent surface,
+ * without the texture being drawn into the parent's buffer. This
+ * lets the compositor scan out video frames directly. */
+
+#define GDK_TYPE_SUBSURFACE              (gdk_subsurface_get_type ())
+#define GDK_SUBSURFACE(obj)              (G_TYPE_CHECK_INSTANCE_CAST ((obj), GDK_TYPE_SUBSURFACE, GdkSubsurface))
+#define GDK_SUBSURFACE_CLASS(klass)      (G_TYPE_CHECK_CLASS_CAST ((klass), GDK_TYPE_SUBSURFACE, GdkSubsurfaceClass))
+#define GDK_IS_SUBSURFACE(obj)           (G_TYPE_CHECK_INSTANCE_TYPE ((obj), GDK_TYPE_SUBSURFACE))
+#define GDK_SUBSURFACE_GET_CLASS(obj)    (G_TYPE_INSTANCE_GET_CLASS ((obj), GDK_TYPE_SUBSURFACE, GdkSubsurfaceClass))
+
+typedef struct _GdkSubsurface GdkSubsurface;
+typedef struct _GdkSubsurfaceClass GdkSubsurfaceClass;
+
+struct _GdkSubsurface
+{
+  GObject parent_instance;
+
+  GdkSurface *parent;
+
+  GdkTexture *texture;
+  graphene_rect_t rect;
+};
+
+struct _GdkSubsurfaceClass
+{
+  GObjectClass parent_class;
+
+  /* Returns FALSE if the texture can't be shown this way,
+   * in which case the subsurface must be detached */
+  gboolean     (* attach)                   (GdkSubsurface         *subsurface,
+                                             GdkTexture            *texture,
+                                             const graphene_rect_t *rect);
+  void         (* detach)                   (GdkSubsurface         *subsurface);
+};
+
+GType                   gdk_subsurface_get_type                 (void) G_GNUC_CONST;
+
+GdkSurface *            gdk_subsurface_get_parent               (GdkSubsurface          *subsurface);
+gboolean                gdk_subsurface_attach                   (GdkSubsurface          *subsurface,
+                                                                 GdkTexture             *texture,
+                                                                 const graphene_rect_t  *rect);
+void                    gdk_subsurface_detach                   (GdkSubsurface          *subsurface);
+GdkTexture *            gdk_subsurface_get_texture              (GdkSubsurface          *subsurface);
+void                    gdk_subsurface_get_rect                 (GdkSubsurface          *subsurface,
+                                                                 graphene_rect_t        *rect);
+
+G_END_DECLS
+
+#endif /* __GDK_SUBSURFACE_PRIVATE_H__ */
@@ -39,6 +39,7 @@
 #include "gdkinternals.h"
 #include "gdkintl.h"
 #include "gdkmarshalers.h"
+#include "gdkmonitorprivate.h"
 #include "gdkpopupprivate.h"
 #include "gdkrectangle.h"
 #include "gdktoplevelprivate.h"
@@ -113,6 +114,8 @@ static void update_cursor               (GdkDisplay *display,
 
 static void gdk_surface_set_frame_clock (GdkSurface      *surface,
                                          GdkFrameClock  *clock);
+static void gdk_surface_update_refresh_rate (GdkSurface *surface);
+static void gdk_surface_clear_monitors      (GdkSurface *surface);
 
 static void gdk_surface_queue_set_is_mapped (GdkSurface *surface,
                                              gboolean    is_mapped);
@@ -704,6 +707,8 @@ gdk_surface_finalize (GObject *object)
   if (surface->devices_inside)
     g_list_free (surface->devices_inside);
 
+  gdk_surface_clear_monitors (surface);
+
   g_clear_object (&surface->display);
 
   if (surface->opaque_region)
@@ -909,6 +914,9 @@ _gdk_surface_destroy_hierarchy (GdkSurface *surface,
   if (GDK_SURFACE_DESTROYED (surface))
     return;
 
+  /* Subsurfaces go first, they are children of the windowing system surface */
+  g_clear_pointer (&surface->subsurfaces, g_ptr_array_unref);
+
   GDK_SURFACE_GET_CLASS (surface)->destroy (surface, foreign_destroy);
 
   if (surface->gl_paint_context)
@@ -1121,6 +1129,8 @@ gdk_surface_get_paint_gl_context (GdkSurface  *surface,
       return NULL;
     }
 
+  gdk_gl_context_ensure_upload_pool (surface->gl_paint_context);
+
   return surface->gl_paint_context;
 }
 
@@ -1160,6 +1170,66 @@ gdk_surface_create_gl_context (GdkSurface   *surface,
                                                              error);
 }
 
+/*< private >
+ * gdk_surface_create_subsurface:
+ * @surface: a #GdkSurface
+ *
+ * Creates a new subsurface that can show a texture above @surface.
+ * Subsurfaces are stacked in the order they are created, and stay
+ * owned by @surface.
+ *
+ * Returns: (transfer none) (nullable): the new subsurface, or %NULL
+ *     if the backend doesn't support them
+ */
+GdkSubsurface *
+gdk_surface_create_subsurface (GdkSurface *surface)
+{
+  GdkSurfaceClass *class;
+  GdkSubsurface *subsurface;
+
+  g_return_val_if_fail (GDK_IS_SURFACE (surface), NULL);
+
+  if (GDK_SURFACE_DESTROYED (surface))
+    return NULL;
+
+  class = GDK_SURFACE_GET_CLASS (surface);
+  if (class->create_subsurface == NULL)
+    return NULL;
+
+  subsurface = class->create_subsurface (surface);
+  if (subsurface == NULL)
+    return NULL;
+
+  subsurface->parent = surface;
+
+  if (surface->subsurfaces == NULL)
+    surface->subsurfaces = g_ptr_array_new_with_free_func (g_object_unref);
+  g_ptr_array_add (surface->subsurfaces, subsurface);
+
+  return subsurface;
+}
+
+guint
+gdk_surface_get_n_subsurfaces (GdkSurface *surface)
+{
+  g_return_val_if_fail (GDK_IS_SURFACE (surface), 0);
+
+  if (surface->subsurfaces == NULL)
+    return 0;
+
+  return surface->subsurfaces->len;
+}
+
+GdkSubsurface *
+gdk_surface_get_subsurface (GdkSurface *surface,
+                            guint       idx)
+{
+  g_return_val_if_fail (GDK_IS_SURFACE (surface), NULL);
+  g_return_val_if_fail (idx < gdk_surface_get_n_subsurfaces (surface), NULL);
+
+  return g_ptr_array_index (surface->subsurfaces, idx);
+}
+
 /**
  * gdk_surface_create_cairo_context:
  * @surface: a #GdkSurface
@@ -2511,6 +2581,8 @@ gdk_surface_set_frame_clock (GdkSurface     *surface,
     }
 
   surface->frame_clock = clock;
+
+  gdk_surface_update_refresh_rate (surface);
 }
 
 /**
@@ -3017,10 +3089,66 @@ gdk_surface_get_seat_from_event (GdkSurface *surface,
   return gdk_display_get_default_seat (surface->display);
 }
 
+/* Let the frame clock know about the refresh rate of the monitors we
+ * are on. We go with the fastest one, and only use variable refresh
+ * if all of them support it.
+ */
+static void
+gdk_surface_update_refresh_rate (GdkSurface *surface)
+{
+  int refresh_rate = 0;
+  gboolean variable_refresh = surface->monitors != NULL;
+  GList *l;
+
+  if (surface->parent != NULL ||
+      !GDK_IS_FRAME_CLOCK_IDLE (surface->frame_clock))
+    return;
+
+  for (l = surface->monitors; l; l = l->next)
+    {
+      GdkMonitor *monitor = l->data;
+
+      refresh_rate = MAX (refresh_rate, gdk_monitor_get_refresh_rate (monitor));
+      variable_refresh &= gdk_monitor_get_variable_refresh (monitor);
+    }
+
+  _gdk_frame_clock_idle_set_refresh_rate (GDK_FRAME_CLOCK_IDLE (surface->frame_clock),
+                                          refresh_rate,
+                                          variable_refresh);
+}
+
+static void
+monitor_refresh_rate_changed (GdkMonitor *monitor,
+                              GParamSpec *pspec,
+                              GdkSurface *surface)
+{
+  gdk_surface_update_refresh_rate (surface);
+}
+
+static void
+gdk_surface_clear_monitors (GdkSurface *surface)
+{
+  GList *l;
+
+  for (l = surface->monitors; l; l = l->next)
+    g_signal_handlers_disconnect_by_func (l->data, monitor_refresh_rate_changed, surface);
+
+  g_list_free_full (surface->monitors, g_object_unref);
+  surface->monitors = NULL;
+}
+
 void
 gdk_surface_enter_monitor (GdkSurface *surface,
                            GdkMonitor *monitor)
 {
+  if (!g_list_find (surface->monitors, monitor))
+    {
+      surface->monitors = g_list_prepend (surface->monitors, g_object_ref (monitor));
+      g_signal_connect (monitor, "notify::refresh-rate",
+                        G_CALLBACK (monitor_refresh_rate_changed), surface);
+      gdk_surface_update_refresh_rate (surface);
+    }
+
   g_signal_emit (surface, signals[ENTER_MONITOR], 0, monitor);
 }
 
@@ -3028,5 +3156,15 @@ void
 gdk_surface_leave_monitor (GdkSurface *surface,
                            GdkMonitor *monitor)
 {
+  GList *link = g_list_find (surface->monitors, monitor);
+
+  if (link)
+    {
+      g_signal_handlers_disconnect_by_func (monitor, monitor_refresh_rate_changed, surface);
+      surface->monitors = g_list_delete_link (surface->monitors, link);
+      gdk_surface_update_refresh_rate (surface);
+      g_object_unref (monitor);
+    }
+
   g_signal_emit (surface, signals[LEAVE_MONITOR], 0, monitor);
 }
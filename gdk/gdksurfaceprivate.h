@@ -22,6 +22,7 @@
 
 #include <gdk-pixbuf/gdk-pixbuf.h>
 #include "gdkenumtypes.h"
+#include "gdksubsurfaceprivate.h"
 #include "gdksurface.h"
 #include "gdktoplevel.h"
 
@@ -99,6 +100,7 @@ struct _GdkSurface
   GList *devices_inside;
 
   GdkFrameClock *frame_clock; /* NULL to use from parent or default */
+  GList *monitors;            /* the ones we entered, for the refresh rate */
 
   GSList *draw_contexts;
   GdkDrawContext *paint_context;
@@ -106,6 +108,8 @@ struct _GdkSurface
   cairo_region_t *opaque_region;
 
   GdkSeat *current_shortcuts_inhibited_seat;
+
+  GPtrArray *subsurfaces;
 };
 
 struct _GdkSurfaceClass
@@ -169,6 +173,10 @@ struct _GdkSurfaceClass
                                            GError        **error);
   void         (* request_layout)         (GdkSurface     *surface);
   gboolean     (* compute_size)           (GdkSurface     *surface);
+
+  /* optional, for offloading textures to the compositor */
+  GdkSubsurface *
+               (* create_subsurface)      (GdkSurface     *surface);
 };
 
 #define GDK_SURFACE_DESTROYED(d) (((GdkSurface *)(d))->destroyed)
@@ -347,6 +355,11 @@ void       gdk_surface_request_compute_size (GdkSurface      *surface);
 GDK_AVAILABLE_IN_ALL
 void           gdk_surface_request_motion (GdkSurface *surface);
 
+GdkSubsurface * gdk_surface_create_subsurface   (GdkSurface *surface);
+guint           gdk_surface_get_n_subsurfaces   (GdkSurface *surface);
+GdkSubsurface * gdk_surface_get_subsurface      (GdkSurface *surface,
+                                                 guint       idx);
+
 
 G_END_DECLS
 
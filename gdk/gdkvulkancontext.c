@@ -431,6 +431,54 @@ device_supports_incremental_present (VkPhysicalDevice device)
   return FALSE;
 }
 
+/* Importing dma-bufs needs these, and the extensions they depend on,
+ * because we only ask for Vulkan 1.0 */
+static const char *dmabuf_device_extensions[] = {
+  VK_KHR_EXTERNAL_MEMORY_EXTENSION_NAME,
+  VK_KHR_EXTERNAL_MEMORY_FD_EXTENSION_NAME,
+  VK_KHR_DEDICATED_ALLOCATION_EXTENSION_NAME,
+  VK_EXT_EXTERNAL_MEMORY_DMA_BUF_EXTENSION_NAME,
+  VK_EXT_IMAGE_DRM_FORMAT_MODIFIER_EXTENSION_NAME,
+  VK_KHR_IMAGE_FORMAT_LIST_EXTENSION_NAME,
+  VK_KHR_BIND_MEMORY_2_EXTENSION_NAME,
+  VK_KHR_GET_MEMORY_REQUIREMENTS_2_EXTENSION_NAME,
+  VK_KHR_SAMPLER_YCBCR_CONVERSION_EXTENSION_NAME,
+  VK_KHR_MAINTENANCE1_EXTENSION_NAME,
+};
+
+static gboolean
+device_supports_dmabuf_import (GdkDisplay       *display,
+                               VkPhysicalDevice  device)
+{
+  VkExtensionProperties *extensions;
+  uint32_t n_device_extensions;
+  guint i;
+
+  if (!display->vk_has_external_memory_capabilities)
+    return FALSE;
+
+  vkEnumerateDeviceExtensionProperties (device, NULL, &n_device_extensions, NULL);
+
+  extensions = g_newa (VkExtensionProperties, n_device_extensions);
+  vkEnumerateDeviceExtensionProperties (device, NULL, &n_device_extensions, extensions);
+
+  for (i = 0; i < G_N_ELEMENTS (dmabuf_device_extensions); i++)
+    {
+      uint32_t j;
+
+      for (j = 0; j < n_device_extensions; j++)
+        {
+          if (g_str_equal (extensions[j].extensionName, dmabuf_device_extensions[i]))
+            break;
+        }
+
+      if (j == n_device_extensions)
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
 static void
 gdk_vulkan_context_begin_frame (GdkDrawContext *draw_context,
                                 cairo_region_t *region)
@@ -727,6 +775,16 @@ gdk_vulkan_context_get_queue_family_index (GdkVulkanContext *context)
   return gdk_draw_context_get_display (GDK_DRAW_CONTEXT (context))->vk_queue_family_index;
 }
 
+/* Whether the device can import dma-bufs into images, see
+ * gsk_vulkan_image_new_from_dmabuf() */
+gboolean
+gdk_vulkan_context_has_dmabuf_import (GdkVulkanContext *context)
+{
+  g_return_val_if_fail (GDK_IS_VULKAN_CONTEXT (context), FALSE);
+
+  return gdk_draw_context_get_display (GDK_DRAW_CONTEXT (context))->vk_has_dmabuf_import;
+}
+
 /**
  * gdk_vulkan_context_get_image_format:
  * @context: a #GdkVulkanContext
@@ -947,13 +1005,22 @@ gdk_display_create_vulkan_device (GdkDisplay  *display,
             {
               GPtrArray *device_extensions;
               gboolean has_incremental_present;
+              gboolean has_dmabuf_import;
 
               has_incremental_present = device_supports_incremental_present (devices[i]);
+              has_dmabuf_import = device_supports_dmabuf_import (display, devices[i]);
 
               device_extensions = g_ptr_array_new ();
               g_ptr_array_add (device_extensions, (gpointer) VK_KHR_SWAPCHAIN_EXTENSION_NAME);
               if (has_incremental_present)
                 g_ptr_array_add (device_extensions, (gpointer) VK_KHR_INCREMENTAL_PRESENT_EXTENSION_NAME);
+              if (has_dmabuf_import)
+                {
+                  guint k;
+
+                  for (k = 0; k < G_N_ELEMENTS (dmabuf_device_extensions); k++)
+                    g_ptr_array_add (device_extensions, (gpointer) dmabuf_device_extensions[k]);
+                }
 
               GDK_DISPLAY_NOTE (display, VULKAN, g_print ("Using Vulkan device %u, queue %u\n", i, j));
               if (GDK_VK_CHECK (vkCreateDevice, devices[i],
@@ -983,6 +1050,7 @@ gdk_display_create_vulkan_device (GdkDisplay  *display,
               g_ptr_array_unref (device_extensions);
 
               display->vk_physical_device = devices[i];
+              display->vk_has_dmabuf_import = has_dmabuf_import;
               vkGetDeviceQueue(display->vk_device, j, 0, &display->vk_queue);
               display->vk_queue_family_index = j;
               return TRUE;
@@ -1027,6 +1095,7 @@ gdk_display_create_vulkan_instance (GdkDisplay  *display,
   GPtrArray *used_extensions;
   GPtrArray *used_layers;
   gboolean validate = FALSE, have_debug_report = FALSE;
+  gboolean have_properties2 = FALSE, have_external_memory_capabilities = FALSE;
   VkResult res;
 
   if (GDK_DISPLAY_GET_CLASS (display)->vk_extension_name == NULL)
@@ -1059,8 +1128,20 @@ gdk_display_create_vulkan_instance (GdkDisplay  *display,
           g_ptr_array_add (used_extensions, (gpointer) VK_EXT_DEBUG_REPORT_EXTENSION_NAME);
           have_debug_report = TRUE;
         }
+      else if (g_str_equal (extensions[i].extensionName, VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME))
+        {
+          g_ptr_array_add (used_extensions, (gpointer) VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
+          have_properties2 = TRUE;
+        }
+      else if (g_str_equal (extensions[i].extensionName, VK_KHR_EXTERNAL_MEMORY_CAPABILITIES_EXTENSION_NAME))
+        {
+          g_ptr_array_add (used_extensions, (gpointer) VK_KHR_EXTERNAL_MEMORY_CAPABILITIES_EXTENSION_NAME);
+          have_external_memory_capabilities = TRUE;
+        }
     }
 
+  display->vk_has_external_memory_capabilities = have_properties2 && have_external_memory_capabilities;
+
   uint32_t n_layers;
   GDK_VK_CHECK (vkEnumerateInstanceLayerProperties, &n_layers, NULL);
   VkLayerProperties *layers = g_newa (VkLayerProperties, n_layers);
@@ -28,6 +28,11 @@
 static const cairo_user_data_key_t gdk_wayland_cairo_context_key;
 static const cairo_user_data_key_t gdk_wayland_cairo_region_key;
 
+/* Released buffers kept around for drawing */
+#define MAX_FREE_SURFACES 2
+/* Memory of buffers that had the wrong size */
+#define MAX_SPARE_BLOCKS 2
+
 G_DEFINE_TYPE (GdkWaylandCairoContext, gdk_wayland_cairo_context, GDK_TYPE_CAIRO_CONTEXT)
 
 static void
@@ -89,6 +94,33 @@ gdk_wayland_cairo_context_remove_surface (GdkWaylandCairoContext *self,
   cairo_surface_destroy (surface);
 }
 
+static gboolean
+gdk_wayland_cairo_context_surface_has_size (GdkWaylandCairoContext *self,
+                                            cairo_surface_t        *cairo_surface)
+{
+  GdkSurface *surface = gdk_draw_context_get_surface (GDK_DRAW_CONTEXT (self));
+  int scale = gdk_surface_get_scale_factor (surface);
+
+  return cairo_image_surface_get_width (cairo_surface) == gdk_surface_get_width (surface) * scale &&
+         cairo_image_surface_get_height (cairo_surface) == gdk_surface_get_height (surface) * scale;
+}
+
+/* Gets rid of a surface that doesn't fit the GdkSurface anymore,
+ * but keeps its memory for the next one */
+static void
+gdk_wayland_cairo_context_recycle_surface (GdkWaylandCairoContext *self,
+                                           cairo_surface_t        *cairo_surface)
+{
+  if (g_slist_length (self->spare_blocks) < MAX_SPARE_BLOCKS)
+    {
+      GdkWaylandShmBlock *block = _gdk_wayland_shm_surface_get_block (cairo_surface);
+
+      self->spare_blocks = g_slist_prepend (self->spare_blocks, _gdk_wayland_shm_block_ref (block));
+    }
+
+  gdk_wayland_cairo_context_remove_surface (self, cairo_surface);
+}
+
 static void
 gdk_wayland_cairo_context_buffer_release (void             *_data,
                                           struct wl_buffer *wl_buffer)
@@ -100,40 +132,83 @@ gdk_wayland_cairo_context_buffer_release (void             *_data,
   if (self == NULL)
     return;
 
-  /* Cache one surface for reuse when drawing */
-  if (self->cached_surface == NULL)
+  /* Keep a few surfaces for reuse when drawing, the compositor
+   * may hold on to more than one buffer */
+  if (g_slist_length (self->free_surfaces) < MAX_FREE_SURFACES &&
+      gdk_wayland_cairo_context_surface_has_size (self, cairo_surface))
     {
-      self->cached_surface = cairo_surface;
+      self->free_surfaces = g_slist_prepend (self->free_surfaces, cairo_surface);
       return;
     }
 
-  /* Get rid of all the extra ones */
-  gdk_wayland_cairo_context_remove_surface (self, cairo_surface);
+  gdk_wayland_cairo_context_recycle_surface (self, cairo_surface);
 }
 
 static const struct wl_buffer_listener buffer_listener = {
   gdk_wayland_cairo_context_buffer_release
 };
 
+/* Blocks are allocated in size classes, so that the memory of a
+ * buffer can be reused after small size changes, like during an
+ * interactive resize. The classes are quarters of powers of two,
+ * so no more than a quarter of a block is wasted. */
+static gsize
+get_block_size (gsize size)
+{
+  gsize step;
+
+  for (step = 4096; step * 8 <= size; step *= 2)
+    ;
+
+  return (size + step - 1) / step * step;
+}
+
+static GdkWaylandShmBlock *
+gdk_wayland_cairo_context_get_block (GdkWaylandCairoContext *self,
+                                     gsize                   size)
+{
+  GdkWaylandDisplay *display_wayland = GDK_WAYLAND_DISPLAY (gdk_draw_context_get_display (GDK_DRAW_CONTEXT (self)));
+  GSList *l;
+
+  for (l = self->spare_blocks; l; l = l->next)
+    {
+      GdkWaylandShmBlock *block = l->data;
+      gsize block_size = _gdk_wayland_shm_block_get_size (block);
+
+      if (block_size >= size && block_size < 2 * size)
+        {
+          self->spare_blocks = g_slist_delete_link (self->spare_blocks, l);
+          return block;
+        }
+    }
+
+  return _gdk_wayland_shm_block_new (display_wayland, get_block_size (size));
+}
+
 static cairo_surface_t *
 gdk_wayland_cairo_context_create_surface (GdkWaylandCairoContext *self)
 {
   GdkWaylandDisplay *display_wayland = GDK_WAYLAND_DISPLAY (gdk_draw_context_get_display (GDK_DRAW_CONTEXT (self)));
   GdkSurface *surface = gdk_draw_context_get_surface (GDK_DRAW_CONTEXT (self));
+  GdkWaylandShmBlock *block;
   cairo_surface_t *cairo_surface;
   struct wl_buffer *buffer;
   cairo_region_t *region;
-  int width, height;
+  int width, height, scale;
 
   width = gdk_surface_get_width (surface);
   height = gdk_surface_get_height (surface);
-  cairo_surface = _gdk_wayland_display_create_shm_surface (display_wayland,
-                                                           width, height,
-                                                           gdk_surface_get_scale_factor (surface));
+  scale = gdk_surface_get_scale_factor (surface);
+  block = gdk_wayland_cairo_context_get_block (self, _gdk_wayland_shm_surface_size (width, height, scale));
+  cairo_surface = _gdk_wayland_shm_block_create_surface (block, display_wayland,
+                                                         width, height,
+                                                         scale);
+  _gdk_wayland_shm_block_unref (block);
   buffer = _gdk_wayland_shm_surface_get_wl_buffer (cairo_surface);
   wl_buffer_add_listener (buffer, &buffer_listener, cairo_surface);
   gdk_wayland_cairo_context_add_surface (self, cairo_surface);
 
+  /* A new buffer, even in reused memory, needs a full repaint */
   region = cairo_region_create_rectangle (&(cairo_rectangle_int_t) { 0, 0, width, height });
   gdk_wayland_cairo_context_surface_add_region (cairo_surface, region);
   cairo_region_destroy (region);
@@ -150,8 +225,11 @@ gdk_wayland_cairo_context_begin_frame (GdkDrawContext *draw_context,
   GSList *l;
   cairo_t *cr;
 
-  if (self->cached_surface)
-    self->paint_surface = g_steal_pointer (&self->cached_surface);
+  if (self->free_surfaces)
+    {
+      self->paint_surface = self->free_surfaces->data;
+      self->free_surfaces = g_slist_delete_link (self->free_surfaces, self->free_surfaces);
+    }
   else
     self->paint_surface = gdk_wayland_cairo_context_create_surface (self);
 
@@ -194,17 +272,26 @@ gdk_wayland_cairo_context_end_frame (GdkDrawContext *draw_context,
 static void
 gdk_wayland_cairo_context_clear_all_cairo_surfaces (GdkWaylandCairoContext *self)
 {
-  self->cached_surface = NULL;
+  g_clear_pointer (&self->free_surfaces, g_slist_free);
   while (self->surfaces)
     gdk_wayland_cairo_context_remove_surface (self, self->surfaces->data);
+  g_slist_free_full (self->spare_blocks, (GDestroyNotify) _gdk_wayland_shm_block_unref);
+  self->spare_blocks = NULL;
 }
 
 static void
 gdk_wayland_cairo_context_surface_resized (GdkDrawContext *draw_context)
 {
   GdkWaylandCairoContext *self = GDK_WAYLAND_CAIRO_CONTEXT (draw_context);
+  GSList *free_surfaces;
 
-  gdk_wayland_cairo_context_clear_all_cairo_surfaces (self);
+  /* Surfaces held by the compositor get recycled when it releases them */
+  free_surfaces = g_steal_pointer (&self->free_surfaces);
+  while (free_surfaces)
+    {
+      gdk_wayland_cairo_context_recycle_surface (self, free_surfaces->data);
+      free_surfaces = g_slist_delete_link (free_surfaces, free_surfaces);
+    }
 }
 
 static cairo_t *
@@ -40,7 +40,8 @@ struct _GdkWaylandCairoContext
   GdkCairoContext parent_instance;
 
   GSList *surfaces;
-  cairo_surface_t *cached_surface;
+  GSList *free_surfaces;
+  GSList *spare_blocks;
   cairo_surface_t *paint_surface;
 };
 
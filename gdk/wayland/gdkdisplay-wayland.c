@@ -364,6 +364,20 @@ static const struct wl_shm_listener wl_shm_listener = {
   wl_shm_format
 };
 
+static void
+presentation_clock_id (void                   *data,
+                       struct wp_presentation *presentation,
+                       uint32_t                clk_id)
+{
+  GdkWaylandDisplay *display_wayland = data;
+
+  display_wayland->presentation_clock_id = clk_id;
+}
+
+static const struct wp_presentation_listener presentation_listener = {
+  presentation_clock_id
+};
+
 static void
 server_decoration_manager_default_mode (void                                          *data,
                                         struct org_kde_kwin_server_decoration_manager *manager,
@@ -561,6 +575,30 @@ gdk_registry_handle_global (void               *data,
         wl_registry_bind (display_wayland->wl_registry, id,
                           &zwp_idle_inhibit_manager_v1_interface, 1);
     }
+  else if (strcmp (interface, "zwp_linux_dmabuf_v1") == 0 && version >= 2)
+    {
+      /* We need create_immed from version 2, and modifiers from 3 */
+      display_wayland->linux_dmabuf_version = MIN (version, 3);
+      display_wayland->linux_dmabuf =
+        wl_registry_bind (display_wayland->wl_registry, id,
+                          &zwp_linux_dmabuf_v1_interface,
+                          display_wayland->linux_dmabuf_version);
+    }
+  else if (strcmp (interface, "wp_presentation") == 0)
+    {
+      display_wayland->presentation =
+        wl_registry_bind (display_wayland->wl_registry, id,
+                          &wp_presentation_interface, 1);
+      wp_presentation_add_listener (display_wayland->presentation,
+                                    &presentation_listener,
+                                    display_wayland);
+    }
+  else if (strcmp (interface, "wp_viewporter") == 0)
+    {
+      display_wayland->viewporter =
+        wl_registry_bind (display_wayland->wl_registry, id,
+                          &wp_viewporter_interface, 1);
+    }
 
   g_hash_table_insert (display_wayland->known_globals,
                        GUINT_TO_POINTER (id), g_strdup (interface));
@@ -1204,10 +1242,18 @@ gdk_wayland_display_get_wl_compositor (GdkDisplay *display)
 
 static const cairo_user_data_key_t gdk_wayland_shm_surface_cairo_key;
 
-typedef struct _GdkWaylandCairoSurfaceData {
+/* A piece of shared memory that buffers get created in. It can outlive
+ * its buffers, so that it gets reused for the next one instead of
+ * creating and mapping a new file every time. */
+struct _GdkWaylandShmBlock {
+  int ref_count;
   gpointer buf;
   size_t buf_length;
   struct wl_shm_pool *pool;
+};
+
+typedef struct _GdkWaylandCairoSurfaceData {
+  GdkWaylandShmBlock *block;
   struct wl_buffer *buffer;
   GdkWaylandDisplay *display;
   uint32_t scale;
@@ -1319,6 +1365,51 @@ fail:
   return NULL;
 }
 
+GdkWaylandShmBlock *
+_gdk_wayland_shm_block_new (GdkWaylandDisplay *display,
+                            gsize              size)
+{
+  GdkWaylandShmBlock *block;
+
+  block = g_new (GdkWaylandShmBlock, 1);
+  block->ref_count = 1;
+  block->pool = create_shm_pool (display->shm,
+                                 size,
+                                 &block->buf_length,
+                                 &block->buf);
+
+  return block;
+}
+
+GdkWaylandShmBlock *
+_gdk_wayland_shm_block_ref (GdkWaylandShmBlock *block)
+{
+  block->ref_count++;
+
+  return block;
+}
+
+void
+_gdk_wayland_shm_block_unref (GdkWaylandShmBlock *block)
+{
+  block->ref_count--;
+  if (block->ref_count > 0)
+    return;
+
+  if (block->pool)
+    wl_shm_pool_destroy (block->pool);
+
+  if (block->buf)
+    munmap (block->buf, block->buf_length);
+  g_free (block);
+}
+
+gsize
+_gdk_wayland_shm_block_get_size (GdkWaylandShmBlock *block)
+{
+  return block->buf_length;
+}
+
 static void
 gdk_wayland_cairo_surface_destroy (void *p)
 {
@@ -1327,45 +1418,52 @@ gdk_wayland_cairo_surface_destroy (void *p)
   if (data->buffer)
     wl_buffer_destroy (data->buffer);
 
-  if (data->pool)
-    wl_shm_pool_destroy (data->pool);
-
-  munmap (data->buf, data->buf_length);
+  _gdk_wayland_shm_block_unref (data->block);
   g_free (data);
 }
 
+gsize
+_gdk_wayland_shm_surface_size (int   width,
+                               int   height,
+                               guint scale)
+{
+  return (gsize) height * scale * cairo_format_stride_for_width (CAIRO_FORMAT_ARGB32, width * scale);
+}
+
+/* The block must be at least _gdk_wayland_shm_surface_size() big */
 cairo_surface_t *
-_gdk_wayland_display_create_shm_surface (GdkWaylandDisplay *display,
-                                         int                width,
-                                         int                height,
-                                         guint              scale)
+_gdk_wayland_shm_block_create_surface (GdkWaylandShmBlock *block,
+                                       GdkWaylandDisplay  *display,
+                                       int                 width,
+                                       int                 height,
+                                       guint               scale)
 {
   GdkWaylandCairoSurfaceData *data;
   cairo_surface_t *surface = NULL;
   cairo_status_t status;
   int stride;
 
+  g_assert (block->buf == NULL ||
+            _gdk_wayland_shm_block_get_size (block) >= _gdk_wayland_shm_surface_size (width, height, scale));
+
   data = g_new (GdkWaylandCairoSurfaceData, 1);
   data->display = display;
   data->buffer = NULL;
   data->scale = scale;
+  data->block = _gdk_wayland_shm_block_ref (block);
 
   stride = cairo_format_stride_for_width (CAIRO_FORMAT_ARGB32, width*scale);
 
-  data->pool = create_shm_pool (display->shm,
-                                height*scale*stride,
-                                &data->buf_length,
-                                &data->buf);
-
-  surface = cairo_image_surface_create_for_data (data->buf,
+  surface = cairo_image_surface_create_for_data (block->buf,
                                                  CAIRO_FORMAT_ARGB32,
                                                  width*scale,
                                                  height*scale,
                                                  stride);
 
-  data->buffer = wl_shm_pool_create_buffer (data->pool, 0,
-                                            width*scale, height*scale,
-                                            stride, WL_SHM_FORMAT_ARGB8888);
+  if (block->pool)
+    data->buffer = wl_shm_pool_create_buffer (block->pool, 0,
+                                              width*scale, height*scale,
+                                              stride, WL_SHM_FORMAT_ARGB8888);
 
   cairo_surface_set_user_data (surface, &gdk_wayland_shm_surface_cairo_key,
                                data, gdk_wayland_cairo_surface_destroy);
@@ -1382,6 +1480,22 @@ _gdk_wayland_display_create_shm_surface (GdkWaylandDisplay *display,
   return surface;
 }
 
+cairo_surface_t *
+_gdk_wayland_display_create_shm_surface (GdkWaylandDisplay *display,
+                                         int                width,
+                                         int                height,
+                                         guint              scale)
+{
+  GdkWaylandShmBlock *block;
+  cairo_surface_t *surface;
+
+  block = _gdk_wayland_shm_block_new (display, _gdk_wayland_shm_surface_size (width, height, scale));
+  surface = _gdk_wayland_shm_block_create_surface (block, display, width, height, scale);
+  _gdk_wayland_shm_block_unref (block);
+
+  return surface;
+}
+
 struct wl_buffer *
 _gdk_wayland_shm_surface_get_wl_buffer (cairo_surface_t *surface)
 {
@@ -1395,6 +1509,13 @@ _gdk_wayland_is_shm_surface (cairo_surface_t *surface)
   return cairo_surface_get_user_data (surface, &gdk_wayland_shm_surface_cairo_key) != NULL;
 }
 
+GdkWaylandShmBlock *
+_gdk_wayland_shm_surface_get_block (cairo_surface_t *surface)
+{
+  GdkWaylandCairoSurfaceData *data = cairo_surface_get_user_data (surface, &gdk_wayland_shm_surface_cairo_key);
+  return data->block;
+}
+
 typedef enum
 {
   GSD_FONT_ANTIALIASING_MODE_NONE,
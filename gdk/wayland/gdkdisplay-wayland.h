@@ -37,6 +37,9 @@
 #include <gdk/wayland/xdg-output-unstable-v1-client-protocol.h>
 #include <gdk/wayland/idle-inhibit-unstable-v1-client-protocol.h>
 #include <gdk/wayland/primary-selection-unstable-v1-client-protocol.h>
+#include <gdk/wayland/linux-dmabuf-unstable-v1-client-protocol.h>
+#include <gdk/wayland/viewporter-client-protocol.h>
+#include <gdk/wayland/presentation-time-client-protocol.h>
 
 #include <glib.h>
 #include <gdk/gdkkeys.h>
@@ -112,6 +115,9 @@ struct _GdkWaylandDisplay
   struct org_kde_kwin_server_decoration_manager *server_decoration_manager;
   struct zxdg_output_manager_v1 *xdg_output_manager;
   struct zwp_idle_inhibit_manager_v1 *idle_inhibit_manager;
+  struct zwp_linux_dmabuf_v1 *linux_dmabuf;
+  struct wp_viewporter *viewporter;
+  struct wp_presentation *presentation;
 
   GList *async_roundtrips;
 
@@ -139,6 +145,8 @@ struct _GdkWaylandDisplay
   int data_device_manager_version;
   int gtk_shell_version;
   int xdg_output_manager_version;
+  int linux_dmabuf_version;
+  guint32 presentation_clock_id;
 
   uint32_t server_decoration_mode;
 
@@ -157,7 +165,10 @@ struct _GdkWaylandDisplay
   guint have_egl_khr_create_context : 1;
   guint have_egl_buffer_age : 1;
   guint have_egl_swap_buffers_with_damage : 1;
+  guint have_egl_partial_update : 1;
   guint have_egl_surfaceless_context : 1;
+  guint have_egl_dma_buf_import : 1;
+  guint have_egl_dma_buf_import_modifiers : 1;
 };
 
 struct _GdkWaylandDisplayClass
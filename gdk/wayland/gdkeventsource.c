@@ -20,6 +20,7 @@
 #include "gdkinternals.h"
 #include "gdkprivate-wayland.h"
 
+#include <glib-unix.h>
 #include <unistd.h>
 #include <errno.h>
 
@@ -29,8 +30,135 @@ typedef struct _GdkWaylandEventSource {
   uint32_t mask;
   GdkDisplay *display;
   gboolean reading;
+
+  /* Only used with GDK_DEBUG=event-thread */
+  GThread *thread;
+  GMutex thread_mutex;
+  GCond thread_cond;
+  int thread_wakeup[2];
+  gboolean thread_stop;
+  int thread_pending;
 } GdkWaylandEventSource;
 
+/* With GDK_DEBUG=event-thread, the Wayland socket is read in a thread,
+ * so that events are taken off the socket even while the main thread
+ * is busy with layout or drawing. The thread only moves the events
+ * into their queues, they are still dispatched on the main thread by
+ * _gdk_wayland_display_queue_events().
+ */
+static gpointer
+gdk_event_source_thread (gpointer data)
+{
+  GdkWaylandEventSource *source = data;
+  GdkWaylandDisplay *display = (GdkWaylandDisplay *) source->display;
+  GPollFD fds[2];
+
+  fds[0].fd = wl_display_get_fd (display->wl_display);
+  fds[0].events = G_IO_IN | G_IO_ERR | G_IO_HUP;
+  fds[1].fd = source->thread_wakeup[0];
+  fds[1].events = G_IO_IN;
+
+  while (TRUE)
+    {
+      /* If the default queue is not empty, we have to wait for the
+       * main thread to dispatch it before we can read again */
+      if (wl_display_prepare_read (display->wl_display) != 0)
+        {
+          g_mutex_lock (&source->thread_mutex);
+          g_atomic_int_set (&source->thread_pending, TRUE);
+          g_main_context_wakeup (NULL);
+          while (g_atomic_int_get (&source->thread_pending) && !source->thread_stop)
+            g_cond_wait (&source->thread_cond, &source->thread_mutex);
+          if (source->thread_stop)
+            {
+              g_mutex_unlock (&source->thread_mutex);
+              break;
+            }
+          g_mutex_unlock (&source->thread_mutex);
+          continue;
+        }
+
+      fds[0].revents = fds[1].revents = 0;
+      if (g_poll (fds, 2, -1) < 0)
+        {
+          wl_display_cancel_read (display->wl_display);
+          if (errno == EINTR)
+            continue;
+
+          g_message ("Error polling Wayland display: %s", g_strerror (errno));
+          _exit (1);
+        }
+
+      if (fds[1].revents)
+        {
+          wl_display_cancel_read (display->wl_display);
+          break;
+        }
+
+      if (fds[0].revents & G_IO_IN)
+        {
+          if (wl_display_read_events (display->wl_display) < 0)
+            {
+              g_message ("Error reading events from display: %s", g_strerror (errno));
+              _exit (1);
+            }
+        }
+      else
+        {
+          wl_display_cancel_read (display->wl_display);
+          if (fds[0].revents & (G_IO_ERR | G_IO_HUP))
+            {
+              g_message ("Lost connection to Wayland compositor.");
+              _exit (1);
+            }
+        }
+
+      g_atomic_int_set (&source->thread_pending, TRUE);
+      g_main_context_wakeup (NULL);
+    }
+
+  return NULL;
+}
+
+static gboolean
+gdk_event_source_thread_start (GdkWaylandEventSource *source)
+{
+  GError *error = NULL;
+
+  if (!g_unix_open_pipe (source->thread_wakeup, FD_CLOEXEC, &error))
+    {
+      g_warning ("Failed to create the Wayland event thread: %s", error->message);
+      g_error_free (error);
+      return FALSE;
+    }
+
+  g_mutex_init (&source->thread_mutex);
+  g_cond_init (&source->thread_cond);
+  source->thread = g_thread_new ("gdk-wayland-events", gdk_event_source_thread, source);
+
+  return TRUE;
+}
+
+static void
+gdk_event_source_thread_stop (GdkWaylandEventSource *source)
+{
+  g_mutex_lock (&source->thread_mutex);
+  source->thread_stop = TRUE;
+  g_cond_signal (&source->thread_cond);
+  g_mutex_unlock (&source->thread_mutex);
+
+  if (write (source->thread_wakeup[1], "x", 1) < 0)
+    g_warning ("Failed to stop the Wayland event thread: %s", g_strerror (errno));
+
+  g_thread_join (source->thread);
+  source->thread = NULL;
+
+  close (source->thread_wakeup[0]);
+  close (source->thread_wakeup[1]);
+  g_mutex_clear (&source->thread_mutex);
+  g_cond_clear (&source->thread_cond);
+}
+
 static gboolean
 gdk_event_source_prepare (GSource *base,
                           int     *timeout)
@@ -52,6 +180,17 @@ gdk_event_source_prepare (GSource *base,
   if (_gdk_event_queue_find_first (source->display) != NULL)
     return TRUE;
 
+  if (source->thread)
+    {
+      if (wl_display_flush (display->wl_display) < 0 && errno != EAGAIN)
+        {
+          g_message ("Error flushing display: %s", g_strerror (errno));
+          _exit (1);
+        }
+
+      return g_atomic_int_get (&source->thread_pending);
+    }
+
   /* wl_display_prepare_read() needs to be balanced with either
    * wl_display_read_events() or wl_display_cancel_read()
    * (in gdk_event_source_check() */
@@ -105,6 +244,10 @@ gdk_event_source_check (GSource *base)
       return _gdk_event_queue_find_first (source->display) != NULL;
     }
 
+  if (source->thread)
+    return _gdk_event_queue_find_first (source->display) != NULL ||
+           g_atomic_int_get (&source->thread_pending);
+
   /* read the events from the wayland fd into their respective queues if we have data */
   if (source->reading)
     {
@@ -155,6 +298,9 @@ gdk_event_source_finalize (GSource *base)
   if (source->reading)
     wl_display_cancel_read (display->wl_display);
   source->reading = FALSE;
+
+  if (source->thread)
+    gdk_event_source_thread_stop (source);
 }
 
 static GSourceFuncs wl_glib_source_funcs = {
@@ -193,9 +339,15 @@ _gdk_wayland_display_event_source_new (GdkDisplay *display)
 
   display_wayland = GDK_WAYLAND_DISPLAY (display);
   wl_source->display = display;
-  wl_source->pfd.fd = wl_display_get_fd (display_wayland->wl_display);
-  wl_source->pfd.events = G_IO_IN | G_IO_ERR | G_IO_HUP;
-  g_source_add_poll (source, &wl_source->pfd);
+
+  /* The thread polls the socket, the main loop only gets woken up */
+  if ((gdk_display_get_debug_flags (display) & GDK_DEBUG_EVENT_THREAD) == 0 ||
+      !gdk_event_source_thread_start (wl_source))
+    {
+      wl_source->pfd.fd = wl_display_get_fd (display_wayland->wl_display);
+      wl_source->pfd.events = G_IO_IN | G_IO_ERR | G_IO_HUP;
+      g_source_add_poll (source, &wl_source->pfd);
+    }
 
   g_source_set_priority (source, GDK_PRIORITY_EVENTS);
   g_source_set_can_recurse (source, TRUE);
@@ -239,4 +391,13 @@ _gdk_wayland_display_queue_events (GdkDisplay *display)
       _exit (1);
     }
   source->pfd.revents = 0;
+
+  /* Let the thread read again, now that the queues are empty */
+  if (source->thread)
+    {
+      g_mutex_lock (&source->thread_mutex);
+      g_atomic_int_set (&source->thread_pending, FALSE);
+      g_cond_signal (&source->thread_cond);
+      g_mutex_unlock (&source->thread_mutex);
+    }
 }
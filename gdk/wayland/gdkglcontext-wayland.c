@@ -30,6 +30,7 @@
 #include "gdkprivate-wayland.h"
 
 #include "gdkinternals.h"
+#include "gdkdmabuftextureprivate.h"
 #include "gdksurfaceprivate.h"
 #include "gdkprofilerprivate.h"
 
@@ -216,6 +217,64 @@ gdk_wayland_gl_context_get_damage (GdkGLContext *context)
   return GDK_GL_CONTEXT_CLASS (gdk_wayland_gl_context_parent_class)->get_damage (context);
 }
 
+static EGLint *
+region_to_egl_rects (const cairo_region_t *region,
+                     GdkSurface           *surface,
+                     int                  *n_rects)
+{
+  int i, j;
+  EGLint *rects;
+  cairo_rectangle_int_t rect;
+  int surface_height = gdk_surface_get_height (surface);
+  int scale = gdk_surface_get_scale_factor (surface);
+
+  *n_rects = cairo_region_num_rectangles (region);
+  rects = g_new (EGLint, *n_rects * 4);
+
+  for (i = 0, j = 0; i < *n_rects; i++)
+    {
+      cairo_region_get_rectangle (region, i, &rect);
+      rects[j++] = rect.x * scale;
+      rects[j++] = (surface_height - rect.height - rect.y) * scale;
+      rects[j++] = rect.width * scale;
+      rects[j++] = rect.height * scale;
+    }
+
+  return rects;
+}
+
+static void
+gdk_wayland_gl_context_begin_frame (GdkDrawContext *draw_context,
+                                    cairo_region_t *region)
+{
+  GdkGLContext *context = GDK_GL_CONTEXT (draw_context);
+  GdkSurface *surface = gdk_gl_context_get_surface (context);
+  GdkDisplay *display = gdk_surface_get_display (surface);
+  GdkWaylandDisplay *display_wayland = GDK_WAYLAND_DISPLAY (display);
+  GdkWaylandGLContext *context_wayland = GDK_WAYLAND_GL_CONTEXT (context);
+  EGLSurface egl_surface;
+  EGLint *rects;
+  int n_rects;
+
+  GDK_DRAW_CONTEXT_CLASS (gdk_wayland_gl_context_parent_class)->begin_frame (draw_context, region);
+  if (gdk_gl_context_get_shared_context (context))
+    return;
+
+  /* With EGL_KHR_partial_update, the driver only has to preserve (and on
+   * tiled GPUs, load) the parts of the back buffer outside of @region,
+   * which at this point includes the damage computed from the buffer age.
+   */
+  if (!display_wayland->have_egl_partial_update)
+    return;
+
+  egl_surface = gdk_wayland_surface_get_egl_surface (surface,
+                                                    context_wayland->egl_config);
+
+  rects = region_to_egl_rects (region, surface, &n_rects);
+  eglSetDamageRegionKHR (display_wayland->egl_display, egl_surface, rects, n_rects);
+  g_free (rects);
+}
+
 static void
 gdk_wayland_gl_context_end_frame (GdkDrawContext *draw_context,
                                   cairo_region_t *painted)
@@ -242,20 +301,9 @@ gdk_wayland_gl_context_end_frame (GdkDrawContext *draw_context,
   gdk_profiler_add_mark (GDK_PROFILER_CURRENT_TIME, 0, "wayland", "swap buffers");
   if (display_wayland->have_egl_swap_buffers_with_damage)
     {
-      int i, j, n_rects = cairo_region_num_rectangles (painted);
-      EGLint *rects = g_new (EGLint, n_rects * 4);
-      cairo_rectangle_int_t rect;
-      int surface_height = gdk_surface_get_height (surface);
-      int scale = gdk_surface_get_scale_factor (surface);
+      int n_rects;
+      EGLint *rects = region_to_egl_rects (painted, surface, &n_rects);
 
-      for (i = 0, j = 0; i < n_rects; i++)
-        {
-          cairo_region_get_rectangle (painted, i, &rect);
-          rects[j++] = rect.x * scale;
-          rects[j++] = (surface_height - rect.height - rect.y) * scale;
-          rects[j++] = rect.width * scale;
-          rects[j++] = rect.height * scale;
-        }
       eglSwapBuffersWithDamageEXT (display_wayland->egl_display, egl_surface, rects, n_rects);
       g_free (rects);
     }
@@ -265,6 +313,87 @@ gdk_wayland_gl_context_end_frame (GdkDrawContext *draw_context,
   gdk_wayland_surface_notify_committed (surface);
 }
 
+static gboolean
+gdk_wayland_gl_context_import_dmabuf (GdkGLContext     *context,
+                                      GdkDmabufTexture *texture,
+                                      guint             target)
+{
+  GdkDisplay *display = gdk_gl_context_get_display (context);
+  GdkWaylandDisplay *display_wayland = GDK_WAYLAND_DISPLAY (display);
+  static const EGLint plane_attribs[GDK_DMABUF_MAX_PLANES][5] = {
+    { EGL_DMA_BUF_PLANE0_FD_EXT, EGL_DMA_BUF_PLANE0_OFFSET_EXT, EGL_DMA_BUF_PLANE0_PITCH_EXT,
+      EGL_DMA_BUF_PLANE0_MODIFIER_LO_EXT, EGL_DMA_BUF_PLANE0_MODIFIER_HI_EXT },
+    { EGL_DMA_BUF_PLANE1_FD_EXT, EGL_DMA_BUF_PLANE1_OFFSET_EXT, EGL_DMA_BUF_PLANE1_PITCH_EXT,
+      EGL_DMA_BUF_PLANE1_MODIFIER_LO_EXT, EGL_DMA_BUF_PLANE1_MODIFIER_HI_EXT },
+    { EGL_DMA_BUF_PLANE2_FD_EXT, EGL_DMA_BUF_PLANE2_OFFSET_EXT, EGL_DMA_BUF_PLANE2_PITCH_EXT,
+      EGL_DMA_BUF_PLANE2_MODIFIER_LO_EXT, EGL_DMA_BUF_PLANE2_MODIFIER_HI_EXT },
+    { EGL_DMA_BUF_PLANE3_FD_EXT, EGL_DMA_BUF_PLANE3_OFFSET_EXT, EGL_DMA_BUF_PLANE3_PITCH_EXT,
+      EGL_DMA_BUF_PLANE3_MODIFIER_LO_EXT, EGL_DMA_BUF_PLANE3_MODIFIER_HI_EXT },
+  };
+  EGLint attribs[7 + GDK_DMABUF_MAX_PLANES * 10];
+  guint64 modifier;
+  EGLImageKHR image;
+  guint i, j;
+
+  if (!display_wayland->have_egl_dma_buf_import ||
+      !epoxy_has_gl_extension ("GL_OES_EGL_image"))
+    return FALSE;
+
+  modifier = gdk_dmabuf_texture_get_modifier (texture);
+  if (modifier != GDK_DRM_FORMAT_MOD_INVALID &&
+      modifier != GDK_DRM_FORMAT_MOD_LINEAR &&
+      !display_wayland->have_egl_dma_buf_import_modifiers)
+    return FALSE;
+
+  i = 0;
+  attribs[i++] = EGL_WIDTH;
+  attribs[i++] = gdk_texture_get_width (GDK_TEXTURE (texture));
+  attribs[i++] = EGL_HEIGHT;
+  attribs[i++] = gdk_texture_get_height (GDK_TEXTURE (texture));
+  attribs[i++] = EGL_LINUX_DRM_FOURCC_EXT;
+  attribs[i++] = gdk_dmabuf_texture_get_fourcc (texture);
+
+  for (j = 0; j < gdk_dmabuf_texture_get_n_planes (texture); j++)
+    {
+      attribs[i++] = plane_attribs[j][0];
+      attribs[i++] = gdk_dmabuf_texture_get_fd (texture, j);
+      attribs[i++] = plane_attribs[j][1];
+      attribs[i++] = gdk_dmabuf_texture_get_offset (texture, j);
+      attribs[i++] = plane_attribs[j][2];
+      attribs[i++] = gdk_dmabuf_texture_get_stride (texture, j);
+
+      /* Without the modifiers extension, the driver assumes linear */
+      if (modifier != GDK_DRM_FORMAT_MOD_INVALID &&
+          display_wayland->have_egl_dma_buf_import_modifiers)
+        {
+          attribs[i++] = plane_attribs[j][3];
+          attribs[i++] = modifier & 0xFFFFFFFF;
+          attribs[i++] = plane_attribs[j][4];
+          attribs[i++] = modifier >> 32;
+        }
+    }
+
+  attribs[i++] = EGL_NONE;
+
+  image = eglCreateImageKHR (display_wayland->egl_display,
+                             EGL_NO_CONTEXT,
+                             EGL_LINUX_DMA_BUF_EXT,
+                             (EGLClientBuffer) NULL,
+                             attribs);
+  if (image == EGL_NO_IMAGE_KHR)
+    {
+      GDK_DISPLAY_NOTE (display, OPENGL,
+                        g_message ("Importing dma-buf failed: 0x%x", eglGetError ()));
+      return FALSE;
+    }
+
+  /* The texture keeps the buffer referenced, we don't need the image anymore */
+  glEGLImageTargetTexture2DOES (target, image);
+  eglDestroyImageKHR (display_wayland->egl_display, image);
+
+  return TRUE;
+}
+
 static void
 gdk_wayland_gl_context_class_init (GdkWaylandGLContextClass *klass)
 {
@@ -274,10 +403,12 @@ gdk_wayland_gl_context_class_init (GdkWaylandGLContextClass *klass)
 
   gobject_class->dispose = gdk_wayland_gl_context_dispose;
 
+  draw_context_class->begin_frame = gdk_wayland_gl_context_begin_frame;
   draw_context_class->end_frame = gdk_wayland_gl_context_end_frame;
 
   context_class->realize = gdk_wayland_gl_context_realize;
   context_class->get_damage = gdk_wayland_gl_context_get_damage;
+  context_class->import_dmabuf = gdk_wayland_gl_context_import_dmabuf;
 }
 
 static void
@@ -355,9 +486,18 @@ gdk_wayland_display_init_gl (GdkDisplay *display)
   display_wayland->have_egl_swap_buffers_with_damage =
     epoxy_has_egl_extension (dpy, "EGL_EXT_swap_buffers_with_damage");
 
+  display_wayland->have_egl_partial_update =
+    epoxy_has_egl_extension (dpy, "EGL_KHR_partial_update");
+
   display_wayland->have_egl_surfaceless_context =
     epoxy_has_egl_extension (dpy, "EGL_KHR_surfaceless_context");
 
+  display_wayland->have_egl_dma_buf_import =
+    epoxy_has_egl_extension (dpy, "EGL_EXT_image_dma_buf_import");
+
+  display_wayland->have_egl_dma_buf_import_modifiers =
+    epoxy_has_egl_extension (dpy, "EGL_EXT_image_dma_buf_import_modifiers");
+
   GDK_DISPLAY_NOTE (display, OPENGL,
             g_message ("EGL API version %d.%d found\n"
                        " - Vendor: %s\n"
@@ -97,6 +97,7 @@ void       gdk_wayland_surface_commit (GdkSurface *surface);
 void       gdk_wayland_surface_notify_committed (GdkSurface *surface);
 void       gdk_wayland_surface_request_frame (GdkSurface *surface);
 gboolean   gdk_wayland_surface_has_surface (GdkSurface *surface);
+GdkSubsurface * gdk_wayland_surface_create_subsurface (GdkSurface *surface);
 void            gdk_wayland_surface_attach_image           (GdkSurface           *surface,
                                                             cairo_surface_t      *cairo_surface,
                                                             const cairo_region_t *damage);
@@ -180,6 +181,23 @@ cairo_surface_t * _gdk_wayland_display_create_shm_surface (GdkWaylandDisplay *di
 struct wl_buffer *_gdk_wayland_shm_surface_get_wl_buffer (cairo_surface_t *surface);
 gboolean _gdk_wayland_is_shm_surface (cairo_surface_t *surface);
 
+typedef struct _GdkWaylandShmBlock GdkWaylandShmBlock;
+
+GdkWaylandShmBlock * _gdk_wayland_shm_block_new     (GdkWaylandDisplay  *display,
+                                                     gsize               size);
+GdkWaylandShmBlock * _gdk_wayland_shm_block_ref     (GdkWaylandShmBlock *block);
+void                 _gdk_wayland_shm_block_unref   (GdkWaylandShmBlock *block);
+gsize                _gdk_wayland_shm_block_get_size (GdkWaylandShmBlock *block);
+cairo_surface_t *    _gdk_wayland_shm_block_create_surface (GdkWaylandShmBlock *block,
+                                                            GdkWaylandDisplay  *display,
+                                                            int                 width,
+                                                            int                 height,
+                                                            guint               scale);
+gsize                _gdk_wayland_shm_surface_size  (int                 width,
+                                                     int                 height,
+                                                     guint               scale);
+GdkWaylandShmBlock * _gdk_wayland_shm_surface_get_block (cairo_surface_t *surface);
+
 EGLSurface gdk_wayland_surface_get_egl_surface (GdkSurface *surface,
                                                EGLConfig config);
 EGLSurface gdk_wayland_surface_get_dummy_egl_surface (GdkSurface *surface,
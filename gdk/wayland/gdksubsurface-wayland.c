@@ -0,0 +1,278 @@
+/* GDK - The GIMP Drawing Kit
+ * Copyright (C) 2021 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include "gdkprivate-wayland.h"
+
+#include "gdkdisplay-wayland.h"
+#include "gdkdmabuftextureprivate.h"
+#include "gdksubsurfaceprivate.h"
+#include "gdksurfaceprivate.h"
+
+#include <math.h>
+
+typedef struct _GdkWaylandSubsurface GdkWaylandSubsurface;
+typedef struct _GdkWaylandSubsurfaceClass GdkWaylandSubsurfaceClass;
+
+#define GDK_TYPE_WAYLAND_SUBSURFACE (gdk_wayland_subsurface_get_type ())
+#define GDK_WAYLAND_SUBSURFACE(obj) (G_TYPE_CHECK_INSTANCE_CAST ((obj), GDK_TYPE_WAYLAND_SUBSURFACE, GdkWaylandSubsurface))
+
+struct _GdkWaylandSubsurface
+{
+  GdkSubsurface parent_instance;
+
+  struct wl_surface *wl_surface;
+  struct wl_subsurface *wl_subsurface;
+  struct wp_viewport *viewport;
+
+  /* Where the last buffer was placed, the compositor applies
+   * position changes together with the next parent commit */
+  int x, y, width, height;
+  gboolean synchronized;
+};
+
+struct _GdkWaylandSubsurfaceClass
+{
+  GdkSubsurfaceClass parent_class;
+};
+
+G_DEFINE_TYPE (GdkWaylandSubsurface, gdk_wayland_subsurface, GDK_TYPE_SUBSURFACE)
+
+static void
+gdk_wayland_subsurface_finalize (GObject *object)
+{
+  GdkWaylandSubsurface *self = GDK_WAYLAND_SUBSURFACE (object);
+
+  g_clear_pointer (&self->viewport, wp_viewport_destroy);
+  g_clear_pointer (&self->wl_subsurface, wl_subsurface_destroy);
+  g_clear_pointer (&self->wl_surface, wl_surface_destroy);
+
+  G_OBJECT_CLASS (gdk_wayland_subsurface_parent_class)->finalize (object);
+}
+
+static void
+buffer_release (void             *data,
+                struct wl_buffer *buffer)
+{
+  GdkTexture *texture = data;
+
+  wl_buffer_destroy (buffer);
+  g_object_unref (texture);
+}
+
+static const struct wl_buffer_listener buffer_listener = {
+  buffer_release,
+};
+
+static struct wl_buffer *
+get_wl_buffer (GdkWaylandDisplay *display,
+               GdkDmabufTexture  *texture)
+{
+  struct zwp_linux_buffer_params_v1 *params;
+  struct wl_buffer *buffer;
+  guint64 modifier;
+  guint i;
+
+  if (display->linux_dmabuf == NULL)
+    return NULL;
+
+  modifier = gdk_dmabuf_texture_get_modifier (texture);
+  if (display->linux_dmabuf_version < 3 && modifier != GDK_DRM_FORMAT_MOD_INVALID)
+    return NULL;
+
+  params = zwp_linux_dmabuf_v1_create_params (display->linux_dmabuf);
+
+  for (i = 0; i < gdk_dmabuf_texture_get_n_planes (texture); i++)
+    zwp_linux_buffer_params_v1_add (params,
+                                    gdk_dmabuf_texture_get_fd (texture, i),
+                                    i,
+                                    gdk_dmabuf_texture_get_offset (texture, i),
+                                    gdk_dmabuf_texture_get_stride (texture, i),
+                                    modifier >> 32,
+                                    modifier & 0xffffffff);
+
+  /* The compositor disconnects us if it can't import the buffer,
+   * attach() only lets through formats that everybody supports */
+  buffer = zwp_linux_buffer_params_v1_create_immed (params,
+                                                    gdk_texture_get_width (GDK_TEXTURE (texture)),
+                                                    gdk_texture_get_height (GDK_TEXTURE (texture)),
+                                                    gdk_dmabuf_texture_get_fourcc (texture),
+                                                    0);
+  zwp_linux_buffer_params_v1_destroy (params);
+
+  wl_buffer_add_listener (buffer, &buffer_listener, g_object_ref (texture));
+
+  return buffer;
+}
+
+static gboolean
+gdk_wayland_subsurface_attach (GdkSubsurface         *subsurface,
+                               GdkTexture            *texture,
+                               const graphene_rect_t *rect)
+{
+  GdkWaylandSubsurface *self = GDK_WAYLAND_SUBSURFACE (subsurface);
+  GdkWaylandDisplay *display = GDK_WAYLAND_DISPLAY (gdk_surface_get_display (subsurface->parent));
+  struct wl_buffer *buffer;
+  int x, y, width, height, scale;
+  guint32 fourcc;
+
+  if (!GDK_IS_DMABUF_TEXTURE (texture))
+    return FALSE;
+
+  fourcc = gdk_dmabuf_texture_get_fourcc (GDK_DMABUF_TEXTURE (texture));
+  if (fourcc != GDK_DRM_FORMAT_ARGB8888 && fourcc != GDK_DRM_FORMAT_XRGB8888 &&
+      fourcc != GDK_DRM_FORMAT_ABGR8888 && fourcc != GDK_DRM_FORMAT_XBGR8888)
+    return FALSE;
+
+  /* Wayland positions and sizes surfaces in whole application pixels */
+  x = rect->origin.x;
+  y = rect->origin.y;
+  width = rect->size.width;
+  height = rect->size.height;
+  if (x != rect->origin.x || y != rect->origin.y ||
+      width != rect->size.width || height != rect->size.height ||
+      width <= 0 || height <= 0)
+    return FALSE;
+
+  scale = gdk_surface_get_scale_factor (subsurface->parent);
+  if (self->viewport == NULL &&
+      (gdk_texture_get_width (texture) != width * scale ||
+       gdk_texture_get_height (texture) != height * scale))
+    return FALSE;
+
+  buffer = get_wl_buffer (display, GDK_DMABUF_TEXTURE (texture));
+  if (buffer == NULL)
+    return FALSE;
+
+  /* A new frame of a video that stays in place is shown right away,
+   * everything else waits for the parent, so it can draw whatever
+   * the subsurface uncovers in the same frame */
+  if (subsurface->texture != NULL &&
+      x == self->x && y == self->y && width == self->width && height == self->height)
+    {
+      if (self->synchronized)
+        {
+          wl_subsurface_set_desync (self->wl_subsurface);
+          self->synchronized = FALSE;
+        }
+    }
+  else
+    {
+      if (!self->synchronized)
+        {
+          wl_subsurface_set_sync (self->wl_subsurface);
+          self->synchronized = TRUE;
+        }
+      wl_subsurface_set_position (self->wl_subsurface, x, y);
+    }
+
+  wl_surface_attach (self->wl_surface, buffer, 0, 0);
+
+  if (self->viewport)
+    wp_viewport_set_destination (self->viewport, width, height);
+  else if (display->compositor_version >= WL_SURFACE_HAS_BUFFER_SCALE)
+    wl_surface_set_buffer_scale (self->wl_surface, scale);
+
+  if (fourcc == GDK_DRM_FORMAT_XRGB8888 || fourcc == GDK_DRM_FORMAT_XBGR8888)
+    {
+      struct wl_region *region = wl_compositor_create_region (display->compositor);
+
+      wl_region_add (region, 0, 0, width, height);
+      wl_surface_set_opaque_region (self->wl_surface, region);
+      wl_region_destroy (region);
+    }
+  else
+    {
+      wl_surface_set_opaque_region (self->wl_surface, NULL);
+    }
+
+  wl_surface_damage (self->wl_surface, 0, 0, width, height);
+  wl_surface_commit (self->wl_surface);
+
+  self->x = x;
+  self->y = y;
+  self->width = width;
+  self->height = height;
+
+  return TRUE;
+}
+
+static void
+gdk_wayland_subsurface_detach (GdkSubsurface *subsurface)
+{
+  GdkWaylandSubsurface *self = GDK_WAYLAND_SUBSURFACE (subsurface);
+
+  /* Unmap together with the parent frame that draws the texture again */
+  if (!self->synchronized)
+    {
+      wl_subsurface_set_sync (self->wl_subsurface);
+      self->synchronized = TRUE;
+    }
+
+  wl_surface_attach (self->wl_surface, NULL, 0, 0);
+  wl_surface_commit (self->wl_surface);
+}
+
+static void
+gdk_wayland_subsurface_class_init (GdkWaylandSubsurfaceClass *class)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (class);
+  GdkSubsurfaceClass *subsurface_class = GDK_SUBSURFACE_CLASS (class);
+
+  object_class->finalize = gdk_wayland_subsurface_finalize;
+
+  subsurface_class->attach = gdk_wayland_subsurface_attach;
+  subsurface_class->detach = gdk_wayland_subsurface_detach;
+}
+
+static void
+gdk_wayland_subsurface_init (GdkWaylandSubsurface *self)
+{
+}
+
+GdkSubsurface *
+gdk_wayland_surface_create_subsurface (GdkSurface *surface)
+{
+  GdkWaylandDisplay *display = GDK_WAYLAND_DISPLAY (gdk_surface_get_display (surface));
+  struct wl_surface *parent = gdk_wayland_surface_get_wl_surface (surface);
+  GdkWaylandSubsurface *self;
+  struct wl_region *region;
+
+  if (parent == NULL ||
+      display->subcompositor == NULL ||
+      display->linux_dmabuf == NULL)
+    return NULL;
+
+  self = g_object_new (GDK_TYPE_WAYLAND_SUBSURFACE, NULL);
+
+  self->wl_surface = wl_compositor_create_surface (display->compositor);
+  self->wl_subsurface = wl_subcompositor_get_subsurface (display->subcompositor,
+                                                         self->wl_surface,
+                                                         parent);
+  self->synchronized = TRUE;
+
+  if (display->viewporter)
+    self->viewport = wp_viewporter_get_viewport (display->viewporter, self->wl_surface);
+
+  /* Input goes to the parent */
+  region = wl_compositor_create_region (display->compositor);
+  wl_surface_set_input_region (self->wl_surface, region);
+  wl_region_destroy (region);
+
+  return GDK_SUBSURFACE (self);
+}
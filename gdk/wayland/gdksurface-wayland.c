@@ -41,6 +41,7 @@
 #include <errno.h>
 
 #include <netinet/in.h>
+#include <time.h>
 #include <unistd.h>
 
 #define SURFACE_IS_TOPLEVEL(surface)  TRUE
@@ -120,6 +121,7 @@ struct _GdkWaylandSurface
   GdkSeat *grab_input_seat;
 
   gint64 pending_frame_counter;
+  GList *presentation_feedbacks;
   guint32 scale;
 
   int shadow_left;
@@ -503,6 +505,21 @@ finish_pending_relayout (GdkSurface *surface)
   thaw_popup_toplevel_state (surface);
 }
 
+static void
+complete_timings (GdkFrameClock   *clock,
+                  GdkFrameTimings *timings)
+{
+  timings->complete = TRUE;
+
+#ifdef G_ENABLE_DEBUG
+  if ((_gdk_debug_flags & GDK_DEBUG_FRAMES) != 0)
+    _gdk_frame_clock_debug_print_timings (clock, timings);
+#endif
+
+  if (GDK_PROFILER_IS_RUNNING)
+    _gdk_frame_clock_add_timings_to_profiler (clock, timings);
+}
+
 static void
 frame_callback (void               *data,
                 struct wl_callback *callback,
@@ -566,21 +583,110 @@ frame_callback (void               *data,
 
   fill_presentation_time_from_frame_time (timings, time);
 
-  timings->complete = TRUE;
-
-#ifdef G_ENABLE_DEBUG
-  if ((_gdk_debug_flags & GDK_DEBUG_FRAMES) != 0)
-    _gdk_frame_clock_debug_print_timings (clock, timings);
-#endif
+  /* The compositor tells us the actual time later */
+  if (display_wayland->presentation)
+    return;
 
-  if (GDK_PROFILER_IS_RUNNING)
-    _gdk_frame_clock_add_timings_to_profiler (clock, timings);
+  complete_timings (clock, timings);
 }
 
 static const struct wl_callback_listener frame_listener = {
   frame_callback
 };
 
+typedef struct {
+  GdkSurface *surface;
+  struct wp_presentation_feedback *feedback;
+  gint64 frame_counter;
+} PresentationFeedback;
+
+static void
+presentation_feedback_free (PresentationFeedback *data)
+{
+  GdkWaylandSurface *impl = GDK_WAYLAND_SURFACE (data->surface);
+
+  impl->presentation_feedbacks = g_list_remove (impl->presentation_feedbacks, data);
+  wp_presentation_feedback_destroy (data->feedback);
+  g_free (data);
+}
+
+static void
+presentation_feedback_sync_output (void                            *data,
+                                   struct wp_presentation_feedback *feedback,
+                                   struct wl_output                *output)
+{
+}
+
+static void
+presentation_feedback_presented (void                            *data,
+                                 struct wp_presentation_feedback *feedback,
+                                 uint32_t                         tv_sec_hi,
+                                 uint32_t                         tv_sec_lo,
+                                 uint32_t                         tv_nsec,
+                                 uint32_t                         refresh,
+                                 uint32_t                         seq_hi,
+                                 uint32_t                         seq_lo,
+                                 uint32_t                         flags)
+{
+  PresentationFeedback *presentation = data;
+  GdkSurface *surface = presentation->surface;
+  GdkWaylandDisplay *display_wayland = GDK_WAYLAND_DISPLAY (gdk_surface_get_display (surface));
+  GdkFrameClock *clock = gdk_surface_get_frame_clock (surface);
+  GdkFrameTimings *timings;
+
+  timings = gdk_frame_clock_get_timings (clock, presentation->frame_counter);
+  presentation_feedback_free (presentation);
+
+  if (timings == NULL)
+    return;
+
+  /* Our timestamps come from g_get_monotonic_time() */
+  if (display_wayland->presentation_clock_id == CLOCK_MONOTONIC)
+    {
+      guint64 sec = ((guint64) tv_sec_hi << 32) | tv_sec_lo;
+
+      timings->presentation_time = sec * G_USEC_PER_SEC + tv_nsec / 1000;
+      timings->presentation_time_is_reported = TRUE;
+    }
+
+  /* Zero for outputs without a fixed refresh rate */
+  if (refresh != 0)
+    timings->refresh_interval = refresh / 1000;
+
+  complete_timings (clock, timings);
+}
+
+static void
+presentation_feedback_discarded (void                            *data,
+                                 struct wp_presentation_feedback *feedback)
+{
+  PresentationFeedback *presentation = data;
+  GdkSurface *surface = presentation->surface;
+  GdkFrameClock *clock = gdk_surface_get_frame_clock (surface);
+  GdkFrameTimings *timings;
+
+  timings = gdk_frame_clock_get_timings (clock, presentation->frame_counter);
+  presentation_feedback_free (presentation);
+
+  /* The frame was never shown, so we keep the presentation time
+   * that was guessed from the frame callback */
+  if (timings)
+    complete_timings (clock, timings);
+}
+
+static const struct wp_presentation_feedback_listener presentation_feedback_listener = {
+  presentation_feedback_sync_output,
+  presentation_feedback_presented,
+  presentation_feedback_discarded
+};
+
+static void
+clear_presentation_feedbacks (GdkWaylandSurface *impl)
+{
+  while (impl->presentation_feedbacks)
+    presentation_feedback_free (impl->presentation_feedbacks->data);
+}
+
 static void
 on_frame_clock_before_paint (GdkFrameClock *clock,
                              GdkSurface     *surface)
@@ -671,6 +777,7 @@ void
 gdk_wayland_surface_request_frame (GdkSurface *surface)
 {
   GdkWaylandSurface *impl = GDK_WAYLAND_SURFACE (surface);
+  GdkWaylandDisplay *display_wayland = GDK_WAYLAND_DISPLAY (gdk_surface_get_display (surface));
   struct wl_callback *callback;
   GdkFrameClock *clock;
 
@@ -684,6 +791,21 @@ gdk_wayland_surface_request_frame (GdkSurface *surface)
   wl_callback_add_listener (callback, &frame_listener, surface);
   impl->pending_frame_counter = gdk_frame_clock_get_frame_counter (clock);
   impl->awaiting_frame = TRUE;
+
+  if (display_wayland->presentation)
+    {
+      PresentationFeedback *presentation = g_new (PresentationFeedback, 1);
+
+      presentation->surface = surface;
+      presentation->frame_counter = impl->pending_frame_counter;
+      presentation->feedback = wp_presentation_feedback (display_wayland->presentation,
+                                                         impl->display_server.wl_surface);
+      wl_proxy_set_queue ((struct wl_proxy *) presentation->feedback, NULL);
+      wp_presentation_feedback_add_listener (presentation->feedback,
+                                             &presentation_feedback_listener,
+                                             presentation);
+      impl->presentation_feedbacks = g_list_prepend (impl->presentation_feedbacks, presentation);
+    }
 }
 
 gboolean
@@ -2917,6 +3039,8 @@ gdk_wayland_surface_hide_surface (GdkSurface *surface)
           gdk_surface_thaw_updates (surface);
         }
 
+      clear_presentation_feedbacks (impl);
+
       if (GDK_IS_POPUP (surface))
         {
           switch (impl->popup_state)
@@ -4164,6 +4288,7 @@ gdk_wayland_surface_class_init (GdkWaylandSurfaceClass *klass)
   impl_class->create_gl_context = gdk_wayland_surface_create_gl_context;
   impl_class->request_layout = gdk_wayland_surface_request_layout;
   impl_class->compute_size = gdk_wayland_surface_compute_size;
+  impl_class->create_subsurface = gdk_wayland_surface_create_subsurface;
 }
 
 void
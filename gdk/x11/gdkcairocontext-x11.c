@@ -23,15 +23,348 @@
 #include "gdkcairocontext-x11.h"
 
 #include "gdkprivate-x11.h"
+#include "gdkdisplay-x11.h"
 
 #include "gdkcairo.h"
 #include "gdksurfaceprivate.h"
 #include "gdkinternals.h"
 
 #include <X11/Xlib.h>
+#include <X11/extensions/XShm.h>
+#ifdef HAVE_XPRESENT
+#include <X11/extensions/Xfixes.h>
+#include <X11/extensions/Xpresent.h>
+#endif
+
+#include <sys/ipc.h>
+#include <sys/shm.h>
+
+/* With MIT-SHM, we render into shared memory with the image backend
+ * and have the server copy the painted region to the window, instead
+ * of sending every image over the wire. With Present, the server does
+ * that at vblank, but keeps reading the buffer until it tells us it is
+ * idle, so we keep a few buffers and redraw what changed since a buffer
+ * was last used. Without MIT-SHM, e.g. on remote displays, we draw with
+ * Xlib as before.
+ */
+#define MAX_SHM_BUFFERS 3
+
+struct _GdkX11ShmBuffer
+{
+  XShmSegmentInfo shm_info;
+  XImage *image;
+  Pixmap pixmap;
+  cairo_surface_t *surface;
+  cairo_region_t *damage; /* drawn into other buffers since this one was used */
+  gulong serial;          /* without Present, the last request reading the buffer */
+  guint busy : 1;         /* presented and not idle yet */
+};
 
 G_DEFINE_TYPE (GdkX11CairoContext, gdk_x11_cairo_context, GDK_TYPE_CAIRO_CONTEXT)
 
+static gboolean
+use_present (GdkX11Display *display_x11)
+{
+#ifdef HAVE_XPRESENT
+  return display_x11->have_present && display_x11->have_shm_pixmaps;
+#else
+  return FALSE;
+#endif
+}
+
+static void
+gdk_x11_shm_buffer_free (GdkX11Display   *display_x11,
+                         GdkX11ShmBuffer *buffer)
+{
+  cairo_surface_destroy (buffer->surface);
+  cairo_region_destroy (buffer->damage);
+
+  /* The server keeps the segment alive while a Present still uses it */
+  if (buffer->pixmap)
+    XFreePixmap (display_x11->xdisplay, buffer->pixmap);
+  XShmDetach (display_x11->xdisplay, &buffer->shm_info);
+  shmdt (buffer->shm_info.shmaddr);
+
+  buffer->image->data = NULL;
+  XDestroyImage (buffer->image);
+
+  g_free (buffer);
+}
+
+static GdkX11ShmBuffer *
+gdk_x11_shm_buffer_new (GdkSurface *surface,
+                        int         width,
+                        int         height,
+                        int         scale)
+{
+  GdkDisplay *display = gdk_surface_get_display (surface);
+  GdkX11Display *display_x11 = GDK_X11_DISPLAY (display);
+  Display *xdisplay = display_x11->xdisplay;
+  Visual *visual = gdk_x11_display_get_window_visual (display_x11);
+  int depth = gdk_x11_display_get_window_depth (display_x11);
+  GdkX11ShmBuffer *buffer;
+  gboolean failed;
+
+  /* We need something cairo's image backend can draw to directly */
+  if ((depth != 24 && depth != 32) ||
+      visual->red_mask != 0xff0000 ||
+      visual->green_mask != 0xff00 ||
+      visual->blue_mask != 0xff)
+    return NULL;
+
+  buffer = g_new0 (GdkX11ShmBuffer, 1);
+
+  buffer->image = XShmCreateImage (xdisplay, visual, depth, ZPixmap, NULL,
+                                   &buffer->shm_info,
+                                   width * scale, height * scale);
+  if (buffer->image == NULL)
+    {
+      g_free (buffer);
+      return NULL;
+    }
+
+  if (buffer->image->bits_per_pixel != 32 ||
+      buffer->image->byte_order != (G_BYTE_ORDER == G_LITTLE_ENDIAN ? LSBFirst : MSBFirst))
+    goto fail_image;
+
+  buffer->shm_info.shmid = shmget (IPC_PRIVATE,
+                                   buffer->image->bytes_per_line * buffer->image->height,
+                                   IPC_CREAT | 0600);
+  if (buffer->shm_info.shmid == -1)
+    goto fail_image;
+
+  buffer->shm_info.shmaddr = shmat (buffer->shm_info.shmid, NULL, 0);
+  if (buffer->shm_info.shmaddr == (char *) -1)
+    {
+      shmctl (buffer->shm_info.shmid, IPC_RMID, NULL);
+      goto fail_image;
+    }
+
+  buffer->image->data = buffer->shm_info.shmaddr;
+  buffer->shm_info.readOnly = True;
+
+  gdk_x11_display_error_trap_push (display);
+  XShmAttach (xdisplay, &buffer->shm_info);
+  XSync (xdisplay, False);
+  failed = gdk_x11_display_error_trap_pop (display);
+
+  /* The segment goes away once both of us have detached */
+  shmctl (buffer->shm_info.shmid, IPC_RMID, NULL);
+
+  if (failed)
+    {
+      /* The server can't get at our memory, so don't try again */
+      GDK_DISPLAY_NOTE (display, MISC, g_message ("MIT-SHM is not usable, drawing with Xlib"));
+      display_x11->have_shm = FALSE;
+      shmdt (buffer->shm_info.shmaddr);
+      goto fail_image;
+    }
+
+  if (use_present (display_x11))
+    buffer->pixmap = XShmCreatePixmap (xdisplay, GDK_SURFACE_XID (surface),
+                                       buffer->shm_info.shmaddr, &buffer->shm_info,
+                                       buffer->image->width, buffer->image->height,
+                                       depth);
+
+  buffer->surface = cairo_image_surface_create_for_data ((guchar *) buffer->shm_info.shmaddr,
+                                                         depth == 32 ? CAIRO_FORMAT_ARGB32 : CAIRO_FORMAT_RGB24,
+                                                         buffer->image->width,
+                                                         buffer->image->height,
+                                                         buffer->image->bytes_per_line);
+  cairo_surface_set_device_scale (buffer->surface, scale, scale);
+
+  /* Nothing in it is valid yet */
+  buffer->damage = cairo_region_create_rectangle (&(cairo_rectangle_int_t) { 0, 0, width, height });
+
+  return buffer;
+
+fail_image:
+  buffer->image->data = NULL;
+  XDestroyImage (buffer->image);
+  g_free (buffer);
+  return NULL;
+}
+
+static void
+gdk_x11_cairo_context_clear_shm_buffers (GdkX11CairoContext *self)
+{
+  GdkDrawContext *draw_context = GDK_DRAW_CONTEXT (self);
+  GdkX11Display *display_x11 = GDK_X11_DISPLAY (gdk_draw_context_get_display (draw_context));
+  guint i;
+
+  if (self->shm_buffers == NULL)
+    return;
+
+  for (i = 0; i < self->shm_buffers->len; i++)
+    gdk_x11_shm_buffer_free (display_x11, g_ptr_array_index (self->shm_buffers, i));
+
+  g_ptr_array_set_size (self->shm_buffers, 0);
+}
+
+#ifdef HAVE_XPRESENT
+static gboolean
+gdk_x11_cairo_context_xevent (GdkX11Display      *display_x11,
+                              const XEvent       *xevent,
+                              GdkX11CairoContext *self)
+{
+  const XPresentIdleNotifyEvent *idle;
+  guint i;
+
+  if (xevent->type != GenericEvent ||
+      xevent->xcookie.extension != display_x11->present_opcode ||
+      xevent->xcookie.evtype != PresentIdleNotify ||
+      xevent->xcookie.data == NULL)
+    return FALSE;
+
+  idle = xevent->xcookie.data;
+  if (idle->eid != self->present_event)
+    return FALSE;
+
+  for (i = 0; i < self->shm_buffers->len; i++)
+    {
+      GdkX11ShmBuffer *buffer = g_ptr_array_index (self->shm_buffers, i);
+
+      if (buffer->pixmap == idle->pixmap)
+        buffer->busy = FALSE;
+    }
+
+  return FALSE;
+}
+#endif
+
+static GdkX11ShmBuffer *
+gdk_x11_cairo_context_get_shm_buffer (GdkX11CairoContext *self,
+                                      GdkSurface         *surface)
+{
+  GdkX11Display *display_x11 = GDK_X11_DISPLAY (gdk_surface_get_display (surface));
+  GdkX11ShmBuffer *buffer;
+  int width, height, scale;
+  guint i;
+
+  if (!display_x11->have_shm)
+    return NULL;
+
+  width = gdk_surface_get_width (surface);
+  height = gdk_surface_get_height (surface);
+  scale = gdk_surface_get_scale_factor (surface);
+
+  if (width != self->shm_width || height != self->shm_height || scale != self->shm_scale)
+    {
+      gdk_x11_cairo_context_clear_shm_buffers (self);
+      self->shm_width = width;
+      self->shm_height = height;
+      self->shm_scale = scale;
+    }
+
+  if (!use_present (display_x11))
+    {
+      if (self->shm_buffers->len == 0)
+        {
+          buffer = gdk_x11_shm_buffer_new (surface, width, height, scale);
+          if (buffer == NULL)
+            return NULL;
+          g_ptr_array_add (self->shm_buffers, buffer);
+        }
+
+      /* Make sure the server is done copying the last frame */
+      buffer = g_ptr_array_index (self->shm_buffers, 0);
+      if (LastKnownRequestProcessed (display_x11->xdisplay) < buffer->serial)
+        XSync (display_x11->xdisplay, False);
+
+      return buffer;
+    }
+
+#ifdef HAVE_XPRESENT
+  if (self->present_event == None)
+    {
+      self->present_event = XPresentSelectInput (display_x11->xdisplay,
+                                                 GDK_SURFACE_XID (surface),
+                                                 PresentIdleNotifyMask);
+      self->xevent_handler = g_signal_connect (display_x11, "xevent",
+                                               G_CALLBACK (gdk_x11_cairo_context_xevent), self);
+    }
+#endif
+
+  for (i = 0; i < self->shm_buffers->len; i++)
+    {
+      buffer = g_ptr_array_index (self->shm_buffers, i);
+      if (!buffer->busy)
+        return buffer;
+    }
+
+  if (self->shm_buffers->len >= MAX_SHM_BUFFERS)
+    return NULL;
+
+  buffer = gdk_x11_shm_buffer_new (surface, width, height, scale);
+  if (buffer)
+    g_ptr_array_add (self->shm_buffers, buffer);
+
+  return buffer;
+}
+
+static void
+gdk_x11_cairo_context_present_shm_buffer (GdkX11CairoContext *self,
+                                          GdkSurface         *surface,
+                                          GdkX11ShmBuffer    *buffer,
+                                          cairo_region_t     *painted)
+{
+  GdkX11Display *display_x11 = GDK_X11_DISPLAY (gdk_surface_get_display (surface));
+  Display *xdisplay = display_x11->xdisplay;
+  Window xid = GDK_SURFACE_XID (surface);
+  int scale = self->shm_scale;
+  XRectangle *rects;
+  int i, n_rects;
+
+  cairo_surface_flush (buffer->surface);
+
+  n_rects = cairo_region_num_rectangles (painted);
+  rects = g_newa (XRectangle, n_rects);
+  for (i = 0; i < n_rects; i++)
+    {
+      cairo_rectangle_int_t rect;
+
+      cairo_region_get_rectangle (painted, i, &rect);
+      rects[i].x = rect.x * scale;
+      rects[i].y = rect.y * scale;
+      rects[i].width = rect.width * scale;
+      rects[i].height = rect.height * scale;
+    }
+
+#ifdef HAVE_XPRESENT
+  if (buffer->pixmap)
+    {
+      XserverRegion update;
+
+      update = XFixesCreateRegion (xdisplay, rects, n_rects);
+      XPresentPixmap (xdisplay, xid, buffer->pixmap, self->present_serial++,
+                      None, update,
+                      0, 0,
+                      None, None, None,
+                      PresentOptionNone,
+                      0, 0, 0,
+                      NULL, 0);
+      XFixesDestroyRegion (xdisplay, update);
+
+      buffer->busy = TRUE;
+      XFlush (xdisplay);
+      return;
+    }
+#endif
+
+  if (self->gc == NULL)
+    self->gc = XCreateGC (xdisplay, xid, 0, NULL);
+
+  for (i = 0; i < n_rects; i++)
+    XShmPutImage (xdisplay, xid, self->gc, buffer->image,
+                  rects[i].x, rects[i].y,
+                  rects[i].x, rects[i].y,
+                  rects[i].width, rects[i].height,
+                  False);
+
+  buffer->serial = NextRequest (xdisplay) - 1;
+  XFlush (xdisplay);
+}
+
 static cairo_surface_t *
 create_cairo_surface_for_surface (GdkSurface *surface)
 {
@@ -62,8 +395,26 @@ gdk_x11_cairo_context_begin_frame (GdkDrawContext *draw_context,
   GdkRectangle clip_box;
   GdkSurface *surface;
   double sx, sy;
+  cairo_t *cr;
 
   surface = gdk_draw_context_get_surface (draw_context);
+
+  self->current_buffer = gdk_x11_cairo_context_get_shm_buffer (self, surface);
+  if (self->current_buffer)
+    {
+      /* Redraw what the buffer missed while others were on screen */
+      cairo_region_union (region, self->current_buffer->damage);
+      self->paint_surface = cairo_surface_reference (self->current_buffer->surface);
+
+      /* clear the repaint area */
+      cr = cairo_create (self->paint_surface);
+      cairo_set_operator (cr, CAIRO_OPERATOR_CLEAR);
+      gdk_cairo_region (cr, region);
+      cairo_fill (cr);
+      cairo_destroy (cr);
+      return;
+    }
+
   cairo_region_get_extents (region, &clip_box);
 
   self->window_surface = create_cairo_surface_for_surface (surface);
@@ -83,6 +434,29 @@ gdk_x11_cairo_context_end_frame (GdkDrawContext *draw_context,
 {
   GdkX11CairoContext *self = GDK_X11_CAIRO_CONTEXT (draw_context);
   cairo_t *cr;
+  guint i;
+
+  /* Whatever we didn't draw into, is out of date now */
+  for (i = 0; i < self->shm_buffers->len; i++)
+    {
+      GdkX11ShmBuffer *buffer = g_ptr_array_index (self->shm_buffers, i);
+
+      if (buffer == self->current_buffer)
+        cairo_region_subtract (buffer->damage, buffer->damage);
+      else
+        cairo_region_union (buffer->damage, painted);
+    }
+
+  if (self->current_buffer)
+    {
+      gdk_x11_cairo_context_present_shm_buffer (self,
+                                                gdk_draw_context_get_surface (draw_context),
+                                                self->current_buffer,
+                                                painted);
+      self->current_buffer = NULL;
+      g_clear_pointer (&self->paint_surface, cairo_surface_destroy);
+      return;
+    }
 
   cr = cairo_create (self->window_surface);
 
@@ -109,14 +483,47 @@ gdk_x11_cairo_context_cairo_create (GdkCairoContext *context)
   return cairo_create (self->paint_surface);
 }
 
+static void
+gdk_x11_cairo_context_surface_resized (GdkDrawContext *draw_context)
+{
+  gdk_x11_cairo_context_clear_shm_buffers (GDK_X11_CAIRO_CONTEXT (draw_context));
+}
+
+static void
+gdk_x11_cairo_context_dispose (GObject *object)
+{
+  GdkX11CairoContext *self = GDK_X11_CAIRO_CONTEXT (object);
+  GdkDisplay *display = gdk_draw_context_get_display (GDK_DRAW_CONTEXT (self));
+
+  if (self->shm_buffers)
+    {
+      gdk_x11_cairo_context_clear_shm_buffers (self);
+      g_clear_pointer (&self->shm_buffers, g_ptr_array_unref);
+    }
+
+  if (self->gc)
+    {
+      XFreeGC (GDK_DISPLAY_XDISPLAY (display), self->gc);
+      self->gc = NULL;
+    }
+
+  g_clear_signal_handler (&self->xevent_handler, display);
+
+  G_OBJECT_CLASS (gdk_x11_cairo_context_parent_class)->dispose (object);
+}
+
 static void
 gdk_x11_cairo_context_class_init (GdkX11CairoContextClass *klass)
 {
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
   GdkDrawContextClass *draw_context_class = GDK_DRAW_CONTEXT_CLASS (klass);
   GdkCairoContextClass *cairo_context_class = GDK_CAIRO_CONTEXT_CLASS (klass);
 
+  gobject_class->dispose = gdk_x11_cairo_context_dispose;
+
   draw_context_class->begin_frame = gdk_x11_cairo_context_begin_frame;
   draw_context_class->end_frame = gdk_x11_cairo_context_end_frame;
+  draw_context_class->surface_resized = gdk_x11_cairo_context_surface_resized;
 
   cairo_context_class->cairo_create = gdk_x11_cairo_context_cairo_create;
 }
@@ -124,5 +531,6 @@ gdk_x11_cairo_context_class_init (GdkX11CairoContextClass *klass)
 static void
 gdk_x11_cairo_context_init (GdkX11CairoContext *self)
 {
+  self->shm_buffers = g_ptr_array_new ();
 }
 
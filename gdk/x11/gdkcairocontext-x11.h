@@ -25,6 +25,8 @@
 
 #include "gdkcairocontextprivate.h"
 
+#include <X11/Xlib.h>
+
 G_BEGIN_DECLS
 
 #define GDK_TYPE_X11_CAIRO_CONTEXT		(gdk_x11_cairo_context_get_type ())
@@ -36,6 +38,7 @@ G_BEGIN_DECLS
 
 typedef struct _GdkX11CairoContext GdkX11CairoContext;
 typedef struct _GdkX11CairoContextClass GdkX11CairoContextClass;
+typedef struct _GdkX11ShmBuffer GdkX11ShmBuffer;
 
 struct _GdkX11CairoContext
 {
@@ -43,6 +46,17 @@ struct _GdkX11CairoContext
 
   cairo_surface_t *window_surface;
   cairo_surface_t *paint_surface;
+
+  /* MIT-SHM path */
+  GPtrArray *shm_buffers;
+  GdkX11ShmBuffer *current_buffer;
+  int shm_width;
+  int shm_height;
+  int shm_scale;
+  GC gc;
+  XID present_event;
+  guint32 present_serial;
+  gulong xevent_handler;
 };
 
 struct _GdkX11CairoContextClass
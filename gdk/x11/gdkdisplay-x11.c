@@ -73,6 +73,12 @@
 #include <X11/extensions/Xcomposite.h>
 #endif
 
+#include <X11/extensions/XShm.h>
+
+#ifdef HAVE_XPRESENT
+#include <X11/extensions/Xpresent.h>
+#endif
+
 #ifdef HAVE_RANDR
 #include <X11/extensions/Xrandr.h>
 #endif
@@ -1214,7 +1220,10 @@ _gdk_wm_protocols_filter (const XEvent  *xevent,
               gint32 refresh_interval = d3;
 
               if (timings->drawn_time && presentation_time_offset)
-                timings->presentation_time = timings->drawn_time + presentation_time_offset;
+                {
+                  timings->presentation_time = timings->drawn_time + presentation_time_offset;
+                  timings->presentation_time_is_reported = TRUE;
+                }
 
               if (refresh_interval)
                 timings->refresh_interval = refresh_interval;
@@ -1603,6 +1612,32 @@ gdk_x11_display_open (const char *display_name)
     display_x11->have_damage = TRUE;
 #endif
 
+  /* This only tells us that the server has the extension, if it
+   * is remote, attaching a segment fails later in the cairo context */
+  {
+    int major, minor;
+    Bool pixmaps;
+
+    if (XShmQueryVersion (display_x11->xdisplay, &major, &minor, &pixmaps))
+      {
+        display_x11->have_shm = TRUE;
+        display_x11->have_shm_pixmaps = pixmaps && XShmPixmapFormat (display_x11->xdisplay) == ZPixmap;
+      }
+  }
+
+#ifdef HAVE_XPRESENT
+  {
+    int major = 1, minor = 0, event_base, error_base;
+
+    display_x11->have_present =
+      display_x11->have_xfixes &&
+      XPresentQueryExtension (display_x11->xdisplay,
+                              &display_x11->present_opcode,
+                              &event_base, &error_base) &&
+      XPresentQueryVersion (display_x11->xdisplay, &major, &minor);
+  }
+#endif
+
   display->clipboard = gdk_x11_clipboard_new (display, "CLIPBOARD");
   display->primary_clipboard = gdk_x11_clipboard_new (display, "PRIMARY");
 
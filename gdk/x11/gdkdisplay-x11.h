@@ -156,6 +156,15 @@ struct _GdkX11Display
   int damage_error_base;
   guint have_damage;
 #endif
+
+  /* MIT-SHM, for software rendering into shared memory */
+  guint have_shm : 1;
+  guint have_shm_pixmaps : 1;
+
+#ifdef HAVE_XPRESENT
+  int present_opcode;
+  guint have_present : 1;
+#endif
 };
 
 struct _GdkX11DisplayClass
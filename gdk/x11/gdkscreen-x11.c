@@ -435,6 +435,41 @@ translate_subpixel_order (int subpixel)
     }
 }
 
+/* The kernel's "vrr_capable" connector property, which the
+ * modesetting and amdgpu drivers expose on the RandR output */
+static gboolean
+output_is_vrr_capable (Display  *xdisplay,
+                       RROutput  output)
+{
+  Atom vrr_atom, actual_type;
+  int actual_format;
+  unsigned long nitems, bytes_left;
+  unsigned char *prop = NULL;
+  gboolean result = FALSE;
+
+  vrr_atom = XInternAtom (xdisplay, "vrr_capable", True);
+  if (vrr_atom == None)
+    return FALSE;
+
+  if (XRRGetOutputProperty (xdisplay, output,
+                            vrr_atom,
+                            0, 1,
+                            False, False,
+                            XA_INTEGER,
+                            &actual_type,
+                            &actual_format,
+                            &nitems,
+                            &bytes_left,
+                            &prop) == Success &&
+      actual_type == XA_INTEGER && actual_format == 32 && nitems == 1)
+    result = *(long *) prop != 0;
+
+  if (prop)
+    XFree (prop);
+
+  return result;
+}
+
 static gboolean
 init_randr15 (GdkX11Screen *x11_screen)
 {
@@ -590,6 +625,8 @@ init_randr15 (GdkX11Screen *x11_screen)
       gdk_monitor_set_subpixel_layout (GDK_MONITOR (monitor),
                                        translate_subpixel_order (output_info->subpixel_order));
       gdk_monitor_set_refresh_rate (GDK_MONITOR (monitor), refresh_rate);
+      gdk_monitor_set_variable_refresh (GDK_MONITOR (monitor),
+                                        output_is_vrr_capable (x11_screen->xdisplay, output));
       gdk_monitor_set_scale_factor (GDK_MONITOR (monitor), x11_screen->surface_scale);
       gdk_monitor_set_model (GDK_MONITOR (monitor), name);
       gdk_monitor_set_connector (GDK_MONITOR (monitor), name);
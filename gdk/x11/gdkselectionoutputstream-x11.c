@@ -224,6 +224,23 @@ get_element_size (int format)
     }
 }
 
+/* Only take as much data as fits into the next property change, so
+ * that big transfers don't get copied in full before the requestor
+ * asked for the first chunk. write_all() will come back with the rest. */
+static gsize
+gdk_x11_selection_output_stream_accept_unlocked (GdkX11SelectionOutputStream *stream,
+                                                 gsize                        count)
+{
+  GdkX11SelectionOutputStreamPrivate *priv = gdk_x11_selection_output_stream_get_instance_private (stream);
+  gsize max_size;
+
+  max_size = gdk_x11_display_get_max_request_size (priv->display);
+  if (priv->data->len >= max_size)
+    return MIN (count, 1);
+
+  return MIN (count, max_size - priv->data->len);
+}
+
 static void
 gdk_x11_selection_output_stream_perform_flush (GdkX11SelectionOutputStream *stream)
 {
@@ -335,6 +352,7 @@ gdk_x11_selection_output_stream_write (GOutputStream  *output_stream,
   GdkX11SelectionOutputStreamPrivate *priv = gdk_x11_selection_output_stream_get_instance_private (stream);
 
   g_mutex_lock (&priv->mutex);
+  count = gdk_x11_selection_output_stream_accept_unlocked (stream, count);
   g_byte_array_append (priv->data, buffer, count);
   GDK_NOTE (SELECTION, g_printerr ("%s:%s: wrote %zu bytes, %u total now\n",
                                   priv->selection, priv->target, count, priv->data->len));
@@ -368,6 +386,7 @@ gdk_x11_selection_output_stream_write_async (GOutputStream        *output_stream
   g_task_set_priority (task, io_priority);
 
   g_mutex_lock (&priv->mutex);
+  count = gdk_x11_selection_output_stream_accept_unlocked (stream, count);
   g_byte_array_append (priv->data, buffer, count);
   GDK_NOTE (SELECTION, g_printerr ("%s:%s: async wrote %zu bytes, %u total now\n",
                                   priv->selection, priv->target, count, priv->data->len));
@@ -10,6 +10,27 @@
 #include "gskrendernodeprivate.h"
 #include "gdk/gdktextureprivate.h"
 
+#include <pango/pangocairo.h>
+
+/* The glyph cache is dropped when it grows beyond this */
+#define MAX_CACHED_GLYPHS 4096
+
+typedef struct {
+  PangoFont *font;
+  PangoGlyph glyph;
+  int scale;
+} GlyphKey;
+
+/* A glyph rendered in white, in device pixels. The browser uses
+ * it as mask for the color of the text node, so the same texture
+ * works for every color and position the glyph is drawn at. */
+typedef struct {
+  GlyphKey key;
+  GdkTexture *texture; /* NULL if the glyph has no ink */
+  int x, y; /* of the texture, relative to the glyph origin */
+  int width, height;
+} CachedGlyph;
+
 struct _GskBroadwayRenderer
 {
   GskRenderer parent_instance;
@@ -24,6 +45,9 @@ struct _GskBroadwayRenderer
   /* Kept from last frame */
   GHashTable *last_node_lookup;
   GskRenderNode *last_root; /* Owning refs to the things in last_node_lookup */
+
+  /* Kept until unrealize, so the textures stay uploaded */
+  GHashTable *glyph_cache;
 };
 
 struct _GskBroadwayRendererClass
@@ -56,6 +80,7 @@ static void
 gsk_broadway_renderer_unrealize (GskRenderer *renderer)
 {
   GskBroadwayRenderer *self = GSK_BROADWAY_RENDERER (renderer);
+  g_clear_pointer (&self->glyph_cache, g_hash_table_unref);
   g_clear_object (&self->draw_context);
 }
 
@@ -216,6 +241,88 @@ add_string (GArray *nodes, const char *str)
     add_uint32 (nodes, v);
 }
 
+static guint
+glyph_key_hash (gconstpointer v)
+{
+  const GlyphKey *key = v;
+
+  return g_direct_hash (key->font) ^ key->glyph ^ (key->scale << 24);
+}
+
+static gboolean
+glyph_key_equal (gconstpointer v1,
+                 gconstpointer v2)
+{
+  const GlyphKey *key1 = v1;
+  const GlyphKey *key2 = v2;
+
+  return key1->font == key2->font &&
+         key1->glyph == key2->glyph &&
+         key1->scale == key2->scale;
+}
+
+static void
+cached_glyph_free (CachedGlyph *cached)
+{
+  g_object_unref (cached->key.font);
+  g_clear_object (&cached->texture);
+  g_free (cached);
+}
+
+static CachedGlyph *
+get_cached_glyph (GskBroadwayRenderer *self,
+                  PangoFont           *font,
+                  PangoGlyph           glyph,
+                  int                  scale)
+{
+  GlyphKey key = { font, glyph, scale };
+  CachedGlyph *cached;
+  PangoRectangle ink;
+
+  if (self->glyph_cache == NULL)
+    self->glyph_cache = g_hash_table_new_full (glyph_key_hash, glyph_key_equal,
+                                               NULL, (GDestroyNotify) cached_glyph_free);
+
+  cached = g_hash_table_lookup (self->glyph_cache, &key);
+  if (cached)
+    return cached;
+
+  cached = g_new0 (CachedGlyph, 1);
+  cached->key.font = g_object_ref (font);
+  cached->key.glyph = glyph;
+  cached->key.scale = scale;
+
+  pango_font_get_glyph_extents (font, glyph, &ink, NULL);
+  if (ink.width > 0 && ink.height > 0)
+    {
+      PangoGlyphInfo glyph_info = { glyph, { 0, 0, 0 }, { 1 } };
+      PangoGlyphString glyphs = { 1, &glyph_info, NULL };
+      cairo_surface_t *surface;
+      cairo_t *cr;
+
+      /* Leave a pixel for antialiasing on each side */
+      cached->x = floor ((double) ink.x * scale / PANGO_SCALE) - 1;
+      cached->y = floor ((double) ink.y * scale / PANGO_SCALE) - 1;
+      cached->width = ceil ((double) (ink.x + ink.width) * scale / PANGO_SCALE) + 1 - cached->x;
+      cached->height = ceil ((double) (ink.y + ink.height) * scale / PANGO_SCALE) + 1 - cached->y;
+
+      surface = cairo_image_surface_create (CAIRO_FORMAT_ARGB32, cached->width, cached->height);
+      cr = cairo_create (surface);
+      cairo_translate (cr, - cached->x, - cached->y);
+      cairo_scale (cr, scale, scale);
+      cairo_set_source_rgb (cr, 1, 1, 1);
+      pango_cairo_show_glyph_string (cr, font, &glyphs);
+      cairo_destroy (cr);
+
+      cached->texture = gdk_texture_new_for_surface (surface);
+      cairo_surface_destroy (surface);
+    }
+
+  g_hash_table_insert (self->glyph_cache, &cached->key, cached);
+
+  return cached;
+}
+
 static void
 collect_reused_child_nodes (GskRenderer *renderer,
                             GskRenderNode *node);
@@ -256,18 +363,16 @@ collect_reused_child_nodes (GskRenderer *renderer,
     case GSK_OUTSET_SHADOW_NODE:
     case GSK_INSET_SHADOW_NODE:
     case GSK_LINEAR_GRADIENT_NODE:
+    case GSK_RADIAL_GRADIENT_NODE:
+    case GSK_REPEATING_RADIAL_GRADIENT_NODE:
+    case GSK_CONIC_GRADIENT_NODE:
+    case GSK_TEXT_NODE:
 
       /* Fallbacks (=> leaf for now */
     case GSK_GL_SHADER_NODE:
     case GSK_COLOR_MATRIX_NODE:
-    case GSK_TEXT_NODE:
-    case GSK_RADIAL_GRADIENT_NODE:
     case GSK_REPEATING_LINEAR_GRADIENT_NODE:
-    case GSK_REPEATING_RADIAL_GRADIENT_NODE:
-    case GSK_CONIC_GRADIENT_NODE:
     case GSK_REPEAT_NODE:
-    case GSK_BLEND_NODE:
-    case GSK_CROSS_FADE_NODE:
     case GSK_BLUR_NODE:
 
     default:
@@ -314,6 +419,20 @@ collect_reused_child_nodes (GskRenderer *renderer,
                              gsk_container_node_get_child (node, i));
       break;
 
+    case GSK_BLEND_NODE:
+      collect_reused_node (renderer,
+                           gsk_blend_node_get_bottom_child (node));
+      collect_reused_node (renderer,
+                           gsk_blend_node_get_top_child (node));
+      break;
+
+    case GSK_CROSS_FADE_NODE:
+      collect_reused_node (renderer,
+                           gsk_cross_fade_node_get_start_child (node));
+      collect_reused_node (renderer,
+                           gsk_cross_fade_node_get_end_child (node));
+      break;
+
       break; /* Fallback */
     }
 }
@@ -350,7 +469,9 @@ node_type_is_container (BroadwayNodeType type)
     type == BROADWAY_NODE_CLIP ||
     type == BROADWAY_NODE_TRANSFORM ||
     type == BROADWAY_NODE_DEBUG ||
-    type == BROADWAY_NODE_CONTAINER;
+    type == BROADWAY_NODE_CONTAINER ||
+    type == BROADWAY_NODE_BLEND ||
+    type == BROADWAY_NODE_CROSS_FADE;
 }
 
 static gboolean
@@ -676,6 +797,96 @@ gsk_broadway_renderer_add_node (GskRenderer *renderer,
         }
       return;
 
+    case GSK_RADIAL_GRADIENT_NODE:
+    case GSK_REPEATING_RADIAL_GRADIENT_NODE:
+      if (add_new_node (renderer, node, BROADWAY_NODE_RADIAL_GRADIENT, clip_bounds))
+        {
+          guint i, n;
+
+          add_rect (nodes, &node->bounds, offset_x, offset_y);
+          add_point (nodes, gsk_radial_gradient_node_get_center (node), offset_x, offset_y);
+          add_float (nodes, gsk_radial_gradient_node_get_hradius (node));
+          add_float (nodes, gsk_radial_gradient_node_get_vradius (node));
+          add_float (nodes, gsk_radial_gradient_node_get_start (node));
+          add_float (nodes, gsk_radial_gradient_node_get_end (node));
+          add_uint32 (nodes, gsk_render_node_get_node_type (node) == GSK_REPEATING_RADIAL_GRADIENT_NODE);
+          n = gsk_radial_gradient_node_get_n_color_stops (node);
+          add_uint32 (nodes, n);
+          for (i = 0; i < n; i++)
+            add_color_stop (nodes, &gsk_radial_gradient_node_get_color_stops (node, NULL)[i]);
+        }
+      return;
+
+    case GSK_CONIC_GRADIENT_NODE:
+      if (add_new_node (renderer, node, BROADWAY_NODE_CONIC_GRADIENT, clip_bounds))
+        {
+          guint i, n;
+
+          add_rect (nodes, &node->bounds, offset_x, offset_y);
+          add_point (nodes, gsk_conic_gradient_node_get_center (node), offset_x, offset_y);
+          add_float (nodes, gsk_conic_gradient_node_get_rotation (node));
+          n = gsk_conic_gradient_node_get_n_color_stops (node);
+          add_uint32 (nodes, n);
+          for (i = 0; i < n; i++)
+            add_color_stop (nodes, &gsk_conic_gradient_node_get_color_stops (node, NULL)[i]);
+        }
+      return;
+
+    case GSK_TEXT_NODE:
+      /* Color glyphs can't be used as masks */
+      if (gsk_text_node_has_color_glyphs (node))
+        break; /* Fallback */
+
+      if (add_new_node (renderer, node, BROADWAY_NODE_TEXT, clip_bounds))
+        {
+          const PangoGlyphInfo *glyphs = gsk_text_node_get_glyphs (node, NULL);
+          const graphene_point_t *offset = gsk_text_node_get_offset (node);
+          PangoFont *font = gsk_text_node_get_font (node);
+          int scale = broadway_display->scale_factor;
+          guint i, placeholder;
+          guint32 n_glyphs = 0;
+          int x_position = 0;
+
+          add_rgba (nodes, gsk_text_node_get_color (node));
+          placeholder = add_uint32_placeholder (nodes);
+
+          /* Every glyph is sent as a reference to its cached texture,
+           * and snapped to device pixels, so that changed text only
+           * uploads glyphs that the browser hasn't seen yet. */
+          for (i = 0; i < gsk_text_node_get_num_glyphs (node); i++)
+            {
+              const PangoGlyphInfo *gi = &glyphs[i];
+              CachedGlyph *cached;
+              int x, y;
+
+              x = round ((offset->x + (double) (x_position + gi->geometry.x_offset) / PANGO_SCALE) * scale);
+              y = round ((offset->y + (double) gi->geometry.y_offset / PANGO_SCALE) * scale);
+              x_position += gi->geometry.width;
+
+              if (gi->glyph == PANGO_GLYPH_EMPTY)
+                continue;
+
+              cached = get_cached_glyph (self, font, gi->glyph, scale);
+              if (cached->texture == NULL)
+                continue;
+
+              /* Glyphs are not GskRenderNodes, so they are never reused on their own */
+              add_uint32 (nodes, BROADWAY_NODE_GLYPH);
+              add_uint32 (nodes, ++self->next_node_id);
+              add_xy (nodes,
+                      (float) (x + cached->x) / scale,
+                      (float) (y + cached->y) / scale,
+                      offset_x, offset_y);
+              add_float (nodes, (float) cached->width / scale);
+              add_float (nodes, (float) cached->height / scale);
+              add_uint32 (nodes, gdk_broadway_display_ensure_texture (display, cached->texture));
+              n_glyphs++;
+            }
+
+          set_uint32_at (nodes, placeholder, n_glyphs);
+        }
+      return;
+
       /* Bin nodes */
 
     case GSK_SHADOW_NODE:
@@ -824,6 +1035,32 @@ gsk_broadway_renderer_add_node (GskRenderer *renderer,
         }
       return;
 
+    case GSK_BLEND_NODE:
+      if (add_new_node (renderer, node, BROADWAY_NODE_BLEND, clip_bounds))
+        {
+          add_uint32 (nodes, gsk_blend_node_get_blend_mode (node));
+          gsk_broadway_renderer_add_node (renderer,
+                                          gsk_blend_node_get_bottom_child (node),
+                                          offset_x, offset_y, clip_bounds);
+          gsk_broadway_renderer_add_node (renderer,
+                                          gsk_blend_node_get_top_child (node),
+                                          offset_x, offset_y, clip_bounds);
+        }
+      return;
+
+    case GSK_CROSS_FADE_NODE:
+      if (add_new_node (renderer, node, BROADWAY_NODE_CROSS_FADE, clip_bounds))
+        {
+          add_float (nodes, gsk_cross_fade_node_get_progress (node));
+          gsk_broadway_renderer_add_node (renderer,
+                                          gsk_cross_fade_node_get_start_child (node),
+                                          offset_x, offset_y, clip_bounds);
+          gsk_broadway_renderer_add_node (renderer,
+                                          gsk_cross_fade_node_get_end_child (node),
+                                          offset_x, offset_y, clip_bounds);
+        }
+      return;
+
     case GSK_COLOR_MATRIX_NODE:
       {
         GskRenderNode *child = gsk_color_matrix_node_get_child (node);
@@ -845,14 +1082,8 @@ gsk_broadway_renderer_add_node (GskRenderer *renderer,
       }
       break; /* Fallback */
 
-    case GSK_TEXT_NODE:
-    case GSK_RADIAL_GRADIENT_NODE:
     case GSK_REPEATING_LINEAR_GRADIENT_NODE:
-    case GSK_REPEATING_RADIAL_GRADIENT_NODE:
-    case GSK_CONIC_GRADIENT_NODE:
     case GSK_REPEAT_NODE:
-    case GSK_BLEND_NODE:
-    case GSK_CROSS_FADE_NODE:
     case GSK_BLUR_NODE:
     case GSK_GL_SHADER_NODE:
     default:
@@ -906,6 +1137,10 @@ gsk_broadway_renderer_render (GskRenderer          *renderer,
 
   self->node_lookup = g_hash_table_new (g_direct_hash, g_direct_equal);
 
+  if (self->glyph_cache &&
+      g_hash_table_size (self->glyph_cache) > MAX_CACHED_GLYPHS)
+    g_hash_table_remove_all (self->glyph_cache);
+
   gdk_draw_context_begin_frame (GDK_DRAW_CONTEXT (self->draw_context), update_area);
 
   /* These are owned by the draw context between begin and end, but
@@ -4,12 +4,14 @@
 
 #include "gskdebugprivate.h"
 #include "gskprofilerprivate.h"
+#include "gskrendernodeprivate.h"
 #include "gdk/gdkglcontextprivate.h"
 #include "gdk/gdktextureprivate.h"
 #include "gdk/gdkgltextureprivate.h"
 #include "gdkmemorytextureprivate.h"
 
 #include <gdk/gdk.h>
+#include <gsk/gsk.h>
 #include <epoxy/gl.h>
 
  typedef struct {
@@ -33,6 +35,18 @@ typedef struct {
   guint n_slices;
 } Texture;
 
+/* Vertex data is streamed through a small ring of buffers so that
+ * uploading a frame never has to wait on the GPU still reading the
+ * buffer from the previous one. */
+#define N_VERTEX_BUFFERS 3
+
+typedef struct {
+  GLuint buffer_id;
+  gsize size;
+  gpointer mapping; /* Only set for persistently mapped buffers */
+  GLsync fence;
+} VertexBuffer;
+
 struct _GskGLDriver
 {
   GObject parent_instance;
@@ -50,17 +64,93 @@ struct _GskGLDriver
   GHashTable *textures;         /* texture_id -> Texture */
   GHashTable *pointer_textures; /* pointer -> texture_id */
 
+  GPtrArray *released_gl_textures; /* GdkGLTextures that want a fence after this frame */
+
   const Texture *bound_source_texture;
 
   int max_texture_size;
 
+  VertexBuffer vertex_buffers[N_VERTEX_BUFFERS];
+  guint current_vertex_buffer;
+
+  GLuint pixel_buffer_id;
+
   gboolean in_frame : 1;
+  gboolean features_checked : 1;
+  gboolean has_buffer_storage : 1;
+  gboolean has_sync : 1;
+  gboolean has_pixel_buffers : 1;
 };
 
 G_DEFINE_TYPE (GskGLDriver, gsk_gl_driver, G_TYPE_OBJECT)
 
+/* Textures at least this big are staged through a pixel buffer object */
+#define MIN_PIXEL_BUFFER_UPLOAD_SIZE (256 * 256 * 4)
+
 static void
-upload_gdk_texture (GdkTexture      *source_texture,
+upload_through_pixel_buffer (GskGLDriver     *self,
+                             const guchar    *data,
+                             int              width,
+                             int              height,
+                             gsize            stride,
+                             GdkMemoryFormat  data_format,
+                             int              target)
+{
+  GdkMemoryFormat staging_format;
+  gsize staging_stride;
+  gsize size;
+  guchar *mapping;
+
+  /* Use whatever format gdk_gl_context_upload_texture() can pass
+   * to GL without converting it on the CPU again */
+  staging_format = gdk_gl_context_get_upload_format (self->gl_context, data_format);
+  staging_stride = width * gdk_memory_format_bytes_per_pixel (staging_format);
+  size = staging_stride * height;
+
+  if (self->pixel_buffer_id == 0)
+    {
+      glGenBuffers (1, &self->pixel_buffer_id);
+      glBindBuffer (GL_PIXEL_UNPACK_BUFFER, self->pixel_buffer_id);
+      gdk_gl_context_label_object (self->gl_context, GL_BUFFER, self->pixel_buffer_id,
+                                   "Texture upload buffer");
+    }
+  else
+    {
+      glBindBuffer (GL_PIXEL_UNPACK_BUFFER, self->pixel_buffer_id);
+    }
+
+  /* Orphan the previous storage, so we never wait for a transfer
+   * that is still in flight */
+  glBufferData (GL_PIXEL_UNPACK_BUFFER, size, NULL, GL_STREAM_DRAW);
+  mapping = glMapBufferRange (GL_PIXEL_UNPACK_BUFFER, 0, size,
+                              GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+
+  if (mapping == NULL)
+    {
+      glBindBuffer (GL_PIXEL_UNPACK_BUFFER, 0);
+      gdk_gl_context_upload_texture (self->gl_context,
+                                     data, width, height, stride,
+                                     data_format, target);
+      return;
+    }
+
+  gdk_memory_convert (mapping, staging_stride, staging_format,
+                      data, stride, data_format,
+                      width, height);
+  glUnmapBuffer (GL_PIXEL_UNPACK_BUFFER);
+
+  /* With a pixel unpack buffer bound, the data pointer is an offset
+   * into it, and glTexImage2D() returns without waiting for the copy */
+  gdk_gl_context_upload_texture (self->gl_context,
+                                 NULL, width, height, staging_stride,
+                                 staging_format, target);
+
+  glBindBuffer (GL_PIXEL_UNPACK_BUFFER, 0);
+}
+
+static void
+upload_gdk_texture (GskGLDriver     *self,
+                    GdkTexture      *source_texture,
                     int              target,
                     int              x_offset,
                     int              y_offset,
@@ -98,10 +188,17 @@ upload_gdk_texture (GdkTexture      *source_texture,
 
   bpp = gdk_memory_format_bytes_per_pixel (data_format);
 
-  gdk_gl_context_upload_texture (gdk_gl_context_get_current (),
+  if (self->has_pixel_buffers &&
+      (gsize) width * height * 4 >= MIN_PIXEL_BUFFER_UPLOAD_SIZE)
+    upload_through_pixel_buffer (self,
                                  data + x_offset * bpp + y_offset * data_stride,
                                  width, height, data_stride,
                                  data_format, target);
+  else
+    gdk_gl_context_upload_texture (gdk_gl_context_get_current (),
+                                   data + x_offset * bpp + y_offset * data_stride,
+                                   width, height, data_stride,
+                                   data_format, target);
 
   if (surface)
     cairo_surface_destroy (surface);
@@ -161,15 +258,35 @@ gsk_gl_driver_set_texture_parameters (GskGLDriver *self,
   glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 }
 
+static void
+vertex_buffer_clear (VertexBuffer *vb)
+{
+  if (vb->fence != NULL)
+    glDeleteSync (vb->fence);
+
+  if (vb->buffer_id != 0)
+    glDeleteBuffers (1, &vb->buffer_id);
+
+  memset (vb, 0, sizeof (VertexBuffer));
+}
+
 static void
 gsk_gl_driver_finalize (GObject *gobject)
 {
   GskGLDriver *self = GSK_GL_DRIVER (gobject);
+  guint i;
 
   gdk_gl_context_make_current (self->gl_context);
 
+  for (i = 0; i < N_VERTEX_BUFFERS; i ++)
+    vertex_buffer_clear (&self->vertex_buffers[i]);
+
+  if (self->pixel_buffer_id != 0)
+    glDeleteBuffers (1, &self->pixel_buffer_id);
+
   g_clear_pointer (&self->textures, g_hash_table_unref);
   g_clear_pointer (&self->pointer_textures, g_hash_table_unref);
+  g_clear_pointer (&self->released_gl_textures, g_ptr_array_unref);
   g_clear_object (&self->profiler);
 
   if (self->gl_context == gdk_gl_context_get_current ())
@@ -190,6 +307,7 @@ static void
 gsk_gl_driver_init (GskGLDriver *self)
 {
   self->textures = g_hash_table_new_full (NULL, NULL, NULL, texture_free);
+  self->released_gl_textures = g_ptr_array_new_with_free_func (g_object_unref);
 
   self->max_texture_size = -1;
 
@@ -236,6 +354,36 @@ gsk_gl_driver_begin_frame (GskGLDriver *self)
       GSK_NOTE (OPENGL, g_message ("GL max texture size: %d", self->max_texture_size));
     }
 
+  if (!self->features_checked)
+    {
+      const int gl_version = epoxy_gl_version ();
+
+      if (gdk_gl_context_get_use_es (self->gl_context))
+        {
+          self->has_buffer_storage = FALSE;
+          self->has_sync = gl_version >= 30;
+          self->has_pixel_buffers = gl_version >= 30;
+        }
+      else
+        {
+          self->has_buffer_storage = gl_version >= 44 ||
+                                     epoxy_has_gl_extension ("GL_ARB_buffer_storage");
+          self->has_sync = gl_version >= 32 ||
+                           epoxy_has_gl_extension ("GL_ARB_sync");
+          self->has_pixel_buffers = gl_version >= 30 ||
+                                    epoxy_has_gl_extension ("GL_ARB_map_buffer_range");
+        }
+
+      /* Persistent mappings are only safe if we can fence them */
+      self->has_buffer_storage &= self->has_sync;
+      self->features_checked = TRUE;
+
+      GSK_NOTE (OPENGL, g_message ("Vertex buffers: %s",
+                                   self->has_buffer_storage ? "persistent mapping" : "orphaning"));
+      GSK_NOTE (OPENGL, g_message ("Pixel buffer uploads: %s",
+                                   self->has_pixel_buffers ? "yes" : "no"));
+    }
+
   glBindFramebuffer (GL_FRAMEBUFFER, 0);
 
   glActiveTexture (GL_TEXTURE0);
@@ -270,6 +418,17 @@ gsk_gl_driver_end_frame (GskGLDriver *self)
 
   self->default_fbo.fbo_id = 0;
 
+  /* One fence per texture, their producers delete them independently */
+  if (self->has_sync)
+    {
+      guint i;
+
+      for (i = 0; i < self->released_gl_textures->len; i++)
+        gdk_gl_texture_set_release_sync (g_ptr_array_index (self->released_gl_textures, i),
+                                         glFenceSync (GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+    }
+  g_ptr_array_set_size (self->released_gl_textures, 0);
+
 #ifdef G_ENABLE_DEBUG
   GSK_NOTE (OPENGL,
             g_message ("Textures created: %" G_GINT64_FORMAT "\n"
@@ -474,7 +633,7 @@ gsk_gl_driver_slice_texture (GskGLDriver   *self,
 #endif
           glBindTexture (GL_TEXTURE_2D, texture_id);
           gsk_gl_driver_set_texture_parameters (self, GL_NEAREST, GL_NEAREST);
-          upload_gdk_texture (texture, GL_TEXTURE_2D, x, y, slice_width, slice_height);
+          upload_gdk_texture (self, texture, GL_TEXTURE_2D, x, y, slice_width, slice_height);
 
 #ifdef G_ENABLE_DEBUG
           gsk_profiler_counter_inc (self->profiler, self->counters.surface_uploads);
@@ -508,6 +667,12 @@ gsk_gl_driver_slice_texture (GskGLDriver   *self,
   *out_n_slices = cols * rows;
 }
 
+static gboolean
+filter_uses_mipmaps (int filter)
+{
+  return filter != GL_NEAREST && filter != GL_LINEAR;
+}
+
 int
 gsk_gl_driver_get_texture_for_texture (GskGLDriver *self,
                                        GdkTexture  *texture,
@@ -526,7 +691,14 @@ gsk_gl_driver_get_texture_for_texture (GskGLDriver *self,
       if (texture_context == self->gl_context ||
           (gdk_gl_context_get_shared_context (texture_context) == shared_context && shared_context != NULL))
         {
-          /* A GL texture from the same GL context is a simple task... */
+          /* A GL texture from the same GL context is a simple task,
+           * we only need to synchronize with its producer */
+          gdk_gl_texture_wait_sync ((GdkGLTexture *)texture);
+
+          if (gdk_gl_texture_wants_release_sync ((GdkGLTexture *)texture) &&
+              !g_ptr_array_find (self->released_gl_textures, texture, NULL))
+            g_ptr_array_add (self->released_gl_textures, g_object_ref (texture));
+
           return gdk_gl_texture_get_id ((GdkGLTexture *)texture);
         }
       else
@@ -536,7 +708,10 @@ gsk_gl_driver_get_texture_for_texture (GskGLDriver *self,
           /* In this case, we have to temporarily make the texture's context the current one,
            * download its data into our context and then create a texture from it. */
           if (texture_context)
-            gdk_gl_context_make_current (texture_context);
+            {
+              gdk_gl_context_make_current (texture_context);
+              gdk_gl_texture_wait_sync ((GdkGLTexture *)texture);
+            }
 
           surface = gdk_texture_download_surface (texture);
           downloaded_texture = gdk_texture_new_for_surface (surface);
@@ -553,7 +728,12 @@ gsk_gl_driver_get_texture_for_texture (GskGLDriver *self,
 
       if (t)
         {
-          if (t->min_filter == min_filter && t->mag_filter == mag_filter)
+          /* A mipmapped texture also does for linear filtering,
+           * so a texture drawn at several scales isn't reuploaded.
+           */
+          if ((t->min_filter == min_filter ||
+               (min_filter == GL_LINEAR && filter_uses_mipmaps (t->min_filter))) &&
+              t->mag_filter == mag_filter)
             return t->texture_id;
         }
 
@@ -566,11 +746,26 @@ gsk_gl_driver_get_texture_for_texture (GskGLDriver *self,
     t->user = texture;
 
   gsk_gl_driver_bind_source_texture (self, t->texture_id);
-  gsk_gl_driver_init_texture (self,
-                              t->texture_id,
-                              source_texture,
-                              min_filter,
-                              mag_filter);
+
+  if (GDK_IS_DMABUF_TEXTURE (texture) &&
+      gdk_gl_context_import_dmabuf (self->gl_context, GDK_DMABUF_TEXTURE (texture), GL_TEXTURE_2D))
+    {
+      /* The imported image has no mipmaps we could generate */
+      gsk_gl_driver_set_texture_parameters (self,
+                                            filter_uses_mipmaps (min_filter) ? GL_LINEAR : min_filter,
+                                            mag_filter);
+      t->min_filter = min_filter;
+      t->mag_filter = mag_filter;
+    }
+  else
+    {
+      gsk_gl_driver_init_texture (self,
+                                  t->texture_id,
+                                  source_texture,
+                                  min_filter,
+                                  mag_filter);
+    }
+
   gdk_gl_context_label_object_printf (self->gl_context, GL_TEXTURE, t->texture_id,
                                       "GdkTexture<%p> %d", texture, t->texture_id);
 
@@ -585,7 +780,7 @@ texture_key_hash (gconstpointer v)
 {
   const GskTextureKey *k = (GskTextureKey *)v;
 
-  return GPOINTER_TO_UINT (k->pointer)
+  return gsk_render_node_hash (k->pointer)
          + (guint)(k->scale_x * 100)
          + (guint)(k->scale_y * 100)
          + (guint)k->filter * 2 +
@@ -598,7 +793,7 @@ texture_key_equal (gconstpointer v1, gconstpointer v2)
   const GskTextureKey *k1 = (GskTextureKey *)v1;
   const GskTextureKey *k2 = (GskTextureKey *)v2;
 
-  return k1->pointer == k2->pointer &&
+  return gsk_render_node_equal (k1->pointer, k2->pointer) &&
          k1->scale_x == k2->scale_x &&
          k1->scale_y == k2->scale_y &&
          k1->filter == k2->filter &&
@@ -606,14 +801,33 @@ texture_key_equal (gconstpointer v1, gconstpointer v2)
          (!k1->pointer_is_child || graphene_rect_equal (&k1->parent_rect, &k2->parent_rect));
 }
 
+/* Keys compare nodes by their contents, so a node that was built
+ * again still finds the texture. The key keeps its node alive, so
+ * the node it compares against stays valid while the texture exists. */
+static void
+texture_key_free (gpointer data)
+{
+  GskTextureKey *k = data;
+
+  gsk_render_node_unref (k->pointer);
+  g_free (k);
+}
+
+static void
+ensure_pointer_textures (GskGLDriver *self)
+{
+  if (G_UNLIKELY (self->pointer_textures == NULL))
+    self->pointer_textures = g_hash_table_new_full (texture_key_hash, texture_key_equal,
+                                                    texture_key_free, NULL);
+}
+
 int
 gsk_gl_driver_get_texture_for_key (GskGLDriver   *self,
                                    GskTextureKey *key)
 {
   int id = 0;
 
-  if (G_UNLIKELY (self->pointer_textures == NULL))
-    self->pointer_textures = g_hash_table_new_full (texture_key_hash, texture_key_equal, g_free, NULL);
+  ensure_pointer_textures (self);
 
   id = GPOINTER_TO_INT (g_hash_table_lookup (self->pointer_textures, key));
 
@@ -637,11 +851,11 @@ gsk_gl_driver_set_texture_for_key (GskGLDriver   *self,
 {
   GskTextureKey *k;
 
-  if (G_UNLIKELY (self->pointer_textures == NULL))
-    self->pointer_textures = g_hash_table_new_full (texture_key_hash, texture_key_equal, g_free, NULL);
+  ensure_pointer_textures (self);
 
   k = g_new (GskTextureKey, 1);
   *k = *key;
+  gsk_render_node_ref (k->pointer);
 
   g_hash_table_insert (self->pointer_textures, k, GINT_TO_POINTER (texture_id));
 }
@@ -806,12 +1020,6 @@ gsk_gl_driver_init_texture_empty (GskGLDriver *self,
   glBindTexture (GL_TEXTURE_2D, 0);
 }
 
-static gboolean
-filter_uses_mipmaps (int filter)
-{
-  return filter != GL_NEAREST && filter != GL_LINEAR;
-}
-
 void
 gsk_gl_driver_init_texture (GskGLDriver     *self,
                             int              texture_id,
@@ -838,7 +1046,7 @@ gsk_gl_driver_init_texture (GskGLDriver     *self,
 
   gsk_gl_driver_set_texture_parameters (self, min_filter, mag_filter);
 
-  upload_gdk_texture (texture, GL_TEXTURE_2D, 0, 0, t->width, t->height);
+  upload_gdk_texture (self, texture, GL_TEXTURE_2D, 0, 0, t->width, t->height);
 
 #ifdef G_ENABLE_DEBUG
   gsk_profiler_counter_inc (self->profiler, self->counters.surface_uploads);
@@ -850,3 +1058,104 @@ gsk_gl_driver_init_texture (GskGLDriver     *self,
   if (filter_uses_mipmaps (t->min_filter))
     glGenerateMipmap (GL_TEXTURE_2D);
 }
+
+static void
+vertex_buffer_wait (VertexBuffer *vb)
+{
+  if (vb->fence == NULL)
+    return;
+
+  /* With three buffers in flight this is expected to be signaled already */
+  glClientWaitSync (vb->fence, GL_SYNC_FLUSH_COMMANDS_BIT, G_GUINT64_CONSTANT (1000000000));
+  glDeleteSync (vb->fence);
+  vb->fence = NULL;
+}
+
+static void
+vertex_buffer_allocate (GskGLDriver  *self,
+                        VertexBuffer *vb,
+                        gsize         size)
+{
+  const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+  vertex_buffer_clear (vb);
+
+  /* Round up so small growth doesn't reallocate every frame */
+  vb->size = 64 * 1024;
+  while (vb->size < size)
+    vb->size *= 2;
+
+  glGenBuffers (1, &vb->buffer_id);
+  glBindBuffer (GL_ARRAY_BUFFER, vb->buffer_id);
+  gdk_gl_context_label_object_printf (self->gl_context, GL_BUFFER, vb->buffer_id,
+                                      "Vertex buffer %u", self->current_vertex_buffer);
+
+  if (self->has_buffer_storage)
+    {
+      glBufferStorage (GL_ARRAY_BUFFER, vb->size, NULL, flags);
+      vb->mapping = glMapBufferRange (GL_ARRAY_BUFFER, 0, vb->size, flags);
+    }
+  else
+    {
+      glBufferData (GL_ARRAY_BUFFER, vb->size, NULL, GL_STREAM_DRAW);
+    }
+}
+
+/**
+ * gsk_gl_driver_upload_vertices:
+ * @self: a #GskGLDriver
+ * @data: the vertex data
+ * @size: size of @data in bytes
+ *
+ * Copies @data into the next buffer of the vertex ring and leaves
+ * that buffer bound to %GL_ARRAY_BUFFER. Call
+ * gsk_gl_driver_release_vertices() once all draws reading from it
+ * have been submitted.
+ */
+void
+gsk_gl_driver_upload_vertices (GskGLDriver   *self,
+                               gconstpointer  data,
+                               gsize          size)
+{
+  VertexBuffer *vb;
+
+  g_return_if_fail (GSK_IS_GL_DRIVER (self));
+  g_return_if_fail (self->in_frame);
+
+  self->current_vertex_buffer = (self->current_vertex_buffer + 1) % N_VERTEX_BUFFERS;
+  vb = &self->vertex_buffers[self->current_vertex_buffer];
+
+  vertex_buffer_wait (vb);
+
+  if (vb->buffer_id == 0 || vb->size < size)
+    vertex_buffer_allocate (self, vb, size);
+  else
+    glBindBuffer (GL_ARRAY_BUFFER, vb->buffer_id);
+
+  if (size == 0)
+    return;
+
+  if (vb->mapping != NULL)
+    {
+      memcpy (vb->mapping, data, size);
+    }
+  else
+    {
+      /* Orphan the old storage so the driver doesn't stall on it */
+      glBufferData (GL_ARRAY_BUFFER, vb->size, NULL, GL_STREAM_DRAW);
+      glBufferSubData (GL_ARRAY_BUFFER, 0, size, data);
+    }
+}
+
+void
+gsk_gl_driver_release_vertices (GskGLDriver *self)
+{
+  VertexBuffer *vb;
+
+  g_return_if_fail (GSK_IS_GL_DRIVER (self));
+
+  vb = &self->vertex_buffers[self->current_vertex_buffer];
+
+  if (self->has_sync && vb->fence == NULL)
+    vb->fence = glFenceSync (GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
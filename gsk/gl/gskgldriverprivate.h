@@ -14,6 +14,7 @@ G_DECLARE_FINAL_TYPE (GskGLDriver, gsk_gl_driver, GSK, GL_DRIVER, GObject)
 typedef struct {
   float position[2];
   float uv[2];
+  float color[4]; /* Only used by the color and coloring programs */
 } GskQuadVertex;
 
 typedef struct {
@@ -22,7 +23,7 @@ typedef struct {
 } TextureSlice;
 
 typedef struct {
-  gpointer pointer;
+  gpointer pointer; /* A GskRenderNode, referenced while cached */
   float scale_x;
   float scale_y;
   int filter;
@@ -75,6 +76,11 @@ void            gsk_gl_driver_init_texture              (GskGLDriver     *driver
 void            gsk_gl_driver_destroy_texture           (GskGLDriver     *driver,
                                                          int              texture_id);
 
+void            gsk_gl_driver_upload_vertices           (GskGLDriver     *driver,
+                                                         gconstpointer    data,
+                                                         gsize            size);
+void            gsk_gl_driver_release_vertices          (GskGLDriver     *driver);
+
 int             gsk_gl_driver_collect_textures          (GskGLDriver     *driver);
 void            gsk_gl_driver_slice_texture             (GskGLDriver     *self,
                                                          GdkTexture      *texture,
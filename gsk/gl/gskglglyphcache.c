@@ -13,6 +13,7 @@
 #include <cairo.h>
 #include <epoxy/gl.h>
 #include <string.h>
+#include <math.h>
 
 /* Cache eviction strategy
  *
@@ -20,10 +21,16 @@
  * Every few frames, we mark glyphs that haven't been
  * accessed since the last check as old.
  *
+ * On top of that, if the glyphs in the atlases take up
+ * more than the cache budget, the least recently used
+ * ones are marked as old too, until we're back within
+ * the budget.
+ *
  * We keep count of the pixels of each atlas that are
  * taken up by old data. When the fraction of old pixels
- * gets too high, we drop the atlas and all the items it
- * contained.
+ * gets too high, we drop the atlas. Glyphs on it that are
+ * still in use are copied over to another atlas on the GPU,
+ * everything else is dropped.
  *
  * Big glyphs are not stored in the atlas, they get their
  * own texture, but they are still cached.
@@ -31,6 +38,17 @@
 
 #define MAX_FRAME_AGE (60)
 #define MAX_GLYPH_SIZE 128 /* Will get its own texture if bigger */
+#define DEFAULT_BUDGET (4 * 1024 * 1024) /* In bytes, can be changed with GSK_GLYPH_CACHE_SIZE */
+
+/* Text that is at least SDF_MIN_SIZE pixels big on screen is drawn
+ * from signed distance fields. Those are rendered once per glyph, with
+ * the em box SDF_SIZE pixels big and the distance clamped at SDF_SPREAD
+ * pixels, and serve every scale the text gets drawn at.
+ */
+#define SDF_MIN_SIZE 64
+#define SDF_SIZE 64
+#define SDF_SPREAD 8
+#define SDF_INF 1e20f
 
 static guint    glyph_cache_hash       (gconstpointer v);
 static gboolean glyph_cache_equal      (gconstpointer v1,
@@ -52,6 +70,15 @@ gsk_gl_glyph_cache_new (GdkDisplay *display,
 
   glyph_cache->atlases = gsk_gl_texture_atlases_ref (atlases);
 
+  glyph_cache->max_atlas_pixels = DEFAULT_BUDGET / 4;
+  if (g_getenv ("GSK_GLYPH_CACHE_SIZE"))
+    {
+      guint64 budget = g_ascii_strtoull (g_getenv ("GSK_GLYPH_CACHE_SIZE"), NULL, 10);
+
+      if (budget > 0)
+        glyph_cache->max_atlas_pixels = MIN (budget / 4, G_MAXINT);
+    }
+
   glyph_cache->ref_count = 1;
 
   return glyph_cache;
@@ -110,6 +137,157 @@ glyph_cache_value_free (gpointer v)
   g_free (v);
 }
 
+/* The size of the area the glyph takes up on its atlas, including the border */
+static inline void
+glyph_get_packed_size (const GlyphCacheKey    *key,
+                       const GskGLCachedGlyph *value,
+                       int                    *width,
+                       int                    *height)
+{
+  *width = value->draw_width * key->data.scale / 1024 + 2;
+  *height = value->draw_height * key->data.scale / 1024 + 2;
+}
+
+static inline void
+glyph_mark_unused (const GlyphCacheKey *key,
+                   GskGLCachedGlyph    *value)
+{
+  int width, height;
+
+  glyph_get_packed_size (key, value, &width, &height);
+  gsk_gl_texture_atlas_mark_unused (value->atlas, width, height);
+  value->used = FALSE;
+}
+
+/* Felzenszwalb & Huttenlocher, squared euclidean distance transform
+ * of the sampled function @f into @d. @v and @z are scratch space of
+ * n and n + 1 elements. */
+static void
+distance_transform_1d (const float *f,
+                       float       *d,
+                       int         *v,
+                       float       *z,
+                       int          n)
+{
+  int q, k = 0;
+
+  v[0] = 0;
+  z[0] = -SDF_INF;
+  z[1] = SDF_INF;
+
+  for (q = 1; q < n; q++)
+    {
+      float s = ((f[q] + q * q) - (f[v[k]] + v[k] * v[k])) / (2 * q - 2 * v[k]);
+
+      while (s <= z[k])
+        {
+          k--;
+          s = ((f[q] + q * q) - (f[v[k]] + v[k] * v[k])) / (2 * q - 2 * v[k]);
+        }
+
+      k++;
+      v[k] = q;
+      z[k] = s;
+      z[k + 1] = SDF_INF;
+    }
+
+  k = 0;
+  for (q = 0; q < n; q++)
+    {
+      while (z[k + 1] < q)
+        k++;
+
+      d[q] = (q - v[k]) * (q - v[k]) + f[v[k]];
+    }
+}
+
+static void
+distance_transform (float *grid,
+                    int    width,
+                    int    height)
+{
+  const int n = MAX (width, height);
+  float *f = g_new (float, n);
+  float *d = g_new (float, n);
+  float *z = g_new (float, n + 1);
+  int *v = g_new (int, n);
+  int x, y;
+
+  for (x = 0; x < width; x++)
+    {
+      for (y = 0; y < height; y++)
+        f[y] = grid[y * width + x];
+
+      distance_transform_1d (f, d, v, z, height);
+
+      for (y = 0; y < height; y++)
+        grid[y * width + x] = d[y];
+    }
+
+  for (y = 0; y < height; y++)
+    {
+      memcpy (f, &grid[y * width], sizeof (float) * width);
+      distance_transform_1d (f, &grid[y * width], v, z, width);
+    }
+
+  g_free (f);
+  g_free (d);
+  g_free (z);
+  g_free (v);
+}
+
+/* Replaces the rendered glyph coverage in @data by its signed distance
+ * field, with 0.5 on the outline and bigger values inside the glyph. */
+static void
+convert_to_sdf (guchar *data,
+                int     width,
+                int     height,
+                int     stride)
+{
+  float *outside = g_new (float, width * height); /* distance to the glyph */
+  float *inside = g_new (float, width * height);  /* distance to the background */
+  int x, y;
+
+  for (y = 0; y < height; y++)
+    {
+      const guint32 *row = (const guint32 *) (data + y * stride);
+
+      for (x = 0; x < width; x++)
+        {
+          gboolean covered = (row[x] >> 24) >= 128;
+
+          outside[y * width + x] = covered ? 0 : SDF_INF;
+          inside[y * width + x] = covered ? SDF_INF : 0;
+        }
+    }
+
+  distance_transform (outside, width, height);
+  distance_transform (inside, width, height);
+
+  for (y = 0; y < height; y++)
+    {
+      guint32 *row = (guint32 *) (data + y * stride);
+
+      for (x = 0; x < width; x++)
+        {
+          float dist = sqrtf (outside[y * width + x]) - sqrtf (inside[y * width + x]);
+          guint32 value;
+
+          /* The outline runs between pixel centers */
+          if (dist > 0)
+            dist -= 0.5f;
+          else
+            dist += 0.5f;
+
+          value = (guint32) (CLAMP (0.5f - dist / (2 * SDF_SPREAD), 0.0f, 1.0f) * 255.f + 0.5f);
+          row[x] = (value << 24) | (value << 16) | (value << 8) | value;
+        }
+    }
+
+  g_free (outside);
+  g_free (inside);
+}
+
 static gboolean
 render_glyph (GlyphCacheKey    *key,
               GskGLCachedGlyph *value,
@@ -148,12 +326,17 @@ render_glyph (GlyphCacheKey    *key,
 
   glyph_info.glyph = key->data.glyph;
   glyph_info.geometry.width = value->draw_width * 1024;
-  if (glyph_info.glyph & PANGO_GLYPH_UNKNOWN_FLAG)
+  if ((glyph_info.glyph & PANGO_GLYPH_UNKNOWN_FLAG) && !key->data.sdf)
     glyph_info.geometry.x_offset = 0;
   else
     glyph_info.geometry.x_offset = - value->draw_x * 1024;
   glyph_info.geometry.y_offset = - value->draw_y * 1024;
 
+  /* The position is snapped to the pixel grid when drawing, so the
+   * subpixel phase of the key has to be baked into the glyph */
+  glyph_info.geometry.x_offset += key->data.xshift * (PANGO_SCALE / 4);
+  glyph_info.geometry.y_offset += key->data.yshift * (PANGO_SCALE / 4);
+
   glyph_string.num_glyphs = 1;
   glyph_string.glyphs = &glyph_info;
 
@@ -162,6 +345,9 @@ render_glyph (GlyphCacheKey    *key,
 
   cairo_surface_flush (surface);
 
+  if (key->data.sdf)
+    convert_to_sdf (data, surface_width, surface_height, stride);
+
   region->width = cairo_image_surface_get_width (surface);
   region->height = cairo_image_surface_get_height (surface);
   region->stride = cairo_image_surface_get_stride (surface);
@@ -272,7 +458,77 @@ add_to_cache (GskGLGlyphCache  *self,
   upload_glyph (key, value);
 }
 
-void
+static float
+get_font_pixel_size (PangoFont *font)
+{
+  static GQuark quark;
+  gpointer size;
+
+  if (G_UNLIKELY (quark == 0))
+    quark = g_quark_from_static_string ("gsk-gl-font-pixel-size");
+
+  size = g_object_get_qdata (G_OBJECT (font), quark);
+  if (size == NULL)
+    {
+      PangoFontDescription *desc = pango_font_describe_with_absolute_size (font);
+      int pango_size = pango_font_description_get_size (desc);
+
+      pango_font_description_free (desc);
+
+      /* Store it off by one, so zero sized fonts are cached too */
+      size = GINT_TO_POINTER (pango_size + 1);
+      g_object_set_qdata (G_OBJECT (font), quark, size);
+    }
+
+  return (float) (GPOINTER_TO_INT (size) - 1) / PANGO_SCALE;
+}
+
+/**
+ * gsk_gl_glyph_cache_get_sdf_scale:
+ * @self: a #GskGLGlyphCache
+ * @font: the font to draw
+ * @text_scale: the scale the text is drawn at
+ * @sdf_scale: (out): return location for the scale of the cached glyphs
+ *
+ * Decides whether glyphs of @font are drawn from signed distance fields
+ * at @text_scale. If so, glyphs should be looked up with the sdf bit set
+ * in the key and @sdf_scale as the key's scale, no matter what the actual
+ * text scale is.
+ *
+ * Returns: %TRUE if distance fields should be used
+ */
+gboolean
+gsk_gl_glyph_cache_get_sdf_scale (GskGLGlyphCache *self,
+                                  PangoFont       *font,
+                                  float            text_scale,
+                                  float           *sdf_scale)
+{
+  float size;
+
+  if (!self->use_sdf)
+    return FALSE;
+
+  size = get_font_pixel_size (font);
+  if (size <= 0 || size * text_scale < SDF_MIN_SIZE)
+    return FALSE;
+
+  *sdf_scale = SDF_SIZE / size;
+
+  return TRUE;
+}
+
+/**
+ * gsk_gl_glyph_cache_lookup_or_add:
+ * @cache: a #GskGLGlyphCache
+ * @lookup: the glyph to look up
+ * @driver: the driver to create textures with
+ * @cached_glyph_out: (out): return location for the cached glyph
+ *
+ * Looks up a glyph, rendering and uploading it if it isn't cached yet.
+ *
+ * Returns: %TRUE if the glyph was already cached
+ */
+gboolean
 gsk_gl_glyph_cache_lookup_or_add (GskGLGlyphCache         *cache,
                                   GlyphCacheKey           *lookup,
                                   GskGLDriver             *driver,
@@ -286,13 +542,17 @@ gsk_gl_glyph_cache_lookup_or_add (GskGLGlyphCache         *cache,
     {
       if (value->atlas && !value->used)
         {
-          gsk_gl_texture_atlas_mark_used (value->atlas, value->draw_width, value->draw_height);
+          int width, height;
+
+          glyph_get_packed_size (lookup, value, &width, &height);
+          gsk_gl_texture_atlas_mark_used (value->atlas, width, height);
           value->used = TRUE;
         }
       value->accessed = TRUE;
+      value->last_used = cache->timestamp;
 
       *cached_glyph_out = value;
-      return;
+      return TRUE;
     }
 
   {
@@ -306,6 +566,17 @@ gsk_gl_glyph_cache_lookup_or_add (GskGLGlyphCache         *cache,
     if (lookup->data.yshift != 0)
       ink_rect.height += 1;
 
+    if (lookup->data.sdf && lookup->data.scale > 0)
+      {
+        /* Leave room for the distance field around the outline */
+        const int pad = ceilf (SDF_SPREAD * 1024.0f / lookup->data.scale);
+
+        ink_rect.x -= pad;
+        ink_rect.y -= pad;
+        ink_rect.width += 2 * pad;
+        ink_rect.height += 2 * pad;
+      }
+
     value = g_new0 (GskGLCachedGlyph, 1);
 
     value->draw_x = ink_rect.x;
@@ -313,6 +584,7 @@ gsk_gl_glyph_cache_lookup_or_add (GskGLGlyphCache         *cache,
     value->draw_width = ink_rect.width;
     value->draw_height = ink_rect.height;
     value->accessed = TRUE;
+    value->last_used = cache->timestamp;
     value->atlas = NULL; /* For now */
 
     key = g_new0 (GlyphCacheKey, 1);
@@ -322,6 +594,7 @@ gsk_gl_glyph_cache_lookup_or_add (GskGLGlyphCache         *cache,
     key->data.xshift = lookup->data.xshift;
     key->data.yshift = lookup->data.yshift;
     key->data.scale = lookup->data.scale;
+    key->data.sdf = lookup->data.sdf;
     key->hash = lookup->hash;
 
     if (key->data.scale > 0 &&
@@ -332,6 +605,61 @@ gsk_gl_glyph_cache_lookup_or_add (GskGLGlyphCache         *cache,
     *cached_glyph_out = value;
     g_hash_table_insert (cache->hash_table, key, value);
   }
+
+  return FALSE;
+}
+
+/* Copies a glyph that is still in use from the atlas that is
+ * currently attached to the bound read framebuffer into a live
+ * atlas, and updates @value to point to its new location */
+static void
+relocate_glyph (GskGLGlyphCache  *self,
+                GlyphCacheKey    *key,
+                GskGLCachedGlyph *value)
+{
+  GskGLTextureAtlas *old_atlas = value->atlas;
+  GskGLTextureAtlas *atlas = NULL;
+  int old_x, old_y;
+  int packed_x = 0;
+  int packed_y = 0;
+  int width, height;
+
+  glyph_get_packed_size (key, value, &width, &height);
+  old_x = (int) roundf (value->tx * old_atlas->width) - 1;
+  old_y = (int) roundf (value->ty * old_atlas->height) - 1;
+
+  gsk_gl_texture_atlases_pack (self->atlases, width, height, &atlas, &packed_x, &packed_y);
+
+  glBindTexture (GL_TEXTURE_2D, atlas->texture_id);
+  glCopyTexSubImage2D (GL_TEXTURE_2D, 0,
+                       packed_x, packed_y,
+                       old_x, old_y,
+                       width, height);
+
+  value->tx = (float)(packed_x + 1) / atlas->width;
+  value->ty = (float)(packed_y + 1) / atlas->height;
+  value->tw = (float)(width - 2) / atlas->width;
+  value->th = (float)(height - 2) / atlas->height;
+
+  value->atlas = atlas;
+  value->texture_id = atlas->texture_id;
+}
+
+static int
+compare_last_used (gconstpointer a,
+                   gconstpointer b,
+                   gpointer      user_data)
+{
+  GHashTable *hash_table = user_data;
+  const GskGLCachedGlyph *ga = g_hash_table_lookup (hash_table, *(GlyphCacheKey **) a);
+  const GskGLCachedGlyph *gb = g_hash_table_lookup (hash_table, *(GlyphCacheKey **) b);
+
+  if (ga->last_used < gb->last_used)
+    return -1;
+  else if (ga->last_used > gb->last_used)
+    return 1;
+
+  return 0;
 }
 
 void
@@ -343,24 +671,54 @@ gsk_gl_glyph_cache_begin_frame (GskGLGlyphCache *self,
   GlyphCacheKey *key;
   GskGLCachedGlyph *value;
   guint dropped = 0;
+  guint relocated = 0;
 
   self->timestamp++;
 
   if (removed_atlases->len > 0)
     {
-      g_hash_table_iter_init (&iter, self->hash_table);
-      while (g_hash_table_iter_next (&iter, (gpointer *)&key, (gpointer *)&value))
+      GLuint fbo_id;
+      guint i;
+
+      glGenFramebuffers (1, &fbo_id);
+      glBindFramebuffer (GL_FRAMEBUFFER, fbo_id);
+
+      for (i = 0; i < removed_atlases->len; i++)
         {
-          if (g_ptr_array_find (removed_atlases, value->atlas, NULL))
+          GskGLTextureAtlas *atlas = g_ptr_array_index (removed_atlases, i);
+
+          glFramebufferTexture2D (GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                                  GL_TEXTURE_2D, atlas->texture_id, 0);
+
+          g_hash_table_iter_init (&iter, self->hash_table);
+          while (g_hash_table_iter_next (&iter, (gpointer *)&key, (gpointer *)&value))
             {
-              g_hash_table_iter_remove (&iter);
-              dropped++;
+              if (value->atlas != atlas)
+                continue;
+
+              if (value->used)
+                {
+                  relocate_glyph (self, key, value);
+                  relocated++;
+                }
+              else
+                {
+                  g_hash_table_iter_remove (&iter);
+                  dropped++;
+                }
             }
         }
+
+      glBindFramebuffer (GL_FRAMEBUFFER, 0);
+      glDeleteFramebuffers (1, &fbo_id);
+      glBindTexture (GL_TEXTURE_2D, 0);
     }
 
   if (self->timestamp % MAX_FRAME_AGE == 30)
     {
+      GPtrArray *resident = g_ptr_array_new ();
+      gint64 resident_pixels = 0;
+
       g_hash_table_iter_init (&iter, self->hash_table);
       while (g_hash_table_iter_next (&iter, (gpointer *)&key, (gpointer *)&value))
         {
@@ -369,10 +727,7 @@ gsk_gl_glyph_cache_begin_frame (GskGLGlyphCache *self,
               if (value->atlas)
                 {
                   if (value->used)
-                    {
-                      gsk_gl_texture_atlas_mark_unused (value->atlas, value->draw_width, value->draw_height);
-                      value->used = FALSE;
-                    }
+                    glyph_mark_unused (key, value);
                 }
               else
                 {
@@ -387,11 +742,51 @@ gsk_gl_glyph_cache_begin_frame (GskGLGlyphCache *self,
                 }
             }
           else
-            value->accessed = FALSE;
+            {
+              value->accessed = FALSE;
+
+              if (value->atlas && value->used)
+                {
+                  int width, height;
+
+                  glyph_get_packed_size (key, value, &width, &height);
+                  resident_pixels += width * height;
+                  g_ptr_array_add (resident, key);
+                }
+            }
        }
 
+      /* Over budget, age the least recently used glyphs as well */
+      if (resident_pixels > self->max_atlas_pixels)
+        {
+          guint i;
+
+          g_ptr_array_sort_with_data (resident, compare_last_used, self->hash_table);
+
+          for (i = 0; i < resident->len && resident_pixels > self->max_atlas_pixels; i++)
+            {
+              int width, height;
+
+              key = g_ptr_array_index (resident, i);
+              value = g_hash_table_lookup (self->hash_table, key);
+
+              /* Never age what the current frames are using */
+              if (value->last_used + 1 >= self->timestamp)
+                break;
+
+              glyph_get_packed_size (key, value, &width, &height);
+              glyph_mark_unused (key, value);
+              resident_pixels -= width * height;
+            }
+
+          GSK_NOTE(GLYPH_CACHE, g_message ("Over budget, aged %u glyphs", i));
+        }
+
+      g_ptr_array_unref (resident);
+
       GSK_NOTE(GLYPH_CACHE, g_message ("%d glyphs cached", g_hash_table_size (self->hash_table)));
     }
 
   GSK_NOTE(GLYPH_CACHE, if (dropped > 0) g_message ("Dropped %d glyphs", dropped));
+  GSK_NOTE(GLYPH_CACHE, if (relocated > 0) g_message ("Moved %d glyphs to other atlases", relocated));
 }
@@ -16,6 +16,9 @@ typedef struct
   GskGLTextureAtlases *atlases;
 
   int timestamp;
+  int max_atlas_pixels; /* Budget for glyphs on atlases */
+
+  guint use_sdf : 1; /* Whether big glyphs are cached as distance fields */
 } GskGLGlyphCache;
 
 struct _CacheKeyData
@@ -24,7 +27,8 @@ struct _CacheKeyData
   PangoGlyph glyph;
   guint xshift : 3;
   guint yshift : 3;
-  guint scale  : 26; /* times 1024 */
+  guint scale  : 25; /* times 1024 */
+  guint sdf    : 1;  /* signed distance field, see gsk_gl_glyph_cache_get_sdf_scale() */
 };
 
 typedef struct _CacheKeyData CacheKeyData;
@@ -46,12 +50,14 @@ glyph_cache_key_set_glyph_and_shift (GlyphCacheKey *key,
                                      float y)
 {
   key->data.glyph = glyph;
-  key->data.xshift = PHASE (x);
-  key->data.yshift = PHASE (y);
+  /* Distance fields are sampled at subpixel positions as they are */
+  key->data.xshift = key->data.sdf ? 0 : PHASE (x);
+  key->data.yshift = key->data.sdf ? 0 : PHASE (y);
   key->hash = GPOINTER_TO_UINT (key->data.font) ^
               key->data.glyph ^
               (key->data.xshift << 24) ^
               (key->data.yshift << 26) ^
+              (key->data.sdf << 31) ^
               key->data.scale;
 }
 
@@ -72,6 +78,8 @@ struct _GskGLCachedGlyph
   int draw_width;
   int draw_height;
 
+  int last_used; /* timestamp of the last frame using this glyph */
+
   guint accessed : 1; /* accessed since last check */
   guint used     : 1; /* accounted as used in the atlas */
 };
@@ -84,7 +92,11 @@ void                     gsk_gl_glyph_cache_unref           (GskGLGlyphCache
 void                     gsk_gl_glyph_cache_begin_frame     (GskGLGlyphCache        *self,
                                                              GskGLDriver            *driver,
                                                              GPtrArray              *removed_atlases);
-void                     gsk_gl_glyph_cache_lookup_or_add   (GskGLGlyphCache        *self,
+gboolean                 gsk_gl_glyph_cache_get_sdf_scale   (GskGLGlyphCache        *self,
+                                                             PangoFont              *font,
+                                                             float                   text_scale,
+                                                             float                  *sdf_scale);
+gboolean                 gsk_gl_glyph_cache_lookup_or_add   (GskGLGlyphCache        *self,
                                                              GlyphCacheKey          *lookup,
                                                              GskGLDriver            *driver,
                                                              const GskGLCachedGlyph **cached_glyph_out);
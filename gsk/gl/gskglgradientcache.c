@@ -0,0 +1,218 @@
+
+#include "gskglgradientcacheprivate.h"
+
+#include <epoxy/gl.h>
+#include <string.h>
+
+#define MAX_UNUSED_FRAMES (16 * 5)
+
+typedef struct
+{
+  guint hash;
+  gsize n_color_stops;
+  GskColorStop *color_stops;
+} CacheKey;
+
+typedef struct
+{
+  int texture_id;
+  int unused_frames;
+} CacheItem;
+
+static guint
+key_hash (gconstpointer v)
+{
+  const CacheKey *key = v;
+
+  return key->hash;
+}
+
+static gboolean
+key_equal (gconstpointer v1,
+           gconstpointer v2)
+{
+  const CacheKey *a = v1;
+  const CacheKey *b = v2;
+
+  return a->hash == b->hash &&
+         a->n_color_stops == b->n_color_stops &&
+         memcmp (a->color_stops, b->color_stops, sizeof (GskColorStop) * a->n_color_stops) == 0;
+}
+
+static void
+key_free (gpointer v)
+{
+  CacheKey *key = v;
+
+  g_free (key->color_stops);
+  g_free (key);
+}
+
+static guint
+hash_color_stops (const GskColorStop *color_stops,
+                  gsize               n_color_stops)
+{
+  const guint32 *data = (const guint32 *) color_stops;
+  const gsize n = n_color_stops * sizeof (GskColorStop) / sizeof (guint32);
+  guint hash = 5381;
+  gsize i;
+
+  for (i = 0; i < n; i++)
+    hash = (hash << 5) + hash + data[i];
+
+  return hash;
+}
+
+static inline void
+premultiply (const GdkRGBA *color,
+             float          out[4])
+{
+  out[0] = color->red * color->alpha;
+  out[1] = color->green * color->alpha;
+  out[2] = color->blue * color->alpha;
+  out[3] = color->alpha;
+}
+
+/* Evaluates the gradient the same way the shaders do: the first and
+ * last colors extend beyond the first and last stop, and colors are
+ * interpolated in premultiplied space. */
+static void
+fill_ramp (guchar             *data,
+           const GskColorStop *color_stops,
+           gsize               n_color_stops)
+{
+  gsize stop = 0;
+  int i, c;
+
+  for (i = 0; i < GSK_GL_GRADIENT_RAMP_SIZE; i++)
+    {
+      const float offset = (float) i / (GSK_GL_GRADIENT_RAMP_SIZE - 1);
+      float color[4];
+
+      while (stop < n_color_stops && color_stops[stop].offset < offset)
+        stop++;
+
+      if (stop == 0)
+        {
+          premultiply (&color_stops[0].color, color);
+        }
+      else if (stop == n_color_stops)
+        {
+          premultiply (&color_stops[n_color_stops - 1].color, color);
+        }
+      else
+        {
+          const GskColorStop *s1 = &color_stops[stop - 1];
+          const GskColorStop *s2 = &color_stops[stop];
+          float c1[4], c2[4];
+          float f;
+
+          premultiply (&s1->color, c1);
+          premultiply (&s2->color, c2);
+
+          if (s2->offset > s1->offset)
+            f = (offset - s1->offset) / (s2->offset - s1->offset);
+          else
+            f = 1.0f;
+
+          for (c = 0; c < 4; c++)
+            color[c] = c1[c] + (c2[c] - c1[c]) * f;
+        }
+
+      for (c = 0; c < 4; c++)
+        data[i * 4 + c] = (guchar) (CLAMP (color[c], 0.0f, 1.0f) * 255.f + 0.5f);
+    }
+}
+
+void
+gsk_gl_gradient_cache_init (GskGLGradientCache *self)
+{
+  self->textures = g_hash_table_new_full (key_hash, key_equal, key_free, g_free);
+}
+
+void
+gsk_gl_gradient_cache_free (GskGLGradientCache *self,
+                            GskGLDriver        *gl_driver)
+{
+  GHashTableIter iter;
+  CacheItem *item;
+
+  g_hash_table_iter_init (&iter, self->textures);
+  while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &item))
+    gsk_gl_driver_destroy_texture (gl_driver, item->texture_id);
+
+  g_clear_pointer (&self->textures, g_hash_table_unref);
+}
+
+void
+gsk_gl_gradient_cache_begin_frame (GskGLGradientCache *self,
+                                   GskGLDriver        *gl_driver)
+{
+  GHashTableIter iter;
+  CacheItem *item;
+
+  g_hash_table_iter_init (&iter, self->textures);
+  while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &item))
+    {
+      if (item->unused_frames > MAX_UNUSED_FRAMES)
+        {
+          gsk_gl_driver_destroy_texture (gl_driver, item->texture_id);
+          g_hash_table_iter_remove (&iter);
+        }
+      else
+        {
+          item->unused_frames ++;
+        }
+    }
+}
+
+/*
+ * Returns a GSK_GL_GRADIENT_RAMP_SIZE x 1 texture containing the
+ * premultiplied colors of the gradient, creating it if necessary.
+ */
+int
+gsk_gl_gradient_cache_get_texture_id (GskGLGradientCache *self,
+                                      GskGLDriver        *gl_driver,
+                                      const GskColorStop *color_stops,
+                                      gsize               n_color_stops)
+{
+  CacheKey lookup;
+  CacheKey *key;
+  CacheItem *item;
+  guchar data[GSK_GL_GRADIENT_RAMP_SIZE * 4];
+
+  g_assert (self != NULL);
+  g_assert (gl_driver != NULL);
+  g_assert (n_color_stops > 0);
+
+  lookup.hash = hash_color_stops (color_stops, n_color_stops);
+  lookup.n_color_stops = n_color_stops;
+  lookup.color_stops = (GskColorStop *) color_stops;
+
+  item = g_hash_table_lookup (self->textures, &lookup);
+  if (item != NULL)
+    {
+      item->unused_frames = 0;
+      return item->texture_id;
+    }
+
+  fill_ramp (data, color_stops, n_color_stops);
+
+  item = g_new (CacheItem, 1);
+  item->unused_frames = 0;
+  item->texture_id = gsk_gl_driver_create_texture (gl_driver, GSK_GL_GRADIENT_RAMP_SIZE, 1);
+  gsk_gl_driver_mark_texture_permanent (gl_driver, item->texture_id);
+  gsk_gl_driver_bind_source_texture (gl_driver, item->texture_id);
+  gsk_gl_driver_init_texture_empty (gl_driver, item->texture_id, GL_LINEAR, GL_LINEAR);
+  glTexSubImage2D (GL_TEXTURE_2D, 0, 0, 0, GSK_GL_GRADIENT_RAMP_SIZE, 1,
+                   GL_RGBA, GL_UNSIGNED_BYTE, data);
+
+  key = g_new (CacheKey, 1);
+  key->hash = lookup.hash;
+  key->n_color_stops = n_color_stops;
+  key->color_stops = g_memdup (color_stops, sizeof (GskColorStop) * n_color_stops);
+
+  g_hash_table_insert (self->textures, key, item);
+
+  return item->texture_id;
+}
@@ -0,0 +1,28 @@
+#ifndef __GSK_GL_GRADIENT_CACHE_H__
+#define __GSK_GL_GRADIENT_CACHE_H__
+
+#include <glib.h>
+#include "gskgldriverprivate.h"
+#include "gskrendernode.h"
+
+/* Width of the ramp textures used for gradients */
+#define GSK_GL_GRADIENT_RAMP_SIZE 256
+
+typedef struct
+{
+  GHashTable *textures;
+} GskGLGradientCache;
+
+
+void gsk_gl_gradient_cache_init           (GskGLGradientCache   *self);
+void gsk_gl_gradient_cache_free           (GskGLGradientCache   *self,
+                                           GskGLDriver          *gl_driver);
+void gsk_gl_gradient_cache_begin_frame    (GskGLGradientCache   *self,
+                                           GskGLDriver          *gl_driver);
+int  gsk_gl_gradient_cache_get_texture_id (GskGLGradientCache   *self,
+                                           GskGLDriver          *gl_driver,
+                                           const GskColorStop   *color_stops,
+                                           gsize                 n_color_stops);
+
+
+#endif
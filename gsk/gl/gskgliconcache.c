@@ -91,12 +91,20 @@ gsk_gl_icon_cache_begin_frame (GskGLIconCache *self,
           if (!icon_data->accessed)
             {
               if (icon_data->used)
-                { 
+                {
                   const int width = icon_data->source_texture->width;
                   const int height = icon_data->source_texture->height;
                   gsk_gl_texture_atlas_mark_unused (icon_data->atlas, width + 2, height + 2);
                   icon_data->used = FALSE;
                 }
+              else
+                {
+                  /* Unused for two periods in a row. Its space on the atlas
+                   * is already accounted as unused, so stop keeping the
+                   * source texture alive. */
+                  g_hash_table_iter_remove (&iter);
+                  continue;
+                }
             }
 
           icon_data->accessed = FALSE;
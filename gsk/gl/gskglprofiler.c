@@ -3,9 +3,18 @@
 #include "gskglprofilerprivate.h"
 
 #include <epoxy/gl.h>
+#include <string.h>
 
 #define N_QUERIES       4
 
+/* Timestamps recorded during one frame, each one marking the start
+ * of a section that lasts until the next timestamp. The query objects
+ * are kept around and reused when the slot comes around again. */
+typedef struct {
+  GArray *queries;  /* GLuint */
+  GArray *sections; /* guint, one per used query */
+} SectionFrame;
+
 struct _GskGLProfiler
 {
   GObject parent_instance;
@@ -18,9 +27,14 @@ struct _GskGLProfiler
   GLuint gl_queries[N_QUERIES];
   GLuint active_query;
 
+  SectionFrame section_frames[N_QUERIES];
+  guint n_sections;
+  guint64 *section_times; /* usec, for the last frame with results */
+
   gboolean has_queries : 1;
   gboolean has_timer : 1;
   gboolean first_frame : 1;
+  gboolean in_gpu_region : 1;
 };
 
 enum {
@@ -37,10 +51,27 @@ static void
 gsk_gl_profiler_finalize (GObject *gobject)
 {
   GskGLProfiler *self = GSK_GL_PROFILER (gobject);
+  guint i;
 
   if (self->has_queries)
     glDeleteQueries (N_QUERIES, self->gl_queries);
 
+  for (i = 0; i < N_QUERIES; i++)
+    {
+      SectionFrame *frame = &self->section_frames[i];
+
+      if (frame->queries == NULL)
+        continue;
+
+      if (frame->queries->len > 0)
+        glDeleteQueries (frame->queries->len, (GLuint *) frame->queries->data);
+
+      g_array_unref (frame->queries);
+      g_array_unref (frame->sections);
+    }
+
+  g_free (self->section_times);
+
   g_clear_object (&self->gl_context);
 
   G_OBJECT_CLASS (gsk_gl_profiler_parent_class)->finalize (gobject);
@@ -138,6 +169,66 @@ gsk_gl_profiler_begin_gpu_region (GskGLProfiler *profiler)
 
   query_id = profiler->gl_queries[profiler->active_query];
   glBeginQuery (GL_TIME_ELAPSED, query_id);
+  profiler->in_gpu_region = TRUE;
+
+  if (profiler->n_sections > 0)
+    g_array_set_size (profiler->section_frames[profiler->active_query].sections, 0);
+}
+
+/* Reads back the timestamps of @frame, if the GPU is done with them */
+static void
+collect_sections (GskGLProfiler *profiler,
+                  SectionFrame  *frame)
+{
+  GLuint64 start, end;
+  GLint available;
+  guint i, n;
+
+  n = frame->sections->len;
+  if (n < 2)
+    return;
+
+  glGetQueryObjectiv (g_array_index (frame->queries, GLuint, n - 1),
+                      GL_QUERY_RESULT_AVAILABLE, &available);
+  if (!available)
+    return;
+
+  memset (profiler->section_times, 0, sizeof (guint64) * profiler->n_sections);
+
+  glGetQueryObjectui64v (g_array_index (frame->queries, GLuint, 0), GL_QUERY_RESULT, &start);
+  for (i = 1; i < n; i++)
+    {
+      guint section = g_array_index (frame->sections, guint, i - 1);
+
+      glGetQueryObjectui64v (g_array_index (frame->queries, GLuint, i), GL_QUERY_RESULT, &end);
+
+      if (section < profiler->n_sections && end > start)
+        profiler->section_times[section] += end - start;
+
+      start = end;
+    }
+
+  for (i = 0; i < profiler->n_sections; i++)
+    profiler->section_times[i] /= 1000; /* Convert to usec */
+}
+
+static void
+record_timestamp (GskGLProfiler *profiler,
+                  guint          section)
+{
+  SectionFrame *frame = &profiler->section_frames[profiler->active_query];
+  guint n = frame->sections->len;
+
+  if (n == frame->queries->len)
+    {
+      GLuint query_id;
+
+      glGenQueries (1, &query_id);
+      g_array_append_val (frame->queries, query_id);
+    }
+
+  glQueryCounter (g_array_index (frame->queries, GLuint, n), GL_TIMESTAMP);
+  g_array_append_val (frame->sections, section);
 }
 
 guint64
@@ -153,6 +244,12 @@ gsk_gl_profiler_end_gpu_region (GskGLProfiler *profiler)
     return 0;
 
   glEndQuery (GL_TIME_ELAPSED);
+  profiler->in_gpu_region = FALSE;
+
+  /* Close the last section of this frame */
+  if (profiler->n_sections > 0 &&
+      profiler->section_frames[profiler->active_query].sections->len > 0)
+    record_timestamp (profiler, G_MAXUINT);
 
   if (profiler->active_query == 0)
     last_query_id = N_QUERIES - 1;
@@ -164,6 +261,11 @@ gsk_gl_profiler_end_gpu_region (GskGLProfiler *profiler)
   if (profiler->active_query == N_QUERIES)
     profiler->active_query = 0;
 
+  /* The slot we're about to reuse has the oldest section timings,
+   * which are the most likely to be available by now */
+  if (profiler->n_sections > 0)
+    collect_sections (profiler, &profiler->section_frames[profiler->active_query]);
+
   /* If this is the first frame we already have a result */
   if (profiler->first_frame)
     {
@@ -179,3 +281,78 @@ gsk_gl_profiler_end_gpu_region (GskGLProfiler *profiler)
 
   return elapsed / 1000; /* Convert to usec to match other profiler APIs */
 }
+
+/**
+ * gsk_gl_profiler_set_n_sections:
+ * @profiler: a #GskGLProfiler
+ * @n_sections: the number of sections to time
+ *
+ * Enables timing of up to @n_sections separate parts of each GPU
+ * region, see gsk_gl_profiler_begin_section().
+ */
+void
+gsk_gl_profiler_set_n_sections (GskGLProfiler *profiler,
+                                guint          n_sections)
+{
+  guint i;
+
+  g_return_if_fail (GSK_IS_GL_PROFILER (profiler));
+  g_return_if_fail (profiler->n_sections == 0);
+
+  if (!profiler->has_timer || !profiler->has_queries)
+    return;
+
+  profiler->n_sections = n_sections;
+  profiler->section_times = g_new0 (guint64, n_sections);
+
+  for (i = 0; i < N_QUERIES; i++)
+    {
+      profiler->section_frames[i].queries = g_array_new (FALSE, FALSE, sizeof (GLuint));
+      profiler->section_frames[i].sections = g_array_new (FALSE, FALSE, sizeof (guint));
+    }
+}
+
+/**
+ * gsk_gl_profiler_begin_section:
+ * @profiler: a #GskGLProfiler
+ * @section: the section the following GL commands belong to
+ *
+ * Records a GPU timestamp. The time between this and the next
+ * timestamp, or the end of the GPU region, is accounted to @section.
+ *
+ * Must be called between gsk_gl_profiler_begin_gpu_region() and
+ * gsk_gl_profiler_end_gpu_region().
+ */
+void
+gsk_gl_profiler_begin_section (GskGLProfiler *profiler,
+                               guint          section)
+{
+  g_return_if_fail (GSK_IS_GL_PROFILER (profiler));
+
+  if (!profiler->in_gpu_region || section >= profiler->n_sections)
+    return;
+
+  record_timestamp (profiler, section);
+}
+
+/**
+ * gsk_gl_profiler_get_section_time:
+ * @profiler: a #GskGLProfiler
+ * @section: a section
+ *
+ * Returns the GPU time spent in @section during the most recent frame
+ * whose results are available. Results lag a few frames behind.
+ *
+ * Returns: the time in microseconds
+ */
+guint64
+gsk_gl_profiler_get_section_time (GskGLProfiler *profiler,
+                                  guint          section)
+{
+  g_return_val_if_fail (GSK_IS_GL_PROFILER (profiler), 0);
+
+  if (section >= profiler->n_sections)
+    return 0;
+
+  return profiler->section_times[section];
+}
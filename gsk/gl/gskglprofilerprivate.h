@@ -13,6 +13,13 @@ GskGLProfiler * gsk_gl_profiler_new                     (GdkGLContext  *context)
 void            gsk_gl_profiler_begin_gpu_region        (GskGLProfiler *profiler);
 guint64         gsk_gl_profiler_end_gpu_region          (GskGLProfiler *profiler);
 
+void            gsk_gl_profiler_set_n_sections          (GskGLProfiler *profiler,
+                                                         guint          n_sections);
+void            gsk_gl_profiler_begin_section           (GskGLProfiler *profiler,
+                                                         guint          section);
+guint64         gsk_gl_profiler_get_section_time        (GskGLProfiler *profiler,
+                                                         guint          section);
+
 G_END_DECLS
 
 #endif /* __GSK_GL_PROFILER_PRIVATE_H__ */
@@ -16,6 +16,7 @@
 #include "gskglrenderopsprivate.h"
 #include "gskcairoblurprivate.h"
 #include "gskglshadowcacheprivate.h"
+#include "gskglgradientcacheprivate.h"
 #include "gskglnodesampleprivate.h"
 #include "gsktransform.h"
 #include "glutilsprivate.h"
@@ -42,6 +43,12 @@
 
 #define SHADOW_EXTRA_SIZE  4
 
+#define MAX_ATLASED_TEXTURE_SIZE 128
+
+/* Blurs with radii larger than twice this are done on a downscaled texture */
+#define MIN_DOWNSCALED_BLUR_RADIUS 8
+#define MAX_BLUR_DOWNSCALE         8
+
 #if DEBUG_OPS
 #define OP_PRINT(format, ...) g_print(format, ## __VA_ARGS__)
 #else
@@ -56,8 +63,7 @@
                   { \
                     g_set_error (error, GDK_GL_ERROR, GDK_GL_ERROR_LINK_FAILED, \
                                  "Failed to find variable \"u_%s\" in shader program \"%s\"", #uniform_basename, #program_name); \
-                    g_clear_pointer (&programs, gsk_gl_renderer_programs_unref); \
-                    goto out; \
+                    return FALSE; \
                   } \
               }G_STMT_END
 
@@ -542,18 +548,31 @@ struct _GskGLRenderer
   GskGLGlyphCache *glyph_cache;
   GskGLIconCache *icon_cache;
   GskGLShadowCache shadow_cache;
+  GskGLGradientCache gradient_cache;
 
 #ifdef G_ENABLE_DEBUG
   struct {
     GQuark frames;
+    GQuark culled_nodes;
+    GQuark glyph_cache_hits;
+    GQuark glyph_cache_misses;
+    GQuark fallback_cache_hits;
+    GQuark fallback_cache_misses;
   } profile_counters;
   struct {
     GQuark cpu_time;
     GQuark gpu_time;
+    /* One per program, plus one for all custom shaders */
+    GQuark program_gpu_time[GL_N_PROGRAMS + 1];
   } profile_timers;
 #endif
 
   cairo_region_t *render_region;
+
+  /* Only used if op_builder.use_uniform_block is set */
+  GLuint common_uniforms_buffer;
+  GskGLCommonUniforms common_uniforms;
+  gboolean common_uniforms_dirty;
 };
 
 struct _GskGLRendererClass
@@ -604,7 +623,7 @@ add_rect_outline_ops (GskGLRenderer         *self,
                       const graphene_rect_t *rect)
 {
   ops_set_program (builder, &self->programs->color_program);
-  ops_set_color (builder, &BLACK);
+  ops_set_vertex_color (builder, &BLACK);
 
   load_vertex_data (ops_draw (builder, NULL),
                     &GRAPHENE_RECT_INIT (rect->origin.x, rect->origin.y, 1, rect->size.height),
@@ -670,6 +689,12 @@ render_fallback_node (GskGLRenderer   *self,
 
   cached_id = gsk_gl_driver_get_texture_for_key (self->gl_driver, &key);
 
+#ifdef G_ENABLE_DEBUG
+  gsk_profiler_counter_inc (gsk_renderer_get_profiler (GSK_RENDERER (self)),
+                            cached_id != 0 ? self->profile_counters.fallback_cache_hits
+                                           : self->profile_counters.fallback_cache_misses);
+#endif
+
   if (cached_id != 0)
     {
       ops_set_program (builder, &self->programs->blit_program);
@@ -778,22 +803,36 @@ render_text_node (GskGLRenderer   *self,
   int i;
   int x_position = 0;
   GlyphCacheKey lookup;
+  gboolean use_sdf = FALSE;
+  float sdf_scale;
+  guint n_hits = 0;
+  guint n_misses = 0;
+
+  memset (&lookup, 0, sizeof (CacheKeyData));
+  lookup.data.font = (PangoFont *)font;
+  lookup.data.scale = (guint) (text_scale * 1024);
 
   /* If the font has color glyphs, we don't need to recolor anything */
   if (!force_color && gsk_text_node_has_color_glyphs (node))
     {
       ops_set_program (builder, &self->programs->blit_program);
     }
+  else if (gsk_gl_glyph_cache_get_sdf_scale (self->glyph_cache, (PangoFont *)font,
+                                             text_scale, &sdf_scale))
+    {
+      use_sdf = TRUE;
+      lookup.data.sdf = TRUE;
+      lookup.data.scale = (guint) (sdf_scale * 1024);
+
+      ops_set_program (builder, &self->programs->sdf_text_program);
+      ops_set_vertex_color (builder, color);
+    }
   else
     {
       ops_set_program (builder, &self->programs->coloring_program);
-      ops_set_color (builder, color);
+      ops_set_vertex_color (builder, color);
     }
 
-  memset (&lookup, 0, sizeof (CacheKeyData));
-  lookup.data.font = (PangoFont *)font;
-  lookup.data.scale = (guint) (text_scale * 1024);
-
   /* We use one quad per character */
   for (i = 0; i < num_glyphs; i++)
     {
@@ -812,10 +851,13 @@ render_text_node (GskGLRenderer   *self,
 
       glyph_cache_key_set_glyph_and_shift (&lookup, gi->glyph, x + cx, y + cy);
 
-      gsk_gl_glyph_cache_lookup_or_add (self->glyph_cache,
-                                        &lookup,
-                                        self->gl_driver,
-                                        &glyph);
+      if (gsk_gl_glyph_cache_lookup_or_add (self->glyph_cache,
+                                            &lookup,
+                                            self->gl_driver,
+                                            &glyph))
+        n_hits++;
+      else
+        n_misses++;
 
       if (glyph->texture_id == 0)
         goto next;
@@ -827,8 +869,16 @@ render_text_node (GskGLRenderer   *self,
       tx2 = tx + glyph->tw;
       ty2 = ty + glyph->th;
 
-      glyph_x = floor (x + cx + 0.125) + glyph->draw_x;
-      glyph_y = floor (y + cy + 0.125) + glyph->draw_y;
+      if (use_sdf)
+        {
+          glyph_x = x + cx + glyph->draw_x;
+          glyph_y = y + cy + glyph->draw_y;
+        }
+      else
+        {
+          glyph_x = floor (x + cx + 0.125) + glyph->draw_x;
+          glyph_y = floor (y + cy + 0.125) + glyph->draw_y;
+        }
       glyph_x2 = glyph_x + glyph->draw_width;
       glyph_y2 = glyph_y + glyph->draw_height;
 
@@ -845,6 +895,18 @@ render_text_node (GskGLRenderer   *self,
 next:
       x_position += gi->geometry.width;
     }
+
+#ifdef G_ENABLE_DEBUG
+  {
+    GskProfiler *profiler = gsk_renderer_get_profiler (GSK_RENDERER (self));
+
+    gsk_profiler_counter_add (profiler, self->profile_counters.glyph_cache_hits, n_hits);
+    gsk_profiler_counter_add (profiler, self->profile_counters.glyph_cache_misses, n_misses);
+  }
+#else
+  (void) n_hits;
+  (void) n_misses;
+#endif
 }
 
 static inline void
@@ -993,17 +1055,20 @@ render_color_node (GskGLRenderer   *self,
                    RenderOpBuilder *builder)
 {
   ops_set_program (builder, &self->programs->color_program);
-  ops_set_color (builder, gsk_color_node_get_color (node));
+  ops_set_vertex_color (builder, gsk_color_node_get_color (node));
   load_vertex_data (ops_draw (builder, NULL), &node->bounds, builder);
 }
 
 static inline void
 upload_texture (GskGLRenderer *self,
                 GdkTexture    *texture,
+                int            min_filter,
                 TextureRegion *out_region)
 {
-  if (texture->width <= 128 &&
-      texture->height <= 128 &&
+  /* Small textures are packed into the shared atlases, so that
+   * consecutive draws of different ones can share a texture bind. */
+  if (texture->width <= MAX_ATLASED_TEXTURE_SIZE &&
+      texture->height <= MAX_ATLASED_TEXTURE_SIZE &&
       !GDK_IS_GL_TEXTURE (texture))
     {
       const IconData *icon_data;
@@ -1024,7 +1089,7 @@ upload_texture (GskGLRenderer *self,
       out_region->texture_id =
           gsk_gl_driver_get_texture_for_texture (self->gl_driver,
                                                  texture,
-                                                 GL_LINEAR,
+                                                 min_filter,
                                                  GL_LINEAR);
 
       out_region->x  = 0;
@@ -1041,6 +1106,11 @@ render_texture_node (GskGLRenderer       *self,
 {
   GdkTexture *texture = gsk_texture_node_get_texture (node);
   const int max_texture_size = gsk_gl_driver_get_max_texture_size (self->gl_driver);
+  GskOffload *offload = gsk_renderer_get_offload (GSK_RENDERER (self));
+
+  /* Shown on a subsurface */
+  if (offload && gsk_offload_is_offloaded (offload, node))
+    return;
 
   if (texture->width > max_texture_size || texture->height > max_texture_size)
     {
@@ -1082,8 +1152,19 @@ render_texture_node (GskGLRenderer       *self,
   else
     {
       TextureRegion r;
+      int min_filter = GL_LINEAR;
 
-      upload_texture (self, texture, &r);
+      /* Sample from mipmaps when the texture is drawn at less than
+       * half its size, as linear filtering then skips texels and
+       * aliases. GLES 2 can't generate mipmaps for all sizes, so
+       * stick to desktop GL there.
+       */
+      if (node->bounds.size.width * builder->scale_x * 2 < texture->width &&
+          node->bounds.size.height * builder->scale_y * 2 < texture->height &&
+          !gdk_gl_context_get_use_es (self->gl_context))
+        min_filter = GL_LINEAR_MIPMAP_LINEAR;
+
+      upload_texture (self, texture, min_filter, &r);
 
       ops_set_program (builder, &self->programs->blit_program);
       ops_set_texture (builder, r.texture_id);
@@ -1262,7 +1343,7 @@ render_gl_shader_node (GskGLRenderer       *self,
     {
       static GdkRGBA pink = { 255 / 255., 105 / 255., 180 / 255., 1.0 };
       ops_set_program (builder, &self->programs->color_program);
-      ops_set_color (builder, &pink);
+      ops_set_vertex_color (builder, &pink);
       load_vertex_data (ops_draw (builder, NULL), &node->bounds, builder);
     }
 }
@@ -1441,14 +1522,14 @@ render_linear_gradient_node (GskGLRenderer   *self,
                              RenderOpBuilder *builder)
 {
   const int n_color_stops = gsk_linear_gradient_node_get_n_color_stops (node);
+  const GskColorStop *stops = gsk_linear_gradient_node_get_color_stops (node, NULL);
+  const graphene_point_t *start = gsk_linear_gradient_node_get_start (node);
+  const graphene_point_t *end = gsk_linear_gradient_node_get_end (node);
+
+  ops_set_program (builder, &self->programs->linear_gradient_program);
 
   if (n_color_stops < GL_MAX_GRADIENT_STOPS)
     {
-      const GskColorStop *stops = gsk_linear_gradient_node_get_color_stops (node, NULL);
-      const graphene_point_t *start = gsk_linear_gradient_node_get_start (node);
-      const graphene_point_t *end = gsk_linear_gradient_node_get_end (node);
-
-      ops_set_program (builder, &self->programs->linear_gradient_program);
       ops_set_linear_gradient (builder,
                                n_color_stops,
                                stops,
@@ -1456,13 +1537,22 @@ render_linear_gradient_node (GskGLRenderer   *self,
                                builder->dy + start->y,
                                builder->dx + end->x,
                                builder->dy + end->y);
-
-      load_vertex_data (ops_draw (builder, NULL), &node->bounds, builder);
     }
   else
     {
-      render_fallback_node (self, node, builder);
+      /* Too many stops for uniforms, look the colors up in a ramp instead */
+      ops_set_texture (builder, gsk_gl_gradient_cache_get_texture_id (&self->gradient_cache,
+                                                                      self->gl_driver,
+                                                                      stops, n_color_stops));
+      ops_set_linear_gradient (builder,
+                               0, NULL,
+                               builder->dx + start->x,
+                               builder->dy + start->y,
+                               builder->dx + end->x,
+                               builder->dy + end->y);
     }
+
+  load_vertex_data (ops_draw (builder, NULL), &node->bounds, builder);
 }
 
 static inline void
@@ -1471,32 +1561,33 @@ render_radial_gradient_node (GskGLRenderer   *self,
                              RenderOpBuilder *builder)
 {
   const int n_color_stops = gsk_radial_gradient_node_get_n_color_stops (node);
+  const GskColorStop *stops = gsk_radial_gradient_node_get_color_stops (node, NULL);
+  const graphene_point_t *center = gsk_radial_gradient_node_get_center (node);
+  const float start = gsk_radial_gradient_node_get_start (node);
+  const float end = gsk_radial_gradient_node_get_end (node);
+  const float hradius = gsk_radial_gradient_node_get_hradius (node);
+  const float vradius = gsk_radial_gradient_node_get_vradius (node);
 
-  if (n_color_stops < GL_MAX_GRADIENT_STOPS)
-    {
-      const GskColorStop *stops = gsk_radial_gradient_node_get_color_stops (node, NULL);
-      const graphene_point_t *center = gsk_radial_gradient_node_get_center (node);
-      const float start = gsk_radial_gradient_node_get_start (node);
-      const float end = gsk_radial_gradient_node_get_end (node);
-      const float hradius = gsk_radial_gradient_node_get_hradius (node);
-      const float vradius = gsk_radial_gradient_node_get_vradius (node);
-
-      ops_set_program (builder, &self->programs->radial_gradient_program);
-      ops_set_radial_gradient (builder,
-                               n_color_stops,
-                               stops,
-                               builder->dx + center->x,
-                               builder->dy + center->y,
-                               start, end,
-                               hradius * builder->scale_x,
-                               vradius * builder->scale_y);
+  ops_set_program (builder, &self->programs->radial_gradient_program);
 
-      load_vertex_data (ops_draw (builder, NULL), &node->bounds, builder);
-    }
-  else
+  if (n_color_stops >= GL_MAX_GRADIENT_STOPS)
     {
-      render_fallback_node (self, node, builder);
+      /* Too many stops for uniforms, look the colors up in a ramp instead */
+      ops_set_texture (builder, gsk_gl_gradient_cache_get_texture_id (&self->gradient_cache,
+                                                                      self->gl_driver,
+                                                                      stops, n_color_stops));
     }
+
+  ops_set_radial_gradient (builder,
+                           n_color_stops < GL_MAX_GRADIENT_STOPS ? n_color_stops : 0,
+                           stops,
+                           builder->dx + center->x,
+                           builder->dy + center->y,
+                           start, end,
+                           hradius * builder->scale_x,
+                           vradius * builder->scale_y);
+
+  load_vertex_data (ops_draw (builder, NULL), &node->bounds, builder);
 }
 
 static inline void
@@ -1505,27 +1596,28 @@ render_conic_gradient_node (GskGLRenderer   *self,
                              RenderOpBuilder *builder)
 {
   const int n_color_stops = gsk_conic_gradient_node_get_n_color_stops (node);
+  const GskColorStop *stops = gsk_conic_gradient_node_get_color_stops (node, NULL);
+  const graphene_point_t *center = gsk_conic_gradient_node_get_center (node);
+  const float rotation = gsk_conic_gradient_node_get_rotation (node);
 
-  if (n_color_stops < GL_MAX_GRADIENT_STOPS)
-    {
-      const GskColorStop *stops = gsk_conic_gradient_node_get_color_stops (node, NULL);
-      const graphene_point_t *center = gsk_conic_gradient_node_get_center (node);
-      const float rotation = gsk_conic_gradient_node_get_rotation (node);
-
-      ops_set_program (builder, &self->programs->conic_gradient_program);
-      ops_set_conic_gradient (builder,
-                              n_color_stops,
-                              stops,
-                              builder->dx + center->x,
-                              builder->dy + center->y,
-                              rotation);
+  ops_set_program (builder, &self->programs->conic_gradient_program);
 
-      load_vertex_data (ops_draw (builder, NULL), &node->bounds, builder);
-    }
-  else
+  if (n_color_stops >= GL_MAX_GRADIENT_STOPS)
     {
-      render_fallback_node (self, node, builder);
+      /* Too many stops for uniforms, look the colors up in a ramp instead */
+      ops_set_texture (builder, gsk_gl_gradient_cache_get_texture_id (&self->gradient_cache,
+                                                                      self->gl_driver,
+                                                                      stops, n_color_stops));
     }
+
+  ops_set_conic_gradient (builder,
+                          n_color_stops < GL_MAX_GRADIENT_STOPS ? n_color_stops : 0,
+                          stops,
+                          builder->dx + center->x,
+                          builder->dy + center->y,
+                          rotation);
+
+  load_vertex_data (ops_draw (builder, NULL), &node->bounds, builder);
 }
 
 static inline gboolean
@@ -1815,12 +1907,106 @@ render_color_matrix_node (GskGLRenderer       *self,
                                 is_offscreen);
 }
 
+/* Returns the factor by which a texture is shrunk before blurring it
+ * with the given radii (in device pixels).
+ *
+ * The gaussian shader samples every pixel within the radius, so large
+ * radii get expensive quickly. Halving the texture halves the radius,
+ * and since the result is blurry anyway, sampling it back up bilinearly
+ * is not noticeable as long as the remaining radius isn't too small. */
+static inline int
+get_blur_downscale (float blur_radius_x,
+                    float blur_radius_y)
+{
+  const float min_radius = MIN (blur_radius_x, blur_radius_y);
+  int downscale = 1;
+
+  while (downscale < MAX_BLUR_DOWNSCALE &&
+         min_radius / downscale > 2 * MIN_DOWNSCALED_BLUR_RADIUS)
+    downscale *= 2;
+
+  return downscale;
+}
+
+/* Shrinks @region to half its size @n_passes times, letting linear
+ * filtering average 2x2 pixels in each pass. */
+static inline int
+downsample_texture (GskGLRenderer       *self,
+                    RenderOpBuilder     *builder,
+                    const TextureRegion *region,
+                    int                 *inout_width,
+                    int                 *inout_height,
+                    int                  n_passes)
+{
+  const int width = *inout_width;
+  const int height = *inout_height;
+  TextureRegion source = *region;
+  int prev_render_target;
+  graphene_matrix_t prev_projection;
+  graphene_rect_t prev_viewport;
+  graphene_matrix_t item_proj;
+  int texture_id = 0;
+  int w = width, h = height;
+  int i;
+
+  g_assert (n_passes > 0);
+
+  init_projection_matrix (&item_proj, &GRAPHENE_RECT_INIT (0, 0, width, height));
+
+  prev_projection = ops_set_projection (builder, &item_proj);
+  ops_set_modelview (builder, NULL);
+  prev_viewport = ops_set_viewport (builder, &GRAPHENE_RECT_INIT (0, 0, width, height));
+  ops_push_clip (builder, &GSK_ROUNDED_RECT_INIT (0, 0, width, height));
+
+  ops_set_program (builder, &self->programs->blit_program);
+
+  for (i = 0; i < n_passes; i ++)
+    {
+      int render_target;
+
+      w = MAX ((w + 1) / 2, 1);
+      h = MAX ((h + 1) / 2, 1);
+
+      gsk_gl_driver_create_render_target (self->gl_driver,
+                                          w, h,
+                                          GL_LINEAR, GL_LINEAR,
+                                          &texture_id, &render_target);
+
+      init_projection_matrix (&item_proj, &GRAPHENE_RECT_INIT (0, 0, w, h));
+      ops_set_projection (builder, &item_proj);
+      ops_set_viewport (builder, &GRAPHENE_RECT_INIT (0, 0, w, h));
+      if (i == 0)
+        prev_render_target = ops_set_render_target (builder, render_target);
+      else
+        ops_set_render_target (builder, render_target);
+      ops_begin (builder, OP_CLEAR);
+      ops_set_texture (builder, source.texture_id);
+      load_vertex_data_with_region (ops_draw (builder, NULL),
+                                    &GRAPHENE_RECT_INIT (0, 0, w, h),
+                                    builder, &source,
+                                    FALSE);
+
+      init_full_texture_region (&source, texture_id);
+    }
+
+  ops_set_render_target (builder, prev_render_target);
+  ops_set_viewport (builder, &prev_viewport);
+  ops_set_projection (builder, &prev_projection);
+  ops_pop_modelview (builder);
+  ops_pop_clip (builder);
+
+  *inout_width = w;
+  *inout_height = h;
+
+  return texture_id;
+}
+
 static inline int
 blur_texture (GskGLRenderer       *self,
               RenderOpBuilder     *builder,
               const TextureRegion *region,
-              const int            texture_to_blur_width,
-              const int            texture_to_blur_height,
+              int                  texture_to_blur_width,
+              int                  texture_to_blur_height,
               float                blur_radius_x,
               float                blur_radius_y)
 {
@@ -1830,24 +2016,55 @@ blur_texture (GskGLRenderer       *self,
   graphene_matrix_t prev_projection;
   graphene_rect_t prev_viewport;
   graphene_matrix_t item_proj;
+  TextureRegion downsampled_region;
+  int downscale;
+  int filter;
   OpBlur *op;
 
   g_assert (blur_radius_x > 0);
   g_assert (blur_radius_y > 0);
 
-  gsk_gl_driver_create_render_target (self->gl_driver,
-                                      MAX (texture_to_blur_width, 1), MAX (texture_to_blur_height, 1),
-                                      GL_NEAREST, GL_NEAREST,
-                                      &pass1_texture_id, &pass1_render_target);
-
   if (texture_to_blur_width <= 0 || texture_to_blur_height <= 0)
     {
+      gsk_gl_driver_create_render_target (self->gl_driver, 1, 1,
+                                          GL_NEAREST, GL_NEAREST,
+                                          &pass1_texture_id, &pass1_render_target);
       return pass1_texture_id;
     }
 
+  downscale = get_blur_downscale (blur_radius_x, blur_radius_y);
+  if (downscale > 1)
+    {
+      int n_passes = 0;
+
+      while ((1 << n_passes) < downscale)
+        n_passes ++;
+
+      init_full_texture_region (&downsampled_region,
+                                downsample_texture (self, builder, region,
+                                                    &texture_to_blur_width,
+                                                    &texture_to_blur_height,
+                                                    n_passes));
+      region = &downsampled_region;
+      blur_radius_x /= downscale;
+      blur_radius_y /= downscale;
+
+      /* The result is smaller than what the caller asked for, have it
+       * scaled back up smoothly when it gets drawn */
+      filter = GL_LINEAR;
+    }
+  else
+    {
+      filter = GL_NEAREST;
+    }
+
   gsk_gl_driver_create_render_target (self->gl_driver,
                                       texture_to_blur_width, texture_to_blur_height,
                                       GL_NEAREST, GL_NEAREST,
+                                      &pass1_texture_id, &pass1_render_target);
+  gsk_gl_driver_create_render_target (self->gl_driver,
+                                      texture_to_blur_width, texture_to_blur_height,
+                                      filter, filter,
                                       &pass2_texture_id, &pass2_render_target);
 
   init_projection_matrix (&item_proj,
@@ -1942,6 +2159,10 @@ blur_node (GskGLRenderer   *self,
   /* Only blur this if the out region has no texture id yet */
   if (out_region->texture_id == 0)
     {
+      /* A downscaled blur needs to average its source pixels */
+      if (get_blur_downscale (blur_radius * scale_x, blur_radius * scale_y) > 1)
+        extra_flags |= LINEAR_FILTER;
+
       if (!add_offscreen_ops (self, builder,
                               &GRAPHENE_RECT_INIT (node->bounds.origin.x - (blur_extra / 2.0),
                                                    node->bounds.origin.y - (blur_extra / 2.0),
@@ -2067,6 +2288,7 @@ render_inset_shadow_node (GskGLRenderer   *self,
       graphene_matrix_t prev_projection;
       graphene_rect_t prev_viewport;
       graphene_matrix_t item_proj;
+      int filter;
       int i;
 
       /* TODO: In the following code, we have to be careful about where we apply the scale.
@@ -2094,9 +2316,10 @@ render_inset_shadow_node (GskGLRenderer   *self,
           outline_to_blur.corner[i].height *= scale_y;
         }
 
+      filter = get_blur_downscale (blur_radius * scale_x, blur_radius * scale_y) > 1 ? GL_LINEAR : GL_NEAREST;
       gsk_gl_driver_create_render_target (self->gl_driver,
                                           texture_width, texture_height,
-                                          GL_NEAREST, GL_NEAREST,
+                                          filter, filter,
                                           &texture_id, &render_target);
 
       init_projection_matrix (&item_proj,
@@ -2305,6 +2528,10 @@ render_outset_shadow_node (GskGLRenderer   *self,
       scaled_outline.corner[i].height *= scale_y;
     }
 
+  /* When slicing, scaled_outline only depends on the corner sizes, the spread
+   * and the blur radius, not on the size of the outline, so resizing a
+   * shadowed window keeps hitting the same cached texture and only the
+   * stretched edges change. */
   cached_tid = gsk_gl_shadow_cache_get_texture_id (&self->shadow_cache,
                                                    self->gl_driver,
                                                    &scaled_outline,
@@ -2317,10 +2544,12 @@ render_outset_shadow_node (GskGLRenderer   *self,
       graphene_matrix_t prev_projection;
       graphene_rect_t prev_viewport;
       graphene_matrix_t item_proj;
+      int filter;
 
+      filter = get_blur_downscale (blur_radius * scale_x, blur_radius * scale_y) > 1 ? GL_LINEAR : GL_NEAREST;
       gsk_gl_driver_create_render_target (self->gl_driver,
                                           texture_width, texture_height,
-                                          GL_NEAREST, GL_NEAREST,
+                                          filter, filter,
                                           &texture_id, &render_target);
       if (gdk_gl_context_has_debug (self->gl_context))
         {
@@ -2342,7 +2571,7 @@ render_outset_shadow_node (GskGLRenderer   *self,
 
       /* Draw outline */
       ops_push_clip (builder, &scaled_outline);
-      ops_set_color (builder, &COLOR_WHITE);
+      ops_set_vertex_color (builder, &COLOR_WHITE);
       load_float_vertex_data (ops_draw (builder, NULL), builder,
                               0, 0, texture_width, texture_height);
 
@@ -2610,7 +2839,7 @@ render_shadow_node (GskGLRenderer   *self,
           float max_y;
 
           region.texture_id = 0;
-          blur_node (self, shadow_child, builder, shadow->radius, NO_CACHE_PLZ, &region,
+          blur_node (self, shadow_child, builder, shadow->radius, 0, &region,
                      (float*[4]){&min_x, &max_x, &min_y, &max_y});
           bounds.origin.x = min_x - builder->dx;
           bounds.origin.y = min_y - builder->dy;
@@ -2627,14 +2856,14 @@ render_shadow_node (GskGLRenderer   *self,
           if (!add_offscreen_ops (self, builder,
                                   &shadow_child->bounds,
                                   shadow_child, &region, &is_offscreen,
-                                  RESET_CLIP | NO_CACHE_PLZ))
+                                  RESET_CLIP))
             g_assert_not_reached ();
 
           bounds = shadow_child->bounds;
         }
 
       ops_set_program (builder, &self->programs->coloring_program);
-      ops_set_color (builder, &shadow->color);
+      ops_set_vertex_color (builder, &shadow->color);
       ops_set_texture (builder, region.texture_id);
 
       ops_offset (builder, dx, dy);
@@ -2844,6 +3073,88 @@ apply_viewport_op (const Program    *program,
   glViewport (0, 0, op->viewport.size.width, op->viewport.size.height);
 }
 
+/* With a shared uniform block the common state doesn't depend on the
+ * program, so we just collect it and upload it before the next draw. */
+static inline gboolean
+apply_common_uniform_op (GskGLRenderer *self,
+                         OpKind         kind,
+                         gconstpointer  ptr)
+{
+  GskGLCommonUniforms *u = &self->common_uniforms;
+
+  switch (kind)
+    {
+    case OP_CHANGE_PROJECTION:
+      {
+        const OpMatrix *op = ptr;
+
+        OP_PRINT (" -> Common projection");
+        graphene_matrix_to_float (&op->matrix, u->projection);
+      }
+      break;
+
+    case OP_CHANGE_MODELVIEW:
+      {
+        const OpMatrix *op = ptr;
+
+        OP_PRINT (" -> Common modelview");
+        graphene_matrix_to_float (&op->matrix, u->modelview);
+      }
+      break;
+
+    case OP_CHANGE_VIEWPORT:
+      {
+        const OpViewport *op = ptr;
+
+        OP_PRINT (" -> Common viewport: %f, %f, %f, %f",
+                  op->viewport.origin.x, op->viewport.origin.y,
+                  op->viewport.size.width, op->viewport.size.height);
+        u->viewport[0] = op->viewport.origin.x;
+        u->viewport[1] = op->viewport.origin.y;
+        u->viewport[2] = op->viewport.size.width;
+        u->viewport[3] = op->viewport.size.height;
+        glViewport (0, 0, op->viewport.size.width, op->viewport.size.height);
+      }
+      break;
+
+    case OP_CHANGE_CLIP:
+      {
+        const OpClip *op = ptr;
+
+        OP_PRINT (" -> Common clip: %s", gsk_rounded_rect_to_string (&op->clip));
+        memcpy (u->clip_rect, &op->clip,
+                (op->send_corners ? 12 : 4) * sizeof (float));
+      }
+      break;
+
+    case OP_CHANGE_OPACITY:
+      {
+        const OpOpacity *op = ptr;
+
+        OP_PRINT (" -> Common opacity %f", op->opacity);
+        u->alpha = op->opacity;
+      }
+      break;
+
+    default:
+      return FALSE;
+    }
+
+  self->common_uniforms_dirty = TRUE;
+
+  return TRUE;
+}
+
+static inline void
+flush_common_uniforms (GskGLRenderer *self)
+{
+  if (!self->common_uniforms_dirty)
+    return;
+
+  glBufferSubData (GL_UNIFORM_BUFFER, 0, sizeof (GskGLCommonUniforms), &self->common_uniforms);
+  self->common_uniforms_dirty = FALSE;
+}
+
 static inline void
 apply_modelview_op (const Program  *program,
                     const OpMatrix *op)
@@ -2902,7 +3213,7 @@ apply_color_op (const Program *program,
 {
   OP_PRINT (" -> Color: (%f, %f, %f, %f)",
             op->rgba->red, op->rgba->green, op->rgba->blue, op->rgba->alpha);
-  glUniform4fv (program->color.color_location, 1, (float *)op->rgba);
+  glUniform4fv (program->outset_shadow.color_location, 1, (float *)op->rgba);
 }
 
 static inline void
@@ -3300,42 +3611,194 @@ gsk_gl_renderer_create_custom_program (GskGLRenderer  *self,
   return program;
 }
 
-static GskGLRendererPrograms *
-gsk_gl_renderer_create_programs (GskGLRenderer  *self,
-                                 GError        **error)
+static const struct {
+  const char *resource_path;
+  const char *name;
+} program_definitions[] = {
+  { "/org/gtk/libgsk/glsl/blend.glsl",                     "blend" },
+  { "/org/gtk/libgsk/glsl/blit.glsl",                      "blit" },
+  { "/org/gtk/libgsk/glsl/blur.glsl",                      "blur" },
+  { "/org/gtk/libgsk/glsl/border.glsl",                    "border" },
+  { "/org/gtk/libgsk/glsl/color_matrix.glsl",              "color matrix" },
+  { "/org/gtk/libgsk/glsl/color.glsl",                     "color" },
+  { "/org/gtk/libgsk/glsl/coloring.glsl",                  "coloring" },
+  { "/org/gtk/libgsk/glsl/cross_fade.glsl",                "cross fade" },
+  { "/org/gtk/libgsk/glsl/inset_shadow.glsl",              "inset shadow" },
+  { "/org/gtk/libgsk/glsl/linear_gradient.glsl",           "linear gradient" },
+  { "/org/gtk/libgsk/glsl/radial_gradient.glsl",           "radial gradient" },
+  { "/org/gtk/libgsk/glsl/conic_gradient.glsl",            "conic gradient" },
+  { "/org/gtk/libgsk/glsl/outset_shadow.glsl",             "outset shadow" },
+  { "/org/gtk/libgsk/glsl/repeat.glsl",                    "repeat" },
+  { "/org/gtk/libgsk/glsl/unblurred_outset_shadow.glsl",   "unblurred_outset shadow" },
+  { "/org/gtk/libgsk/glsl/sdf_text.glsl",                  "sdf text" },
+};
+
+static gboolean
+init_program_uniforms (GskGLRendererPrograms  *programs,
+                       Program                *prog,
+                       GError                **error)
+{
+  INIT_COMMON_UNIFORM_LOCATION (prog, alpha);
+  INIT_COMMON_UNIFORM_LOCATION (prog, source);
+  INIT_COMMON_UNIFORM_LOCATION (prog, clip_rect);
+  INIT_COMMON_UNIFORM_LOCATION (prog, viewport);
+  INIT_COMMON_UNIFORM_LOCATION (prog, projection);
+  INIT_COMMON_UNIFORM_LOCATION (prog, modelview);
+
+  if (prog == &programs->color_matrix_program)
+    {
+      INIT_PROGRAM_UNIFORM_LOCATION (color_matrix, color_matrix);
+      INIT_PROGRAM_UNIFORM_LOCATION (color_matrix, color_offset);
+    }
+  else if (prog == &programs->linear_gradient_program)
+    {
+      INIT_PROGRAM_UNIFORM_LOCATION (linear_gradient, color_stops);
+      INIT_PROGRAM_UNIFORM_LOCATION (linear_gradient, num_color_stops);
+      INIT_PROGRAM_UNIFORM_LOCATION (linear_gradient, start_point);
+      INIT_PROGRAM_UNIFORM_LOCATION (linear_gradient, end_point);
+    }
+  else if (prog == &programs->radial_gradient_program)
+    {
+      INIT_PROGRAM_UNIFORM_LOCATION (radial_gradient, color_stops);
+      INIT_PROGRAM_UNIFORM_LOCATION (radial_gradient, num_color_stops);
+      INIT_PROGRAM_UNIFORM_LOCATION (radial_gradient, center);
+      INIT_PROGRAM_UNIFORM_LOCATION (radial_gradient, start);
+      INIT_PROGRAM_UNIFORM_LOCATION (radial_gradient, end);
+      INIT_PROGRAM_UNIFORM_LOCATION (radial_gradient, radius);
+    }
+  else if (prog == &programs->conic_gradient_program)
+    {
+      INIT_PROGRAM_UNIFORM_LOCATION (conic_gradient, color_stops);
+      INIT_PROGRAM_UNIFORM_LOCATION (conic_gradient, num_color_stops);
+      INIT_PROGRAM_UNIFORM_LOCATION (conic_gradient, center);
+      INIT_PROGRAM_UNIFORM_LOCATION (conic_gradient, rotation);
+    }
+  else if (prog == &programs->blur_program)
+    {
+      INIT_PROGRAM_UNIFORM_LOCATION (blur, blur_radius);
+      INIT_PROGRAM_UNIFORM_LOCATION (blur, blur_size);
+      INIT_PROGRAM_UNIFORM_LOCATION (blur, blur_dir);
+    }
+  else if (prog == &programs->inset_shadow_program)
+    {
+      INIT_PROGRAM_UNIFORM_LOCATION (inset_shadow, color);
+      INIT_PROGRAM_UNIFORM_LOCATION (inset_shadow, spread);
+      INIT_PROGRAM_UNIFORM_LOCATION (inset_shadow, offset);
+      INIT_PROGRAM_UNIFORM_LOCATION (inset_shadow, outline_rect);
+    }
+  else if (prog == &programs->outset_shadow_program)
+    {
+      INIT_PROGRAM_UNIFORM_LOCATION (outset_shadow, color);
+      INIT_PROGRAM_UNIFORM_LOCATION (outset_shadow, outline_rect);
+    }
+  else if (prog == &programs->unblurred_outset_shadow_program)
+    {
+      INIT_PROGRAM_UNIFORM_LOCATION (unblurred_outset_shadow, color);
+      INIT_PROGRAM_UNIFORM_LOCATION (unblurred_outset_shadow, spread);
+      INIT_PROGRAM_UNIFORM_LOCATION (unblurred_outset_shadow, offset);
+      INIT_PROGRAM_UNIFORM_LOCATION (unblurred_outset_shadow, outline_rect);
+    }
+  else if (prog == &programs->border_program)
+    {
+      INIT_PROGRAM_UNIFORM_LOCATION (border, color);
+      INIT_PROGRAM_UNIFORM_LOCATION (border, widths);
+      INIT_PROGRAM_UNIFORM_LOCATION (border, outline_rect);
+    }
+  else if (prog == &programs->cross_fade_program)
+    {
+      INIT_PROGRAM_UNIFORM_LOCATION (cross_fade, progress);
+      INIT_PROGRAM_UNIFORM_LOCATION (cross_fade, source2);
+    }
+  else if (prog == &programs->blend_program)
+    {
+      INIT_PROGRAM_UNIFORM_LOCATION (blend, source2);
+      INIT_PROGRAM_UNIFORM_LOCATION (blend, mode);
+    }
+  else if (prog == &programs->repeat_program)
+    {
+      INIT_PROGRAM_UNIFORM_LOCATION (repeat, child_bounds);
+      INIT_PROGRAM_UNIFORM_LOCATION (repeat, texture_rect);
+    }
+
+  return TRUE;
+}
+
+static gboolean
+compile_program (GskGLRenderer          *self,
+                 GskGLRendererPrograms  *programs,
+                 Program                *prog,
+                 GError                **error)
 {
   GskGLShaderBuilder shader_builder;
-  GskGLRendererPrograms *programs = NULL;
-  int i;
-  static const struct {
-    const char *resource_path;
-    const char *name;
-  } program_definitions[] = {
-    { "/org/gtk/libgsk/glsl/blend.glsl",                     "blend" },
-    { "/org/gtk/libgsk/glsl/blit.glsl",                      "blit" },
-    { "/org/gtk/libgsk/glsl/blur.glsl",                      "blur" },
-    { "/org/gtk/libgsk/glsl/border.glsl",                    "border" },
-    { "/org/gtk/libgsk/glsl/color_matrix.glsl",              "color matrix" },
-    { "/org/gtk/libgsk/glsl/color.glsl",                     "color" },
-    { "/org/gtk/libgsk/glsl/coloring.glsl",                  "coloring" },
-    { "/org/gtk/libgsk/glsl/cross_fade.glsl",                "cross fade" },
-    { "/org/gtk/libgsk/glsl/inset_shadow.glsl",              "inset shadow" },
-    { "/org/gtk/libgsk/glsl/linear_gradient.glsl",           "linear gradient" },
-    { "/org/gtk/libgsk/glsl/radial_gradient.glsl",           "radial gradient" },
-    { "/org/gtk/libgsk/glsl/conic_gradient.glsl",            "conic gradient" },
-    { "/org/gtk/libgsk/glsl/outset_shadow.glsl",             "outset shadow" },
-    { "/org/gtk/libgsk/glsl/repeat.glsl",                    "repeat" },
-    { "/org/gtk/libgsk/glsl/unblurred_outset_shadow.glsl",   "unblurred_outset shadow" },
-  };
+  gint64 before G_GNUC_UNUSED;
+
+  g_assert (prog->index >= 0 && prog->index < GL_N_PROGRAMS);
+  g_assert (prog->id == 0);
+
+  before = GDK_PROFILER_CURRENT_TIME;
 
   gsk_gl_shader_builder_init (&shader_builder,
                               "/org/gtk/libgsk/glsl/preamble.glsl",
                               "/org/gtk/libgsk/glsl/preamble.vs.glsl",
                               "/org/gtk/libgsk/glsl/preamble.fs.glsl");
+  init_shader_builder (self, &shader_builder);
 
-  g_assert (G_N_ELEMENTS (program_definitions) == GL_N_PROGRAMS);
+  prog->id = gsk_gl_shader_builder_create_program (&shader_builder,
+                                                   program_definitions[prog->index].resource_path,
+                                                   NULL, 0, error);
+  gsk_gl_shader_builder_finish (&shader_builder);
 
-  init_shader_builder (self, &shader_builder);
+  if (prog->id < 0)
+    return FALSE;
+
+  if (!init_program_uniforms (programs, prog, error))
+    return FALSE;
+
+  /* We initialize the alpha uniform here, since the default value is important.
+   * We can't do it in the shader like a reasonable person would because that doesn't
+   * work in gles. */
+  glUseProgram (prog->id);
+  glUniform1f (prog->alpha_location, 1.0);
+
+  gdk_profiler_end_mark (before, "compile gl program", prog->name);
+
+  return TRUE;
+}
+
+/* Programs are compiled the first time an op needs them, see
+ * ops_set_program(). Called with the GL context current. */
+void
+gsk_gl_renderer_ensure_program (GskGLRenderer *self,
+                                Program       *program)
+{
+  GError *error = NULL;
+
+  if (G_LIKELY (program->id != 0))
+    return;
+
+  GSK_RENDERER_NOTE (GSK_RENDERER (self), OPENGL,
+                     g_message ("Compiling %s program on demand", program->name));
+
+  if (!compile_program (self, self->programs, program, &error))
+    {
+      g_critical ("Failed to compile the %s program: %s", program->name, error->message);
+      g_error_free (error);
+
+      /* Don't try again, draws using it will just be dropped */
+      if (program->id > 0)
+        glDeleteProgram (program->id);
+      program->id = -1;
+    }
+}
+
+static GskGLRendererPrograms *
+gsk_gl_renderer_create_programs (GskGLRenderer  *self,
+                                 GError        **error)
+{
+  GskGLRendererPrograms *programs = NULL;
+  int i;
+
+  g_assert (G_N_ELEMENTS (program_definitions) == GL_N_PROGRAMS);
 
   programs = gsk_gl_renderer_programs_new ();
 
@@ -3345,102 +3808,12 @@ gsk_gl_renderer_create_programs (GskGLRenderer  *self,
 
       prog->name = program_definitions[i].name;
       prog->index = i;
-      prog->id = gsk_gl_shader_builder_create_program (&shader_builder,
-                                                       program_definitions[i].resource_path,
-                                                       NULL, 0, error);
-      if (prog->id < 0)
-        {
-          g_clear_pointer (&programs, gsk_gl_renderer_programs_unref);
-          goto out;
-        }
-
-      INIT_COMMON_UNIFORM_LOCATION (prog, alpha);
-      INIT_COMMON_UNIFORM_LOCATION (prog, source);
-      INIT_COMMON_UNIFORM_LOCATION (prog, clip_rect);
-      INIT_COMMON_UNIFORM_LOCATION (prog, viewport);
-      INIT_COMMON_UNIFORM_LOCATION (prog, projection);
-      INIT_COMMON_UNIFORM_LOCATION (prog, modelview);
     }
-  /* color */
-  INIT_PROGRAM_UNIFORM_LOCATION (color, color);
-
-  /* coloring */
-  INIT_PROGRAM_UNIFORM_LOCATION (coloring, color);
-
-  /* color matrix */
-  INIT_PROGRAM_UNIFORM_LOCATION (color_matrix, color_matrix);
-  INIT_PROGRAM_UNIFORM_LOCATION (color_matrix, color_offset);
-
-  /* linear gradient */
-  INIT_PROGRAM_UNIFORM_LOCATION (linear_gradient, color_stops);
-  INIT_PROGRAM_UNIFORM_LOCATION (linear_gradient, num_color_stops);
-  INIT_PROGRAM_UNIFORM_LOCATION (linear_gradient, start_point);
-  INIT_PROGRAM_UNIFORM_LOCATION (linear_gradient, end_point);
-
-  /* radial gradient */
-  INIT_PROGRAM_UNIFORM_LOCATION (radial_gradient, color_stops);
-  INIT_PROGRAM_UNIFORM_LOCATION (radial_gradient, num_color_stops);
-  INIT_PROGRAM_UNIFORM_LOCATION (radial_gradient, center);
-  INIT_PROGRAM_UNIFORM_LOCATION (radial_gradient, start);
-  INIT_PROGRAM_UNIFORM_LOCATION (radial_gradient, end);
-  INIT_PROGRAM_UNIFORM_LOCATION (radial_gradient, radius);
-
-  /* conic gradient */
-  INIT_PROGRAM_UNIFORM_LOCATION (conic_gradient, color_stops);
-  INIT_PROGRAM_UNIFORM_LOCATION (conic_gradient, num_color_stops);
-  INIT_PROGRAM_UNIFORM_LOCATION (conic_gradient, center);
-  INIT_PROGRAM_UNIFORM_LOCATION (conic_gradient, rotation);
-
-  /* blur */
-  INIT_PROGRAM_UNIFORM_LOCATION (blur, blur_radius);
-  INIT_PROGRAM_UNIFORM_LOCATION (blur, blur_size);
-  INIT_PROGRAM_UNIFORM_LOCATION (blur, blur_dir);
-
-  /* inset shadow */
-  INIT_PROGRAM_UNIFORM_LOCATION (inset_shadow, color);
-  INIT_PROGRAM_UNIFORM_LOCATION (inset_shadow, spread);
-  INIT_PROGRAM_UNIFORM_LOCATION (inset_shadow, offset);
-  INIT_PROGRAM_UNIFORM_LOCATION (inset_shadow, outline_rect);
-
-  /* outset shadow */
-  INIT_PROGRAM_UNIFORM_LOCATION (outset_shadow, color);
-  INIT_PROGRAM_UNIFORM_LOCATION (outset_shadow, outline_rect);
-
-  /* unblurred outset shadow */
-  INIT_PROGRAM_UNIFORM_LOCATION (unblurred_outset_shadow, color);
-  INIT_PROGRAM_UNIFORM_LOCATION (unblurred_outset_shadow, spread);
-  INIT_PROGRAM_UNIFORM_LOCATION (unblurred_outset_shadow, offset);
-  INIT_PROGRAM_UNIFORM_LOCATION (unblurred_outset_shadow, outline_rect);
-
-  /* border */
-  INIT_PROGRAM_UNIFORM_LOCATION (border, color);
-  INIT_PROGRAM_UNIFORM_LOCATION (border, widths);
-  INIT_PROGRAM_UNIFORM_LOCATION (border, outline_rect);
-
-  /* cross fade */
-  INIT_PROGRAM_UNIFORM_LOCATION (cross_fade, progress);
-  INIT_PROGRAM_UNIFORM_LOCATION (cross_fade, source2);
-
-  /* blend */
-  INIT_PROGRAM_UNIFORM_LOCATION (blend, source2);
-  INIT_PROGRAM_UNIFORM_LOCATION (blend, mode);
-
-  /* repeat */
-  INIT_PROGRAM_UNIFORM_LOCATION (repeat, child_bounds);
-  INIT_PROGRAM_UNIFORM_LOCATION (repeat, texture_rect);
 
-
-  /* We initialize the alpha uniform here, since the default value is important.
-   * We can't do it in the shader like a reasonable person would because that doesn't
-   * work in gles. */
-  for (i = 0; i < GL_N_PROGRAMS; i++)
-    {
-      glUseProgram(programs->programs[i].id);
-      glUniform1f (programs->programs[i].alpha_location, 1.0);
-    }
-
-out:
-  gsk_gl_shader_builder_finish (&shader_builder);
+  /* The blit program is needed for practically every frame, compiling it
+   * right away also tells us early whether our shaders work at all. */
+  if (!compile_program (self, programs, &programs->blit_program, error))
+    g_clear_pointer (&programs, gsk_gl_renderer_programs_unref);
 
   /* Check we indeed emitted an error if there was one */
   g_assert (programs || !error || *error);
@@ -3562,6 +3935,9 @@ gsk_gl_renderer_realize (GskRenderer  *renderer,
 
   g_assert (self->gl_driver == NULL);
   self->gl_profiler = gsk_gl_profiler_new (self->gl_context);
+#ifdef G_ENABLE_DEBUG
+  gsk_gl_profiler_set_n_sections (self->gl_profiler, GL_N_PROGRAMS + 1);
+#endif
   self->gl_driver = gsk_gl_driver_new (self->gl_context);
 
   GSK_RENDERER_NOTE (renderer, OPENGL, g_message ("Creating buffers and programs"));
@@ -3570,10 +3946,31 @@ gsk_gl_renderer_realize (GskRenderer  *renderer,
     return FALSE;
   self->op_builder.programs = self->programs;
 
+  /* GL3 shaders get the state common to all programs from a uniform block */
+  ops_set_use_uniform_block (&self->op_builder,
+                             !gdk_gl_context_get_use_es (self->gl_context) &&
+                             !gdk_gl_context_is_legacy (self->gl_context));
+  if (self->op_builder.use_uniform_block)
+    {
+      memset (&self->common_uniforms, 0, sizeof (GskGLCommonUniforms));
+      self->common_uniforms.alpha = 1.0f;
+      self->common_uniforms_dirty = FALSE;
+
+      glGenBuffers (1, &self->common_uniforms_buffer);
+      glBindBuffer (GL_UNIFORM_BUFFER, self->common_uniforms_buffer);
+      glBufferData (GL_UNIFORM_BUFFER, sizeof (GskGLCommonUniforms),
+                    &self->common_uniforms, GL_DYNAMIC_DRAW);
+      gdk_gl_context_label_object (self->gl_context, GL_BUFFER,
+                                   self->common_uniforms_buffer, "Common uniforms");
+    }
+
   self->atlases = get_texture_atlases_for_display (gdk_surface_get_display (surface));
   self->glyph_cache = get_glyph_cache_for_display (gdk_surface_get_display (surface), self->atlases);
+  /* The distance field shader needs fwidth(), which GLSL ES 1.00 lacks */
+  self->glyph_cache->use_sdf = !gdk_gl_context_get_use_es (self->gl_context);
   self->icon_cache = get_icon_cache_for_display (gdk_surface_get_display (surface), self->atlases);
   gsk_gl_shadow_cache_init (&self->shadow_cache);
+  gsk_gl_gradient_cache_init (&self->gradient_cache);
 
   gdk_profiler_end_mark (before, "gl renderer realize", NULL);
 
@@ -3596,11 +3993,19 @@ gsk_gl_renderer_unrealize (GskRenderer *renderer)
   ops_reset (&self->op_builder);
   self->op_builder.programs = NULL;
 
+  if (self->common_uniforms_buffer != 0)
+    {
+      glDeleteBuffers (1, &self->common_uniforms_buffer);
+      self->common_uniforms_buffer = 0;
+    }
+  ops_set_use_uniform_block (&self->op_builder, FALSE);
+
   g_clear_pointer (&self->programs, gsk_gl_renderer_programs_unref);
   g_clear_pointer (&self->glyph_cache, gsk_gl_glyph_cache_unref);
   g_clear_pointer (&self->icon_cache, gsk_gl_icon_cache_unref);
   g_clear_pointer (&self->atlases, gsk_gl_texture_atlases_unref);
   gsk_gl_shadow_cache_free (&self->shadow_cache, self->gl_driver);
+  gsk_gl_gradient_cache_free (&self->gradient_cache, self->gl_driver);
 
   g_clear_object (&self->gl_profiler);
   g_clear_object (&self->gl_driver);
@@ -3663,6 +4068,89 @@ gsk_gl_renderer_setup_render_mode (GskGLRenderer *self)
     }
 }
 
+#define MAX_OCCLUDERS 8
+
+static inline bool
+node_is_opaque (const GskRenderNode *node)
+{
+  switch (gsk_render_node_get_node_type (node))
+    {
+    case GSK_COLOR_NODE:
+      return gsk_color_node_get_color (node)->alpha >= 1.0f;
+
+    case GSK_DEBUG_NODE:
+      return node_is_opaque (gsk_debug_node_get_child (node));
+
+    default:
+      return false;
+    }
+}
+
+/* Walks the children of @node front to back, collecting the bounds of
+ * opaque children, and marks every child that is entirely covered by a
+ * child painted later on. All children share the coordinate system of
+ * @node, so this works regardless of the current modelview.
+ *
+ * Returns the number of children that can be skipped. */
+static guint
+cull_occluded_children (GskRenderNode *node,
+                        bool          *culled)
+{
+  graphene_rect_t occluders[MAX_OCCLUDERS];
+  guint n_occluders = 0;
+  guint n_culled = 0;
+  guint j;
+  int i;
+
+  for (i = (int) gsk_container_node_get_n_children (node) - 1; i >= 0; i--)
+    {
+      GskRenderNode *child = gsk_container_node_get_child (node, i);
+
+      culled[i] = false;
+
+      for (j = 0; j < n_occluders; j++)
+        {
+          if (_graphene_rect_contains_rect (&occluders[j], &child->bounds))
+            {
+              culled[i] = true;
+              n_culled++;
+              break;
+            }
+        }
+
+      if (!culled[i] && node_is_opaque (child))
+        {
+          guint smallest = 0;
+
+          if (n_occluders < MAX_OCCLUDERS)
+            {
+              occluders[n_occluders++] = child->bounds;
+              continue;
+            }
+
+          /* Out of slots, replace the smallest occluder if this one is bigger */
+          for (j = 1; j < n_occluders; j++)
+            {
+              if (occluders[j].size.width * occluders[j].size.height <
+                  occluders[smallest].size.width * occluders[smallest].size.height)
+                smallest = j;
+            }
+
+          if (child->bounds.size.width * child->bounds.size.height >
+              occluders[smallest].size.width * occluders[smallest].size.height)
+            occluders[smallest] = child->bounds;
+        }
+    }
+
+  return n_culled;
+}
+
+/* Note that building ops is not a pure function of the node tree: it
+ * uploads textures and glyphs, compiles programs on first use and
+ * creates render targets for offscreens, and it threads the clip,
+ * modelview and program state of the builder from one node to the next.
+ * So it has to run on the thread owning the GL context, and subtrees
+ * can't be built independently of what came before them. */
 static void
 gsk_gl_renderer_add_render_ops (GskGLRenderer   *self,
                                 GskRenderNode   *node,
@@ -3695,13 +4183,37 @@ gsk_gl_renderer_add_render_ops (GskGLRenderer   *self,
     case GSK_CONTAINER_NODE:
       {
         guint i, p;
+        guint n_culled;
+        bool *culled;
+
+        p = gsk_container_node_get_n_children (node);
+        if (p <= 256)
+          culled = g_newa (bool, p);
+        else
+          culled = g_new (bool, p);
+        n_culled = cull_occluded_children (node, culled);
 
-        for (i = 0, p = gsk_container_node_get_n_children (node); i < p; i ++)
+#ifdef G_ENABLE_DEBUG
+        if (n_culled > 0)
+          gsk_profiler_counter_add (gsk_renderer_get_profiler (GSK_RENDERER (self)),
+                                    self->profile_counters.culled_nodes,
+                                    n_culled);
+#else
+        (void) n_culled;
+#endif
+
+        for (i = 0; i < p; i ++)
           {
             GskRenderNode *child = gsk_container_node_get_child (node, i);
 
+            if (culled[i])
+              continue;
+
             gsk_gl_renderer_add_render_ops (self, child, builder);
           }
+
+        if (p > 256)
+          g_free (culled);
       }
     break;
 
@@ -3854,7 +4366,7 @@ add_offscreen_ops (GskGLRenderer         *self,
       (flags & FORCE_OFFSCREEN) == 0)
     {
       GdkTexture *texture = gsk_texture_node_get_texture (child_node);
-      upload_texture (self, texture, texture_region_out);
+      upload_texture (self, texture, GL_LINEAR, texture_region_out);
       *is_offscreen = FALSE;
       return TRUE;
     }
@@ -3997,7 +4509,7 @@ gsk_gl_renderer_render_ops (GskGLRenderer *self)
   OpBufferIter iter;
   OpKind kind;
   gpointer ptr;
-  GLuint buffer_id, vao_id;
+  GLuint vao_id;
 
 #if DEBUG_OPS
   g_print ("============================================\n");
@@ -4006,10 +4518,7 @@ gsk_gl_renderer_render_ops (GskGLRenderer *self)
   glGenVertexArrays (1, &vao_id);
   glBindVertexArray (vao_id);
 
-  glGenBuffers (1, &buffer_id);
-  glBindBuffer (GL_ARRAY_BUFFER, buffer_id);
-
-  glBufferData (GL_ARRAY_BUFFER, vertex_data_size, vertex_data, GL_STATIC_DRAW);
+  gsk_gl_driver_upload_vertices (self->gl_driver, vertex_data, vertex_data_size);
 
   /* 0 = position location */
   glEnableVertexAttribArray (0);
@@ -4021,6 +4530,14 @@ gsk_gl_renderer_render_ops (GskGLRenderer *self)
   glVertexAttribPointer (1, 2, GL_FLOAT, GL_FALSE,
                          sizeof (GskQuadVertex),
                          (void *) G_STRUCT_OFFSET (GskQuadVertex, uv));
+  /* 2 = color location */
+  glEnableVertexAttribArray (2);
+  glVertexAttribPointer (2, 4, GL_FLOAT, GL_FALSE,
+                         sizeof (GskQuadVertex),
+                         (void *) G_STRUCT_OFFSET (GskQuadVertex, color));
+
+  if (self->op_builder.use_uniform_block)
+    glBindBufferBase (GL_UNIFORM_BUFFER, GSK_GL_COMMON_UNIFORMS_BINDING, self->common_uniforms_buffer);
 
   op_buffer_iter_init (&iter, ops_get_buffer (&self->op_builder));
   while ((ptr = op_buffer_iter_next (&iter, &kind)))
@@ -4028,6 +4545,10 @@ gsk_gl_renderer_render_ops (GskGLRenderer *self)
       if (kind == OP_NONE)
         continue;
 
+      if (self->op_builder.use_uniform_block &&
+          apply_common_uniform_op (self, kind, ptr))
+        continue;
+
       if (program == NULL &&
           kind != OP_PUSH_DEBUG_GROUP &&
           kind != OP_POP_DEBUG_GROUP &&
@@ -4053,6 +4574,10 @@ gsk_gl_renderer_render_ops (GskGLRenderer *self)
             const OpProgram *op = ptr;
             apply_program_op (program, op);
             program = op->program;
+#ifdef G_ENABLE_DEBUG
+            gsk_gl_profiler_begin_section (self->gl_profiler,
+                                           program->index >= 0 ? program->index : GL_N_PROGRAMS);
+#endif
             break;
           }
 
@@ -4079,8 +4604,7 @@ gsk_gl_renderer_render_ops (GskGLRenderer *self)
           break;
 
         case OP_CHANGE_COLOR:
-          /*g_assert (program == &self->color_program || program == &self->coloring_program ||*/
-                    /*program == &self->shadow_program);*/
+          g_assert (program == &self->programs->outset_shadow_program);
           apply_color_op (program, ptr);
           break;
 
@@ -4161,6 +4685,8 @@ gsk_gl_renderer_render_ops (GskGLRenderer *self)
             OP_PRINT (" -> draw %ld, size %ld and program %d: %s",
                       op->vao_offset, op->vao_size, program->index,
                       program->name ?: "");
+            if (self->op_builder.use_uniform_block)
+              flush_common_uniforms (self);
             glDrawArrays (GL_TRIANGLES, op->vao_offset, op->vao_size);
             break;
           }
@@ -4195,7 +4721,7 @@ gsk_gl_renderer_render_ops (GskGLRenderer *self)
     }
 
   glDeleteVertexArrays (1, &vao_id);
-  glDeleteBuffers (1, &buffer_id);
+  gsk_gl_driver_release_vertices (self->gl_driver);
 }
 
 static void
@@ -4211,6 +4737,7 @@ gsk_gl_renderer_do_render (GskRenderer           *renderer,
   GskProfiler *profiler;
   gint64 gpu_time, cpu_time;
   gint64 start_time G_GNUC_UNUSED;
+  guint i;
 #endif
   GPtrArray *removed;
 
@@ -4226,11 +4753,14 @@ gsk_gl_renderer_do_render (GskRenderer           *renderer,
 
   g_assert (gsk_gl_driver_in_frame (self->gl_driver));
 
-  removed = g_ptr_array_new ();
+  /* Removed atlases are only freed after the caches had a chance to move
+   * their live entries elsewhere */
+  removed = g_ptr_array_new_with_free_func (gsk_gl_texture_atlas_destroy);
   gsk_gl_texture_atlases_begin_frame (self->atlases, removed);
   gsk_gl_glyph_cache_begin_frame (self->glyph_cache, self->gl_driver, removed);
   gsk_gl_icon_cache_begin_frame (self->icon_cache, removed);
   gsk_gl_shadow_cache_begin_frame (&self->shadow_cache, self->gl_driver);
+  gsk_gl_gradient_cache_begin_frame (&self->gradient_cache, self->gl_driver);
   g_ptr_array_unref (removed);
 
   /* Set up the modelview and projection matrices to fit our viewport */
@@ -4319,6 +4849,10 @@ gsk_gl_renderer_do_render (GskRenderer           *renderer,
   gpu_time = gsk_gl_profiler_end_gpu_region (self->gl_profiler);
   gsk_profiler_timer_set (profiler, self->profile_timers.gpu_time, gpu_time);
 
+  for (i = 0; i < G_N_ELEMENTS (self->profile_timers.program_gpu_time); i++)
+    gsk_profiler_timer_set (profiler, self->profile_timers.program_gpu_time[i],
+                            gsk_gl_profiler_get_section_time (self->gl_profiler, i));
+
   gsk_profiler_push_samples (profiler);
 
   gdk_profiler_add_mark (start_time * 1000, cpu_time * 1000, "GL render", "");
@@ -4459,6 +4993,7 @@ gsk_gl_renderer_render (GskRenderer          *renderer,
   graphene_rect_t viewport;
   const cairo_region_t *damage;
   GdkRectangle whole_surface;
+  GdkRectangle surface_rect;
   GdkSurface *surface;
 
   if (self->gl_context == NULL)
@@ -4480,9 +5015,16 @@ gsk_gl_renderer_render (GskRenderer          *renderer,
   gdk_draw_context_begin_frame (GDK_DRAW_CONTEXT (self->gl_context),
                                 update_area);
 
+  /* The frame region is in surface coordinates, while whole_surface
+   * is in device pixels */
   damage = gdk_draw_context_get_frame_region (GDK_DRAW_CONTEXT (self->gl_context));
+  surface_rect = (GdkRectangle) {
+                     0, 0,
+                     gdk_surface_get_width (surface),
+                     gdk_surface_get_height (surface)
+                 };
 
-  if (cairo_region_contains_rectangle (damage, &whole_surface) == CAIRO_REGION_OVERLAP_IN)
+  if (cairo_region_contains_rectangle (damage, &surface_rect) == CAIRO_REGION_OVERLAP_IN)
     {
       self->render_region = NULL;
     }
@@ -4491,8 +5033,9 @@ gsk_gl_renderer_render (GskRenderer          *renderer,
       GdkRectangle extents;
 
       cairo_region_get_extents (damage, &extents);
+      gdk_rectangle_intersect (&extents, &surface_rect, &extents);
 
-      if (gdk_rectangle_equal (&extents, &whole_surface))
+      if (gdk_rectangle_equal (&extents, &surface_rect))
         self->render_region = NULL;
       else
         self->render_region = cairo_region_create_rectangle (&extents);
@@ -4531,6 +5074,7 @@ gsk_gl_renderer_class_init (GskGLRendererClass *klass)
   renderer_class->unrealize = gsk_gl_renderer_unrealize;
   renderer_class->render = gsk_gl_renderer_render;
   renderer_class->render_texture = gsk_gl_renderer_render_texture;
+  renderer_class->supports_offload = TRUE;
 }
 
 static void
@@ -4544,11 +5088,30 @@ gsk_gl_renderer_init (GskGLRenderer *self)
 #ifdef G_ENABLE_DEBUG
   {
     GskProfiler *profiler = gsk_renderer_get_profiler (GSK_RENDERER (self));
+    guint i;
 
     self->profile_counters.frames = gsk_profiler_add_counter (profiler, "frames", "Frames", FALSE);
+    self->profile_counters.culled_nodes = gsk_profiler_add_counter (profiler, "culled-nodes", "Occluded nodes skipped", TRUE);
+    self->profile_counters.glyph_cache_hits = gsk_profiler_add_counter (profiler, "glyph-cache-hits", "Glyphs found in the cache", TRUE);
+    self->profile_counters.glyph_cache_misses = gsk_profiler_add_counter (profiler, "glyph-cache-misses", "Glyphs rendered and uploaded", TRUE);
+    self->profile_counters.fallback_cache_hits = gsk_profiler_add_counter (profiler, "fallback-cache-hits", "Fallbacks found in the cache", TRUE);
+    self->profile_counters.fallback_cache_misses = gsk_profiler_add_counter (profiler, "fallback-cache-misses", "Fallbacks rendered with cairo", TRUE);
 
     self->profile_timers.cpu_time = gsk_profiler_add_timer (profiler, "cpu-time", "CPU time", FALSE, TRUE);
     self->profile_timers.gpu_time = gsk_profiler_add_timer (profiler, "gpu-time", "GPU time", FALSE, TRUE);
+
+    for (i = 0; i < GL_N_PROGRAMS + 1; i++)
+      {
+        const char *name = i < GL_N_PROGRAMS ? program_definitions[i].name : "custom shaders";
+        char *timer_name = g_strdup_printf ("gpu-time-%s", name);
+        char *description = g_strdup_printf ("GPU time (%s)", name);
+
+        self->profile_timers.program_gpu_time[i] =
+          gsk_profiler_add_timer (profiler, timer_name, description, FALSE, TRUE);
+
+        g_free (timer_name);
+        g_free (description);
+      }
   }
 #endif
 }
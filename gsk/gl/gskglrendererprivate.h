@@ -9,6 +9,9 @@ gboolean gsk_gl_renderer_try_compile_gl_shader (GskGLRenderer    *self,
                                                 GskGLShader      *shader,
                                                 GError          **error);
 
+void     gsk_gl_renderer_ensure_program        (GskGLRenderer    *self,
+                                                struct _Program  *program);
+
 G_END_DECLS
 
 #endif /* __GSK_GL_RENDERER_PRIVATE_H__ */
@@ -1,4 +1,5 @@
 #include "gskglrenderopsprivate.h"
+#include "gskglrendererprivate.h"
 #include "gsktransform.h"
 
 typedef struct
@@ -63,6 +64,18 @@ get_current_program_state (RenderOpBuilder *builder)
   return &builder->current_program->state;
 }
 
+/* The state projection, modelview, viewport, clip and opacity are
+ * compared against. This is the same for all programs if they share
+ * a uniform block for it. */
+static inline ProgramState *
+get_common_state (RenderOpBuilder *builder)
+{
+  if (builder->use_uniform_block)
+    return &builder->common_state;
+
+  return get_current_program_state (builder);
+}
+
 void
 ops_finish (RenderOpBuilder *builder)
 {
@@ -194,6 +207,7 @@ ops_init (RenderOpBuilder *builder)
   memset (builder, 0, sizeof (*builder));
 
   builder->current_opacity = 1.0f;
+  builder->common_state.opacity = 1.0f;
 
   op_buffer_init (&builder->render_ops);
   builder->vertices = g_array_new (FALSE, TRUE, sizeof (GskQuadVertex));
@@ -202,10 +216,24 @@ ops_init (RenderOpBuilder *builder)
 void
 ops_free (RenderOpBuilder *builder)
 {
+  g_clear_pointer (&builder->common_state.modelview, gsk_transform_unref);
   g_array_unref (builder->vertices);
   op_buffer_destroy (&builder->render_ops);
 }
 
+/* Must be called whenever the storage of the shared uniform block
+ * is (re)created, since it drops all state tracked for it. */
+void
+ops_set_use_uniform_block (RenderOpBuilder *builder,
+                           bool             use_uniform_block)
+{
+  g_clear_pointer (&builder->common_state.modelview, gsk_transform_unref);
+  memset (&builder->common_state, 0, sizeof (ProgramState));
+  builder->common_state.opacity = 1.0f;
+
+  builder->use_uniform_block = use_uniform_block;
+}
+
 void
 ops_set_program (RenderOpBuilder *builder,
                  Program   *program)
@@ -216,11 +244,19 @@ ops_set_program (RenderOpBuilder *builder,
   if (builder->current_program == program)
     return;
 
+  /* Built-in programs are only compiled once they are needed */
+  if (G_UNLIKELY (program->id == 0 && program->index >= 0))
+    gsk_gl_renderer_ensure_program (builder->renderer, program);
+
   op = ops_begin (builder, OP_CHANGE_PROGRAM);
   op->program = program;
 
   builder->current_program = program;
 
+  /* Nothing to sync if all programs share the common state */
+  if (builder->use_uniform_block)
+    return;
+
   program_state = &program->state;
 
   if (memcmp (&builder->current_projection, &program_state->projection, sizeof (graphene_matrix_t)) != 0)
@@ -276,7 +312,7 @@ static void
 ops_set_clip (RenderOpBuilder      *builder,
               const GskRoundedRect *clip)
 {
-  ProgramState *current_program_state = get_current_program_state (builder);
+  ProgramState *current_program_state = get_common_state (builder);
   OpClip *op;
 
   if (current_program_state &&
@@ -356,7 +392,7 @@ static void
 ops_set_modelview_internal (RenderOpBuilder *builder,
                             GskTransform    *transform)
 {
-  ProgramState *current_program_state = get_current_program_state (builder);
+  ProgramState *current_program_state = get_common_state (builder);
   OpMatrix *op;
 
 #if 0
@@ -371,7 +407,7 @@ ops_set_modelview_internal (RenderOpBuilder *builder,
 
   gsk_transform_to_matrix (transform, &op->matrix);
 
-  if (builder->current_program != NULL)
+  if (current_program_state != NULL)
     {
       gsk_transform_unref (current_program_state->modelview);
       current_program_state->modelview = gsk_transform_ref (transform);
@@ -492,7 +528,7 @@ graphene_matrix_t
 ops_set_projection (RenderOpBuilder         *builder,
                     const graphene_matrix_t *projection)
 {
-  ProgramState *current_program_state = get_current_program_state (builder);
+  ProgramState *current_program_state = get_common_state (builder);
   graphene_matrix_t prev_mv;
   OpMatrix *op;
 
@@ -501,7 +537,7 @@ ops_set_projection (RenderOpBuilder         *builder,
 
   op->matrix = *projection;
 
-  if (builder->current_program != NULL)
+  if (current_program_state != NULL)
     current_program_state->projection = *projection;
 
   prev_mv = builder->current_projection;
@@ -514,7 +550,7 @@ graphene_rect_t
 ops_set_viewport (RenderOpBuilder       *builder,
                   const graphene_rect_t *viewport)
 {
-  ProgramState *current_program_state = get_current_program_state (builder);
+  ProgramState *current_program_state = get_common_state (builder);
   OpViewport *op;
   graphene_rect_t prev_viewport;
 
@@ -586,7 +622,7 @@ float
 ops_set_opacity (RenderOpBuilder *builder,
                  float            opacity)
 {
-  ProgramState *current_program_state = get_current_program_state (builder);
+  ProgramState *current_program_state = get_common_state (builder);
   OpOpacity *op;
   float prev_opacity;
 
@@ -601,7 +637,7 @@ ops_set_opacity (RenderOpBuilder *builder,
   prev_opacity = builder->current_opacity;
   builder->current_opacity = opacity;
 
-  if (builder->current_program != NULL)
+  if (current_program_state != NULL)
     current_program_state->opacity = opacity;
 
   return prev_opacity;
@@ -751,10 +787,37 @@ ops_set_border_color (RenderOpBuilder *builder,
   current_program_state->border.color = *color;
 }
 
+/* The color and coloring programs take their color as a vertex
+ * attribute instead of a uniform, so changing the color between two
+ * draws doesn't need a new op and the draws can be merged into one. */
+void
+ops_set_vertex_color (RenderOpBuilder *builder,
+                      const GdkRGBA   *color)
+{
+  builder->current_vertex_color = *color;
+}
+
+static inline void
+load_vertex_color (const RenderOpBuilder *builder,
+                   GskQuadVertex          vertices[GL_N_VERTICES])
+{
+  const GdkRGBA *c = &builder->current_vertex_color;
+  int i;
+
+  for (i = 0; i < GL_N_VERTICES; i ++)
+    {
+      vertices[i].color[0] = c->red;
+      vertices[i].color[1] = c->green;
+      vertices[i].color[2] = c->blue;
+      vertices[i].color[3] = c->alpha;
+    }
+}
+
 GskQuadVertex *
 ops_draw (RenderOpBuilder     *builder,
           const GskQuadVertex  vertex_data[GL_N_VERTICES])
 {
+  GskQuadVertex *vertices;
   OpDraw *op;
 
   if ((op = op_buffer_peek_tail_checked (&builder->render_ops, OP_DRAW)))
@@ -771,11 +834,16 @@ ops_draw (RenderOpBuilder     *builder,
   if (vertex_data)
     {
       g_array_append_vals (builder->vertices, vertex_data, GL_N_VERTICES);
+      load_vertex_color (builder, &g_array_index (builder->vertices, GskQuadVertex,
+                                                  builder->vertices->len - GL_N_VERTICES));
       return NULL; /* Better not use this on the caller side */
     }
 
   g_array_set_size (builder->vertices, builder->vertices->len + GL_N_VERTICES);
-  return &g_array_index (builder->vertices, GskQuadVertex, builder->vertices->len - GL_N_VERTICES);
+  vertices = &g_array_index (builder->vertices, GskQuadVertex, builder->vertices->len - GL_N_VERTICES);
+  load_vertex_color (builder, vertices);
+
+  return vertices;
 }
 
 /* The offset is only valid for the current modelview.
@@ -986,6 +1054,10 @@ ops_set_linear_gradient (RenderOpBuilder     *self,
   else
     op->color_stops.send = TRUE;
 
+  /* No stops means the colors come from a ramp texture */
+  if (real_n_color_stops == 0)
+    op->color_stops.send = FALSE;
+
   if (op->color_stops.send)
     {
       op->color_stops.value = color_stops;
@@ -1020,7 +1092,7 @@ ops_set_radial_gradient (RenderOpBuilder    *self,
   op->n_color_stops.value = real_n_color_stops;
   op->n_color_stops.send = true;
   op->color_stops.value = color_stops;
-  op->color_stops.send = true;
+  op->color_stops.send = real_n_color_stops > 0;
   op->center[0] = center_x;
   op->center[1] = center_y;
   op->radius[0] = hradius;
@@ -1046,7 +1118,7 @@ ops_set_conic_gradient (RenderOpBuilder    *self,
   op->n_color_stops.value = real_n_color_stops;
   op->n_color_stops.send = true;
   op->color_stops.value = color_stops;
-  op->color_stops.send = true;
+  op->color_stops.send = real_n_color_stops > 0;
   op->center[0] = center_x;
   op->center[1] = center_y;
   op->rotation = rotation;
@@ -13,7 +13,7 @@
 #include "opbuffer.h"
 
 #define GL_N_VERTICES 6
-#define GL_N_PROGRAMS 15
+#define GL_N_PROGRAMS 16
 #define GL_MAX_GRADIENT_STOPS 6
 
 typedef struct
@@ -83,7 +83,8 @@ typedef struct
       float width;
       float height;
       gint uniform_data_len;
-      guchar uniform_data[32];
+      /* Large enough for the 8 vec4 args a GskGLShader can have */
+      guchar uniform_data[8 * 4 * sizeof (float)];
     } gl_shader;
   };
 } ProgramState;
@@ -105,12 +106,6 @@ struct _Program
   int modelview_location;
   int clip_rect_location;
   union {
-    struct {
-      int color_location;
-    } color;
-    struct {
-      int color_location;
-    } coloring;
     struct {
       int color_matrix_location;
       int color_offset_location;
@@ -203,6 +198,7 @@ typedef struct {
       Program outset_shadow_program;
       Program repeat_program;
       Program unblurred_outset_shadow_program;
+      Program sdf_text_program;
     };
   };
   GHashTable *custom_programs; /* GskGLShader -> Program* */
@@ -218,6 +214,7 @@ typedef struct
   graphene_matrix_t current_projection;
   graphene_rect_t current_viewport;
   float current_opacity;
+  GdkRGBA current_vertex_color;
   float dx, dy;
   float scale_x, scale_y;
 
@@ -235,6 +232,12 @@ typedef struct
   /* Pointer into clip_stack */
   const GskRoundedRect *current_clip;
   bool clip_is_rectilinear;
+
+  /* If set, projection, modelview, viewport, clip and opacity live in
+   * a uniform block shared by all programs and are tracked in
+   * common_state instead of the per-program state. */
+  bool use_uniform_block;
+  ProgramState common_state;
 } RenderOpBuilder;
 
 
@@ -257,6 +260,8 @@ void              ops_set_modelview      (RenderOpBuilder         *builder,
 void              ops_pop_modelview      (RenderOpBuilder         *builder);
 void              ops_set_program        (RenderOpBuilder         *builder,
                                           Program                 *program);
+void              ops_set_use_uniform_block (RenderOpBuilder      *builder,
+                                             bool                  use_uniform_block);
 
 void              ops_push_clip          (RenderOpBuilder         *builder,
                                           const GskRoundedRect    *clip);
@@ -286,6 +291,8 @@ float             ops_set_opacity        (RenderOpBuilder         *builder,
                                           float                    opacity);
 void              ops_set_color          (RenderOpBuilder         *builder,
                                           const GdkRGBA           *color);
+void              ops_set_vertex_color   (RenderOpBuilder         *builder,
+                                          const GdkRGBA           *color);
 
 void              ops_set_color_matrix   (RenderOpBuilder         *builder,
                                           const graphene_matrix_t *matrix,
@@ -22,6 +22,24 @@ gsk_gl_shader_builder_init (GskGLShaderBuilder *self,
   g_assert (self->preamble);
   g_assert (self->vs_preamble);
   g_assert (self->fs_preamble);
+
+  /* Cache linked programs on disk if the driver lets us, see
+   * gsk_gl_shader_builder_create_program() */
+  if (!g_getenv ("GSK_NO_PROGRAM_CACHE"))
+    {
+      GLint n_formats = 0;
+
+      if (epoxy_is_desktop_gl ())
+        self->program_binaries = epoxy_gl_version () >= 41 ||
+                                 epoxy_has_gl_extension ("GL_ARB_get_program_binary");
+      else
+        self->program_binaries = epoxy_gl_version () >= 30;
+
+      if (self->program_binaries)
+        glGetIntegerv (GL_NUM_PROGRAM_BINARY_FORMATS, &n_formats);
+
+      self->program_binaries = n_formats > 0;
+    }
 }
 
 void
@@ -126,6 +144,112 @@ print_shader_info (const char *prefix,
     }
 }
 
+static GFile *
+get_program_cache_file (GskGLShaderBuilder  *self,
+                        const char         **vs_sources,
+                        const int           *vs_lengths,
+                        guint                n_vs_sources,
+                        const char         **fs_sources,
+                        const int           *fs_lengths,
+                        guint                n_fs_sources)
+{
+  GChecksum *checksum;
+  char *filename;
+  char *path;
+  GFile *file;
+  guint i;
+
+  checksum = g_checksum_new (G_CHECKSUM_SHA256);
+
+  /* Binaries are only valid for the exact driver that produced them */
+  g_checksum_update (checksum, (const guchar *) glGetString (GL_VENDOR), -1);
+  g_checksum_update (checksum, (const guchar *) glGetString (GL_RENDERER), -1);
+  g_checksum_update (checksum, (const guchar *) glGetString (GL_VERSION), -1);
+
+  for (i = 0; i < n_vs_sources; i ++)
+    g_checksum_update (checksum, (const guchar *) vs_sources[i], vs_lengths[i]);
+  for (i = 0; i < n_fs_sources; i ++)
+    g_checksum_update (checksum, (const guchar *) fs_sources[i], fs_lengths[i]);
+
+  filename = g_strconcat (g_checksum_get_string (checksum), ".bin", NULL);
+  path = g_build_filename (g_get_user_cache_dir (), "gtk-4.0", "gsk", "programs", filename, NULL);
+  file = g_file_new_for_path (path);
+
+  g_free (path);
+  g_free (filename);
+  g_checksum_free (checksum);
+
+  return file;
+}
+
+/* The cache files contain the binary format as a guint32
+ * followed by the data from glGetProgramBinary() */
+static int
+load_cached_program (GFile *file)
+{
+  char *contents;
+  gsize length;
+  guint32 format;
+  int program_id;
+  int status;
+
+  if (!g_file_load_contents (file, NULL, &contents, &length, NULL, NULL))
+    return -1;
+
+  if (length <= sizeof (guint32))
+    {
+      g_free (contents);
+      return -1;
+    }
+
+  memcpy (&format, contents, sizeof (guint32));
+
+  program_id = glCreateProgram ();
+  glProgramBinary (program_id, format,
+                   contents + sizeof (guint32), length - sizeof (guint32));
+  g_free (contents);
+
+  glGetProgramiv (program_id, GL_LINK_STATUS, &status);
+  if (status == GL_FALSE)
+    {
+      /* Outdated or broken, it gets replaced once we compiled the program again */
+      GSK_NOTE (SHADERS, g_message ("Rejected cached program binary %s", g_file_peek_path (file)));
+      glDeleteProgram (program_id);
+      return -1;
+    }
+
+  return program_id;
+}
+
+static void
+store_cached_program (GFile *file,
+                      int    program_id)
+{
+  GFile *parent;
+  guchar *contents;
+  GLenum format;
+  int length = 0;
+  guint32 format32;
+
+  glGetProgramiv (program_id, GL_PROGRAM_BINARY_LENGTH, &length);
+  if (length <= 0)
+    return;
+
+  contents = g_malloc (sizeof (guint32) + length);
+  glGetProgramBinary (program_id, length, &length, &format, contents + sizeof (guint32));
+  format32 = format;
+  memcpy (contents, &format32, sizeof (guint32));
+
+  parent = g_file_get_parent (file);
+  g_file_make_directory_with_parents (parent, NULL, NULL);
+  g_object_unref (parent);
+
+  g_file_replace_contents (file, (const char *) contents, sizeof (guint32) + length,
+                           NULL, FALSE, G_FILE_CREATE_NONE, NULL, NULL, NULL);
+
+  g_free (contents);
+}
+
 int
 gsk_gl_shader_builder_create_program (GskGLShaderBuilder  *self,
                                       const char          *resource_path,
@@ -139,10 +263,16 @@ gsk_gl_shader_builder_create_program (GskGLShaderBuilder  *self,
   const char *source;
   const char *vertex_shader_start;
   const char *fragment_shader_start;
+  const char *vs_sources[8];
+  int vs_lengths[8];
+  const char *fs_sources[9];
+  int fs_lengths[9];
+  GFile *cache_file = NULL;
   int vertex_id;
   int fragment_id;
   int program_id = -1;
   int status;
+  guint i;
 
   g_assert (source_bytes);
 
@@ -160,28 +290,44 @@ gsk_gl_shader_builder_create_program (GskGLShaderBuilder  *self,
   g_snprintf (version_buffer, sizeof (version_buffer),
               "#version %d\n", self->version);
 
+  vs_sources[0] = version_buffer;
+  vs_sources[1] = self->debugging ? "#define GSK_DEBUG 1\n" : "";
+  vs_sources[2] = self->legacy ? "#define GSK_LEGACY 1\n" : "";
+  vs_sources[3] = self->gl3 ? "#define GSK_GL3 1\n" : "";
+  vs_sources[4] = self->gles ? "#define GSK_GLES 1\n" : "";
+  vs_sources[5] = g_bytes_get_data (self->preamble, NULL);
+  vs_sources[6] = g_bytes_get_data (self->vs_preamble, NULL);
+  vs_sources[7] = vertex_shader_start;
+
+  for (i = 0; i < 7; i ++)
+    vs_lengths[i] = -1;
+  vs_lengths[7] = fragment_shader_start - vertex_shader_start;
+
+  memcpy (fs_sources, vs_sources, 5 * sizeof (char *));
+  fs_sources[5] = g_bytes_get_data (self->preamble, NULL);
+  fs_sources[6] = g_bytes_get_data (self->fs_preamble, NULL);
+  fs_sources[7] = fragment_shader_start;
+  fs_sources[8] = extra_fragment_snippet ? extra_fragment_snippet : "";
+
+  for (i = 0; i < 8; i ++)
+    fs_lengths[i] = -1;
+  fs_lengths[8] = extra_fragment_snippet ? extra_fragment_length : 0;
+
+  if (self->program_binaries && !self->debugging)
+    {
+      cache_file = get_program_cache_file (self,
+                                           vs_sources, vs_lengths, G_N_ELEMENTS (vs_sources),
+                                           fs_sources, fs_lengths, G_N_ELEMENTS (fs_sources));
+      program_id = load_cached_program (cache_file);
+      if (program_id > 0)
+        {
+          g_clear_object (&cache_file);
+          goto linked;
+        }
+    }
+
   vertex_id = glCreateShader (GL_VERTEX_SHADER);
-  glShaderSource (vertex_id, 8,
-                  (const char *[]) {
-                    version_buffer,
-                    self->debugging ? "#define GSK_DEBUG 1\n" : "",
-                    self->legacy ? "#define GSK_LEGACY 1\n" : "",
-                    self->gl3 ? "#define GSK_GL3 1\n" : "",
-                    self->gles ? "#define GSK_GLES 1\n" : "",
-                    g_bytes_get_data (self->preamble, NULL),
-                    g_bytes_get_data (self->vs_preamble, NULL),
-                    vertex_shader_start
-                  },
-                  (int[]) {
-                    -1,
-                    -1,
-                    -1,
-                    -1,
-                    -1,
-                    -1,
-                    -1,
-                    fragment_shader_start - vertex_shader_start
-                  });
+  glShaderSource (vertex_id, G_N_ELEMENTS (vs_sources), vs_sources, vs_lengths);
   glCompileShader (vertex_id);
 
   if (!check_shader_error (vertex_id, error))
@@ -193,29 +339,7 @@ gsk_gl_shader_builder_create_program (GskGLShaderBuilder  *self,
   print_shader_info ("Vertex shader", vertex_id, resource_path);
 
   fragment_id = glCreateShader (GL_FRAGMENT_SHADER);
-  glShaderSource (fragment_id, 9,
-                  (const char *[]) {
-                    version_buffer,
-                    self->debugging ? "#define GSK_DEBUG 1\n" : "",
-                    self->legacy ? "#define GSK_LEGACY 1\n" : "",
-                    self->gl3 ? "#define GSK_GL3 1\n" : "",
-                    self->gles ? "#define GSK_GLES 1\n" : "",
-                    g_bytes_get_data (self->preamble, NULL),
-                    g_bytes_get_data (self->fs_preamble, NULL),
-                    fragment_shader_start,
-                    extra_fragment_snippet ? extra_fragment_snippet : ""
-                  },
-                  (int[]) {
-                    -1,
-                    -1,
-                    -1,
-                    -1,
-                    -1,
-                    -1,
-                    -1,
-                    -1,
-                    extra_fragment_length,
-                  });
+  glShaderSource (fragment_id, G_N_ELEMENTS (fs_sources), fs_sources, fs_lengths);
   glCompileShader (fragment_id);
 
   if (!check_shader_error (fragment_id, error))
@@ -230,7 +354,10 @@ gsk_gl_shader_builder_create_program (GskGLShaderBuilder  *self,
   glAttachShader (program_id, vertex_id);
   glAttachShader (program_id, fragment_id);
   glBindAttribLocation (program_id, 0, "aPosition");
-  glBindAttribLocation (program_id, 1, "vUv");
+  glBindAttribLocation (program_id, 1, "aUv");
+  glBindAttribLocation (program_id, 2, "aColor");
+  if (cache_file != NULL)
+    glProgramParameteri (program_id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
   glLinkProgram (program_id);
 
   glGetProgramiv (program_id, GL_LINK_STATUS, &status);
@@ -262,9 +389,22 @@ gsk_gl_shader_builder_create_program (GskGLShaderBuilder  *self,
   glDetachShader (program_id, fragment_id);
   glDeleteShader (fragment_id);
 
+  if (cache_file != NULL)
+    store_cached_program (cache_file, program_id);
+
+linked:
+  /* Uniform block bindings are not part of the program binary */
+  if (self->gl3)
+    {
+      GLuint block_index = glGetUniformBlockIndex (program_id, "GskCommon");
+
+      if (block_index != GL_INVALID_INDEX)
+        glUniformBlockBinding (program_id, block_index, GSK_GL_COMMON_UNIFORMS_BINDING);
+    }
+
 out:
+  g_clear_object (&cache_file);
   g_bytes_unref (source_bytes);
 
   return program_id;
 }
-
@@ -6,6 +6,21 @@
 
 G_BEGIN_DECLS
 
+#define GSK_GL_COMMON_UNIFORMS_BINDING 0
+
+/* Matches the std140 layout of the GskCommon uniform block in
+ * preamble.glsl, which GL3 shaders use instead of per-program
+ * uniforms for the state shared by all programs. */
+typedef struct
+{
+  float projection[16];
+  float modelview[16];
+  float viewport[4];
+  float clip_rect[12];
+  float alpha;
+  float padding[3];
+} GskGLCommonUniforms;
+
 typedef struct
 {
   GBytes *preamble;
@@ -18,6 +33,7 @@ typedef struct
   guint gles: 1;
   guint gl3: 1;
   guint legacy: 1;
+  guint program_binaries: 1;
 
 } GskGLShaderBuilder;
 
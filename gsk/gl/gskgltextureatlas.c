@@ -8,8 +8,8 @@
 #define ATLAS_SIZE (512)
 #define MAX_OLD_RATIO 0.5
 
-static void
-free_atlas (gpointer v)
+void
+gsk_gl_texture_atlas_destroy (gpointer v)
 {
   GskGLTextureAtlas *atlas = v;
 
@@ -24,7 +24,7 @@ gsk_gl_texture_atlases_new (void)
   GskGLTextureAtlases *self;
 
   self = g_new (GskGLTextureAtlases, 1);
-  self->atlases = g_ptr_array_new_with_free_func (free_atlas);
+  self->atlases = g_ptr_array_new_with_free_func (gsk_gl_texture_atlas_destroy);
 
   self->ref_count = 1;
 
@@ -89,14 +89,9 @@ gsk_gl_texture_atlases_begin_frame (GskGLTextureAtlases *self,
                    g_message ("Dropping atlas %d (%g.2%% old)", i,
                               100.0 * gsk_gl_texture_atlas_get_unused_ratio (atlas)));
 
-          if (atlas->texture_id != 0)
-            {
-              glDeleteTextures (1, &atlas->texture_id);
-              atlas->texture_id = 0;
-            }
-
-          g_ptr_array_add (removed, atlas);
-          g_ptr_array_remove_index (self->atlases, i);
+          /* @removed takes over the atlas, so the caches can still
+           * copy live entries out of its texture */
+          g_ptr_array_add (removed, g_ptr_array_steal_index (self->atlases, i));
        }
     }
 
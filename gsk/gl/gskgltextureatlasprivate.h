@@ -49,6 +49,7 @@ void        gsk_gl_texture_atlas_init              (GskGLTextureAtlas       *sel
                                                     int                      height);
 
 void        gsk_gl_texture_atlas_free              (GskGLTextureAtlas       *self);
+void        gsk_gl_texture_atlas_destroy           (gpointer                 self);
 
 void        gsk_gl_texture_atlas_realize           (GskGLTextureAtlas       *self);
 
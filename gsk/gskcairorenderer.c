@@ -26,6 +26,13 @@
 #include "gskrendererprivate.h"
 #include "gskrendernodeprivate.h"
 #include "gdk/gdktextureprivate.h"
+#include "gdk/gdkmemorytextureprivate.h"
+
+#include <pango/pangocairo.h>
+
+/* Big enough that the overhead of a tile doesn't matter,
+ * small enough to spread a frame over all the cores. In device pixels. */
+#define TILE_SIZE 256
 
 #ifdef G_ENABLE_DEBUG
 typedef struct {
@@ -40,6 +47,11 @@ struct _GskCairoRenderer
 
   GdkCairoContext *cairo_context;
 
+  GThreadPool *tile_pool;
+  GMutex tile_lock;
+  GCond tile_cond;
+  guint n_pending_tiles;
+
 #ifdef G_ENABLE_DEBUG
   ProfileTimers profile_timers;
 #endif
@@ -72,13 +84,223 @@ gsk_cairo_renderer_unrealize (GskRenderer *renderer)
   g_clear_object (&self->cairo_context);
 }
 
+typedef struct
+{
+  GskRenderNode *root;
+  graphene_rect_t area; /* in the coordinates of the root node */
+  double scale_x;
+  double scale_y;
+  cairo_surface_t *surface;
+} Tile;
+
+static void
+gsk_cairo_renderer_draw_tile (gpointer data,
+                              gpointer user_data)
+{
+  GskCairoRenderer *self = user_data;
+  Tile *tile = data;
+  cairo_t *cr;
+
+  tile->surface = cairo_image_surface_create (CAIRO_FORMAT_ARGB32,
+                                              ceil (tile->area.size.width * tile->scale_x),
+                                              ceil (tile->area.size.height * tile->scale_y));
+  cairo_surface_set_device_scale (tile->surface, tile->scale_x, tile->scale_y);
+
+  cr = cairo_create (tile->surface);
+  cairo_translate (cr, - tile->area.origin.x, - tile->area.origin.y);
+  gsk_render_node_draw (tile->root, cr);
+  cairo_destroy (cr);
+
+  g_mutex_lock (&self->tile_lock);
+  self->n_pending_tiles--;
+  if (self->n_pending_tiles == 0)
+    g_cond_signal (&self->tile_cond);
+  g_mutex_unlock (&self->tile_lock);
+}
+
+/* Checks that the nodes can be drawn from several threads at once,
+ * and creates what they would otherwise create lazily while drawing.
+ *
+ * Textures other than memory textures may need a GL context to be
+ * downloaded, and cairo nodes share their surface between all the
+ * tiles, which cairo doesn't allow across threads. */
+static gboolean
+gsk_cairo_renderer_prepare_tiles (GskRenderNode *node)
+{
+  guint i;
+
+  switch (gsk_render_node_get_node_type (node))
+    {
+    case GSK_CONTAINER_NODE:
+      for (i = 0; i < gsk_container_node_get_n_children (node); i++)
+        {
+          if (!gsk_cairo_renderer_prepare_tiles (gsk_container_node_get_child (node, i)))
+            return FALSE;
+        }
+      return TRUE;
+
+    case GSK_CAIRO_NODE:
+      return gsk_cairo_node_get_surface (node) == NULL;
+
+    case GSK_TEXTURE_NODE:
+      return GDK_IS_MEMORY_TEXTURE (gsk_texture_node_get_texture (node));
+
+    case GSK_TEXT_NODE:
+      /* Pango creates the scaled font on first use */
+      pango_cairo_font_get_scaled_font (PANGO_CAIRO_FONT (gsk_text_node_get_font (node)));
+      return TRUE;
+
+    case GSK_TRANSFORM_NODE:
+      return gsk_cairo_renderer_prepare_tiles (gsk_transform_node_get_child (node));
+
+    case GSK_OPACITY_NODE:
+      return gsk_cairo_renderer_prepare_tiles (gsk_opacity_node_get_child (node));
+
+    case GSK_COLOR_MATRIX_NODE:
+      return gsk_cairo_renderer_prepare_tiles (gsk_color_matrix_node_get_child (node));
+
+    case GSK_REPEAT_NODE:
+      return gsk_cairo_renderer_prepare_tiles (gsk_repeat_node_get_child (node));
+
+    case GSK_CLIP_NODE:
+      return gsk_cairo_renderer_prepare_tiles (gsk_clip_node_get_child (node));
+
+    case GSK_ROUNDED_CLIP_NODE:
+      return gsk_cairo_renderer_prepare_tiles (gsk_rounded_clip_node_get_child (node));
+
+    case GSK_SHADOW_NODE:
+      return gsk_cairo_renderer_prepare_tiles (gsk_shadow_node_get_child (node));
+
+    case GSK_BLUR_NODE:
+      return gsk_cairo_renderer_prepare_tiles (gsk_blur_node_get_child (node));
+
+    case GSK_DEBUG_NODE:
+      return gsk_cairo_renderer_prepare_tiles (gsk_debug_node_get_child (node));
+
+    case GSK_BLEND_NODE:
+      return gsk_cairo_renderer_prepare_tiles (gsk_blend_node_get_bottom_child (node)) &&
+             gsk_cairo_renderer_prepare_tiles (gsk_blend_node_get_top_child (node));
+
+    case GSK_CROSS_FADE_NODE:
+      return gsk_cairo_renderer_prepare_tiles (gsk_cross_fade_node_get_start_child (node)) &&
+             gsk_cairo_renderer_prepare_tiles (gsk_cross_fade_node_get_end_child (node));
+
+    case GSK_GL_SHADER_NODE:
+      for (i = 0; i < gsk_gl_shader_node_get_n_children (node); i++)
+        {
+          if (!gsk_cairo_renderer_prepare_tiles (gsk_gl_shader_node_get_child (node, i)))
+            return FALSE;
+        }
+      return TRUE;
+
+    case GSK_COLOR_NODE:
+    case GSK_LINEAR_GRADIENT_NODE:
+    case GSK_REPEATING_LINEAR_GRADIENT_NODE:
+    case GSK_RADIAL_GRADIENT_NODE:
+    case GSK_REPEATING_RADIAL_GRADIENT_NODE:
+    case GSK_CONIC_GRADIENT_NODE:
+    case GSK_BORDER_NODE:
+    case GSK_INSET_SHADOW_NODE:
+    case GSK_OUTSET_SHADOW_NODE:
+      return TRUE;
+
+    case GSK_NOT_A_RENDER_NODE:
+    default:
+      return FALSE;
+    }
+}
+
+/* Splits the area to draw into tiles, draws them on the thread pool
+ * and then puts them together on @cr. Every tile only draws the nodes
+ * that intersect it, because container nodes skip children outside of
+ * the clip.
+ *
+ * Returns: %FALSE if the frame is not worth splitting up or can't be */
+static gboolean
+gsk_cairo_renderer_draw_tiled (GskCairoRenderer *self,
+                               cairo_t          *cr,
+                               GskRenderNode    *root)
+{
+  double x1, y1, x2, y2, scale_x, scale_y;
+  float tile_width, tile_height;
+  graphene_rect_t area;
+  guint i, n_tiles, n_columns, n_rows;
+  Tile *tiles;
+
+  if (self->tile_pool == NULL)
+    return FALSE;
+
+  /* The tiles are painted in the coordinates of the root node */
+  cairo_clip_extents (cr, &x1, &y1, &x2, &y2);
+  if (!graphene_rect_intersection (&GRAPHENE_RECT_INIT (floor (x1), floor (y1),
+                                                        ceil (x2) - floor (x1),
+                                                        ceil (y2) - floor (y1)),
+                                   &root->bounds,
+                                   &area))
+    return TRUE;
+
+  cairo_surface_get_device_scale (cairo_get_target (cr), &scale_x, &scale_y);
+  tile_width = TILE_SIZE / scale_x;
+  tile_height = TILE_SIZE / scale_y;
+  n_columns = ceil (area.size.width / tile_width);
+  n_rows = ceil (area.size.height / tile_height);
+  n_tiles = n_columns * n_rows;
+
+  if (n_tiles < 2 || !gsk_cairo_renderer_prepare_tiles (root))
+    return FALSE;
+
+  tiles = g_new (Tile, n_tiles);
+  for (i = 0; i < n_tiles; i++)
+    {
+      graphene_rect_t tile_area = GRAPHENE_RECT_INIT (area.origin.x + (i % n_columns) * tile_width,
+                                                      area.origin.y + (i / n_columns) * tile_height,
+                                                      tile_width,
+                                                      tile_height);
+
+      tiles[i].root = root;
+      tiles[i].scale_x = scale_x;
+      tiles[i].scale_y = scale_y;
+      tiles[i].surface = NULL;
+      graphene_rect_intersection (&tile_area, &area, &tiles[i].area);
+    }
+
+  self->n_pending_tiles = n_tiles;
+  for (i = 0; i < n_tiles; i++)
+    g_thread_pool_push (self->tile_pool, &tiles[i], NULL);
+
+  g_mutex_lock (&self->tile_lock);
+  while (self->n_pending_tiles > 0)
+    g_cond_wait (&self->tile_cond, &self->tile_lock);
+  g_mutex_unlock (&self->tile_lock);
+
+  /* Nodes draw with OVER, so drawing them on a transparent tile
+   * and painting that is the same as drawing them directly */
+  for (i = 0; i < n_tiles; i++)
+    {
+      cairo_save (cr);
+      cairo_rectangle (cr,
+                       tiles[i].area.origin.x, tiles[i].area.origin.y,
+                       tiles[i].area.size.width, tiles[i].area.size.height);
+      cairo_clip (cr);
+      cairo_set_source_surface (cr, tiles[i].surface, tiles[i].area.origin.x, tiles[i].area.origin.y);
+      cairo_paint (cr);
+      cairo_restore (cr);
+
+      cairo_surface_destroy (tiles[i].surface);
+    }
+
+  g_free (tiles);
+
+  return TRUE;
+}
+
 static void
 gsk_cairo_renderer_do_render (GskRenderer   *renderer,
                               cairo_t       *cr,
                               GskRenderNode *root)
 {
-#ifdef G_ENABLE_DEBUG
   GskCairoRenderer *self = GSK_CAIRO_RENDERER (renderer);
+#ifdef G_ENABLE_DEBUG
   GskProfiler *profiler;
   gint64 cpu_time;
 #endif
@@ -88,7 +310,8 @@ gsk_cairo_renderer_do_render (GskRenderer   *renderer,
   gsk_profiler_timer_begin (profiler, self->profile_timers.cpu_time);
 #endif
 
-  gsk_render_node_draw (root, cr);
+  if (!gsk_cairo_renderer_draw_tiled (self, cr, root))
+    gsk_render_node_draw (root, cr);
 
 #ifdef G_ENABLE_DEBUG
   cpu_time = gsk_profiler_timer_end (profiler, self->profile_timers.cpu_time);
@@ -159,10 +382,26 @@ gsk_cairo_renderer_render (GskRenderer          *renderer,
   gdk_draw_context_end_frame (GDK_DRAW_CONTEXT (self->cairo_context));
 }
 
+static void
+gsk_cairo_renderer_finalize (GObject *object)
+{
+  GskCairoRenderer *self = GSK_CAIRO_RENDERER (object);
+
+  if (self->tile_pool)
+    g_thread_pool_free (self->tile_pool, FALSE, TRUE);
+  g_mutex_clear (&self->tile_lock);
+  g_cond_clear (&self->tile_cond);
+
+  G_OBJECT_CLASS (gsk_cairo_renderer_parent_class)->finalize (object);
+}
+
 static void
 gsk_cairo_renderer_class_init (GskCairoRendererClass *klass)
 {
   GskRendererClass *renderer_class = GSK_RENDERER_CLASS (klass);
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+
+  gobject_class->finalize = gsk_cairo_renderer_finalize;
 
   renderer_class->realize = gsk_cairo_renderer_realize;
   renderer_class->unrealize = gsk_cairo_renderer_unrealize;
@@ -173,6 +412,15 @@ gsk_cairo_renderer_class_init (GskCairoRendererClass *klass)
 static void
 gsk_cairo_renderer_init (GskCairoRenderer *self)
 {
+  g_mutex_init (&self->tile_lock);
+  g_cond_init (&self->tile_cond);
+  if (g_get_num_processors () > 1)
+    self->tile_pool = g_thread_pool_new (gsk_cairo_renderer_draw_tile,
+                                         self,
+                                         g_get_num_processors (),
+                                         FALSE,
+                                         NULL);
+
 #ifdef G_ENABLE_DEBUG
   GskProfiler *profiler = gsk_renderer_get_profiler (GSK_RENDERER (self));
 
@@ -0,0 +1,261 @@
+/*
+ * Copyright © 2021 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include "gskoffloadprivate.h"
+
+#include "gskrendernodeprivate.h"
+
+#include "gdk/gdkdmabuftextureprivate.h"
+#include "gdk/gdksubsurfaceprivate.h"
+#include "gdk/gdksurfaceprivate.h"
+
+/* Finds the texture nodes of a frame that can be shown on subsurfaces
+ * instead of being drawn, and attaches them.
+ *
+ * Subsurfaces are stacked above the surface, so a texture is only
+ * offloaded when nothing that is drawn after it overlaps it, and it
+ * must be fully visible, since subsurfaces aren't clipped. We only
+ * look through nodes that don't change how the texture is drawn
+ * other than moving it.
+ */
+#define MAX_SUBSURFACES 4
+
+typedef struct
+{
+  GskRenderNode *node;
+  graphene_rect_t rect;
+  gboolean covered;
+} Candidate;
+
+struct _GskOffload
+{
+  Candidate candidates[MAX_SUBSURFACES];
+  guint n_candidates;
+
+  /* indexed by subsurface */
+  GskRenderNode *offloaded[MAX_SUBSURFACES];
+  graphene_rect_t rects[MAX_SUBSURFACES];
+  gboolean opaque[MAX_SUBSURFACES];
+  guint n_offloaded;
+};
+
+static void
+cover_candidates (GskOffload            *self,
+                  const graphene_rect_t *bounds)
+{
+  guint i;
+
+  for (i = 0; i < self->n_candidates; i++)
+    {
+      if (graphene_rect_intersection (&self->candidates[i].rect, bounds, NULL))
+        self->candidates[i].covered = TRUE;
+    }
+}
+
+static void
+find_candidates (GskOffload            *self,
+                 GskRenderNode         *node,
+                 float                  dx,
+                 float                  dy,
+                 const graphene_rect_t *clip)
+{
+  graphene_rect_t bounds;
+
+  switch (gsk_render_node_get_node_type (node))
+    {
+    case GSK_CONTAINER_NODE:
+      {
+        guint i;
+
+        for (i = 0; i < gsk_container_node_get_n_children (node); i++)
+          find_candidates (self, gsk_container_node_get_child (node, i), dx, dy, clip);
+      }
+      return;
+
+    case GSK_DEBUG_NODE:
+      find_candidates (self, gsk_debug_node_get_child (node), dx, dy, clip);
+      return;
+
+    case GSK_TRANSFORM_NODE:
+      {
+        GskTransform *transform = gsk_transform_node_get_transform (node);
+
+        if (gsk_transform_get_category (transform) >= GSK_TRANSFORM_CATEGORY_2D_TRANSLATE)
+          {
+            float tx, ty;
+
+            gsk_transform_to_translate (transform, &tx, &ty);
+            find_candidates (self, gsk_transform_node_get_child (node), dx + tx, dy + ty, clip);
+            return;
+          }
+      }
+      break;
+
+    case GSK_CLIP_NODE:
+      {
+        graphene_rect_t child_clip;
+
+        graphene_rect_offset_r (gsk_clip_node_get_clip (node), dx, dy, &child_clip);
+        if (!graphene_rect_intersection (clip, &child_clip, &child_clip))
+          return;
+
+        find_candidates (self, gsk_clip_node_get_child (node), dx, dy, &child_clip);
+      }
+      return;
+
+    case GSK_TEXTURE_NODE:
+      graphene_rect_offset_r (&node->bounds, dx, dy, &bounds);
+      cover_candidates (self, &bounds);
+
+      if (GDK_IS_DMABUF_TEXTURE (gsk_texture_node_get_texture (node)) &&
+          self->n_candidates < MAX_SUBSURFACES &&
+          graphene_rect_contains_rect (clip, &bounds))
+        {
+          self->candidates[self->n_candidates].node = node;
+          self->candidates[self->n_candidates].rect = bounds;
+          self->candidates[self->n_candidates].covered = FALSE;
+          self->n_candidates++;
+        }
+      return;
+
+    default:
+      break;
+    }
+
+  graphene_rect_offset_r (&node->bounds, dx, dy, &bounds);
+  cover_candidates (self, &bounds);
+}
+
+static gboolean
+texture_is_opaque (GdkTexture *texture)
+{
+  guint32 fourcc = gdk_dmabuf_texture_get_fourcc (GDK_DMABUF_TEXTURE (texture));
+
+  return fourcc == GDK_DRM_FORMAT_XRGB8888 || fourcc == GDK_DRM_FORMAT_XBGR8888;
+}
+
+GskOffload *
+gsk_offload_new (GdkSurface    *surface,
+                 GskRenderNode *root)
+{
+  GskOffload *self;
+  guint i, n_subsurfaces;
+
+  self = g_slice_new0 (GskOffload);
+
+  find_candidates (self, root, 0, 0,
+                   &GRAPHENE_RECT_INIT (0, 0,
+                                        gdk_surface_get_width (surface),
+                                        gdk_surface_get_height (surface)));
+
+  n_subsurfaces = gdk_surface_get_n_subsurfaces (surface);
+
+  for (i = 0; i < self->n_candidates; i++)
+    {
+      Candidate *candidate = &self->candidates[i];
+      GdkTexture *texture = gsk_texture_node_get_texture (candidate->node);
+      GdkSubsurface *subsurface;
+
+      if (candidate->covered)
+        continue;
+
+      if (self->n_offloaded < n_subsurfaces)
+        {
+          subsurface = gdk_surface_get_subsurface (surface, self->n_offloaded);
+        }
+      else
+        {
+          subsurface = gdk_surface_create_subsurface (surface);
+          if (subsurface == NULL)
+            break;
+          n_subsurfaces++;
+        }
+
+      /* Subsurfaces of offloaded textures never overlap, so it doesn't
+       * matter which one we use */
+      if (!gdk_subsurface_attach (subsurface, texture, &candidate->rect))
+        continue;
+
+      self->offloaded[self->n_offloaded] = candidate->node;
+      self->rects[self->n_offloaded] = candidate->rect;
+      self->opaque[self->n_offloaded] = texture_is_opaque (texture);
+      self->n_offloaded++;
+    }
+
+  for (i = self->n_offloaded; i < n_subsurfaces; i++)
+    gdk_subsurface_detach (gdk_surface_get_subsurface (surface, i));
+
+  return self;
+}
+
+void
+gsk_offload_free (GskOffload *self)
+{
+  g_slice_free (GskOffload, self);
+}
+
+gboolean
+gsk_offload_is_offloaded (GskOffload    *self,
+                          GskRenderNode *node)
+{
+  guint i;
+
+  for (i = 0; i < self->n_offloaded; i++)
+    {
+      if (self->offloaded[i] == node)
+        return TRUE;
+    }
+
+  return FALSE;
+}
+
+/* Opaque textures that stayed in place hide whatever is below them,
+ * so a new video frame doesn't make us redraw the surface */
+void
+gsk_offload_subtract_unchanged (GskOffload     *self,
+                                GskOffload     *prev,
+                                cairo_region_t *region)
+{
+  guint i;
+
+  for (i = 0; i < MIN (self->n_offloaded, prev->n_offloaded); i++)
+    {
+      if (!self->opaque[i] ||
+          !graphene_rect_equal (&self->rects[i], &prev->rects[i]))
+        continue;
+
+      /* attach() only accepts rects in whole pixels */
+      cairo_region_subtract_rectangle (region,
+                                       &(cairo_rectangle_int_t) {
+                                           self->rects[i].origin.x,
+                                           self->rects[i].origin.y,
+                                           self->rects[i].size.width,
+                                           self->rects[i].size.height
+                                       });
+    }
+}
+
+void
+gsk_offload_detach_all (GdkSurface *surface)
+{
+  guint i;
+
+  for (i = 0; i < gdk_surface_get_n_subsurfaces (surface); i++)
+    gdk_subsurface_detach (gdk_surface_get_subsurface (surface, i));
+}
@@ -0,0 +1,42 @@
+/*
+ * Copyright © 2021 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GSK_OFFLOAD_PRIVATE_H__
+#define __GSK_OFFLOAD_PRIVATE_H__
+
+#include <gdk/gdk.h>
+#include "gskrendernode.h"
+
+G_BEGIN_DECLS
+
+typedef struct _GskOffload GskOffload;
+
+GskOffload *            gsk_offload_new                         (GdkSurface             *surface,
+                                                                 GskRenderNode          *root);
+void                    gsk_offload_free                        (GskOffload             *self);
+
+gboolean                gsk_offload_is_offloaded                (GskOffload             *self,
+                                                                 GskRenderNode          *node);
+void                    gsk_offload_subtract_unchanged          (GskOffload             *self,
+                                                                 GskOffload             *prev,
+                                                                 cairo_region_t         *region);
+
+void                    gsk_offload_detach_all                  (GdkSurface             *surface);
+
+G_END_DECLS
+
+#endif /* __GSK_OFFLOAD_PRIVATE_H__ */
@@ -2,7 +2,7 @@
 
 #include "gskprofilerprivate.h"
 
-#define MAX_SAMPLES     32
+#define MAX_SAMPLES     512
 
 typedef struct {
   GQuark id;
@@ -39,6 +39,7 @@
 #include "gskcairorenderer.h"
 #include "gskdebugprivate.h"
 #include "gl/gskglrenderer.h"
+#include "gskoffloadprivate.h"
 #include "gskprofilerprivate.h"
 #include "gskrendernodeprivate.h"
 
@@ -79,6 +80,10 @@ typedef struct
   GskRenderNode *prev_node;
   GskRenderNode *root_node;
 
+  /* of the frame being rendered and the one before */
+  GskOffload *offload;
+  GskOffload *prev_offload;
+
   GskProfiler *profiler;
 
   GskDebugFlags debug_flags;
@@ -318,6 +323,9 @@ gsk_renderer_unrealize (GskRenderer *renderer)
 
   GSK_RENDERER_GET_CLASS (renderer)->unrealize (renderer);
 
+  if (priv->prev_offload)
+    gsk_offload_detach_all (priv->surface);
+  g_clear_pointer (&priv->prev_offload, gsk_offload_free);
   g_clear_pointer (&priv->prev_node, gsk_render_node_unref);
 
   priv->is_realized = FALSE;
@@ -410,6 +418,7 @@ gsk_renderer_render (GskRenderer          *renderer,
                      const cairo_region_t *region)
 {
   GskRendererPrivate *priv = gsk_renderer_get_instance_private (renderer);
+  GskOffload *offload;
   cairo_region_t *clip;
 
   g_return_if_fail (GSK_IS_RENDERER (renderer));
@@ -417,6 +426,12 @@ gsk_renderer_render (GskRenderer          *renderer,
   g_return_if_fail (GSK_IS_RENDER_NODE (root));
   g_return_if_fail (priv->root_node == NULL);
 
+  if (GSK_RENDERER_GET_CLASS (renderer)->supports_offload &&
+      !GSK_RENDERER_DEBUG_CHECK (renderer, NO_OFFLOAD))
+    offload = gsk_offload_new (priv->surface, root);
+  else
+    offload = NULL;
+
   if (region == NULL || priv->prev_node == NULL || GSK_RENDERER_DEBUG_CHECK (renderer, FULL_REDRAW))
     {
       clip = cairo_region_create_rectangle (&(GdkRectangle) {
@@ -430,14 +445,20 @@ gsk_renderer_render (GskRenderer          *renderer,
       clip = cairo_region_copy (region);
       gsk_render_node_diff (priv->prev_node, root, clip);
 
+      if (offload && priv->prev_offload)
+        gsk_offload_subtract_unchanged (offload, priv->prev_offload, clip);
+
       if (cairo_region_is_empty (clip))
         {
+          g_clear_pointer (&priv->prev_offload, gsk_offload_free);
+          priv->prev_offload = offload;
           cairo_region_destroy (clip);
           return;
         }
     }
 
   priv->root_node = gsk_render_node_ref (root);
+  priv->offload = offload;
 
   GSK_RENDERER_GET_CLASS (renderer)->render (renderer, root, clip);
 
@@ -459,9 +480,29 @@ gsk_renderer_render (GskRenderer          *renderer,
 #endif
 
   g_clear_pointer (&priv->prev_node, gsk_render_node_unref);
+  g_clear_pointer (&priv->prev_offload, gsk_offload_free);
   cairo_region_destroy (clip);
   priv->prev_node = priv->root_node;
   priv->root_node = NULL;
+  priv->prev_offload = priv->offload;
+  priv->offload = NULL;
+}
+
+/*< private >
+ * gsk_renderer_get_offload:
+ * @renderer: a #GskRenderer
+ *
+ * Retrieves the offload information of the frame that is being
+ * rendered. Renderers must not draw the nodes it has offloaded.
+ *
+ * Returns: (transfer none) (nullable): the offload of the frame
+ */
+GskOffload *
+gsk_renderer_get_offload (GskRenderer *renderer)
+{
+  GskRendererPrivate *priv = gsk_renderer_get_instance_private (renderer);
+
+  return priv->offload;
 }
 
 /*< private >
@@ -22,6 +22,7 @@
 #include "gskrenderer.h"
 #include "gskprofilerprivate.h"
 #include "gskdebugprivate.h"
+#include "gskoffloadprivate.h"
 
 G_BEGIN_DECLS
 
@@ -38,6 +39,9 @@ struct _GskRendererClass
 {
   GObjectClass parent_class;
 
+  /* whether the renderer skips the nodes in gsk_renderer_get_offload() */
+  gboolean supports_offload;
+
   gboolean             (* realize)                              (GskRenderer            *renderer,
                                                                  GdkSurface             *surface,
                                                                  GError                **error);
@@ -52,6 +56,7 @@ struct _GskRendererClass
 };
 
 GskRenderNode *         gsk_renderer_get_root_node              (GskRenderer    *renderer);
+GskOffload *            gsk_renderer_get_offload                (GskRenderer    *renderer);
 
 GskProfiler *           gsk_renderer_get_profiler               (GskRenderer    *renderer);
 
@@ -42,6 +42,7 @@
 
 #include "gskdebugprivate.h"
 #include "gskrendererprivate.h"
+#include "gskrendernodebinaryprivate.h"
 #include "gskrendernodeparserprivate.h"
 
 #include <graphene-gobject.h>
@@ -140,9 +141,8 @@ value_render_node_lcopy_value (const GValue *value,
 }
 
 static void
-gsk_render_node_finalize (GskRenderNode *self)
+gsk_render_node_real_finalize (GskRenderNode *self)
 {
-  g_type_free_instance ((GTypeInstance *) self);
 }
 
 static void
@@ -165,14 +165,30 @@ gsk_render_node_real_diff (GskRenderNode  *node1,
 {
 }
 
+static guint
+gsk_render_node_real_hash (GskRenderNode *node,
+                           guint          hash)
+{
+  return gsk_render_node_hash_data (hash, &node, sizeof (GskRenderNode *));
+}
+
+static gboolean
+gsk_render_node_real_equal (GskRenderNode *node1,
+                            GskRenderNode *node2)
+{
+  return node1 == node2;
+}
+
 static void
 gsk_render_node_class_init (GskRenderNodeClass *klass)
 {
   klass->node_type = GSK_NOT_A_RENDER_NODE;
-  klass->finalize = gsk_render_node_finalize;
+  klass->finalize = gsk_render_node_real_finalize;
   klass->draw = gsk_render_node_real_draw;
   klass->can_diff = gsk_render_node_real_can_diff;
   klass->diff = gsk_render_node_real_diff;
+  klass->hash = gsk_render_node_real_hash;
+  klass->equal = gsk_render_node_real_equal;
 }
 
 static void
@@ -248,6 +264,10 @@ typedef struct
   void     (* diff)     (GskRenderNode        *node1,
                          GskRenderNode        *node2,
                          cairo_region_t       *region);
+  guint    (* hash)     (GskRenderNode        *node,
+                         guint                 hash);
+  gboolean (* equal)    (GskRenderNode        *node1,
+                         GskRenderNode        *node2);
 } RenderNodeClassData;
 
 static void
@@ -265,6 +285,10 @@ gsk_render_node_generic_class_init (gpointer g_class,
     node_class->finalize = node_data->finalize;
   if (node_data->can_diff != NULL)
     node_class->can_diff = node_data->can_diff;
+  if (node_data->hash != NULL)
+    node_class->hash = node_data->hash;
+  if (node_data->equal != NULL)
+    node_class->equal = node_data->equal;
 
   /* Mandatory */
   node_class->draw = node_data->draw;
@@ -316,6 +340,8 @@ gsk_render_node_type_register_static (const char                  *node_name,
   ((RenderNodeClassData *) info.class_data)->diff = node_info->diff != NULL
                                                   ? node_info->diff
                                                   : gsk_render_node_diff_impossible;
+  ((RenderNodeClassData *) info.class_data)->hash = node_info->hash;
+  ((RenderNodeClassData *) info.class_data)->equal = node_info->equal;
 
   info.instance_size = node_info->instance_size;
   info.n_preallocs = 0;
@@ -325,6 +351,8 @@ gsk_render_node_type_register_static (const char                  *node_name,
   return g_type_register_static (GSK_TYPE_RENDER_NODE, node_name, &info, 0);
 }
 
+static guint n_render_nodes_allocated;
+
 /*< private >
  * gsk_render_node_alloc:
  * @node_type: the #GskRenderNodeType to instantiate
@@ -340,9 +368,21 @@ gsk_render_node_alloc (GskRenderNodeType node_type)
   g_return_val_if_fail (node_type < GSK_RENDER_NODE_TYPE_N_TYPES, NULL);
 
   g_assert (gsk_render_node_types[node_type] != G_TYPE_INVALID);
+
+  n_render_nodes_allocated++;
+
   return g_type_create_instance (gsk_render_node_types[node_type]);
 }
 
+/* The number of render nodes allocated so far. This wraps
+ * around, so callers should only look at differences.
+ */
+guint
+gsk_render_node_get_n_allocated (void)
+{
+  return n_render_nodes_allocated;
+}
+
 /**
  * gsk_render_node_ref:
  * @node: a #GskRenderNode
@@ -375,8 +415,14 @@ gsk_render_node_unref (GskRenderNode *node)
 {
   g_return_if_fail (GSK_IS_RENDER_NODE (node));
 
+  /* Subclasses only release their own data and don't chain up, so that
+   * freeing the thousands of nodes of a frame doesn't need a trip through
+   * the type system to find the parent class for each of them. */
   if (g_atomic_ref_count_dec (&node->ref_count))
-    GSK_RENDER_NODE_GET_CLASS (node)->finalize (node);
+    {
+      GSK_RENDER_NODE_GET_CLASS (node)->finalize (node);
+      g_type_free_instance ((GTypeInstance *) node);
+    }
 }
 
 
@@ -551,9 +597,103 @@ gsk_render_node_diff (GskRenderNode  *node1,
   if (_gsk_render_node_get_node_type (node1) != _gsk_render_node_get_node_type (node2))
     return gsk_render_node_diff_impossible (node1, node2, region);
 
+  /* Catches identical subtrees that were built again, like
+   * widgets do when they don't cache their nodes */
+  if (gsk_render_node_equal (node1, node2))
+    return;
+
   return GSK_RENDER_NODE_GET_CLASS (node1)->diff (node1, node2, region);
 }
 
+/*< private >
+ * gsk_render_node_hash_data:
+ * @hash: the hash so far
+ * @data: the data to add
+ * @size: size of @data in bytes
+ *
+ * Mixes @data into @hash, for the hash functions of render nodes.
+ *
+ * Returns: the new hash
+ */
+guint
+gsk_render_node_hash_data (guint          hash,
+                           gconstpointer  data,
+                           gsize          size)
+{
+  const guchar *p = data;
+  gsize i;
+
+  /* FNV-1a */
+  for (i = 0; i < size; i++)
+    hash = (hash ^ p[i]) * 16777619u;
+
+  return hash;
+}
+
+/*< private >
+ * gsk_render_node_hash:
+ * @node: a #GskRenderNode
+ *
+ * Computes a hash of the contents of @node and all its children, so
+ * that nodes which draw the same have the same hash, no matter if they
+ * are the same node or not. Nodes can't be modified, so the hash is only
+ * computed once and then kept in the node.
+ *
+ * Returns: the hash of @node
+ */
+guint
+gsk_render_node_hash (GskRenderNode *node)
+{
+  GskRenderNodeType node_type;
+  guint hash;
+
+  if (G_LIKELY (node->hash != 0))
+    return node->hash;
+
+  node_type = _gsk_render_node_get_node_type (node);
+  hash = gsk_render_node_hash_data (2166136261u, &node_type, sizeof (GskRenderNodeType));
+  hash = gsk_render_node_hash_data (hash, &node->bounds, sizeof (graphene_rect_t));
+  hash = GSK_RENDER_NODE_GET_CLASS (node)->hash (node, hash);
+
+  /* 0 means "not computed yet" */
+  node->hash = hash ? hash : 1;
+
+  return node->hash;
+}
+
+/*< private >
+ * gsk_render_node_equal:
+ * @node1: a #GskRenderNode
+ * @node2: another #GskRenderNode
+ *
+ * Checks if @node1 and @node2 have the same contents. Nodes with
+ * different hashes are rejected right away, so this is cheap unless
+ * the nodes turn out to be equal.
+ *
+ * Together with gsk_render_node_hash(), this allows using nodes as
+ * keys in caches that keep working when a node gets built again.
+ *
+ * Returns: %TRUE if the two nodes draw the same
+ */
+gboolean
+gsk_render_node_equal (GskRenderNode *node1,
+                       GskRenderNode *node2)
+{
+  if (node1 == node2)
+    return TRUE;
+
+  if (_gsk_render_node_get_node_type (node1) != _gsk_render_node_get_node_type (node2))
+    return FALSE;
+
+  if (gsk_render_node_hash (node1) != gsk_render_node_hash (node2))
+    return FALSE;
+
+  if (!graphene_rect_equal (&node1->bounds, &node2->bounds))
+    return FALSE;
+
+  return GSK_RENDER_NODE_GET_CLASS (node1)->equal (node1, node2);
+}
+
 /**
  * gsk_render_node_write_to_file:
  * @node: a #GskRenderNode
@@ -567,6 +707,10 @@ gsk_render_node_diff (GskRenderNode  *node1,
  * It is mostly intended for use inside a debugger to quickly dump a render
  * node to a file for later inspection.
  *
+ * If @filename ends in ".bnode", a binary format is used instead, which
+ * is much faster to load for big recordings, but can only be loaded by
+ * the same version of GTK on a machine with the same byte order.
+ *
  * Returns: %TRUE if saving was successful
  **/
 gboolean
@@ -581,7 +725,10 @@ gsk_render_node_write_to_file (GskRenderNode *node,
   g_return_val_if_fail (filename != NULL, FALSE);
   g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
 
-  bytes = gsk_render_node_serialize (node);
+  if (g_str_has_suffix (filename, ".bnode"))
+    bytes = gsk_render_node_serialize_binary (node);
+  else
+    bytes = gsk_render_node_serialize (node);
   result = g_file_set_contents (filename,
                                 g_bytes_get_data (bytes, NULL),
                                 g_bytes_get_size (bytes),
@@ -600,6 +747,9 @@ gsk_render_node_write_to_file (GskRenderNode *node,
  * Loads data previously created via gsk_render_node_serialize(). For a
  * discussion of the supported format, see that function.
  *
+ * Data in the binary format written by gsk_render_node_write_to_file()
+ * is detected and loaded as well.
+ *
  * Returns: (nullable) (transfer full): a new #GskRenderNode or %NULL on
  *     error.
  **/
@@ -610,7 +760,10 @@ gsk_render_node_deserialize (GBytes            *bytes,
 {
   GskRenderNode *node = NULL;
 
-  node = gsk_render_node_deserialize_from_bytes (bytes, error_func, user_data);
+  if (gsk_render_node_is_binary (bytes))
+    node = gsk_render_node_deserialize_binary (bytes, error_func, user_data);
+  else
+    node = gsk_render_node_deserialize_from_bytes (bytes, error_func, user_data);
 
   return node;
 }
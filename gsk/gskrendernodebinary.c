@@ -0,0 +1,1672 @@
+/*
+ * Copyright © 2021 GTK Team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include "gskrendernodebinaryprivate.h"
+
+#include "gskrendernodeparserprivate.h"
+#include "gskrendernodeprivate.h"
+#include "gsktransformprivate.h"
+
+#include "gdk/gdkmemorytextureprivate.h"
+#include "gdk/gdktextureprivate.h"
+
+#include <string.h>
+
+/* The binary format is meant for big recordings that need to load fast,
+ * the text format stays the one to read and edit.
+ *
+ * A file is a header, followed by the nodes, the blob table and the blob data.
+ * Everything is stored in native byte order and nothing needs to be parsed
+ * or copied except for the nodes themselves, so textures can point right
+ * into a mapped file.
+ *
+ * Nodes are stored children first, so every node only refers to nodes that
+ * have already been created, and the root node comes last. Each node is a
+ * guint32 node type, a guint32 length of its payload in 32-bit words and the
+ * payload, made of floats, guint32s, indexes of earlier nodes and indexes
+ * of blobs. Nodes that appear more than once in the tree are only stored once.
+ *
+ * Blobs hold strings, pixel data, shader sources and shader arguments.
+ * Strings are deduplicated by contents, everything else by the object it
+ * was created from, so a font, texture or shader used in thousands of nodes
+ * is stored, and loaded, only once.
+ */
+
+#define BINARY_VERSION 1
+#define BYTE_ORDER_MARK 0x01020304
+#define NO_BLOB G_MAXUINT32
+#define BLOB_ALIGNMENT 16
+
+static const char binary_magic[8] = { '\211', 'G', 'S', 'K', '\r', '\n', '\032', '\n' };
+
+typedef struct
+{
+  char magic[8];
+  guint32 byte_order;
+  guint32 version;
+  guint32 n_nodes;
+  guint32 n_blobs;
+  guint64 nodes_offset;
+  guint64 nodes_size;
+  guint64 blobs_offset;
+  guint64 blob_data_offset;
+  guint64 blob_data_size;
+} BinaryHeader;
+
+typedef struct
+{
+  guint64 offset; /* relative to blob_data_offset */
+  guint64 size;
+} BlobEntry;
+
+/* Pixel data blobs start with this, followed by height * stride
+ * bytes in GDK_MEMORY_DEFAULT */
+typedef struct
+{
+  guint32 width;
+  guint32 height;
+  guint32 stride;
+  guint32 padding;
+} PixelHeader;
+
+gboolean
+gsk_render_node_is_binary (GBytes *bytes)
+{
+  gsize size;
+  const guchar *data = g_bytes_get_data (bytes, &size);
+
+  return size >= sizeof (binary_magic) &&
+         memcmp (data, binary_magic, sizeof (binary_magic)) == 0;
+}
+
+/*** WRITER ***/
+
+typedef struct
+{
+  GByteArray *nodes;
+  guint n_nodes;
+  GHashTable *node_indexes; /* GskRenderNode => index + 1 */
+
+  GArray *blobs; /* BlobEntry */
+  GByteArray *blob_data;
+  GHashTable *string_blobs; /* char * => index + 1 */
+  GHashTable *object_blobs; /* pointer => index + 1 */
+} Writer;
+
+static void
+writer_init (Writer *self)
+{
+  self->nodes = g_byte_array_new ();
+  self->n_nodes = 0;
+  self->node_indexes = g_hash_table_new (NULL, NULL);
+  self->blobs = g_array_new (FALSE, FALSE, sizeof (BlobEntry));
+  self->blob_data = g_byte_array_new ();
+  self->string_blobs = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+  self->object_blobs = g_hash_table_new (NULL, NULL);
+}
+
+static void
+writer_clear (Writer *self)
+{
+  g_byte_array_unref (self->nodes);
+  g_hash_table_unref (self->node_indexes);
+  g_array_unref (self->blobs);
+  g_byte_array_unref (self->blob_data);
+  g_hash_table_unref (self->string_blobs);
+  g_hash_table_unref (self->object_blobs);
+}
+
+static guint32
+writer_add_blob (Writer       *self,
+                 const guchar *header,
+                 gsize         header_size,
+                 const guchar *data,
+                 gsize         size)
+{
+  BlobEntry entry;
+  gsize padding;
+
+  padding = (BLOB_ALIGNMENT - self->blob_data->len % BLOB_ALIGNMENT) % BLOB_ALIGNMENT;
+  if (padding)
+    g_byte_array_set_size (self->blob_data, self->blob_data->len + padding);
+
+  entry.offset = self->blob_data->len;
+  entry.size = header_size + size;
+
+  if (header_size)
+    g_byte_array_append (self->blob_data, header, header_size);
+  if (size)
+    g_byte_array_append (self->blob_data, data, size);
+
+  g_array_append_val (self->blobs, entry);
+
+  return self->blobs->len - 1;
+}
+
+static guint32
+writer_add_string (Writer     *self,
+                   const char *string)
+{
+  gpointer index;
+  guint32 result;
+
+  if (string == NULL)
+    return NO_BLOB;
+
+  index = g_hash_table_lookup (self->string_blobs, string);
+  if (index)
+    return GPOINTER_TO_UINT (index) - 1;
+
+  result = writer_add_blob (self, NULL, 0, (const guchar *) string, strlen (string));
+  g_hash_table_insert (self->string_blobs, g_strdup (string), GUINT_TO_POINTER (result + 1));
+
+  return result;
+}
+
+static guint32
+writer_add_pixels (Writer          *self,
+                   gconstpointer    key,
+                   cairo_surface_t *surface)
+{
+  PixelHeader header;
+  gpointer index;
+  guint32 result;
+
+  index = g_hash_table_lookup (self->object_blobs, key);
+  if (index)
+    return GPOINTER_TO_UINT (index) - 1;
+
+  cairo_surface_flush (surface);
+
+  header.width = cairo_image_surface_get_width (surface);
+  header.height = cairo_image_surface_get_height (surface);
+  header.stride = cairo_image_surface_get_stride (surface);
+  header.padding = 0;
+
+  result = writer_add_blob (self,
+                            (const guchar *) &header, sizeof (header),
+                            cairo_image_surface_get_data (surface),
+                            (gsize) header.height * header.stride);
+  g_hash_table_insert (self->object_blobs, (gpointer) key, GUINT_TO_POINTER (result + 1));
+
+  return result;
+}
+
+static guint32
+writer_add_texture (Writer     *self,
+                    GdkTexture *texture)
+{
+  cairo_surface_t *surface;
+  guint32 result;
+  gpointer index;
+
+  index = g_hash_table_lookup (self->object_blobs, texture);
+  if (index)
+    return GPOINTER_TO_UINT (index) - 1;
+
+  surface = gdk_texture_download_surface (texture);
+  result = writer_add_pixels (self, texture, surface);
+  cairo_surface_destroy (surface);
+
+  return result;
+}
+
+static guint32
+writer_add_cairo_surface (Writer                *self,
+                          cairo_surface_t       *surface,
+                          const graphene_rect_t *bounds)
+{
+  cairo_surface_t *image;
+  guint32 result;
+  gpointer index;
+  cairo_t *cr;
+
+  if (surface == NULL)
+    return NO_BLOB;
+
+  index = g_hash_table_lookup (self->object_blobs, surface);
+  if (index)
+    return GPOINTER_TO_UINT (index) - 1;
+
+  /* Recording surfaces get rasterized, the pixels start at the
+   * origin of the bounds */
+  image = cairo_image_surface_create (CAIRO_FORMAT_ARGB32,
+                                      ceilf (bounds->size.width),
+                                      ceilf (bounds->size.height));
+  cr = cairo_create (image);
+  cairo_set_source_surface (cr, surface, - bounds->origin.x, - bounds->origin.y);
+  cairo_paint (cr);
+  cairo_destroy (cr);
+
+  result = writer_add_pixels (self, surface, image);
+  cairo_surface_destroy (image);
+
+  return result;
+}
+
+static guint32
+writer_add_bytes (Writer  *self,
+                  GBytes  *bytes)
+{
+  gpointer index;
+  guint32 result;
+
+  index = g_hash_table_lookup (self->object_blobs, bytes);
+  if (index)
+    return GPOINTER_TO_UINT (index) - 1;
+
+  result = writer_add_blob (self, NULL, 0,
+                            g_bytes_get_data (bytes, NULL),
+                            g_bytes_get_size (bytes));
+  g_hash_table_insert (self->object_blobs, bytes, GUINT_TO_POINTER (result + 1));
+
+  return result;
+}
+
+static void
+put_uint (GArray  *payload,
+          guint32  value)
+{
+  g_array_append_val (payload, value);
+}
+
+static void
+put_float (GArray *payload,
+           float   value)
+{
+  guint32 word;
+
+  G_STATIC_ASSERT (sizeof (float) == sizeof (guint32));
+  memcpy (&word, &value, sizeof (float));
+  g_array_append_val (payload, word);
+}
+
+static void
+put_floats (GArray      *payload,
+            const float *values,
+            guint        n_values)
+{
+  guint i;
+
+  for (i = 0; i < n_values; i++)
+    put_float (payload, values[i]);
+}
+
+static void
+put_rect (GArray                *payload,
+          const graphene_rect_t *rect)
+{
+  put_float (payload, rect->origin.x);
+  put_float (payload, rect->origin.y);
+  put_float (payload, rect->size.width);
+  put_float (payload, rect->size.height);
+}
+
+static void
+put_point (GArray                 *payload,
+           const graphene_point_t *point)
+{
+  put_float (payload, point->x);
+  put_float (payload, point->y);
+}
+
+static void
+put_rounded_rect (GArray               *payload,
+                  const GskRoundedRect *rect)
+{
+  guint i;
+
+  put_rect (payload, &rect->bounds);
+  for (i = 0; i < 4; i++)
+    {
+      put_float (payload, rect->corner[i].width);
+      put_float (payload, rect->corner[i].height);
+    }
+}
+
+static void
+put_rgba (GArray        *payload,
+          const GdkRGBA *rgba)
+{
+  put_float (payload, rgba->red);
+  put_float (payload, rgba->green);
+  put_float (payload, rgba->blue);
+  put_float (payload, rgba->alpha);
+}
+
+static void
+put_stops (GArray             *payload,
+           const GskColorStop *stops,
+           gsize               n_stops)
+{
+  gsize i;
+
+  put_uint (payload, n_stops);
+  for (i = 0; i < n_stops; i++)
+    {
+      put_float (payload, stops[i].offset);
+      put_rgba (payload, &stops[i].color);
+    }
+}
+
+static guint32 writer_add_node (Writer        *self,
+                                GskRenderNode *node);
+
+static void
+put_node (Writer        *self,
+          GArray        *payload,
+          GskRenderNode *node)
+{
+  put_uint (payload, writer_add_node (self, node));
+}
+
+static void
+writer_write_payload (Writer        *self,
+                      GskRenderNode *node,
+                      GArray        *payload)
+{
+  switch (gsk_render_node_get_node_type (node))
+    {
+    case GSK_CONTAINER_NODE:
+      {
+        guint i, n = gsk_container_node_get_n_children (node);
+        guint32 *children = g_newa (guint32, n);
+
+        /* Add the children before the container's payload gets written */
+        for (i = 0; i < n; i++)
+          children[i] = writer_add_node (self, gsk_container_node_get_child (node, i));
+
+        put_uint (payload, n);
+        for (i = 0; i < n; i++)
+          put_uint (payload, children[i]);
+      }
+      break;
+
+    case GSK_COLOR_NODE:
+      put_rect (payload, &node->bounds);
+      put_rgba (payload, gsk_color_node_get_color (node));
+      break;
+
+    case GSK_LINEAR_GRADIENT_NODE:
+    case GSK_REPEATING_LINEAR_GRADIENT_NODE:
+      put_rect (payload, &node->bounds);
+      put_point (payload, gsk_linear_gradient_node_get_start (node));
+      put_point (payload, gsk_linear_gradient_node_get_end (node));
+      put_stops (payload,
+                 gsk_linear_gradient_node_get_color_stops (node, NULL),
+                 gsk_linear_gradient_node_get_n_color_stops (node));
+      break;
+
+    case GSK_RADIAL_GRADIENT_NODE:
+    case GSK_REPEATING_RADIAL_GRADIENT_NODE:
+      put_rect (payload, &node->bounds);
+      put_point (payload, gsk_radial_gradient_node_get_center (node));
+      put_float (payload, gsk_radial_gradient_node_get_hradius (node));
+      put_float (payload, gsk_radial_gradient_node_get_vradius (node));
+      put_float (payload, gsk_radial_gradient_node_get_start (node));
+      put_float (payload, gsk_radial_gradient_node_get_end (node));
+      put_stops (payload,
+                 gsk_radial_gradient_node_get_color_stops (node, NULL),
+                 gsk_radial_gradient_node_get_n_color_stops (node));
+      break;
+
+    case GSK_CONIC_GRADIENT_NODE:
+      put_rect (payload, &node->bounds);
+      put_point (payload, gsk_conic_gradient_node_get_center (node));
+      put_float (payload, gsk_conic_gradient_node_get_rotation (node));
+      put_stops (payload,
+                 gsk_conic_gradient_node_get_color_stops (node, NULL),
+                 gsk_conic_gradient_node_get_n_color_stops (node));
+      break;
+
+    case GSK_BORDER_NODE:
+      {
+        const GdkRGBA *colors = gsk_border_node_get_colors (node);
+        guint i;
+
+        put_rounded_rect (payload, gsk_border_node_get_outline (node));
+        put_floats (payload, gsk_border_node_get_widths (node), 4);
+        for (i = 0; i < 4; i++)
+          put_rgba (payload, &colors[i]);
+      }
+      break;
+
+    case GSK_TEXTURE_NODE:
+      put_rect (payload, &node->bounds);
+      put_uint (payload, writer_add_texture (self, gsk_texture_node_get_texture (node)));
+      break;
+
+    case GSK_INSET_SHADOW_NODE:
+      put_rounded_rect (payload, gsk_inset_shadow_node_get_outline (node));
+      put_rgba (payload, gsk_inset_shadow_node_get_color (node));
+      put_float (payload, gsk_inset_shadow_node_get_dx (node));
+      put_float (payload, gsk_inset_shadow_node_get_dy (node));
+      put_float (payload, gsk_inset_shadow_node_get_spread (node));
+      put_float (payload, gsk_inset_shadow_node_get_blur_radius (node));
+      break;
+
+    case GSK_OUTSET_SHADOW_NODE:
+      put_rounded_rect (payload, gsk_outset_shadow_node_get_outline (node));
+      put_rgba (payload, gsk_outset_shadow_node_get_color (node));
+      put_float (payload, gsk_outset_shadow_node_get_dx (node));
+      put_float (payload, gsk_outset_shadow_node_get_dy (node));
+      put_float (payload, gsk_outset_shadow_node_get_spread (node));
+      put_float (payload, gsk_outset_shadow_node_get_blur_radius (node));
+      break;
+
+    case GSK_CAIRO_NODE:
+      put_rect (payload, &node->bounds);
+      put_uint (payload, writer_add_cairo_surface (self, gsk_cairo_node_get_surface (node), &node->bounds));
+      break;
+
+    case GSK_TRANSFORM_NODE:
+      {
+        char *string = gsk_transform_to_string (gsk_transform_node_get_transform (node));
+
+        put_node (self, payload, gsk_transform_node_get_child (node));
+        put_uint (payload, writer_add_string (self, string));
+
+        g_free (string);
+      }
+      break;
+
+    case GSK_OPACITY_NODE:
+      put_node (self, payload, gsk_opacity_node_get_child (node));
+      put_float (payload, gsk_opacity_node_get_opacity (node));
+      break;
+
+    case GSK_COLOR_MATRIX_NODE:
+      {
+        float values[16];
+
+        put_node (self, payload, gsk_color_matrix_node_get_child (node));
+        graphene_matrix_to_float (gsk_color_matrix_node_get_color_matrix (node), values);
+        put_floats (payload, values, 16);
+        graphene_vec4_to_float (gsk_color_matrix_node_get_color_offset (node), values);
+        put_floats (payload, values, 4);
+      }
+      break;
+
+    case GSK_REPEAT_NODE:
+      put_rect (payload, &node->bounds);
+      put_node (self, payload, gsk_repeat_node_get_child (node));
+      put_rect (payload, gsk_repeat_node_get_child_bounds (node));
+      break;
+
+    case GSK_CLIP_NODE:
+      put_node (self, payload, gsk_clip_node_get_child (node));
+      put_rect (payload, gsk_clip_node_get_clip (node));
+      break;
+
+    case GSK_ROUNDED_CLIP_NODE:
+      put_node (self, payload, gsk_rounded_clip_node_get_child (node));
+      put_rounded_rect (payload, gsk_rounded_clip_node_get_clip (node));
+      break;
+
+    case GSK_SHADOW_NODE:
+      {
+        gsize i, n = gsk_shadow_node_get_n_shadows (node);
+
+        put_node (self, payload, gsk_shadow_node_get_child (node));
+        put_uint (payload, n);
+        for (i = 0; i < n; i++)
+          {
+            const GskShadow *shadow = gsk_shadow_node_get_shadow (node, i);
+
+            put_rgba (payload, &shadow->color);
+            put_float (payload, shadow->dx);
+            put_float (payload, shadow->dy);
+            put_float (payload, shadow->radius);
+          }
+      }
+      break;
+
+    case GSK_BLEND_NODE:
+      put_node (self, payload, gsk_blend_node_get_bottom_child (node));
+      put_node (self, payload, gsk_blend_node_get_top_child (node));
+      put_uint (payload, gsk_blend_node_get_blend_mode (node));
+      break;
+
+    case GSK_CROSS_FADE_NODE:
+      put_node (self, payload, gsk_cross_fade_node_get_start_child (node));
+      put_node (self, payload, gsk_cross_fade_node_get_end_child (node));
+      put_float (payload, gsk_cross_fade_node_get_progress (node));
+      break;
+
+    case GSK_TEXT_NODE:
+      {
+        const PangoGlyphInfo *glyphs = gsk_text_node_get_glyphs (node, NULL);
+        guint i, n = gsk_text_node_get_num_glyphs (node);
+        PangoFontDescription *desc;
+        char *font_name;
+
+        desc = pango_font_describe (gsk_text_node_get_font (node));
+        font_name = pango_font_description_to_string (desc);
+        put_uint (payload, writer_add_string (self, font_name));
+        g_free (font_name);
+        pango_font_description_free (desc);
+
+        put_rgba (payload, gsk_text_node_get_color (node));
+        put_point (payload, gsk_text_node_get_offset (node));
+        put_uint (payload, n);
+        for (i = 0; i < n; i++)
+          {
+            put_uint (payload, glyphs[i].glyph);
+            put_uint (payload, glyphs[i].geometry.width);
+            put_uint (payload, glyphs[i].geometry.x_offset);
+            put_uint (payload, glyphs[i].geometry.y_offset);
+            put_uint (payload, glyphs[i].attr.is_cluster_start);
+          }
+      }
+      break;
+
+    case GSK_BLUR_NODE:
+      put_node (self, payload, gsk_blur_node_get_child (node));
+      put_float (payload, gsk_blur_node_get_radius (node));
+      break;
+
+    case GSK_DEBUG_NODE:
+      put_node (self, payload, gsk_debug_node_get_child (node));
+      put_uint (payload, writer_add_string (self, gsk_debug_node_get_message (node)));
+      break;
+
+    case GSK_GL_SHADER_NODE:
+      {
+        GskGLShader *shader = gsk_gl_shader_node_get_shader (node);
+        guint i, n = gsk_gl_shader_node_get_n_children (node);
+        guint32 *children = g_newa (guint32, n);
+
+        for (i = 0; i < n; i++)
+          children[i] = writer_add_node (self, gsk_gl_shader_node_get_child (node, i));
+
+        put_rect (payload, &node->bounds);
+        put_uint (payload, writer_add_bytes (self, gsk_gl_shader_get_source (shader)));
+        put_uint (payload, writer_add_bytes (self, gsk_gl_shader_node_get_args (node)));
+        put_uint (payload, n);
+        for (i = 0; i < n; i++)
+          put_uint (payload, children[i]);
+      }
+      break;
+
+    case GSK_NOT_A_RENDER_NODE:
+    default:
+      g_error ("Unhandled node: %s", g_type_name_from_instance ((GTypeInstance *) node));
+      break;
+    }
+}
+
+static guint32
+writer_add_node (Writer        *self,
+                 GskRenderNode *node)
+{
+  GArray *payload;
+  gpointer index;
+  guint32 header[2];
+
+  index = g_hash_table_lookup (self->node_indexes, node);
+  if (index)
+    return GPOINTER_TO_UINT (index) - 1;
+
+  /* The payload adds the children first, so they get lower indexes */
+  payload = g_array_new (FALSE, FALSE, sizeof (guint32));
+  writer_write_payload (self, node, payload);
+
+  header[0] = gsk_render_node_get_node_type (node);
+  header[1] = payload->len;
+  g_byte_array_append (self->nodes, (const guchar *) header, sizeof (header));
+  g_byte_array_append (self->nodes, (const guchar *) payload->data, payload->len * sizeof (guint32));
+  g_array_unref (payload);
+
+  g_hash_table_insert (self->node_indexes, node, GUINT_TO_POINTER (self->n_nodes + 1));
+
+  return self->n_nodes++;
+}
+
+/**
+ * gsk_render_node_serialize_binary:
+ * @node: a #GskRenderNode
+ *
+ * Serializes @node into the binary format, which is much faster to
+ * load than the text format created by gsk_render_node_serialize().
+ * gsk_render_node_deserialize() detects it automatically.
+ *
+ * The binary format is even less permanent than the text format: it can
+ * only be loaded by the same version of GTK on a machine with the same
+ * byte order.
+ *
+ * Returns: a #GBytes representing the node.
+ */
+GBytes *
+gsk_render_node_serialize_binary (GskRenderNode *node)
+{
+  BinaryHeader header = { { 0, }, };
+  GByteArray *result;
+  Writer writer;
+  gsize padding;
+
+  writer_init (&writer);
+
+  writer_add_node (&writer, node);
+
+  memcpy (header.magic, binary_magic, sizeof (binary_magic));
+  header.byte_order = BYTE_ORDER_MARK;
+  header.version = BINARY_VERSION;
+  header.n_nodes = writer.n_nodes;
+  header.n_blobs = writer.blobs->len;
+  header.nodes_offset = sizeof (BinaryHeader);
+  header.nodes_size = writer.nodes->len;
+  header.blobs_offset = header.nodes_offset + header.nodes_size;
+  header.blob_data_offset = header.blobs_offset + writer.blobs->len * sizeof (BlobEntry);
+  padding = (BLOB_ALIGNMENT - header.blob_data_offset % BLOB_ALIGNMENT) % BLOB_ALIGNMENT;
+  header.blob_data_offset += padding;
+  header.blob_data_size = writer.blob_data->len;
+
+  result = g_byte_array_sized_new (header.blob_data_offset + header.blob_data_size);
+  g_byte_array_append (result, (const guchar *) &header, sizeof (header));
+  g_byte_array_append (result, writer.nodes->data, writer.nodes->len);
+  g_byte_array_append (result, (const guchar *) writer.blobs->data, writer.blobs->len * sizeof (BlobEntry));
+  g_byte_array_set_size (result, result->len + padding);
+  g_byte_array_append (result, writer.blob_data->data, writer.blob_data->len);
+
+  writer_clear (&writer);
+
+  return g_byte_array_free_to_bytes (result);
+}
+
+/*** READER ***/
+
+typedef struct
+{
+  GBytes *bytes;
+  const guchar *data;
+  BinaryHeader header;
+  const guchar *blobs;
+  const guchar *blob_data;
+
+  /* The node being read */
+  const guchar *payload;
+  guint32 payload_len;
+  guint32 pos;
+
+  GPtrArray *nodes;
+  GHashTable *blob_objects; /* index => GObject created from the blob */
+  GHashTable *transforms; /* index => GskTransform */
+
+  GError *error;
+  gsize error_offset;
+} Reader;
+
+static void
+reader_error (Reader     *self,
+              const char *format,
+              ...) G_GNUC_PRINTF (2, 3);
+
+static void
+reader_error (Reader     *self,
+              const char *format,
+              ...)
+{
+  va_list args;
+
+  if (self->error)
+    return;
+
+  va_start (args, format);
+  self->error = g_error_new_valist (GSK_SERIALIZATION_ERROR,
+                                    GSK_SERIALIZATION_INVALID_DATA,
+                                    format, args);
+  va_end (args);
+
+  self->error_offset = self->payload ? self->payload - self->data : 0;
+}
+
+static guint32
+get_uint (Reader *self)
+{
+  guint32 value;
+
+  if (self->pos >= self->payload_len)
+    {
+      reader_error (self, "Node data is too short");
+      return 0;
+    }
+
+  memcpy (&value, self->payload + self->pos * sizeof (guint32), sizeof (guint32));
+  self->pos++;
+
+  return value;
+}
+
+static float
+get_float (Reader *self)
+{
+  guint32 word = get_uint (self);
+  float value;
+
+  memcpy (&value, &word, sizeof (float));
+
+  return value;
+}
+
+static void
+get_rect (Reader          *self,
+          graphene_rect_t *rect)
+{
+  rect->origin.x = get_float (self);
+  rect->origin.y = get_float (self);
+  rect->size.width = get_float (self);
+  rect->size.height = get_float (self);
+}
+
+static void
+get_point (Reader           *self,
+           graphene_point_t *point)
+{
+  point->x = get_float (self);
+  point->y = get_float (self);
+}
+
+static void
+get_rounded_rect (Reader         *self,
+                  GskRoundedRect *rect)
+{
+  guint i;
+
+  get_rect (self, &rect->bounds);
+  for (i = 0; i < 4; i++)
+    {
+      rect->corner[i].width = get_float (self);
+      rect->corner[i].height = get_float (self);
+    }
+}
+
+static void
+get_rgba (Reader  *self,
+          GdkRGBA *rgba)
+{
+  rgba->red = get_float (self);
+  rgba->green = get_float (self);
+  rgba->blue = get_float (self);
+  rgba->alpha = get_float (self);
+}
+
+/* Reads a count of items with item_words words each,
+ * and makes sure they fit into the payload */
+static guint32
+get_count (Reader *self,
+           guint   item_words)
+{
+  guint32 n = get_uint (self);
+
+  if (n > (self->payload_len - self->pos) / item_words)
+    {
+      reader_error (self, "Node data is too short");
+      return 0;
+    }
+
+  return n;
+}
+
+static GskColorStop *
+get_stops (Reader *self,
+           gsize  *n_stops)
+{
+  GskColorStop *stops;
+  guint32 i, n;
+
+  n = get_count (self, 5);
+  stops = g_new (GskColorStop, MAX (n, 1));
+  for (i = 0; i < n; i++)
+    {
+      stops[i].offset = get_float (self);
+      get_rgba (self, &stops[i].color);
+    }
+
+  *n_stops = n;
+
+  return stops;
+}
+
+static GskRenderNode *
+get_node (Reader *self)
+{
+  guint32 index = get_uint (self);
+
+  if (self->error)
+    return NULL;
+
+  if (index >= self->nodes->len)
+    {
+      reader_error (self, "Invalid child node %u", index);
+      return NULL;
+    }
+
+  return g_ptr_array_index (self->nodes, index);
+}
+
+static gboolean
+get_blob (Reader        *self,
+          guint32        index,
+          const guchar **data,
+          gsize         *size)
+{
+  BlobEntry entry;
+
+  if (index >= self->header.n_blobs)
+    {
+      reader_error (self, "Invalid blob %u", index);
+      return FALSE;
+    }
+
+  memcpy (&entry, self->blobs + index * sizeof (BlobEntry), sizeof (BlobEntry));
+  if (entry.offset > self->header.blob_data_size ||
+      entry.size > self->header.blob_data_size - entry.offset)
+    {
+      reader_error (self, "Blob %u is out of bounds", index);
+      return FALSE;
+    }
+
+  *data = self->blob_data + entry.offset;
+  *size = entry.size;
+
+  return TRUE;
+}
+
+static char *
+get_string (Reader *self)
+{
+  guint32 index = get_uint (self);
+  const guchar *data;
+  gsize size;
+
+  if (self->error || index == NO_BLOB)
+    return NULL;
+
+  if (!get_blob (self, index, &data, &size))
+    return NULL;
+
+  return g_strndup ((const char *) data, size);
+}
+
+static GBytes *
+get_bytes (Reader *self,
+           guint32 index)
+{
+  const guchar *data;
+  gsize size;
+
+  if (!get_blob (self, index, &data, &size))
+    return NULL;
+
+  return g_bytes_new_from_bytes (self->bytes, data - self->data, size);
+}
+
+static GdkTexture *
+get_pixels (Reader *self,
+            guint32 index)
+{
+  PixelHeader header;
+  const guchar *data;
+  GdkTexture *texture;
+  GBytes *pixels;
+  gsize size;
+
+  if (!get_blob (self, index, &data, &size))
+    return NULL;
+
+  if (size < sizeof (PixelHeader))
+    {
+      reader_error (self, "Pixel data is too short");
+      return NULL;
+    }
+
+  memcpy (&header, data, sizeof (PixelHeader));
+  if (header.width == 0 || header.height == 0 ||
+      header.stride < header.width * 4 ||
+      (size - sizeof (PixelHeader)) / header.stride < header.height)
+    {
+      reader_error (self, "Invalid pixel data");
+      return NULL;
+    }
+
+  /* The texture points right into the data, no copies */
+  pixels = g_bytes_new_from_bytes (self->bytes,
+                                   data + sizeof (PixelHeader) - self->data,
+                                   (gsize) header.height * header.stride);
+  texture = gdk_memory_texture_new (header.width, header.height,
+                                    GDK_MEMORY_DEFAULT,
+                                    pixels,
+                                    header.stride);
+  g_bytes_unref (pixels);
+
+  return texture;
+}
+
+static GdkTexture *
+get_texture (Reader *self)
+{
+  guint32 index = get_uint (self);
+  GdkTexture *texture;
+
+  if (self->error)
+    return NULL;
+
+  texture = g_hash_table_lookup (self->blob_objects, GUINT_TO_POINTER (index));
+  if (texture)
+    return g_object_ref (texture);
+
+  texture = get_pixels (self, index);
+  if (texture)
+    g_hash_table_insert (self->blob_objects, GUINT_TO_POINTER (index), g_object_ref (texture));
+
+  return texture;
+}
+
+static PangoFont *
+get_font (Reader *self)
+{
+  guint32 index = get_uint (self);
+  PangoFont *font;
+  const guchar *data;
+  gsize size;
+  char *name;
+
+  if (self->error)
+    return NULL;
+
+  font = g_hash_table_lookup (self->blob_objects, GUINT_TO_POINTER (index));
+  if (font)
+    return g_object_ref (font);
+
+  if (!get_blob (self, index, &data, &size))
+    return NULL;
+
+  name = g_strndup ((const char *) data, size);
+  font = gsk_render_node_font_from_string (name);
+  g_free (name);
+
+  if (font == NULL)
+    {
+      reader_error (self, "Could not load font");
+      return NULL;
+    }
+
+  g_hash_table_insert (self->blob_objects, GUINT_TO_POINTER (index), g_object_ref (font));
+
+  return font;
+}
+
+static GskGLShader *
+get_shader (Reader *self)
+{
+  guint32 index = get_uint (self);
+  GskGLShader *shader;
+  GBytes *source;
+
+  if (self->error)
+    return NULL;
+
+  shader = g_hash_table_lookup (self->blob_objects, GUINT_TO_POINTER (index));
+  if (shader)
+    return g_object_ref (shader);
+
+  source = get_bytes (self, index);
+  if (source == NULL)
+    return NULL;
+
+  shader = gsk_gl_shader_new_from_bytes (source);
+  g_bytes_unref (source);
+
+  g_hash_table_insert (self->blob_objects, GUINT_TO_POINTER (index), g_object_ref (shader));
+
+  return shader;
+}
+
+static GskTransform *
+get_transform (Reader *self)
+{
+  guint32 index = get_uint (self);
+  GskTransform *transform;
+  const guchar *data;
+  gsize size;
+  char *string;
+
+  if (self->error)
+    return NULL;
+
+  if (g_hash_table_lookup_extended (self->transforms, GUINT_TO_POINTER (index),
+                                    NULL, (gpointer *) &transform))
+    return gsk_transform_ref (transform);
+
+  if (!get_blob (self, index, &data, &size))
+    return NULL;
+
+  string = g_strndup ((const char *) data, size);
+  if (!gsk_transform_parse (string, &transform))
+    {
+      reader_error (self, "Invalid transform \"%s\"", string);
+      g_free (string);
+      return NULL;
+    }
+  g_free (string);
+
+  g_hash_table_insert (self->transforms, GUINT_TO_POINTER (index), gsk_transform_ref (transform));
+
+  return transform;
+}
+
+static GskRenderNode *
+reader_read_node (Reader            *self,
+                  GskRenderNodeType  node_type)
+{
+  switch (node_type)
+    {
+    case GSK_CONTAINER_NODE:
+      {
+        GskRenderNode **children;
+        guint32 i, n;
+
+        n = get_count (self, 1);
+        children = g_newa (GskRenderNode *, MAX (n, 1));
+        for (i = 0; i < n; i++)
+          children[i] = get_node (self);
+
+        if (self->error)
+          return NULL;
+
+        return gsk_container_node_new (children, n);
+      }
+
+    case GSK_COLOR_NODE:
+      {
+        graphene_rect_t bounds;
+        GdkRGBA color;
+
+        get_rect (self, &bounds);
+        get_rgba (self, &color);
+
+        return gsk_color_node_new (&color, &bounds);
+      }
+
+    case GSK_LINEAR_GRADIENT_NODE:
+    case GSK_REPEATING_LINEAR_GRADIENT_NODE:
+      {
+        graphene_rect_t bounds;
+        graphene_point_t start, end;
+        GskColorStop *stops;
+        GskRenderNode *node;
+        gsize n_stops;
+
+        get_rect (self, &bounds);
+        get_point (self, &start);
+        get_point (self, &end);
+        stops = get_stops (self, &n_stops);
+
+        if (self->error || n_stops < 2)
+          node = NULL;
+        else if (node_type == GSK_REPEATING_LINEAR_GRADIENT_NODE)
+          node = gsk_repeating_linear_gradient_node_new (&bounds, &start, &end, stops, n_stops);
+        else
+          node = gsk_linear_gradient_node_new (&bounds, &start, &end, stops, n_stops);
+
+        g_free (stops);
+
+        return node;
+      }
+
+    case GSK_RADIAL_GRADIENT_NODE:
+    case GSK_REPEATING_RADIAL_GRADIENT_NODE:
+      {
+        graphene_rect_t bounds;
+        graphene_point_t center;
+        float hradius, vradius, start, end;
+        GskColorStop *stops;
+        GskRenderNode *node;
+        gsize n_stops;
+
+        get_rect (self, &bounds);
+        get_point (self, &center);
+        hradius = get_float (self);
+        vradius = get_float (self);
+        start = get_float (self);
+        end = get_float (self);
+        stops = get_stops (self, &n_stops);
+
+        if (self->error || n_stops < 2)
+          node = NULL;
+        else if (node_type == GSK_REPEATING_RADIAL_GRADIENT_NODE)
+          node = gsk_repeating_radial_gradient_node_new (&bounds, &center, hradius, vradius, start, end, stops, n_stops);
+        else
+          node = gsk_radial_gradient_node_new (&bounds, &center, hradius, vradius, start, end, stops, n_stops);
+
+        g_free (stops);
+
+        return node;
+      }
+
+    case GSK_CONIC_GRADIENT_NODE:
+      {
+        graphene_rect_t bounds;
+        graphene_point_t center;
+        GskColorStop *stops;
+        GskRenderNode *node;
+        float rotation;
+        gsize n_stops;
+
+        get_rect (self, &bounds);
+        get_point (self, &center);
+        rotation = get_float (self);
+        stops = get_stops (self, &n_stops);
+
+        if (self->error || n_stops < 2)
+          node = NULL;
+        else
+          node = gsk_conic_gradient_node_new (&bounds, &center, rotation, stops, n_stops);
+
+        g_free (stops);
+
+        return node;
+      }
+
+    case GSK_BORDER_NODE:
+      {
+        GskRoundedRect outline;
+        float widths[4];
+        GdkRGBA colors[4];
+        guint i;
+
+        get_rounded_rect (self, &outline);
+        for (i = 0; i < 4; i++)
+          widths[i] = get_float (self);
+        for (i = 0; i < 4; i++)
+          get_rgba (self, &colors[i]);
+
+        return gsk_border_node_new (&outline, widths, colors);
+      }
+
+    case GSK_TEXTURE_NODE:
+      {
+        graphene_rect_t bounds;
+        GdkTexture *texture;
+        GskRenderNode *node;
+
+        get_rect (self, &bounds);
+        texture = get_texture (self);
+        if (texture == NULL)
+          return NULL;
+
+        node = gsk_texture_node_new (texture, &bounds);
+        g_object_unref (texture);
+
+        return node;
+      }
+
+    case GSK_INSET_SHADOW_NODE:
+    case GSK_OUTSET_SHADOW_NODE:
+      {
+        GskRoundedRect outline;
+        GdkRGBA color;
+        float dx, dy, spread, blur_radius;
+
+        get_rounded_rect (self, &outline);
+        get_rgba (self, &color);
+        dx = get_float (self);
+        dy = get_float (self);
+        spread = get_float (self);
+        blur_radius = get_float (self);
+
+        if (node_type == GSK_INSET_SHADOW_NODE)
+          return gsk_inset_shadow_node_new (&outline, &color, dx, dy, spread, blur_radius);
+        else
+          return gsk_outset_shadow_node_new (&outline, &color, dx, dy, spread, blur_radius);
+      }
+
+    case GSK_CAIRO_NODE:
+      {
+        graphene_rect_t bounds;
+        GskRenderNode *node;
+        guint32 index;
+
+        get_rect (self, &bounds);
+        index = get_uint (self);
+        if (self->error)
+          return NULL;
+
+        node = gsk_cairo_node_new (&bounds);
+
+        if (index != NO_BLOB)
+          {
+            GdkTexture *pixels = get_pixels (self, index);
+            cairo_surface_t *surface;
+            cairo_t *cr;
+
+            if (pixels == NULL)
+              return node;
+
+            cr = gsk_cairo_node_get_draw_context (node);
+            surface = gdk_texture_download_surface (pixels);
+            cairo_set_source_surface (cr, surface, bounds.origin.x, bounds.origin.y);
+            cairo_paint (cr);
+            cairo_destroy (cr);
+            cairo_surface_destroy (surface);
+            g_object_unref (pixels);
+          }
+
+        return node;
+      }
+
+    case GSK_TRANSFORM_NODE:
+      {
+        GskRenderNode *child, *node;
+        GskTransform *transform;
+
+        child = get_node (self);
+        transform = get_transform (self);
+        if (self->error)
+          {
+            gsk_transform_unref (transform);
+            return NULL;
+          }
+
+        /* The identity is stored as NULL */
+        if (transform == NULL)
+          transform = gsk_transform_new ();
+
+        node = gsk_transform_node_new (child, transform);
+        gsk_transform_unref (transform);
+
+        return node;
+      }
+
+    case GSK_OPACITY_NODE:
+      {
+        GskRenderNode *child = get_node (self);
+        float opacity = get_float (self);
+
+        if (self->error)
+          return NULL;
+
+        return gsk_opacity_node_new (child, opacity);
+      }
+
+    case GSK_COLOR_MATRIX_NODE:
+      {
+        graphene_matrix_t matrix;
+        graphene_vec4_t offset;
+        GskRenderNode *child;
+        float values[16];
+        guint i;
+
+        child = get_node (self);
+        for (i = 0; i < 16; i++)
+          values[i] = get_float (self);
+        graphene_matrix_init_from_float (&matrix, values);
+        for (i = 0; i < 4; i++)
+          values[i] = get_float (self);
+        graphene_vec4_init_from_float (&offset, values);
+
+        if (self->error)
+          return NULL;
+
+        return gsk_color_matrix_node_new (child, &matrix, &offset);
+      }
+
+    case GSK_REPEAT_NODE:
+      {
+        graphene_rect_t bounds, child_bounds;
+        GskRenderNode *child;
+
+        get_rect (self, &bounds);
+        child = get_node (self);
+        get_rect (self, &child_bounds);
+
+        if (self->error)
+          return NULL;
+
+        return gsk_repeat_node_new (&bounds, child, &child_bounds);
+      }
+
+    case GSK_CLIP_NODE:
+      {
+        graphene_rect_t clip;
+        GskRenderNode *child;
+
+        child = get_node (self);
+        get_rect (self, &clip);
+
+        if (self->error)
+          return NULL;
+
+        return gsk_clip_node_new (child, &clip);
+      }
+
+    case GSK_ROUNDED_CLIP_NODE:
+      {
+        GskRoundedRect clip;
+        GskRenderNode *child;
+
+        child = get_node (self);
+        get_rounded_rect (self, &clip);
+
+        if (self->error)
+          return NULL;
+
+        return gsk_rounded_clip_node_new (child, &clip);
+      }
+
+    case GSK_SHADOW_NODE:
+      {
+        GskRenderNode *child;
+        GskShadow *shadows;
+        guint32 i, n;
+
+        child = get_node (self);
+        n = get_count (self, 7);
+        shadows = g_newa (GskShadow, MAX (n, 1));
+        for (i = 0; i < n; i++)
+          {
+            get_rgba (self, &shadows[i].color);
+            shadows[i].dx = get_float (self);
+            shadows[i].dy = get_float (self);
+            shadows[i].radius = get_float (self);
+          }
+
+        if (self->error || n == 0)
+          return NULL;
+
+        return gsk_shadow_node_new (child, shadows, n);
+      }
+
+    case GSK_BLEND_NODE:
+      {
+        GskRenderNode *bottom, *top;
+        guint32 mode;
+
+        bottom = get_node (self);
+        top = get_node (self);
+        mode = get_uint (self);
+
+        if (self->error)
+          return NULL;
+
+        if (mode > GSK_BLEND_MODE_LUMINOSITY)
+          {
+            reader_error (self, "Invalid blend mode %u", mode);
+            return NULL;
+          }
+
+        return gsk_blend_node_new (bottom, top, mode);
+      }
+
+    case GSK_CROSS_FADE_NODE:
+      {
+        GskRenderNode *start, *end;
+        float progress;
+
+        start = get_node (self);
+        end = get_node (self);
+        progress = get_float (self);
+
+        if (self->error)
+          return NULL;
+
+        return gsk_cross_fade_node_new (start, end, progress);
+      }
+
+    case GSK_TEXT_NODE:
+      {
+        PangoGlyphString *glyphs;
+        graphene_point_t offset;
+        GskRenderNode *node;
+        PangoFont *font;
+        GdkRGBA color;
+        guint32 i, n;
+
+        font = get_font (self);
+        get_rgba (self, &color);
+        get_point (self, &offset);
+        n = get_count (self, 5);
+
+        if (self->error)
+          {
+            g_clear_object (&font);
+            return NULL;
+          }
+
+        glyphs = pango_glyph_string_new ();
+        pango_glyph_string_set_size (glyphs, n);
+        for (i = 0; i < n; i++)
+          {
+            glyphs->glyphs[i].glyph = get_uint (self);
+            glyphs->glyphs[i].geometry.width = (gint32) get_uint (self);
+            glyphs->glyphs[i].geometry.x_offset = (gint32) get_uint (self);
+            glyphs->glyphs[i].geometry.y_offset = (gint32) get_uint (self);
+            glyphs->glyphs[i].attr.is_cluster_start = get_uint (self) ? 1 : 0;
+          }
+
+        node = gsk_text_node_new (font, glyphs, &color, &offset);
+
+        pango_glyph_string_free (glyphs);
+        g_object_unref (font);
+
+        /* Text nodes have empty bounds if the font is missing */
+        if (node == NULL)
+          node = gsk_container_node_new (NULL, 0);
+
+        return node;
+      }
+
+    case GSK_BLUR_NODE:
+      {
+        GskRenderNode *child = get_node (self);
+        float radius = get_float (self);
+
+        if (self->error)
+          return NULL;
+
+        return gsk_blur_node_new (child, radius);
+      }
+
+    case GSK_DEBUG_NODE:
+      {
+        GskRenderNode *child = get_node (self);
+        char *message = get_string (self);
+
+        if (self->error)
+          {
+            g_free (message);
+            return NULL;
+          }
+
+        return gsk_debug_node_new (child, message);
+      }
+
+    case GSK_GL_SHADER_NODE:
+      {
+        GskRenderNode **children;
+        graphene_rect_t bounds;
+        GskGLShader *shader;
+        GskRenderNode *node;
+        GBytes *args;
+        guint32 i, n;
+
+        get_rect (self, &bounds);
+        shader = get_shader (self);
+        args = self->error ? NULL : get_bytes (self, get_uint (self));
+        n = get_count (self, 1);
+        children = g_newa (GskRenderNode *, MAX (n, 1));
+        for (i = 0; i < n; i++)
+          children[i] = get_node (self);
+
+        if (self->error || n > 4 ||
+            g_bytes_get_size (args) != gsk_gl_shader_get_args_size (shader))
+          {
+            reader_error (self, "Invalid shader node");
+            g_clear_object (&shader);
+            g_clear_pointer (&args, g_bytes_unref);
+            return NULL;
+          }
+
+        node = gsk_gl_shader_node_new (shader, &bounds, args, children, n);
+
+        g_object_unref (shader);
+        g_bytes_unref (args);
+
+        return node;
+      }
+
+    case GSK_NOT_A_RENDER_NODE:
+    default:
+      reader_error (self, "Unknown node type %u", node_type);
+      return NULL;
+    }
+}
+
+static gboolean
+reader_init (Reader *self,
+             GBytes *bytes)
+{
+  gsize size;
+
+  memset (self, 0, sizeof (Reader));
+
+  self->bytes = bytes;
+  self->data = g_bytes_get_data (bytes, &size);
+  self->nodes = g_ptr_array_new_with_free_func ((GDestroyNotify) gsk_render_node_unref);
+  self->blob_objects = g_hash_table_new_full (NULL, NULL, NULL, g_object_unref);
+  self->transforms = g_hash_table_new_full (NULL, NULL, NULL, (GDestroyNotify) gsk_transform_unref);
+
+  if (size < sizeof (BinaryHeader))
+    {
+      self->error = g_error_new_literal (GSK_SERIALIZATION_ERROR,
+                                         GSK_SERIALIZATION_UNSUPPORTED_FORMAT,
+                                         "Data is too short");
+      return FALSE;
+    }
+
+  memcpy (&self->header, self->data, sizeof (BinaryHeader));
+
+  if (self->header.byte_order != BYTE_ORDER_MARK)
+    {
+      self->error = g_error_new_literal (GSK_SERIALIZATION_ERROR,
+                                         GSK_SERIALIZATION_UNSUPPORTED_FORMAT,
+                                         "Data was written on a machine with a different byte order");
+      return FALSE;
+    }
+
+  if (self->header.version != BINARY_VERSION)
+    {
+      self->error = g_error_new (GSK_SERIALIZATION_ERROR,
+                                 GSK_SERIALIZATION_UNSUPPORTED_VERSION,
+                                 "Unsupported version %u", self->header.version);
+      return FALSE;
+    }
+
+  if (self->header.nodes_offset > size ||
+      self->header.nodes_size > size - self->header.nodes_offset ||
+      self->header.blobs_offset > size ||
+      self->header.n_blobs > (size - self->header.blobs_offset) / sizeof (BlobEntry) ||
+      self->header.blob_data_offset > size ||
+      self->header.blob_data_size > size - self->header.blob_data_offset)
+    {
+      self->error = g_error_new_literal (GSK_SERIALIZATION_ERROR,
+                                         GSK_SERIALIZATION_INVALID_DATA,
+                                         "Data is truncated");
+      return FALSE;
+    }
+
+  self->blobs = self->data + self->header.blobs_offset;
+  self->blob_data = self->data + self->header.blob_data_offset;
+
+  return TRUE;
+}
+
+static void
+reader_clear (Reader *self)
+{
+  g_ptr_array_unref (self->nodes);
+  g_hash_table_unref (self->blob_objects);
+  g_hash_table_unref (self->transforms);
+  g_clear_error (&self->error);
+}
+
+GskRenderNode *
+gsk_render_node_deserialize_binary (GBytes            *bytes,
+                                    GskParseErrorFunc  error_func,
+                                    gpointer           user_data)
+{
+  GskRenderNode *root = NULL;
+  const guchar *p, *end;
+  Reader reader;
+
+  if (reader_init (&reader, bytes))
+    {
+      p = reader.data + reader.header.nodes_offset;
+      end = p + reader.header.nodes_size;
+
+      while (reader.nodes->len < reader.header.n_nodes)
+        {
+          guint32 header[2];
+          GskRenderNode *node;
+
+          if (end - p < sizeof (header))
+            {
+              reader_error (&reader, "Node data is truncated");
+              break;
+            }
+
+          memcpy (header, p, sizeof (header));
+          p += sizeof (header);
+
+          if (header[1] > (end - p) / sizeof (guint32))
+            {
+              reader_error (&reader, "Node data is truncated");
+              break;
+            }
+
+          reader.payload = p;
+          reader.payload_len = header[1];
+          reader.pos = 0;
+
+          node = reader_read_node (&reader, header[0]);
+          if (node == NULL)
+            {
+              reader_error (&reader, "Invalid node");
+              break;
+            }
+
+          g_ptr_array_add (reader.nodes, node);
+          p += header[1] * sizeof (guint32);
+        }
+
+      if (reader.error == NULL && reader.nodes->len > 0)
+        root = gsk_render_node_ref (g_ptr_array_index (reader.nodes, reader.nodes->len - 1));
+    }
+
+  if (reader.error && error_func)
+    {
+      GskParseLocation location = { reader.error_offset, reader.error_offset, 0, reader.error_offset, reader.error_offset };
+
+      error_func (&location, &location, reader.error, user_data);
+    }
+
+  reader_clear (&reader);
+
+  return root;
+}
@@ -0,0 +1,13 @@
+#ifndef __GSK_RENDER_NODE_BINARY_PRIVATE_H__
+#define __GSK_RENDER_NODE_BINARY_PRIVATE_H__
+
+#include "gskrendernode.h"
+
+GBytes *        gsk_render_node_serialize_binary        (GskRenderNode     *node);
+
+gboolean        gsk_render_node_is_binary               (GBytes            *bytes);
+GskRenderNode * gsk_render_node_deserialize_binary      (GBytes            *bytes,
+                                                         GskParseErrorFunc  error_func,
+                                                         gpointer           user_data);
+
+#endif
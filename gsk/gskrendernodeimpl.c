@@ -49,6 +49,53 @@ rectangle_init_from_graphene (cairo_rectangle_int_t *cairo,
   cairo->height = ceilf (graphene->origin.y + graphene->size.height) - cairo->y;
 }
 
+static inline guint
+hash_float (guint hash,
+            float value)
+{
+  return gsk_render_node_hash_data (hash, &value, sizeof (float));
+}
+
+static inline guint
+hash_child (guint          hash,
+            GskRenderNode *child)
+{
+  guint child_hash = gsk_render_node_hash (child);
+
+  return gsk_render_node_hash_data (hash, &child_hash, sizeof (guint));
+}
+
+static guint
+hash_color_stops (guint               hash,
+                  const GskColorStop *stops,
+                  gsize               n_stops)
+{
+  hash = gsk_render_node_hash_data (hash, &n_stops, sizeof (gsize));
+
+  return gsk_render_node_hash_data (hash, stops, n_stops * sizeof (GskColorStop));
+}
+
+static gboolean
+color_stops_equal (const GskColorStop *stops1,
+                   gsize               n_stops1,
+                   const GskColorStop *stops2,
+                   gsize               n_stops2)
+{
+  gsize i;
+
+  if (n_stops1 != n_stops2)
+    return FALSE;
+
+  for (i = 0; i < n_stops1; i++)
+    {
+      if (stops1[i].offset != stops2[i].offset ||
+          !gdk_rgba_equal (&stops1[i].color, &stops2[i].color))
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
 /*** GSK_COLOR_NODE ***/
 
 /**
@@ -75,6 +122,25 @@ gsk_color_node_draw (GskRenderNode *node,
   cairo_fill (cr);
 }
 
+static guint
+gsk_color_node_hash (GskRenderNode *node,
+                    guint          hash)
+{
+  GskColorNode *self = (GskColorNode *) node;
+
+  return gsk_render_node_hash_data (hash, &self->color, sizeof (GdkRGBA));
+}
+
+static gboolean
+gsk_color_node_equal (GskRenderNode *node1,
+                     GskRenderNode *node2)
+{
+  GskColorNode *self1 = (GskColorNode *) node1;
+  GskColorNode *self2 = (GskColorNode *) node2;
+
+  return gdk_rgba_equal (&self1->color, &self2->color);
+}
+
 static void
 gsk_color_node_diff (GskRenderNode  *node1,
                      GskRenderNode  *node2,
@@ -165,11 +231,8 @@ static void
 gsk_linear_gradient_node_finalize (GskRenderNode *node)
 {
   GskLinearGradientNode *self = (GskLinearGradientNode *) node;
-  GskRenderNodeClass *parent_class = g_type_class_peek (g_type_parent (GSK_TYPE_LINEAR_GRADIENT_NODE));
 
   g_free (self->stops);
-
-  parent_class->finalize (node);
 }
 
 static void
@@ -203,6 +266,30 @@ gsk_linear_gradient_node_draw (GskRenderNode *node,
   cairo_fill (cr);
 }
 
+static guint
+gsk_linear_gradient_node_hash (GskRenderNode *node,
+                              guint          hash)
+{
+  GskLinearGradientNode *self = (GskLinearGradientNode *) node;
+
+  hash = gsk_render_node_hash_data (hash, &self->start, sizeof (graphene_point_t));
+  hash = gsk_render_node_hash_data (hash, &self->end, sizeof (graphene_point_t));
+
+  return hash_color_stops (hash, self->stops, self->n_stops);
+}
+
+static gboolean
+gsk_linear_gradient_node_equal (GskRenderNode *node1,
+                               GskRenderNode *node2)
+{
+  GskLinearGradientNode *self1 = (GskLinearGradientNode *) node1;
+  GskLinearGradientNode *self2 = (GskLinearGradientNode *) node2;
+
+  return graphene_point_equal (&self1->start, &self2->start) &&
+         graphene_point_equal (&self1->end, &self2->end) &&
+         color_stops_equal (self1->stops, self1->n_stops, self2->stops, self2->n_stops);
+}
+
 static void
 gsk_linear_gradient_node_diff (GskRenderNode  *node1,
                                GskRenderNode  *node2,
@@ -438,11 +525,8 @@ static void
 gsk_radial_gradient_node_finalize (GskRenderNode *node)
 {
   GskRadialGradientNode *self = (GskRadialGradientNode *) node;
-  GskRenderNodeClass *parent_class = g_type_class_peek (g_type_parent (GSK_TYPE_RADIAL_GRADIENT_NODE));
 
   g_free (self->stops);
-
-  parent_class->finalize (node);
 }
 
 static void
@@ -485,6 +569,36 @@ gsk_radial_gradient_node_draw (GskRenderNode *node,
   cairo_pattern_destroy (pattern);
 }
 
+static guint
+gsk_radial_gradient_node_hash (GskRenderNode *node,
+                              guint          hash)
+{
+  GskRadialGradientNode *self = (GskRadialGradientNode *) node;
+
+  hash = gsk_render_node_hash_data (hash, &self->center, sizeof (graphene_point_t));
+  hash = hash_float (hash, self->hradius);
+  hash = hash_float (hash, self->vradius);
+  hash = hash_float (hash, self->start);
+  hash = hash_float (hash, self->end);
+
+  return hash_color_stops (hash, self->stops, self->n_stops);
+}
+
+static gboolean
+gsk_radial_gradient_node_equal (GskRenderNode *node1,
+                               GskRenderNode *node2)
+{
+  GskRadialGradientNode *self1 = (GskRadialGradientNode *) node1;
+  GskRadialGradientNode *self2 = (GskRadialGradientNode *) node2;
+
+  return graphene_point_equal (&self1->center, &self2->center) &&
+         self1->hradius == self2->hradius &&
+         self1->vradius == self2->vradius &&
+         self1->start == self2->start &&
+         self1->end == self2->end &&
+         color_stops_equal (self1->stops, self1->n_stops, self2->stops, self2->n_stops);
+}
+
 static void
 gsk_radial_gradient_node_diff (GskRenderNode  *node1,
                                GskRenderNode  *node2,
@@ -791,11 +905,8 @@ static void
 gsk_conic_gradient_node_finalize (GskRenderNode *node)
 {
   GskConicGradientNode *self = (GskConicGradientNode *) node;
-  GskRenderNodeClass *parent_class = g_type_class_peek (g_type_parent (GSK_TYPE_CONIC_GRADIENT_NODE));
 
   g_free (self->stops);
-
-  parent_class->finalize (node);
 }
 
 #define DEG_TO_RAD(x)          ((x) * (G_PI / 180.f))
@@ -944,6 +1055,30 @@ gsk_conic_gradient_node_draw (GskRenderNode *node,
   cairo_pattern_destroy (pattern);
 }
 
+static guint
+gsk_conic_gradient_node_hash (GskRenderNode *node,
+                             guint          hash)
+{
+  GskConicGradientNode *self = (GskConicGradientNode *) node;
+
+  hash = gsk_render_node_hash_data (hash, &self->center, sizeof (graphene_point_t));
+  hash = hash_float (hash, self->rotation);
+
+  return hash_color_stops (hash, self->stops, self->n_stops);
+}
+
+static gboolean
+gsk_conic_gradient_node_equal (GskRenderNode *node1,
+                              GskRenderNode *node2)
+{
+  GskConicGradientNode *self1 = (GskConicGradientNode *) node1;
+  GskConicGradientNode *self2 = (GskConicGradientNode *) node2;
+
+  return graphene_point_equal (&self1->center, &self2->center) &&
+         self1->rotation == self2->rotation &&
+         color_stops_equal (self1->stops, self1->n_stops, self2->stops, self2->n_stops);
+}
+
 static void
 gsk_conic_gradient_node_diff (GskRenderNode  *node1,
                               GskRenderNode  *node2,
@@ -1248,6 +1383,40 @@ gsk_border_node_draw (GskRenderNode *node,
   cairo_restore (cr);
 }
 
+static guint
+gsk_border_node_hash (GskRenderNode *node,
+                     guint          hash)
+{
+  GskBorderNode *self = (GskBorderNode *) node;
+
+  hash = gsk_render_node_hash_data (hash, &self->outline, sizeof (GskRoundedRect));
+  hash = gsk_render_node_hash_data (hash, self->border_width, sizeof (self->border_width));
+
+  return gsk_render_node_hash_data (hash, self->border_color, sizeof (self->border_color));
+}
+
+static gboolean
+gsk_border_node_equal (GskRenderNode *node1,
+                      GskRenderNode *node2)
+{
+  GskBorderNode *self1 = (GskBorderNode *) node1;
+  GskBorderNode *self2 = (GskBorderNode *) node2;
+
+  guint i;
+
+  if (!gsk_rounded_rect_equal (&self1->outline, &self2->outline))
+    return FALSE;
+
+  for (i = 0; i < 4; i++)
+    {
+      if (self1->border_width[i] != self2->border_width[i] ||
+          !gdk_rgba_equal (&self1->border_color[i], &self2->border_color[i]))
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
 static void
 gsk_border_node_diff (GskRenderNode  *node1,
                       GskRenderNode  *node2,
@@ -1402,11 +1571,8 @@ static void
 gsk_texture_node_finalize (GskRenderNode *node)
 {
   GskTextureNode *self = (GskTextureNode *) node;
-  GskRenderNodeClass *parent_class = g_type_class_peek (g_type_parent (GSK_TYPE_TEXTURE_NODE));
 
   g_clear_object (&self->texture);
-
-  parent_class->finalize (node);
 }
 
 static void
@@ -1438,6 +1604,25 @@ gsk_texture_node_draw (GskRenderNode *node,
   cairo_fill (cr);
 }
 
+static guint
+gsk_texture_node_hash (GskRenderNode *node,
+                      guint          hash)
+{
+  GskTextureNode *self = (GskTextureNode *) node;
+
+  return gsk_render_node_hash_data (hash, &self->texture, sizeof (GdkTexture *));
+}
+
+static gboolean
+gsk_texture_node_equal (GskRenderNode *node1,
+                       GskRenderNode *node2)
+{
+  GskTextureNode *self1 = (GskTextureNode *) node1;
+  GskTextureNode *self2 = (GskTextureNode *) node2;
+
+  return self1->texture == self2->texture;
+}
+
 static void
 gsk_texture_node_diff (GskRenderNode  *node1,
                        GskRenderNode  *node2,
@@ -1894,6 +2079,36 @@ gsk_inset_shadow_node_draw (GskRenderNode *node,
   cairo_restore (cr);
 }
 
+static guint
+gsk_inset_shadow_node_hash (GskRenderNode *node,
+                           guint          hash)
+{
+  GskInsetShadowNode *self = (GskInsetShadowNode *) node;
+
+  hash = gsk_render_node_hash_data (hash, &self->outline, sizeof (GskRoundedRect));
+  hash = gsk_render_node_hash_data (hash, &self->color, sizeof (GdkRGBA));
+  hash = hash_float (hash, self->dx);
+  hash = hash_float (hash, self->dy);
+  hash = hash_float (hash, self->spread);
+
+  return hash_float (hash, self->blur_radius);
+}
+
+static gboolean
+gsk_inset_shadow_node_equal (GskRenderNode *node1,
+                            GskRenderNode *node2)
+{
+  GskInsetShadowNode *self1 = (GskInsetShadowNode *) node1;
+  GskInsetShadowNode *self2 = (GskInsetShadowNode *) node2;
+
+  return gsk_rounded_rect_equal (&self1->outline, &self2->outline) &&
+         gdk_rgba_equal (&self1->color, &self2->color) &&
+         self1->dx == self2->dx &&
+         self1->dy == self2->dy &&
+         self1->spread == self2->spread &&
+         self1->blur_radius == self2->blur_radius;
+}
+
 static void
 gsk_inset_shadow_node_diff (GskRenderNode  *node1,
                             GskRenderNode  *node2,
@@ -2201,6 +2416,36 @@ gsk_outset_shadow_node_draw (GskRenderNode *node,
   cairo_restore (cr);
 }
 
+static guint
+gsk_outset_shadow_node_hash (GskRenderNode *node,
+                            guint          hash)
+{
+  GskOutsetShadowNode *self = (GskOutsetShadowNode *) node;
+
+  hash = gsk_render_node_hash_data (hash, &self->outline, sizeof (GskRoundedRect));
+  hash = gsk_render_node_hash_data (hash, &self->color, sizeof (GdkRGBA));
+  hash = hash_float (hash, self->dx);
+  hash = hash_float (hash, self->dy);
+  hash = hash_float (hash, self->spread);
+
+  return hash_float (hash, self->blur_radius);
+}
+
+static gboolean
+gsk_outset_shadow_node_equal (GskRenderNode *node1,
+                             GskRenderNode *node2)
+{
+  GskOutsetShadowNode *self1 = (GskOutsetShadowNode *) node1;
+  GskOutsetShadowNode *self2 = (GskOutsetShadowNode *) node2;
+
+  return gsk_rounded_rect_equal (&self1->outline, &self2->outline) &&
+         gdk_rgba_equal (&self1->color, &self2->color) &&
+         self1->dx == self2->dx &&
+         self1->dy == self2->dy &&
+         self1->spread == self2->spread &&
+         self1->blur_radius == self2->blur_radius;
+}
+
 static void
 gsk_outset_shadow_node_diff (GskRenderNode  *node1,
                              GskRenderNode  *node2,
@@ -2396,12 +2641,9 @@ static void
 gsk_cairo_node_finalize (GskRenderNode *node)
 {
   GskCairoNode *self = (GskCairoNode *) node;
-  GskRenderNodeClass *parent_class = g_type_class_peek (g_type_parent (GSK_TYPE_CAIRO_NODE));
 
   if (self->surface)
     cairo_surface_destroy (self->surface);
-
-  parent_class->finalize (node);
 }
 
 static void
@@ -2533,14 +2775,11 @@ static void
 gsk_container_node_finalize (GskRenderNode *node)
 {
   GskContainerNode *container = (GskContainerNode *) node;
-  GskRenderNodeClass *parent_class = g_type_class_peek (g_type_parent (GSK_TYPE_CONTAINER_NODE));
 
   for (guint i = 0; i < container->n_children; i++)
     gsk_render_node_unref (container->children[i]);
 
   g_free (container->children);
-
-  parent_class->finalize (node);
 }
 
 static void
@@ -2548,10 +2787,20 @@ gsk_container_node_draw (GskRenderNode *node,
                          cairo_t       *cr)
 {
   GskContainerNode *container = (GskContainerNode *) node;
+  graphene_rect_t clip;
+  double x1, y1, x2, y2;
   guint i;
 
+  /* Skip children that are clipped away, the cairo renderer sets
+   * up a clip per tile and draws the whole tree in each of them */
+  cairo_clip_extents (cr, &x1, &y1, &x2, &y2);
+  graphene_rect_init (&clip, x1, y1, x2 - x1, y2 - y1);
+
   for (i = 0; i < container->n_children; i++)
     {
+      if (!graphene_rect_intersection (&clip, &container->children[i]->bounds, NULL))
+        continue;
+
       gsk_render_node_draw (container->children[i], cr);
     }
 }
@@ -2601,6 +2850,125 @@ gsk_container_node_get_diff_settings (void)
   return settings;
 }
 
+static guint
+gsk_container_node_hash (GskRenderNode *node,
+                        guint          hash)
+{
+  GskContainerNode *self = (GskContainerNode *) node;
+
+  guint i;
+
+  hash = gsk_render_node_hash_data (hash, &self->n_children, sizeof (guint));
+  for (i = 0; i < self->n_children; i++)
+    hash = hash_child (hash, self->children[i]);
+
+  return hash;
+}
+
+static gboolean
+gsk_container_node_equal (GskRenderNode *node1,
+                         GskRenderNode *node2)
+{
+  GskContainerNode *self1 = (GskContainerNode *) node1;
+  GskContainerNode *self2 = (GskContainerNode *) node2;
+
+  guint i;
+
+  if (self1->n_children != self2->n_children)
+    return FALSE;
+
+  for (i = 0; i < self1->n_children; i++)
+    {
+      if (!gsk_render_node_equal (self1->children[i], self2->children[i]))
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
+static guint
+gsk_container_node_child_hash (gconstpointer key)
+{
+  return gsk_render_node_hash ((GskRenderNode *) key);
+}
+
+static gboolean
+gsk_container_node_child_equal (gconstpointer a,
+                                gconstpointer b)
+{
+  return gsk_render_node_equal ((GskRenderNode *) a, (GskRenderNode *) b);
+}
+
+/* Used when gsk_diff() gave up because too many children changed,
+ * like when a list scrolls and rows get added and removed at both
+ * ends. Children are matched by their contents, so unchanged
+ * children are found no matter how their indexes shifted, and only
+ * the bounds of children without a match are added to @region.
+ *
+ * This only works if the matched children keep their relative order,
+ * otherwise they would be stacked differently. Returns %FALSE if
+ * they don't.
+ */
+static gboolean
+gsk_container_node_diff_keyed (GskContainerNode *self1,
+                               GskContainerNode *self2,
+                               cairo_region_t   *region)
+{
+  GHashTable *children1;
+  gboolean *matched;
+  gboolean result = TRUE;
+  gsize last_match = 0;
+  guint i;
+
+  children1 = g_hash_table_new (gsk_container_node_child_hash,
+                                gsk_container_node_child_equal);
+  matched = g_new0 (gboolean, self1->n_children);
+
+  /* Only the first of several equal children can be matched, the
+   * others count as removed */
+  for (i = 0; i < self1->n_children; i++)
+    {
+      if (!g_hash_table_contains (children1, self1->children[i]))
+        g_hash_table_insert (children1, self1->children[i], GSIZE_TO_POINTER (i + 1));
+    }
+
+  for (i = 0; i < self2->n_children; i++)
+    {
+      gsize idx;
+
+      idx = GPOINTER_TO_SIZE (g_hash_table_lookup (children1, self2->children[i]));
+      if (idx == 0)
+        {
+          gsk_render_node_add_to_region (self2->children[i], region);
+          continue;
+        }
+
+      if (idx <= last_match)
+        {
+          result = FALSE;
+          break;
+        }
+
+      g_hash_table_remove (children1, self2->children[i]);
+      matched[idx - 1] = TRUE;
+      last_match = idx;
+    }
+
+  if (result)
+    {
+      for (i = 0; i < self1->n_children; i++)
+        {
+          if (!matched[i])
+            gsk_render_node_add_to_region (self1->children[i], region);
+        }
+    }
+
+  g_free (matched);
+  g_hash_table_unref (children1);
+
+  return result;
+}
+
 static void
 gsk_container_node_diff (GskRenderNode  *node1,
                          GskRenderNode  *node2,
@@ -2617,6 +2985,9 @@ gsk_container_node_diff (GskRenderNode  *node1,
                 region) == GSK_DIFF_OK)
     return;
 
+  if (gsk_container_node_diff_keyed (self1, self2, region))
+    return;
+
   gsk_render_node_diff_impossible (node1, node2, region);
 }
 
@@ -2725,12 +3096,9 @@ static void
 gsk_transform_node_finalize (GskRenderNode *node)
 {
   GskTransformNode *self = (GskTransformNode *) node;
-  GskRenderNodeClass *parent_class = g_type_class_peek (g_type_parent (GSK_TYPE_TRANSFORM_NODE));
 
   gsk_render_node_unref (self->child);
   gsk_transform_unref (self->transform);
-
-  parent_class->finalize (node);
 }
 
 static void
@@ -2760,6 +3128,33 @@ gsk_transform_node_draw (GskRenderNode *node,
   gsk_render_node_draw (self->child, cr);
 }
 
+static guint
+gsk_transform_node_hash (GskRenderNode *node,
+                        guint          hash)
+{
+  GskTransformNode *self = (GskTransformNode *) node;
+
+  graphene_matrix_t matrix;
+  float values[16];
+
+  gsk_transform_to_matrix (self->transform, &matrix);
+  graphene_matrix_to_float (&matrix, values);
+  hash = gsk_render_node_hash_data (hash, values, sizeof (values));
+
+  return hash_child (hash, self->child);
+}
+
+static gboolean
+gsk_transform_node_equal (GskRenderNode *node1,
+                         GskRenderNode *node2)
+{
+  GskTransformNode *self1 = (GskTransformNode *) node1;
+  GskTransformNode *self2 = (GskTransformNode *) node2;
+
+  return gsk_transform_equal (self1->transform, self2->transform) &&
+         gsk_render_node_equal (self1->child, self2->child);
+}
+
 static gboolean
 gsk_transform_node_can_diff (const GskRenderNode *node1,
                              const GskRenderNode *node2)
@@ -2923,11 +3318,8 @@ static void
 gsk_opacity_node_finalize (GskRenderNode *node)
 {
   GskOpacityNode *self = (GskOpacityNode *) node;
-  GskRenderNodeClass *parent_class = g_type_class_peek (g_type_parent (GSK_TYPE_OPACITY_NODE));
 
   gsk_render_node_unref (self->child);
-
-  parent_class->finalize (node);
 }
 
 static void
@@ -2952,6 +3344,28 @@ gsk_opacity_node_draw (GskRenderNode *node,
   cairo_restore (cr);
 }
 
+static guint
+gsk_opacity_node_hash (GskRenderNode *node,
+                      guint          hash)
+{
+  GskOpacityNode *self = (GskOpacityNode *) node;
+
+  hash = hash_float (hash, self->opacity);
+
+  return hash_child (hash, self->child);
+}
+
+static gboolean
+gsk_opacity_node_equal (GskRenderNode *node1,
+                       GskRenderNode *node2)
+{
+  GskOpacityNode *self1 = (GskOpacityNode *) node1;
+  GskOpacityNode *self2 = (GskOpacityNode *) node2;
+
+  return self1->opacity == self2->opacity &&
+         gsk_render_node_equal (self1->child, self2->child);
+}
+
 static void
 gsk_opacity_node_diff (GskRenderNode  *node1,
                        GskRenderNode  *node2,
@@ -3052,11 +3466,8 @@ static void
 gsk_color_matrix_node_finalize (GskRenderNode *node)
 {
   GskColorMatrixNode *self = (GskColorMatrixNode *) node;
-  GskRenderNodeClass *parent_class = g_type_class_peek (g_type_parent (GSK_TYPE_COLOR_MATRIX_NODE));
 
   gsk_render_node_unref (self->child);
-
-  parent_class->finalize (node);
 }
 
 static void
@@ -3141,6 +3552,34 @@ gsk_color_matrix_node_draw (GskRenderNode *node,
   cairo_pattern_destroy (pattern);
 }
 
+static guint
+gsk_color_matrix_node_hash (GskRenderNode *node,
+                           guint          hash)
+{
+  GskColorMatrixNode *self = (GskColorMatrixNode *) node;
+
+  float values[16];
+
+  graphene_matrix_to_float (&self->color_matrix, values);
+  hash = gsk_render_node_hash_data (hash, values, sizeof (values));
+  graphene_vec4_to_float (&self->color_offset, values);
+  hash = gsk_render_node_hash_data (hash, values, 4 * sizeof (float));
+
+  return hash_child (hash, self->child);
+}
+
+static gboolean
+gsk_color_matrix_node_equal (GskRenderNode *node1,
+                            GskRenderNode *node2)
+{
+  GskColorMatrixNode *self1 = (GskColorMatrixNode *) node1;
+  GskColorMatrixNode *self2 = (GskColorMatrixNode *) node2;
+
+  return graphene_matrix_equal (&self1->color_matrix, &self2->color_matrix) &&
+         graphene_vec4_equal (&self1->color_offset, &self2->color_offset) &&
+         gsk_render_node_equal (self1->child, self2->child);
+}
+
 static void
 gsk_color_matrix_node_diff (GskRenderNode  *node1,
                             GskRenderNode  *node2,
@@ -3277,11 +3716,8 @@ static void
 gsk_repeat_node_finalize (GskRenderNode *node)
 {
   GskRepeatNode *self = (GskRepeatNode *) node;
-  GskRenderNodeClass *parent_class = g_type_class_peek (g_type_parent (GSK_TYPE_REPEAT_NODE));
 
   gsk_render_node_unref (self->child);
-
-  parent_class->finalize (node);
 }
 
 static void
@@ -3321,6 +3757,28 @@ gsk_repeat_node_draw (GskRenderNode *node,
   cairo_fill (cr);
 }
 
+static guint
+gsk_repeat_node_hash (GskRenderNode *node,
+                     guint          hash)
+{
+  GskRepeatNode *self = (GskRepeatNode *) node;
+
+  hash = gsk_render_node_hash_data (hash, &self->child_bounds, sizeof (graphene_rect_t));
+
+  return hash_child (hash, self->child);
+}
+
+static gboolean
+gsk_repeat_node_equal (GskRenderNode *node1,
+                      GskRenderNode *node2)
+{
+  GskRepeatNode *self1 = (GskRepeatNode *) node1;
+  GskRepeatNode *self2 = (GskRepeatNode *) node2;
+
+  return graphene_rect_equal (&self1->child_bounds, &self2->child_bounds) &&
+         gsk_render_node_equal (self1->child, self2->child);
+}
+
 /**
  * gsk_repeat_node_new:
  * @bounds: The bounds of the area to be painted
@@ -3414,11 +3872,8 @@ static void
 gsk_clip_node_finalize (GskRenderNode *node)
 {
   GskClipNode *self = (GskClipNode *) node;
-  GskRenderNodeClass *parent_class = g_type_class_peek (g_type_parent (GSK_TYPE_CLIP_NODE));
 
   gsk_render_node_unref (self->child);
-
-  parent_class->finalize (node);
 }
 
 static void
@@ -3437,6 +3892,28 @@ gsk_clip_node_draw (GskRenderNode *node,
   cairo_restore (cr);
 }
 
+static guint
+gsk_clip_node_hash (GskRenderNode *node,
+                   guint          hash)
+{
+  GskClipNode *self = (GskClipNode *) node;
+
+  hash = gsk_render_node_hash_data (hash, &self->clip, sizeof (graphene_rect_t));
+
+  return hash_child (hash, self->child);
+}
+
+static gboolean
+gsk_clip_node_equal (GskRenderNode *node1,
+                    GskRenderNode *node2)
+{
+  GskClipNode *self1 = (GskClipNode *) node1;
+  GskClipNode *self2 = (GskClipNode *) node2;
+
+  return graphene_rect_equal (&self1->clip, &self2->clip) &&
+         gsk_render_node_equal (self1->child, self2->child);
+}
+
 static void
 gsk_clip_node_diff (GskRenderNode  *node1,
                     GskRenderNode  *node2,
@@ -3549,11 +4026,8 @@ static void
 gsk_rounded_clip_node_finalize (GskRenderNode *node)
 {
   GskRoundedClipNode *self = (GskRoundedClipNode *) node;
-  GskRenderNodeClass *parent_class = g_type_class_peek (g_type_parent (GSK_TYPE_ROUNDED_CLIP_NODE));
 
   gsk_render_node_unref (self->child);
-
-  parent_class->finalize (node);
 }
 
 static void
@@ -3572,6 +4046,28 @@ gsk_rounded_clip_node_draw (GskRenderNode *node,
   cairo_restore (cr);
 }
 
+static guint
+gsk_rounded_clip_node_hash (GskRenderNode *node,
+                           guint          hash)
+{
+  GskRoundedClipNode *self = (GskRoundedClipNode *) node;
+
+  hash = gsk_render_node_hash_data (hash, &self->clip, sizeof (GskRoundedRect));
+
+  return hash_child (hash, self->child);
+}
+
+static gboolean
+gsk_rounded_clip_node_equal (GskRenderNode *node1,
+                            GskRenderNode *node2)
+{
+  GskRoundedClipNode *self1 = (GskRoundedClipNode *) node1;
+  GskRoundedClipNode *self2 = (GskRoundedClipNode *) node2;
+
+  return gsk_rounded_rect_equal (&self1->clip, &self2->clip) &&
+         gsk_render_node_equal (self1->child, self2->child);
+}
+
 static void
 gsk_rounded_clip_node_diff (GskRenderNode  *node1,
                             GskRenderNode  *node2,
@@ -3686,12 +4182,9 @@ static void
 gsk_shadow_node_finalize (GskRenderNode *node)
 {
   GskShadowNode *self = (GskShadowNode *) node;
-  GskRenderNodeClass *parent_class = g_type_class_peek (g_type_parent (GSK_TYPE_SHADOW_NODE));
 
   gsk_render_node_unref (self->child);
   g_free (self->shadows);
-
-  parent_class->finalize (node);
 }
 
 static void
@@ -3736,6 +4229,45 @@ gsk_shadow_node_draw (GskRenderNode *node,
   cairo_pattern_destroy (pattern);
 }
 
+static guint
+gsk_shadow_node_hash (GskRenderNode *node,
+                     guint          hash)
+{
+  GskShadowNode *self = (GskShadowNode *) node;
+
+  hash = gsk_render_node_hash_data (hash, &self->n_shadows, sizeof (gsize));
+  hash = gsk_render_node_hash_data (hash, self->shadows, self->n_shadows * sizeof (GskShadow));
+
+  return hash_child (hash, self->child);
+}
+
+static gboolean
+gsk_shadow_node_equal (GskRenderNode *node1,
+                      GskRenderNode *node2)
+{
+  GskShadowNode *self1 = (GskShadowNode *) node1;
+  GskShadowNode *self2 = (GskShadowNode *) node2;
+
+  gsize i;
+
+  if (self1->n_shadows != self2->n_shadows)
+    return FALSE;
+
+  for (i = 0; i < self1->n_shadows; i++)
+    {
+      const GskShadow *shadow1 = &self1->shadows[i];
+      const GskShadow *shadow2 = &self2->shadows[i];
+
+      if (!gdk_rgba_equal (&shadow1->color, &shadow2->color) ||
+          shadow1->dx != shadow2->dx ||
+          shadow1->dy != shadow2->dy ||
+          shadow1->radius != shadow2->radius)
+        return FALSE;
+    }
+
+  return gsk_render_node_equal (self1->child, self2->child);
+}
+
 static void
 gsk_shadow_node_diff (GskRenderNode  *node1,
                       GskRenderNode  *node2,
@@ -3971,12 +4503,9 @@ static void
 gsk_blend_node_finalize (GskRenderNode *node)
 {
   GskBlendNode *self = (GskBlendNode *) node;
-  GskRenderNodeClass *parent_class = g_type_class_peek (g_type_parent (GSK_TYPE_BLEND_NODE));
 
   gsk_render_node_unref (self->bottom);
   gsk_render_node_unref (self->top);
-
-  parent_class->finalize (node);
 }
 
 static void
@@ -3999,6 +4528,30 @@ gsk_blend_node_draw (GskRenderNode *node,
   cairo_paint (cr);
 }
 
+static guint
+gsk_blend_node_hash (GskRenderNode *node,
+                    guint          hash)
+{
+  GskBlendNode *self = (GskBlendNode *) node;
+
+  hash = gsk_render_node_hash_data (hash, &self->blend_mode, sizeof (GskBlendMode));
+  hash = hash_child (hash, self->bottom);
+
+  return hash_child (hash, self->top);
+}
+
+static gboolean
+gsk_blend_node_equal (GskRenderNode *node1,
+                     GskRenderNode *node2)
+{
+  GskBlendNode *self1 = (GskBlendNode *) node1;
+  GskBlendNode *self2 = (GskBlendNode *) node2;
+
+  return self1->blend_mode == self2->blend_mode &&
+         gsk_render_node_equal (self1->bottom, self2->bottom) &&
+         gsk_render_node_equal (self1->top, self2->top);
+}
+
 static void
 gsk_blend_node_diff (GskRenderNode  *node1,
                      GskRenderNode  *node2,
@@ -4126,12 +4679,9 @@ static void
 gsk_cross_fade_node_finalize (GskRenderNode *node)
 {
   GskCrossFadeNode *self = (GskCrossFadeNode *) node;
-  GskRenderNodeClass *parent_class = g_type_class_peek (g_type_parent (GSK_TYPE_CROSS_FADE_NODE));
 
   gsk_render_node_unref (self->start);
   gsk_render_node_unref (self->end);
-
-  parent_class->finalize (node);
 }
 
 static void
@@ -4154,6 +4704,30 @@ gsk_cross_fade_node_draw (GskRenderNode *node,
   cairo_paint (cr);
 }
 
+static guint
+gsk_cross_fade_node_hash (GskRenderNode *node,
+                         guint          hash)
+{
+  GskCrossFadeNode *self = (GskCrossFadeNode *) node;
+
+  hash = hash_float (hash, self->progress);
+  hash = hash_child (hash, self->start);
+
+  return hash_child (hash, self->end);
+}
+
+static gboolean
+gsk_cross_fade_node_equal (GskRenderNode *node1,
+                          GskRenderNode *node2)
+{
+  GskCrossFadeNode *self1 = (GskCrossFadeNode *) node1;
+  GskCrossFadeNode *self2 = (GskCrossFadeNode *) node2;
+
+  return self1->progress == self2->progress &&
+         gsk_render_node_equal (self1->start, self2->start) &&
+         gsk_render_node_equal (self1->end, self2->end);
+}
+
 static void
 gsk_cross_fade_node_diff (GskRenderNode  *node1,
                           GskRenderNode  *node2,
@@ -4285,12 +4859,9 @@ static void
 gsk_text_node_finalize (GskRenderNode *node)
 {
   GskTextNode *self = (GskTextNode *) node;
-  GskRenderNodeClass *parent_class = g_type_class_peek (g_type_parent (GSK_TYPE_TEXT_NODE));
 
   g_object_unref (self->font);
   g_free (self->glyphs);
-
-  parent_class->finalize (node);
 }
 
 static void
@@ -4313,6 +4884,60 @@ gsk_text_node_draw (GskRenderNode *node,
   cairo_restore (cr);
 }
 
+static guint
+gsk_text_node_hash (GskRenderNode *node,
+                   guint          hash)
+{
+  GskTextNode *self = (GskTextNode *) node;
+
+  guint i;
+
+  hash = gsk_render_node_hash_data (hash, &self->font, sizeof (PangoFont *));
+  hash = gsk_render_node_hash_data (hash, &self->color, sizeof (GdkRGBA));
+  hash = gsk_render_node_hash_data (hash, &self->offset, sizeof (graphene_point_t));
+  hash = gsk_render_node_hash_data (hash, &self->num_glyphs, sizeof (guint));
+
+  /* The attributes are bitfields, only look at the parts we compare */
+  for (i = 0; i < self->num_glyphs; i++)
+    {
+      hash = gsk_render_node_hash_data (hash, &self->glyphs[i].glyph, sizeof (PangoGlyph));
+      hash = gsk_render_node_hash_data (hash, &self->glyphs[i].geometry, sizeof (PangoGlyphGeometry));
+    }
+
+  return hash;
+}
+
+static gboolean
+gsk_text_node_equal (GskRenderNode *node1,
+                    GskRenderNode *node2)
+{
+  GskTextNode *self1 = (GskTextNode *) node1;
+  GskTextNode *self2 = (GskTextNode *) node2;
+
+  guint i;
+
+  if (self1->font != self2->font ||
+      !gdk_rgba_equal (&self1->color, &self2->color) ||
+      !graphene_point_equal (&self1->offset, &self2->offset) ||
+      self1->num_glyphs != self2->num_glyphs)
+    return FALSE;
+
+  for (i = 0; i < self1->num_glyphs; i++)
+    {
+      PangoGlyphInfo *info1 = &self1->glyphs[i];
+      PangoGlyphInfo *info2 = &self2->glyphs[i];
+
+      if (info1->glyph != info2->glyph ||
+          info1->geometry.width != info2->geometry.width ||
+          info1->geometry.x_offset != info2->geometry.x_offset ||
+          info1->geometry.y_offset != info2->geometry.y_offset ||
+          info1->attr.is_cluster_start != info2->attr.is_cluster_start)
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
 static void
 gsk_text_node_diff (GskRenderNode  *node1,
                     GskRenderNode  *node2,
@@ -4350,11 +4975,29 @@ gsk_text_node_diff (GskRenderNode  *node1,
   gsk_render_node_diff_impossible (node1, node2, region);
 }
 
+/* Text nodes are created for every run of every layout that gets
+ * drawn, and locking the face each time shows up in profiles, so
+ * we remember the answer on the font. */
+enum {
+  COLOR_GLYPHS_UNKNOWN,
+  COLOR_GLYPHS_NO,
+  COLOR_GLYPHS_YES
+};
+
 static gboolean
 font_has_color_glyphs (const PangoFont *font)
 {
+  static GQuark quark_color_glyphs;
   cairo_scaled_font_t *scaled_font;
   gboolean has_color = FALSE;
+  guint cached;
+
+  if (G_UNLIKELY (quark_color_glyphs == 0))
+    quark_color_glyphs = g_quark_from_static_string ("gsk-text-node-color-glyphs");
+
+  cached = GPOINTER_TO_UINT (g_object_get_qdata (G_OBJECT (font), quark_color_glyphs));
+  if (cached != COLOR_GLYPHS_UNKNOWN)
+    return cached == COLOR_GLYPHS_YES;
 
   scaled_font = pango_cairo_font_get_scaled_font ((PangoCairoFont *)font);
   if (cairo_scaled_font_get_type (scaled_font) == CAIRO_FONT_TYPE_FT)
@@ -4364,6 +5007,9 @@ font_has_color_glyphs (const PangoFont *font)
       cairo_ft_scaled_font_unlock_face (scaled_font);
     }
 
+  g_object_set_qdata (G_OBJECT (font), quark_color_glyphs,
+                      GUINT_TO_POINTER (has_color ? COLOR_GLYPHS_YES : COLOR_GLYPHS_NO));
+
   return has_color;
 }
 
@@ -4549,11 +5195,8 @@ static void
 gsk_blur_node_finalize (GskRenderNode *node)
 {
   GskBlurNode *self = (GskBlurNode *) node;
-  GskRenderNodeClass *parent_class = g_type_class_peek (g_type_parent (GSK_TYPE_BLUR_NODE));
 
   gsk_render_node_unref (self->child);
-
-  parent_class->finalize (node);
 }
 
 static void
@@ -4740,6 +5383,28 @@ gsk_blur_node_draw (GskRenderNode *node,
   cairo_pattern_destroy (pattern);
 }
 
+static guint
+gsk_blur_node_hash (GskRenderNode *node,
+                   guint          hash)
+{
+  GskBlurNode *self = (GskBlurNode *) node;
+
+  hash = hash_float (hash, self->radius);
+
+  return hash_child (hash, self->child);
+}
+
+static gboolean
+gsk_blur_node_equal (GskRenderNode *node1,
+                    GskRenderNode *node2)
+{
+  GskBlurNode *self1 = (GskBlurNode *) node1;
+  GskBlurNode *self2 = (GskBlurNode *) node2;
+
+  return self1->radius == self2->radius &&
+         gsk_render_node_equal (self1->child, self2->child);
+}
+
 static void
 gsk_blur_node_diff (GskRenderNode  *node1,
                     GskRenderNode  *node2,
@@ -4867,12 +5532,9 @@ static void
 gsk_debug_node_finalize (GskRenderNode *node)
 {
   GskDebugNode *self = (GskDebugNode *) node;
-  GskRenderNodeClass *parent_class = g_type_class_peek (g_type_parent (GSK_TYPE_DEBUG_NODE));
 
   gsk_render_node_unref (self->child);
   g_free (self->message);
-
-  parent_class->finalize (node);
 }
 
 static void
@@ -4884,6 +5546,26 @@ gsk_debug_node_draw (GskRenderNode *node,
   gsk_render_node_draw (self->child, cr);
 }
 
+static guint
+gsk_debug_node_hash (GskRenderNode *node,
+                    guint          hash)
+{
+  GskDebugNode *self = (GskDebugNode *) node;
+
+  /* The message doesn't change what gets drawn */
+  return hash_child (hash, self->child);
+}
+
+static gboolean
+gsk_debug_node_equal (GskRenderNode *node1,
+                     GskRenderNode *node2)
+{
+  GskDebugNode *self1 = (GskDebugNode *) node1;
+  GskDebugNode *self2 = (GskDebugNode *) node2;
+
+  return gsk_render_node_equal (self1->child, self2->child);
+}
+
 static gboolean
 gsk_debug_node_can_diff (const GskRenderNode *node1,
                          const GskRenderNode *node2)
@@ -4994,7 +5676,6 @@ static void
 gsk_gl_shader_node_finalize (GskRenderNode *node)
 {
   GskGLShaderNode *self = (GskGLShaderNode *) node;
-  GskRenderNodeClass *parent_class = g_type_class_peek (g_type_parent (GSK_TYPE_GL_SHADER_NODE));
 
   for (guint i = 0; i < self->n_children; i++)
     gsk_render_node_unref (self->children[i]);
@@ -5003,8 +5684,6 @@ gsk_gl_shader_node_finalize (GskRenderNode *node)
   g_bytes_unref (self->args);
 
   g_object_unref (self->shader);
-
-  parent_class->finalize (node);
 }
 
 static void
@@ -5016,6 +5695,47 @@ gsk_gl_shader_node_draw (GskRenderNode *node,
   cairo_fill (cr);
 }
 
+static guint
+gsk_gl_shader_node_hash (GskRenderNode *node,
+                        guint          hash)
+{
+  GskGLShaderNode *self = (GskGLShaderNode *) node;
+
+  guint i, args_hash;
+
+  args_hash = g_bytes_hash (self->args);
+  hash = gsk_render_node_hash_data (hash, &self->shader, sizeof (GskGLShader *));
+  hash = gsk_render_node_hash_data (hash, &args_hash, sizeof (guint));
+  hash = gsk_render_node_hash_data (hash, &self->n_children, sizeof (guint));
+  for (i = 0; i < self->n_children; i++)
+    hash = hash_child (hash, self->children[i]);
+
+  return hash;
+}
+
+static gboolean
+gsk_gl_shader_node_equal (GskRenderNode *node1,
+                         GskRenderNode *node2)
+{
+  GskGLShaderNode *self1 = (GskGLShaderNode *) node1;
+  GskGLShaderNode *self2 = (GskGLShaderNode *) node2;
+
+  guint i;
+
+  if (self1->shader != self2->shader ||
+      self1->n_children != self2->n_children ||
+      !g_bytes_equal (self1->args, self2->args))
+    return FALSE;
+
+  for (i = 0; i < self1->n_children; i++)
+    {
+      if (!gsk_render_node_equal (self1->children[i], self2->children[i]))
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
 static void
 gsk_gl_shader_node_diff (GskRenderNode  *node1,
                          GskRenderNode  *node2,
@@ -5234,6 +5954,8 @@ gsk_render_node_init_types_once (void)
       gsk_container_node_draw,
       NULL,
       gsk_container_node_diff,
+      gsk_container_node_hash,
+      gsk_container_node_equal,
     };
 
     GType node_type = gsk_render_node_type_register_static (I_("GskContainerNode"), &node_info);
@@ -5266,6 +5988,8 @@ gsk_render_node_init_types_once (void)
       gsk_color_node_draw,
       NULL,
       gsk_color_node_diff,
+      gsk_color_node_hash,
+      gsk_color_node_equal,
     };
 
     GType node_type = gsk_render_node_type_register_static (I_("GskColorNode"), &node_info);
@@ -5282,6 +6006,8 @@ gsk_render_node_init_types_once (void)
       gsk_linear_gradient_node_draw,
       NULL,
       gsk_linear_gradient_node_diff,
+      gsk_linear_gradient_node_hash,
+      gsk_linear_gradient_node_equal,
     };
 
     GType node_type = gsk_render_node_type_register_static (I_("GskLinearGradientNode"), &node_info);
@@ -5298,6 +6024,8 @@ gsk_render_node_init_types_once (void)
       gsk_linear_gradient_node_draw,
       NULL,
       gsk_linear_gradient_node_diff,
+      gsk_linear_gradient_node_hash,
+      gsk_linear_gradient_node_equal,
     };
 
     GType node_type = gsk_render_node_type_register_static (I_("GskRepeatingLinearGradientNode"), &node_info);
@@ -5314,6 +6042,8 @@ gsk_render_node_init_types_once (void)
       gsk_radial_gradient_node_draw,
       NULL,
       gsk_radial_gradient_node_diff,
+      gsk_radial_gradient_node_hash,
+      gsk_radial_gradient_node_equal,
     };
 
     GType node_type = gsk_render_node_type_register_static (I_("GskRadialGradientNode"), &node_info);
@@ -5330,6 +6060,8 @@ gsk_render_node_init_types_once (void)
       gsk_radial_gradient_node_draw,
       NULL,
       gsk_radial_gradient_node_diff,
+      gsk_radial_gradient_node_hash,
+      gsk_radial_gradient_node_equal,
     };
 
     GType node_type = gsk_render_node_type_register_static (I_("GskRepeatingRadialGradientNode"), &node_info);
@@ -5346,6 +6078,8 @@ gsk_render_node_init_types_once (void)
       gsk_conic_gradient_node_draw,
       NULL,
       gsk_conic_gradient_node_diff,
+      gsk_conic_gradient_node_hash,
+      gsk_conic_gradient_node_equal,
     };
 
     GType node_type = gsk_render_node_type_register_static (I_("GskConicGradientNode"), &node_info);
@@ -5362,6 +6096,8 @@ gsk_render_node_init_types_once (void)
       gsk_border_node_draw,
       NULL,
       gsk_border_node_diff,
+      gsk_border_node_hash,
+      gsk_border_node_equal,
     };
 
     GType node_type = gsk_render_node_type_register_static (I_("GskBorderNode"), &node_info);
@@ -5378,6 +6114,8 @@ gsk_render_node_init_types_once (void)
       gsk_texture_node_draw,
       NULL,
       gsk_texture_node_diff,
+      gsk_texture_node_hash,
+      gsk_texture_node_equal,
     };
 
     GType node_type = gsk_render_node_type_register_static (I_("GskTextureNode"), &node_info);
@@ -5394,6 +6132,8 @@ gsk_render_node_init_types_once (void)
       gsk_inset_shadow_node_draw,
       NULL,
       gsk_inset_shadow_node_diff,
+      gsk_inset_shadow_node_hash,
+      gsk_inset_shadow_node_equal,
     };
 
     GType node_type = gsk_render_node_type_register_static (I_("GskInsetShadowNode"), &node_info);
@@ -5410,6 +6150,8 @@ gsk_render_node_init_types_once (void)
       gsk_outset_shadow_node_draw,
       NULL,
       gsk_outset_shadow_node_diff,
+      gsk_outset_shadow_node_hash,
+      gsk_outset_shadow_node_equal,
     };
 
     GType node_type = gsk_render_node_type_register_static (I_("GskOutsetShadowNode"), &node_info);
@@ -5426,6 +6168,8 @@ gsk_render_node_init_types_once (void)
       gsk_transform_node_draw,
       gsk_transform_node_can_diff,
       gsk_transform_node_diff,
+      gsk_transform_node_hash,
+      gsk_transform_node_equal,
     };
 
     GType node_type = gsk_render_node_type_register_static (I_("GskTransformNode"), &node_info);
@@ -5442,6 +6186,8 @@ gsk_render_node_init_types_once (void)
       gsk_opacity_node_draw,
       NULL,
       gsk_opacity_node_diff,
+      gsk_opacity_node_hash,
+      gsk_opacity_node_equal,
     };
 
     GType node_type = gsk_render_node_type_register_static (I_("GskOpacityNode"), &node_info);
@@ -5458,6 +6204,8 @@ gsk_render_node_init_types_once (void)
       gsk_color_matrix_node_draw,
       NULL,
       gsk_color_matrix_node_diff,
+      gsk_color_matrix_node_hash,
+      gsk_color_matrix_node_equal,
     };
 
     GType node_type = gsk_render_node_type_register_static (I_("GskColorMatrixNode"), &node_info);
@@ -5474,6 +6222,8 @@ gsk_render_node_init_types_once (void)
       gsk_repeat_node_draw,
       NULL,
       NULL,
+      gsk_repeat_node_hash,
+      gsk_repeat_node_equal,
     };
 
     GType node_type = gsk_render_node_type_register_static (I_("GskRepeatNode"), &node_info);
@@ -5490,6 +6240,8 @@ gsk_render_node_init_types_once (void)
       gsk_clip_node_draw,
       NULL,
       gsk_clip_node_diff,
+      gsk_clip_node_hash,
+      gsk_clip_node_equal,
     };
 
     GType node_type = gsk_render_node_type_register_static (I_("GskClipNode"), &node_info);
@@ -5506,6 +6258,8 @@ gsk_render_node_init_types_once (void)
       gsk_rounded_clip_node_draw,
       NULL,
       gsk_rounded_clip_node_diff,
+      gsk_rounded_clip_node_hash,
+      gsk_rounded_clip_node_equal,
     };
 
     GType node_type = gsk_render_node_type_register_static (I_("GskRoundedClipNode"), &node_info);
@@ -5522,6 +6276,8 @@ gsk_render_node_init_types_once (void)
       gsk_shadow_node_draw,
       NULL,
       gsk_shadow_node_diff,
+      gsk_shadow_node_hash,
+      gsk_shadow_node_equal,
     };
 
     GType node_type = gsk_render_node_type_register_static (I_("GskShadowNode"), &node_info);
@@ -5538,6 +6294,8 @@ gsk_render_node_init_types_once (void)
       gsk_blend_node_draw,
       NULL,
       gsk_blend_node_diff,
+      gsk_blend_node_hash,
+      gsk_blend_node_equal,
     };
 
     GType node_type = gsk_render_node_type_register_static (I_("GskBlendNode"), &node_info);
@@ -5554,6 +6312,8 @@ gsk_render_node_init_types_once (void)
       gsk_cross_fade_node_draw,
       NULL,
       gsk_cross_fade_node_diff,
+      gsk_cross_fade_node_hash,
+      gsk_cross_fade_node_equal,
     };
 
     GType node_type = gsk_render_node_type_register_static (I_("GskCrossFadeNode"), &node_info);
@@ -5570,6 +6330,8 @@ gsk_render_node_init_types_once (void)
       gsk_text_node_draw,
       NULL,
       gsk_text_node_diff,
+      gsk_text_node_hash,
+      gsk_text_node_equal,
     };
 
     GType node_type = gsk_render_node_type_register_static (I_("GskTextNode"), &node_info);
@@ -5586,6 +6348,8 @@ gsk_render_node_init_types_once (void)
       gsk_blur_node_draw,
       NULL,
       gsk_blur_node_diff,
+      gsk_blur_node_hash,
+      gsk_blur_node_equal,
     };
 
     GType node_type = gsk_render_node_type_register_static (I_("GskBlurNode"), &node_info);
@@ -5602,6 +6366,8 @@ gsk_render_node_init_types_once (void)
       gsk_gl_shader_node_draw,
       NULL,
       gsk_gl_shader_node_diff,
+      gsk_gl_shader_node_hash,
+      gsk_gl_shader_node_equal,
     };
 
     GType node_type = gsk_render_node_type_register_static (I_("GskGLShaderNode"), &node_info);
@@ -5618,6 +6384,8 @@ gsk_render_node_init_types_once (void)
       gsk_debug_node_draw,
       gsk_debug_node_can_diff,
       gsk_debug_node_diff,
+      gsk_debug_node_hash,
+      gsk_debug_node_equal,
     };
 
     GType node_type = gsk_render_node_type_register_static (I_("GskDebugNode"), &node_info);
@@ -631,8 +631,8 @@ parse_blend_mode (GtkCssParser *parser,
   return FALSE;
 }
 
-static PangoFont *
-font_from_string (const char *string)
+PangoFont *
+gsk_render_node_font_from_string (const char *string)
 {
   PangoFontDescription *desc;
   PangoFontMap *font_map;
@@ -717,7 +717,7 @@ parse_font (GtkCssParser *parser,
   if (s == NULL)
     return FALSE;
 
-  font = font_from_string (s);
+  font = gsk_render_node_font_from_string (s);
   if (font == NULL)
     {
       gtk_css_parser_error_syntax (parser, "This font does not exist.");
@@ -1647,7 +1647,7 @@ parse_text_node (GtkCssParser *parser)
 
   if (font == NULL)
     {
-      font = font_from_string ("Cantarell 11");
+      font = gsk_render_node_font_from_string ("Cantarell 11");
       g_assert (font);
     }
 
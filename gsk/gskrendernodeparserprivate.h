@@ -8,4 +8,6 @@ GskRenderNode * gsk_render_node_deserialize_from_bytes  (GBytes            *byte
                                                          GskParseErrorFunc  error_func,
                                                          gpointer           user_data);
 
+PangoFont *     gsk_render_node_font_from_string        (const char        *string);
+
 #endif
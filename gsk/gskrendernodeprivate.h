@@ -27,6 +27,8 @@ struct _GskRenderNode
   gatomicrefcount ref_count;
 
   graphene_rect_t bounds;
+
+  guint hash; /* 0 until gsk_render_node_hash() computed it */
 };
 
 struct _GskRenderNodeClass
@@ -43,6 +45,10 @@ struct _GskRenderNodeClass
   void            (* diff)        (GskRenderNode  *node1,
                                    GskRenderNode  *node2,
                                    cairo_region_t *region);
+  guint           (* hash)        (GskRenderNode  *node,
+                                   guint           hash);
+  gboolean        (* equal)       (GskRenderNode  *node1,
+                                   GskRenderNode  *node2);
 };
 
 /*< private >
@@ -50,13 +56,19 @@ struct _GskRenderNodeClass
  * @node_type: the render node type in the #GskRenderNodeType enumeration
  * @instance_size: the size of the render node instance
  * @instance_init: (nullable): the instance initialization function
- * @finalize: (nullable): the instance finalization function; must chain up to the
- *   implementation of the parent class
+ * @finalize: (nullable): the instance finalization function; releases the
+ *   data of the node, but must not chain up: the instance is freed by
+ *   gsk_render_node_unref()
  * @draw: the function called by gsk_render_node_draw()
  * @can_diff: (nullable): the function called by gsk_render_node_can_diff(); if
  *   unset, gsk_render_node_can_diff_true() will be used
  * @diff: (nullable): the function called by gsk_render_node_diff(); if unset,
  *   gsk_render_node_diff_impossible() will be used
+ * @hash: (nullable): mixes the contents of the node into the given hash, the
+ *   type and bounds are already part of it; if unset, the node's address is used
+ * @equal: (nullable): compares the contents of two nodes of the same type and
+ *   bounds, nodes that compare equal must produce the same hash; if unset, only
+ *   a node is equal to itself
  *
  * A struction that contains the type information for a #GskRenderNode subclass,
  * to be used by gsk_render_node_type_register_static().
@@ -76,6 +88,10 @@ typedef struct
   void            (* diff)          (GskRenderNode        *node1,
                                      GskRenderNode        *node2,
                                      cairo_region_t       *region);
+  guint           (* hash)          (GskRenderNode        *node,
+                                     guint                 hash);
+  gboolean        (* equal)         (GskRenderNode        *node1,
+                                     GskRenderNode        *node2);
 } GskRenderNodeTypeInfo;
 
 void            gsk_render_node_init_types              (void);
@@ -84,6 +100,7 @@ GType           gsk_render_node_type_register_static    (const char
                                                          const GskRenderNodeTypeInfo *node_info);
 
 gpointer        gsk_render_node_alloc                   (GskRenderNodeType            node_type);
+guint           gsk_render_node_get_n_allocated         (void);
 
 gboolean        gsk_render_node_can_diff                (const GskRenderNode         *node1,
                                                          const GskRenderNode         *node2) G_GNUC_PURE;
@@ -94,6 +111,13 @@ void            gsk_render_node_diff_impossible         (GskRenderNode
                                                          GskRenderNode               *node2,
                                                          cairo_region_t              *region);
 
+guint           gsk_render_node_hash                    (GskRenderNode               *node);
+gboolean        gsk_render_node_equal                   (GskRenderNode               *node1,
+                                                         GskRenderNode               *node2);
+guint           gsk_render_node_hash_data               (guint                        hash,
+                                                         gconstpointer                data,
+                                                         gsize                        size);
+
 bool            gsk_border_node_get_uniform             (GskRenderNode               *self);
 
 G_END_DECLS
@@ -37,6 +37,7 @@
 
 #include "gskdebugprivate.h"
 
+#include <float.h>
 #include <math.h>
 
 static void
@@ -400,6 +401,53 @@ gsk_rounded_rect_contains_point (const GskRoundedRect   *self,
   return gsk_rounded_rect_locate_point (self, point) == INSIDE;
 }
 
+/* For each corner, in GskCorner order, checks how far the matching point
+ * lies outside of the corner's ellipse. The result is > 1 if the point is
+ * in the corner's outside region and <= 1 if it is not, so callers can
+ * check all 4 corners at once. Points must not be further away from the
+ * corner's ellipse center than the corner box reaches. */
+static inline graphene_simd4f_t
+gsk_rounded_rect_corner_distances (const GskRoundedRect *self,
+                                   graphene_simd4f_t     px,
+                                   graphene_simd4f_t     py)
+{
+  const graphene_simd4f_t xsign = graphene_simd4f_init (1.f, -1.f, -1.f, 1.f);
+  const graphene_simd4f_t ysign = graphene_simd4f_init (1.f, 1.f, -1.f, -1.f);
+  const graphene_simd4f_t zero = graphene_simd4f_splat (0.f);
+  const graphene_simd4f_t tiny = graphene_simd4f_splat (FLT_MIN);
+  float left = self->bounds.origin.x;
+  float top = self->bounds.origin.y;
+  float right = left + self->bounds.size.width;
+  float bottom = top + self->bounds.size.height;
+  graphene_simd4f_t cw, ch, cx, cy, dx, dy;
+
+  cw = graphene_simd4f_init (self->corner[GSK_CORNER_TOP_LEFT].width,
+                             self->corner[GSK_CORNER_TOP_RIGHT].width,
+                             self->corner[GSK_CORNER_BOTTOM_RIGHT].width,
+                             self->corner[GSK_CORNER_BOTTOM_LEFT].width);
+  ch = graphene_simd4f_init (self->corner[GSK_CORNER_TOP_LEFT].height,
+                             self->corner[GSK_CORNER_TOP_RIGHT].height,
+                             self->corner[GSK_CORNER_BOTTOM_RIGHT].height,
+                             self->corner[GSK_CORNER_BOTTOM_LEFT].height);
+
+  /* The centers of the ellipses */
+  cx = graphene_simd4f_add (graphene_simd4f_init (left, right, right, left),
+                            graphene_simd4f_mul (cw, xsign));
+  cy = graphene_simd4f_add (graphene_simd4f_init (top, top, bottom, bottom),
+                            graphene_simd4f_mul (ch, ysign));
+
+  /* Distance towards the corner, 0 if the point is not in the corner box.
+   * Then it is <= the radius, so the result stays <= 1 */
+  dx = graphene_simd4f_max (graphene_simd4f_mul (graphene_simd4f_sub (cx, px), xsign), zero);
+  dy = graphene_simd4f_max (graphene_simd4f_mul (graphene_simd4f_sub (cy, py), ysign), zero);
+
+  /* Corners without radius have a distance of 0, avoid dividing 0 by 0 */
+  return graphene_simd4f_add (graphene_simd4f_div (graphene_simd4f_mul (dx, dx),
+                                                   graphene_simd4f_max (graphene_simd4f_mul (cw, cw), tiny)),
+                              graphene_simd4f_div (graphene_simd4f_mul (dy, dy),
+                                                   graphene_simd4f_max (graphene_simd4f_mul (ch, ch), tiny)));
+}
+
 /**
  * gsk_rounded_rect_contains_rect:
  * @self: a #GskRoundedRect
@@ -415,19 +463,24 @@ gboolean
 gsk_rounded_rect_contains_rect (const GskRoundedRect  *self,
                                 const graphene_rect_t *rect)
 {
-  if (rect->origin.x < self->bounds.origin.x ||
-      rect->origin.y < self->bounds.origin.y ||
-      rect->origin.x + rect->size.width > self->bounds.origin.x + self->bounds.size.width ||
-      rect->origin.y + rect->size.height > self->bounds.origin.y + self->bounds.size.height)
+  float x1 = rect->origin.x, y1 = rect->origin.y;
+  float x2 = x1 + rect->size.width, y2 = y1 + rect->size.height;
+
+  /* x1 >= left, y1 >= top, -x2 >= -right, -y2 >= -bottom */
+  if (!graphene_simd4f_cmp_ge (graphene_simd4f_init (x1, y1, -x2, -y2),
+                               graphene_simd4f_init (self->bounds.origin.x,
+                                                     self->bounds.origin.y,
+                                                     - (self->bounds.origin.x + self->bounds.size.width),
+                                                     - (self->bounds.origin.y + self->bounds.size.height))))
     return FALSE;
 
-  if (!gsk_rounded_rect_contains_point (self, &rect->origin) ||
-      !gsk_rounded_rect_contains_point (self, &GRAPHENE_POINT_INIT (rect->origin.x + rect->size.width, rect->origin.y)) ||
-      !gsk_rounded_rect_contains_point (self, &GRAPHENE_POINT_INIT (rect->origin.x, rect->origin.y + rect->size.height)) ||
-      !gsk_rounded_rect_contains_point (self, &GRAPHENE_POINT_INIT (rect->origin.x + rect->size.width, rect->origin.y + rect->size.height)))
-    return FALSE;
-
-  return TRUE;
+  /* The rounded rect is convex and the rect is inside its bounds, so the
+   * rect is contained if each of its corners is inside the ellipse of the
+   * same corner */
+  return graphene_simd4f_cmp_le (gsk_rounded_rect_corner_distances (self,
+                                                                    graphene_simd4f_init (x1, x2, x2, x1),
+                                                                    graphene_simd4f_init (y1, y1, y2, y2)),
+                                 graphene_simd4f_splat (1.f));
 }
 
 /**
@@ -445,18 +498,22 @@ gboolean
 gsk_rounded_rect_intersects_rect (const GskRoundedRect  *self,
                                   const graphene_rect_t *rect)
 {
+  float x1, y1, x2, y2;
+
   if (!graphene_rect_intersection (&self->bounds, rect, NULL))
     return FALSE;
 
+  x1 = rect->origin.x;
+  y1 = rect->origin.y;
+  x2 = x1 + rect->size.width;
+  y2 = y1 + rect->size.height;
+
   /* If the bounding boxes intersect but the rectangles don't, one of the rect's corners
    * must be in the opposite corner's outside region */
-  if (gsk_rounded_rect_locate_point (self, &rect->origin) == OUTSIDE_BOTTOM_RIGHT ||
-      gsk_rounded_rect_locate_point (self, &GRAPHENE_POINT_INIT (rect->origin.x + rect->size.width, rect->origin.y)) == OUTSIDE_BOTTOM_LEFT ||
-      gsk_rounded_rect_locate_point (self, &GRAPHENE_POINT_INIT (rect->origin.x, rect->origin.y + rect->size.height)) == OUTSIDE_TOP_RIGHT ||
-      gsk_rounded_rect_locate_point (self, &GRAPHENE_POINT_INIT (rect->origin.x + rect->size.width, rect->origin.y + rect->size.height)) == OUTSIDE_TOP_LEFT)
-    return FALSE;
-
-  return TRUE;
+  return graphene_simd4f_cmp_le (gsk_rounded_rect_corner_distances (self,
+                                                                    graphene_simd4f_init (x2, x1, x1, x2),
+                                                                    graphene_simd4f_init (y2, y2, y1, y1)),
+                                 graphene_simd4f_splat (1.f));
 }
 
 static void
@@ -1792,12 +1792,11 @@ gsk_transform_transform_bounds (GskTransform          *self,
       {
         float dx, dy;
 
+        /* A rect is 4 floats: x, y, width, height */
         gsk_transform_to_translate (self, &dx, &dy);
-        graphene_rect_init (out_rect,
-                            rect->origin.x + dx,
-                            rect->origin.y + dy,
-                            rect->size.width,
-                            rect->size.height);
+        graphene_simd4f_dup_4f (graphene_simd4f_add (graphene_simd4f_init_4f ((const float *) rect),
+                                                     graphene_simd4f_init (dx, dy, 0.f, 0.f)),
+                                (float *) out_rect);
       }
     break;
 
@@ -1807,11 +1806,10 @@ gsk_transform_transform_bounds (GskTransform          *self,
 
         gsk_transform_to_affine (self, &scale_x, &scale_y, &dx, &dy);
 
-        graphene_rect_init (out_rect,
-                            (rect->origin.x * scale_x) + dx,
-                            (rect->origin.y * scale_y) + dy,
-                            rect->size.width * scale_x,
-                            rect->size.height * scale_y);
+        graphene_simd4f_dup_4f (graphene_simd4f_add (graphene_simd4f_mul (graphene_simd4f_init_4f ((const float *) rect),
+                                                                          graphene_simd4f_init (scale_x, scale_y, scale_x, scale_y)),
+                                                     graphene_simd4f_init (dx, dy, 0.f, 0.f)),
+                                (float *) out_rect);
       }
     break;
 
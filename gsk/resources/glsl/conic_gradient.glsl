@@ -45,6 +45,12 @@ _IN_ float rotation;
 _IN_ vec4 color_stops[6];
 _IN_ float color_offsets[6];
 
+// Colors of gradients with too many stops for uniforms come
+// premultiplied from a ramp texture bound as u_source.
+vec4 ramp_color(float offset) {
+  return GskTexture(u_source, vec2((clamp(offset, 0.0, 1.0) * 255.0 + 0.5) / 256.0, 0.5));
+}
+
 void main() {
   // Position relative to center
   vec2 pos = gsk_get_frag_coord() - center;
@@ -57,6 +63,11 @@ void main() {
   // into the current conic
   float offset = fract (angle / 2 / PI + 2);
 
+  if (u_num_color_stops == 0) {
+    gskSetOutputColor(ramp_color(offset) * u_alpha);
+    return;
+  }
+
   vec4 color = color_stops[0];
   for (int i = 1; i < u_num_color_stops; i ++) {
     if (offset >= color_offsets[i - 1])  {
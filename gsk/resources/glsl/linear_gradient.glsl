@@ -47,6 +47,12 @@ _IN_ float gradientLength;
 _IN_ vec4 color_stops[6];
 _IN_ float color_offsets[6];
 
+// Colors of gradients with too many stops for uniforms come
+// premultiplied from a ramp texture bound as u_source.
+vec4 ramp_color(float offset) {
+  return GskTexture(u_source, vec2((clamp(offset, 0.0, 1.0) * 255.0 + 0.5) / 256.0, 0.5));
+}
+
 void main() {
   // Position relative to startPoint
   vec2 pos = gsk_get_frag_coord() - startPoint;
@@ -58,6 +64,11 @@ void main() {
   // Offset of the current pixel
   float offset = length(proj) / maxDist;
 
+  if (u_num_color_stops == 0) {
+    gskSetOutputColor(ramp_color(offset) * u_alpha);
+    return;
+  }
+
   vec4 color = color_stops[0];
   for (int i = 1; i < u_num_color_stops; i ++) {
     if (offset >= color_offsets[i - 1])  {
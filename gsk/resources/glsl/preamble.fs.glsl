@@ -1,9 +1,11 @@
 uniform sampler2D u_source;
+#if !defined(GSK_GL3)
 uniform mat4 u_projection;
 uniform mat4 u_modelview;
 uniform float u_alpha;// = 1.0;
 uniform vec4 u_viewport;
 uniform vec4[3] u_clip_rect;
+#endif
 
 #if defined(GSK_LEGACY)
 _OUT_ vec4 outputColor;
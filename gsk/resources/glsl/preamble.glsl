@@ -13,6 +13,18 @@ precision highp float;
 #endif
 
 
+#if defined(GSK_GL3)
+// State shared by all programs, see GskGLCommonUniforms
+layout(std140) uniform GskCommon
+{
+  mat4 u_projection;
+  mat4 u_modelview;
+  vec4 u_viewport;
+  vec4 u_clip_rect[3];
+  float u_alpha;
+};
+#endif
+
 struct GskRoundedRect
 {
   vec4 bounds; // Top left and bottom right
@@ -1,14 +1,18 @@
+#if !defined(GSK_GL3)
 uniform mat4 u_projection;
 uniform mat4 u_modelview;
 uniform float u_alpha;
+#endif
 
 #if defined(GSK_GLES) || defined(GSK_LEGACY)
 attribute vec2 aPosition;
 attribute vec2 aUv;
+attribute vec4 aColor;
 _OUT_ vec2 vUv;
 #else
 _IN_ vec2 aPosition;
 _IN_ vec2 aUv;
+_IN_ vec4 aColor;
 _OUT_ vec2 vUv;
 #endif
 
@@ -50,11 +50,22 @@ float abs_offset(float offset)  {
   return start + ((end - start) * offset);
 }
 
+// Colors of gradients with too many stops for uniforms come
+// premultiplied from a ramp texture bound as u_source.
+vec4 ramp_color(float offset) {
+  return GskTexture(u_source, vec2((clamp(offset, 0.0, 1.0) * 255.0 + 0.5) / 256.0, 0.5));
+}
+
 void main() {
   vec2 pixel = gsk_get_frag_coord();
   vec2 rel = (center - pixel) / (u_radius);
   float d = sqrt(dot(rel, rel));
 
+  if (u_num_color_stops == 0) {
+    gskSetOutputColor(ramp_color((d - start) / (end - start)) * u_alpha);
+    return;
+  }
+
   if (d < abs_offset (color_offsets[0])) {
     gskSetOutputColor(color_stops[0] * u_alpha);
     return;
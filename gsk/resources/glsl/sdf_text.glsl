@@ -0,0 +1,23 @@
+// VERTEX_SHADER:
+_OUT_ vec4 final_color;
+
+void main() {
+  gl_Position = u_projection * u_modelview * vec4(aPosition, 0.0, 1.0);
+
+  vUv = vec2(aUv.x, aUv.y);
+
+  final_color = gsk_premultiply(aColor) * u_alpha;
+}
+
+// FRAGMENT_SHADER:
+
+_IN_ vec4 final_color;
+
+void main() {
+  // Signed distance to the glyph outline, 0.5 is on the outline
+  float dist = GskTexture(u_source, vUv).a;
+  // Antialias over one device pixel, at whatever scale we're drawn
+  float coverage = clamp((dist - 0.5) / max(fwidth(dist), 0.0001) + 0.5, 0.0, 1.0);
+
+  gskSetOutputColor(final_color * coverage);
+}
@@ -22,6 +22,12 @@
 #define CHECK_INTERVAL 10
 #define MAX_OLD 0.333
 
+/* The cache is shared by all renderers of a display, so a frame is
+ * only counted once per FRAME_INTERVAL, no matter how many windows
+ * start drawing in it.
+ */
+#define FRAME_INTERVAL (G_USEC_PER_SEC / 60)
+
 
 typedef struct {
   GskVulkanImage *image;
@@ -35,13 +41,11 @@ typedef struct {
 struct _GskVulkanGlyphCache {
   GObject parent_instance;
 
-  GdkVulkanContext *vulkan;
-  GskRenderer *renderer;
-
   GHashTable *hash_table;
   GPtrArray *atlases;
 
   guint64 timestamp;
+  gint64 last_frame_time;
 };
 
 struct _GskVulkanGlyphCacheClass {
@@ -232,7 +236,7 @@ add_to_cache (GskVulkanGlyphCache  *cache,
   atlas->num_glyphs++;
 
 #ifdef G_ENABLE_DEBUG
-  if (GSK_RENDERER_DEBUG_CHECK (cache->renderer, GLYPH_CACHE))
+  if (GSK_DEBUG_CHECK (GLYPH_CACHE))
     {
       g_print ("Glyph cache:\n");
       for (i = 0; i < cache->atlases->len; i++)
@@ -309,7 +313,7 @@ upload_dirty_glyphs (GskVulkanGlyphCache *cache,
   for (l = atlas->dirty_glyphs, i = 0; l; l = l->next, i++)
     render_glyph (atlas, (DirtyGlyph *)l->data, &regions[i]);
 
-  GSK_RENDERER_NOTE (cache->renderer, GLYPH_CACHE,
+  GSK_NOTE (GLYPH_CACHE,
             g_message ("uploading %d glyphs to cache", num_regions));
 
   gsk_vulkan_image_upload_regions (atlas->image, uploader, num_regions, regions);
@@ -319,14 +323,11 @@ upload_dirty_glyphs (GskVulkanGlyphCache *cache,
 }
 
 GskVulkanGlyphCache *
-gsk_vulkan_glyph_cache_new (GskRenderer      *renderer,
-                            GdkVulkanContext *vulkan)
+gsk_vulkan_glyph_cache_new (void)
 {
   GskVulkanGlyphCache *cache;
 
   cache = GSK_VULKAN_GLYPH_CACHE (g_object_new (GSK_TYPE_VULKAN_GLYPH_CACHE, NULL));
-  cache->renderer = renderer;
-  cache->vulkan = vulkan;
   g_ptr_array_add (cache->atlases, create_atlas (cache));
 
   return cache;
@@ -413,8 +414,11 @@ gsk_vulkan_glyph_cache_get_glyph_image (GskVulkanGlyphCache *cache,
 
   atlas = g_ptr_array_index (cache->atlases, index);
 
+  /* All Vulkan contexts of a display use the same device, so the
+   * atlas can be created with whichever renderer needs it first */
   if (atlas->image == NULL)
-    atlas->image = gsk_vulkan_image_new_for_atlas (cache->vulkan, atlas->width, atlas->height);
+    atlas->image = gsk_vulkan_image_new_for_atlas (gsk_vulkan_uploader_get_context (uploader),
+                                                   atlas->width, atlas->height);
 
   if (atlas->dirty_glyphs)
     upload_dirty_glyphs (cache, atlas, uploader);
@@ -433,7 +437,13 @@ gsk_vulkan_glyph_cache_begin_frame (GskVulkanGlyphCache *cache)
   GlyphCacheKey *key;
   GskVulkanCachedGlyph *value;
   guint dropped = 0;
+  gint64 now;
+
+  now = g_get_monotonic_time ();
+  if (now - cache->last_frame_time < FRAME_INTERVAL)
+    return;
 
+  cache->last_frame_time = now;
   cache->timestamp++;
 
   if (cache->timestamp % CHECK_INTERVAL != 0)
@@ -471,7 +481,7 @@ gsk_vulkan_glyph_cache_begin_frame (GskVulkanGlyphCache *cache)
 
       if (atlas->old_pixels > MAX_OLD * atlas->width * atlas->height)
         {
-          GSK_RENDERER_NOTE(cache->renderer, GLYPH_CACHE,
+          GSK_NOTE(GLYPH_CACHE,
                    g_message ("Dropping atlas %d (%g.2%% old)", i, 100.0 * (double)atlas->old_pixels / (double)(atlas->width * atlas->height)));
           g_ptr_array_remove_index (cache->atlases, i);
 
@@ -501,5 +511,5 @@ gsk_vulkan_glyph_cache_begin_frame (GskVulkanGlyphCache *cache)
         }
     }
 
-  GSK_RENDERER_NOTE(cache->renderer, GLYPH_CACHE, g_message ("Dropped %d glyphs", dropped));
+  GSK_NOTE(GLYPH_CACHE, g_message ("Dropped %d glyphs", dropped));
 }
@@ -6,8 +6,15 @@
 #include "gskvulkanmemoryprivate.h"
 #include "gskvulkanpipelineprivate.h"
 
+#include "gdk/gdkdmabuftextureprivate.h"
+#include "gdk/gdkmemorytextureprivate.h"
+#include "gdk/gdkvulkancontextprivate.h"
+
 #include <string.h>
 
+/* Initial size of the staging buffer that uploads are copied into */
+#define STAGING_BUFFER_SIZE (4 * 1024 * 1024)
+
 struct _GskVulkanUploader
 {
   GdkVulkanContext *vulkan;
@@ -20,6 +27,13 @@ struct _GskVulkanUploader
   GArray *after_buffer_barriers;
   GArray *after_image_barriers;
 
+  /* All uploads of a frame are copied into this one buffer,
+   * which is reused once the frame is done */
+  GskVulkanBuffer *staging_buffer;
+  guchar *staging_data;
+  gsize staging_size;
+  gsize staging_offset;
+
   GSList *staging_image_free_list;
   GSList *staging_buffer_free_list;
 };
@@ -68,6 +82,12 @@ gsk_vulkan_uploader_free (GskVulkanUploader *self)
 {
   gsk_vulkan_uploader_reset (self);
 
+  if (self->staging_buffer)
+    {
+      gsk_vulkan_buffer_unmap (self->staging_buffer);
+      gsk_vulkan_buffer_free (self->staging_buffer);
+    }
+
   g_array_unref (self->after_buffer_barriers);
   g_array_unref (self->before_buffer_barriers);
   g_array_unref (self->after_image_barriers);
@@ -78,6 +98,12 @@ gsk_vulkan_uploader_free (GskVulkanUploader *self)
   g_slice_free (GskVulkanUploader, self);
 }
 
+GdkVulkanContext *
+gsk_vulkan_uploader_get_context (GskVulkanUploader *self)
+{
+  return self->vulkan;
+}
+
 static void
 gsk_vulkan_uploader_add_image_barrier (GskVulkanUploader          *self,
                                        gboolean                    after,
@@ -139,6 +165,47 @@ gsk_vulkan_uploader_get_copy_buffer (GskVulkanUploader *self)
   return self->copy_buffer;
 }
 
+/* Returns memory to copy @size bytes of upload data into, at
+ * *out_offset in *out_buffer. It stays valid until the uploader
+ * is reset, i.e. until the GPU is done with the frame. */
+static guchar *
+gsk_vulkan_uploader_alloc_staging (GskVulkanUploader  *self,
+                                   gsize               size,
+                                   VkBuffer           *out_buffer,
+                                   gsize              *out_offset)
+{
+  /* Copies need the buffer offset to be a multiple of the texel size */
+  gsize offset = (self->staging_offset + 15) & ~(gsize) 15;
+
+  if (self->staging_buffer == NULL || offset + size > self->staging_size)
+    {
+      gsize new_size = MAX (self->staging_size * 2, STAGING_BUFFER_SIZE);
+
+      while (new_size < size)
+        new_size *= 2;
+
+      /* Copies from the old one may still be pending in this frame */
+      if (self->staging_buffer)
+        {
+          gsk_vulkan_buffer_unmap (self->staging_buffer);
+          self->staging_buffer_free_list = g_slist_prepend (self->staging_buffer_free_list,
+                                                            self->staging_buffer);
+        }
+
+      self->staging_buffer = gsk_vulkan_buffer_new_staging (self->vulkan, new_size);
+      self->staging_data = gsk_vulkan_buffer_map (self->staging_buffer);
+      self->staging_size = new_size;
+      offset = 0;
+    }
+
+  self->staging_offset = offset + size;
+
+  *out_buffer = gsk_vulkan_buffer_get_buffer (self->staging_buffer);
+  *out_offset = offset;
+
+  return self->staging_data + offset;
+}
+
 void
 gsk_vulkan_uploader_upload (GskVulkanUploader *self)
 {
@@ -194,12 +261,15 @@ gsk_vulkan_uploader_reset (GskVulkanUploader *self)
   self->staging_image_free_list = NULL;
   g_slist_free_full (self->staging_buffer_free_list, (GDestroyNotify) gsk_vulkan_buffer_free);
   self->staging_buffer_free_list = NULL;
+
+  self->staging_offset = 0;
 }
 
 static GskVulkanImage *
 gsk_vulkan_image_new (GdkVulkanContext      *context,
                       gsize                  width,
                       gsize                  height,
+                      VkFormat               format,
                       VkImageTiling          tiling,
                       VkImageUsageFlags      usage,
                       VkImageLayout          layout,
@@ -223,7 +293,7 @@ gsk_vulkan_image_new (GdkVulkanContext      *context,
                                     .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
                                     .flags = 0,
                                     .imageType = VK_IMAGE_TYPE_2D,
-                                    .format = VK_FORMAT_B8G8R8A8_UNORM,
+                                    .format = format,
                                     .extent = { width, height, 1 },
                                     .mipLevels = 1,
                                     .arrayLayers = 1,
@@ -243,12 +313,13 @@ gsk_vulkan_image_new (GdkVulkanContext      *context,
   self->memory = gsk_vulkan_memory_new (context,
                                         requirements.memoryTypeBits,
                                         memory,
-                                        requirements.size);
+                                        requirements.size,
+                                        requirements.alignment);
 
   GSK_VK_CHECK (vkBindImageMemory, gdk_vulkan_context_get_device (context),
                                    self->vk_image,
                                    gsk_vulkan_memory_get_device_memory (self->memory),
-                                   0);
+                                   gsk_vulkan_memory_get_offset (self->memory));
   return self;
 }
 
@@ -323,17 +394,19 @@ gsk_vulkan_image_new_from_data_via_staging_buffer (GskVulkanUploader *uploader,
                                                    guchar            *data,
                                                    gsize              width,
                                                    gsize              height,
-                                                   gsize              stride)
+                                                   gsize              stride,
+                                                   VkFormat           format,
+                                                   gsize              bpp)
 {
   GskVulkanImage *self;
-  GskVulkanBuffer *staging;
-  gsize buffer_size = width * height * 4;
+  VkBuffer staging;
+  gsize staging_offset;
+  gsize buffer_size = width * height * bpp;
   guchar *mem;
 
-  staging = gsk_vulkan_buffer_new_staging (uploader->vulkan, buffer_size);
-  mem = gsk_vulkan_buffer_map (staging);
+  mem = gsk_vulkan_uploader_alloc_staging (uploader, buffer_size, &staging, &staging_offset);
 
-  if (stride == width * 4)
+  if (stride == width * bpp)
     {
       memcpy (mem, data, stride * height);
     }
@@ -341,12 +414,10 @@ gsk_vulkan_image_new_from_data_via_staging_buffer (GskVulkanUploader *uploader,
     {
       for (gsize i = 0; i < height; i++)
         {
-          memcpy (mem + i * width * 4, data + i * stride, width * 4);
+          memcpy (mem + i * width * bpp, data + i * stride, width * bpp);
         }
     }
 
-  gsk_vulkan_buffer_unmap (staging);
-
   gsk_vulkan_uploader_add_buffer_barrier (uploader,
                                           FALSE,
                                           &(VkBufferMemoryBarrier) {
@@ -355,14 +426,15 @@ gsk_vulkan_image_new_from_data_via_staging_buffer (GskVulkanUploader *uploader,
                                              .dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT,
                                              .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
                                              .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-                                             .buffer = gsk_vulkan_buffer_get_buffer(staging),
-                                             .offset = 0,
+                                             .buffer = staging,
+                                             .offset = staging_offset,
                                              .size = buffer_size,
                                          });
 
   self = gsk_vulkan_image_new (uploader->vulkan,
                                width,
                                height,
+                               format,
                                VK_IMAGE_TILING_OPTIMAL,
                                VK_IMAGE_USAGE_TRANSFER_DST_BIT |
                                VK_IMAGE_USAGE_SAMPLED_BIT,
@@ -377,13 +449,13 @@ gsk_vulkan_image_new_from_data_via_staging_buffer (GskVulkanUploader *uploader,
                                          VK_ACCESS_TRANSFER_WRITE_BIT);
 
   vkCmdCopyBufferToImage (gsk_vulkan_uploader_get_copy_buffer (uploader),
-                          gsk_vulkan_buffer_get_buffer (staging),
+                          staging,
                           self->vk_image,
                           VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
                           1,
                           (VkBufferImageCopy[1]) {
                                {
-                                   .bufferOffset = 0,
+                                   .bufferOffset = staging_offset,
                                    .imageSubresource = {
                                        .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
                                        .mipLevel = 0,
@@ -405,9 +477,7 @@ gsk_vulkan_image_new_from_data_via_staging_buffer (GskVulkanUploader *uploader,
                                          VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
                                          VK_ACCESS_SHADER_READ_BIT);
 
-  uploader->staging_buffer_free_list = g_slist_prepend (uploader->staging_buffer_free_list, staging);
-
-  gsk_vulkan_image_ensure_view (self, VK_FORMAT_B8G8R8A8_UNORM);
+  gsk_vulkan_image_ensure_view (self, format);
 
   return self;
 }
@@ -424,6 +494,7 @@ gsk_vulkan_image_new_from_data_via_staging_image (GskVulkanUploader *uploader,
   staging = gsk_vulkan_image_new (uploader->vulkan,
                                   width,
                                   height,
+                                  VK_FORMAT_B8G8R8A8_UNORM,
                                   VK_IMAGE_TILING_LINEAR,
                                   VK_IMAGE_USAGE_TRANSFER_DST_BIT |
                                   VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
@@ -436,6 +507,7 @@ gsk_vulkan_image_new_from_data_via_staging_image (GskVulkanUploader *uploader,
   self = gsk_vulkan_image_new (uploader->vulkan,
                                width,
                                height,
+                               VK_FORMAT_B8G8R8A8_UNORM,
                                VK_IMAGE_TILING_OPTIMAL,
                                VK_IMAGE_USAGE_TRANSFER_DST_BIT |
                                VK_IMAGE_USAGE_SAMPLED_BIT,
@@ -508,6 +580,7 @@ gsk_vulkan_image_new_from_data_directly (GskVulkanUploader *uploader,
   self = gsk_vulkan_image_new (uploader->vulkan,
                                width,
                                height,
+                               VK_FORMAT_B8G8R8A8_UNORM,
                                VK_IMAGE_TILING_LINEAR,
                                VK_IMAGE_USAGE_SAMPLED_BIT,
                                VK_IMAGE_LAYOUT_PREINITIALIZED,
@@ -535,13 +608,195 @@ gsk_vulkan_image_new_from_data (GskVulkanUploader *uploader,
                                 gsize              stride)
 {
   if (GSK_DEBUG_CHECK (VULKAN_STAGING_BUFFER))
-    return gsk_vulkan_image_new_from_data_via_staging_buffer (uploader, data, width, height, stride);
+    return gsk_vulkan_image_new_from_data_via_staging_buffer (uploader, data, width, height, stride,
+                                                              VK_FORMAT_B8G8R8A8_UNORM, 4);
   else if (GSK_DEBUG_CHECK (VULKAN_STAGING_IMAGE))
     return gsk_vulkan_image_new_from_data_via_staging_image (uploader, data, width, height, stride);
   else
     return gsk_vulkan_image_new_from_data_directly (uploader, data, width, height, stride);
 }
 
+static VkFormat
+get_vk_format (GdkMemoryFormat format)
+{
+  switch ((int) format)
+    {
+    case GDK_MEMORY_R16G16B16A16_PREMULTIPLIED:
+      return VK_FORMAT_R16G16B16A16_UNORM;
+    case GDK_MEMORY_R16G16B16A16_FLOAT_PREMULTIPLIED:
+      return VK_FORMAT_R16G16B16A16_SFLOAT;
+    case GDK_MEMORY_R32G32B32A32_FLOAT_PREMULTIPLIED:
+      return VK_FORMAT_R32G32B32A32_SFLOAT;
+    default:
+      return VK_FORMAT_UNDEFINED;
+    }
+}
+
+/* Uploads data in a format with more than 8 bits per channel into an
+ * image of the matching VkFormat. Returns %NULL if there is no such
+ * format, or the device can't sample from it, in which case the data
+ * has to be converted to 8 bits per channel. */
+GskVulkanImage *
+gsk_vulkan_image_new_from_data_with_format (GskVulkanUploader *uploader,
+                                            GdkMemoryFormat    format,
+                                            guchar            *data,
+                                            gsize              width,
+                                            gsize              height,
+                                            gsize              stride)
+{
+  VkFormatProperties properties;
+  VkFormat vk_format;
+  VkFormatFeatureFlags required = VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT |
+                                  VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+
+  vk_format = get_vk_format (format);
+  if (vk_format == VK_FORMAT_UNDEFINED)
+    return NULL;
+
+  vkGetPhysicalDeviceFormatProperties (gdk_vulkan_context_get_physical_device (uploader->vulkan),
+                                       vk_format,
+                                       &properties);
+  if ((properties.optimalTilingFeatures & required) != required)
+    return NULL;
+
+  /* Linear images of these formats are not guaranteed to be
+   * sampleable, so always copy them into an optimal one */
+  return gsk_vulkan_image_new_from_data_via_staging_buffer (uploader, data, width, height, stride,
+                                                            vk_format,
+                                                            gdk_memory_format_bytes_per_pixel (format));
+}
+
+/* Imports the dma-buf without copying it. Returns %NULL if the device
+ * can't import it, only single-plane RGB buffers are supported. */
+GskVulkanImage *
+gsk_vulkan_image_new_from_dmabuf (GskVulkanUploader *uploader,
+                                  GdkDmabufTexture  *texture)
+{
+  GdkVulkanContext *context = uploader->vulkan;
+  VkDevice device = gdk_vulkan_context_get_device (context);
+  VkMemoryRequirements requirements;
+  GskVulkanImage *self;
+  VkImage vk_image;
+  VkFormat format;
+  gboolean opaque;
+  gsize width, height;
+
+  if (!gdk_vulkan_context_has_dmabuf_import (context) ||
+      gdk_dmabuf_texture_get_n_planes (texture) != 1 ||
+      gdk_dmabuf_texture_get_modifier (texture) == GDK_DRM_FORMAT_MOD_INVALID)
+    return NULL;
+
+  switch (gdk_dmabuf_texture_get_fourcc (texture))
+    {
+    case GDK_DRM_FORMAT_ARGB8888:
+    case GDK_DRM_FORMAT_XRGB8888:
+      format = VK_FORMAT_B8G8R8A8_UNORM;
+      break;
+    case GDK_DRM_FORMAT_ABGR8888:
+    case GDK_DRM_FORMAT_XBGR8888:
+      format = VK_FORMAT_R8G8B8A8_UNORM;
+      break;
+    default:
+      return NULL;
+    }
+  opaque = gdk_dmabuf_texture_get_fourcc (texture) == GDK_DRM_FORMAT_XRGB8888 ||
+           gdk_dmabuf_texture_get_fourcc (texture) == GDK_DRM_FORMAT_XBGR8888;
+
+  width = gdk_texture_get_width (GDK_TEXTURE (texture));
+  height = gdk_texture_get_height (GDK_TEXTURE (texture));
+
+  if (vkCreateImage (device,
+                     &(VkImageCreateInfo) {
+                         .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+                         .pNext = &(VkExternalMemoryImageCreateInfo) {
+                             .sType = VK_STRUCTURE_TYPE_EXTERNAL_MEMORY_IMAGE_CREATE_INFO,
+                             .pNext = &(VkImageDrmFormatModifierExplicitCreateInfoEXT) {
+                                 .sType = VK_STRUCTURE_TYPE_IMAGE_DRM_FORMAT_MODIFIER_EXPLICIT_CREATE_INFO_EXT,
+                                 .drmFormatModifier = gdk_dmabuf_texture_get_modifier (texture),
+                                 .drmFormatModifierPlaneCount = 1,
+                                 .pPlaneLayouts = &(VkSubresourceLayout) {
+                                     .offset = gdk_dmabuf_texture_get_offset (texture, 0),
+                                     .rowPitch = gdk_dmabuf_texture_get_stride (texture, 0),
+                                 },
+                             },
+                             .handleTypes = VK_EXTERNAL_MEMORY_HANDLE_TYPE_DMA_BUF_BIT_EXT,
+                         },
+                         .flags = 0,
+                         .imageType = VK_IMAGE_TYPE_2D,
+                         .format = format,
+                         .extent = { width, height, 1 },
+                         .mipLevels = 1,
+                         .arrayLayers = 1,
+                         .samples = VK_SAMPLE_COUNT_1_BIT,
+                         .tiling = VK_IMAGE_TILING_DRM_FORMAT_MODIFIER_EXT,
+                         .usage = VK_IMAGE_USAGE_SAMPLED_BIT,
+                         .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+                         .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+                     },
+                     NULL,
+                     &vk_image) != VK_SUCCESS)
+    return NULL;
+
+  self = g_object_new (GSK_TYPE_VULKAN_IMAGE, NULL);
+
+  self->vulkan = g_object_ref (context);
+  self->width = width;
+  self->height = height;
+  self->vk_usage = VK_IMAGE_USAGE_SAMPLED_BIT;
+  self->vk_image = vk_image;
+  /* The contents were written outside of Vulkan, so don't let the
+   * layout transition below discard them */
+  self->vk_image_layout = VK_IMAGE_LAYOUT_GENERAL;
+  self->vk_access = 0;
+
+  vkGetImageMemoryRequirements (device, vk_image, &requirements);
+
+  self->memory = gsk_vulkan_memory_new_from_dmabuf (context,
+                                                    vk_image,
+                                                    requirements.memoryTypeBits,
+                                                    gdk_dmabuf_texture_get_fd (texture, 0),
+                                                    requirements.size);
+  if (self->memory == NULL ||
+      vkBindImageMemory (device, vk_image, gsk_vulkan_memory_get_device_memory (self->memory), 0) != VK_SUCCESS)
+    {
+      if (self->memory == NULL)
+        vkDestroyImage (device, vk_image, NULL);
+      g_object_unref (self);
+      return NULL;
+    }
+
+  gsk_vulkan_uploader_add_image_barrier (uploader,
+                                         FALSE,
+                                         self,
+                                         VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                                         VK_ACCESS_SHADER_READ_BIT);
+
+  GSK_VK_CHECK (vkCreateImageView, device,
+                                   &(VkImageViewCreateInfo) {
+                                       .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+                                       .image = self->vk_image,
+                                       .viewType = VK_IMAGE_VIEW_TYPE_2D,
+                                       .format = format,
+                                       .components = {
+                                           .r = VK_COMPONENT_SWIZZLE_R,
+                                           .g = VK_COMPONENT_SWIZZLE_G,
+                                           .b = VK_COMPONENT_SWIZZLE_B,
+                                           .a = opaque ? VK_COMPONENT_SWIZZLE_ONE : VK_COMPONENT_SWIZZLE_A,
+                                       },
+                                       .subresourceRange = {
+                                           .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                                           .baseMipLevel = 0,
+                                           .levelCount = 1,
+                                           .baseArrayLayer = 0,
+                                           .layerCount = 1,
+                                       },
+                                   },
+                                   NULL,
+                                   &self->vk_image_view);
+
+  return self;
+}
+
 GskVulkanImage *
 gsk_vulkan_image_new_for_swapchain (GdkVulkanContext *context,
                                     VkImage           image,
@@ -574,6 +829,7 @@ gsk_vulkan_image_new_for_framebuffer (GdkVulkanContext *context,
   self = gsk_vulkan_image_new (context,
                                width,
                                height,
+                               VK_FORMAT_B8G8R8A8_UNORM,
                                VK_IMAGE_TILING_OPTIMAL,
                                VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT,
                                VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
@@ -595,6 +851,7 @@ gsk_vulkan_image_new_for_atlas (GdkVulkanContext *context,
   self = gsk_vulkan_image_new (context,
                                width,
                                height,
+                               VK_FORMAT_B8G8R8A8_UNORM,
                                VK_IMAGE_TILING_OPTIMAL,
                                VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
                                VK_IMAGE_LAYOUT_UNDEFINED,
@@ -616,6 +873,7 @@ gsk_vulkan_image_new_for_texture (GdkVulkanContext *context,
   self = gsk_vulkan_image_new (context,
                                width,
                                height,
+                               VK_FORMAT_B8G8R8A8_UNORM,
                                VK_IMAGE_TILING_OPTIMAL,
                                VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT |
                                VK_IMAGE_USAGE_SAMPLED_BIT |
@@ -691,7 +949,8 @@ gsk_vulkan_image_upload_regions (GskVulkanImage    *self,
                                  guint              num_regions,
                                  GskImageRegion    *regions)
 {
-  GskVulkanBuffer *staging;
+  VkBuffer staging;
+  gsize staging_offset;
   guchar *mem;
   guchar *m;
   gsize size;
@@ -702,8 +961,7 @@ gsk_vulkan_image_upload_regions (GskVulkanImage    *self,
   for (int i = 0; i < num_regions; i++)
     size += regions[i].width * regions[i].height * 4;
 
-  staging = gsk_vulkan_buffer_new_staging (uploader->vulkan, size);
-  mem = gsk_vulkan_buffer_map (staging);
+  mem = gsk_vulkan_uploader_alloc_staging (uploader, size, &staging, &staging_offset);
 
   bufferImageCopy = alloca (sizeof (VkBufferImageCopy) * num_regions);
   memset (bufferImageCopy, 0, sizeof (VkBufferImageCopy) * num_regions);
@@ -718,11 +976,11 @@ gsk_vulkan_image_upload_regions (GskVulkanImage    *self,
         }
       else
         {
-          for (gsize r = 0; r < regions[i].height; i++)
+          for (gsize r = 0; r < regions[i].height; r++)
             memcpy (m + r * regions[i].width * 4, regions[i].data + r * regions[i].stride, regions[i].width * 4);
         }
 
-      bufferImageCopy[i].bufferOffset = offset;
+      bufferImageCopy[i].bufferOffset = staging_offset + offset;
       bufferImageCopy[i].imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
       bufferImageCopy[i].imageSubresource.mipLevel = 0;
       bufferImageCopy[i].imageSubresource.baseArrayLayer = 0;
@@ -737,8 +995,6 @@ gsk_vulkan_image_upload_regions (GskVulkanImage    *self,
       offset += regions[i].width * regions[i].height * 4;
     }
 
-  gsk_vulkan_buffer_unmap (staging);
-
   gsk_vulkan_uploader_add_image_barrier (uploader,
                                          FALSE,
                                          self,
@@ -746,7 +1002,7 @@ gsk_vulkan_image_upload_regions (GskVulkanImage    *self,
                                          VK_ACCESS_TRANSFER_WRITE_BIT);
 
   vkCmdCopyBufferToImage (gsk_vulkan_uploader_get_copy_buffer (uploader),
-                          gsk_vulkan_buffer_get_buffer (staging),
+                          staging,
                           self->vk_image,
                           VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
                           num_regions,
@@ -758,8 +1014,6 @@ gsk_vulkan_image_upload_regions (GskVulkanImage    *self,
                                          VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
                                          VK_ACCESS_SHADER_READ_BIT);
 
-  uploader->staging_buffer_free_list = g_slist_prepend (uploader->staging_buffer_free_list, staging);
-
   gsk_vulkan_image_ensure_view (self, VK_FORMAT_B8G8R8A8_UNORM);
 }
 
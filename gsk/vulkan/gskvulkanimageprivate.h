@@ -16,6 +16,7 @@ G_DECLARE_FINAL_TYPE (GskVulkanImage, gsk_vulkan_image, GSK, VULKAN_IMAGE, GObje
 GskVulkanUploader *     gsk_vulkan_uploader_new                         (GdkVulkanContext       *context,
                                                                          GskVulkanCommandPool   *command_pool);
 void                    gsk_vulkan_uploader_free                        (GskVulkanUploader      *self);
+GdkVulkanContext *      gsk_vulkan_uploader_get_context                 (GskVulkanUploader      *self);
 
 void                    gsk_vulkan_uploader_reset                       (GskVulkanUploader      *self);
 void                    gsk_vulkan_uploader_upload                      (GskVulkanUploader      *self);
@@ -30,6 +31,14 @@ GskVulkanImage *        gsk_vulkan_image_new_from_data                  (GskVulk
                                                                          gsize                   width,
                                                                          gsize                   height,
                                                                          gsize                   stride);
+GskVulkanImage *        gsk_vulkan_image_new_from_data_with_format      (GskVulkanUploader      *uploader,
+                                                                         GdkMemoryFormat         format,
+                                                                         guchar                 *data,
+                                                                         gsize                   width,
+                                                                         gsize                   height,
+                                                                         gsize                   stride);
+GskVulkanImage *        gsk_vulkan_image_new_from_dmabuf                (GskVulkanUploader      *uploader,
+                                                                         GdkDmabufTexture       *texture);
 
 typedef struct {
   guchar *data;
@@ -3,6 +3,46 @@
 #include "gskvulkanpipelineprivate.h"
 #include "gskvulkanmemoryprivate.h"
 
+#include <fcntl.h>
+#include <unistd.h>
+
+/* Memory is handed out from large blocks shared by all buffers and images
+ * of a device, so that we don't hit maxMemoryAllocationCount and don't pay
+ * for a vkAllocateMemory() every time a glyph atlas or vertex buffer is
+ * created. Allocations bigger than a fraction of a block get their own
+ * VkDeviceMemory like before. */
+#define BLOCK_SIZE (16 * 1024 * 1024)
+#define MAX_SUBALLOCATION_SIZE (BLOCK_SIZE / 4)
+
+typedef struct _GskVulkanAllocator GskVulkanAllocator;
+
+typedef struct
+{
+  VkDeviceSize offset;
+  VkDeviceSize size;
+} Range;
+
+typedef struct
+{
+  VkDeviceMemory vk_memory;
+  uint32_t memory_type;
+  VkDeviceSize used;
+  guchar *map;
+  GArray *free_ranges; /* Range, sorted by offset */
+} Block;
+
+struct _GskVulkanAllocator
+{
+  int ref_count;
+
+  GdkVulkanContext *vulkan;
+
+  VkPhysicalDeviceMemoryProperties properties;
+  VkDeviceSize granularity;
+
+  GPtrArray *blocks;
+};
+
 struct _GskVulkanMemory
 {
   GdkVulkanContext *vulkan;
@@ -10,45 +50,385 @@ struct _GskVulkanMemory
   gsize size;
 
   VkDeviceMemory vk_memory;
+
+  /* Only set for memory inside a shared block */
+  GskVulkanAllocator *allocator;
+  Block *block;
+  VkDeviceSize offset;
 };
 
-GskVulkanMemory *
-gsk_vulkan_memory_new (GdkVulkanContext      *context,
-                       uint32_t               allowed_types,
-                       VkMemoryPropertyFlags  flags,
-                       gsize                  size)
+static void
+block_free (GskVulkanAllocator *allocator,
+            Block              *block)
 {
-  VkPhysicalDeviceMemoryProperties properties;
-  GskVulkanMemory *self;
-  uint32_t i;
+  VkDevice device = gdk_vulkan_context_get_device (allocator->vulkan);
 
-  self = g_slice_new0 (GskVulkanMemory);
+  if (block->map)
+    vkUnmapMemory (device, block->vk_memory);
+  vkFreeMemory (device, block->vk_memory, NULL);
+  g_array_unref (block->free_ranges);
+  g_free (block);
+}
+
+static GskVulkanAllocator *
+gsk_vulkan_allocator_get (GdkVulkanContext *context)
+{
+  GskVulkanAllocator *self;
+  VkPhysicalDeviceProperties props;
+
+  /* The context doesn't own the allocator, the allocations do:
+   * it goes away with the last one of them. */
+  self = g_object_get_data (G_OBJECT (context), "gsk-vulkan-allocator");
+  if (self)
+    {
+      self->ref_count++;
+      return self;
+    }
 
+  self = g_new0 (GskVulkanAllocator, 1);
+  self->ref_count = 1;
   self->vulkan = g_object_ref (context);
-  self->size = size;
+  self->blocks = g_ptr_array_new ();
 
   vkGetPhysicalDeviceMemoryProperties (gdk_vulkan_context_get_physical_device (context),
-                                       &properties);
+                                       &self->properties);
+  vkGetPhysicalDeviceProperties (gdk_vulkan_context_get_physical_device (context), &props);
+  self->granularity = props.limits.bufferImageGranularity;
+
+  g_object_set_data (G_OBJECT (context), "gsk-vulkan-allocator", self);
+
+  return self;
+}
+
+static void
+gsk_vulkan_allocator_unref (GskVulkanAllocator *self)
+{
+  guint i;
+
+  self->ref_count--;
+  if (self->ref_count > 0)
+    return;
+
+  for (i = 0; i < self->blocks->len; i++)
+    block_free (self, g_ptr_array_index (self->blocks, i));
+  g_ptr_array_unref (self->blocks);
+
+  g_object_set_data (G_OBJECT (self->vulkan), "gsk-vulkan-allocator", NULL);
+  g_object_unref (self->vulkan);
+  g_free (self);
+}
+
+static uint32_t
+find_memory_type (const VkPhysicalDeviceMemoryProperties *properties,
+                  uint32_t                                allowed_types,
+                  VkMemoryPropertyFlags                   flags)
+{
+  uint32_t i;
 
-  for (i = 0; i < properties.memoryTypeCount; i++)
+  for (i = 0; i < properties->memoryTypeCount; i++)
     {
       if (!(allowed_types & (1 << i)))
         continue;
 
-      if ((properties.memoryTypes[i].propertyFlags & flags) == flags)
+      if ((properties->memoryTypes[i].propertyFlags & flags) == flags)
         break;
-  }
+    }
 
-  g_assert (i < properties.memoryTypeCount);
+  g_assert (i < properties->memoryTypeCount);
+
+  return i;
+}
+
+static VkDeviceMemory
+allocate_device_memory (GdkVulkanContext *context,
+                        uint32_t          memory_type,
+                        VkDeviceSize      size)
+{
+  VkDeviceMemory vk_memory;
 
   GSK_VK_CHECK (vkAllocateMemory, gdk_vulkan_context_get_device (context),
                                   &(VkMemoryAllocateInfo) {
                                       .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
                                       .allocationSize = size,
-                                      .memoryTypeIndex = i
+                                      .memoryTypeIndex = memory_type
                                   },
                                   NULL,
-                                  &self->vk_memory);
+                                  &vk_memory);
+
+  return vk_memory;
+}
+
+static Block *
+block_new (GskVulkanAllocator *allocator,
+           uint32_t            memory_type)
+{
+  Block *block;
+  Range range = { 0, BLOCK_SIZE };
+
+  block = g_new0 (Block, 1);
+  block->memory_type = memory_type;
+  block->vk_memory = allocate_device_memory (allocator->vulkan, memory_type, BLOCK_SIZE);
+  block->free_ranges = g_array_new (FALSE, FALSE, sizeof (Range));
+  g_array_append_val (block->free_ranges, range);
+
+  /* Host visible blocks stay mapped, a memory object can only be mapped once */
+  if (allocator->properties.memoryTypes[memory_type].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+    GSK_VK_CHECK (vkMapMemory, gdk_vulkan_context_get_device (allocator->vulkan),
+                               block->vk_memory,
+                               0,
+                               BLOCK_SIZE,
+                               0,
+                               (void **) &block->map);
+
+  g_ptr_array_add (allocator->blocks, block);
+
+  return block;
+}
+
+static gboolean
+block_alloc (Block        *block,
+             VkDeviceSize  size,
+             VkDeviceSize  alignment,
+             VkDeviceSize *out_offset)
+{
+  guint i;
+
+  for (i = 0; i < block->free_ranges->len; i++)
+    {
+      Range *range = &g_array_index (block->free_ranges, Range, i);
+      VkDeviceSize start = (range->offset + alignment - 1) / alignment * alignment;
+      VkDeviceSize end = range->offset + range->size;
+
+      if (start + size > end)
+        continue;
+
+      /* Keep what's left before and after the allocation */
+      if (start + size < end)
+        {
+          Range after = { start + size, end - (start + size) };
+          g_array_insert_val (block->free_ranges, i + 1, after);
+          range = &g_array_index (block->free_ranges, Range, i);
+        }
+
+      if (start > range->offset)
+        range->size = start - range->offset;
+      else
+        g_array_remove_index (block->free_ranges, i);
+
+      block->used += size;
+      *out_offset = start;
+
+      return TRUE;
+    }
+
+  return FALSE;
+}
+
+static void
+block_release (Block        *block,
+               VkDeviceSize  offset,
+               VkDeviceSize  size)
+{
+  Range *prev = NULL, *next = NULL;
+  guint i;
+
+  block->used -= size;
+
+  for (i = 0; i < block->free_ranges->len; i++)
+    {
+      if (g_array_index (block->free_ranges, Range, i).offset > offset)
+        break;
+    }
+
+  if (i > 0)
+    prev = &g_array_index (block->free_ranges, Range, i - 1);
+  if (i < block->free_ranges->len)
+    next = &g_array_index (block->free_ranges, Range, i);
+
+  if (prev && prev->offset + prev->size == offset)
+    {
+      prev->size += size;
+      if (next && prev->offset + prev->size == next->offset)
+        {
+          prev->size += next->size;
+          g_array_remove_index (block->free_ranges, i);
+        }
+    }
+  else if (next && offset + size == next->offset)
+    {
+      next->offset = offset;
+      next->size += size;
+    }
+  else
+    {
+      Range range = { offset, size };
+      g_array_insert_val (block->free_ranges, i, range);
+    }
+}
+
+static gboolean
+gsk_vulkan_allocator_alloc (GskVulkanAllocator *self,
+                            uint32_t            memory_type,
+                            VkDeviceSize        size,
+                            VkDeviceSize        alignment,
+                            Block             **out_block,
+                            VkDeviceSize       *out_offset)
+{
+  Block *block;
+  guint i;
+
+  /* Buffers and images can share a block, keep them apart far enough */
+  alignment = MAX (MAX (alignment, self->granularity), 1);
+
+  for (i = 0; i < self->blocks->len; i++)
+    {
+      block = g_ptr_array_index (self->blocks, i);
+
+      if (block->memory_type == memory_type &&
+          block_alloc (block, size, alignment, out_offset))
+        {
+          *out_block = block;
+          return TRUE;
+        }
+    }
+
+  block = block_new (self, memory_type);
+  if (!block_alloc (block, size, alignment, out_offset))
+    return FALSE;
+
+  *out_block = block;
+  return TRUE;
+}
+
+static void
+gsk_vulkan_allocator_release (GskVulkanAllocator *self,
+                              Block              *block,
+                              VkDeviceSize        offset,
+                              VkDeviceSize        size)
+{
+  guint i;
+
+  block_release (block, offset, size);
+
+  if (block->used > 0)
+    return;
+
+  /* Keep one empty block around per memory type, so that buffers
+   * replaced every frame don't cause a block to be allocated each time */
+  for (i = 0; i < self->blocks->len; i++)
+    {
+      Block *other = g_ptr_array_index (self->blocks, i);
+
+      if (other != block && other->memory_type == block->memory_type && other->used == 0)
+        {
+          g_ptr_array_remove (self->blocks, block);
+          block_free (self, block);
+          return;
+        }
+    }
+}
+
+GskVulkanMemory *
+gsk_vulkan_memory_new (GdkVulkanContext      *context,
+                       uint32_t               allowed_types,
+                       VkMemoryPropertyFlags  flags,
+                       gsize                  size,
+                       gsize                  alignment)
+{
+  GskVulkanAllocator *allocator;
+  GskVulkanMemory *self;
+  uint32_t memory_type;
+
+  self = g_slice_new0 (GskVulkanMemory);
+
+  self->vulkan = g_object_ref (context);
+  self->size = size;
+
+  allocator = gsk_vulkan_allocator_get (context);
+  memory_type = find_memory_type (&allocator->properties, allowed_types, flags);
+
+  if (size <= MAX_SUBALLOCATION_SIZE &&
+      gsk_vulkan_allocator_alloc (allocator, memory_type, size, alignment,
+                                  &self->block, &self->offset))
+    {
+      self->allocator = allocator;
+      self->vk_memory = self->block->vk_memory;
+    }
+  else
+    {
+      self->vk_memory = allocate_device_memory (context, memory_type, size);
+      gsk_vulkan_allocator_unref (allocator);
+    }
+
+  return self;
+}
+
+/* Imports a dma-buf as the dedicated memory of @image. Returns %NULL
+ * if the device can't do that. The fd stays owned by the caller. */
+GskVulkanMemory *
+gsk_vulkan_memory_new_from_dmabuf (GdkVulkanContext *context,
+                                   VkImage           image,
+                                   uint32_t          allowed_types,
+                                   int               fd,
+                                   gsize             size)
+{
+  VkDevice device = gdk_vulkan_context_get_device (context);
+  PFN_vkGetMemoryFdPropertiesKHR get_memory_fd_properties;
+  VkMemoryFdPropertiesKHR fd_properties = {
+    .sType = VK_STRUCTURE_TYPE_MEMORY_FD_PROPERTIES_KHR,
+  };
+  GskVulkanMemory *self;
+  VkDeviceMemory vk_memory;
+  uint32_t memory_type;
+  int import_fd;
+
+  get_memory_fd_properties = (PFN_vkGetMemoryFdPropertiesKHR) vkGetDeviceProcAddr (device, "vkGetMemoryFdPropertiesKHR");
+  if (get_memory_fd_properties == NULL ||
+      get_memory_fd_properties (device,
+                                VK_EXTERNAL_MEMORY_HANDLE_TYPE_DMA_BUF_BIT_EXT,
+                                fd,
+                                &fd_properties) != VK_SUCCESS)
+    return NULL;
+
+  allowed_types &= fd_properties.memoryTypeBits;
+  if (allowed_types == 0)
+    return NULL;
+
+  for (memory_type = 0; !(allowed_types & (1 << memory_type)); memory_type++)
+    ;
+
+  /* A successful import takes over the fd */
+  import_fd = fcntl (fd, F_DUPFD_CLOEXEC, 0);
+  if (import_fd == -1)
+    return NULL;
+
+  if (GSK_VK_CHECK (vkAllocateMemory, device,
+                                      &(VkMemoryAllocateInfo) {
+                                          .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+                                          .pNext = &(VkImportMemoryFdInfoKHR) {
+                                              .sType = VK_STRUCTURE_TYPE_IMPORT_MEMORY_FD_INFO_KHR,
+                                              .pNext = &(VkMemoryDedicatedAllocateInfoKHR) {
+                                                  .sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_ALLOCATE_INFO_KHR,
+                                                  .image = image,
+                                              },
+                                              .handleType = VK_EXTERNAL_MEMORY_HANDLE_TYPE_DMA_BUF_BIT_EXT,
+                                              .fd = import_fd,
+                                          },
+                                          .allocationSize = size,
+                                          .memoryTypeIndex = memory_type
+                                      },
+                                      NULL,
+                                      &vk_memory) != VK_SUCCESS)
+    {
+      close (import_fd);
+      return NULL;
+    }
+
+  self = g_slice_new0 (GskVulkanMemory);
+
+  self->vulkan = g_object_ref (context);
+  self->size = size;
+  self->vk_memory = vk_memory;
 
   return self;
 }
@@ -56,9 +436,17 @@ gsk_vulkan_memory_new (GdkVulkanContext      *context,
 void
 gsk_vulkan_memory_free (GskVulkanMemory *self)
 {
-  vkFreeMemory (gdk_vulkan_context_get_device (self->vulkan),
-                self->vk_memory,
-                NULL);
+  if (self->allocator)
+    {
+      gsk_vulkan_allocator_release (self->allocator, self->block, self->offset, self->size);
+      gsk_vulkan_allocator_unref (self->allocator);
+    }
+  else
+    {
+      vkFreeMemory (gdk_vulkan_context_get_device (self->vulkan),
+                    self->vk_memory,
+                    NULL);
+    }
 
   g_object_unref (self->vulkan);
 
@@ -71,11 +459,23 @@ gsk_vulkan_memory_get_device_memory (GskVulkanMemory *self)
   return self->vk_memory;
 }
 
+gsize
+gsk_vulkan_memory_get_offset (GskVulkanMemory *self)
+{
+  return self->offset;
+}
+
 guchar *
 gsk_vulkan_memory_map (GskVulkanMemory *self)
 {
   void *data;
 
+  if (self->allocator)
+    {
+      g_assert (self->block->map != NULL);
+      return self->block->map + self->offset;
+    }
+
   GSK_VK_CHECK (vkMapMemory, gdk_vulkan_context_get_device (self->vulkan),
                              self->vk_memory,
                              0,
@@ -89,6 +489,10 @@ gsk_vulkan_memory_map (GskVulkanMemory *self)
 void
 gsk_vulkan_memory_unmap (GskVulkanMemory *self)
 {
+  /* Shared blocks stay mapped */
+  if (self->allocator)
+    return;
+
   vkUnmapMemory (gdk_vulkan_context_get_device (self->vulkan),
                  self->vk_memory);
 }
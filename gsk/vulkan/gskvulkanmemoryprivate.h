@@ -10,10 +10,17 @@ typedef struct _GskVulkanMemory GskVulkanMemory;
 GskVulkanMemory *       gsk_vulkan_memory_new                           (GdkVulkanContext       *context,
                                                                          uint32_t                allowed_types,
                                                                          VkMemoryPropertyFlags   properties,
+                                                                         gsize                   size,
+                                                                         gsize                   alignment);
+GskVulkanMemory *       gsk_vulkan_memory_new_from_dmabuf               (GdkVulkanContext       *context,
+                                                                         VkImage                 image,
+                                                                         uint32_t                allowed_types,
+                                                                         int                     fd,
                                                                          gsize                   size);
 void                    gsk_vulkan_memory_free                          (GskVulkanMemory        *memory);
 
 VkDeviceMemory          gsk_vulkan_memory_get_device_memory             (GskVulkanMemory        *self);
+gsize                   gsk_vulkan_memory_get_offset                    (GskVulkanMemory        *self);
 
 guchar *                gsk_vulkan_memory_map                           (GskVulkanMemory        *self);
 void                    gsk_vulkan_memory_unmap                         (GskVulkanMemory        *self);
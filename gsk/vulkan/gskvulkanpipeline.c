@@ -6,6 +6,8 @@
 #include "gskvulkanshaderprivate.h"
 
 #include <graphene.h>
+#include <gio/gio.h>
+#include <string.h>
 
 typedef struct _GskVulkanPipelinePrivate GskVulkanPipelinePrivate;
 
@@ -53,6 +55,149 @@ gsk_vulkan_pipeline_init (GskVulkanPipeline *self)
 {
 }
 
+typedef struct
+{
+  VkPipelineCache cache;
+} PipelineCache;
+
+/* Pipeline caches are only valid for the device and driver that produced
+ * them, so both go into the file name. The driver checks the header again
+ * when the cache is loaded. */
+static GFile *
+get_pipeline_cache_file (GdkVulkanContext *context)
+{
+  VkPhysicalDeviceProperties props;
+  GString *filename;
+  char *path;
+  GFile *file;
+  guint i;
+
+  vkGetPhysicalDeviceProperties (gdk_vulkan_context_get_physical_device (context), &props);
+
+  filename = g_string_new (NULL);
+  for (i = 0; i < VK_UUID_SIZE; i++)
+    g_string_append_printf (filename, "%02x", props.pipelineCacheUUID[i]);
+  g_string_append_printf (filename, "-%04x-%04x-%08x.bin",
+                          props.vendorID, props.deviceID, props.driverVersion);
+
+  path = g_build_filename (g_get_user_cache_dir (), "gtk-4.0", "gsk", "vulkan-pipelines", filename->str, NULL);
+  file = g_file_new_for_path (path);
+
+  g_free (path);
+  g_string_free (filename, TRUE);
+
+  return file;
+}
+
+/* Returns whether @data starts with a header written for @context's device.
+ * Some drivers don't cope well with caches from other devices, so we don't
+ * rely on them to reject those. */
+static gboolean
+pipeline_cache_data_is_valid (GdkVulkanContext *context,
+                              const char       *data,
+                              gsize             length)
+{
+  VkPhysicalDeviceProperties props;
+  guint32 header[4];
+
+  if (length < sizeof (header) + VK_UUID_SIZE)
+    return FALSE;
+
+  vkGetPhysicalDeviceProperties (gdk_vulkan_context_get_physical_device (context), &props);
+
+  memcpy (header, data, sizeof (header));
+
+  return header[0] >= sizeof (header) + VK_UUID_SIZE &&
+         header[1] == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+         header[2] == props.vendorID &&
+         header[3] == props.deviceID &&
+         memcmp (data + sizeof (header), props.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+}
+
+static VkPipelineCache
+gsk_vulkan_pipeline_get_cache (GdkVulkanContext *context)
+{
+  PipelineCache *self;
+  GFile *file;
+  char *contents = NULL;
+  gsize length = 0;
+
+  self = g_object_get_data (G_OBJECT (context), "gsk-vulkan-pipeline-cache");
+  if (self)
+    return self->cache;
+
+  file = get_pipeline_cache_file (context);
+  if (g_file_load_contents (file, NULL, &contents, &length, NULL, NULL) &&
+      !pipeline_cache_data_is_valid (context, contents, length))
+    {
+      GSK_NOTE (VULKAN, g_message ("Ignoring stale pipeline cache %s", g_file_peek_path (file)));
+      g_clear_pointer (&contents, g_free);
+      length = 0;
+    }
+
+  self = g_new0 (PipelineCache, 1);
+
+  GSK_VK_CHECK (vkCreatePipelineCache, gdk_vulkan_context_get_device (context),
+                                       &(VkPipelineCacheCreateInfo) {
+                                           .sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+                                           .initialDataSize = length,
+                                           .pInitialData = contents,
+                                       },
+                                       NULL,
+                                       &self->cache);
+
+  g_object_set_data_full (G_OBJECT (context), "gsk-vulkan-pipeline-cache",
+                          self, g_free);
+
+  g_free (contents);
+  g_object_unref (file);
+
+  return self->cache;
+}
+
+/* Writes the pipelines created for @context to disk, so that later runs
+ * can skip compiling them, and frees the pipeline cache. This needs to
+ * happen while the device is still around, so it can't be left to the
+ * context's data being cleared. */
+void
+gsk_vulkan_pipeline_release_cache (GdkVulkanContext *context)
+{
+  PipelineCache *self;
+  VkDevice device;
+  GFile *file, *parent;
+  char *contents;
+  size_t length = 0;
+
+  self = g_object_get_data (G_OBJECT (context), "gsk-vulkan-pipeline-cache");
+  if (self == NULL)
+    return;
+
+  device = gdk_vulkan_context_get_device (context);
+
+  if (GSK_VK_CHECK (vkGetPipelineCacheData, device, self->cache, &length, NULL) == VK_SUCCESS &&
+      length > 0)
+    {
+      contents = g_malloc (length);
+      if (GSK_VK_CHECK (vkGetPipelineCacheData, device, self->cache, &length, contents) == VK_SUCCESS)
+        {
+          file = get_pipeline_cache_file (context);
+          parent = g_file_get_parent (file);
+          g_file_make_directory_with_parents (parent, NULL, NULL);
+          g_object_unref (parent);
+
+          g_file_replace_contents (file, contents, length,
+                                   NULL, FALSE, G_FILE_CREATE_NONE, NULL, NULL, NULL);
+
+          g_object_unref (file);
+        }
+      g_free (contents);
+    }
+
+  vkDestroyPipelineCache (device, self->cache, NULL);
+
+  g_object_set_data (G_OBJECT (context), "gsk-vulkan-pipeline-cache", NULL);
+}
+
 GskVulkanPipeline *
 gsk_vulkan_pipeline_new (GType                    pipeline_type,
                          GdkVulkanContext        *context,
@@ -96,7 +241,7 @@ gsk_vulkan_pipeline_new_full (GType                    pipeline_type,
   priv->fragment_shader = gsk_vulkan_shader_new_from_resource (context, GSK_VULKAN_SHADER_FRAGMENT, shader_name, NULL);
 
   GSK_VK_CHECK (vkCreateGraphicsPipelines, device,
-                                           VK_NULL_HANDLE,
+                                           gsk_vulkan_pipeline_get_cache (context),
                                            1,
                                            &(VkGraphicsPipelineCreateInfo) {
                                                .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
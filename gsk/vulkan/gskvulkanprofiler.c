@@ -0,0 +1,318 @@
+#include "config.h"
+
+#include "gskvulkanprofilerprivate.h"
+#include "gskvulkanpipelineprivate.h"
+
+#include <string.h>
+
+/* Every render pass of a frame owns QUERIES_PER_PASS timestamp queries of
+ * one query pool: one when it starts, one whenever it switches to another
+ * section and one when it ends. Each timestamp marks the end of the section
+ * before it. Passes never touch each other's queries, so they can be
+ * recorded on different threads, as long as gsk_vulkan_profiler_begin_pass()
+ * is called for all of them before recording starts.
+ *
+ * Passes that switch sections more often than that just keep counting the
+ * rest of their work in the last section they got a query for.
+ */
+#define QUERIES_PER_PASS 64
+
+#define NO_SECTION G_MAXUINT
+
+typedef struct {
+  VkCommandBuffer command_buffer;
+  guint n_queries;
+  guint sections[QUERIES_PER_PASS]; /* section that starts with the query */
+} PassFrame;
+
+struct _GskVulkanProfiler
+{
+  GdkVulkanContext *vulkan;
+
+  double timestamp_period; /* nsec per tick */
+  guint64 timestamp_mask;
+
+  VkQueryPool query_pool;
+  guint max_passes;
+
+  PassFrame *pass_frames;
+  guint n_passes;
+  gboolean has_results;
+
+  guint n_sections;
+
+  /* usec, for the last frame with results */
+  guint64 gpu_time;
+  guint64 *pass_times;
+  guint n_pass_times;
+  guint64 *section_times;
+};
+
+static void
+gsk_vulkan_profiler_ensure_queries (GskVulkanProfiler *self,
+                                    guint              n_passes)
+{
+  VkDevice device = gdk_vulkan_context_get_device (self->vulkan);
+
+  if (n_passes <= self->max_passes)
+    return;
+
+  if (self->query_pool != VK_NULL_HANDLE)
+    vkDestroyQueryPool (device, self->query_pool, NULL);
+
+  self->max_passes = MAX (n_passes, 2 * self->max_passes);
+  self->pass_frames = g_renew (PassFrame, self->pass_frames, self->max_passes);
+  self->pass_times = g_renew (guint64, self->pass_times, self->max_passes);
+
+  GSK_VK_CHECK (vkCreateQueryPool, device,
+                                   &(VkQueryPoolCreateInfo) {
+                                       .sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+                                       .queryType = VK_QUERY_TYPE_TIMESTAMP,
+                                       .queryCount = self->max_passes * QUERIES_PER_PASS,
+                                   },
+                                   NULL,
+                                   &self->query_pool);
+}
+
+/* Returns %NULL if the device can't do timestamps on our queue */
+GskVulkanProfiler *
+gsk_vulkan_profiler_new (GdkVulkanContext *context,
+                         guint             n_sections)
+{
+  GskVulkanProfiler *self;
+  VkPhysicalDeviceProperties props;
+  VkQueueFamilyProperties *queue_props;
+  uint32_t n_queue_props;
+  uint32_t valid_bits;
+
+  vkGetPhysicalDeviceProperties (gdk_vulkan_context_get_physical_device (context), &props);
+  if (!props.limits.timestampComputeAndGraphics)
+    return NULL;
+
+  vkGetPhysicalDeviceQueueFamilyProperties (gdk_vulkan_context_get_physical_device (context),
+                                            &n_queue_props, NULL);
+  queue_props = g_newa (VkQueueFamilyProperties, n_queue_props);
+  vkGetPhysicalDeviceQueueFamilyProperties (gdk_vulkan_context_get_physical_device (context),
+                                            &n_queue_props, queue_props);
+  valid_bits = queue_props[gdk_vulkan_context_get_queue_family_index (context)].timestampValidBits;
+  if (valid_bits == 0)
+    return NULL;
+
+  self = g_slice_new0 (GskVulkanProfiler);
+
+  self->vulkan = g_object_ref (context);
+  self->timestamp_period = props.limits.timestampPeriod;
+  self->timestamp_mask = valid_bits >= 64 ? G_MAXUINT64 : (G_GUINT64_CONSTANT (1) << valid_bits) - 1;
+  self->n_sections = n_sections;
+  self->section_times = g_new0 (guint64, n_sections);
+
+  gsk_vulkan_profiler_ensure_queries (self, 1);
+
+  return self;
+}
+
+void
+gsk_vulkan_profiler_free (GskVulkanProfiler *self)
+{
+  vkDestroyQueryPool (gdk_vulkan_context_get_device (self->vulkan),
+                      self->query_pool,
+                      NULL);
+
+  g_free (self->pass_frames);
+  g_free (self->pass_times);
+  g_free (self->section_times);
+
+  g_object_unref (self->vulkan);
+
+  g_slice_free (GskVulkanProfiler, self);
+}
+
+/* Must only be called once the previous frame has been collected */
+void
+gsk_vulkan_profiler_begin_frame (GskVulkanProfiler *self,
+                                 guint              n_passes)
+{
+  guint i;
+
+  gsk_vulkan_profiler_ensure_queries (self, n_passes);
+
+  for (i = 0; i < n_passes; i++)
+    {
+      self->pass_frames[i].command_buffer = VK_NULL_HANDLE;
+      self->pass_frames[i].n_queries = 0;
+    }
+
+  self->n_passes = n_passes;
+  self->has_results = n_passes > 0;
+}
+
+static PassFrame *
+find_pass (GskVulkanProfiler *self,
+           VkCommandBuffer    command_buffer)
+{
+  guint i;
+
+  for (i = 0; i < self->n_passes; i++)
+    {
+      if (self->pass_frames[i].command_buffer == command_buffer)
+        return &self->pass_frames[i];
+    }
+
+  g_assert_not_reached ();
+  return NULL;
+}
+
+static void
+write_timestamp (GskVulkanProfiler *self,
+                 PassFrame         *frame,
+                 guint              section)
+{
+  vkCmdWriteTimestamp (frame->command_buffer,
+                       VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                       self->query_pool,
+                       (frame - self->pass_frames) * QUERIES_PER_PASS + frame->n_queries);
+
+  frame->sections[frame->n_queries] = section;
+  frame->n_queries++;
+}
+
+/* Must be called outside of a VkRenderPass, the pass is identified
+ * by its command buffer from then on */
+void
+gsk_vulkan_profiler_begin_pass (GskVulkanProfiler *self,
+                                guint              pass,
+                                VkCommandBuffer    command_buffer)
+{
+  PassFrame *frame;
+
+  g_assert (pass < self->n_passes);
+
+  frame = &self->pass_frames[pass];
+  frame->command_buffer = command_buffer;
+
+  vkCmdResetQueryPool (command_buffer,
+                       self->query_pool,
+                       pass * QUERIES_PER_PASS,
+                       QUERIES_PER_PASS);
+
+  write_timestamp (self, frame, NO_SECTION);
+}
+
+void
+gsk_vulkan_profiler_begin_section (GskVulkanProfiler *self,
+                                   VkCommandBuffer    command_buffer,
+                                   guint              section)
+{
+  PassFrame *frame = find_pass (self, command_buffer);
+
+  g_assert (frame->n_queries > 0);
+
+  if (frame->sections[frame->n_queries - 1] == section)
+    return;
+
+  /* Keep the last query for end_pass() */
+  if (frame->n_queries + 1 >= QUERIES_PER_PASS)
+    return;
+
+  write_timestamp (self, frame, section);
+}
+
+void
+gsk_vulkan_profiler_end_pass (GskVulkanProfiler *self,
+                              VkCommandBuffer    command_buffer)
+{
+  write_timestamp (self, find_pass (self, command_buffer), NO_SECTION);
+}
+
+/* Reads the results of the last frame, its fence must have been waited on */
+void
+gsk_vulkan_profiler_collect (GskVulkanProfiler *self)
+{
+  guint64 results[QUERIES_PER_PASS];
+  guint i, j;
+
+  if (!self->has_results)
+    return;
+
+  self->has_results = FALSE;
+  self->gpu_time = 0;
+  memset (self->section_times, 0, sizeof (guint64) * self->n_sections);
+
+  for (i = 0; i < self->n_passes; i++)
+    {
+      PassFrame *frame = &self->pass_frames[i];
+      guint64 start, end;
+
+      self->pass_times[i] = 0;
+
+      if (frame->n_queries < 2)
+        continue;
+
+      if (vkGetQueryPoolResults (gdk_vulkan_context_get_device (self->vulkan),
+                                 self->query_pool,
+                                 i * QUERIES_PER_PASS,
+                                 frame->n_queries,
+                                 sizeof (results),
+                                 results,
+                                 sizeof (guint64),
+                                 VK_QUERY_RESULT_64_BIT) != VK_SUCCESS)
+        continue;
+
+      for (j = 1; j < frame->n_queries; j++)
+        {
+          guint section = frame->sections[j - 1];
+
+          start = results[j - 1] & self->timestamp_mask;
+          end = results[j] & self->timestamp_mask;
+
+          if (section < self->n_sections && end > start)
+            self->section_times[section] += (end - start) * self->timestamp_period;
+        }
+
+      start = results[0] & self->timestamp_mask;
+      end = results[frame->n_queries - 1] & self->timestamp_mask;
+      if (end > start)
+        self->pass_times[i] = (end - start) * self->timestamp_period;
+
+      self->gpu_time += self->pass_times[i];
+    }
+
+  /* Convert to usec */
+  for (i = 0; i < self->n_passes; i++)
+    self->pass_times[i] /= 1000;
+  for (i = 0; i < self->n_sections; i++)
+    self->section_times[i] /= 1000;
+  self->gpu_time /= 1000;
+
+  self->n_pass_times = self->n_passes;
+}
+
+guint64
+gsk_vulkan_profiler_get_gpu_time (GskVulkanProfiler *self)
+{
+  return self->gpu_time;
+}
+
+guint
+gsk_vulkan_profiler_get_n_passes (GskVulkanProfiler *self)
+{
+  return self->n_pass_times;
+}
+
+guint64
+gsk_vulkan_profiler_get_pass_time (GskVulkanProfiler *self,
+                                   guint              pass)
+{
+  g_return_val_if_fail (pass < self->n_pass_times, 0);
+
+  return self->pass_times[pass];
+}
+
+guint64
+gsk_vulkan_profiler_get_section_time (GskVulkanProfiler *self,
+                                      guint              section)
+{
+  g_return_val_if_fail (section < self->n_sections, 0);
+
+  return self->section_times[section];
+}
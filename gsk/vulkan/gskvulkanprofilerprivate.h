@@ -0,0 +1,35 @@
+#ifndef __GSK_VULKAN_PROFILER_PRIVATE_H__
+#define __GSK_VULKAN_PROFILER_PRIVATE_H__
+
+#include <gdk/gdk.h>
+
+G_BEGIN_DECLS
+
+typedef struct _GskVulkanProfiler GskVulkanProfiler;
+
+GskVulkanProfiler *     gsk_vulkan_profiler_new                         (GdkVulkanContext       *context,
+                                                                         guint                   n_sections);
+void                    gsk_vulkan_profiler_free                        (GskVulkanProfiler      *self);
+
+void                    gsk_vulkan_profiler_begin_frame                 (GskVulkanProfiler      *self,
+                                                                         guint                   n_passes);
+void                    gsk_vulkan_profiler_begin_pass                  (GskVulkanProfiler      *self,
+                                                                         guint                   pass,
+                                                                         VkCommandBuffer         command_buffer);
+void                    gsk_vulkan_profiler_begin_section               (GskVulkanProfiler      *self,
+                                                                         VkCommandBuffer         command_buffer,
+                                                                         guint                   section);
+void                    gsk_vulkan_profiler_end_pass                    (GskVulkanProfiler      *self,
+                                                                         VkCommandBuffer         command_buffer);
+void                    gsk_vulkan_profiler_collect                     (GskVulkanProfiler      *self);
+
+guint64                 gsk_vulkan_profiler_get_gpu_time                (GskVulkanProfiler      *self);
+guint                   gsk_vulkan_profiler_get_n_passes                (GskVulkanProfiler      *self);
+guint64                 gsk_vulkan_profiler_get_pass_time               (GskVulkanProfiler      *self,
+                                                                         guint                   pass);
+guint64                 gsk_vulkan_profiler_get_section_time            (GskVulkanProfiler      *self,
+                                                                         guint                   section);
+
+G_END_DECLS
+
+#endif /* __GSK_VULKAN_PROFILER_PRIVATE_H__ */
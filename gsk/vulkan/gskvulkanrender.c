@@ -8,6 +8,7 @@
 #include "gskvulkanbufferprivate.h"
 #include "gskvulkancommandpoolprivate.h"
 #include "gskvulkanpipelineprivate.h"
+#include "gskvulkanprofilerprivate.h"
 #include "gskvulkanrenderpassprivate.h"
 
 #include "gskvulkanblendmodepipelineprivate.h"
@@ -23,6 +24,8 @@
 #include "gskvulkantexturepipelineprivate.h"
 #include "gskvulkanpushconstantsprivate.h"
 
+#include "gdk/gdkprofilerprivate.h"
+
 #define DESCRIPTOR_POOL_MAXSETS 128
 #define DESCRIPTOR_POOL_MAXSETS_INCREASE 128
 
@@ -58,10 +61,28 @@ struct _GskVulkanRender
   GList *render_passes;
   GSList *cleanup_images;
 
+  /* Frames with several passes record them on worker threads,
+   * each pass into a command buffer from its own pool */
+  GThreadPool *record_pool;
+  GPtrArray *record_command_pools;
+  GMutex record_lock;
+  GCond record_cond;
+  guint n_pending_records;
+
+  /* Timestamps for the GPU time of each pass and pipeline kind,
+   * NULL if the device can't do those */
+  GskVulkanProfiler *profiler;
+
   GQuark render_pass_counter;
   GQuark gpu_time_timer;
+  GQuark offscreen_gpu_time_timer;
+  GQuark pipeline_gpu_time_timers[GSK_VULKAN_N_PIPELINE_KINDS];
 };
 
+#ifdef G_ENABLE_DEBUG
+static guint gpu_time_counter;
+#endif
+
 static void
 gsk_vulkan_render_setup (GskVulkanRender       *self,
                          GskVulkanImage        *target,
@@ -105,6 +126,7 @@ gsk_vulkan_render_setup (GskVulkanRender       *self,
 
 static guint desc_set_index_hash (gconstpointer v);
 static gboolean desc_set_index_equal (gconstpointer v1, gconstpointer v2);
+static void gsk_vulkan_render_record_pass (gpointer data, gpointer user_data);
 
 GskVulkanRender *
 gsk_vulkan_render_new (GskRenderer      *renderer,
@@ -112,6 +134,7 @@ gsk_vulkan_render_new (GskRenderer      *renderer,
 {
   GskVulkanRender *self;
   VkDevice device;
+  guint i G_GNUC_UNUSED;
 
   self = g_slice_new0 (GskVulkanRender);
 
@@ -255,9 +278,31 @@ gsk_vulkan_render_new (GskRenderer      *renderer,
 
   self->uploader = gsk_vulkan_uploader_new (self->vulkan, self->command_pool);
 
+  self->record_command_pools = g_ptr_array_new_with_free_func ((GDestroyNotify) gsk_vulkan_command_pool_free);
+  g_mutex_init (&self->record_lock);
+  g_cond_init (&self->record_cond);
+  if (g_get_num_processors () > 1)
+    self->record_pool = g_thread_pool_new (gsk_vulkan_render_record_pass,
+                                           self,
+                                           g_get_num_processors (),
+                                           FALSE,
+                                           NULL);
+
 #ifdef G_ENABLE_DEBUG
   self->render_pass_counter = g_quark_from_static_string ("render-passes");
   self->gpu_time_timer = g_quark_from_static_string ("gpu-time");
+  self->offscreen_gpu_time_timer = g_quark_from_static_string ("gpu-time-offscreens");
+  for (i = 0; i < GSK_VULKAN_N_PIPELINE_KINDS; i++)
+    {
+      char *timer_name = g_strdup_printf ("gpu-time-%s", gsk_vulkan_render_get_pipeline_kind_name (i));
+      self->pipeline_gpu_time_timers[i] = g_quark_from_string (timer_name);
+      g_free (timer_name);
+    }
+
+  self->profiler = gsk_vulkan_profiler_new (self->vulkan, GSK_VULKAN_N_PIPELINE_KINDS);
+
+  if (gpu_time_counter == 0)
+    gpu_time_counter = gdk_profiler_define_counter ("vulkan-gpu-time", "GPU time (ms)");
 #endif
 
   return self;
@@ -431,6 +476,53 @@ gsk_vulkan_render_get_pipeline (GskVulkanRender       *self,
   return self->pipelines[type];
 }
 
+const char *
+gsk_vulkan_render_get_pipeline_kind_name (guint kind)
+{
+  static const char *kind_names[GSK_VULKAN_N_PIPELINE_KINDS] = {
+    "texture",
+    "color",
+    "linear-gradient",
+    "color-matrix",
+    "border",
+    "inset-shadow",
+    "outset-shadow",
+    "blur",
+    "text",
+    "color-text",
+    "cross-fade",
+    "blend-mode",
+  };
+
+  g_return_val_if_fail (kind < GSK_VULKAN_N_PIPELINE_KINDS, NULL);
+
+  return kind_names[kind];
+}
+
+/* Called whenever a pass binds a pipeline, so that the GPU time
+ * can be attributed to the kind of pipeline in use. */
+void
+gsk_vulkan_render_begin_pipeline (GskVulkanRender   *self,
+                                  VkCommandBuffer    command_buffer,
+                                  GskVulkanPipeline *pipeline)
+{
+#ifdef G_ENABLE_DEBUG
+  guint i;
+
+  if (self->profiler == NULL)
+    return;
+
+  for (i = 0; i < GSK_VULKAN_N_PIPELINES; i++)
+    {
+      if (self->pipelines[i] == pipeline)
+        {
+          gsk_vulkan_profiler_begin_section (self->profiler, command_buffer, i / 3);
+          break;
+        }
+    }
+#endif
+}
+
 VkDescriptorSet
 gsk_vulkan_render_get_descriptor_set (GskVulkanRender *self,
                                       gsize            id)
@@ -587,19 +679,129 @@ gsk_vulkan_render_prepare_descriptor_sets (GskVulkanRender *self)
     }
 }
 
+typedef struct
+{
+  GskVulkanRenderPass *pass;
+  VkCommandBuffer command_buffer;
+} RecordJob;
+
+static void
+gsk_vulkan_render_record_pass (gpointer data,
+                               gpointer user_data)
+{
+  RecordJob *job = data;
+  GskVulkanRender *self = user_data;
+
+  gsk_vulkan_render_pass_draw (job->pass, self, 3, self->pipeline_layout, job->command_buffer);
+#ifdef G_ENABLE_DEBUG
+  if (self->profiler)
+    gsk_vulkan_profiler_end_pass (self->profiler, job->command_buffer);
+#endif
+
+  g_mutex_lock (&self->record_lock);
+  self->n_pending_records--;
+  if (self->n_pending_records == 0)
+    g_cond_signal (&self->record_cond);
+  g_mutex_unlock (&self->record_lock);
+}
+
+/* Records every pass on a worker thread and returns the command buffers
+ * in the order of the passes. Everything a pass lazily creates while
+ * drawing is created up front, so that recording doesn't touch any
+ * state shared between passes. */
+static VkCommandBuffer *
+gsk_vulkan_render_record_passes (GskVulkanRender *self,
+                                 guint            n_passes)
+{
+  VkCommandBuffer *command_buffers;
+  RecordJob *jobs;
+  GList *l;
+  guint i;
+
+  command_buffers = g_new (VkCommandBuffer, n_passes);
+  jobs = g_newa (RecordJob, n_passes);
+
+  while (self->record_command_pools->len < n_passes)
+    g_ptr_array_add (self->record_command_pools, gsk_vulkan_command_pool_new (self->vulkan));
+
+  for (l = self->render_passes, i = 0; l; l = l->next, i++)
+    {
+      gsk_vulkan_render_pass_prepare_draw (l->data, self);
+
+      jobs[i].pass = l->data;
+      jobs[i].command_buffer = gsk_vulkan_command_pool_get_buffer (g_ptr_array_index (self->record_command_pools, i));
+      command_buffers[i] = jobs[i].command_buffer;
+#ifdef G_ENABLE_DEBUG
+      if (self->profiler)
+        gsk_vulkan_profiler_begin_pass (self->profiler, i, jobs[i].command_buffer);
+#endif
+    }
+
+  self->n_pending_records = n_passes;
+  for (i = 0; i < n_passes; i++)
+    g_thread_pool_push (self->record_pool, &jobs[i], NULL);
+
+  g_mutex_lock (&self->record_lock);
+  while (self->n_pending_records > 0)
+    g_cond_wait (&self->record_cond, &self->record_lock);
+  g_mutex_unlock (&self->record_lock);
+
+  return command_buffers;
+}
+
+#ifdef G_ENABLE_DEBUG
+static void
+gsk_vulkan_render_update_profiler (GskVulkanRender *self)
+{
+  GskProfiler *profiler = gsk_renderer_get_profiler (self->renderer);
+  guint64 gpu_time, offscreen_time;
+  guint i, n_passes;
+
+  gpu_time = gsk_vulkan_profiler_get_gpu_time (self->profiler);
+  gsk_profiler_timer_set (profiler, self->gpu_time_timer, gpu_time);
+
+  /* The last pass is the one drawing to the target */
+  offscreen_time = 0;
+  n_passes = gsk_vulkan_profiler_get_n_passes (self->profiler);
+  for (i = 0; i + 1 < n_passes; i++)
+    offscreen_time += gsk_vulkan_profiler_get_pass_time (self->profiler, i);
+  gsk_profiler_timer_set (profiler, self->offscreen_gpu_time_timer, offscreen_time);
+
+  for (i = 0; i < GSK_VULKAN_N_PIPELINE_KINDS; i++)
+    gsk_profiler_timer_set (profiler, self->pipeline_gpu_time_timers[i],
+                            gsk_vulkan_profiler_get_section_time (self->profiler, i));
+
+  if (GDK_PROFILER_IS_RUNNING)
+    gdk_profiler_set_counter (gpu_time_counter, gpu_time / 1000.0);
+}
+#endif
+
 void
 gsk_vulkan_render_draw (GskVulkanRender *self)
 {
+  VkCommandBuffer *command_buffers = NULL;
+  guint n_passes;
   GList *l;
+  guint i;
 
 #ifdef G_ENABLE_DEBUG
-  if (GSK_RENDERER_DEBUG_CHECK (self->renderer, SYNC))
+  if (GSK_RENDERER_DEBUG_CHECK (self->renderer, SYNC) && self->profiler == NULL)
     gsk_profiler_timer_begin (gsk_renderer_get_profiler (self->renderer), self->gpu_time_timer);
 #endif
 
   gsk_vulkan_render_prepare_descriptor_sets (self);
 
-  for (l = self->render_passes; l; l = l->next)
+  n_passes = g_list_length (self->render_passes);
+#ifdef G_ENABLE_DEBUG
+  if (self->profiler)
+    gsk_vulkan_profiler_begin_frame (self->profiler, n_passes);
+#endif
+  if (self->record_pool && n_passes > 1)
+    command_buffers = gsk_vulkan_render_record_passes (self, n_passes);
+
+  /* Submission happens in order here, the semaphores take care of
+   * passes waiting for the offscreens they use */
+  for (l = self->render_passes, i = 0; l; l = l->next, i++)
     {
       GskVulkanRenderPass *pass = l->data;
       VkCommandBuffer command_buffer;
@@ -611,9 +813,23 @@ gsk_vulkan_render_draw (GskVulkanRender *self)
       wait_semaphore_count = gsk_vulkan_render_pass_get_wait_semaphores (pass, &wait_semaphores);
       signal_semaphore_count = gsk_vulkan_render_pass_get_signal_semaphores (pass, &signal_semaphores);
 
-      command_buffer = gsk_vulkan_command_pool_get_buffer (self->command_pool);
-
-      gsk_vulkan_render_pass_draw (pass, self, 3, self->pipeline_layout, command_buffer);
+      if (command_buffers)
+        {
+          command_buffer = command_buffers[i];
+        }
+      else
+        {
+          command_buffer = gsk_vulkan_command_pool_get_buffer (self->command_pool);
+#ifdef G_ENABLE_DEBUG
+          if (self->profiler)
+            gsk_vulkan_profiler_begin_pass (self->profiler, i, command_buffer);
+#endif
+          gsk_vulkan_render_pass_draw (pass, self, 3, self->pipeline_layout, command_buffer);
+#ifdef G_ENABLE_DEBUG
+          if (self->profiler)
+            gsk_vulkan_profiler_end_pass (self->profiler, command_buffer);
+#endif
+        }
 
       gsk_vulkan_command_pool_submit_buffer (self->command_pool,
                                              command_buffer,
@@ -624,22 +840,36 @@ gsk_vulkan_render_draw (GskVulkanRender *self)
                                              l->next != NULL ? VK_NULL_HANDLE : self->fence);
     }
 
+  g_free (command_buffers);
+
 #ifdef G_ENABLE_DEBUG
   if (GSK_RENDERER_DEBUG_CHECK (self->renderer, SYNC))
     {
-      GskProfiler *profiler;
-      gint64 gpu_time;
-
       GSK_VK_CHECK (vkWaitForFences, gdk_vulkan_context_get_device (self->vulkan),
                                      1,
                                      &self->fence,
                                      VK_TRUE,
                                      INT64_MAX);
 
-      profiler = gsk_renderer_get_profiler (self->renderer);
-      gpu_time = gsk_profiler_timer_end (profiler, self->gpu_time_timer);
-      gsk_profiler_timer_set (profiler, self->gpu_time_timer, gpu_time);
+      if (self->profiler)
+        {
+          gsk_vulkan_profiler_collect (self->profiler);
+        }
+      else
+        {
+          GskProfiler *profiler;
+          gint64 gpu_time;
+
+          profiler = gsk_renderer_get_profiler (self->renderer);
+          gpu_time = gsk_profiler_timer_end (profiler, self->gpu_time_timer);
+          gsk_profiler_timer_set (profiler, self->gpu_time_timer, gpu_time);
+        }
     }
+
+  /* Without SYNC, the timestamps are only collected once the fence
+   * has been waited on, so this reports the previous frame */
+  if (self->profiler)
+    gsk_vulkan_render_update_profiler (self);
 #endif
 }
 
@@ -655,6 +885,7 @@ static void
 gsk_vulkan_render_cleanup (GskVulkanRender *self)
 {
   VkDevice device = gdk_vulkan_context_get_device (self->vulkan);
+  guint i;
 
   /* XXX: Wait for fence here or just in reset()? */
   GSK_VK_CHECK (vkWaitForFences, device,
@@ -667,9 +898,16 @@ gsk_vulkan_render_cleanup (GskVulkanRender *self)
                                1,
                                &self->fence);
 
+#ifdef G_ENABLE_DEBUG
+  if (self->profiler)
+    gsk_vulkan_profiler_collect (self->profiler);
+#endif
+
   gsk_vulkan_uploader_reset (self->uploader);
 
   gsk_vulkan_command_pool_reset (self->command_pool);
+  for (i = 0; i < self->record_command_pools->len; i++)
+    gsk_vulkan_command_pool_reset (g_ptr_array_index (self->record_command_pools, i));
 
   g_hash_table_remove_all (self->descriptor_set_indexes);
   GSK_VK_CHECK (vkResetDescriptorPool, device,
@@ -749,6 +987,14 @@ gsk_vulkan_render_free (GskVulkanRender *self)
 
   gsk_vulkan_command_pool_free (self->command_pool);
 
+  g_clear_pointer (&self->profiler, gsk_vulkan_profiler_free);
+
+  if (self->record_pool)
+    g_thread_pool_free (self->record_pool, FALSE, TRUE);
+  g_ptr_array_unref (self->record_command_pools);
+  g_mutex_clear (&self->record_lock);
+  g_cond_clear (&self->record_cond);
+
   g_slice_free (GskVulkanRender, self);
 }
 
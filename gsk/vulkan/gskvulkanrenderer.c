@@ -6,6 +6,7 @@
 #include "gskprivate.h"
 #include "gskrendererprivate.h"
 #include "gskrendernodeprivate.h"
+#include "gskroundedrectprivate.h"
 #include "gskvulkanbufferprivate.h"
 #include "gskvulkanimageprivate.h"
 #include "gskvulkanpipelineprivate.h"
@@ -13,11 +14,17 @@
 #include "gskvulkanglyphcacheprivate.h"
 
 #include "gdk/gdktextureprivate.h"
+#include "gdk/gdkdmabuftextureprivate.h"
+#include "gdk/gdkmemorytextureprivate.h"
 #include "gdk/gdkprofilerprivate.h"
 
 #include <graphene.h>
 
+/* Fallback images that were not used for this many frames are dropped */
+#define MAX_FALLBACK_AGE 60
+
 typedef struct _GskVulkanTextureData GskVulkanTextureData;
+typedef struct _GskVulkanFallbackData GskVulkanFallbackData;
 
 struct _GskVulkanTextureData {
   GdkTexture *texture;
@@ -25,17 +32,31 @@ struct _GskVulkanTextureData {
   GskVulkanRenderer *renderer;
 };
 
+struct _GskVulkanFallbackData {
+  GskRenderNode *node; /* compared by content, so rebuilt nodes hit too */
+  int scale_factor;
+  gboolean has_clip;
+  GskRoundedRect clip;
+
+  GskVulkanImage *image;
+  guint64 timestamp;
+};
+
 #ifdef G_ENABLE_DEBUG
 typedef struct {
   GQuark frames;
   GQuark render_passes;
   GQuark fallback_pixels;
+  GQuark fallback_cache_hits;
+  GQuark fallback_cache_misses;
   GQuark texture_pixels;
 } ProfileCounters;
 
 typedef struct {
   GQuark cpu_time;
   GQuark gpu_time;
+  GQuark offscreen_gpu_time;
+  GQuark pipeline_gpu_time[GSK_VULKAN_N_PIPELINE_KINDS];
 } ProfileTimers;
 
 static guint texture_pixels_counter;
@@ -57,6 +78,9 @@ struct _GskVulkanRenderer
 
   GskVulkanGlyphCache *glyph_cache;
 
+  GHashTable *fallback_cache;
+  guint64 timestamp;
+
 #ifdef G_ENABLE_DEBUG
   ProfileCounters profile_counters;
   ProfileTimers profile_timers;
@@ -112,6 +136,82 @@ gsk_vulkan_renderer_update_images_cb (GdkVulkanContext  *context,
     }
 }
 
+static GskVulkanGlyphCache *
+get_glyph_cache_for_display (GdkDisplay *display)
+{
+  GskVulkanGlyphCache *glyph_cache;
+
+  if (g_getenv ("GSK_NO_SHARED_CACHES"))
+    return gsk_vulkan_glyph_cache_new ();
+
+  glyph_cache = g_object_get_data (G_OBJECT (display), "gsk-vulkan-glyph-cache");
+  if (glyph_cache == NULL)
+    {
+      glyph_cache = gsk_vulkan_glyph_cache_new ();
+      g_object_set_data_full (G_OBJECT (display), "gsk-vulkan-glyph-cache",
+                              glyph_cache,
+                              g_object_unref);
+    }
+
+  return g_object_ref (glyph_cache);
+}
+
+static guint
+fallback_data_hash (gconstpointer v)
+{
+  const GskVulkanFallbackData *data = v;
+  guint hash;
+
+  hash = gsk_render_node_hash (data->node) + data->scale_factor;
+  if (data->has_clip)
+    hash = gsk_render_node_hash_data (hash, &data->clip, sizeof (GskRoundedRect));
+
+  return hash;
+}
+
+static gboolean
+fallback_data_equal (gconstpointer v1,
+                     gconstpointer v2)
+{
+  const GskVulkanFallbackData *data1 = v1;
+  const GskVulkanFallbackData *data2 = v2;
+
+  return data1->scale_factor == data2->scale_factor &&
+         data1->has_clip == data2->has_clip &&
+         (!data1->has_clip || gsk_rounded_rect_equal (&data1->clip, &data2->clip)) &&
+         gsk_render_node_equal (data1->node, data2->node);
+}
+
+static void
+fallback_data_free (gpointer p)
+{
+  GskVulkanFallbackData *data = p;
+
+  gsk_render_node_unref (data->node);
+  g_object_unref (data->image);
+
+  g_slice_free (GskVulkanFallbackData, data);
+}
+
+static void
+gsk_vulkan_renderer_begin_frame (GskVulkanRenderer *self)
+{
+  GHashTableIter iter;
+  GskVulkanFallbackData *data;
+
+  self->timestamp++;
+
+  if (self->timestamp % MAX_FALLBACK_AGE != 0)
+    return;
+
+  g_hash_table_iter_init (&iter, self->fallback_cache);
+  while (g_hash_table_iter_next (&iter, (gpointer *) &data, NULL))
+    {
+      if (self->timestamp - data->timestamp > MAX_FALLBACK_AGE)
+        g_hash_table_iter_remove (&iter);
+    }
+}
+
 static gboolean
 gsk_vulkan_renderer_realize (GskRenderer  *renderer,
                              GdkSurface    *window,
@@ -131,7 +231,10 @@ gsk_vulkan_renderer_realize (GskRenderer  *renderer,
 
   self->render = gsk_vulkan_render_new (renderer, self->vulkan);
 
-  self->glyph_cache = gsk_vulkan_glyph_cache_new (renderer, self->vulkan);
+  self->glyph_cache = get_glyph_cache_for_display (gdk_surface_get_display (window));
+
+  self->fallback_cache = g_hash_table_new_full (fallback_data_hash, fallback_data_equal,
+                                                fallback_data_free, NULL);
 
   return TRUE;
 }
@@ -143,6 +246,7 @@ gsk_vulkan_renderer_unrealize (GskRenderer *renderer)
   GSList *l;
 
   g_clear_object (&self->glyph_cache);
+  g_clear_pointer (&self->fallback_cache, g_hash_table_unref);
 
   for (l = self->textures; l; l = l->next)
     {
@@ -155,6 +259,8 @@ gsk_vulkan_renderer_unrealize (GskRenderer *renderer)
 
   g_clear_pointer (&self->render, gsk_vulkan_render_free);
 
+  gsk_vulkan_pipeline_release_cache (self->vulkan);
+
   gsk_vulkan_renderer_free_targets (self);
   g_signal_handlers_disconnect_by_func(self->vulkan,
                                        gsk_vulkan_renderer_update_images_cb,
@@ -247,6 +353,8 @@ gsk_vulkan_renderer_render (GskRenderer          *renderer,
 #endif
 
   gdk_draw_context_begin_frame (GDK_DRAW_CONTEXT (self->vulkan), region);
+  gsk_vulkan_glyph_cache_begin_frame (self->glyph_cache);
+  gsk_vulkan_renderer_begin_frame (self);
   render = self->render;
 
   clip = gdk_draw_context_get_frame_region (GDK_DRAW_CONTEXT (self->vulkan));
@@ -286,6 +394,7 @@ gsk_vulkan_renderer_init (GskVulkanRenderer *self)
 {
 #ifdef G_ENABLE_DEBUG
   GskProfiler *profiler = gsk_renderer_get_profiler (GSK_RENDERER (self));
+  guint i;
 #endif
 
   gsk_ensure_resources ();
@@ -294,11 +403,26 @@ gsk_vulkan_renderer_init (GskVulkanRenderer *self)
   self->profile_counters.frames = gsk_profiler_add_counter (profiler, "frames", "Frames", FALSE);
   self->profile_counters.render_passes = gsk_profiler_add_counter (profiler, "render-passes", "Render passes", FALSE);
   self->profile_counters.fallback_pixels = gsk_profiler_add_counter (profiler, "fallback-pixels", "Fallback pixels", TRUE);
+  self->profile_counters.fallback_cache_hits = gsk_profiler_add_counter (profiler, "fallback-cache-hits", "Fallbacks found in the cache", TRUE);
+  self->profile_counters.fallback_cache_misses = gsk_profiler_add_counter (profiler, "fallback-cache-misses", "Fallbacks rendered with cairo", TRUE);
   self->profile_counters.texture_pixels = gsk_profiler_add_counter (profiler, "texture-pixels", "Texture pixels", TRUE);
 
   self->profile_timers.cpu_time = gsk_profiler_add_timer (profiler, "cpu-time", "CPU time", FALSE, TRUE);
-  if (GSK_RENDERER_DEBUG_CHECK (GSK_RENDERER (self), SYNC))
-    self->profile_timers.gpu_time = gsk_profiler_add_timer (profiler, "gpu-time", "GPU time", FALSE, TRUE);
+  self->profile_timers.gpu_time = gsk_profiler_add_timer (profiler, "gpu-time", "GPU time", FALSE, TRUE);
+  self->profile_timers.offscreen_gpu_time = gsk_profiler_add_timer (profiler, "gpu-time-offscreens", "GPU time (offscreens)", FALSE, TRUE);
+
+  for (i = 0; i < GSK_VULKAN_N_PIPELINE_KINDS; i++)
+    {
+      const char *name = gsk_vulkan_render_get_pipeline_kind_name (i);
+      char *timer_name = g_strdup_printf ("gpu-time-%s", name);
+      char *description = g_strdup_printf ("GPU time (%s)", name);
+
+      self->profile_timers.pipeline_gpu_time[i] =
+        gsk_profiler_add_timer (profiler, timer_name, description, FALSE, TRUE);
+
+      g_free (timer_name);
+      g_free (description);
+    }
 
   if (texture_pixels_counter == 0)
     {
@@ -335,13 +459,33 @@ gsk_vulkan_renderer_ref_texture_image (GskVulkanRenderer *self,
   if (data)
     return g_object_ref (data->image);
 
-  surface = gdk_texture_download_surface (texture);
-  image = gsk_vulkan_image_new_from_data (uploader,
-                                          cairo_image_surface_get_data (surface),
-                                          cairo_image_surface_get_width (surface),
-                                          cairo_image_surface_get_height (surface),
-                                          cairo_image_surface_get_stride (surface));
-  cairo_surface_destroy (surface);
+  image = NULL;
+  if (GDK_IS_DMABUF_TEXTURE (texture))
+    {
+      image = gsk_vulkan_image_new_from_dmabuf (uploader, GDK_DMABUF_TEXTURE (texture));
+    }
+  else if (GDK_IS_MEMORY_TEXTURE (texture))
+    {
+      GdkMemoryTexture *memory_texture = GDK_MEMORY_TEXTURE (texture);
+
+      image = gsk_vulkan_image_new_from_data_with_format (uploader,
+                                                          gdk_memory_texture_get_format (memory_texture),
+                                                          (guchar *) gdk_memory_texture_get_data (memory_texture),
+                                                          gdk_texture_get_width (texture),
+                                                          gdk_texture_get_height (texture),
+                                                          gdk_memory_texture_get_stride (memory_texture));
+    }
+
+  if (image == NULL)
+    {
+      surface = gdk_texture_download_surface (texture);
+      image = gsk_vulkan_image_new_from_data (uploader,
+                                              cairo_image_surface_get_data (surface),
+                                              cairo_image_surface_get_width (surface),
+                                              cairo_image_surface_get_height (surface),
+                                              cairo_image_surface_get_stride (surface));
+      cairo_surface_destroy (surface);
+    }
 
   data = g_slice_new0 (GskVulkanTextureData);
   data->image = image;
@@ -409,3 +553,60 @@ gsk_vulkan_renderer_new (void)
 {
   return g_object_new (GSK_TYPE_VULKAN_RENDERER, NULL);
 }
+
+static void
+fallback_data_init_key (GskVulkanFallbackData *data,
+                        GskRenderNode         *node,
+                        int                    scale_factor,
+                        const GskRoundedRect  *clip)
+{
+  data->node = node;
+  data->scale_factor = scale_factor;
+  data->has_clip = clip != NULL;
+  if (clip)
+    data->clip = *clip;
+}
+
+GskVulkanImage *
+gsk_vulkan_renderer_ref_fallback_image (GskVulkanRenderer    *self,
+                                        GskRenderNode        *node,
+                                        int                   scale_factor,
+                                        const GskRoundedRect *clip)
+{
+  GskVulkanFallbackData lookup;
+  GskVulkanFallbackData *data;
+
+  fallback_data_init_key (&lookup, node, scale_factor, clip);
+  data = g_hash_table_lookup (self->fallback_cache, &lookup);
+
+#ifdef G_ENABLE_DEBUG
+  gsk_profiler_counter_inc (gsk_renderer_get_profiler (GSK_RENDERER (self)),
+                            data ? self->profile_counters.fallback_cache_hits
+                                 : self->profile_counters.fallback_cache_misses);
+#endif
+
+  if (data == NULL)
+    return NULL;
+
+  data->timestamp = self->timestamp;
+
+  return g_object_ref (data->image);
+}
+
+void
+gsk_vulkan_renderer_add_fallback_image (GskVulkanRenderer    *self,
+                                        GskRenderNode        *node,
+                                        int                   scale_factor,
+                                        const GskRoundedRect *clip,
+                                        GskVulkanImage       *image)
+{
+  GskVulkanFallbackData *data;
+
+  data = g_slice_new (GskVulkanFallbackData);
+  fallback_data_init_key (data, node, scale_factor, clip);
+  gsk_render_node_ref (data->node);
+  data->image = g_object_ref (image);
+  data->timestamp = self->timestamp;
+
+  g_hash_table_replace (self->fallback_cache, data, NULL);
+}
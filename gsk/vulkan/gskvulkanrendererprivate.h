@@ -10,6 +10,16 @@ GskVulkanImage *        gsk_vulkan_renderer_ref_texture_image           (GskVulk
                                                                          GdkTexture             *texture,
                                                                          GskVulkanUploader      *uploader);
 
+GskVulkanImage *        gsk_vulkan_renderer_ref_fallback_image          (GskVulkanRenderer      *self,
+                                                                         GskRenderNode          *node,
+                                                                         int                     scale_factor,
+                                                                         const GskRoundedRect   *clip);
+void                    gsk_vulkan_renderer_add_fallback_image          (GskVulkanRenderer      *self,
+                                                                         GskRenderNode          *node,
+                                                                         int                     scale_factor,
+                                                                         const GskRoundedRect   *clip,
+                                                                         GskVulkanImage         *image);
+
 typedef struct
 {
   guint texture_index;
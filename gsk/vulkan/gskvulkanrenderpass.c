@@ -810,11 +810,30 @@ gsk_vulkan_render_pass_upload_fallback (GskVulkanRenderPass  *self,
                                         GskVulkanRender      *render,
                                         GskVulkanUploader    *uploader)
 {
+  GskVulkanRenderer *renderer;
   GskRenderNode *node;
+  GskRoundedRect rect_clip;
+  const GskRoundedRect *clip;
   cairo_surface_t *surface;
   cairo_t *cr;
 
   node = op->node;
+  renderer = GSK_VULKAN_RENDERER (gsk_vulkan_render_get_renderer (render));
+
+  if (op->type == GSK_VULKAN_OP_FALLBACK_CLIP)
+    clip = gsk_rounded_rect_init_from_rect (&rect_clip, &op->clip.bounds, 0);
+  else if (op->type == GSK_VULKAN_OP_FALLBACK_ROUNDED_CLIP)
+    clip = &op->clip;
+  else
+    clip = NULL;
+
+  op->source = gsk_vulkan_renderer_ref_fallback_image (renderer, node, self->scale_factor, clip);
+  if (op->source)
+    {
+      op->source_rect = GRAPHENE_RECT_INIT(0, 0, 1, 1);
+      gsk_vulkan_render_add_cleanup_image (render, op->source);
+      return;
+    }
 
   GSK_RENDERER_NOTE (gsk_vulkan_render_get_renderer (render), FALLBACK,
             g_message ("Upload op=%s, node %s[%p], bounds %gx%g",
@@ -871,6 +890,7 @@ gsk_vulkan_render_pass_upload_fallback (GskVulkanRenderPass  *self,
 
   cairo_surface_destroy (surface);
 
+  gsk_vulkan_renderer_add_fallback_image (renderer, node, self->scale_factor, clip, op->source);
   gsk_vulkan_render_add_cleanup_image (render, op->source);
 }
 
@@ -1401,6 +1421,16 @@ gsk_vulkan_render_pass_get_vertex_data (GskVulkanRenderPass *self,
   return self->vertex_data;
 }
 
+/* Creates what drawing the pass would otherwise create on demand,
+ * so that gsk_vulkan_render_pass_draw() can run on another thread. */
+void
+gsk_vulkan_render_pass_prepare_draw (GskVulkanRenderPass *self,
+                                     GskVulkanRender     *render)
+{
+  gsk_vulkan_render_pass_get_vertex_data (self, render);
+  gsk_vulkan_render_get_framebuffer (render, self->target);
+}
+
 gsize
 gsk_vulkan_render_pass_get_wait_semaphores (GskVulkanRenderPass  *self,
                                             VkSemaphore         **semaphores)
@@ -1509,6 +1539,7 @@ gsk_vulkan_render_pass_draw_rect (GskVulkanRenderPass     *self,
               vkCmdBindPipeline (command_buffer,
                                  VK_PIPELINE_BIND_POINT_GRAPHICS,
                                  gsk_vulkan_pipeline_get_pipeline (current_pipeline));
+              gsk_vulkan_render_begin_pipeline (render, command_buffer, current_pipeline);
               vkCmdBindVertexBuffers (command_buffer,
                                       0,
                                       1,
@@ -1530,9 +1561,19 @@ gsk_vulkan_render_pass_draw_rect (GskVulkanRenderPass     *self,
                                    0,
                                    NULL);
 
+          /* Textures sharing a descriptor set, like repeated icons, go into one draw */
+          for (step = 1; step + i < self->render_ops->len; step++)
+            {
+              GskVulkanOp *cmp = &g_array_index (self->render_ops, GskVulkanOp, i + step);
+              if (cmp->type != op->type ||
+                  cmp->render.source == NULL ||
+                  cmp->render.pipeline != current_pipeline ||
+                  cmp->render.descriptor_set_index != op->render.descriptor_set_index)
+                break;
+            }
           current_draw_index += gsk_vulkan_texture_pipeline_draw (GSK_VULKAN_TEXTURE_PIPELINE (current_pipeline),
                                                                   command_buffer,
-                                                                  current_draw_index, 1);
+                                                                  current_draw_index, step);
           break;
 
         case GSK_VULKAN_OP_TEXT:
@@ -1542,6 +1583,7 @@ gsk_vulkan_render_pass_draw_rect (GskVulkanRenderPass     *self,
               vkCmdBindPipeline (command_buffer,
                                  VK_PIPELINE_BIND_POINT_GRAPHICS,
                                  gsk_vulkan_pipeline_get_pipeline (current_pipeline));
+              gsk_vulkan_render_begin_pipeline (render, command_buffer, current_pipeline);
               vkCmdBindVertexBuffers (command_buffer,
                                       0,
                                       1,
@@ -1563,9 +1605,23 @@ gsk_vulkan_render_pass_draw_rect (GskVulkanRenderPass     *self,
                                    0,
                                    NULL);
 
-          current_draw_index += gsk_vulkan_text_pipeline_draw (GSK_VULKAN_TEXT_PIPELINE (current_pipeline),
-                                                               command_buffer,
-                                                               current_draw_index, op->text.num_glyphs);
+          {
+            gsize num_glyphs = op->text.num_glyphs;
+
+            /* Runs of text using the same glyph atlas go into one draw */
+            for (step = 1; step + i < self->render_ops->len; step++)
+              {
+                GskVulkanOp *cmp = &g_array_index (self->render_ops, GskVulkanOp, i + step);
+                if (cmp->type != GSK_VULKAN_OP_TEXT ||
+                    cmp->text.pipeline != current_pipeline ||
+                    cmp->text.descriptor_set_index != op->text.descriptor_set_index)
+                  break;
+                num_glyphs += cmp->text.num_glyphs;
+              }
+            current_draw_index += gsk_vulkan_text_pipeline_draw (GSK_VULKAN_TEXT_PIPELINE (current_pipeline),
+                                                                 command_buffer,
+                                                                 current_draw_index, num_glyphs);
+          }
           break;
 
         case GSK_VULKAN_OP_COLOR_TEXT:
@@ -1575,6 +1631,7 @@ gsk_vulkan_render_pass_draw_rect (GskVulkanRenderPass     *self,
               vkCmdBindPipeline (command_buffer,
                                  VK_PIPELINE_BIND_POINT_GRAPHICS,
                                  gsk_vulkan_pipeline_get_pipeline (current_pipeline));
+              gsk_vulkan_render_begin_pipeline (render, command_buffer, current_pipeline);
               vkCmdBindVertexBuffers (command_buffer,
                                       0,
                                       1,
@@ -1596,9 +1653,22 @@ gsk_vulkan_render_pass_draw_rect (GskVulkanRenderPass     *self,
                                    0,
                                    NULL);
 
-          current_draw_index += gsk_vulkan_color_text_pipeline_draw (GSK_VULKAN_COLOR_TEXT_PIPELINE (current_pipeline),
-                                                                     command_buffer,
-                                                                     current_draw_index, op->text.num_glyphs);
+          {
+            gsize num_glyphs = op->text.num_glyphs;
+
+            for (step = 1; step + i < self->render_ops->len; step++)
+              {
+                GskVulkanOp *cmp = &g_array_index (self->render_ops, GskVulkanOp, i + step);
+                if (cmp->type != GSK_VULKAN_OP_COLOR_TEXT ||
+                    cmp->text.pipeline != current_pipeline ||
+                    cmp->text.descriptor_set_index != op->text.descriptor_set_index)
+                  break;
+                num_glyphs += cmp->text.num_glyphs;
+              }
+            current_draw_index += gsk_vulkan_color_text_pipeline_draw (GSK_VULKAN_COLOR_TEXT_PIPELINE (current_pipeline),
+                                                                       command_buffer,
+                                                                       current_draw_index, num_glyphs);
+          }
           break;
 
         case GSK_VULKAN_OP_OPACITY:
@@ -1611,6 +1681,7 @@ gsk_vulkan_render_pass_draw_rect (GskVulkanRenderPass     *self,
               vkCmdBindPipeline (command_buffer,
                                  VK_PIPELINE_BIND_POINT_GRAPHICS,
                                  gsk_vulkan_pipeline_get_pipeline (current_pipeline));
+              gsk_vulkan_render_begin_pipeline (render, command_buffer, current_pipeline);
               vkCmdBindVertexBuffers (command_buffer,
                                       0,
                                       1,
@@ -1646,6 +1717,7 @@ gsk_vulkan_render_pass_draw_rect (GskVulkanRenderPass     *self,
               vkCmdBindPipeline (command_buffer,
                                  VK_PIPELINE_BIND_POINT_GRAPHICS,
                                  gsk_vulkan_pipeline_get_pipeline (current_pipeline));
+              gsk_vulkan_render_begin_pipeline (render, command_buffer, current_pipeline);
               vkCmdBindVertexBuffers (command_buffer,
                                       0,
                                       1,
@@ -1679,6 +1751,7 @@ gsk_vulkan_render_pass_draw_rect (GskVulkanRenderPass     *self,
               vkCmdBindPipeline (command_buffer,
                                  VK_PIPELINE_BIND_POINT_GRAPHICS,
                                  gsk_vulkan_pipeline_get_pipeline (current_pipeline));
+              gsk_vulkan_render_begin_pipeline (render, command_buffer, current_pipeline);
               vkCmdBindVertexBuffers (command_buffer,
                                       0,
                                       1,
@@ -1708,6 +1781,7 @@ gsk_vulkan_render_pass_draw_rect (GskVulkanRenderPass     *self,
               vkCmdBindPipeline (command_buffer,
                                  VK_PIPELINE_BIND_POINT_GRAPHICS,
                                  gsk_vulkan_pipeline_get_pipeline (current_pipeline));
+              gsk_vulkan_render_begin_pipeline (render, command_buffer, current_pipeline);
               vkCmdBindVertexBuffers (command_buffer,
                                       0,
                                       1,
@@ -1729,6 +1803,7 @@ gsk_vulkan_render_pass_draw_rect (GskVulkanRenderPass     *self,
               vkCmdBindPipeline (command_buffer,
                                  VK_PIPELINE_BIND_POINT_GRAPHICS,
                                  gsk_vulkan_pipeline_get_pipeline (current_pipeline));
+              gsk_vulkan_render_begin_pipeline (render, command_buffer, current_pipeline);
               vkCmdBindVertexBuffers (command_buffer,
                                       0,
                                       1,
@@ -1751,6 +1826,7 @@ gsk_vulkan_render_pass_draw_rect (GskVulkanRenderPass     *self,
               vkCmdBindPipeline (command_buffer,
                                  VK_PIPELINE_BIND_POINT_GRAPHICS,
                                  gsk_vulkan_pipeline_get_pipeline (current_pipeline));
+              gsk_vulkan_render_begin_pipeline (render, command_buffer, current_pipeline);
               vkCmdBindVertexBuffers (command_buffer,
                                       0,
                                       1,
@@ -1781,6 +1857,7 @@ gsk_vulkan_render_pass_draw_rect (GskVulkanRenderPass     *self,
               vkCmdBindPipeline (command_buffer,
                                  VK_PIPELINE_BIND_POINT_GRAPHICS,
                                  gsk_vulkan_pipeline_get_pipeline (current_pipeline));
+              gsk_vulkan_render_begin_pipeline (render, command_buffer, current_pipeline);
               vkCmdBindVertexBuffers (command_buffer,
                                       0,
                                       1,
@@ -1817,6 +1894,7 @@ gsk_vulkan_render_pass_draw_rect (GskVulkanRenderPass     *self,
               vkCmdBindPipeline (command_buffer,
                                  VK_PIPELINE_BIND_POINT_GRAPHICS,
                                  gsk_vulkan_pipeline_get_pipeline (current_pipeline));
+              gsk_vulkan_render_begin_pipeline (render, command_buffer, current_pipeline);
               vkCmdBindVertexBuffers (command_buffer,
                                       0,
                                       1,
@@ -52,6 +52,9 @@ typedef enum {
   GSK_VULKAN_N_PIPELINES
 } GskVulkanPipelineType;
 
+/* Every pipeline comes in 3 variants: plain, clip and clip-rounded */
+#define GSK_VULKAN_N_PIPELINE_KINDS (GSK_VULKAN_N_PIPELINES / 3)
+
 GskVulkanRender *       gsk_vulkan_render_new                           (GskRenderer            *renderer,
                                                                          GdkVulkanContext       *context);
 void                    gsk_vulkan_render_free                          (GskVulkanRender        *self);
@@ -77,6 +80,10 @@ void                    gsk_vulkan_render_upload                        (GskVulk
 
 GskVulkanPipeline *     gsk_vulkan_render_get_pipeline                  (GskVulkanRender        *self,
                                                                          GskVulkanPipelineType   pipeline_type);
+const char *            gsk_vulkan_render_get_pipeline_kind_name        (guint                   kind);
+void                    gsk_vulkan_render_begin_pipeline                (GskVulkanRender        *self,
+                                                                         VkCommandBuffer         command_buffer,
+                                                                         GskVulkanPipeline      *pipeline);
 VkDescriptorSet         gsk_vulkan_render_get_descriptor_set            (GskVulkanRender        *self,
                                                                          gsize                   id);
 gsize                   gsk_vulkan_render_reserve_descriptor_set        (GskVulkanRender        *self,
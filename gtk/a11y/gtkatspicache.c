@@ -58,6 +58,23 @@ struct _GtkAtSpiCache
 
   /* HashTable<GtkAtSpiContext, str> */
   GHashTable *contexts_to_path;
+
+  /* Changes are queued and sent in one go from an idle, so that
+   * building or tearing down a large tree doesn't emit a signal
+   * for every widget, and objects that are added and removed
+   * again before that are never announced at all.
+   */
+
+  /* Queue<GtkAtSpiContext>, in the order they were added */
+  GQueue pending_adds;
+
+  /* HashTable<GtkAtSpiContext, GList> */
+  GHashTable *pending_add_links;
+
+  /* HashTable<str, GVariant> */
+  GHashTable *pending_removes;
+
+  guint flush_id;
 };
 
 enum
@@ -77,6 +94,10 @@ gtk_at_spi_cache_finalize (GObject *gobject)
 {
   GtkAtSpiCache *self = GTK_AT_SPI_CACHE (gobject);
 
+  g_clear_handle_id (&self->flush_id, g_source_remove);
+  g_queue_clear (&self->pending_adds);
+  g_clear_pointer (&self->pending_add_links, g_hash_table_unref);
+  g_clear_pointer (&self->pending_removes, g_hash_table_unref);
   g_clear_pointer (&self->contexts_to_path, g_hash_table_unref);
   g_clear_pointer (&self->contexts_by_path, g_hash_table_unref);
   g_clear_object (&self->connection);
@@ -172,22 +193,30 @@ collect_cached_objects (GtkAtSpiCache   *self,
   g_hash_table_unref (collection);
 }
 
-static void
-emit_add_accessible (GtkAtSpiCache   *self,
-                     GtkAtSpiContext *context)
+static gboolean
+context_is_hidden (GtkAtSpiContext *context)
 {
   GtkATContext *at_context = GTK_AT_CONTEXT (context);
 
-  /* If the context is hidden, we don't need to update the cache */
   if (gtk_at_context_has_accessible_state (at_context, GTK_ACCESSIBLE_STATE_HIDDEN))
     {
       GtkAccessibleValue *is_hidden =
         gtk_at_context_get_accessible_state (at_context, GTK_ACCESSIBLE_STATE_HIDDEN);
 
-      if (gtk_boolean_accessible_value_get (is_hidden))
-        return;
+      return gtk_boolean_accessible_value_get (is_hidden);
     }
 
+  return FALSE;
+}
+
+static void
+emit_add_accessible (GtkAtSpiCache   *self,
+                     GtkAtSpiContext *context)
+{
+  /* If the context is hidden, we don't need to update the cache */
+  if (context_is_hidden (context))
+    return;
+
   GVariantBuilder builder = G_VARIANT_BUILDER_INIT (G_VARIANT_TYPE ("(" ITEM_SIGNATURE ")"));
 
   collect_object (self, &builder, context);
@@ -203,23 +232,9 @@ emit_add_accessible (GtkAtSpiCache   *self,
 }
 
 static void
-emit_remove_accessible (GtkAtSpiCache   *self,
-                        GtkAtSpiContext *context)
+emit_remove_accessible (GtkAtSpiCache *self,
+                        GVariant      *ref)
 {
-  GtkATContext *at_context = GTK_AT_CONTEXT (context);
-
-  /* If the context is hidden, we don't need to update the cache */
-  if (gtk_at_context_has_accessible_state (at_context, GTK_ACCESSIBLE_STATE_HIDDEN))
-    {
-      GtkAccessibleValue *is_hidden =
-        gtk_at_context_get_accessible_state (at_context, GTK_ACCESSIBLE_STATE_HIDDEN);
-
-      if (gtk_boolean_accessible_value_get (is_hidden))
-        return;
-    }
-
-  GVariant *ref = gtk_at_spi_context_to_ref (context);
-
   g_dbus_connection_emit_signal (self->connection,
                                  NULL,
                                  self->cache_path,
@@ -229,6 +244,43 @@ emit_remove_accessible (GtkAtSpiCache   *self,
                                  NULL);
 }
 
+static gboolean
+flush_pending_changes (gpointer data)
+{
+  GtkAtSpiCache *self = data;
+  GHashTableIter iter;
+  gpointer value_p;
+
+  self->flush_id = 0;
+
+  g_hash_table_iter_init (&iter, self->pending_removes);
+  while (g_hash_table_iter_next (&iter, NULL, &value_p))
+    {
+      emit_remove_accessible (self, value_p);
+      g_hash_table_iter_remove (&iter);
+    }
+
+  while (!g_queue_is_empty (&self->pending_adds))
+    {
+      GtkAtSpiContext *context = g_queue_pop_head (&self->pending_adds);
+
+      g_hash_table_remove (self->pending_add_links, context);
+      emit_add_accessible (self, context);
+    }
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+queue_flush (GtkAtSpiCache *self)
+{
+  if (self->flush_id != 0)
+    return;
+
+  self->flush_id = g_idle_add (flush_pending_changes, self);
+  g_source_set_name_by_id (self->flush_id, "[gtk] AT-SPI cache flush");
+}
+
 static void
 handle_cache_method (GDBusConnection       *connection,
                      const gchar           *sender,
@@ -336,6 +388,12 @@ gtk_at_spi_cache_init (GtkAtSpiCache *self)
                                                   g_free,
                                                   NULL);
   self->contexts_to_path = g_hash_table_new (NULL, NULL);
+
+  g_queue_init (&self->pending_adds);
+  self->pending_add_links = g_hash_table_new (NULL, NULL);
+  self->pending_removes = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                                 g_free,
+                                                 (GDestroyNotify) g_variant_unref);
 }
 
 GtkAtSpiCache *
@@ -371,7 +429,15 @@ gtk_at_spi_cache_add_context (GtkAtSpiCache   *self,
 
   GTK_NOTE (A11Y, g_message ("Adding context '%s' to cache", path_key));
 
-  emit_add_accessible (self, context);
+  /* A removal of the same path that hasn't been sent yet is
+   * superseded by the addition, which updates the item
+   */
+  g_hash_table_remove (self->pending_removes, path);
+
+  g_queue_push_tail (&self->pending_adds, context);
+  g_hash_table_insert (self->pending_add_links, context, g_queue_peek_tail_link (&self->pending_adds));
+
+  queue_flush (self);
 }
 
 void
@@ -385,7 +451,20 @@ gtk_at_spi_cache_remove_context (GtkAtSpiCache   *self,
   if (!g_hash_table_contains (self->contexts_by_path, path))
     return;
 
-  emit_remove_accessible (self, context);
+  GList *link = g_hash_table_lookup (self->pending_add_links, context);
+  if (link != NULL)
+    {
+      /* Nobody has been told about this context yet */
+      g_queue_delete_link (&self->pending_adds, link);
+      g_hash_table_remove (self->pending_add_links, context);
+    }
+  else if (!context_is_hidden (context))
+    {
+      g_hash_table_insert (self->pending_removes,
+                           g_strdup (path),
+                           g_variant_ref_sink (gtk_at_spi_context_to_ref (context)));
+      queue_flush (self);
+    }
 
   /* The order is important: the value in contexts_by_path is the
    * key in contexts_to_path
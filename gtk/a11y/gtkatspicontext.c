@@ -45,6 +45,8 @@
 #include "gtkdebug.h"
 #include "gtkeditable.h"
 #include "gtkentryprivate.h"
+#include "gtklistbaseprivate.h"
+#include "gtklistitemwidgetprivate.h"
 #include "gtkroot.h"
 #include "gtkstack.h"
 #include "gtktextview.h"
@@ -451,6 +453,42 @@ get_parent_context_ref (GtkAccessible *accessible)
   return res;
 }
 
+/* List views only create widgets for the rows that are on screen,
+ * so their children can't tell an AT how long the list is. The rows
+ * do know their position in the model, though, and report it along
+ * with the model size the same way as ARIA's posinset and setsize.
+ */
+static void
+collect_list_item_attributes (GtkAtSpiContext *self,
+                              GVariantBuilder *builder)
+{
+  GtkAccessible *accessible = gtk_at_context_get_accessible (GTK_AT_CONTEXT (self));
+  GtkWidget *parent;
+  GtkSelectionModel *model;
+  guint position;
+  char *str;
+
+  if (!GTK_IS_LIST_ITEM_WIDGET (accessible))
+    return;
+
+  parent = gtk_widget_get_parent (GTK_WIDGET (accessible));
+  if (!GTK_IS_LIST_BASE (parent))
+    return;
+
+  model = gtk_list_base_get_model (GTK_LIST_BASE (parent));
+  position = gtk_list_item_widget_get_position (GTK_LIST_ITEM_WIDGET (accessible));
+  if (model == NULL || position == GTK_INVALID_LIST_POSITION)
+    return;
+
+  str = g_strdup_printf ("%u", position + 1);
+  g_variant_builder_add (builder, "{ss}", "posinset", str);
+  g_free (str);
+
+  str = g_strdup_printf ("%u", g_list_model_get_n_items (G_LIST_MODEL (model)));
+  g_variant_builder_add (builder, "{ss}", "setsize", str);
+  g_free (str);
+}
+
 static void
 handle_accessible_method (GDBusConnection       *connection,
                           const gchar           *sender,
@@ -508,6 +546,8 @@ handle_accessible_method (GDBusConnection       *connection,
                                  "placeholder-text", gtk_string_accessible_value_get (value));
         }
 
+      collect_list_item_attributes (self, &builder);
+
       g_variant_builder_close (&builder);
 
       g_dbus_method_invocation_return_value (invocation, g_variant_builder_end (&builder));
@@ -1219,10 +1259,17 @@ gtk_at_spi_context_child_change (GtkATContext             *ctx,
     }
 
   if (change & GTK_ACCESSIBLE_CHILD_CHANGE_ADDED)
-    emit_children_changed (self,
-                           GTK_AT_SPI_CONTEXT (child_context),
-                           idx,
-                           GTK_ACCESSIBLE_CHILD_STATE_ADDED);
+    {
+      /* The parent has been seen by an AT, so its new children
+       * need to exist on the bus before they are announced
+       */
+      gtk_at_context_realize (child_context);
+
+      emit_children_changed (self,
+                             GTK_AT_SPI_CONTEXT (child_context),
+                             idx,
+                             GTK_ACCESSIBLE_CHILD_STATE_ADDED);
+    }
   else if (change & GTK_ACCESSIBLE_CHILD_CHANGE_REMOVED)
     emit_children_changed (self,
                            GTK_AT_SPI_CONTEXT (child_context),
@@ -1284,8 +1284,27 @@ typedef struct {
   GtkTextBuffer *buffer;
   int cursor_position;
   int selection_bound;
+
+  /* Consecutive insertions into a GtkTextBuffer are collected here
+   * and reported together from an idle.
+   */
+  GString *pending_text;
+  int pending_start;
+  int pending_length;
+  guint flush_id;
 } TextChanged;
 
+static void
+text_changed_free (gpointer data)
+{
+  TextChanged *changed = data;
+
+  g_clear_handle_id (&changed->flush_id, g_source_remove);
+  if (changed->pending_text)
+    g_string_free (changed->pending_text, TRUE);
+  g_free (changed);
+}
+
 /* {{{ GtkEditable notification */
 
 static void
@@ -1378,6 +1397,35 @@ update_cursor (GtkTextBuffer *buffer,
 /* }}} */
 /* {{{ GtkTextView notification */
 
+static void
+flush_pending_insert (TextChanged *changed)
+{
+  char *text;
+
+  g_clear_handle_id (&changed->flush_id, g_source_remove);
+
+  if (changed->pending_text == NULL)
+    return;
+
+  text = g_string_free (g_steal_pointer (&changed->pending_text), FALSE);
+  changed->text_changed (changed->data, "insert", changed->pending_start, changed->pending_length, text);
+  g_free (text);
+
+  if (changed->buffer)
+    update_cursor (changed->buffer, changed);
+}
+
+static gboolean
+flush_pending_insert_cb (gpointer data)
+{
+  TextChanged *changed = data;
+
+  changed->flush_id = 0;
+  flush_pending_insert (changed);
+
+  return G_SOURCE_REMOVE;
+}
+
 static void
 insert_range_cb (GtkTextBuffer *buffer,
                  GtkTextIter   *iter,
@@ -1391,9 +1439,30 @@ insert_range_cb (GtkTextBuffer *buffer,
   position = gtk_text_iter_get_offset (iter);
   length = g_utf8_strlen (text, len);
 
-  changed->text_changed (changed->data, "insert", position - length, length, text);
+  /* Typing and programmatic inserts in a loop produce many small
+   * insertions; report each run of adjacent ones as a single event.
+   */
+  if (changed->pending_text != NULL &&
+      changed->pending_start + changed->pending_length != position - length)
+    flush_pending_insert (changed);
 
-  update_cursor (buffer, changed);
+  if (changed->pending_text == NULL)
+    {
+      changed->pending_text = g_string_new_len (text, len);
+      changed->pending_start = position - length;
+      changed->pending_length = length;
+    }
+  else
+    {
+      g_string_append_len (changed->pending_text, text, len);
+      changed->pending_length += length;
+    }
+
+  if (changed->flush_id == 0)
+    {
+      changed->flush_id = g_idle_add (flush_pending_insert_cb, changed);
+      g_source_set_name_by_id (changed->flush_id, "[gtk] flush_pending_insert_cb");
+    }
 }
 
 static void
@@ -1405,6 +1474,8 @@ delete_range_cb (GtkTextBuffer *buffer,
   int offset, length;
   char *text;
 
+  flush_pending_insert (changed);
+
   text = gtk_text_buffer_get_slice (buffer, start, end, FALSE);
 
   offset = gtk_text_iter_get_offset (start);
@@ -1432,7 +1503,10 @@ mark_set_cb (GtkTextBuffer *buffer,
 {
   if (mark == gtk_text_buffer_get_insert (buffer) ||
       mark == gtk_text_buffer_get_selection_bound (buffer))
-    update_cursor (buffer, changed);
+    {
+      flush_pending_insert (changed);
+      update_cursor (buffer, changed);
+    }
 }
 
 static void
@@ -1446,6 +1520,8 @@ buffer_changed (GtkWidget   *widget,
 
   buffer = gtk_text_view_get_buffer (GTK_TEXT_VIEW (widget));
 
+  flush_pending_insert (changed);
+
   if (changed->buffer)
     {
       g_signal_handlers_disconnect_by_func (changed->buffer, insert_range_cb, changed);
@@ -1501,7 +1577,7 @@ gtk_atspi_connect_text_signals (GtkAccessible *accessible,
   changed->selection_changed = selection_changed;
   changed->data = data;
 
-  g_object_set_data_full (G_OBJECT (accessible), "accessible-text-data", changed, g_free);
+  g_object_set_data_full (G_OBJECT (accessible), "accessible-text-data", changed, text_changed_free);
 
   if (GTK_IS_EDITABLE (accessible))
     {
@@ -1551,6 +1627,8 @@ gtk_atspi_disconnect_text_signals (GtkAccessible *accessible)
     {
       g_signal_handlers_disconnect_by_func (accessible, buffer_changed, changed);
 
+      flush_pending_insert (changed);
+
       if (changed->buffer)
         {
           g_signal_handlers_disconnect_by_func (changed->buffer, insert_range_cb, changed);
@@ -26,6 +26,35 @@
 #include <math.h>
 #include <string.h>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+/* Precompiled token streams are what gtk_css_tokenizer_precompile()
+ * produces: a header, an array of PrecompiledTokens ending with an EOF
+ * token and a table of NUL-terminated strings the tokens point into.
+ * They are only meant to be read back by the same build of GTK on the
+ * same machine, so everything is stored in native byte order.
+ */
+#define PRECOMPILED_MAGIC "GtkCss\0\1"
+#define PRECOMPILED_MAGIC_LEN 8
+
+typedef struct {
+  char    magic[PRECOMPILED_MAGIC_LEN];
+  guint32 n_tokens;
+  guint32 strings_size;
+} PrecompiledHeader;
+
+typedef struct {
+  guint32 type;
+  guint32 value;        /* delim, or offset of the string */
+  double  number;
+  guint32 dimension;    /* offset of the dimension */
+  guint32 location[5];  /* GtkCssLocation at the start of the token */
+} PrecompiledToken;
+
 struct _GtkCssTokenizer
 {
   int                    ref_count;
@@ -35,6 +64,11 @@ struct _GtkCssTokenizer
   const char            *end;
 
   GtkCssLocation         position;
+
+  /* set if bytes is a precompiled token stream */
+  const PrecompiledToken *tokens;
+  const char            *strings;
+  gsize                  next_token;
 };
 
 void
@@ -526,6 +560,101 @@ gtk_css_token_init (GtkCssToken     *token,
   va_end (args);
 }
 
+static gboolean
+token_type_has_string (guint32 type)
+{
+  switch (type)
+    {
+    case GTK_CSS_TOKEN_STRING:
+    case GTK_CSS_TOKEN_IDENT:
+    case GTK_CSS_TOKEN_FUNCTION:
+    case GTK_CSS_TOKEN_AT_KEYWORD:
+    case GTK_CSS_TOKEN_HASH_UNRESTRICTED:
+    case GTK_CSS_TOKEN_HASH_ID:
+    case GTK_CSS_TOKEN_URL:
+      return TRUE;
+
+    default:
+      return FALSE;
+    }
+}
+
+static gboolean
+token_type_has_dimension (guint32 type)
+{
+  return type == GTK_CSS_TOKEN_SIGNED_INTEGER_DIMENSION ||
+         type == GTK_CSS_TOKEN_SIGNLESS_INTEGER_DIMENSION ||
+         type == GTK_CSS_TOKEN_DIMENSION;
+}
+
+static void
+precompiled_location (const PrecompiledToken *token,
+                      GtkCssLocation         *location)
+{
+  location->bytes = token->location[0];
+  location->chars = token->location[1];
+  location->lines = token->location[2];
+  location->line_bytes = token->location[3];
+  location->line_chars = token->location[4];
+}
+
+/**
+ * gtk_css_tokenizer_is_precompiled:
+ * @bytes: the data to check
+ *
+ * Checks if @bytes contains a valid token stream as produced by
+ * gtk_css_tokenizer_precompile(). Such data can be passed to
+ * gtk_css_tokenizer_new() in place of the CSS it was made from.
+ *
+ * Returns: %TRUE if @bytes is a usable precompiled token stream
+ **/
+gboolean
+gtk_css_tokenizer_is_precompiled (GBytes *bytes)
+{
+  const PrecompiledHeader *header;
+  const PrecompiledToken *tokens;
+  const char *data, *strings;
+  gsize size, i;
+
+  data = g_bytes_get_data (bytes, &size);
+
+  if (size < sizeof (PrecompiledHeader) ||
+      memcmp (data, PRECOMPILED_MAGIC, PRECOMPILED_MAGIC_LEN) != 0)
+    return FALSE;
+
+  /* The token array must be properly aligned, which mapped files
+   * and g_malloc()ed memory always are */
+  if (GPOINTER_TO_SIZE (data) % G_ALIGNOF (PrecompiledToken) != 0)
+    return FALSE;
+
+  header = (const PrecompiledHeader *) data;
+  if (header->n_tokens == 0 || header->strings_size == 0 ||
+      header->n_tokens > (size - sizeof (PrecompiledHeader)) / sizeof (PrecompiledToken) ||
+      size - sizeof (PrecompiledHeader) - header->n_tokens * sizeof (PrecompiledToken) != header->strings_size)
+    return FALSE;
+
+  tokens = (const PrecompiledToken *) (data + sizeof (PrecompiledHeader));
+  strings = (const char *) (tokens + header->n_tokens);
+
+  if (strings[header->strings_size - 1] != '\0' ||
+      tokens[header->n_tokens - 1].type != GTK_CSS_TOKEN_EOF)
+    return FALSE;
+
+  for (i = 0; i < header->n_tokens; i++)
+    {
+      if (tokens[i].type > GTK_CSS_TOKEN_DIMENSION)
+        return FALSE;
+      if (token_type_has_string (tokens[i].type) &&
+          tokens[i].value >= header->strings_size)
+        return FALSE;
+      if (token_type_has_dimension (tokens[i].type) &&
+          tokens[i].dimension >= header->strings_size)
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
 GtkCssTokenizer *
 gtk_css_tokenizer_new (GBytes *bytes)
 {
@@ -538,7 +667,18 @@ gtk_css_tokenizer_new (GBytes *bytes)
   tokenizer->data = g_bytes_get_data (bytes, NULL);
   tokenizer->end = tokenizer->data + g_bytes_get_size (bytes);
 
-  gtk_css_location_init (&tokenizer->position);
+  if (gtk_css_tokenizer_is_precompiled (bytes))
+    {
+      const PrecompiledHeader *header = (const PrecompiledHeader *) tokenizer->data;
+
+      tokenizer->tokens = (const PrecompiledToken *) (tokenizer->data + sizeof (PrecompiledHeader));
+      tokenizer->strings = (const char *) (tokenizer->tokens + header->n_tokens);
+      precompiled_location (&tokenizer->tokens[0], &tokenizer->position);
+    }
+  else
+    {
+      gtk_css_location_init (&tokenizer->position);
+    }
 
   return tokenizer;
 }
@@ -662,6 +802,89 @@ is_valid_escape (const char *data,
     }
 }
 
+/* Counts the characters of a run of UTF-8, which must not end
+ * in the middle of a character */
+static inline gsize
+count_characters (const char *data,
+                  gsize       n_bytes)
+{
+  gsize i, n_characters;
+
+  n_characters = n_bytes;
+  for (i = 0; i < n_bytes; i++)
+    {
+      if ((data[i] & 0xC0) == 0x80)
+        n_characters--;
+    }
+
+  return n_characters;
+}
+
+/* Returns the number of bytes at @data before the first @stop1, @stop2
+ * or newline. Multibyte characters never contain any of those, so the
+ * run always ends at a character boundary.
+ * Comments and strings are where the bulk of a stylesheet's bytes are,
+ * so look at 16 bytes at a time there. */
+static gsize
+scan_until (const char *data,
+            const char *end,
+            char        stop1,
+            char        stop2)
+{
+  const char *p = data;
+
+#if defined(__SSE2__)
+  const __m128i s1 = _mm_set1_epi8 (stop1);
+  const __m128i s2 = _mm_set1_epi8 (stop2);
+  const __m128i lf = _mm_set1_epi8 ('\n');
+  const __m128i cr = _mm_set1_epi8 ('\r');
+  const __m128i ff = _mm_set1_epi8 ('\f');
+
+  while (end - p >= 16)
+    {
+      __m128i v = _mm_loadu_si128 ((const __m128i *) p);
+      __m128i m;
+      int mask;
+
+      m = _mm_or_si128 (_mm_cmpeq_epi8 (v, s1), _mm_cmpeq_epi8 (v, s2));
+      m = _mm_or_si128 (m, _mm_cmpeq_epi8 (v, lf));
+      m = _mm_or_si128 (m, _mm_cmpeq_epi8 (v, cr));
+      m = _mm_or_si128 (m, _mm_cmpeq_epi8 (v, ff));
+      mask = _mm_movemask_epi8 (m);
+      if (mask)
+        return p - data + g_bit_nth_lsf (mask, -1);
+
+      p += 16;
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+  const uint8x16_t s1 = vdupq_n_u8 (stop1);
+  const uint8x16_t s2 = vdupq_n_u8 (stop2);
+  const uint8x16_t lf = vdupq_n_u8 ('\n');
+  const uint8x16_t cr = vdupq_n_u8 ('\r');
+  const uint8x16_t ff = vdupq_n_u8 ('\f');
+
+  while (end - p >= 16)
+    {
+      uint8x16_t v = vld1q_u8 ((const uint8_t *) p);
+      uint8x16_t m;
+
+      m = vorrq_u8 (vceqq_u8 (v, s1), vceqq_u8 (v, s2));
+      m = vorrq_u8 (m, vceqq_u8 (v, lf));
+      m = vorrq_u8 (m, vceqq_u8 (v, cr));
+      m = vorrq_u8 (m, vceqq_u8 (v, ff));
+      if (vmaxvq_u8 (m))
+        break;
+
+      p += 16;
+    }
+#endif
+
+  while (p < end && *p != stop1 && *p != stop2 && !is_newline (*p))
+    p++;
+
+  return p - data;
+}
+
 static inline gsize
 gtk_css_tokenizer_remaining (GtkCssTokenizer *tokenizer)
 {
@@ -790,12 +1013,36 @@ gtk_css_tokenizer_consume_char (GtkCssTokenizer *tokenizer,
     }
 }
 
+/* Consumes @n_bytes of valid UTF-8 without newlines, optionally
+ * appending them to @string */
+static inline void
+gtk_css_tokenizer_consume_run (GtkCssTokenizer *tokenizer,
+                               gsize            n_bytes,
+                               GString         *string)
+{
+  if (string)
+    g_string_append_len (string, tokenizer->data, n_bytes);
+
+  gtk_css_tokenizer_consume (tokenizer, n_bytes, count_characters (tokenizer->data, n_bytes));
+}
+
 static void
 gtk_css_tokenizer_read_whitespace (GtkCssTokenizer *tokenizer,
                                    GtkCssToken     *token)
 {
   do {
-    gtk_css_tokenizer_consume_whitespace (tokenizer);
+    const char *p;
+
+    if (is_newline (*tokenizer->data))
+      {
+        gtk_css_tokenizer_consume_newline (tokenizer);
+        continue;
+      }
+
+    /* indentation */
+    for (p = tokenizer->data; p < tokenizer->end && (*p == ' ' || *p == '\t'); p++)
+      ;
+    gtk_css_tokenizer_consume (tokenizer, p - tokenizer->data, p - tokenizer->data);
   } while (tokenizer->data != tokenizer->end &&
            is_whitespace (*tokenizer->data));
 
@@ -868,7 +1115,14 @@ gtk_css_tokenizer_read_name (GtkCssTokenizer *tokenizer)
         }
       else if (is_name (*tokenizer->data))
         {
-          gtk_css_tokenizer_consume_char (tokenizer, string);
+          const char *p;
+
+          for (p = tokenizer->data + 1; p < tokenizer->end && is_name (*p); p++)
+            ;
+          /* don't split a multibyte character at the end of the data */
+          while (p < tokenizer->end && (*p & 0xC0) == 0x80)
+            p++;
+          gtk_css_tokenizer_consume_run (tokenizer, p - tokenizer->data, string);
         }
       else
         {
@@ -1191,7 +1445,9 @@ gtk_css_tokenizer_read_string (GtkCssTokenizer  *tokenizer,
         }
       else
         {
-          gtk_css_tokenizer_consume_char (tokenizer, string);
+          gtk_css_tokenizer_consume_run (tokenizer,
+                                         scan_until (tokenizer->data, tokenizer->end, end, '\\'),
+                                         string);
         }
     }
   
@@ -1216,7 +1472,20 @@ gtk_css_tokenizer_read_comment (GtkCssTokenizer  *tokenizer,
           gtk_css_token_init (token, GTK_CSS_TOKEN_COMMENT);
           return TRUE;
         }
-      gtk_css_tokenizer_consume_char (tokenizer, NULL);
+      else if (*tokenizer->data == '*')
+        {
+          gtk_css_tokenizer_consume_ascii (tokenizer);
+        }
+      else if (is_newline (*tokenizer->data))
+        {
+          gtk_css_tokenizer_consume_newline (tokenizer);
+        }
+      else
+        {
+          gtk_css_tokenizer_consume_run (tokenizer,
+                                         scan_until (tokenizer->data, tokenizer->end, '*', '*'),
+                                         NULL);
+        }
     }
 
   gtk_css_token_init (token, GTK_CSS_TOKEN_COMMENT);
@@ -1240,11 +1509,44 @@ gtk_css_tokenizer_read_match (GtkCssTokenizer *tokenizer,
     }
 }
 
+static void
+gtk_css_tokenizer_replay_token (GtkCssTokenizer *tokenizer,
+                                GtkCssToken     *token)
+{
+  const PrecompiledToken *record = &tokenizer->tokens[tokenizer->next_token];
+
+  token->type = record->type;
+  if (token_type_has_string (record->type))
+    token->string.string = g_strdup (tokenizer->strings + record->value);
+  else if (token_type_has_dimension (record->type))
+    {
+      token->dimension.value = record->number;
+      token->dimension.dimension = g_strdup (tokenizer->strings + record->dimension);
+    }
+  else if (record->type == GTK_CSS_TOKEN_DELIM)
+    token->delim.delim = record->value;
+  else if (record->type >= GTK_CSS_TOKEN_SIGNED_INTEGER)
+    token->number.number = record->number;
+
+  /* The EOF token stays around forever */
+  if (record->type != GTK_CSS_TOKEN_EOF)
+    {
+      tokenizer->next_token++;
+      precompiled_location (&tokenizer->tokens[tokenizer->next_token], &tokenizer->position);
+    }
+}
+
 gboolean
 gtk_css_tokenizer_read_token (GtkCssTokenizer  *tokenizer,
                               GtkCssToken      *token,
                               GError          **error)
 {
+  if (tokenizer->tokens)
+    {
+      gtk_css_tokenizer_replay_token (tokenizer, token);
+      return TRUE;
+    }
+
   if (tokenizer->data == tokenizer->end)
     {
       gtk_css_token_init (token, GTK_CSS_TOKEN_EOF);
@@ -1442,3 +1744,125 @@ gtk_css_tokenizer_read_token (GtkCssTokenizer  *tokenizer,
     }
 }
 
+
+typedef struct {
+  GArray *tokens;
+  GHashTable *string_offsets;
+  GString *strings;
+} PrecompileData;
+
+static guint32
+precompile_string (PrecompileData *data,
+                   const char     *string)
+{
+  gpointer offset;
+
+  if (g_hash_table_lookup_extended (data->string_offsets, string, NULL, &offset))
+    return GPOINTER_TO_UINT (offset);
+
+  offset = GUINT_TO_POINTER (data->strings->len);
+  g_string_append_len (data->strings, string, strlen (string) + 1);
+  g_hash_table_insert (data->string_offsets, g_strdup (string), offset);
+
+  return GPOINTER_TO_UINT (offset);
+}
+
+/**
+ * gtk_css_tokenizer_precompile:
+ * @bytes: CSS data
+ *
+ * Tokenizes all of @bytes and stores the result in a binary form
+ * that gtk_css_tokenizer_new() can read back much faster than it
+ * can tokenize the original text.
+ *
+ * The resulting tokenizer produces the same tokens and locations as
+ * if it had been created for @bytes. Because precompiled data cannot
+ * reproduce tokenizer errors, %NULL is returned if tokenizing fails.
+ *
+ * Returns: (nullable): the precompiled token stream
+ **/
+GBytes *
+gtk_css_tokenizer_precompile (GBytes *bytes)
+{
+  GtkCssTokenizer *tokenizer;
+  PrecompileData data;
+  PrecompiledHeader header;
+  GtkCssToken token;
+  GByteArray *result;
+  gboolean success = TRUE;
+
+  tokenizer = gtk_css_tokenizer_new (bytes);
+  if (tokenizer->tokens)
+    {
+      gtk_css_tokenizer_unref (tokenizer);
+      return g_bytes_ref (bytes);
+    }
+
+  data.tokens = g_array_new (FALSE, TRUE, sizeof (PrecompiledToken));
+  data.string_offsets = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+  data.strings = g_string_new (NULL);
+
+  do
+    {
+      PrecompiledToken record = { 0, };
+      GtkCssLocation location = *gtk_css_tokenizer_get_location (tokenizer);
+
+      gtk_css_token_init (&token, GTK_CSS_TOKEN_EOF);
+      if (location.bytes > G_MAXUINT32 ||
+          !gtk_css_tokenizer_read_token (tokenizer, &token, NULL))
+        {
+          success = FALSE;
+          gtk_css_token_clear (&token);
+          break;
+        }
+
+      record.type = token.type;
+      record.location[0] = location.bytes;
+      record.location[1] = location.chars;
+      record.location[2] = location.lines;
+      record.location[3] = location.line_bytes;
+      record.location[4] = location.line_chars;
+
+      if (token_type_has_string (token.type))
+        record.value = precompile_string (&data, token.string.string);
+      else if (token_type_has_dimension (token.type))
+        {
+          record.number = token.dimension.value;
+          record.dimension = precompile_string (&data, token.dimension.dimension);
+        }
+      else if (token.type == GTK_CSS_TOKEN_DELIM)
+        record.value = token.delim.delim;
+      else if (token.type >= GTK_CSS_TOKEN_SIGNED_INTEGER)
+        record.number = token.number.number;
+
+      g_array_append_val (data.tokens, record);
+      gtk_css_token_clear (&token);
+    }
+  while (g_array_index (data.tokens, PrecompiledToken, data.tokens->len - 1).type != GTK_CSS_TOKEN_EOF);
+
+  gtk_css_tokenizer_unref (tokenizer);
+
+  /* There is always at least one string, which keeps the string
+   * table from being empty */
+  precompile_string (&data, "");
+
+  if (success)
+    {
+      memcpy (header.magic, PRECOMPILED_MAGIC, PRECOMPILED_MAGIC_LEN);
+      header.n_tokens = data.tokens->len;
+      header.strings_size = data.strings->len;
+
+      result = g_byte_array_sized_new (sizeof (header) + data.tokens->len * sizeof (PrecompiledToken) + data.strings->len);
+      g_byte_array_append (result, (const guint8 *) &header, sizeof (header));
+      g_byte_array_append (result, (const guint8 *) data.tokens->data, data.tokens->len * sizeof (PrecompiledToken));
+      g_byte_array_append (result, (const guint8 *) data.strings->str, data.strings->len);
+    }
+  else
+    result = NULL;
+
+  g_array_unref (data.tokens);
+  g_hash_table_unref (data.string_offsets);
+  g_string_free (data.strings, TRUE);
+
+  return result ? g_byte_array_free_to_bytes (result) : NULL;
+}
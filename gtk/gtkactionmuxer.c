@@ -25,6 +25,7 @@
 #include "gtkactionobserverprivate.h"
 #include "gtkbitmaskprivate.h"
 #include "gtkintl.h"
+#include "gtkmain.h"
 #include "gtkmarshalers.h"
 #include "gtkwidgetprivate.h"
 #include "gsettings-mapping.h"
@@ -161,6 +162,15 @@ struct _GtkActionMuxer
   GtkAccels primary_accels;
 
   GtkBitmask *widget_actions_disabled;
+
+  /* Where action names resolve locally, dropped when groups change */
+  GHashTable *lookups;
+
+  /* Actions with enabled or state changes that observers have not
+   * been told about yet, see gtk_action_muxer_queue_change().
+   */
+  GHashTable *pending_changes;
+  guint pending_changes_id;
 };
 
 G_DEFINE_TYPE_WITH_CODE (GtkActionMuxer, gtk_action_muxer, G_TYPE_OBJECT,
@@ -192,6 +202,23 @@ typedef struct
   gulong        handler_ids[4];
 } Group;
 
+/* The local result of looking up an action name. If neither
+ * widget_action nor group is set, the name must be looked up
+ * in the parent.
+ */
+typedef struct
+{
+  char            *name;
+  GtkWidgetAction *widget_action;
+  Group           *group;
+  gsize            unprefixed_offset;
+} Lookup;
+
+enum {
+  PENDING_ENABLED = 1 << 0,
+  PENDING_STATE   = 1 << 1
+};
+
 static inline guint
 get_action_position (GtkWidgetAction *action)
 {
@@ -301,16 +328,85 @@ gtk_action_muxer_find_group (GtkActionMuxer  *muxer,
   return NULL;
 }
 
+static void
+lookup_free (gpointer data)
+{
+  Lookup *lookup = data;
+
+  g_free (lookup->name);
+  g_slice_free (Lookup, lookup);
+}
+
+static const Lookup *
+gtk_action_muxer_lookup (GtkActionMuxer *muxer,
+                         const char     *action_name)
+{
+  Lookup *lookup;
+
+  if (muxer->lookups == NULL)
+    muxer->lookups = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, lookup_free);
+  else
+    {
+      lookup = g_hash_table_lookup (muxer->lookups, action_name);
+      if (lookup)
+        return lookup;
+    }
+
+  lookup = g_slice_new0 (Lookup);
+  lookup->name = g_strdup (action_name);
+
+  if (muxer->widget)
+    {
+      GtkWidgetClass *klass = GTK_WIDGET_GET_CLASS (muxer->widget);
+      GtkWidgetClassPrivate *priv = klass->priv;
+      GtkWidgetAction *action;
+
+      for (action = priv->actions; action; action = action->next)
+        {
+          if (strcmp (action->name, action_name) == 0)
+            {
+              lookup->widget_action = action;
+              break;
+            }
+        }
+    }
+
+  if (lookup->widget_action == NULL)
+    {
+      const char *unprefixed_name;
+
+      lookup->group = gtk_action_muxer_find_group (muxer, lookup->name, &unprefixed_name);
+      if (lookup->group)
+        lookup->unprefixed_offset = unprefixed_name - lookup->name;
+    }
+
+  g_hash_table_insert (muxer->lookups, lookup->name, lookup);
+
+  return lookup;
+}
+
+static void
+gtk_action_muxer_invalidate_lookups (GtkActionMuxer *muxer)
+{
+  if (muxer->lookups)
+    g_hash_table_remove_all (muxer->lookups);
+}
+
 GActionGroup *
 gtk_action_muxer_find (GtkActionMuxer  *muxer,
                        const char      *action_name,
                        const char     **unprefixed_name)
 {
-  Group *group;
+  const Lookup *lookup;
 
-  group = gtk_action_muxer_find_group (muxer, action_name, unprefixed_name);
-  if (group)
-    return group->group;
+  lookup = gtk_action_muxer_lookup (muxer, action_name);
+  if (lookup->group)
+    {
+      if (unprefixed_name)
+        *unprefixed_name = action_name + lookup->unprefixed_offset;
+
+      return lookup->group->group;
+    }
 
   return NULL;
 }
@@ -338,36 +434,146 @@ find_observers (GtkActionMuxer *muxer,
   return NULL;
 }
 
-void
-gtk_action_muxer_action_enabled_changed (GtkActionMuxer *muxer,
-                                         const char     *action_name,
-                                         gboolean        enabled)
+static gboolean action_muxer_query_action (GtkActionMuxer      *muxer,
+                                           const char          *action_name,
+                                           gboolean            *enabled,
+                                           const GVariantType **parameter_type,
+                                           const GVariantType **state_type,
+                                           GVariant           **state_hint,
+                                           GVariant           **state,
+                                           gboolean             recurse);
+
+static void
+update_widget_action_enabled (GtkActionMuxer *muxer,
+                              const char     *action_name,
+                              gboolean        enabled)
+{
+  const Lookup *lookup;
+
+  if (!muxer->widget)
+    return;
+
+  lookup = gtk_action_muxer_lookup (muxer, action_name);
+  if (lookup->widget_action)
+    {
+      guint position = get_action_position (lookup->widget_action);
+      muxer->widget_actions_disabled =
+        _gtk_bitmask_set (muxer->widget_actions_disabled, position, !enabled);
+    }
+}
+
+static void
+notify_enabled_changed (GtkActionMuxer *muxer,
+                        const char     *action_name,
+                        gboolean        enabled)
 {
-  GtkWidgetAction *iter;
   Action *action;
   GSList *node;
 
-  if (muxer->widget)
+  action = find_observers (muxer, action_name);
+
+  for (node = action ? action->watchers : NULL; node; node = node->next)
+    gtk_action_observer_action_enabled_changed (node->data, GTK_ACTION_OBSERVABLE (muxer), action_name, enabled);
+}
+
+static void
+notify_state_changed (GtkActionMuxer *muxer,
+                      const char     *action_name,
+                      GVariant       *state)
+{
+  Action *action;
+  GSList *node;
+
+  action = find_observers (muxer, action_name);
+  for (node = action ? action->watchers : NULL; node; node = node->next)
+    gtk_action_observer_action_state_changed (node->data, GTK_ACTION_OBSERVABLE (muxer), action_name, state);
+}
+
+static gboolean
+gtk_action_muxer_flush_changes (gpointer data)
+{
+  GtkActionMuxer *muxer = data;
+  GHashTable *pending = muxer->pending_changes;
+  GHashTableIter iter;
+  const char *action_name;
+  gpointer changes;
+
+  muxer->pending_changes = NULL;
+  muxer->pending_changes_id = 0;
+
+  g_object_ref (muxer);
+
+  g_hash_table_iter_init (&iter, pending);
+  while (g_hash_table_iter_next (&iter, (gpointer *) &action_name, &changes))
     {
-      GtkWidgetClass *klass = GTK_WIDGET_GET_CLASS (muxer->widget);
-      GtkWidgetClassPrivate *priv = klass->priv;
+      gboolean enabled;
+      GVariant *state;
+
+      /* Observers get the current values. If the action went away
+       * in the meantime, they have been told about that already.
+       */
+      if (!action_muxer_query_action (muxer, action_name,
+                                      &enabled, NULL, NULL, NULL, &state,
+                                      FALSE))
+        continue;
 
-      for (iter = priv->actions; iter; iter = iter->next)
+      if (GPOINTER_TO_UINT (changes) & PENDING_ENABLED)
+        notify_enabled_changed (muxer, action_name, enabled);
+
+      if (state)
         {
-          if (strcmp (action_name, iter->name) == 0)
-            {
-              guint position = get_action_position (iter);
-              muxer->widget_actions_disabled =
-                _gtk_bitmask_set (muxer->widget_actions_disabled, position, !enabled);
-              break;
-            }
+          if (GPOINTER_TO_UINT (changes) & PENDING_STATE)
+            notify_state_changed (muxer, action_name, state);
+          g_variant_unref (state);
         }
     }
 
-  action = find_observers (muxer, action_name);
+  g_hash_table_unref (pending);
+  g_object_unref (muxer);
 
-  for (node = action ? action->watchers : NULL; node; node = node->next)
-    gtk_action_observer_action_enabled_changed (node->data, GTK_ACTION_OBSERVABLE (muxer), action_name, enabled);
+  return G_SOURCE_REMOVE;
+}
+
+/* Changes to the enabled state and state of actions are passed on to
+ * observers once per main loop iteration, before the next frame is
+ * laid out. Building a menu or toolbar can change the same actions
+ * many times, and every change would otherwise go through all muxers
+ * below this one and update the widgets each time.
+ */
+static void
+gtk_action_muxer_queue_change (GtkActionMuxer *muxer,
+                               const char     *action_name,
+                               guint           change)
+{
+  gpointer changes;
+
+  if (!find_observers (muxer, action_name))
+    return;
+
+  if (muxer->pending_changes == NULL)
+    {
+      muxer->pending_changes = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+      muxer->pending_changes_id = g_idle_add_full (GTK_PRIORITY_RESIZE,
+                                                   gtk_action_muxer_flush_changes,
+                                                   muxer,
+                                                   NULL);
+      g_source_set_name_by_id (muxer->pending_changes_id, "[gtk] gtk_action_muxer_flush_changes");
+    }
+
+  if (g_hash_table_lookup_extended (muxer->pending_changes, action_name, NULL, &changes))
+    g_hash_table_insert (muxer->pending_changes, g_strdup (action_name),
+                         GUINT_TO_POINTER (GPOINTER_TO_UINT (changes) | change));
+  else
+    g_hash_table_insert (muxer->pending_changes, g_strdup (action_name), GUINT_TO_POINTER (change));
+}
+
+void
+gtk_action_muxer_action_enabled_changed (GtkActionMuxer *muxer,
+                                         const char     *action_name,
+                                         gboolean        enabled)
+{
+  update_widget_action_enabled (muxer, action_name, enabled);
+  gtk_action_muxer_queue_change (muxer, action_name, PENDING_ENABLED);
 }
 
 static void
@@ -389,12 +595,7 @@ gtk_action_muxer_action_state_changed (GtkActionMuxer *muxer,
                                        const char     *action_name,
                                        GVariant       *state)
 {
-  Action *action;
-  GSList *node;
-
-  action = find_observers (muxer, action_name);
-  for (node = action ? action->watchers : NULL; node; node = node->next)
-    gtk_action_observer_action_state_changed (node->data, GTK_ACTION_OBSERVABLE (muxer), action_name, state);
+  gtk_action_muxer_queue_change (muxer, action_name, PENDING_STATE);
 }
 
 static void
@@ -411,15 +612,6 @@ gtk_action_muxer_group_action_state_changed (GActionGroup *action_group,
   g_free (fullname);
 }
 
-static gboolean action_muxer_query_action (GtkActionMuxer      *muxer,
-                                           const char          *action_name,
-                                           gboolean            *enabled,
-                                           const GVariantType **parameter_type,
-                                           const GVariantType **state_type,
-                                           GVariant           **state_hint,
-                                           GVariant           **state,
-                                           gboolean             recurse);
-
 static void
 notify_observers_added (GtkActionMuxer *muxer,
                         GtkActionMuxer *parent)
@@ -524,6 +716,8 @@ gtk_action_muxer_action_added_to_group (GActionGroup *action_group,
   GVariant *state;
   char *fullname;
 
+  gtk_action_muxer_invalidate_lookups (muxer);
+
   fullname = g_strconcat (group->prefix, ".", action_name, NULL);
 
    if (muxer->parent)
@@ -568,6 +762,8 @@ gtk_action_muxer_action_removed_from_group (GActionGroup *action_group,
   char *fullname;
   Action *action;
 
+  gtk_action_muxer_invalidate_lookups (muxer);
+
   fullname = g_strconcat (group->prefix, ".", action_name, NULL);
   gtk_action_muxer_action_removed (muxer, fullname);
   g_free (fullname);
@@ -744,52 +940,42 @@ action_muxer_query_action (GtkActionMuxer      *muxer,
                            GVariant           **state,
                            gboolean             recurse)
 {
-  GtkWidgetAction *action;
-  Group *group;
-  const char *unprefixed_name;
+  const Lookup *lookup;
 
-  if (muxer->widget)
-    {
-      GtkWidgetClass *klass = GTK_WIDGET_GET_CLASS (muxer->widget);
-      GtkWidgetClassPrivate *priv = klass->priv;
+  lookup = gtk_action_muxer_lookup (muxer, action_name);
 
-      for (action = priv->actions; action; action = action->next)
-        {
-          guint position;
+  if (lookup->widget_action)
+    {
+      GtkWidgetAction *action = lookup->widget_action;
+      guint position;
 
-          if (strcmp (action->name, action_name) != 0)
-            continue;
+      position = get_action_position (action);
 
-          position = get_action_position (action);
+      if (enabled)
+        *enabled = !_gtk_bitmask_get (muxer->widget_actions_disabled, position);
+      if (parameter_type)
+        *parameter_type = action->parameter_type;
+      if (state_type)
+        *state_type = action->state_type;
 
-          if (enabled)
-            *enabled = !_gtk_bitmask_get (muxer->widget_actions_disabled, position);
-          if (parameter_type)
-            *parameter_type = action->parameter_type;
-          if (state_type)
-            *state_type = action->state_type;
+      if (state_hint)
+        *state_hint = NULL;
+      if (state)
+        *state = NULL;
 
-          if (state_hint)
-            *state_hint = NULL;
+      if (action->pspec)
+        {
           if (state)
-            *state = NULL;
-
-          if (action->pspec)
-            {
-              if (state)
-                *state = prop_action_get_state (muxer->widget, action);
-              if (state_hint)
-                *state_hint = prop_action_get_state_hint (muxer->widget, action);
-            }
-
-          return TRUE;
+            *state = prop_action_get_state (muxer->widget, action);
+          if (state_hint)
+            *state_hint = prop_action_get_state_hint (muxer->widget, action);
         }
-    }
 
-  group = gtk_action_muxer_find_group (muxer, action_name, &unprefixed_name);
+      return TRUE;
+    }
 
-  if (group)
-    return g_action_group_query_action (group->group, unprefixed_name, enabled,
+  if (lookup->group)
+    return g_action_group_query_action (lookup->group->group, action_name + lookup->unprefixed_offset, enabled,
                                         parameter_type, state_type, state_hint, state);
 
   if (muxer->parent && recurse)
@@ -829,38 +1015,25 @@ gtk_action_muxer_activate_action (GtkActionMuxer *muxer,
                                   const char     *action_name,
                                   GVariant       *parameter)
 {
-  const char *unprefixed_name;
-  Group *group;
+  const Lookup *lookup;
 
-  if (muxer->widget)
+  lookup = gtk_action_muxer_lookup (muxer, action_name);
+
+  if (lookup->widget_action)
     {
-      GtkWidgetClass *klass = GTK_WIDGET_GET_CLASS (muxer->widget);
-      GtkWidgetClassPrivate *priv = klass->priv;
-      GtkWidgetAction *action;
+      GtkWidgetAction *action = lookup->widget_action;
+      guint position = get_action_position (action);
 
-      for (action = priv->actions; action; action = action->next)
+      if (!_gtk_bitmask_get (muxer->widget_actions_disabled, position))
         {
-          if (strcmp (action->name, action_name) == 0)
-            {
-              guint position = get_action_position (action);
-
-              if (!_gtk_bitmask_get (muxer->widget_actions_disabled, position))
-                {
-                  if (action->activate)
-                    action->activate (muxer->widget, action->name, parameter);
-                  else if (action->pspec)
-                    prop_action_activate (muxer->widget, action, parameter);
-                }
-
-              return;
-            }
+          if (action->activate)
+            action->activate (muxer->widget, action->name, parameter);
+          else if (action->pspec)
+            prop_action_activate (muxer->widget, action, parameter);
         }
     }
-
-  group = gtk_action_muxer_find_group (muxer, action_name, &unprefixed_name);
-
-  if (group)
-    g_action_group_activate_action (group->group, unprefixed_name, parameter);
+  else if (lookup->group)
+    g_action_group_activate_action (lookup->group->group, action_name + lookup->unprefixed_offset, parameter);
   else if (muxer->parent)
     gtk_action_muxer_activate_action (muxer->parent, action_name, parameter);
 }
@@ -870,31 +1043,17 @@ gtk_action_muxer_change_action_state (GtkActionMuxer *muxer,
                                       const char     *action_name,
                                       GVariant       *state)
 {
-  GtkWidgetAction *action;
-  const char *unprefixed_name;
-  Group *group;
+  const Lookup *lookup;
 
-  if (muxer->widget)
-    {
-      GtkWidgetClass *klass = GTK_WIDGET_GET_CLASS (muxer->widget);
-      GtkWidgetClassPrivate *priv = klass->priv;
+  lookup = gtk_action_muxer_lookup (muxer, action_name);
 
-      for (action = priv->actions; action; action = action->next)
-        {
-          if (strcmp (action->name, action_name) == 0)
-            {
-              if (action->pspec)
-                prop_action_set_state (muxer->widget, action, state);
-
-              return;
-            }
-        }
+  if (lookup->widget_action)
+    {
+      if (lookup->widget_action->pspec)
+        prop_action_set_state (muxer->widget, lookup->widget_action, state);
     }
-
-  group = gtk_action_muxer_find_group (muxer, action_name, &unprefixed_name);
-
-  if (group)
-    g_action_group_change_action_state (group->group, unprefixed_name, state);
+  else if (lookup->group)
+    g_action_group_change_action_state (lookup->group->group, action_name + lookup->unprefixed_offset, state);
   else if (muxer->parent)
     gtk_action_muxer_change_action_state (muxer->parent, action_name, state);
 }
@@ -1046,6 +1205,8 @@ gtk_action_muxer_finalize (GObject *object)
     }
   if (muxer->groups)
     g_hash_table_unref (muxer->groups);
+  if (muxer->lookups)
+    g_hash_table_unref (muxer->lookups);
 
   gtk_accels_clear (&muxer->primary_accels);
 
@@ -1063,7 +1224,11 @@ gtk_action_muxer_dispose (GObject *object)
   if (muxer->observed_actions)
     g_hash_table_remove_all (muxer->observed_actions);
 
+  g_clear_handle_id (&muxer->pending_changes_id, g_source_remove);
+  g_clear_pointer (&muxer->pending_changes, g_hash_table_unref);
+
   muxer->widget = NULL;
+  gtk_action_muxer_invalidate_lookups (muxer);
 
   G_OBJECT_CLASS (gtk_action_muxer_parent_class)->dispose (object);
 }
@@ -1163,7 +1328,11 @@ gtk_action_muxer_observer_action_enabled_changed (GtkActionObserver   *observer,
                                                   const char          *action_name,
                                                   gboolean             enabled)
 {
-  gtk_action_muxer_action_enabled_changed (GTK_ACTION_MUXER (observer), action_name, enabled);
+  GtkActionMuxer *muxer = GTK_ACTION_MUXER (observer);
+
+  /* The change was queued by the muxer that owns the action already */
+  update_widget_action_enabled (muxer, action_name, enabled);
+  notify_enabled_changed (muxer, action_name, enabled);
 }
 
 static void
@@ -1172,7 +1341,7 @@ gtk_action_muxer_observer_action_state_changed (GtkActionObserver   *observer,
                                                 const char          *action_name,
                                                 GVariant            *state)
 {
-  gtk_action_muxer_action_state_changed (GTK_ACTION_MUXER (observer), action_name, state);
+  notify_state_changed (GTK_ACTION_MUXER (observer), action_name, state);
 }
 
 static void
@@ -1261,6 +1430,7 @@ gtk_action_muxer_insert (GtkActionMuxer *muxer,
   group->prefix = g_strdup (prefix);
 
   g_hash_table_insert (muxer->groups, group->prefix, group);
+  gtk_action_muxer_invalidate_lookups (muxer);
 
   actions = g_action_group_list_actions (group->group);
   for (i = 0; actions[i]; i++)
@@ -1304,6 +1474,7 @@ gtk_action_muxer_remove (GtkActionMuxer *muxer,
       int i;
 
       g_hash_table_steal (muxer->groups, prefix);
+      gtk_action_muxer_invalidate_lookups (muxer);
 
       actions = g_action_group_list_actions (group->group);
       for (i = 0; actions[i]; i++)
@@ -670,17 +670,50 @@ gtk_at_context_unrealize (GtkATContext *self)
     return;
 
   GTK_NOTE (A11Y, g_message ("Unrealizing AT context '%s'", G_OBJECT_TYPE_NAME (self)));
+  g_clear_handle_id (&self->update_id, g_source_remove);
   GTK_AT_CONTEXT_GET_CLASS (self)->unrealize (self);
 
   self->realized = FALSE;
 }
 
+static gboolean
+gtk_at_context_flush_update (gpointer data)
+{
+  GtkATContext *self = data;
+
+  self->update_id = 0;
+
+  /* There's no point in notifying of state changes if there weren't any */
+  if (self->updated_properties == 0 &&
+      self->updated_relations == 0 &&
+      self->updated_states == 0)
+    return G_SOURCE_REMOVE;
+
+  GTK_AT_CONTEXT_GET_CLASS (self)->state_change (self,
+                                                 self->updated_states,
+                                                 self->updated_properties,
+                                                 self->updated_relations,
+                                                 self->states, self->properties, self->relations);
+  g_signal_emit (self, obj_signals[STATE_CHANGE], 0);
+
+  self->updated_properties = 0;
+  self->updated_relations = 0;
+  self->updated_states = 0;
+
+  return G_SOURCE_REMOVE;
+}
+
 /*< private >
  * gtk_at_context_update:
  * @self: a #GtkATContext
  *
  * Notifies the AT connected to this #GtkATContext that the accessible
  * state and its properties have changed.
+ *
+ * The notification is deferred to an idle, so that widgets updating
+ * their state many times in a row, like a progress bar tracking a
+ * download, cause a single notification containing only the attributes
+ * that changed in the meantime, with their latest values.
  */
 void
 gtk_at_context_update (GtkATContext *self)
@@ -696,21 +729,14 @@ gtk_at_context_update (GtkATContext *self)
       self->updated_states == 0)
     return;
 
-  GtkAccessibleStateChange changed_states =
-    gtk_accessible_attribute_set_get_changed (self->states);
-  GtkAccessiblePropertyChange changed_properties =
-    gtk_accessible_attribute_set_get_changed (self->properties);
-  GtkAccessibleRelationChange changed_relations =
-    gtk_accessible_attribute_set_get_changed (self->relations);
-
-  GTK_AT_CONTEXT_GET_CLASS (self)->state_change (self,
-                                                 changed_states, changed_properties, changed_relations,
-                                                 self->states, self->properties, self->relations);
-  g_signal_emit (self, obj_signals[STATE_CHANGE], 0);
+  if (self->update_id != 0)
+    return;
 
-  self->updated_properties = 0;
-  self->updated_relations = 0;
-  self->updated_states = 0;
+  self->update_id = g_idle_add_full (G_PRIORITY_HIGH_IDLE,
+                                     gtk_at_context_flush_update,
+                                     self,
+                                     NULL);
+  g_source_set_name_by_id (self->update_id, "[gtk] gtk_at_context_flush_update");
 }
 
 /*< private >
@@ -1173,7 +1199,15 @@ gtk_at_context_platform_changed (GtkATContext                *self,
                                  GtkAccessiblePlatformChange  change)
 {
   if (!self->realized)
-    return;
+    {
+      /* Contexts are realized lazily, but focus changes are how
+       * ATs find out about widgets they haven't looked at yet
+       */
+      if ((change & GTK_ACCESSIBLE_PLATFORM_CHANGE_FOCUSED) == 0)
+        return;
+
+      gtk_at_context_realize (self);
+    }
 
   GTK_AT_CONTEXT_GET_CLASS (self)->platform_change (self, change);
 }
@@ -117,6 +117,8 @@ struct _GtkATContext
   GtkAccessibleRelationChange updated_relations;
   GtkAccessiblePlatformChange updated_platform;
 
+  guint update_id;
+
   guint realized : 1;
 };
 
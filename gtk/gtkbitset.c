@@ -327,6 +327,73 @@ gtk_bitset_copy (const GtkBitset *self)
   return copy;
 }
 
+/**
+ * gtk_bitset_serialize:
+ * @self: a #GtkBitset
+ *
+ * Serializes @self into the portable format of roaring bitmaps.
+ *
+ * The format is compact even for large sets, so this is a cheap way
+ * to store a selection or pass it to another process. Use
+ * gtk_bitset_deserialize() to get the bitset back.
+ *
+ * Returns: (transfer full): the serialized bitset
+ **/
+GBytes *
+gtk_bitset_serialize (const GtkBitset *self)
+{
+  gsize size;
+  char *data;
+
+  g_return_val_if_fail (self != NULL, NULL);
+
+  size = roaring_bitmap_portable_size_in_bytes (&self->roaring);
+  data = g_malloc (size);
+  roaring_bitmap_portable_serialize (&self->roaring, data);
+
+  return g_bytes_new_take (data, size);
+}
+
+/**
+ * gtk_bitset_deserialize:
+ * @bytes: data created with gtk_bitset_serialize()
+ *
+ * Creates a bitset from data created with gtk_bitset_serialize().
+ *
+ * Returns: (nullable) (transfer full): A new bitset or %NULL if @bytes
+ *     does not contain a serialized bitset
+ **/
+GtkBitset *
+gtk_bitset_deserialize (GBytes *bytes)
+{
+  GtkBitset *self;
+  const char *data;
+  gsize size, read;
+
+  g_return_val_if_fail (bytes != NULL, NULL);
+
+  data = g_bytes_get_data (bytes, &size);
+
+  self = g_slice_new0 (GtkBitset);
+  self->ref_count = 1;
+
+  if (!ra_portable_deserialize (&self->roaring.high_low_container, data, size, &read))
+    {
+      g_slice_free (GtkBitset, self);
+      return NULL;
+    }
+
+  roaring_bitmap_set_copy_on_write (&self->roaring, false);
+
+  if (read != size)
+    {
+      gtk_bitset_unref (self);
+      return NULL;
+    }
+
+  return self;
+}
+
 /**
  * gtk_bitset_remove_all:
  * @self: a #GtkBitset
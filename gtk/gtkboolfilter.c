@@ -21,6 +21,8 @@
 
 #include "gtkboolfilter.h"
 
+#include "gtkexpressionprivate.h"
+#include "gtkfilterprivate.h"
 #include "gtkintl.h"
 #include "gtktypebuiltins.h"
 
@@ -184,6 +186,7 @@ gtk_bool_filter_class_init (GtkBoolFilterClass *class)
 static void
 gtk_bool_filter_init (GtkBoolFilter *self)
 {
+  gtk_filter_set_thread_safe (GTK_FILTER (self), TRUE);
 }
 
 /**
@@ -248,6 +251,7 @@ gtk_bool_filter_set_expression (GtkBoolFilter *self,
   g_clear_pointer (&self->expression, gtk_expression_unref);
   if (expression)
     self->expression = gtk_expression_ref (expression);
+  gtk_filter_set_thread_safe (GTK_FILTER (self), gtk_expression_is_thread_safe (expression));
 
   gtk_filter_changed (GTK_FILTER (self), GTK_FILTER_CHANGE_DIFFERENT);
 
@@ -88,6 +88,13 @@
  * parts of the UI definition. GTK reserves ids starting and ending
  * with `___` (three consecutive underscores) for its own purposes.
  *
+ * Toplevel objects that are not always needed, such as dialogs or
+ * menus, can be given a “lazy” attribute with a true value. Such
+ * objects are not constructed when the UI definition is loaded, but
+ * only the first time they are requested with gtk_builder_get_object().
+ * Lazy objects must have an id, and they can not be referred to from
+ * other parts of the UI definition.
+ *
  * Setting properties of objects is pretty straightforward with the
  * <property> element: the “name” attribute specifies the name of the
  * property, and the content of the element specifies the value.
@@ -267,6 +274,8 @@ typedef struct
   GType template_type;
   GObject *current_object;
   GtkBuilderScope *scope;
+  GHashTable *lazy_objects;
+  GtkBuilderParseCache *parse_cache;
 } GtkBuilderPrivate;
 
 G_DEFINE_TYPE_WITH_PRIVATE (GtkBuilder, gtk_builder, G_TYPE_OBJECT)
@@ -375,6 +384,7 @@ gtk_builder_finalize (GObject *object)
 #endif
 
   g_hash_table_destroy (priv->objects);
+  g_clear_pointer (&priv->lazy_objects, g_hash_table_destroy);
 
   g_slist_free_full (priv->signals, (GDestroyNotify)_free_signal_info);
 
@@ -451,6 +461,13 @@ typedef struct
   int col;
 } DelayedProperty;
 
+typedef struct
+{
+  GBytes *bytes;
+  char *filename;
+  char *resource_prefix;
+} LazyObject;
+
 typedef struct
 {
   GPtrArray *names;
@@ -689,6 +706,115 @@ _gtk_builder_add_object (GtkBuilder  *builder,
   g_hash_table_insert (priv->objects, g_strdup (id), g_object_ref (object));
 }
 
+static void
+lazy_object_free (LazyObject *lazy)
+{
+  g_bytes_unref (lazy->bytes);
+  g_free (lazy->filename);
+  g_free (lazy->resource_prefix);
+  g_slice_free (LazyObject, lazy);
+}
+
+/*< private >
+ * @builder: a #GtkBuilder
+ * @id: the id of a toplevel object marked as lazy
+ * @bytes: the UI definition containing the object
+ *
+ * Remembers where to find the object with @id, so that
+ * gtk_builder_get_object() can construct it on first use.
+ */
+void
+_gtk_builder_add_lazy_object (GtkBuilder *builder,
+                              const char *id,
+                              GBytes     *bytes)
+{
+  GtkBuilderPrivate *priv = gtk_builder_get_instance_private (builder);
+  LazyObject *lazy;
+
+  if (priv->lazy_objects == NULL)
+    priv->lazy_objects = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                                g_free, (GDestroyNotify)lazy_object_free);
+
+  lazy = g_slice_new (LazyObject);
+  lazy->bytes = g_bytes_ref (bytes);
+  lazy->filename = g_strdup (priv->filename);
+  lazy->resource_prefix = g_strdup (priv->resource_prefix);
+
+  g_hash_table_insert (priv->lazy_objects, g_strdup (id), lazy);
+}
+
+/*< private >
+ * @builder: a #GtkBuilder
+ * @cache: (nullable): a cache for the precompiled buffer that
+ *   will be parsed, owned by the caller
+ *
+ * Makes @builder use @cache when it parses the buffer that @cache
+ * was created for. The cache must outlive the parsing.
+ */
+void
+_gtk_builder_set_parse_cache (GtkBuilder           *builder,
+                              GtkBuilderParseCache *cache)
+{
+  GtkBuilderPrivate *priv = gtk_builder_get_instance_private (builder);
+
+  priv->parse_cache = cache;
+}
+
+GtkBuilderParseCache *
+_gtk_builder_get_parse_cache (GtkBuilder *builder)
+{
+  GtkBuilderPrivate *priv = gtk_builder_get_instance_private (builder);
+
+  return priv->parse_cache;
+}
+
+static GObject *
+gtk_builder_construct_lazy_object (GtkBuilder *builder,
+                                   const char *name)
+{
+  GtkBuilderPrivate *priv = gtk_builder_get_instance_private (builder);
+  const char *object_ids[2];
+  LazyObject *lazy;
+  char *id;
+  char *filename;
+  char *resource_prefix;
+  GError *error = NULL;
+
+  if (!g_hash_table_steal_extended (priv->lazy_objects, name,
+                                    (gpointer *)&id, (gpointer *)&lazy))
+    return NULL;
+
+  filename = g_steal_pointer (&priv->filename);
+  resource_prefix = g_steal_pointer (&priv->resource_prefix);
+  priv->filename = g_strdup (lazy->filename);
+  priv->resource_prefix = g_strdup (lazy->resource_prefix);
+
+  object_ids[0] = id;
+  object_ids[1] = NULL;
+
+  _gtk_builder_parser_parse_buffer (builder, lazy->filename,
+                                    g_bytes_get_data (lazy->bytes, NULL),
+                                    g_bytes_get_size (lazy->bytes),
+                                    object_ids,
+                                    &error);
+
+  if (error)
+    {
+      g_warning ("Failed to construct object '%s': %s", id, error->message);
+      g_error_free (error);
+    }
+
+  g_free (priv->filename);
+  g_free (priv->resource_prefix);
+  priv->filename = filename;
+  priv->resource_prefix = resource_prefix;
+
+  g_free (id);
+  lazy_object_free (lazy);
+
+  return g_hash_table_lookup (priv->objects, name);
+}
+
 static void
 gtk_builder_take_bindings (GtkBuilder *builder,
                            GObject    *target,
@@ -874,6 +1000,13 @@ _gtk_builder_construct (GtkBuilder  *builder,
         custom_set_property = TRUE;
     }
 
+  /* Emit the notifications for all properties in one go, and only
+   * once for properties that get changed again as a side effect of
+   * setting others.
+   */
+  if (parameters.len > 1)
+    g_object_freeze_notify (obj);
+
   for (i = 0; i < parameters.len; i++)
     {
       const char *name = object_properties_get_name (&parameters, i);
@@ -893,6 +1026,10 @@ _gtk_builder_construct (GtkBuilder  *builder,
         }
 #endif
     }
+
+  if (parameters.len > 1)
+    g_object_thaw_notify (obj);
+
   object_properties_destroy (&parameters);
 
   if (info->bindings)
@@ -942,6 +1079,9 @@ _gtk_builder_apply_properties (GtkBuilder  *builder,
         custom_set_property = TRUE;
     }
 
+  if (parameters.len > 1)
+    g_object_freeze_notify (info->object);
+
   for (i = 0; i < parameters.len; i++)
     {
       const char *name = object_properties_get_name (&parameters, i);
@@ -960,6 +1100,10 @@ _gtk_builder_apply_properties (GtkBuilder  *builder,
         }
 #endif
     }
+
+  if (parameters.len > 1)
+    g_object_thaw_notify (info->object);
+
   object_properties_destroy (&parameters);
 }
 
@@ -1627,6 +1771,9 @@ gtk_builder_add_objects_from_string (GtkBuilder   *builder,
  * Gets the object named @name. Note that this function does not
  * increment the reference count of the returned object.
  *
+ * If @name refers to an object that was marked as lazy in the
+ * UI definition, it is constructed by this call.
+ *
  * Returns: (nullable) (transfer none): the object named @name or %NULL if
  *    it could not be found in the object tree.
  **/
@@ -1636,10 +1783,16 @@ gtk_builder_get_object (GtkBuilder  *builder,
 {
   GtkBuilderPrivate *priv = gtk_builder_get_instance_private (builder);
 
+  GObject *object;
+
   g_return_val_if_fail (GTK_IS_BUILDER (builder), NULL);
   g_return_val_if_fail (name != NULL, NULL);
 
-  return g_hash_table_lookup (priv->objects, name);
+  object = g_hash_table_lookup (priv->objects, name);
+  if (object == NULL && priv->lazy_objects != NULL)
+    object = gtk_builder_construct_lazy_object (builder, name);
+
+  return object;
 }
 
 /**
@@ -1648,7 +1801,8 @@ gtk_builder_get_object (GtkBuilder  *builder,
  *
  * Gets all objects that have been constructed by @builder. Note that
  * this function does not increment the reference counts of the returned
- * objects.
+ * objects. Lazy objects that have not been requested yet are not
+ * included.
  *
  * Returns: (element-type GObject) (transfer container): a newly-allocated #GSList containing all the objects
  *   constructed by the #GtkBuilder instance. It should be freed by
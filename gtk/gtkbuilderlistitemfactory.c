@@ -63,6 +63,7 @@ struct _GtkBuilderListItemFactory
   GtkBuilderScope *scope;
   GBytes *bytes;
   GBytes *data;
+  GtkBuilderParseCache *cache;
   char *resource;
 };
 
@@ -101,6 +102,12 @@ gtk_builder_list_item_factory_setup (GtkListItemFactory *factory,
   if (self->scope)
     gtk_builder_set_scope (builder, self->scope);
 
+  if (self->cache == NULL &&
+      _gtk_buildable_parser_is_precompiled (g_bytes_get_data (self->data, NULL),
+                                            g_bytes_get_size (self->data)))
+    self->cache = _gtk_builder_parse_cache_new (self->data);
+  _gtk_builder_set_parse_cache (builder, self->cache);
+
   if (!gtk_builder_extend_with_template (builder, G_OBJECT (list_item), G_OBJECT_TYPE (list_item),
                                          (const char *)g_bytes_get_data (self->data, NULL),
                                          g_bytes_get_size (self->data),
@@ -242,6 +249,7 @@ gtk_builder_list_item_factory_finalize (GObject *object)
   g_clear_object (&self->scope);
   g_bytes_unref (self->bytes);
   g_bytes_unref (self->data);
+  g_clear_pointer (&self->cache, _gtk_builder_parse_cache_free);
   g_free (self->resource);
 
   G_OBJECT_CLASS (gtk_builder_list_item_factory_parent_class)->finalize (object);
@@ -544,6 +544,151 @@ is_requested_object (const char *object,
   return FALSE;
 }
 
+/* A cache of type and property lookups for a precompiled buffer.
+ *
+ * Strings in precompiled data are interned, so as long as the buffer
+ * is alive, the same string pointer always means the same type or
+ * property name. That lets us key the cache on the pointers alone,
+ * which makes replaying the same template over and over (as list item
+ * factories do for every row) skip most of the name lookups.
+ */
+struct _GtkBuilderParseCache
+{
+  GBytes *bytes;
+  GHashTable *types;   /* const char * -> GType */
+  GHashTable *pspecs;  /* CacheKey -> GParamSpec */
+  GHashTable *signals; /* CacheKey -> CachedSignal */
+};
+
+typedef struct
+{
+  GObjectClass *oclass;
+  const char *name;
+} CacheKey;
+
+typedef struct
+{
+  guint id;
+  GQuark detail;
+} CachedSignal;
+
+static guint
+cache_key_hash (gconstpointer v)
+{
+  const CacheKey *key = v;
+
+  return g_direct_hash (key->oclass) ^ g_direct_hash (key->name);
+}
+
+static gboolean
+cache_key_equal (gconstpointer v1,
+                 gconstpointer v2)
+{
+  const CacheKey *key1 = v1;
+  const CacheKey *key2 = v2;
+
+  return key1->oclass == key2->oclass && key1->name == key2->name;
+}
+
+GtkBuilderParseCache *
+_gtk_builder_parse_cache_new (GBytes *bytes)
+{
+  GtkBuilderParseCache *cache;
+
+  cache = g_slice_new (GtkBuilderParseCache);
+  cache->bytes = g_bytes_ref (bytes);
+  cache->types = g_hash_table_new (NULL, NULL);
+  cache->pspecs = g_hash_table_new_full (cache_key_hash, cache_key_equal,
+                                         g_free, NULL);
+  cache->signals = g_hash_table_new_full (cache_key_hash, cache_key_equal,
+                                          g_free, g_free);
+
+  return cache;
+}
+
+void
+_gtk_builder_parse_cache_free (GtkBuilderParseCache *cache)
+{
+  g_bytes_unref (cache->bytes);
+  g_hash_table_unref (cache->types);
+  g_hash_table_unref (cache->pspecs);
+  g_hash_table_unref (cache->signals);
+  g_slice_free (GtkBuilderParseCache, cache);
+}
+
+static GType
+lookup_type (ParserData *data,
+             const char *type_name)
+{
+  GType type;
+
+  if (data->cache == NULL)
+    return gtk_builder_get_type_from_name (data->builder, type_name);
+
+  type = GPOINTER_TO_SIZE (g_hash_table_lookup (data->cache->types, type_name));
+  if (type == G_TYPE_INVALID)
+    {
+      type = gtk_builder_get_type_from_name (data->builder, type_name);
+      if (type != G_TYPE_INVALID)
+        g_hash_table_insert (data->cache->types, (gpointer) type_name, GSIZE_TO_POINTER (type));
+    }
+
+  return type;
+}
+
+static GParamSpec *
+lookup_property (ParserData   *data,
+                 GObjectClass *oclass,
+                 const char   *name)
+{
+  CacheKey key = { oclass, name };
+  GParamSpec *pspec;
+
+  if (data->cache == NULL)
+    return g_object_class_find_property (oclass, name);
+
+  pspec = g_hash_table_lookup (data->cache->pspecs, &key);
+  if (pspec == NULL)
+    {
+      pspec = g_object_class_find_property (oclass, name);
+      if (pspec != NULL)
+        g_hash_table_insert (data->cache->pspecs, g_memdup (&key, sizeof (key)), pspec);
+    }
+
+  return pspec;
+}
+
+static gboolean
+lookup_signal (ParserData *data,
+               ObjectInfo *object_info,
+               const char *name,
+               guint      *id,
+               GQuark     *detail)
+{
+  CacheKey key = { object_info->oclass, name };
+  CachedSignal *signal;
+
+  if (data->cache == NULL)
+    return g_signal_parse_name (name, object_info->type, id, detail, FALSE);
+
+  signal = g_hash_table_lookup (data->cache->signals, &key);
+  if (signal == NULL)
+    {
+      if (!g_signal_parse_name (name, object_info->type, id, detail, FALSE))
+        return FALSE;
+
+      signal = g_new (CachedSignal, 1);
+      signal->id = *id;
+      signal->detail = *detail;
+      g_hash_table_insert (data->cache->signals, g_memdup (&key, sizeof (key)), signal);
+    }
+
+  *id = signal->id;
+  *detail = signal->detail;
+
+  return TRUE;
+}
+
 static void
 parse_object (GtkBuildableParseContext  *context,
               ParserData                *data,
@@ -559,6 +704,7 @@ parse_object (GtkBuildableParseContext  *context,
   const char *constructor = NULL;
   const char *type_func = NULL;
   const char *object_id = NULL;
+  gboolean lazy = FALSE;
   char *internal_id = NULL;
   int line;
 
@@ -580,6 +726,7 @@ parse_object (GtkBuildableParseContext  *context,
                                     G_MARKUP_COLLECT_STRING|G_MARKUP_COLLECT_OPTIONAL, "constructor", &constructor,
                                     G_MARKUP_COLLECT_STRING|G_MARKUP_COLLECT_OPTIONAL, "type-func", &type_func,
                                     G_MARKUP_COLLECT_STRING|G_MARKUP_COLLECT_OPTIONAL, "id", &object_id,
+                                    G_MARKUP_COLLECT_BOOLEAN|G_MARKUP_COLLECT_OPTIONAL, "lazy", &lazy,
                                     G_MARKUP_COLLECT_INVALID))
     {
       _gtk_builder_prefix_error (data->builder, &data->ctx, error);
@@ -612,7 +759,7 @@ parse_object (GtkBuildableParseContext  *context,
     {
       g_assert_nonnull (object_class);
 
-      object_type = gtk_builder_get_type_from_name (data->builder, object_class);
+      object_type = lookup_type (data, object_class);
       if (object_type == G_TYPE_INVALID)
         {
           g_set_error (error,
@@ -652,6 +799,26 @@ parse_object (GtkBuildableParseContext  *context,
         }
     }
 
+  /* Lazy toplevels are skipped entirely, and replayed from the
+   * same buffer as a requested object when they are first asked
+   * for with gtk_builder_get_object().
+   */
+  if (lazy && !internal_id && !data->requested_objects &&
+      data->cur_object_level == 1)
+    {
+      if (!data->bytes)
+        data->bytes = g_bytes_new (data->buffer, data->length);
+
+      _gtk_builder_add_lazy_object (data->builder, object_id, data->bytes);
+
+      gtk_buildable_parse_context_get_position (context, &line, NULL);
+      g_hash_table_insert (data->object_ids, g_strdup (object_id), GINT_TO_POINTER (line));
+
+      data->lazy_object_level = data->cur_object_level;
+      data->inside_requested_object = FALSE;
+      return;
+    }
+
   object_info = g_slice_new0 (ObjectInfo);
   object_info->tag_type = TAG_OBJECT;
   object_info->type = object_type;
@@ -885,7 +1052,7 @@ parse_property (ParserData   *data,
       return;
     }
 
-  pspec = g_object_class_find_property (object_info->oclass, name);
+  pspec = lookup_property (data, object_info->oclass, name);
 
   if (!pspec)
     {
@@ -977,7 +1144,7 @@ parse_binding (ParserData   *data,
       return;
     }
 
-  pspec = g_object_class_find_property (object_info->oclass, name);
+  pspec = lookup_property (data, object_info->oclass, name);
 
   if (!pspec)
     {
@@ -1482,7 +1649,7 @@ parse_signal (ParserData   *data,
       return;
     }
 
-  if (!g_signal_parse_name (name, object_info->type, &id, &detail, FALSE))
+  if (!lookup_signal (data, object_info, name, &id, &detail))
     {
       g_set_error (error,
                    GTK_BUILDER_ERROR,
@@ -1779,7 +1946,7 @@ start_element (GtkBuildableParseContext  *context,
 
   if (strcmp (element_name, "object") == 0)
     parse_object (context, data, element_name, names, values, error);
-  else if (data->requested_objects && !data->inside_requested_object)
+  else if (!data->inside_requested_object)
     {
       /* If outside a requested object, simply ignore this tag */
     }
@@ -1846,9 +2013,20 @@ end_element (GtkBuildableParseContext  *context,
       return;
     }
 
-  if (data->requested_objects && !data->inside_requested_object)
+  if (!data->inside_requested_object)
     {
       /* If outside a requested object, simply ignore this tag */
+      if (data->lazy_object_level > 0 &&
+          strcmp (element_name, "object") == 0)
+        {
+          if (data->cur_object_level == data->lazy_object_level)
+            {
+              data->lazy_object_level = 0;
+              data->inside_requested_object = TRUE;
+            }
+
+          --data->cur_object_level;
+        }
     }
   else if (strcmp (element_name, "property") == 0)
     {
@@ -2183,6 +2361,15 @@ _gtk_builder_parser_parse_buffer (GtkBuilder   *builder,
   memset (&data, 0, sizeof (ParserData));
   data.builder = builder;
   data.filename = filename;
+  data.buffer = buffer;
+  data.length = length < 0 ? strlen (buffer) : length;
+
+  /* The cache is keyed on string pointers, so it is only valid
+   * for the buffer it was created for.
+   */
+  data.cache = _gtk_builder_get_parse_cache (builder);
+  if (data.cache && buffer != g_bytes_get_data (data.cache->bytes, NULL))
+    data.cache = NULL;
   data.domain = g_strdup (domain);
   data.object_ids = g_hash_table_new_full (g_str_hash, g_str_equal,
                                            (GDestroyNotify)g_free, NULL);
@@ -2242,6 +2429,7 @@ _gtk_builder_parser_parse_buffer (GtkBuilder   *builder,
   g_slist_free (data.finalizers);
   g_free (data.domain);
   g_hash_table_destroy (data.object_ids);
+  g_clear_pointer (&data.bytes, g_bytes_unref);
   gtk_buildable_parse_context_free (&data.ctx);
 
   /* restore the original domain */
@@ -169,6 +169,8 @@ typedef struct {
   GObject *child;
 } SubParser;
 
+typedef struct _GtkBuilderParseCache GtkBuilderParseCache;
+
 typedef struct {
   const char *last_element;
   GtkBuilder *builder;
@@ -177,6 +179,9 @@ typedef struct {
   SubParser *subparser;
   GtkBuildableParseContext ctx;
   const char *filename;
+  const char *buffer;
+  gsize length;
+  GBytes *bytes;
   GSList *finalizers;
   GSList *custom_finalizers;
 
@@ -184,10 +189,13 @@ typedef struct {
   gboolean inside_requested_object;
   int requested_object_level;
   int cur_object_level;
+  int lazy_object_level;
 
   int object_counter;
 
   GHashTable *object_ids;
+
+  GtkBuilderParseCache *cache;
 } ParserData;
 
 typedef GType (*GTypeGetFunc) (void);
@@ -202,6 +210,11 @@ gboolean _gtk_buildable_parser_replay_precompiled (GtkBuildableParseContext *con
                                                    const char           *data,
                                                    gssize                data_len,
                                                    GError              **error);
+GtkBuilderParseCache * _gtk_builder_parse_cache_new  (GBytes               *bytes);
+void                   _gtk_builder_parse_cache_free (GtkBuilderParseCache *cache);
+void                   _gtk_builder_set_parse_cache  (GtkBuilder           *builder,
+                                                      GtkBuilderParseCache *cache);
+GtkBuilderParseCache * _gtk_builder_get_parse_cache  (GtkBuilder           *builder);
 void _gtk_builder_parser_parse_buffer (GtkBuilder *builder,
                                        const char *filename,
                                        const char *buffer,
@@ -217,6 +230,9 @@ void      _gtk_builder_apply_properties (GtkBuilder *builder,
 void      _gtk_builder_add_object (GtkBuilder  *builder,
                                    const char *id,
                                    GObject     *object);
+void      _gtk_builder_add_lazy_object (GtkBuilder *builder,
+                                        const char *id,
+                                        GBytes     *bytes);
 void      _gtk_builder_add (GtkBuilder *builder,
                             ChildInfo *child_info);
 void      _gtk_builder_add_signals (GtkBuilder *builder,
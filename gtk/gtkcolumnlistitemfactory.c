@@ -102,6 +102,11 @@ gtk_column_list_item_factory_update (GtkListItemFactory *factory,
        child;
        child = gtk_widget_get_next_sibling (child))
     {
+      /* cells of columns that are scrolled out of view stay unbound */
+      if (GTK_IS_COLUMN_VIEW_CELL (child) &&
+          !gtk_column_view_column_get_in_view (gtk_column_view_cell_get_column (GTK_COLUMN_VIEW_CELL (child))))
+        continue;
+
       gtk_list_item_widget_update (GTK_LIST_ITEM_WIDGET (child), position, item, selected);
     }
 }
@@ -143,8 +148,9 @@ gtk_column_list_item_factory_add_column (GtkColumnListItemFactory *factory,
 
   cell = gtk_column_view_cell_new (column);
   gtk_list_item_widget_add_child (GTK_LIST_ITEM_WIDGET (list_item), GTK_WIDGET (cell));
-  gtk_list_item_widget_update (GTK_LIST_ITEM_WIDGET (cell),
-                               gtk_list_item_widget_get_position (list_item),
-                               gtk_list_item_widget_get_item (list_item),
-                               gtk_list_item_widget_get_selected (list_item));
+  if (gtk_column_view_column_get_in_view (column))
+    gtk_list_item_widget_update (GTK_LIST_ITEM_WIDGET (cell),
+                                 gtk_list_item_widget_get_position (list_item),
+                                 gtk_list_item_widget_get_item (list_item),
+                                 gtk_list_item_widget_get_selected (list_item));
 }
@@ -411,6 +411,33 @@ gtk_column_view_allocate_columns (GtkColumnView *self,
   return x;
 }
 
+/* Only columns near the visible area get bound cells. Including
+ * one page on either side avoids rebinding on every small scroll. */
+static void
+gtk_column_view_update_columns_in_view (GtkColumnView *self,
+                                        int            x,
+                                        int            width)
+{
+  guint i, n;
+
+  n = g_list_model_get_n_items (G_LIST_MODEL (self->columns));
+
+  for (i = 0; i < n; i++)
+    {
+      GtkColumnViewColumn *column;
+      int col_x, col_size;
+
+      column = g_list_model_get_item (G_LIST_MODEL (self->columns), i);
+      gtk_column_view_column_get_allocation (column, &col_x, &col_size);
+
+      gtk_column_view_column_set_in_view (column,
+                                          col_x + col_size > x - width &&
+                                          col_x < x + 2 * width);
+
+      g_object_unref (column);
+    }
+}
+
 static void
 gtk_column_view_allocate (GtkWidget *widget,
                           int        width,
@@ -422,6 +449,7 @@ gtk_column_view_allocate (GtkWidget *widget,
 
   x = gtk_adjustment_get_value (self->hadjustment);
   full_width = gtk_column_view_allocate_columns (self, width);
+  gtk_column_view_update_columns_in_view (self, x, width);
 
   gtk_widget_measure (self->header, GTK_ORIENTATION_VERTICAL, full_width, &min, &nat, NULL, NULL);
   if (gtk_scrollable_get_vscroll_policy (GTK_SCROLLABLE (self->listview)) == GTK_SCROLL_MINIMUM)
@@ -70,9 +70,14 @@ struct _GtkColumnViewColumn
 
   int fixed_width;
 
+  /* size of the cells when they were last measured in view */
+  int cell_minimum;
+  int cell_natural;
+
   guint visible     : 1;
   guint resizable   : 1;
   guint expand      : 1;
+  guint in_view     : 1;
 
   GMenuModel *menu;
 
@@ -351,6 +356,7 @@ gtk_column_view_column_init (GtkColumnViewColumn *self)
   self->resizable = FALSE;
   self->expand = FALSE;
   self->fixed_width = -1;
+  self->in_view = TRUE;
 }
 
 /**
@@ -403,6 +409,7 @@ gtk_column_view_column_add_cell (GtkColumnViewColumn *self,
   self->first_cell = cell;
 
   gtk_widget_set_visible (GTK_WIDGET (cell), self->visible);
+  gtk_widget_set_child_visible (GTK_WIDGET (cell), self->in_view);
   gtk_column_view_column_queue_resize (self);
 }
 
@@ -463,18 +470,29 @@ gtk_column_view_column_measure (GtkColumnViewColumn *self,
           nat = 0;
         }
 
-      for (cell = self->first_cell; cell; cell = gtk_column_view_cell_get_next (cell))
+      if (self->in_view)
         {
-          gtk_widget_measure (GTK_WIDGET (cell),
-                              GTK_ORIENTATION_HORIZONTAL,
-                              -1,
-                              &cell_min, &cell_nat,
-                              NULL, NULL);
-
-          min = MAX (min, cell_min);
-          nat = MAX (nat, cell_nat);
+          self->cell_minimum = 0;
+          self->cell_natural = 0;
+
+          for (cell = self->first_cell; cell; cell = gtk_column_view_cell_get_next (cell))
+            {
+              gtk_widget_measure (GTK_WIDGET (cell),
+                                  GTK_ORIENTATION_HORIZONTAL,
+                                  -1,
+                                  &cell_min, &cell_nat,
+                                  NULL, NULL);
+
+              self->cell_minimum = MAX (self->cell_minimum, cell_min);
+              self->cell_natural = MAX (self->cell_natural, cell_nat);
+            }
         }
 
+      /* Cells of columns that are scrolled out of view are unbound,
+       * keep the size they had so that the column doesn't shrink */
+      min = MAX (min, self->cell_minimum);
+      nat = MAX (nat, self->cell_natural);
+
       self->minimum_size_request = min;
       self->natural_size_request = nat;
     }
@@ -493,6 +511,41 @@ gtk_column_view_column_allocate (GtkColumnViewColumn *self,
   self->header_position = offset;
 }
 
+/* Columns that are not in view don't have their cells bound, laid out
+ * or drawn. The view updates this when it is scrolled horizontally. */
+void
+gtk_column_view_column_set_in_view (GtkColumnViewColumn *self,
+                                    gboolean             in_view)
+{
+  GtkColumnViewCell *cell;
+
+  if (self->in_view == in_view)
+    return;
+
+  self->in_view = in_view;
+
+  for (cell = self->first_cell; cell; cell = gtk_column_view_cell_get_next (cell))
+    {
+      GtkListItemWidget *list_item = GTK_LIST_ITEM_WIDGET (gtk_widget_get_parent (GTK_WIDGET (cell)));
+
+      if (in_view)
+        gtk_list_item_widget_update (GTK_LIST_ITEM_WIDGET (cell),
+                                     gtk_list_item_widget_get_position (list_item),
+                                     gtk_list_item_widget_get_item (list_item),
+                                     gtk_list_item_widget_get_selected (list_item));
+      else
+        gtk_list_item_widget_update (GTK_LIST_ITEM_WIDGET (cell), GTK_INVALID_LIST_POSITION, NULL, FALSE);
+
+      gtk_widget_set_child_visible (GTK_WIDGET (cell), in_view);
+    }
+}
+
+gboolean
+gtk_column_view_column_get_in_view (GtkColumnViewColumn *self)
+{
+  return self->in_view;
+}
+
 void
 gtk_column_view_column_get_allocation (GtkColumnViewColumn *self,
                                        int                 *offset,
@@ -527,10 +580,11 @@ gtk_column_view_column_create_cells (GtkColumnViewColumn *self)
       list_item = GTK_LIST_ITEM_WIDGET (row);
       cell = gtk_column_view_cell_new (self);
       gtk_list_item_widget_add_child (list_item, cell);
-      gtk_list_item_widget_update (GTK_LIST_ITEM_WIDGET (cell),
-                                   gtk_list_item_widget_get_position (list_item),
-                                   gtk_list_item_widget_get_item (list_item),
-                                   gtk_list_item_widget_get_selected (list_item));
+      if (self->in_view)
+        gtk_list_item_widget_update (GTK_LIST_ITEM_WIDGET (cell),
+                                     gtk_list_item_widget_get_position (list_item),
+                                     gtk_list_item_widget_get_item (list_item),
+                                     gtk_list_item_widget_get_selected (list_item));
     }
 }
 
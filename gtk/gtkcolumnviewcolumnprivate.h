@@ -51,6 +51,10 @@ void                    gtk_column_view_column_get_allocation           (GtkColu
 
 void                    gtk_column_view_column_notify_sort              (GtkColumnViewColumn    *self);
 
+void                    gtk_column_view_column_set_in_view              (GtkColumnViewColumn    *self,
+                                                                         gboolean                in_view);
+gboolean                gtk_column_view_column_get_in_view              (GtkColumnViewColumn    *self);
+
 void                    gtk_column_view_column_set_header_position      (GtkColumnViewColumn    *self,
                                                                          int                     offset);
 void                    gtk_column_view_column_get_header_allocation    (GtkColumnViewColumn    *self,
@@ -23,6 +23,7 @@
 
 #include "gtkcolumnviewcolumnprivate.h"
 #include "gtkintl.h"
+#include "gtksorterprivate.h"
 #include "gtktypebuiltins.h"
 
 typedef struct
@@ -53,6 +54,44 @@ struct _GtkColumnViewSorter
 
 G_DEFINE_TYPE (GtkColumnViewSorter, gtk_column_view_sorter, GTK_TYPE_SORTER)
 
+static GtkSortKeys *
+gtk_column_view_sort_keys_new (GtkColumnViewSorter *self)
+{
+  GtkSortKeys **keys;
+  gboolean *inverted;
+  GtkSortKeys *result;
+  GSequenceIter *iter;
+  gsize i, n_keys;
+
+  n_keys = g_sequence_get_length (self->sorters);
+  keys = g_new (GtkSortKeys *, n_keys);
+  inverted = g_new (gboolean, n_keys);
+
+  for (iter = g_sequence_get_begin_iter (self->sorters), i = 0;
+       !g_sequence_iter_is_end (iter);
+       iter = g_sequence_iter_next (iter), i++)
+    {
+      Sorter *s = g_sequence_get (iter);
+
+      keys[i] = gtk_sorter_get_keys (s->sorter);
+      inverted[i] = s->inverted;
+    }
+
+  result = gtk_sort_keys_new_composite (keys, inverted, n_keys);
+  g_free (keys);
+  g_free (inverted);
+
+  return result;
+}
+
+static void
+gtk_column_view_sorter_emit_changed (GtkColumnViewSorter *self)
+{
+  gtk_sorter_changed_with_keys (GTK_SORTER (self),
+                                GTK_SORTER_CHANGE_DIFFERENT,
+                                gtk_column_view_sort_keys_new (self));
+}
+
 static GtkOrdering
 gtk_column_view_sorter_compare (GtkSorter *sorter,
                                 gpointer   item1,
@@ -144,6 +183,10 @@ static void
 gtk_column_view_sorter_init (GtkColumnViewSorter *self)
 {
   self->sorters = g_sequence_new (free_sorter);
+
+  gtk_sorter_changed_with_keys (GTK_SORTER (self),
+                                GTK_SORTER_CHANGE_DIFFERENT,
+                                gtk_column_view_sort_keys_new (self));
 }
 
 GtkColumnViewSorter *
@@ -155,7 +198,7 @@ gtk_column_view_sorter_new (void)
 static void
 gtk_column_view_sorter_changed_cb (GtkSorter *sorter, int change, gpointer data)
 {
-  gtk_sorter_changed (GTK_SORTER (data), GTK_SORTER_CHANGE_DIFFERENT);
+  gtk_column_view_sorter_emit_changed (GTK_COLUMN_VIEW_SORTER (data));
 }
 
 static gboolean
@@ -223,7 +266,7 @@ gtk_column_view_sorter_add_column (GtkColumnViewSorter *self,
     gtk_column_view_column_notify_sort (first->column);
 
 out:
-  gtk_sorter_changed (GTK_SORTER (self), GTK_SORTER_CHANGE_DIFFERENT);
+  gtk_column_view_sorter_emit_changed (self);
 
   gtk_column_view_column_notify_sort (column);
 
@@ -239,7 +282,7 @@ gtk_column_view_sorter_remove_column (GtkColumnViewSorter *self,
 
   if (remove_column (self, column))
     {
-      gtk_sorter_changed (GTK_SORTER (self), GTK_SORTER_CHANGE_DIFFERENT);
+      gtk_column_view_sorter_emit_changed (self);
       gtk_column_view_column_notify_sort (column);
       return TRUE;
     }
@@ -275,7 +318,7 @@ gtk_column_view_sorter_set_column (GtkColumnViewSorter *self,
  
   g_sequence_prepend (self->sorters, s);
 
-  gtk_sorter_changed (GTK_SORTER (self), GTK_SORTER_CHANGE_DIFFERENT);
+  gtk_column_view_sorter_emit_changed (self);
 
   gtk_column_view_column_notify_sort (column);
 
@@ -303,7 +346,7 @@ gtk_column_view_sorter_clear (GtkColumnViewSorter *self)
 
   g_sequence_remove_range (iter, g_sequence_get_end_iter (self->sorters));
 
-  gtk_sorter_changed (GTK_SORTER (self), GTK_SORTER_CHANGE_DIFFERENT);
+  gtk_column_view_sorter_emit_changed (self);
 
   gtk_column_view_column_notify_sort (column);
 
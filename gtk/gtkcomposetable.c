@@ -30,7 +30,7 @@
 
 
 #define GTK_COMPOSE_TABLE_MAGIC "GtkComposeTable"
-#define GTK_COMPOSE_TABLE_VERSION (1)
+#define GTK_COMPOSE_TABLE_VERSION (2)
 
 typedef struct {
   gunichar     *sequence;
@@ -534,63 +534,46 @@ gtk_compose_hash_get_cache_path (guint32 hash)
   return path;
 }
 
+/* The cache file starts with a header in native byte order, followed
+ * by the sequences in the same layout as GtkComposeTable.data, so that
+ * it can be mapped and used directly. The header is 24 bytes long, which
+ * keeps the sequences aligned.
+ */
+typedef struct {
+  char magic[16];
+  guint16 byte_order;
+  guint16 version;
+  guint16 max_seq_len;
+  guint16 n_seqs;
+} GtkComposeTableHeader;
+
+G_STATIC_ASSERT (sizeof (GtkComposeTableHeader) == 24);
+
 static char *
 gtk_compose_table_serialize (GtkComposeTable *compose_table,
                              gsize           *count)
 {
-  char *p, *contents;
-  gsize length, total_length;
-  guint16 bytes;
-  const char *header = GTK_COMPOSE_TABLE_MAGIC;
-  const guint16 version = GTK_COMPOSE_TABLE_VERSION;
-  guint16 max_seq_len = compose_table->max_seq_len;
-  guint16 index_stride = max_seq_len + 2;
-  guint16 n_seqs = compose_table->n_seqs;
-  guint32 i;
+  GtkComposeTableHeader header = { { 0, } };
+  char *contents;
+  gsize data_length, total_length;
 
   g_return_val_if_fail (compose_table != NULL, NULL);
-  g_return_val_if_fail (max_seq_len > 0, NULL);
-  g_return_val_if_fail (index_stride > 0, NULL);
+  g_return_val_if_fail (compose_table->max_seq_len > 0, NULL);
 
-  length = strlen (header);
-  total_length = length + sizeof (guint16) * (3 +  index_stride * n_seqs);
+  data_length = sizeof (guint16) * (compose_table->max_seq_len + 2) * compose_table->n_seqs;
+  total_length = sizeof (GtkComposeTableHeader) + data_length;
   if (count)
     *count = total_length;
 
-  p = contents = g_slice_alloc (total_length);
-
-  memcpy (p, header, length);
-  p += length;
-
-  /* Copy by byte for endian */
-#define BYTE_COPY_FROM_BUF(element)                                           \
-  bytes = GUINT16_TO_BE ((element));                                          \
-  memcpy (p, &bytes, length);                                                 \
-  p += length;                                                                \
-  if (p - contents > total_length)                                            \
-    {                                                                         \
-      g_warning ("data size %lld is bigger than %" G_GSIZE_FORMAT,            \
-                 (long long) (p - contents), total_length);                   \
-      g_free (contents);                                                      \
-      if (count)                                                              \
-        {                                                                     \
-          *count = 0;                                                         \
-        }                                                                     \
-      return NULL;                                                            \
-    }
-
-  length = sizeof (guint16);
+  memcpy (header.magic, GTK_COMPOSE_TABLE_MAGIC, strlen (GTK_COMPOSE_TABLE_MAGIC));
+  header.byte_order = G_BYTE_ORDER;
+  header.version = GTK_COMPOSE_TABLE_VERSION;
+  header.max_seq_len = compose_table->max_seq_len;
+  header.n_seqs = compose_table->n_seqs;
 
-  BYTE_COPY_FROM_BUF (version);
-  BYTE_COPY_FROM_BUF (max_seq_len);
-  BYTE_COPY_FROM_BUF (n_seqs);
-
-  for (i = 0; i < (guint32) index_stride * n_seqs; i++)
-    {
-      BYTE_COPY_FROM_BUF (compose_table->data[i]);
-    }
-
-#undef BYTE_COPY_FROM_BUF
+  contents = g_slice_alloc (total_length);
+  memcpy (contents, &header, sizeof (GtkComposeTableHeader));
+  memcpy (contents + sizeof (GtkComposeTableHeader), compose_table->data, data_length);
 
   return contents;
 }
@@ -604,25 +587,23 @@ gtk_compose_table_find (gconstpointer data1,
   return compose_table->id != hash;
 }
 
+/* The cache is mapped rather than read, so that processes using the
+ * same compose file share the pages of the table. The mapping is kept
+ * for the lifetime of the table. The cache is replaced atomically when
+ * it is saved, so existing mappings stay valid.
+ */
 static GtkComposeTable *
 gtk_compose_table_load_cache (const char *compose_file)
 {
   guint32 hash;
   char *path = NULL;
-  char *contents = NULL;
-  char *p;
+  GMappedFile *mapped = NULL;
+  const char *contents;
   GStatBuf original_buf;
   GStatBuf cache_buf;
   gsize total_length;
-  gsize length;
   GError *error = NULL;
-  guint16 bytes;
-  guint16 version;
-  guint16 max_seq_len;
-  guint16 index_stride;
-  guint16 n_seqs;
-  guint32 i;
-  guint16 *gtk_compose_seqs = NULL;
+  GtkComposeTableHeader header;
   GtkComposeTable *retval;
 
   hash = g_str_hash (compose_file);
@@ -635,81 +616,66 @@ gtk_compose_table_load_cache (const char *compose_file)
   g_stat (path, &cache_buf);
   if (original_buf.st_mtime > cache_buf.st_mtime)
     goto out_load_cache;
-  if (!g_file_get_contents (path, &contents, &total_length, &error))
+
+  mapped = g_mapped_file_new (path, FALSE, &error);
+  if (mapped == NULL)
     {
-      g_warning ("Failed to get cache content %s: %s", path, error->message);
+      g_warning ("Failed to map cache content %s: %s", path, error->message);
       g_error_free (error);
       goto out_load_cache;
     }
 
-  /* Copy by byte for endian */
-#define BYTE_COPY_TO_BUF(element)                                       \
-  memcpy (&bytes, p, length);                                           \
-  element = GUINT16_FROM_BE (bytes);                                    \
-  p += length;                                                          \
-  if (p - contents > total_length)                                      \
-    {                                                                   \
-      g_warning ("Broken cache content %s in %s", path, #element);      \
-      goto out_load_cache;                                              \
-    }
+  contents = g_mapped_file_get_contents (mapped);
+  total_length = g_mapped_file_get_length (mapped);
 
-  p = contents;
-  if (g_ascii_strncasecmp (p, GTK_COMPOSE_TABLE_MAGIC,
-                           strlen (GTK_COMPOSE_TABLE_MAGIC)) != 0)
-    {
-      g_warning ("The file is not a GtkComposeTable cache file %s", path);
-      goto out_load_cache;
-    }
-  p += strlen (GTK_COMPOSE_TABLE_MAGIC);
-  if (p - contents > total_length)
+  if (total_length < sizeof (GtkComposeTableHeader))
     {
       g_warning ("Broken cache content %s at head", path);
       goto out_load_cache;
     }
 
-  length = sizeof (guint16);
+  memcpy (&header, contents, sizeof (GtkComposeTableHeader));
 
-  BYTE_COPY_TO_BUF (version);
-  if (version != GTK_COMPOSE_TABLE_VERSION)
+  if (strncmp (header.magic, GTK_COMPOSE_TABLE_MAGIC, sizeof (header.magic)) != 0)
     {
-      g_warning ("cache version is different %u != %u",
-                 version, GTK_COMPOSE_TABLE_VERSION);
+      g_warning ("The file is not a GtkComposeTable cache file %s", path);
       goto out_load_cache;
     }
 
-  BYTE_COPY_TO_BUF (max_seq_len);
-  BYTE_COPY_TO_BUF (n_seqs);
+  /* Caches written on a machine with a different byte order, or by an
+   * older version, are silently regenerated.
+   */
+  if (header.byte_order != G_BYTE_ORDER ||
+      header.version != GTK_COMPOSE_TABLE_VERSION)
+    goto out_load_cache;
 
-  if (max_seq_len == 0 || n_seqs == 0)
+  if (header.max_seq_len == 0 || header.n_seqs == 0 ||
+      header.max_seq_len > GTK_MAX_COMPOSE_LEN)
     {
-      g_warning ("cache size is not correct %d %d", max_seq_len, n_seqs);
+      g_warning ("cache size is not correct %d %d", header.max_seq_len, header.n_seqs);
       goto out_load_cache;
     }
 
-  index_stride = max_seq_len + 2;
-  gtk_compose_seqs = g_new0 (guint16, n_seqs * index_stride);
-
-  for (i = 0; i < (guint32) index_stride * n_seqs; i++)
+  if (total_length != sizeof (GtkComposeTableHeader) +
+                      sizeof (guint16) * (header.max_seq_len + 2) * header.n_seqs)
     {
-      BYTE_COPY_TO_BUF (gtk_compose_seqs[i]);
+      g_warning ("Broken cache content %s", path);
+      goto out_load_cache;
     }
 
   retval = g_new0 (GtkComposeTable, 1);
-  retval->data = gtk_compose_seqs;
-  retval->max_seq_len = max_seq_len;
-  retval->n_seqs = n_seqs;
+  retval->data = (const guint16 *) (contents + sizeof (GtkComposeTableHeader));
+  retval->max_seq_len = header.max_seq_len;
+  retval->n_seqs = header.n_seqs;
   retval->id = hash;
+  retval->mapped = mapped;
 
-  g_free (contents);
   g_free (path);
 
   return retval;
 
-#undef BYTE_COPY_TO_BUF
-
 out_load_cache:
-  g_free (gtk_compose_seqs);
-  g_free (contents);
+  g_clear_pointer (&mapped, g_mapped_file_unref);
   g_free (path);
   return NULL;
 }
@@ -859,7 +825,7 @@ gtk_compose_table_list_add_array (GSList        *compose_tables,
   for (i = 0; i < length; i++)
     gtk_compose_seqs[i] = data[i];
 
-  compose_table = g_new (GtkComposeTable, 1);
+  compose_table = g_new0 (GtkComposeTable, 1);
   compose_table->data = gtk_compose_seqs;
   compose_table->max_seq_len = max_seq_len;
   compose_table->n_seqs = n_seqs;
@@ -1025,13 +1025,15 @@ gtk_constraint_layout_allocate (GtkLayoutManager *manager,
     return;
 
   /* We add required stay constraints to ensure that the layout remains
-   * within the bounds of the allocation
+   * within the bounds of the allocation; the solver is frozen while we
+   * add them, so that it only optimizes once for all four
    */
   layout_top = get_layout_attribute (self, widget, GTK_CONSTRAINT_ATTRIBUTE_TOP);
   layout_left = get_layout_attribute (self, widget, GTK_CONSTRAINT_ATTRIBUTE_LEFT);
   layout_width = get_layout_attribute (self, widget, GTK_CONSTRAINT_ATTRIBUTE_WIDTH);
   layout_height = get_layout_attribute (self, widget, GTK_CONSTRAINT_ATTRIBUTE_HEIGHT);
 
+  gtk_constraint_solver_freeze (solver);
   gtk_constraint_variable_set_value (layout_top, 0.0);
   stay_t = gtk_constraint_solver_add_stay_variable (solver,
                                                     layout_top,
@@ -1048,6 +1050,8 @@ gtk_constraint_layout_allocate (GtkLayoutManager *manager,
   stay_h = gtk_constraint_solver_add_stay_variable (solver,
                                                     layout_height,
                                                     GTK_CONSTRAINT_STRENGTH_REQUIRED);
+  gtk_constraint_solver_thaw (solver);
+
   GTK_NOTE (LAYOUT,
             g_print ("Layout [%p]: { .x: %g, .y: %g, .w: %g, .h: %g }\n",
                      self,
@@ -1122,10 +1126,12 @@ gtk_constraint_layout_allocate (GtkLayoutManager *manager,
 #endif
 
   /* The allocation stay constraints are not needed any more */
+  gtk_constraint_solver_freeze (solver);
   gtk_constraint_solver_remove_constraint (solver, stay_w);
   gtk_constraint_solver_remove_constraint (solver, stay_h);
   gtk_constraint_solver_remove_constraint (solver, stay_t);
   gtk_constraint_solver_remove_constraint (solver, stay_l);
+  gtk_constraint_solver_thaw (solver);
 }
 
 static void
@@ -1416,6 +1416,12 @@ gtk_constraint_solver_thaw (GtkConstraintSolver *solver)
   if (solver->freeze_count == 0)
     {
       solver->auto_solve = TRUE;
+
+      /* Constraints added or removed while frozen haven't been
+       * optimized for yet; do it once for all of them */
+      if (solver->needs_solving)
+        gtk_constraint_solver_optimize (solver, solver->objective);
+
       gtk_constraint_solver_resolve (solver);
     }
 }
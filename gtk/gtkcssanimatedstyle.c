@@ -899,9 +899,9 @@ gtk_css_animated_style_new (GtkCssStyle      *base_style,
   style->background = (GtkCssBackgroundValues *)gtk_css_values_ref ((GtkCssValues *)base_style->background);
   style->border = (GtkCssBorderValues *)gtk_css_values_ref ((GtkCssValues *)base_style->border);
   style->icon = (GtkCssIconValues *)gtk_css_values_ref ((GtkCssValues *)base_style->icon);
-  style->outline = (GtkCssOutlineValues *)gtk_css_values_ref ((GtkCssValues *)base_style->outline);
+  style->outline = (GtkCssOutlineValues *)gtk_css_values_ref ((GtkCssValues *)gtk_css_style_get_outline_values (base_style));
   style->font = (GtkCssFontValues *)gtk_css_values_ref ((GtkCssValues *)base_style->font);
-  style->font_variant = (GtkCssFontVariantValues *)gtk_css_values_ref ((GtkCssValues *)base_style->font_variant);
+  style->font_variant = (GtkCssFontVariantValues *)gtk_css_values_ref ((GtkCssValues *)gtk_css_style_get_font_variant_values (base_style));
   style->animation = (GtkCssAnimationValues *)gtk_css_values_ref ((GtkCssValues *)base_style->animation);
   style->transition = (GtkCssTransitionValues *)gtk_css_values_ref ((GtkCssValues *)base_style->transition);
   style->size = (GtkCssSizeValues *)gtk_css_values_ref ((GtkCssValues *)base_style->size);
@@ -919,8 +919,9 @@ gtk_css_animated_style_new_advance (GtkCssAnimatedStyle *source,
 {
   GtkCssAnimatedStyle *result;
   GtkCssStyle *style;
-  GPtrArray *animations;
-  guint i;
+  GtkStyleAnimation **animations;
+  guint i, n_animations;
+  gboolean reuse;
 
   gtk_internal_return_val_if_fail (GTK_IS_CSS_ANIMATED_STYLE (source), NULL);
   gtk_internal_return_val_if_fail (GTK_IS_CSS_STYLE (base_style), NULL);
@@ -930,7 +931,23 @@ gtk_css_animated_style_new_advance (GtkCssAnimatedStyle *source,
 
   gtk_internal_return_val_if_fail (timestamp > source->current_time, NULL);
 
-  animations = NULL;
+  n_animations = 0;
+  for (i = 0; i < source->n_animations; i ++)
+    {
+      if (!_gtk_style_animation_is_finished (source->animations[i]))
+        n_animations++;
+    }
+
+  if (n_animations == 0)
+    return g_object_ref (source->style);
+
+  /* When the node doing the advancing is the only owner of @source,
+   * nobody can advance it again, so its animations don't need to be
+   * copied. Its values stay untouched for computing the style change. */
+  reuse = G_OBJECT (source)->ref_count == 1;
+
+  animations = g_new (GtkStyleAnimation *, n_animations);
+  n_animations = 0;
   for (i = 0; i < source->n_animations; i ++)
     {
       GtkStyleAnimation *animation = source->animations[i];
@@ -938,31 +955,27 @@ gtk_css_animated_style_new_advance (GtkCssAnimatedStyle *source,
       if (_gtk_style_animation_is_finished (animation))
         continue;
 
-      if (!animations)
-        animations = g_ptr_array_sized_new (16);
-
-      animation = _gtk_style_animation_advance (animation, timestamp);
-      g_ptr_array_add (animations, animation);
+      if (reuse)
+        animations[n_animations++] = gtk_style_animation_advance_reuse (animation, timestamp);
+      else
+        animations[n_animations++] = _gtk_style_animation_advance (animation, timestamp);
     }
 
-  if (animations == NULL)
-    return g_object_ref (source->style);
-
   result = g_object_new (GTK_TYPE_CSS_ANIMATED_STYLE, NULL);
 
   result->style = g_object_ref (base_style);
   result->current_time = timestamp;
-  result->n_animations = animations->len;
-  result->animations = g_ptr_array_free (animations, FALSE);
+  result->n_animations = n_animations;
+  result->animations = animations;
 
   style = (GtkCssStyle *)result;
   style->core = (GtkCssCoreValues *)gtk_css_values_ref ((GtkCssValues *)base_style->core);
   style->background = (GtkCssBackgroundValues *)gtk_css_values_ref ((GtkCssValues *)base_style->background);
   style->border = (GtkCssBorderValues *)gtk_css_values_ref ((GtkCssValues *)base_style->border);
   style->icon = (GtkCssIconValues *)gtk_css_values_ref ((GtkCssValues *)base_style->icon);
-  style->outline = (GtkCssOutlineValues *)gtk_css_values_ref ((GtkCssValues *)base_style->outline);
+  style->outline = (GtkCssOutlineValues *)gtk_css_values_ref ((GtkCssValues *)gtk_css_style_get_outline_values (base_style));
   style->font = (GtkCssFontValues *)gtk_css_values_ref ((GtkCssValues *)base_style->font);
-  style->font_variant = (GtkCssFontVariantValues *)gtk_css_values_ref ((GtkCssValues *)base_style->font_variant);
+  style->font_variant = (GtkCssFontVariantValues *)gtk_css_values_ref ((GtkCssValues *)gtk_css_style_get_font_variant_values (base_style));
   style->animation = (GtkCssAnimationValues *)gtk_css_values_ref ((GtkCssValues *)base_style->animation);
   style->transition = (GtkCssTransitionValues *)gtk_css_values_ref ((GtkCssValues *)base_style->transition);
   style->size = (GtkCssSizeValues *)gtk_css_values_ref ((GtkCssValues *)base_style->size);
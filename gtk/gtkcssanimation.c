@@ -85,6 +85,18 @@ gtk_css_animation_advance (GtkStyleAnimation    *style_animation,
                                                      animation->play_state);
 }
 
+static void
+gtk_css_animation_advance_in_place (GtkStyleAnimation *style_animation,
+                                    gint64             timestamp)
+{
+  GtkCssAnimation *animation = (GtkCssAnimation *)style_animation;
+
+  if (animation->play_state == GTK_CSS_PLAY_STATE_PAUSED)
+    gtk_progress_tracker_skip_frame (&animation->tracker, timestamp);
+  else
+    gtk_progress_tracker_advance_frame (&animation->tracker, timestamp);
+}
+
 static void
 gtk_css_animation_apply_values (GtkStyleAnimation    *style_animation,
                                 GtkCssAnimatedStyle  *style)
@@ -150,6 +162,7 @@ static const GtkStyleAnimationClass GTK_CSS_ANIMATION_CLASS = {
   gtk_css_animation_is_static,
   gtk_css_animation_apply_values,
   gtk_css_animation_advance,
+  gtk_css_animation_advance_in_place,
 };
 
 
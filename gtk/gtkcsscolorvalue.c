@@ -26,6 +26,8 @@
 
 #include "gdk/gdkrgbaprivate.h"
 
+#include <math.h>
+
 typedef enum {
   COLOR_TYPE_LITERAL,
   COLOR_TYPE_NAME,
@@ -61,9 +63,37 @@ struct _GtkCssValue
   } sym_col;
 };
 
+/* Literal colors are what all other colors compute to, so they are
+ * interned like computed dimensions. The table doesn't hold references.
+ */
+static GHashTable *interned_colors;
+
+static guint
+gtk_css_color_value_hash (gconstpointer data)
+{
+  const GtkCssValue *color = data;
+
+  return gdk_rgba_hash (&color->sym_col.rgba);
+}
+
+static gboolean
+gtk_css_color_value_equal (gconstpointer data1,
+                           gconstpointer data2)
+{
+  const GtkCssValue *color1 = data1;
+  const GtkCssValue *color2 = data2;
+
+  return gdk_rgba_equal (&color1->sym_col.rgba, &color2->sym_col.rgba);
+}
+
 static void
 gtk_css_value_color_free (GtkCssValue *color)
 {
+  if (color->type == COLOR_TYPE_LITERAL &&
+      interned_colors != NULL &&
+      g_hash_table_lookup (interned_colors, color) == color)
+    g_hash_table_remove (interned_colors, color);
+
   if (color->last_value)
     _gtk_css_value_unref (color->last_value);
 
@@ -504,6 +534,7 @@ GtkCssValue *
 _gtk_css_color_value_new_literal (const GdkRGBA *color)
 {
   GtkCssValue *value;
+  gboolean interned;
 
   g_return_val_if_fail (color != NULL, NULL);
 
@@ -513,11 +544,35 @@ _gtk_css_color_value_new_literal (const GdkRGBA *color)
   if (gdk_rgba_equal (color, &transparent_black_singleton.sym_col.rgba))
     return _gtk_css_value_ref (&transparent_black_singleton);
 
+  /* NaN never compares equal, so it can't be looked up */
+  if (isnan (color->red) || isnan (color->green) ||
+      isnan (color->blue) || isnan (color->alpha))
+    interned = FALSE;
+  else
+    interned = TRUE;
+
+  if (interned)
+    {
+      GtkCssValue key;
+
+      if (interned_colors == NULL)
+        interned_colors = g_hash_table_new (gtk_css_color_value_hash,
+                                            gtk_css_color_value_equal);
+
+      key.sym_col.rgba = *color;
+      value = g_hash_table_lookup (interned_colors, &key);
+      if (value)
+        return _gtk_css_value_ref (value);
+    }
+
   value = _gtk_css_value_new (GtkCssValue, &GTK_CSS_VALUE_COLOR);
   value->type = COLOR_TYPE_LITERAL;
   value->is_computed = TRUE;
   value->sym_col.rgba = *color;
 
+  if (interned)
+    g_hash_table_add (interned_colors, value);
+
   return value;
 }
 
@@ -35,6 +35,15 @@ gtk_css_dynamic_advance (GtkStyleAnimation    *style_animation,
   return gtk_css_dynamic_new (timestamp);
 }
 
+static void
+gtk_css_dynamic_advance_in_place (GtkStyleAnimation *style_animation,
+                                  gint64             timestamp)
+{
+  GtkCssDynamic *dynamic = (GtkCssDynamic *)style_animation;
+
+  dynamic->timestamp = timestamp;
+}
+
 static void
 gtk_css_dynamic_apply_values (GtkStyleAnimation    *style_animation,
                               GtkCssAnimatedStyle  *style)
@@ -80,6 +89,7 @@ static const GtkStyleAnimationClass GTK_CSS_DYNAMIC_CLASS = {
   gtk_css_dynamic_is_static,
   gtk_css_dynamic_apply_values,
   gtk_css_dynamic_advance,
+  gtk_css_dynamic_advance_in_place,
 };
 
 GtkStyleAnimation *
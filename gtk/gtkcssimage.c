@@ -122,9 +122,23 @@ gtk_css_image_real_is_computed (GtkCssImage *image)
   return FALSE;
 }
 
+static void
+gtk_css_image_dispose (GObject *object)
+{
+  GtkCssImage *image = GTK_CSS_IMAGE (object);
+
+  g_clear_pointer (&image->cached_node, gsk_render_node_unref);
+
+  G_OBJECT_CLASS (_gtk_css_image_parent_class)->dispose (object);
+}
+
 static void
 _gtk_css_image_class_init (GtkCssImageClass *klass)
 {
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->dispose = gtk_css_image_dispose;
+
   klass->get_width = gtk_css_image_real_get_width;
   klass->get_height = gtk_css_image_real_get_height;
   klass->get_aspect_ratio = gtk_css_image_real_get_aspect_ratio;
@@ -287,7 +301,32 @@ gtk_css_image_snapshot (GtkCssImage *image,
 
   klass = GTK_CSS_IMAGE_GET_CLASS (image);
 
-  klass->snapshot (image, snapshot, width, height);
+  if (!klass->cache_snapshot)
+    {
+      klass->snapshot (image, snapshot, width, height);
+      return;
+    }
+
+  /* Gradients and symbolic icons get snapshotted with the same size
+   * every frame, so keep the last node around */
+  if (image->cached_node == NULL ||
+      image->cached_width != width ||
+      image->cached_height != height)
+    {
+      GtkSnapshot *image_snapshot = gtk_snapshot_new ();
+
+      klass->snapshot (image, image_snapshot, width, height);
+
+      g_clear_pointer (&image->cached_node, gsk_render_node_unref);
+      image->cached_node = gtk_snapshot_free_to_node (image_snapshot);
+      image->cached_width = width;
+      image->cached_height = height;
+
+      if (image->cached_node == NULL)
+        return;
+    }
+
+  gtk_snapshot_append_node (snapshot, image->cached_node);
 }
 
 gboolean
@@ -512,6 +512,7 @@ gtk_css_image_conic_class_init (GtkCssImageConicClass *klass)
   GObjectClass *object_class = G_OBJECT_CLASS (klass);
 
   image_class->snapshot = gtk_css_image_conic_snapshot;
+  image_class->cache_snapshot = TRUE;
   image_class->parse = gtk_css_image_conic_parse;
   image_class->print = gtk_css_image_conic_print;
   image_class->compute = gtk_css_image_conic_compute;
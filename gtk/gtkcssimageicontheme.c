@@ -194,6 +194,7 @@ _gtk_css_image_icon_theme_class_init (GtkCssImageIconThemeClass *klass)
 
   image_class->get_aspect_ratio = gtk_css_image_icon_theme_get_aspect_ratio;
   image_class->snapshot = gtk_css_image_icon_theme_snapshot;
+  image_class->cache_snapshot = TRUE;
   image_class->parse = gtk_css_image_icon_theme_parse;
   image_class->print = gtk_css_image_icon_theme_print;
   image_class->compute = gtk_css_image_icon_theme_compute;
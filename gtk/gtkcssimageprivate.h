@@ -45,12 +45,21 @@ typedef struct _GtkCssImageClass      GtkCssImageClass;
 struct _GtkCssImage
 {
   GObject parent;
+
+  /* last snapshot, see GtkCssImageClass::cache_snapshot */
+  GskRenderNode *cached_node;
+  double cached_width;
+  double cached_height;
 };
 
 struct _GtkCssImageClass
 {
   GObjectClass parent_class;
 
+  /* snapshot only depends on the computed value and the size,
+   * so the resulting node can be reused */
+  gboolean     cache_snapshot;
+
   /* width of image or 0 if it has no width (optional) */
   int          (* get_width)                       (GtkCssImage                *image);
   /* height of image or 0 if it has no height (optional) */
@@ -733,6 +733,7 @@ _gtk_css_image_radial_class_init (GtkCssImageRadialClass *klass)
   GObjectClass *object_class = G_OBJECT_CLASS (klass);
 
   image_class->snapshot = gtk_css_image_radial_snapshot;
+  image_class->cache_snapshot = TRUE;
   image_class->parse = gtk_css_image_radial_parse;
   image_class->print = gtk_css_image_radial_print;
   image_class->compute = gtk_css_image_radial_compute;
@@ -325,6 +325,7 @@ _gtk_css_image_recolor_class_init (GtkCssImageRecolorClass *klass)
   image_class->get_height = gtk_css_image_recolor_get_height;
   image_class->compute = gtk_css_image_recolor_compute;
   image_class->snapshot = gtk_css_image_recolor_snapshot;
+  image_class->cache_snapshot = TRUE;
   image_class->parse = gtk_css_image_recolor_parse;
   image_class->print = gtk_css_image_recolor_print;
   image_class->is_computed = gtk_css_image_recolor_is_computed;
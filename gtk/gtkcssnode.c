@@ -22,10 +22,13 @@
 #include "gtkcssstaticstyleprivate.h"
 #include "gtkcssanimatedstyleprivate.h"
 #include "gtkcssstylepropertyprivate.h"
+#include "gtkcsswidgetnodeprivate.h"
+#include "gtkdebug.h"
 #include "gtkintl.h"
 #include "gtkmarshalers.h"
 #include "gtksettingsprivate.h"
 #include "gtktypebuiltins.h"
+#include "gtkwidgetprivate.h"
 #include "gtkprivate.h"
 #include "gdkprofilerprivate.h"
 
@@ -126,8 +129,23 @@ gtk_css_node_get_style_provider_or_null (GtkCssNode *cssnode)
 
 static int invalidated_nodes;
 static int created_styles;
+static int shared_styles;
+static int unshared_styles;
+static int validated_nodes;
+static int parent_cache_hits;
+static GtkCssChange validated_changes;
 static guint invalidated_nodes_counter;
 static guint created_styles_counter;
+static guint shared_styles_counter;
+static guint unshared_styles_counter;
+static guint validated_nodes_counter;
+static guint parent_cache_hits_counter;
+
+/* Restyles taking longer than this get their own mark, in nsec */
+#define SLOW_RESTYLE_TIME (50 * 1000)
+
+static gboolean collect_stats;
+static GQuark stats_quark;
 
 static void
 gtk_css_node_set_invalid (GtkCssNode *node,
@@ -355,6 +373,70 @@ store_in_global_parent_cache (GtkCssNode                  *node,
                                                  style);
 }
 
+/* Rows of lists and other runs of identical siblings usually end up
+ * with the same style. So before doing any lookups, check if the
+ * previous sibling has the same declaration and a style that does
+ * not depend on the position of the node, and just reuse that.
+ */
+static GtkCssStyle *
+lookup_in_previous_sibling (GtkCssNode                  *node,
+                            const GtkCssNodeDeclaration *decl)
+{
+  GtkCssNode *sibling;
+  GtkCssStyle *style;
+  GtkCssChange change;
+
+#ifdef G_ENABLE_DEBUG
+  if (GTK_DEBUG_CHECK (NO_CSS_CACHE))
+    return NULL;
+#endif
+
+  for (sibling = node->previous_sibling;
+       sibling != NULL;
+       sibling = sibling->previous_sibling)
+    {
+      if (sibling->visible)
+        break;
+    }
+
+  if (sibling == NULL)
+    return NULL;
+
+  /* The previous sibling's style is always valid when ours is
+   * computed, but better be safe. */
+  if (sibling->style_is_invalid || sibling->style == NULL)
+    return NULL;
+
+  if (!may_use_global_parent_cache (node) ||
+      gtk_css_node_get_style_provider_or_null (sibling) != gtk_css_node_get_style_provider_or_null (node))
+    return NULL;
+
+  if (!gtk_css_node_declaration_equal (sibling->decl, decl))
+    return NULL;
+
+  style = GTK_CSS_STYLE (gtk_css_style_get_static_style (sibling->style));
+  if (!GTK_IS_CSS_STATIC_STYLE (style))
+    return NULL;
+
+  change = gtk_css_static_style_get_change (GTK_CSS_STATIC_STYLE (style));
+  if (change & (GTK_CSS_CHANGE_ANY_SIBLING | GTK_CSS_CHANGE_NTH_CHILD | GTK_CSS_CHANGE_NTH_LAST_CHILD))
+    return NULL;
+  if ((change & GTK_CSS_CHANGE_FIRST_CHILD) &&
+      gtk_css_node_is_first_child (sibling) != gtk_css_node_is_first_child (node))
+    return NULL;
+  if ((change & GTK_CSS_CHANGE_LAST_CHILD) &&
+      gtk_css_node_is_last_child (sibling) != gtk_css_node_is_last_child (node))
+    return NULL;
+
+  /* Identical styles have identical children, so share the cache
+   * for them, too */
+  g_assert (node->cache == NULL);
+  if (sibling->cache)
+    node->cache = gtk_css_node_style_cache_ref (sibling->cache);
+
+  return style;
+}
+
 static GtkCssStyle *
 gtk_css_node_create_style (GtkCssNode                   *cssnode,
                            const GtkCountingBloomFilter *filter,
@@ -366,9 +448,21 @@ gtk_css_node_create_style (GtkCssNode                   *cssnode,
 
   decl = gtk_css_node_get_declaration (cssnode);
 
+  style = lookup_in_previous_sibling (cssnode, decl);
+  if (style)
+    {
+      shared_styles++;
+      return g_object_ref (style);
+    }
+
+  unshared_styles++;
+
   style = lookup_in_global_parent_cache (cssnode, decl);
   if (style)
-    return g_object_ref (style);
+    {
+      parent_cache_hits++;
+      return g_object_ref (style);
+    }
 
   created_styles++;
 
@@ -631,6 +725,10 @@ gtk_css_node_class_init (GtkCssNodeClass *klass)
     {
       invalidated_nodes_counter = gdk_profiler_define_int_counter ("invalidated-nodes", "CSS Node Invalidations");
       created_styles_counter = gdk_profiler_define_int_counter ("created-styles", "CSS Style Creations");
+      shared_styles_counter = gdk_profiler_define_int_counter ("shared-styles", "CSS Styles shared with siblings");
+      unshared_styles_counter = gdk_profiler_define_int_counter ("unshared-styles", "CSS Styles not shared with siblings");
+      validated_nodes_counter = gdk_profiler_define_int_counter ("validated-nodes", "CSS Nodes restyled");
+      parent_cache_hits_counter = gdk_profiler_define_int_counter ("parent-cache-hits", "CSS Styles found in the parent cache");
     }
 }
 
@@ -942,6 +1040,32 @@ gtk_css_node_propagate_pending_changes (GtkCssNode *cssnode,
   cssnode->needs_propagation = FALSE;
 }
 
+/* Called with the start time before a node is restyled,
+ * and with 0 afterwards */
+static void
+gtk_css_node_update_stats (GtkCssNode *cssnode,
+                           gint64      start_time)
+{
+  GtkCssNodeStats *stats;
+
+  stats = g_object_get_qdata (G_OBJECT (cssnode), stats_quark);
+  if (stats == NULL)
+    {
+      stats = g_new0 (GtkCssNodeStats, 1);
+      g_object_set_qdata_full (G_OBJECT (cssnode), stats_quark, stats, g_free);
+    }
+
+  if (start_time)
+    {
+      stats->last_start_time = start_time;
+      return;
+    }
+
+  stats->n_restyles++;
+  stats->restyle_time += g_get_monotonic_time () - stats->last_start_time;
+  stats->changes |= cssnode->pending_changes;
+}
+
 static gboolean
 gtk_css_node_needs_new_style (GtkCssNode *cssnode)
 {
@@ -958,6 +1082,11 @@ gtk_css_node_do_ensure_style (GtkCssNode                   *cssnode,
   if (cssnode->style_is_invalid)
     {
       GtkCssStyle *new_style;
+      gint64 before G_GNUC_UNUSED;
+
+      before = GDK_PROFILER_CURRENT_TIME;
+      if (collect_stats)
+        gtk_css_node_update_stats (cssnode, g_get_monotonic_time ());
 
       g_clear_pointer (&cssnode->cache, gtk_css_node_style_cache_unref);
 
@@ -969,6 +1098,24 @@ gtk_css_node_do_ensure_style (GtkCssNode                   *cssnode,
 
       style_changed = gtk_css_node_set_style (cssnode, new_style);
       g_object_unref (new_style);
+
+      validated_nodes++;
+      validated_changes |= cssnode->pending_changes;
+
+      if (collect_stats)
+        gtk_css_node_update_stats (cssnode, 0);
+
+      if (GDK_PROFILER_IS_RUNNING &&
+          GDK_PROFILER_CURRENT_TIME - before > SLOW_RESTYLE_TIME)
+        {
+          char *node = gtk_css_node_declaration_to_string (cssnode->decl);
+          char *reasons = gtk_css_change_to_string (cssnode->pending_changes);
+
+          gdk_profiler_end_markf (before, "css node restyle", "%s: %s", node, reasons);
+
+          g_free (reasons);
+          g_free (node);
+        }
     }
   else
     {
@@ -1271,6 +1418,46 @@ gtk_css_node_invalidate_style_provider (GtkCssNode *cssnode)
     }
 }
 
+static void
+invalidate_matching_nodes (GtkCssNode               *cssnode,
+                           const GtkCssSelectorTree *selectors,
+                           GtkCssSelectorMatches    *matches)
+{
+  GtkCssNode *child;
+
+  /* The cached styles may have been computed with the old rules */
+  g_clear_pointer (&cssnode->cache, gtk_css_node_style_cache_unref);
+
+  _gtk_css_selector_tree_match_all (selectors, NULL, cssnode, matches);
+  if (!gtk_css_selector_matches_is_empty (matches))
+    {
+      gtk_css_node_invalidate (cssnode, GTK_CSS_CHANGE_SOURCE);
+      gtk_css_selector_matches_set_size (matches, 0);
+    }
+
+  for (child = cssnode->first_child;
+       child;
+       child = child->next_sibling)
+    {
+      if (gtk_css_node_get_style_provider_or_null (child) == NULL)
+        invalidate_matching_nodes (child, selectors, matches);
+    }
+}
+
+/* Like gtk_css_node_invalidate_style_provider(), but only for the
+ * nodes that match one of @selectors. Their children are updated by
+ * the usual propagation if that changes their style. */
+void
+gtk_css_node_invalidate_style_provider_selectors (GtkCssNode               *cssnode,
+                                                  const GtkCssSelectorTree *selectors)
+{
+  GtkCssSelectorMatches matches;
+
+  gtk_css_selector_matches_init (&matches);
+  invalidate_matching_nodes (cssnode, selectors, &matches);
+  gtk_css_selector_matches_clear (&matches);
+}
+
 static void
 gtk_css_node_invalidate_timestamp (GtkCssNode *cssnode)
 {
@@ -1319,6 +1506,19 @@ gtk_css_node_invalidate (GtkCssNode   *cssnode,
   gtk_css_node_invalidate_style (cssnode);
 }
 
+/* The widget that style updates of @cssnode are accounted to */
+static GtkWidget *
+gtk_css_node_get_owner_widget (GtkCssNode *cssnode)
+{
+  for (; cssnode; cssnode = cssnode->parent)
+    {
+      if (GTK_IS_CSS_WIDGET_NODE (cssnode))
+        return gtk_css_widget_node_get_widget (GTK_CSS_WIDGET_NODE (cssnode));
+    }
+
+  return NULL;
+}
+
 static void
 gtk_css_node_validate_internal (GtkCssNode             *cssnode,
                                 GtkCountingBloomFilter *filter,
@@ -1326,10 +1526,13 @@ gtk_css_node_validate_internal (GtkCssNode             *cssnode,
 {
   GtkCssNode *child;
   gboolean bloomed = FALSE;
+  GtkWidgetCostFrame cost_frame;
 
   if (!cssnode->invalid)
     return;
 
+  gtk_widget_cost_begin (&cost_frame);
+
   gtk_css_node_ensure_style (cssnode, filter, timestamp);
 
   /* need to set to FALSE then to TRUE here to make it chain up */
@@ -1339,6 +1542,12 @@ gtk_css_node_validate_internal (GtkCssNode             *cssnode,
 
   GTK_CSS_NODE_GET_CLASS (cssnode)->validate (cssnode);
 
+  gtk_widget_cost_end (&cost_frame,
+                       gtk_widget_cost_frame_is_active (&cost_frame)
+                         ? gtk_css_node_get_owner_widget (cssnode)
+                         : NULL,
+                       GTK_WIDGET_COST_CSS);
+
   for (child = gtk_css_node_get_first_child (cssnode);
        child;
        child = gtk_css_node_get_next_sibling (child))
@@ -1376,12 +1585,58 @@ gtk_css_node_validate (GtkCssNode *cssnode)
 
   if (GDK_PROFILER_IS_RUNNING)
     {
-      gdk_profiler_end_mark (before,  "css validation", "");
+      char *reasons = gtk_css_change_to_string (validated_changes);
+
+      gdk_profiler_end_mark (before,  "css validation", reasons);
       gdk_profiler_set_int_counter (invalidated_nodes_counter, invalidated_nodes);
       gdk_profiler_set_int_counter (created_styles_counter, created_styles);
-      invalidated_nodes = 0;
-      created_styles = 0;
+      gdk_profiler_set_int_counter (shared_styles_counter, shared_styles);
+      gdk_profiler_set_int_counter (unshared_styles_counter, unshared_styles);
+      gdk_profiler_set_int_counter (validated_nodes_counter, validated_nodes);
+      gdk_profiler_set_int_counter (parent_cache_hits_counter, parent_cache_hits);
+      g_free (reasons);
     }
+
+  invalidated_nodes = 0;
+  created_styles = 0;
+  shared_styles = 0;
+  unshared_styles = 0;
+  validated_nodes = 0;
+  parent_cache_hits = 0;
+  validated_changes = 0;
+}
+
+/*
+ * gtk_css_node_set_collect_stats:
+ * @collect: whether to collect statistics
+ *
+ * Makes all nodes record how often and why they were restyled,
+ * see gtk_css_node_get_stats(). This is meant for the inspector,
+ * statistics are kept until the nodes are finalized.
+ */
+void
+gtk_css_node_set_collect_stats (gboolean collect)
+{
+  if (stats_quark == 0)
+    stats_quark = g_quark_from_static_string ("gtk-css-node-stats");
+
+  collect_stats = collect;
+}
+
+/*
+ * gtk_css_node_get_stats:
+ * @cssnode: a #GtkCssNode
+ *
+ * Returns: (nullable): the statistics collected for @cssnode, or %NULL
+ *     if it has not been restyled while collecting them
+ */
+const GtkCssNodeStats *
+gtk_css_node_get_stats (GtkCssNode *cssnode)
+{
+  if (stats_quark == 0)
+    return NULL;
+
+  return g_object_get_qdata (G_OBJECT (cssnode), stats_quark);
 }
 
 GtkStyleProvider *
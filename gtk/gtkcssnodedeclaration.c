@@ -22,7 +22,8 @@
 #include <string.h>
 
 struct _GtkCssNodeDeclaration {
-  guint refcount;
+  guint refcount : 31;
+  guint interned : 1;
   GQuark name;
   GQuark id;
   GtkStateFlags state;
@@ -43,16 +44,54 @@ sizeof_this_node (GtkCssNodeDeclaration *decl)
   return sizeof_node (decl->n_classes);
 }
 
+/* Nodes with the same name, id, state and classes share their
+ * declaration: Most nodes in a list look the same, and it turns
+ * comparing declarations into a pointer comparison.
+ * Interned declarations are never modified in place.
+ * The table doesn't hold references, declarations remove themselves
+ * from it when they are freed.
+ */
+static GHashTable *interned_declarations;
+
 static void
-gtk_css_node_declaration_make_writable (GtkCssNodeDeclaration **decl)
+gtk_css_node_declaration_intern (GtkCssNodeDeclaration **decl)
 {
-  if ((*decl)->refcount == 1)
+  GtkCssNodeDeclaration *interned;
+
+  if (interned_declarations == NULL)
+    interned_declarations = g_hash_table_new (gtk_css_node_declaration_hash,
+                                              gtk_css_node_declaration_equal);
+
+  interned = g_hash_table_lookup (interned_declarations, *decl);
+  if (interned == *decl)
     return;
 
-  (*decl)->refcount--;
+  if (interned)
+    {
+      gtk_css_node_declaration_ref (interned);
+      gtk_css_node_declaration_unref (*decl);
+      *decl = interned;
+    }
+  else
+    {
+      (*decl)->interned = TRUE;
+      g_hash_table_add (interned_declarations, *decl);
+    }
+}
+
+static void
+gtk_css_node_declaration_make_writable (GtkCssNodeDeclaration **decl)
+{
+  GtkCssNodeDeclaration *old = *decl;
+
+  if (old->refcount == 1 && !old->interned)
+    return;
 
-  *decl = g_memdup (*decl, sizeof_this_node (*decl));
+  *decl = g_memdup (old, sizeof_this_node (old));
   (*decl)->refcount = 1;
+  (*decl)->interned = FALSE;
+
+  gtk_css_node_declaration_unref (old);
 }
 
 static void
@@ -64,7 +103,7 @@ gtk_css_node_declaration_make_writable_resize (GtkCssNodeDeclaration **decl,
   gsize old_size = sizeof_this_node (*decl);
   gsize new_size = old_size + bytes_added - bytes_removed;
 
-  if ((*decl)->refcount == 1)
+  if ((*decl)->refcount == 1 && !(*decl)->interned)
     {
       if (bytes_removed > 0 && old_size - offset - bytes_removed > 0)
         memmove (((char *) *decl) + offset, ((char *) *decl) + offset + bytes_removed, old_size - offset - bytes_removed);
@@ -76,13 +115,14 @@ gtk_css_node_declaration_make_writable_resize (GtkCssNodeDeclaration **decl,
     {
       GtkCssNodeDeclaration *old = *decl;
 
-      old->refcount--;
-  
       *decl = g_malloc (new_size);
       memcpy (*decl, old, offset);
       if (old_size - offset - bytes_removed > 0)
         memcpy (((char *) *decl) + offset + bytes_added, ((char *) old) + offset + bytes_removed, old_size - offset - bytes_removed);
       (*decl)->refcount = 1;
+      (*decl)->interned = FALSE;
+
+      gtk_css_node_declaration_unref (old);
     }
 }
 
@@ -94,6 +134,7 @@ gtk_css_node_declaration_new (void)
     0,
     0,
     0,
+    0,
     0
   };
 
@@ -115,6 +156,9 @@ gtk_css_node_declaration_unref (GtkCssNodeDeclaration *decl)
   if (decl->refcount > 0)
     return;
 
+  if (decl->interned)
+    g_hash_table_remove (interned_declarations, decl);
+
   g_free (decl);
 }
 
@@ -127,6 +171,7 @@ gtk_css_node_declaration_set_name (GtkCssNodeDeclaration **decl,
 
   gtk_css_node_declaration_make_writable (decl);
   (*decl)->name = name;
+  gtk_css_node_declaration_intern (decl);
 
   return TRUE;
 }
@@ -146,6 +191,7 @@ gtk_css_node_declaration_set_id (GtkCssNodeDeclaration **decl,
 
   gtk_css_node_declaration_make_writable (decl);
   (*decl)->id = id;
+  gtk_css_node_declaration_intern (decl);
 
   return TRUE;
 }
@@ -165,6 +211,7 @@ gtk_css_node_declaration_set_state (GtkCssNodeDeclaration **decl,
   
   gtk_css_node_declaration_make_writable (decl);
   (*decl)->state = state;
+  gtk_css_node_declaration_intern (decl);
 
   return TRUE;
 }
@@ -235,6 +282,7 @@ gtk_css_node_declaration_add_class (GtkCssNodeDeclaration **decl,
                                                  0);
   (*decl)->n_classes++;
   (*decl)->classes[pos] = class_quark;
+  gtk_css_node_declaration_intern (decl);
 
   return TRUE;
 }
@@ -253,6 +301,7 @@ gtk_css_node_declaration_remove_class (GtkCssNodeDeclaration **decl,
                                                  0,
                                                  sizeof (GQuark));
   (*decl)->n_classes--;
+  gtk_css_node_declaration_intern (decl);
 
   return TRUE;
 }
@@ -268,6 +317,7 @@ gtk_css_node_declaration_clear_classes (GtkCssNodeDeclaration **decl)
                                                  0,
                                                  sizeof (GQuark) * (*decl)->n_classes);
   (*decl)->n_classes = 0;
+  gtk_css_node_declaration_intern (decl);
 
   return TRUE;
 }
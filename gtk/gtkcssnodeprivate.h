@@ -21,6 +21,7 @@
 #include "gtkcountingbloomfilterprivate.h"
 #include "gtkcssnodedeclarationprivate.h"
 #include "gtkcssnodestylecacheprivate.h"
+#include "gtkcssselectorprivate.h"
 #include "gtkcssstylechangeprivate.h"
 #include "gtkbitmaskprivate.h"
 #include "gtkcsstypesprivate.h"
@@ -36,6 +37,15 @@ G_BEGIN_DECLS
 #define GTK_CSS_NODE_GET_CLASS(obj) (G_TYPE_INSTANCE_GET_CLASS ((obj), GTK_TYPE_CSS_NODE, GtkCssNodeClass))
 
 typedef struct _GtkCssNodeClass         GtkCssNodeClass;
+typedef struct _GtkCssNodeStats         GtkCssNodeStats;
+
+struct _GtkCssNodeStats
+{
+  guint                  n_restyles;
+  gint64                 restyle_time;          /* total, in usec */
+  GtkCssChange           changes;               /* all changes that caused restyles */
+  gint64                 last_start_time;
+};
 
 struct _GtkCssNode
 {
@@ -143,6 +153,9 @@ GtkCssStyle *           gtk_css_node_get_style          (GtkCssNode            *
 
 void                    gtk_css_node_invalidate_style_provider
                                                         (GtkCssNode            *cssnode);
+void                    gtk_css_node_invalidate_style_provider_selectors
+                                                        (GtkCssNode            *cssnode,
+                                                         const GtkCssSelectorTree *selectors);
 void                    gtk_css_node_invalidate_frame_clock
                                                         (GtkCssNode            *cssnode,
                                                          gboolean               just_timestamp);
@@ -150,6 +163,9 @@ void                    gtk_css_node_invalidate         (GtkCssNode            *
                                                          GtkCssChange           change);
 void                    gtk_css_node_validate           (GtkCssNode            *cssnode);
 
+void                    gtk_css_node_set_collect_stats  (gboolean               collect);
+const GtkCssNodeStats * gtk_css_node_get_stats          (GtkCssNode            *cssnode);
+
 GtkStyleProvider *      gtk_css_node_get_style_provider (GtkCssNode            *cssnode) G_GNUC_PURE;
 
 void                    gtk_css_node_print              (GtkCssNode                *cssnode,
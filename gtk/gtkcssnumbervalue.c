@@ -25,9 +25,13 @@
 #include "gtkcssstyleprivate.h"
 #include "gtkprivate.h"
 
+#include <math.h>
+
 static GtkCssValue *        gtk_css_calc_value_new         (guint n_terms);
 static GtkCssValue *        gtk_css_calc_value_new_sum     (GtkCssValue *a,
                                                             GtkCssValue *b);
+static GtkCssValue *        gtk_css_calc_value_new_folded  (GtkCssValue **values,
+                                                            guint         n_values);
 
 enum {
   TYPE_CALC = 0,
@@ -58,8 +62,16 @@ gtk_css_calc_value_new_from_array (GtkCssValue **values,
 
   if (n_values > 1)
     {
+      guint i;
+
       result = gtk_css_calc_value_new (n_values);
       memcpy (result->calc.terms, values, n_values * sizeof (GtkCssValue *));
+
+      /* Terms are always dimensions, so once they are all computed
+       * there is nothing left to do at compute time */
+      result->is_computed = TRUE;
+      for (i = 0; i < n_values; i++)
+        result->is_computed &= values[i]->is_computed;
     }
   else
     {
@@ -70,9 +82,42 @@ gtk_css_calc_value_new_from_array (GtkCssValue **values,
 }
 
 
+/* Computed dimensions end up in the styles of lots of nodes, so
+ * they are interned: Equal values share one instance, which both saves
+ * memory and makes comparing them a pointer comparison.
+ * The table doesn't hold references, values remove themselves from it
+ * when they are freed.
+ */
+static GHashTable *interned_dimensions;
+
+static guint
+gtk_css_dimension_value_hash (gconstpointer data)
+{
+  const GtkCssValue *value = data;
+  double d = value->dimension.value == 0 ? 0 : value->dimension.value;
+
+  return g_double_hash (&d) ^ value->dimension.unit;
+}
+
+static gboolean
+gtk_css_dimension_value_equal (gconstpointer data1,
+                               gconstpointer data2)
+{
+  const GtkCssValue *value1 = data1;
+  const GtkCssValue *value2 = data2;
+
+  return value1->dimension.unit == value2->dimension.unit &&
+         value1->dimension.value == value2->dimension.value;
+}
+
 static void
 gtk_css_value_number_free (GtkCssValue *value)
 {
+  if (value->type == TYPE_DIMENSION &&
+      interned_dimensions != NULL &&
+      g_hash_table_lookup (interned_dimensions, value) == value)
+    g_hash_table_remove (interned_dimensions, value);
+
   g_slice_free (GtkCssValue, value);
 }
 
@@ -129,7 +174,8 @@ gtk_css_value_number_compute (GtkCssValue      *number,
 
       if (changed)
         {
-          result = gtk_css_calc_value_new_from_array (new_values, n_terms);
+          /* em, pt and friends are all px now, so add them up */
+          result = gtk_css_calc_value_new_folded (new_values, n_terms);
         }
       else
         {
@@ -389,6 +435,7 @@ gtk_css_dimension_value_new (double     value,
     { &GTK_CSS_VALUE_NUMBER, 1, TRUE, TYPE_DIMENSION, {{ GTK_CSS_DEG, 270 }} },
   };
   GtkCssValue *result;
+  gboolean is_computed;
 
   switch ((guint)unit)
     {
@@ -451,15 +498,37 @@ gtk_css_dimension_value_new (double     value,
       ;
     }
 
+  is_computed = value == 0 ||
+                unit == GTK_CSS_NUMBER ||
+                unit == GTK_CSS_PX ||
+                unit == GTK_CSS_DEG ||
+                unit == GTK_CSS_S;
+
+  /* NaN never compares equal, so it can't be looked up */
+  if (is_computed && !isnan (value))
+    {
+      GtkCssValue key;
+
+      if (interned_dimensions == NULL)
+        interned_dimensions = g_hash_table_new (gtk_css_dimension_value_hash,
+                                                gtk_css_dimension_value_equal);
+
+      key.dimension.unit = unit;
+      key.dimension.value = value;
+      result = g_hash_table_lookup (interned_dimensions, &key);
+      if (result)
+        return _gtk_css_value_ref (result);
+    }
+
   result = _gtk_css_value_new (GtkCssValue, &GTK_CSS_VALUE_NUMBER);
   result->type = TYPE_DIMENSION;
   result->dimension.unit = unit;
   result->dimension.value = value;
-  result->is_computed = value == 0 ||
-                        unit == GTK_CSS_NUMBER ||
-                        unit == GTK_CSS_PX ||
-                        unit == GTK_CSS_DEG ||
-                        unit == GTK_CSS_S;
+  result->is_computed = is_computed;
+
+  if (is_computed && !isnan (value))
+    g_hash_table_add (interned_dimensions, result);
+
   return result;
 }
 
@@ -526,6 +595,7 @@ gtk_css_calc_array_add (GPtrArray *array, GtkCssValue *value)
 
       if (sum)
         {
+          _gtk_css_value_unref (g_ptr_array_index (array, i));
           g_ptr_array_index (array, i) = sum;
           _gtk_css_value_unref (value);
           return;
@@ -582,6 +652,26 @@ gtk_css_calc_value_new_sum (GtkCssValue *value1,
   return result;
 }
 
+/* Takes ownership of @values and merges terms with the same unit */
+static GtkCssValue *
+gtk_css_calc_value_new_folded (GtkCssValue **values,
+                               guint         n_values)
+{
+  GPtrArray *array;
+  GtkCssValue *result;
+  guint i;
+
+  array = g_ptr_array_sized_new (n_values);
+
+  for (i = 0; i < n_values; i++)
+    gtk_css_calc_array_add (array, values[i]);
+
+  result = gtk_css_calc_value_new_from_array ((GtkCssValue **)array->pdata, array->len);
+  g_ptr_array_free (array, TRUE);
+
+  return result;
+}
+
 GtkCssDimension
 gtk_css_number_value_get_dimension (const GtkCssValue *value)
 {
@@ -735,9 +825,17 @@ _gtk_css_number_value_get (const GtkCssValue *value,
 
   g_assert (value->type == TYPE_CALC);
 
+  /* calc() terms are never calc() themselves, see gtk_css_calc_value_new_sum() */
   result = 0.0;
   for (i = 0; i < value->calc.n_terms; i++)
-    result += _gtk_css_number_value_get (value->calc.terms[i], one_hundred_percent);
+    {
+      const GtkCssValue *term = value->calc.terms[i];
+
+      if (term->dimension.unit == GTK_CSS_PERCENT)
+        result += term->dimension.value * one_hundred_percent / 100;
+      else
+        result += term->dimension.value;
+    }
 
   return result;
 }
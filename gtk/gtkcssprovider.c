@@ -28,6 +28,7 @@
 #include "gtkcsskeyframesprivate.h"
 #include "gtkcssselectorprivate.h"
 #include "gtkcssshorthandpropertyprivate.h"
+#include "gtkdebug.h"
 #include "gtksettingsprivate.h"
 #include "gtkstyleprovider.h"
 #include "gtkstylecontextprivate.h"
@@ -131,6 +132,17 @@ struct _GtkCssProviderPrivate
   GtkCssSelectorTree *tree;
   GResource *resource;
   char *path;
+
+  /* The rules from before the last reset, to find out what a reload
+   * changed. */
+  GHashTable *previous_symbolic_colors;
+  GHashTable *previous_keyframes;
+  GArray *previous_rulesets;
+  GtkCssSelectorTree *previous_tree;
+
+  /* Set if the reload only changed the declarations of these rules */
+  GtkCssSelectorTree *changed_selectors;
+  guint found_changes : 1;
 };
 
 enum {
@@ -384,7 +396,7 @@ gtk_css_scanner_would_recurse (GtkCssScanner *scanner,
 }
 
 static void
-gtk_css_provider_init (GtkCssProvider *css_provider)
+gtk_css_provider_init_rules (GtkCssProvider *css_provider)
 {
   GtkCssProviderPrivate *priv = gtk_css_provider_get_instance_private (css_provider);
 
@@ -398,6 +410,12 @@ gtk_css_provider_init (GtkCssProvider *css_provider)
                                            (GDestroyNotify) _gtk_css_keyframes_unref);
 }
 
+static void
+gtk_css_provider_init (GtkCssProvider *css_provider)
+{
+  gtk_css_provider_init_rules (css_provider);
+}
+
 static void
 verify_tree_match_results (GtkCssProvider        *provider,
                            GtkCssNode            *node,
@@ -516,6 +534,23 @@ gtk_css_style_provider_iface_init (GtkStyleProviderInterface *iface)
   iface->emit_error = gtk_css_style_provider_emit_error;
 }
 
+static void
+gtk_css_provider_clear_previous (GtkCssProvider *css_provider)
+{
+  GtkCssProviderPrivate *priv = gtk_css_provider_get_instance_private (css_provider);
+  guint i;
+
+  if (priv->previous_rulesets == NULL)
+    return;
+
+  for (i = 0; i < priv->previous_rulesets->len; i++)
+    gtk_css_ruleset_clear (&g_array_index (priv->previous_rulesets, GtkCssRuleset, i));
+  g_clear_pointer (&priv->previous_rulesets, g_array_unref);
+  g_clear_pointer (&priv->previous_tree, _gtk_css_selector_tree_free);
+  g_clear_pointer (&priv->previous_symbolic_colors, g_hash_table_unref);
+  g_clear_pointer (&priv->previous_keyframes, g_hash_table_unref);
+}
+
 static void
 gtk_css_provider_finalize (GObject *object)
 {
@@ -529,6 +564,9 @@ gtk_css_provider_finalize (GObject *object)
   g_array_free (priv->rulesets, TRUE);
   _gtk_css_selector_tree_free (priv->tree);
 
+  gtk_css_provider_clear_previous (css_provider);
+  _gtk_css_selector_tree_free (priv->changed_selectors);
+
   g_hash_table_destroy (priv->symbolic_colors);
   g_hash_table_destroy (priv->keyframes);
 
@@ -602,6 +640,19 @@ gtk_css_provider_reset (GtkCssProvider *css_provider)
       priv->path = NULL;
     }
 
+  /* Keep the old rules around until the new ones are loaded */
+  if (priv->previous_rulesets == NULL && priv->rulesets->len > 0)
+    {
+      priv->previous_symbolic_colors = priv->symbolic_colors;
+      priv->previous_keyframes = priv->keyframes;
+      priv->previous_rulesets = priv->rulesets;
+      priv->previous_tree = priv->tree;
+      priv->tree = NULL;
+
+      gtk_css_provider_init_rules (css_provider);
+      return;
+    }
+
   g_hash_table_remove_all (priv->symbolic_colors);
   g_hash_table_remove_all (priv->keyframes);
 
@@ -969,6 +1020,172 @@ gtk_css_provider_compare_rule (gconstpointer a_,
   return 0;
 }
 
+static gboolean
+symbolic_colors_equal (GHashTable *colors1,
+                       GHashTable *colors2)
+{
+  GHashTableIter iter;
+  gpointer name, color;
+
+  if (g_hash_table_size (colors1) != g_hash_table_size (colors2))
+    return FALSE;
+
+  g_hash_table_iter_init (&iter, colors1);
+  while (g_hash_table_iter_next (&iter, &name, &color))
+    {
+      GtkCssValue *other = g_hash_table_lookup (colors2, name);
+
+      if (other == NULL || !_gtk_css_value_equal (color, other))
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
+static gboolean
+keyframes_equal (GHashTable *keyframes1,
+                 GHashTable *keyframes2)
+{
+  GHashTableIter iter;
+  gpointer name, keyframes;
+  GString *str1, *str2;
+  gboolean result = TRUE;
+
+  if (g_hash_table_size (keyframes1) != g_hash_table_size (keyframes2))
+    return FALSE;
+
+  str1 = g_string_new (NULL);
+  str2 = g_string_new (NULL);
+
+  g_hash_table_iter_init (&iter, keyframes1);
+  while (result && g_hash_table_iter_next (&iter, &name, &keyframes))
+    {
+      GtkCssKeyframes *other = g_hash_table_lookup (keyframes2, name);
+
+      if (other == NULL)
+        {
+          result = FALSE;
+          break;
+        }
+
+      g_string_truncate (str1, 0);
+      g_string_truncate (str2, 0);
+      _gtk_css_keyframes_print (keyframes, str1);
+      _gtk_css_keyframes_print (other, str2);
+      result = g_string_equal (str1, str2);
+    }
+
+  g_string_free (str1, TRUE);
+  g_string_free (str2, TRUE);
+
+  return result;
+}
+
+static gboolean
+gtk_css_ruleset_styles_equal (const GtkCssRuleset *ruleset1,
+                              const GtkCssRuleset *ruleset2)
+{
+  guint i;
+
+  if (ruleset1->n_styles != ruleset2->n_styles)
+    return FALSE;
+
+  for (i = 0; i < ruleset1->n_styles; i++)
+    {
+      if (ruleset1->styles[i].property != ruleset2->styles[i].property ||
+          !_gtk_css_value_equal (ruleset1->styles[i].value, ruleset2->styles[i].value))
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
+/* Compares the rules of a reload with the previous ones. If only the
+ * declarations of some rules differ, only nodes matching those rules
+ * need to be restyled, so collect their selectors.
+ *
+ * The selectors of the previous rules are gone by now, so compare them
+ * as printed from the trees. Identical selectors build identical trees,
+ * so they print the same.
+ */
+static void
+gtk_css_provider_find_changed_rules (GtkCssProvider *css_provider)
+{
+  GtkCssProviderPrivate *priv = gtk_css_provider_get_instance_private (css_provider);
+  GtkCssSelectorTreeBuilder *builder;
+  GString *str1, *str2;
+  guint i, n_changed;
+
+  if (priv->previous_rulesets == NULL)
+    return;
+
+  if (priv->previous_rulesets->len != priv->rulesets->len ||
+      !symbolic_colors_equal (priv->previous_symbolic_colors, priv->symbolic_colors) ||
+      !keyframes_equal (priv->previous_keyframes, priv->keyframes))
+    {
+      gtk_css_provider_clear_previous (css_provider);
+      return;
+    }
+
+  builder = _gtk_css_selector_tree_builder_new ();
+  str1 = g_string_new (NULL);
+  str2 = g_string_new (NULL);
+  n_changed = 0;
+
+  for (i = 0; i < priv->rulesets->len; i++)
+    {
+      GtkCssRuleset *previous = &g_array_index (priv->previous_rulesets, GtkCssRuleset, i);
+      GtkCssRuleset *ruleset = &g_array_index (priv->rulesets, GtkCssRuleset, i);
+
+      g_string_truncate (str1, 0);
+      g_string_truncate (str2, 0);
+      _gtk_css_selector_tree_match_print (previous->selector_match, str1);
+      _gtk_css_selector_tree_match_print (ruleset->selector_match, str2);
+      if (!g_string_equal (str1, str2))
+        break;
+
+      if (!gtk_css_ruleset_styles_equal (previous, ruleset))
+        {
+          _gtk_css_selector_tree_builder_add (builder, ruleset->selector, NULL, ruleset);
+          n_changed++;
+        }
+    }
+
+  if (i == priv->rulesets->len)
+    {
+      priv->found_changes = TRUE;
+      if (n_changed > 0)
+        priv->changed_selectors = _gtk_css_selector_tree_builder_build (builder);
+    }
+
+  g_string_free (str1, TRUE);
+  g_string_free (str2, TRUE);
+  _gtk_css_selector_tree_builder_free (builder);
+  gtk_css_provider_clear_previous (css_provider);
+}
+
+static void
+gtk_css_provider_emit_changed (GtkCssProvider *css_provider)
+{
+  GtkCssProviderPrivate *priv = gtk_css_provider_get_instance_private (css_provider);
+
+  if (priv->found_changes)
+    {
+      priv->found_changes = FALSE;
+      if (priv->changed_selectors)
+        {
+          gtk_style_provider_changed_selectors (GTK_STYLE_PROVIDER (css_provider),
+                                                priv->changed_selectors);
+          g_clear_pointer (&priv->changed_selectors, _gtk_css_selector_tree_free);
+        }
+      return;
+    }
+
+  /* Loading failed or changed more than declarations */
+  gtk_css_provider_clear_previous (css_provider);
+  gtk_style_provider_changed (GTK_STYLE_PROVIDER (css_provider));
+}
+
 static void
 gtk_css_provider_postprocess (GtkCssProvider *css_provider)
 {
@@ -997,6 +1214,8 @@ gtk_css_provider_postprocess (GtkCssProvider *css_provider)
   priv->tree = _gtk_css_selector_tree_builder_build (builder);
   _gtk_css_selector_tree_builder_free (builder);
 
+  gtk_css_provider_find_changed_rules (css_provider);
+
 #ifndef VERIFY_TREE
   for (i = 0; i < priv->rulesets->len; i++)
     {
@@ -1012,6 +1231,95 @@ gtk_css_provider_postprocess (GtkCssProvider *css_provider)
   gdk_profiler_end_mark (before, "create selector tree", NULL);
 }
 
+/* Themes are mostly loaded from the same few files over and over, so
+ * we keep their precompiled token streams in the user's cache dir,
+ * keyed by a checksum of the GTK version and the CSS. Replaying those
+ * skips tokenizing, but still builds the rulesets and selector tree,
+ * which reference interned strings and values that only exist in the
+ * running process.
+ */
+static char *
+gtk_css_provider_get_cache_path (GBytes *bytes)
+{
+  GChecksum *checksum;
+  char *path;
+
+  checksum = g_checksum_new (G_CHECKSUM_SHA256);
+  g_checksum_update (checksum, (const guchar *) GTK_VERSION, strlen (GTK_VERSION) + 1);
+  g_checksum_update (checksum, g_bytes_get_data (bytes, NULL), g_bytes_get_size (bytes));
+
+  path = g_build_filename (g_get_user_cache_dir (),
+                           "gtk-4.0",
+                           "css",
+                           g_checksum_get_string (checksum),
+                           NULL);
+
+  g_checksum_free (checksum);
+
+  return path;
+}
+
+static gboolean
+gtk_css_provider_use_precompiled (void)
+{
+#ifdef G_ENABLE_DEBUG
+  if (GTK_DEBUG_CHECK (NO_CSS_CACHE))
+    return FALSE;
+#endif
+
+  return TRUE;
+}
+
+/* Takes a reference to @bytes and returns the data to parse instead.
+ * This may be called from any thread. */
+static GBytes *
+gtk_css_provider_lookup_precompiled (GBytes *bytes)
+{
+  GMappedFile *mapped;
+  GBytes *precompiled;
+  char *path, *dir;
+
+  path = gtk_css_provider_get_cache_path (bytes);
+
+  mapped = g_mapped_file_new (path, FALSE, NULL);
+  if (mapped)
+    {
+      precompiled = g_mapped_file_get_bytes (mapped);
+      g_mapped_file_unref (mapped);
+
+      if (gtk_css_tokenizer_is_precompiled (precompiled))
+        {
+          g_free (path);
+          g_bytes_unref (bytes);
+          return precompiled;
+        }
+
+      g_bytes_unref (precompiled);
+    }
+
+  /* Files with syntax errors don't get precompiled, so that
+   * the errors are reported every time */
+  precompiled = gtk_css_tokenizer_precompile (bytes);
+  if (precompiled == NULL)
+    {
+      g_free (path);
+      return bytes;
+    }
+
+  dir = g_path_get_dirname (path);
+  if (g_mkdir_with_parents (dir, 0700) == 0)
+    g_file_set_contents (path,
+                         g_bytes_get_data (precompiled, NULL),
+                         g_bytes_get_size (precompiled),
+                         NULL);
+  g_free (dir);
+  g_free (path);
+
+  g_bytes_unref (bytes);
+
+  return precompiled;
+}
+
 static void
 gtk_css_provider_load_internal (GtkCssProvider *self,
                                 GtkCssScanner  *parent,
@@ -1048,6 +1356,10 @@ gtk_css_provider_load_internal (GtkCssProvider *self,
                                     load_error->message);
             }
         }
+      else if (gtk_css_provider_use_precompiled ())
+        {
+          bytes = gtk_css_provider_lookup_precompiled (bytes);
+        }
     }
 
   if (bytes)
@@ -1109,7 +1421,7 @@ gtk_css_provider_load_from_data (GtkCssProvider  *css_provider,
   gtk_css_provider_load_internal (css_provider, NULL, NULL, bytes);
   g_bytes_unref (bytes);
 
-  gtk_style_provider_changed (GTK_STYLE_PROVIDER (css_provider));
+  gtk_css_provider_emit_changed (css_provider);
 }
 
 /**
@@ -1131,7 +1443,145 @@ gtk_css_provider_load_from_file (GtkCssProvider  *css_provider,
 
   gtk_css_provider_load_internal (css_provider, NULL, file, NULL);
 
-  gtk_style_provider_changed (GTK_STYLE_PROVIDER (css_provider));
+  gtk_css_provider_emit_changed (css_provider);
+}
+
+typedef struct {
+  GFile *file;
+  gboolean precompile;
+} LoadData;
+
+static void
+load_data_free (gpointer data)
+{
+  LoadData *load = data;
+
+  g_object_unref (load->file);
+  g_free (load);
+}
+
+static void
+gtk_css_provider_load_thread (GTask        *task,
+                              gpointer      source_object,
+                              gpointer      task_data,
+                              GCancellable *cancellable)
+{
+  LoadData *load = task_data;
+  GBytes *bytes;
+  GError *error = NULL;
+
+  bytes = g_file_load_bytes (load->file, cancellable, NULL, &error);
+  if (bytes == NULL)
+    {
+      g_task_return_error (task, error);
+      return;
+    }
+
+  /* Tokenizing is all that can be done here, parsing creates
+   * values, which must only happen on the main thread */
+  if (load->precompile)
+    bytes = gtk_css_provider_lookup_precompiled (bytes);
+
+  g_task_return_pointer (task, bytes, (GDestroyNotify) g_bytes_unref);
+}
+
+static void
+gtk_css_provider_load_thread_done (GObject      *source_object,
+                                   GAsyncResult *result,
+                                   gpointer      data)
+{
+  GtkCssProvider *css_provider = GTK_CSS_PROVIDER (source_object);
+  GTask *task = data;
+  GBytes *bytes;
+  GError *error = NULL;
+
+  bytes = g_task_propagate_pointer (G_TASK (result), &error);
+  if (bytes == NULL)
+    {
+      g_task_return_error (task, error);
+      g_object_unref (task);
+      return;
+    }
+
+  gtk_css_provider_reset (css_provider);
+
+  gtk_css_provider_load_internal (css_provider, NULL, g_task_get_task_data (task), bytes);
+
+  gtk_css_provider_emit_changed (css_provider);
+
+  g_task_return_boolean (task, TRUE);
+  g_object_unref (task);
+}
+
+/**
+ * gtk_css_provider_load_from_file_async:
+ * @css_provider: a #GtkCssProvider
+ * @file: #GFile pointing to a file to load
+ * @cancellable: (nullable): a #GCancellable
+ * @callback: (scope async): callback to call when the file is loaded
+ * @user_data: the data to pass to @callback
+ *
+ * Asynchronously loads the data contained in @file into @css_provider,
+ * like gtk_css_provider_load_from_file().
+ *
+ * The file is read and tokenized in a thread. The previously loaded
+ * information stays in use until the new one has been parsed, which
+ * happens right before @callback is called.
+ *
+ * If the file can't be read, the previously loaded information is
+ * kept and gtk_css_provider_load_from_file_finish() returns the error.
+ * Syntax errors are reported via #GtkCssProvider::parsing-error as
+ * usual.
+ */
+void
+gtk_css_provider_load_from_file_async (GtkCssProvider      *css_provider,
+                                       GFile               *file,
+                                       GCancellable        *cancellable,
+                                       GAsyncReadyCallback  callback,
+                                       gpointer             user_data)
+{
+  GTask *task, *thread_task;
+  LoadData *load;
+
+  g_return_if_fail (GTK_IS_CSS_PROVIDER (css_provider));
+  g_return_if_fail (G_IS_FILE (file));
+  g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+
+  task = g_task_new (css_provider, cancellable, callback, user_data);
+  g_task_set_source_tag (task, gtk_css_provider_load_from_file_async);
+  g_task_set_task_data (task, g_object_ref (file), g_object_unref);
+
+  load = g_new (LoadData, 1);
+  load->file = g_object_ref (file);
+  load->precompile = gtk_css_provider_use_precompiled ();
+
+  thread_task = g_task_new (css_provider, cancellable, gtk_css_provider_load_thread_done, task);
+  g_task_set_task_data (thread_task, load, load_data_free);
+  g_task_run_in_thread (thread_task, gtk_css_provider_load_thread);
+  g_object_unref (thread_task);
+}
+
+/**
+ * gtk_css_provider_load_from_file_finish:
+ * @css_provider: a #GtkCssProvider
+ * @result: a #GAsyncResult
+ * @error: return location for a #GError, or %NULL
+ *
+ * Finishes an operation started with
+ * gtk_css_provider_load_from_file_async().
+ *
+ * Returns: %TRUE if the file was loaded
+ */
+gboolean
+gtk_css_provider_load_from_file_finish (GtkCssProvider  *css_provider,
+                                        GAsyncResult    *result,
+                                        GError         **error)
+{
+  g_return_val_if_fail (GTK_IS_CSS_PROVIDER (css_provider), FALSE);
+  g_return_val_if_fail (g_task_is_valid (result, css_provider), FALSE);
+  g_return_val_if_fail (g_task_get_source_tag (G_TASK (result)) == gtk_css_provider_load_from_file_async, FALSE);
+
+  return g_task_propagate_boolean (G_TASK (result), error);
 }
 
 /**
@@ -24,6 +24,7 @@
 
 #include "gtkcssprovider.h"
 #include "gtkstylecontextprivate.h"
+#include "gdk/gdkprofilerprivate.h"
 
 #include <errno.h>
 #if defined(_MSC_VER) && _MSC_VER >= 1500
@@ -114,6 +115,10 @@ union _GtkCssSelector
     gssize                       a :POSITION_NUMBER_BITS;
     gssize                       b :POSITION_NUMBER_BITS;
   }                              position;
+  struct {
+    const GtkCssSelectorClass   *class;         /* always NULL */
+    guint                        n_buckets;
+  }                              index;
 };
 
 #define GTK_CSS_SELECTOR_TREE_EMPTY_OFFSET G_MAXINT32
@@ -126,6 +131,24 @@ struct _GtkCssSelectorTree
   gint32 matches_offset; /* pointers that we return as matches if selector matches */
 };
 
+/* The tree returned by the builder starts with a root node that has
+ * no selector. It is followed by selector.index.n_buckets buckets,
+ * sorted by their key. Every bucket holds the subtree for all rules
+ * whose rightmost compound selector contains the bucket's key, an id,
+ * a class or a name. Only the subtrees for the keys a node has need
+ * to be matched. The rare rules without a key can match any node.
+ * They are kept in the subtree at the root's previous_offset.
+ */
+typedef struct
+{
+  GtkCssSelector key;
+  gint32 offset; /* relative to the root */
+} GtkCssSelectorTreeBucket;
+
+static guint tested_selectors;
+static guint tested_selectors_counter;
+static guint matched_selectors_counter;
+
 static gboolean
 gtk_css_selector_equal (const GtkCssSelector *a,
 			const GtkCssSelector *b)
@@ -1903,6 +1926,8 @@ gtk_css_selector_tree_match (const GtkCssSelectorTree      *tree,
       !gtk_counting_bloom_filter_may_contain (filter, gtk_css_selector_hash_one (&tree->selector)))
     return FALSE;
 
+  tested_selectors++;
+
   if (!gtk_css_selector_match_one (&tree->selector, node))
     return TRUE;
 
@@ -1927,19 +1952,85 @@ gtk_css_selector_tree_match (const GtkCssSelectorTree      *tree,
   return TRUE;
 }
 
+static inline const GtkCssSelectorTreeBucket *
+gtk_css_selector_tree_get_buckets (const GtkCssSelectorTree *root)
+{
+  return (const GtkCssSelectorTreeBucket *) (root + 1);
+}
+
+static const GtkCssSelectorTree *
+gtk_css_selector_tree_find_bucket (const GtkCssSelectorTree  *root,
+                                   const GtkCssSelectorClass *class,
+                                   GQuark                     quark)
+{
+  const GtkCssSelectorTreeBucket *buckets = gtk_css_selector_tree_get_buckets (root);
+  GtkCssSelector key = { .name = { class, quark } };
+  guint start, end, mid;
+  int cmp;
+
+  start = 0;
+  end = root->selector.index.n_buckets;
+  while (start < end)
+    {
+      mid = (start + end) / 2;
+      cmp = gtk_css_selector_compare_one (&key, &buckets[mid].key);
+      if (cmp == 0)
+        return gtk_css_selector_tree_at_offset (root, buckets[mid].offset);
+      else if (cmp < 0)
+        end = mid;
+      else
+        start = mid + 1;
+    }
+
+  return NULL;
+}
+
+static void
+gtk_css_selector_tree_match_siblings (const GtkCssSelectorTree     *tree,
+                                      const GtkCountingBloomFilter *filter,
+                                      GtkCssNode                   *node,
+                                      GtkCssSelectorMatches        *results)
+{
+  for (; tree != NULL;
+       tree = gtk_css_selector_tree_get_sibling (tree))
+    gtk_css_selector_tree_match (tree, filter, FALSE, node, results);
+}
+
 void
 _gtk_css_selector_tree_match_all (const GtkCssSelectorTree     *tree,
                                   const GtkCountingBloomFilter *filter,
                                   GtkCssNode                   *node,
                                   GtkCssSelectorMatches        *out_tree_rules)
 {
-  const GtkCssSelectorTree *iter;
+  const GQuark *classes;
+  guint i, n_classes;
+  gsize n_matches;
+  GQuark id;
+
+  tested_selectors = 0;
+  n_matches = gtk_css_selector_matches_get_size (out_tree_rules);
+
+  gtk_css_selector_tree_match_siblings (gtk_css_selector_tree_get_previous (tree),
+                                        filter, node, out_tree_rules);
 
-  for (iter = tree;
-       iter != NULL;
-       iter = gtk_css_selector_tree_get_sibling (iter))
+  gtk_css_selector_tree_match_siblings (gtk_css_selector_tree_find_bucket (tree, &GTK_CSS_SELECTOR_NAME, gtk_css_node_get_name (node)),
+                                        filter, node, out_tree_rules);
+
+  id = gtk_css_node_get_id (node);
+  if (id)
+    gtk_css_selector_tree_match_siblings (gtk_css_selector_tree_find_bucket (tree, &GTK_CSS_SELECTOR_ID, id),
+                                          filter, node, out_tree_rules);
+
+  classes = gtk_css_node_declaration_get_classes (gtk_css_node_get_declaration (node), &n_classes);
+  for (i = 0; i < n_classes; i++)
+    gtk_css_selector_tree_match_siblings (gtk_css_selector_tree_find_bucket (tree, &GTK_CSS_SELECTOR_CLASS, classes[i]),
+                                          filter, node, out_tree_rules);
+
+  if (GDK_PROFILER_IS_RUNNING)
     {
-      gtk_css_selector_tree_match (iter, filter, FALSE, node, out_tree_rules);
+      gdk_profiler_set_int_counter (tested_selectors_counter, tested_selectors);
+      gdk_profiler_set_int_counter (matched_selectors_counter,
+                                    gtk_css_selector_matches_get_size (out_tree_rules) - n_matches);
     }
 }
 
@@ -1949,16 +2040,45 @@ _gtk_css_selector_tree_is_empty (const GtkCssSelectorTree *tree)
   return tree == NULL;
 }
 
+static GtkCssChange
+gtk_css_selector_tree_get_change_siblings (const GtkCssSelectorTree     *tree,
+                                           const GtkCountingBloomFilter *filter,
+                                           GtkCssNode                   *node)
+{
+  GtkCssChange change = 0;
+
+  for (; tree != NULL;
+       tree = gtk_css_selector_tree_get_sibling (tree))
+    change |= gtk_css_selector_tree_get_change (tree, filter, node, FALSE);
+
+  return change;
+}
+
 GtkCssChange
 gtk_css_selector_tree_get_change_all (const GtkCssSelectorTree     *tree,
                                       const GtkCountingBloomFilter *filter,
 				      GtkCssNode                   *node)
 {
   GtkCssChange change = 0;
+  const GQuark *classes;
+  guint i, n_classes;
+  GQuark id;
 
-  for (; tree != NULL;
-       tree = gtk_css_selector_tree_get_sibling (tree))
-    change |= gtk_css_selector_tree_get_change (tree, filter, node, FALSE);
+  change |= gtk_css_selector_tree_get_change_siblings (gtk_css_selector_tree_get_previous (tree),
+                                                       filter, node);
+
+  change |= gtk_css_selector_tree_get_change_siblings (gtk_css_selector_tree_find_bucket (tree, &GTK_CSS_SELECTOR_NAME, gtk_css_node_get_name (node)),
+                                                       filter, node);
+
+  id = gtk_css_node_get_id (node);
+  if (id)
+    change |= gtk_css_selector_tree_get_change_siblings (gtk_css_selector_tree_find_bucket (tree, &GTK_CSS_SELECTOR_ID, id),
+                                                         filter, node);
+
+  classes = gtk_css_node_declaration_get_classes (gtk_css_node_get_declaration (node), &n_classes);
+  for (i = 0; i < n_classes; i++)
+    change |= gtk_css_selector_tree_get_change_siblings (gtk_css_selector_tree_find_bucket (tree, &GTK_CSS_SELECTOR_CLASS, classes[i]),
+                                                         filter, node);
 
   /* Never return reserved bit set */
   return change & ~GTK_CSS_CHANGE_RESERVED_BIT;
@@ -2218,6 +2338,12 @@ _gtk_css_selector_tree_builder_new (void)
 {
   GtkCssSelectorTreeBuilder *builder = g_new0 (GtkCssSelectorTreeBuilder, 1);
 
+  if (GDK_PROFILER_IS_RUNNING && tested_selectors_counter == 0)
+    {
+      tested_selectors_counter = gdk_profiler_define_int_counter ("tested-selectors", "CSS Selectors tested per node");
+      matched_selectors_counter = gdk_profiler_define_int_counter ("matched-selectors", "CSS Selectors matched per node");
+    }
+
   builder->infos = g_array_new (FALSE, TRUE, sizeof (GtkCssSelectorRuleSetInfo));
 
   return builder;
@@ -2269,23 +2395,116 @@ fixup_offsets (GtkCssSelectorTree *tree, guint8 *data)
     }
 }
 
+/* Prefer the most selective key, like other engines do */
+static const GtkCssSelector *
+gtk_css_selectors_get_bucket_key (const GtkCssSelector *selector)
+{
+  const GtkCssSelector *name = NULL;
+  const GtkCssSelector *style_class = NULL;
+
+  for (;
+       selector && gtk_css_selector_is_simple (selector);
+       selector = gtk_css_selector_previous (selector))
+    {
+      if (selector->class == &GTK_CSS_SELECTOR_ID)
+        return selector;
+      else if (selector->class == &GTK_CSS_SELECTOR_CLASS && style_class == NULL)
+        style_class = selector;
+      else if (selector->class == &GTK_CSS_SELECTOR_NAME && name == NULL)
+        name = selector;
+    }
+
+  return style_class ? style_class : name;
+}
+
+static int
+compare_bucket_keys (gconstpointer a,
+                     gconstpointer b)
+{
+  return gtk_css_selector_compare_one (*(const GtkCssSelector **) a,
+                                       *(const GtkCssSelector **) b);
+}
+
 GtkCssSelectorTree *
 _gtk_css_selector_tree_builder_build (GtkCssSelectorTreeBuilder *builder)
 {
   GtkCssSelectorTree *tree;
+  GtkCssSelectorTreeBucket *buckets;
   GByteArray *array;
   guint8 *data;
   guint len;
   guint i;
   GtkCssSelectorRuleSetInfo **infos_array;
+  guint n_infos;
+  GHashTable *keyed_infos;
+  const GtkCssSelector **keys;
+  guint n_keys;
+  gint32 root_offset, offset;
+
+  if (builder->infos->len == 0)
+    return NULL;
 
   array = g_byte_array_new ();
 
+  tree = alloc_tree (array, &root_offset);
+  g_assert (root_offset == 0);
+  tree->parent_offset = GTK_CSS_SELECTOR_TREE_EMPTY_OFFSET;
+  tree->sibling_offset = GTK_CSS_SELECTOR_TREE_EMPTY_OFFSET;
+  tree->matches_offset = GTK_CSS_SELECTOR_TREE_EMPTY_OFFSET;
+
+  keyed_infos = g_hash_table_new_full ((GHashFunc) gtk_css_selector_hash_one,
+                                       (GEqualFunc) gtk_css_selector_equal,
+                                       NULL,
+                                       (GDestroyNotify) g_ptr_array_unref);
+
   infos_array = g_alloca (sizeof (GtkCssSelectorRuleSetInfo *) * builder->infos->len);
+  n_infos = 0;
   for (i = 0; i < builder->infos->len; i++)
-    infos_array[i] = &g_array_index (builder->infos, GtkCssSelectorRuleSetInfo, i);
+    {
+      GtkCssSelectorRuleSetInfo *info = &g_array_index (builder->infos, GtkCssSelectorRuleSetInfo, i);
+      const GtkCssSelector *key = gtk_css_selectors_get_bucket_key (info->current_selector);
+
+      if (key)
+        {
+          GPtrArray *infos = g_hash_table_lookup (keyed_infos, key);
+
+          if (infos == NULL)
+            {
+              infos = g_ptr_array_new ();
+              g_hash_table_insert (keyed_infos, (gpointer) key, infos);
+            }
+          g_ptr_array_add (infos, info);
+        }
+      else
+        {
+          infos_array[n_infos++] = info;
+        }
+    }
+
+  keys = (const GtkCssSelector **) g_hash_table_get_keys_as_array (keyed_infos, &n_keys);
+  qsort (keys, n_keys, sizeof (GtkCssSelector *), compare_bucket_keys);
+
+  g_byte_array_set_size (array, array->len + n_keys * sizeof (GtkCssSelectorTreeBucket));
+  get_tree (array, root_offset)->selector.index.n_buckets = n_keys;
+
+  for (i = 0; i < n_keys; i++)
+    {
+      GPtrArray *infos = g_hash_table_lookup (keyed_infos, keys[i]);
+
+      offset = subdivide_infos (array,
+                                (GtkCssSelectorRuleSetInfo **) infos->pdata,
+                                infos->len,
+                                GTK_CSS_SELECTOR_TREE_EMPTY_OFFSET);
+      buckets = (GtkCssSelectorTreeBucket *) (get_tree (array, root_offset) + 1);
+      buckets[i].key = *keys[i];
+      buckets[i].offset = offset;
+    }
+
+  offset = subdivide_infos (array, infos_array, n_infos, GTK_CSS_SELECTOR_TREE_EMPTY_OFFSET);
+  get_tree (array, root_offset)->previous_offset = offset;
 
-  subdivide_infos (array, infos_array, builder->infos->len, GTK_CSS_SELECTOR_TREE_EMPTY_OFFSET);
+  g_free (keys);
+  g_hash_table_unref (keyed_infos);
 
   len = array->len;
   data = g_byte_array_free (array, FALSE);
@@ -2295,7 +2514,12 @@ _gtk_css_selector_tree_builder_build (GtkCssSelectorTreeBuilder *builder)
 
   tree = (GtkCssSelectorTree *)data;
 
+  /* The root is at offset 0, so the offsets of the buckets are
+   * already relative to it */
   fixup_offsets (tree, data);
+  buckets = (GtkCssSelectorTreeBucket *) gtk_css_selector_tree_get_buckets (tree);
+  for (i = 0; i < tree->selector.index.n_buckets; i++)
+    fixup_offsets ((GtkCssSelectorTree *) gtk_css_selector_tree_at_offset (tree, buckets[i].offset), data);
 
   /* Convert offsets to final pointers */
   for (i = 0; i < builder->infos->len; i++)
@@ -2310,7 +2534,9 @@ _gtk_css_selector_tree_builder_build (GtkCssSelectorTreeBuilder *builder)
 #ifdef PRINT_TREE
   {
     GString *s = g_string_new ("");
-    _gtk_css_selector_tree_print (tree, s, "");
+    _gtk_css_selector_tree_print (gtk_css_selector_tree_get_previous (tree), s, "");
+    for (i = 0; i < tree->selector.index.n_buckets; i++)
+      _gtk_css_selector_tree_print (gtk_css_selector_tree_at_offset (tree, buckets[i].offset), s, "");
     g_print ("%s", s->str);
     g_string_free (s, TRUE);
   }
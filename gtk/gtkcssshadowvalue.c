@@ -95,11 +95,71 @@ shadow_value_transition (const ShadowValue *start,
   return TRUE;
 }
 
+/* Computed shadows are interned, too. Their lengths and colors are
+ * interned already, so comparing those by pointer is enough to find
+ * equal shadows. The table doesn't hold references.
+ */
+static GHashTable *interned_shadows;
+
+static guint
+gtk_css_shadow_value_hash (gconstpointer data)
+{
+  const GtkCssValue *value = data;
+  guint i, hash;
+
+  hash = value->n_shadows;
+  for (i = 0; i < value->n_shadows; i++)
+    {
+      const ShadowValue *shadow = &value->shadows[i];
+
+      hash = (hash << 5) - hash + shadow->inset;
+      hash = (hash << 5) - hash + g_direct_hash (shadow->hoffset);
+      hash = (hash << 5) - hash + g_direct_hash (shadow->voffset);
+      hash = (hash << 5) - hash + g_direct_hash (shadow->radius);
+      hash = (hash << 5) - hash + g_direct_hash (shadow->spread);
+      hash = (hash << 5) - hash + g_direct_hash (shadow->color);
+    }
+
+  return hash;
+}
+
+static gboolean
+gtk_css_shadow_value_equal (gconstpointer data1,
+                            gconstpointer data2)
+{
+  const GtkCssValue *value1 = data1;
+  const GtkCssValue *value2 = data2;
+  guint i;
+
+  if (value1->n_shadows != value2->n_shadows)
+    return FALSE;
+
+  for (i = 0; i < value1->n_shadows; i++)
+    {
+      const ShadowValue *shadow1 = &value1->shadows[i];
+      const ShadowValue *shadow2 = &value2->shadows[i];
+
+      if (shadow1->inset != shadow2->inset ||
+          shadow1->hoffset != shadow2->hoffset ||
+          shadow1->voffset != shadow2->voffset ||
+          shadow1->radius != shadow2->radius ||
+          shadow1->spread != shadow2->spread ||
+          shadow1->color != shadow2->color)
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
 static void
 gtk_css_value_shadow_free (GtkCssValue *value)
 {
   guint i;
 
+  if (interned_shadows != NULL &&
+      g_hash_table_lookup (interned_shadows, value) == value)
+    g_hash_table_remove (interned_shadows, value);
+
   for (i = 0; i < value->n_shadows; i ++)
     {
       const ShadowValue *shadow = &value->shadows[i];
@@ -152,11 +212,11 @@ gtk_css_value_shadow_equal (const GtkCssValue *value1,
       const ShadowValue *shadow2 = &value2->shadows[i];
 
       if (shadow1->inset != shadow2->inset ||
-          _gtk_css_value_equal (shadow1->hoffset, shadow2->hoffset) ||
-          _gtk_css_value_equal (shadow1->voffset, shadow2->voffset) ||
-          _gtk_css_value_equal (shadow1->radius, shadow2->radius) ||
-          _gtk_css_value_equal (shadow1->spread, shadow2->spread) ||
-          _gtk_css_value_equal (shadow1->color, shadow2->color))
+          !_gtk_css_value_equal (shadow1->hoffset, shadow2->hoffset) ||
+          !_gtk_css_value_equal (shadow1->voffset, shadow2->voffset) ||
+          !_gtk_css_value_equal (shadow1->radius, shadow2->radius) ||
+          !_gtk_css_value_equal (shadow1->spread, shadow2->spread) ||
+          !_gtk_css_value_equal (shadow1->color, shadow2->color))
         return FALSE;
     }
 
@@ -327,6 +387,25 @@ gtk_css_shadow_value_new (ShadowValue *shadows,
         }
     }
 
+  if (retval->is_computed)
+    {
+      GtkCssValue *interned;
+
+      if (interned_shadows == NULL)
+        interned_shadows = g_hash_table_new (gtk_css_shadow_value_hash,
+                                             gtk_css_shadow_value_equal);
+
+      interned = g_hash_table_lookup (interned_shadows, retval);
+      if (interned)
+        {
+          /* Drops the references to the shadows, too */
+          _gtk_css_value_unref (retval);
+          return _gtk_css_value_ref (interned);
+        }
+
+      g_hash_table_add (interned_shadows, retval);
+    }
+
   return retval;
 }
 
@@ -252,6 +252,117 @@ DEFINE_VALUES (TRANSITION, Transition, transition)
 DEFINE_VALUES (SIZE, Size, size)
 DEFINE_VALUES (OTHER, Other, other)
 
+/* Almost no widgets draw outlines or use font variants, but themes set
+ * them for lots of nodes. So instead of computing those groups right
+ * away, we keep what the lookup found for them and compute them when
+ * they are first used.
+ */
+struct _GtkCssLazyValues
+{
+  GtkStyleProvider *provider;
+  GtkCssStyle *parent_style;
+  GtkCssLookupValue outline[G_N_ELEMENTS (outline_props)];
+  GtkCssLookupValue font_variant[G_N_ELEMENTS (font_variant_props)];
+};
+
+static void
+gtk_css_lazy_values_clear (GtkCssLookupValue *values,
+                           guint              n_values)
+{
+  guint i;
+
+  for (i = 0; i < n_values; i++)
+    {
+      g_clear_pointer (&values[i].value, gtk_css_value_unref);
+      g_clear_pointer (&values[i].section, gtk_css_section_unref);
+    }
+}
+
+static void
+gtk_css_lazy_values_free (GtkCssLazyValues *lazy)
+{
+  gtk_css_lazy_values_clear (lazy->outline, G_N_ELEMENTS (lazy->outline));
+  gtk_css_lazy_values_clear (lazy->font_variant, G_N_ELEMENTS (lazy->font_variant));
+  g_clear_object (&lazy->provider);
+  g_clear_object (&lazy->parent_style);
+
+  g_slice_free (GtkCssLazyValues, lazy);
+}
+
+#define DEFINE_LAZY_VALUES(ENUM, TYPE, NAME) \
+static void \
+gtk_css_ ## NAME ## _values_defer_compute (GtkCssStaticStyle *sstyle, \
+                                           GtkStyleProvider  *provider, \
+                                           GtkCssStyle       *parent_style, \
+                                           GtkCssLookup      *lookup) \
+{ \
+  int i; \
+\
+  if (sstyle->lazy == NULL) \
+    { \
+      sstyle->lazy = g_slice_new0 (GtkCssLazyValues); \
+      sstyle->lazy->provider = g_object_ref (provider); \
+      sstyle->lazy->parent_style = parent_style ? g_object_ref (parent_style) : NULL; \
+    } \
+\
+  for (i = 0; i < G_N_ELEMENTS (NAME ## _props); i++) \
+    { \
+      guint id = NAME ## _props[i]; \
+      GtkCssLookupValue *value = &sstyle->lazy->NAME[i]; \
+\
+      if (lookup->values[id].value) \
+        value->value = gtk_css_value_ref (lookup->values[id].value); \
+      if (lookup->values[id].section) \
+        value->section = gtk_css_section_ref (lookup->values[id].section); \
+    } \
+} \
+\
+static void \
+gtk_css_ ## NAME ## _values_lazy_compute (GtkCssStaticStyle *sstyle) \
+{ \
+  GtkCssStyle *style = (GtkCssStyle *)sstyle; \
+  GtkCssLazyValues *lazy = sstyle->lazy; \
+  int i; \
+\
+  style->NAME = (GtkCss ## TYPE ## Values *)gtk_css_values_new (GTK_CSS_ ## ENUM ## _VALUES); \
+\
+  for (i = 0; i < G_N_ELEMENTS (NAME ## _props); i++) \
+    { \
+      guint id = NAME ## _props[i]; \
+      gtk_css_static_style_compute_value (sstyle, \
+                                          lazy->provider, \
+                                          lazy->parent_style, \
+                                          id, \
+                                          lazy->NAME[i].value, \
+                                          lazy->NAME[i].section); \
+    } \
+\
+  gtk_css_lazy_values_clear (lazy->NAME, G_N_ELEMENTS (lazy->NAME)); \
+} \
+\
+static gboolean \
+gtk_css_ ## NAME ## _lazy_values_equal (GtkCssStaticStyle *sstyle1, \
+                                        GtkCssStaticStyle *sstyle2) \
+{ \
+  GtkCssLazyValues *lazy1 = sstyle1->lazy; \
+  GtkCssLazyValues *lazy2 = sstyle2->lazy; \
+  int i; \
+\
+  if (lazy1->provider != lazy2->provider) \
+    return FALSE; \
+\
+  for (i = 0; i < G_N_ELEMENTS (NAME ## _props); i++) \
+    { \
+      if (lazy1->NAME[i].value != lazy2->NAME[i].value) \
+        return FALSE; \
+    } \
+\
+  return TRUE; \
+}
+
+DEFINE_LAZY_VALUES (OUTLINE, Outline, outline)
+DEFINE_LAZY_VALUES (FONT_VARIANT, FontVariant, font_variant)
+
 #define VERIFY_MASK(NAME) \
   { \
     GtkBitmask *copy; \
@@ -301,6 +412,21 @@ gtk_css_static_style_get_section (GtkCssStyle *style,
                                     guint        id)
 {
   GtkCssStaticStyle *sstyle = GTK_CSS_STATIC_STYLE (style);
+  int i;
+
+  if (style->outline == NULL)
+    {
+      for (i = 0; i < G_N_ELEMENTS (outline_props); i++)
+        if (outline_props[i] == id)
+          return sstyle->lazy->outline[i].section;
+    }
+
+  if (style->font_variant == NULL)
+    {
+      for (i = 0; i < G_N_ELEMENTS (font_variant_props); i++)
+        if (font_variant_props[i] == id)
+          return sstyle->lazy->font_variant[i].section;
+    }
 
   if (sstyle->sections == NULL ||
       id >= sstyle->sections->len)
@@ -320,6 +446,8 @@ gtk_css_static_style_dispose (GObject *object)
       style->sections = NULL;
     }
 
+  g_clear_pointer (&style->lazy, gtk_css_lazy_values_free);
+
   G_OBJECT_CLASS (gtk_css_static_style_parent_class)->dispose (object);
 }
 
@@ -949,7 +1077,7 @@ gtk_css_lookup_resolve (GtkCssLookup      *lookup,
   if (gtk_css_outline_values_unset (lookup))
     style->outline = (GtkCssOutlineValues *)gtk_css_values_ref (gtk_css_outline_initial_values);
   else
-    gtk_css_outline_values_new_compute (sstyle, provider, parent_style, lookup);
+    gtk_css_outline_values_defer_compute (sstyle, provider, parent_style, lookup);
 
   if (parent_style && gtk_css_font_values_unset (lookup))
     style->font = (GtkCssFontValues *)gtk_css_values_ref ((GtkCssValues *)parent_style->font);
@@ -959,7 +1087,7 @@ gtk_css_lookup_resolve (GtkCssLookup      *lookup,
   if (gtk_css_font_variant_values_unset (lookup))
     style->font_variant = (GtkCssFontVariantValues *)gtk_css_values_ref (gtk_css_font_variant_initial_values);
   else
-    gtk_css_font_variant_values_new_compute (sstyle, provider, parent_style, lookup);
+    gtk_css_font_variant_values_defer_compute (sstyle, provider, parent_style, lookup);
 
   if (gtk_css_animation_values_unset (lookup))
     style->animation = (GtkCssAnimationValues *)gtk_css_values_ref (gtk_css_animation_initial_values);
@@ -982,6 +1110,8 @@ gtk_css_lookup_resolve (GtkCssLookup      *lookup,
     gtk_css_other_values_new_compute (sstyle, provider, parent_style, lookup);
 }
 
+static guint n_styles_computed;
+
 GtkCssStyle *
 gtk_css_static_style_new_compute (GtkStyleProvider             *provider,
                                   const GtkCountingBloomFilter *filter,
@@ -1002,6 +1132,7 @@ gtk_css_static_style_new_compute (GtkStyleProvider             *provider,
                                change == 0 ? &change : NULL);
 
   result = g_object_new (GTK_TYPE_CSS_STATIC_STYLE, NULL);
+  n_styles_computed++;
 
   result->change = change;
 
@@ -1020,6 +1151,15 @@ gtk_css_static_style_new_compute (GtkStyleProvider             *provider,
   return GTK_CSS_STYLE (result);
 }
 
+/* The number of styles computed so far, see
+ * gsk_render_node_get_n_allocated()
+ */
+guint
+gtk_css_static_style_get_n_computed (void)
+{
+  return n_styles_computed;
+}
+
 G_STATIC_ASSERT (GTK_CSS_PROPERTY_BORDER_TOP_STYLE == GTK_CSS_PROPERTY_BORDER_TOP_WIDTH - 1);
 G_STATIC_ASSERT (GTK_CSS_PROPERTY_BORDER_RIGHT_STYLE == GTK_CSS_PROPERTY_BORDER_RIGHT_WIDTH - 1);
 G_STATIC_ASSERT (GTK_CSS_PROPERTY_BORDER_BOTTOM_STYLE == GTK_CSS_PROPERTY_BORDER_BOTTOM_WIDTH - 1);
@@ -1094,3 +1234,103 @@ gtk_css_static_style_get_change (GtkCssStaticStyle *style)
 
   return style->change;
 }
+
+void
+gtk_css_static_style_resolve_lazy_values (GtkCssStaticStyle *style,
+                                          GtkCssValuesType   type)
+{
+  GtkCssStyle *css_style = (GtkCssStyle *)style;
+
+  gtk_internal_return_if_fail (style->lazy != NULL);
+
+  switch (type)
+    {
+    case GTK_CSS_OUTLINE_VALUES:
+      if (css_style->outline == NULL)
+        gtk_css_outline_values_lazy_compute (style);
+      break;
+
+    case GTK_CSS_FONT_VARIANT_VALUES:
+      if (css_style->font_variant == NULL)
+        gtk_css_font_variant_values_lazy_compute (style);
+      break;
+
+    default:
+      g_assert_not_reached ();
+    }
+
+  if (css_style->outline && css_style->font_variant)
+    g_clear_pointer (&style->lazy, gtk_css_lazy_values_free);
+}
+
+static gboolean
+gtk_css_style_values_equal (GtkCssStyle      *style1,
+                            GtkCssStyle      *style2,
+                            GtkCssValuesType  type)
+{
+  GtkCssValues *values1, *values2;
+
+  if (style1 == style2)
+    return TRUE;
+
+  if (style1 == NULL || style2 == NULL)
+    return FALSE;
+
+  if (type == GTK_CSS_OUTLINE_VALUES)
+    {
+      values1 = (GtkCssValues *)style1->outline;
+      values2 = (GtkCssValues *)style2->outline;
+    }
+  else
+    {
+      values1 = (GtkCssValues *)style1->font_variant;
+      values2 = (GtkCssValues *)style2->font_variant;
+    }
+
+  if (values1 != NULL || values2 != NULL)
+    return values1 == values2;
+
+  return gtk_css_static_style_lazy_values_equal (GTK_CSS_STATIC_STYLE (style1),
+                                                 GTK_CSS_STATIC_STYLE (style2),
+                                                 type);
+}
+
+/*
+ * gtk_css_static_style_lazy_values_equal:
+ *
+ * Checks if the group @type of @style1 and @style2, which both must
+ * not have been computed yet, will compute to the same values, without
+ * computing them. Returns %FALSE if that can't be determined cheaply.
+ *
+ * Computing a group only depends on the values found by the lookup,
+ * the core values of the style and the same group of the parent style.
+ */
+gboolean
+gtk_css_static_style_lazy_values_equal (GtkCssStaticStyle *style1,
+                                        GtkCssStaticStyle *style2,
+                                        GtkCssValuesType   type)
+{
+  GtkCssStyle *css_style1 = (GtkCssStyle *)style1;
+  GtkCssStyle *css_style2 = (GtkCssStyle *)style2;
+  gboolean equal;
+
+  gtk_internal_return_val_if_fail (style1->lazy != NULL && style2->lazy != NULL, FALSE);
+
+  if (type == GTK_CSS_OUTLINE_VALUES)
+    equal = gtk_css_outline_lazy_values_equal (style1, style2);
+  else
+    equal = gtk_css_font_variant_lazy_values_equal (style1, style2);
+
+  if (!equal)
+    return FALSE;
+
+  if (css_style1->core != css_style2->core &&
+      (!_gtk_css_value_equal (css_style1->core->color, css_style2->core->color) ||
+       !_gtk_css_value_equal (css_style1->core->dpi, css_style2->core->dpi) ||
+       !_gtk_css_value_equal (css_style1->core->font_size, css_style2->core->font_size)))
+    return FALSE;
+
+  return gtk_css_style_values_equal (style1->lazy->parent_style,
+                                     style2->lazy->parent_style,
+                                     type);
+}
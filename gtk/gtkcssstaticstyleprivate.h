@@ -34,6 +34,7 @@ G_BEGIN_DECLS
 #define GTK_CSS_STATIC_STYLE_GET_CLASS(obj) (G_TYPE_INSTANCE_GET_CLASS ((obj), GTK_TYPE_CSS_STATIC_STYLE, GtkCssStaticStyleClass))
 
 typedef struct _GtkCssStaticStyleClass      GtkCssStaticStyleClass;
+typedef struct _GtkCssLazyValues            GtkCssLazyValues;
 
 
 struct _GtkCssStaticStyle
@@ -43,6 +44,8 @@ struct _GtkCssStaticStyle
   GPtrArray             *sections;             /* sections the values are defined in */
 
   GtkCssChange           change;               /* change as returned by value lookup */
+
+  GtkCssLazyValues      *lazy;                 /* inputs for the groups that aren't computed yet */
 };
 
 struct _GtkCssStaticStyleClass
@@ -58,6 +61,13 @@ GtkCssStyle *           gtk_css_static_style_new_compute        (GtkStyleProvide
                                                                  GtkCssNode                     *node,
                                                                  GtkCssChange                    change);
 GtkCssChange            gtk_css_static_style_get_change         (GtkCssStaticStyle              *style);
+guint                   gtk_css_static_style_get_n_computed     (void);
+
+void                    gtk_css_static_style_resolve_lazy_values (GtkCssStaticStyle             *style,
+                                                                 GtkCssValuesType                type);
+gboolean                gtk_css_static_style_lazy_values_equal  (GtkCssStaticStyle              *style1,
+                                                                 GtkCssStaticStyle              *style2,
+                                                                 GtkCssValuesType                type);
 
 G_END_DECLS
 
@@ -30,6 +30,7 @@
 #include "gtkcssnumbervalueprivate.h"
 #include "gtkcsscolorvalueprivate.h"
 #include "gtkcssshorthandpropertyprivate.h"
+#include "gtkcssstaticstyleprivate.h"
 #include "gtkcssstringvalueprivate.h"
 #include "gtkcssfontvariationsvalueprivate.h"
 #include "gtkcssfontfeaturesvalueprivate.h"
@@ -55,6 +56,36 @@ gtk_css_style_real_is_static (GtkCssStyle *style)
 }
 
 
+/* Styles are shared by lots of widgets, often with a few different
+ * sizes, so keep a couple of nodes per type around. */
+#define N_CACHED_RENDER_NODES 4
+
+typedef struct {
+  graphene_rect_t border_rect;
+  GskRenderNode *node;
+} GtkCssCachedRenderNode;
+
+struct _GtkCssRenderCache
+{
+  GtkCssCachedRenderNode nodes[GTK_CSS_N_RENDER_NODES][N_CACHED_RENDER_NODES];
+  guint next[GTK_CSS_N_RENDER_NODES];
+};
+
+static void
+gtk_css_render_cache_free (GtkCssRenderCache *cache)
+{
+  guint i, j;
+
+  if (cache == NULL)
+    return;
+
+  for (i = 0; i < GTK_CSS_N_RENDER_NODES; i++)
+    for (j = 0; j < N_CACHED_RENDER_NODES; j++)
+      g_clear_pointer (&cache->nodes[i][j].node, gsk_render_node_unref);
+
+  g_free (cache);
+}
+
 static void
 gtk_css_style_finalize (GObject *object)
 {
@@ -72,6 +103,8 @@ gtk_css_style_finalize (GObject *object)
   gtk_css_values_unref ((GtkCssValues *)style->size);
   gtk_css_values_unref ((GtkCssValues *)style->other);
 
+  gtk_css_render_cache_free (style->render_cache);
+
   G_OBJECT_CLASS (gtk_css_style_parent_class)->finalize (object);
 }
 
@@ -118,25 +151,28 @@ gtk_css_style_get_value (GtkCssStyle *style,
     case GTK_CSS_PROPERTY_LETTER_SPACING:
       return style->font->letter_spacing;
     case GTK_CSS_PROPERTY_TEXT_DECORATION_LINE:
-      return style->font_variant->text_decoration_line;
+      return gtk_css_style_get_font_variant_values (style)->text_decoration_line;
     case GTK_CSS_PROPERTY_TEXT_DECORATION_COLOR:
-      return style->font_variant->text_decoration_color ? style->font_variant->text_decoration_color : style->core->color;
+      {
+        GtkCssFontVariantValues *font_variant = gtk_css_style_get_font_variant_values (style);
+        return font_variant->text_decoration_color ? font_variant->text_decoration_color : style->core->color;
+      }
     case GTK_CSS_PROPERTY_TEXT_DECORATION_STYLE:
-      return style->font_variant->text_decoration_style;
+      return gtk_css_style_get_font_variant_values (style)->text_decoration_style;
     case GTK_CSS_PROPERTY_FONT_KERNING:
-      return style->font_variant->font_kerning;
+      return gtk_css_style_get_font_variant_values (style)->font_kerning;
     case GTK_CSS_PROPERTY_FONT_VARIANT_LIGATURES:
-      return style->font_variant->font_variant_ligatures;
+      return gtk_css_style_get_font_variant_values (style)->font_variant_ligatures;
     case GTK_CSS_PROPERTY_FONT_VARIANT_POSITION:
-      return style->font_variant->font_variant_position;
+      return gtk_css_style_get_font_variant_values (style)->font_variant_position;
     case GTK_CSS_PROPERTY_FONT_VARIANT_CAPS:
-      return style->font_variant->font_variant_caps;
+      return gtk_css_style_get_font_variant_values (style)->font_variant_caps;
     case GTK_CSS_PROPERTY_FONT_VARIANT_NUMERIC:
-      return style->font_variant->font_variant_numeric;
+      return gtk_css_style_get_font_variant_values (style)->font_variant_numeric;
     case GTK_CSS_PROPERTY_FONT_VARIANT_ALTERNATES:
-      return style->font_variant->font_variant_alternates;
+      return gtk_css_style_get_font_variant_values (style)->font_variant_alternates;
     case GTK_CSS_PROPERTY_FONT_VARIANT_EAST_ASIAN:
-      return style->font_variant->font_variant_east_asian;
+      return gtk_css_style_get_font_variant_values (style)->font_variant_east_asian;
     case GTK_CSS_PROPERTY_TEXT_SHADOW:
       return style->font->text_shadow;
     case GTK_CSS_PROPERTY_BOX_SHADOW:
@@ -182,11 +218,11 @@ gtk_css_style_get_value (GtkCssStyle *style,
     case GTK_CSS_PROPERTY_BORDER_BOTTOM_LEFT_RADIUS:
       return style->border->border_bottom_left_radius;
     case GTK_CSS_PROPERTY_OUTLINE_STYLE:
-      return style->outline->outline_style;
+      return gtk_css_style_get_outline_values (style)->outline_style;
     case GTK_CSS_PROPERTY_OUTLINE_WIDTH:
-      return style->outline->outline_width;
+      return gtk_css_style_get_outline_values (style)->outline_width;
     case GTK_CSS_PROPERTY_OUTLINE_OFFSET:
-      return style->outline->outline_offset;
+      return gtk_css_style_get_outline_values (style)->outline_offset;
     case GTK_CSS_PROPERTY_BACKGROUND_CLIP:
       return style->background->background_clip;
     case GTK_CSS_PROPERTY_BACKGROUND_ORIGIN:
@@ -204,7 +240,10 @@ gtk_css_style_get_value (GtkCssStyle *style,
     case GTK_CSS_PROPERTY_BORDER_LEFT_COLOR:
       return style->border->border_left_color ? style->border->border_left_color: style->core->color;
     case GTK_CSS_PROPERTY_OUTLINE_COLOR:
-      return style->outline->outline_color ? style->outline->outline_color : style->core->color;
+      {
+        GtkCssOutlineValues *outline = gtk_css_style_get_outline_values (style);
+        return outline->outline_color ? outline->outline_color : style->core->color;
+      }
     case GTK_CSS_PROPERTY_BACKGROUND_REPEAT:
       return style->background->background_repeat;
     case GTK_CSS_PROPERTY_BACKGROUND_IMAGE:
@@ -423,6 +462,7 @@ append_separated (GString    **s,
 PangoAttrList *
 gtk_css_style_get_pango_attributes (GtkCssStyle *style)
 {
+  GtkCssFontVariantValues *font_variant = gtk_css_style_get_font_variant_values (style);
   PangoAttrList *attrs = NULL;
   GtkTextDecorationLine decoration_line;
   GtkTextDecorationStyle decoration_style;
@@ -436,11 +476,11 @@ gtk_css_style_get_pango_attributes (GtkCssStyle *style)
   char *settings;
 
   /* text-decoration */
-  decoration_line = _gtk_css_text_decoration_line_value_get (style->font_variant->text_decoration_line);
-  decoration_style = _gtk_css_text_decoration_style_value_get (style->font_variant->text_decoration_style);
+  decoration_line = _gtk_css_text_decoration_line_value_get (font_variant->text_decoration_line);
+  decoration_style = _gtk_css_text_decoration_style_value_get (font_variant->text_decoration_style);
   color = gtk_css_color_value_get_rgba (style->core->color);
-  decoration_color = gtk_css_color_value_get_rgba (style->font_variant->text_decoration_color
-                                                   ? style->font_variant->text_decoration_color
+  decoration_color = gtk_css_color_value_get_rgba (font_variant->text_decoration_color
+                                                   ? font_variant->text_decoration_color
                                                    : style->core->color);
 
   switch (decoration_line)
@@ -475,7 +515,7 @@ gtk_css_style_get_pango_attributes (GtkCssStyle *style)
 
   s = NULL;
 
-  switch (_gtk_css_font_kerning_value_get (style->font_variant->font_kerning))
+  switch (_gtk_css_font_kerning_value_get (font_variant->font_kerning))
     {
     case GTK_CSS_FONT_KERNING_NORMAL:
       append_separated (&s, "kern 1");
@@ -488,7 +528,7 @@ gtk_css_style_get_pango_attributes (GtkCssStyle *style)
       break;
     }
 
-  ligatures = _gtk_css_font_variant_ligature_value_get (style->font_variant->font_variant_ligatures);
+  ligatures = _gtk_css_font_variant_ligature_value_get (font_variant->font_variant_ligatures);
   if (ligatures == GTK_CSS_FONT_VARIANT_LIGATURE_NORMAL)
     {
       /* all defaults */
@@ -515,7 +555,7 @@ gtk_css_style_get_pango_attributes (GtkCssStyle *style)
         append_separated (&s, "calt 0");
     }
 
-  switch (_gtk_css_font_variant_position_value_get (style->font_variant->font_variant_position))
+  switch (_gtk_css_font_variant_position_value_get (font_variant->font_variant_position))
     {
     case GTK_CSS_FONT_VARIANT_POSITION_SUB:
       append_separated (&s, "subs 1");
@@ -528,7 +568,7 @@ gtk_css_style_get_pango_attributes (GtkCssStyle *style)
       break;
     }
 
-  switch (_gtk_css_font_variant_caps_value_get (style->font_variant->font_variant_caps))
+  switch (_gtk_css_font_variant_caps_value_get (font_variant->font_variant_caps))
     {
     case GTK_CSS_FONT_VARIANT_CAPS_SMALL_CAPS:
       append_separated (&s, "smcp 1");
@@ -553,7 +593,7 @@ gtk_css_style_get_pango_attributes (GtkCssStyle *style)
       break;
     }
 
-  numeric = _gtk_css_font_variant_numeric_value_get (style->font_variant->font_variant_numeric);
+  numeric = _gtk_css_font_variant_numeric_value_get (font_variant->font_variant_numeric);
   if (numeric == GTK_CSS_FONT_VARIANT_NUMERIC_NORMAL)
     {
       /* all defaults */
@@ -578,7 +618,7 @@ gtk_css_style_get_pango_attributes (GtkCssStyle *style)
         append_separated (&s, "zero 1");
     }
 
-  switch (_gtk_css_font_variant_alternate_value_get (style->font_variant->font_variant_alternates))
+  switch (_gtk_css_font_variant_alternate_value_get (font_variant->font_variant_alternates))
     {
     case GTK_CSS_FONT_VARIANT_ALTERNATE_HISTORICAL_FORMS:
       append_separated (&s, "hist 1");
@@ -588,7 +628,7 @@ gtk_css_style_get_pango_attributes (GtkCssStyle *style)
       break;
     }
 
-  east_asian = _gtk_css_font_variant_east_asian_value_get (style->font_variant->font_variant_east_asian);
+  east_asian = _gtk_css_font_variant_east_asian_value_get (font_variant->font_variant_east_asian);
   if (east_asian == GTK_CSS_FONT_VARIANT_EAST_ASIAN_NORMAL)
     {
       /* all defaults */
@@ -770,3 +810,56 @@ gtk_css_values_new (GtkCssValuesType type)
 
   return values;
 }
+
+void
+gtk_css_style_resolve_lazy_values (GtkCssStyle      *style,
+                                   GtkCssValuesType  type)
+{
+  /* Animated styles always have all their groups */
+  gtk_css_static_style_resolve_lazy_values (GTK_CSS_STATIC_STYLE (style), type);
+}
+
+/* Returns the node that was cached for rendering @type of @style
+ * into @border_rect, or %NULL */
+GskRenderNode *
+gtk_css_style_get_render_node (GtkCssStyle           *style,
+                               GtkCssRenderNodeType   type,
+                               const graphene_rect_t *border_rect)
+{
+  GtkCssRenderCache *cache = style->render_cache;
+  guint i;
+
+  if (cache == NULL)
+    return NULL;
+
+  for (i = 0; i < N_CACHED_RENDER_NODES; i++)
+    {
+      GtkCssCachedRenderNode *cached = &cache->nodes[type][i];
+
+      if (cached->node && graphene_rect_equal (&cached->border_rect, border_rect))
+        return cached->node;
+    }
+
+  return NULL;
+}
+
+void
+gtk_css_style_set_render_node (GtkCssStyle           *style,
+                               GtkCssRenderNodeType   type,
+                               const graphene_rect_t *border_rect,
+                               GskRenderNode         *node)
+{
+  GtkCssRenderCache *cache;
+  GtkCssCachedRenderNode *cached;
+
+  if (style->render_cache == NULL)
+    style->render_cache = g_new0 (GtkCssRenderCache, 1);
+
+  cache = style->render_cache;
+  cached = &cache->nodes[type][cache->next[type]];
+  cache->next[type] = (cache->next[type] + 1) % N_CACHED_RENDER_NODES;
+
+  g_clear_pointer (&cached->node, gsk_render_node_unref);
+  cached->border_rect = *border_rect;
+  cached->node = gsk_render_node_ref (node);
+}
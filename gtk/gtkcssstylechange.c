@@ -19,8 +19,36 @@
 
 #include "gtkcssstylechangeprivate.h"
 
+#include "gtkcssstaticstyleprivate.h"
 #include "gtkcssstylepropertyprivate.h"
 
+/* Avoids computing lazy groups of both styles if they are going to be
+ * the same anyway */
+static gboolean
+lazy_values_changed (GtkCssStyleChange *change,
+                     GtkCssValuesType   type)
+{
+  GtkCssValues *old_values, *new_values;
+
+  if (type == GTK_CSS_OUTLINE_VALUES)
+    {
+      old_values = (GtkCssValues *)change->old_style->outline;
+      new_values = (GtkCssValues *)change->new_style->outline;
+    }
+  else
+    {
+      old_values = (GtkCssValues *)change->old_style->font_variant;
+      new_values = (GtkCssValues *)change->new_style->font_variant;
+    }
+
+  if (old_values != NULL || new_values != NULL)
+    return TRUE;
+
+  return !gtk_css_static_style_lazy_values_equal (GTK_CSS_STATIC_STYLE (change->old_style),
+                                                  GTK_CSS_STATIC_STYLE (change->new_style),
+                                                  type);
+}
+
 static void
 compute_change (GtkCssStyleChange *change)
 {
@@ -57,8 +85,9 @@ compute_change (GtkCssStyleChange *change)
                                                      &change->changes,
                                                      &change->affects);
 
-  if (change->old_style->outline != change->new_style->outline ||
-      (color_changed && change->old_style->outline->outline_color == NULL))
+  if (lazy_values_changed (change, GTK_CSS_OUTLINE_VALUES) &&
+      (gtk_css_style_get_outline_values (change->old_style) != gtk_css_style_get_outline_values (change->new_style) ||
+       (color_changed && change->old_style->outline->outline_color == NULL)))
     gtk_css_outline_values_compute_changes_and_affects (change->old_style,
                                                         change->new_style,
                                                         &change->changes,
@@ -72,8 +101,9 @@ compute_change (GtkCssStyleChange *change)
                                                      &change->changes,
                                                      &change->affects);
 
-  if (change->old_style->font_variant != change->new_style->font_variant ||
-      (color_changed && change->old_style->font_variant->text_decoration_color == NULL))
+  if (lazy_values_changed (change, GTK_CSS_FONT_VARIANT_VALUES) &&
+      (gtk_css_style_get_font_variant_values (change->old_style) != gtk_css_style_get_font_variant_values (change->new_style) ||
+       (color_changed && change->old_style->font_variant->text_decoration_color == NULL)))
     gtk_css_font_variant_values_compute_changes_and_affects (change->old_style,
                                                              change->new_style,
                                                              &change->changes,
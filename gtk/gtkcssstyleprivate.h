@@ -21,6 +21,7 @@
 #define __GTK_CSS_STYLE_PRIVATE_H__
 
 #include <glib-object.h>
+#include <gsk/gsk.h>
 #include <gtk/css/gtkcss.h>
 
 #include "gtk/gtkbitmaskprivate.h"
@@ -214,6 +215,13 @@ struct _GtkCssOtherValues {
 
 /* typedef struct _GtkCssStyle           GtkCssStyle; */
 typedef struct _GtkCssStyleClass      GtkCssStyleClass;
+typedef struct _GtkCssRenderCache     GtkCssRenderCache;
+
+typedef enum {
+  GTK_CSS_RENDER_NODE_BACKGROUND,
+  GTK_CSS_RENDER_NODE_BORDER,
+  GTK_CSS_N_RENDER_NODES
+} GtkCssRenderNodeType;
 
 struct _GtkCssStyle
 {
@@ -230,6 +238,8 @@ struct _GtkCssStyle
   GtkCssTransitionValues  *transition;
   GtkCssSizeValues        *size;
   GtkCssOtherValues       *other;
+
+  GtkCssRenderCache       *render_cache;
 };
 
 struct _GtkCssStyleClass
@@ -265,6 +275,38 @@ PangoFontDescription *  gtk_css_style_get_pango_font            (GtkCssStyle
 GtkCssStaticStyle *     gtk_css_style_get_static_style          (GtkCssStyle            *style);
 
 
+void                    gtk_css_style_resolve_lazy_values       (GtkCssStyle            *style,
+                                                                 GtkCssValuesType        type);
+
+GskRenderNode *         gtk_css_style_get_render_node           (GtkCssStyle            *style,
+                                                                 GtkCssRenderNodeType    type,
+                                                                 const graphene_rect_t  *border_rect);
+void                    gtk_css_style_set_render_node           (GtkCssStyle            *style,
+                                                                 GtkCssRenderNodeType    type,
+                                                                 const graphene_rect_t  *border_rect,
+                                                                 GskRenderNode          *node);
+
+/* The outline and font-variant groups of static styles are only
+ * computed when they are first used, so they must be accessed via
+ * these functions. */
+static inline GtkCssOutlineValues *
+gtk_css_style_get_outline_values (GtkCssStyle *style)
+{
+  if (G_UNLIKELY (style->outline == NULL))
+    gtk_css_style_resolve_lazy_values (style, GTK_CSS_OUTLINE_VALUES);
+
+  return style->outline;
+}
+
+static inline GtkCssFontVariantValues *
+gtk_css_style_get_font_variant_values (GtkCssStyle *style)
+{
+  if (G_UNLIKELY (style->font_variant == NULL))
+    gtk_css_style_resolve_lazy_values (style, GTK_CSS_FONT_VARIANT_VALUES);
+
+  return style->font_variant;
+}
+
 GtkCssValues *gtk_css_values_new   (GtkCssValuesType  type);
 GtkCssValues *gtk_css_values_ref   (GtkCssValues     *values);
 void          gtk_css_values_unref (GtkCssValues     *values);
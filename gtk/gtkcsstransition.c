@@ -38,6 +38,8 @@ struct _GtkCssTransition
 
 static GtkStyleAnimation *   gtk_css_transition_advance  (GtkStyleAnimation    *style_animation,
                                                           gint64                timestamp);
+static void                  gtk_css_transition_advance_in_place (GtkStyleAnimation *style_animation,
+                                                                  gint64             timestamp);
 
 
 
@@ -111,6 +113,7 @@ static const GtkStyleAnimationClass GTK_CSS_TRANSITION_CLASS = {
   gtk_css_transition_is_static,
   gtk_css_transition_apply_values,
   gtk_css_transition_advance,
+  gtk_css_transition_advance_in_place,
 };
 
 static GtkStyleAnimation *
@@ -134,6 +137,16 @@ gtk_css_transition_advance (GtkStyleAnimation    *style_animation,
 
   return (GtkStyleAnimation *)transition;
 }
+
+static void
+gtk_css_transition_advance_in_place (GtkStyleAnimation *style_animation,
+                                     gint64             timestamp)
+{
+  GtkCssTransition *transition = (GtkCssTransition *)style_animation;
+
+  gtk_progress_tracker_advance_frame (&transition->tracker, timestamp);
+  transition->finished = gtk_progress_tracker_get_state (&transition->tracker) == GTK_PROGRESS_STATE_AFTER;
+}
 GtkStyleAnimation *
 _gtk_css_transition_new (guint        property,
                          GtkCssValue *start,
@@ -136,6 +136,8 @@ get_accounting_data (const char *class)
 }
 #endif
 
+static guint n_css_values_allocated;
+
 GtkCssValue *
 _gtk_css_value_alloc (const GtkCssValueClass *klass,
                       gsize                   size)
@@ -143,6 +145,7 @@ _gtk_css_value_alloc (const GtkCssValueClass *klass,
   GtkCssValue *value;
 
   value = g_slice_alloc0 (size);
+  n_css_values_allocated++;
 
   value->class = klass;
   value->ref_count = 1;
@@ -160,6 +163,15 @@ _gtk_css_value_alloc (const GtkCssValueClass *klass,
   return value;
 }
 
+/* The number of values allocated so far, see
+ * gsk_render_node_get_n_allocated()
+ */
+guint
+gtk_css_value_get_n_allocated (void)
+{
+  return n_css_values_allocated;
+}
+
 GtkCssValue *
 gtk_css_value_ref (GtkCssValue *value)
 {
@@ -67,6 +67,7 @@ GType        _gtk_css_value_get_type                  (void) G_GNUC_CONST;
 GtkCssValue *_gtk_css_value_alloc                     (const GtkCssValueClass     *klass,
                                                        gsize                       size);
 #define _gtk_css_value_new(_name, _klass) ((_name *) _gtk_css_value_alloc ((_klass), sizeof (_name)))
+guint        gtk_css_value_get_n_allocated            (void);
 
 #define _gtk_css_value_ref gtk_css_value_ref
 GtkCssValue *   gtk_css_value_ref                     (GtkCssValue                *value);
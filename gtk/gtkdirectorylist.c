@@ -54,6 +54,13 @@
 
 /* random number that everyone else seems to use, too */
 #define FILES_PER_QUERY 100
+/* Batches start small so the first files show up quickly, and grow
+ * while the enumerator keeps up */
+#define MAX_FILES_PER_QUERY(native) ((native) ? 50 * FILES_PER_QUERY : 10 * FILES_PER_QUERY)
+#define BATCH_TIME_US (20 * 1000)
+/* Changes that arrive in quick succession are announced together,
+ * about once per frame */
+#define ANNOUNCE_INTERVAL_MS 16
 
 enum {
   PROP_0,
@@ -76,9 +83,20 @@ struct _GtkDirectoryList
   gboolean monitored;
   int io_priority;
 
+  /* Thumbnails and previews are only queried for the files that get
+   * requested, which usually means the ones a view shows */
+  char *eager_attributes; /* NULL if all attributes are eager */
+  char *lazy_attributes;
+  GCancellable *lazy_cancellable;
+  GHashTable *lazy_infos; /* old info => info with lazy attributes */
+
   GCancellable *cancellable;
   GError *error; /* Error while loading */
   GSequence *items; /* Use GPtrArray or GListStore here? */
+  guint n_pending; /* items at the end of items that weren't announced yet */
+  guint announce_cb;
+  guint batch_size;
+  gint64 batch_start;
 };
 
 struct _GtkDirectoryListClass
@@ -87,6 +105,7 @@ struct _GtkDirectoryListClass
 };
 
 static GParamSpec *properties[NUM_PROPERTIES] = { NULL, };
+static GQuark lazy_quark;
 
 static GType
 gtk_directory_list_get_item_type (GListModel *list)
@@ -99,22 +118,26 @@ gtk_directory_list_get_n_items (GListModel *list)
 {
   GtkDirectoryList *self = GTK_DIRECTORY_LIST (list);
 
-  return g_sequence_get_length (self->items);
+  return g_sequence_get_length (self->items) - self->n_pending;
 }
 
+static void gtk_directory_list_query_lazy_attributes (GtkDirectoryList *self,
+                                                      GFileInfo        *info);
+
 static gpointer
 gtk_directory_list_get_item (GListModel *list,
                              guint       position)
 {
   GtkDirectoryList *self = GTK_DIRECTORY_LIST (list);
-  GSequenceIter *iter;
-
-  iter = g_sequence_get_iter_at_pos (self->items, position);
+  GFileInfo *info;
 
-  if (g_sequence_iter_is_end (iter))
+  if (position >= gtk_directory_list_get_n_items (list))
     return NULL;
-  else
-    return g_object_ref (g_sequence_get (iter));
+
+  info = g_sequence_get (g_sequence_get_iter_at_pos (self->items, position));
+  gtk_directory_list_query_lazy_attributes (self, info);
+
+  return g_object_ref (info);
 }
 
 static void
@@ -233,8 +256,15 @@ gtk_directory_list_dispose (GObject *object)
   gtk_directory_list_stop_loading (self);
   gtk_directory_list_stop_monitoring (self);
 
+  g_cancellable_cancel (self->lazy_cancellable);
+  g_clear_object (&self->lazy_cancellable);
+  g_clear_pointer (&self->lazy_infos, g_hash_table_unref);
+  g_clear_handle_id (&self->announce_cb, g_source_remove);
+
   g_clear_object (&self->file);
   g_clear_pointer (&self->attributes, g_free);
+  g_clear_pointer (&self->eager_attributes, g_free);
+  g_clear_pointer (&self->lazy_attributes, g_free);
 
   g_clear_error (&self->error);
   g_clear_pointer (&self->items, g_sequence_free);
@@ -247,6 +277,8 @@ gtk_directory_list_class_init (GtkDirectoryListClass *class)
 {
   GObjectClass *gobject_class = G_OBJECT_CLASS (class);
 
+  lazy_quark = g_quark_from_static_string ("gtk-directory-list-lazy-queried");
+
   gobject_class->set_property = gtk_directory_list_set_property;
   gobject_class->get_property = gtk_directory_list_get_property;
   gobject_class->dispose = gtk_directory_list_dispose;
@@ -330,6 +362,8 @@ static void
 gtk_directory_list_init (GtkDirectoryList *self)
 {
   self->items = g_sequence_new (g_object_unref);
+  self->lazy_cancellable = g_cancellable_new ();
+  self->lazy_infos = g_hash_table_new_full (NULL, NULL, g_object_unref, g_object_unref);
   self->io_priority = G_PRIORITY_DEFAULT;
   self->monitored = TRUE;
 }
@@ -356,18 +390,219 @@ gtk_directory_list_new (const char *attributes,
                        NULL);
 }
 
+static gboolean
+is_lazy_attribute (const char *attribute)
+{
+  return g_str_has_prefix (attribute, "thumbnail::") ||
+         g_str_has_prefix (attribute, "preview::");
+}
+
+static void
+gtk_directory_list_split_attributes (GtkDirectoryList *self)
+{
+  GString *eager, *lazy;
+  char **split;
+  guint i;
+
+  g_clear_pointer (&self->eager_attributes, g_free);
+  g_clear_pointer (&self->lazy_attributes, g_free);
+
+  if (self->attributes == NULL)
+    return;
+
+  eager = g_string_new (NULL);
+  lazy = g_string_new (NULL);
+
+  split = g_strsplit (self->attributes, ",", -1);
+  for (i = 0; split[i]; i++)
+    {
+      GString *list = is_lazy_attribute (split[i]) ? lazy : eager;
+
+      if (list->len)
+        g_string_append_c (list, ',');
+      g_string_append (list, split[i]);
+    }
+  g_strfreev (split);
+
+  if (lazy->len == 0)
+    {
+      g_string_free (eager, TRUE);
+      g_string_free (lazy, TRUE);
+      return;
+    }
+
+  /* always query something, so enumerating still gives us infos */
+  if (eager->len == 0)
+    g_string_append (eager, G_FILE_ATTRIBUTE_STANDARD_NAME);
+
+  self->eager_attributes = g_string_free (eager, FALSE);
+  self->lazy_attributes = g_string_free (lazy, FALSE);
+}
+
+typedef struct
+{
+  GtkDirectoryList *self;
+  GFileInfo *info;
+  GCancellable *cancellable;
+} LazyQuery;
+
+static void
+got_lazy_file_info_cb (GObject      *source,
+                       GAsyncResult *res,
+                       gpointer      data)
+{
+  LazyQuery *query = data;
+  GtkDirectoryList *self = query->self; /* invalid if cancelled */
+  GFileInfo *lazy, *info;
+  char **attributes;
+  guint i;
+
+  lazy = g_file_query_info_finish (G_FILE (source), res, NULL);
+  if (lazy == NULL || g_cancellable_is_cancelled (query->cancellable))
+    goto out;
+
+  /* Views only rebind to a new object */
+  info = g_file_info_dup (query->info);
+  attributes = g_file_info_list_attributes (lazy, NULL);
+  for (i = 0; attributes[i]; i++)
+    {
+      GFileAttributeType type;
+      gpointer value;
+
+      if (g_file_info_get_attribute_data (lazy, attributes[i], &type, &value, NULL))
+        g_file_info_set_attribute (info, attributes[i], type, value);
+    }
+  g_strfreev (attributes);
+  g_object_set_qdata (G_OBJECT (info), lazy_quark, GINT_TO_POINTER (TRUE));
+
+  g_hash_table_insert (self->lazy_infos, g_object_ref (query->info), info);
+  gtk_directory_list_queue_announce (self);
+
+out:
+  g_clear_object (&lazy);
+  g_object_unref (query->info);
+  g_object_unref (query->cancellable);
+  g_slice_free (LazyQuery, query);
+}
+
+static void
+gtk_directory_list_query_lazy_attributes (GtkDirectoryList *self,
+                                          GFileInfo        *info)
+{
+  LazyQuery *query;
+
+  if (self->lazy_attributes == NULL ||
+      g_object_get_qdata (G_OBJECT (info), lazy_quark))
+    return;
+
+  g_object_set_qdata (G_OBJECT (info), lazy_quark, GINT_TO_POINTER (TRUE));
+
+  query = g_slice_new (LazyQuery);
+  query->self = self;
+  query->info = g_object_ref (info);
+  query->cancellable = g_object_ref (self->lazy_cancellable);
+
+  g_file_query_info_async (G_FILE (g_file_info_get_attribute_object (info, "standard::file")),
+                           self->lazy_attributes,
+                           G_FILE_QUERY_INFO_NONE,
+                           self->io_priority,
+                           self->lazy_cancellable,
+                           got_lazy_file_info_cb,
+                           query);
+}
+
+static void
+gtk_directory_list_flush_pending (GtkDirectoryList *self)
+{
+  guint n_pending = self->n_pending;
+
+  if (n_pending == 0)
+    return;
+
+  self->n_pending = 0;
+  g_list_model_items_changed (G_LIST_MODEL (self),
+                              g_sequence_get_length (self->items) - n_pending,
+                              0, n_pending);
+}
+
+/* Replaces the items that got their lazy attributes, in runs */
+static void
+gtk_directory_list_flush_lazy_infos (GtkDirectoryList *self)
+{
+  GSequenceIter *iter;
+  guint position, run_start, run_length;
+
+  if (g_hash_table_size (self->lazy_infos) == 0)
+    return;
+
+  run_start = run_length = 0;
+  for (iter = g_sequence_get_begin_iter (self->items), position = 0;
+       !g_sequence_iter_is_end (iter) && g_hash_table_size (self->lazy_infos) > 0;
+       iter = g_sequence_iter_next (iter), position++)
+    {
+      GFileInfo *info;
+
+      if (!g_hash_table_steal_extended (self->lazy_infos, g_sequence_get (iter), NULL, (gpointer *) &info))
+        {
+          if (run_length > 0)
+            g_list_model_items_changed (G_LIST_MODEL (self), run_start, run_length, run_length);
+          run_length = 0;
+          continue;
+        }
+
+      /* the old info is unreffed when it's replaced */
+      g_sequence_set (iter, info);
+
+      if (run_length == 0)
+        run_start = position;
+      run_length++;
+    }
+
+  if (run_length > 0)
+    g_list_model_items_changed (G_LIST_MODEL (self), run_start, run_length, run_length);
+
+  /* whatever is left was removed meanwhile */
+  g_hash_table_remove_all (self->lazy_infos);
+}
+
+static gboolean
+gtk_directory_list_announce_cb (gpointer data)
+{
+  GtkDirectoryList *self = data;
+
+  self->announce_cb = 0;
+
+  gtk_directory_list_flush_pending (self);
+  gtk_directory_list_flush_lazy_infos (self);
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+gtk_directory_list_queue_announce (GtkDirectoryList *self)
+{
+  if (self->announce_cb != 0)
+    return;
+
+  self->announce_cb = g_timeout_add (ANNOUNCE_INTERVAL_MS, gtk_directory_list_announce_cb, self);
+  g_source_set_name_by_id (self->announce_cb, "[gtk] gtk_directory_list_announce_cb");
+}
+
 static void
 gtk_directory_list_clear_items (GtkDirectoryList *self)
 {
   guint n_items;
 
-  n_items = g_sequence_get_length (self->items);
-  if (n_items > 0)
+  n_items = g_sequence_get_length (self->items) - self->n_pending;
+  self->n_pending = 0;
+  g_hash_table_remove_all (self->lazy_infos);
+  if (g_sequence_get_length (self->items) > 0)
     {
       g_sequence_remove_range (g_sequence_get_begin_iter (self->items),
                                g_sequence_get_end_iter (self->items));
 
-      g_list_model_items_changed (G_LIST_MODEL (self), 0, n_items, 0);
+      if (n_items > 0)
+        g_list_model_items_changed (G_LIST_MODEL (self), 0, n_items, 0);
     }
 
   if (self->error)
@@ -385,6 +620,26 @@ gtk_directory_list_enumerator_closed_cb (GObject      *source,
   g_file_enumerator_close_finish (G_FILE_ENUMERATOR (source), res, NULL);
 }
 
+static void
+gtk_directory_list_update_batch_size (GtkDirectoryList *self,
+                                      guint             n_files)
+{
+  gint64 now, elapsed;
+
+  now = g_get_monotonic_time ();
+  elapsed = now - self->batch_start;
+  self->batch_start = now;
+
+  /* short batches mean we're done, they say nothing about speed */
+  if (n_files < self->batch_size)
+    return;
+
+  if (elapsed < BATCH_TIME_US)
+    self->batch_size = MIN (2 * self->batch_size, MAX_FILES_PER_QUERY (g_file_is_native (self->file)));
+  else if (elapsed > 4 * BATCH_TIME_US)
+    self->batch_size = MAX (self->batch_size / 2, FILES_PER_QUERY);
+}
+
 static void
 gtk_directory_list_got_files_cb (GObject      *source,
                                  GAsyncResult *res,
@@ -412,6 +667,8 @@ gtk_directory_list_got_files_cb (GObject      *source,
                                      gtk_directory_list_enumerator_closed_cb,
                                      NULL);
 
+      gtk_directory_list_flush_pending (self);
+
       g_object_freeze_notify (G_OBJECT (self));
 
       g_clear_object (&self->cancellable);
@@ -442,15 +699,25 @@ gtk_directory_list_got_files_cb (GObject      *source,
     }
   g_list_free (files);
 
+  gtk_directory_list_update_batch_size (self, n);
   g_file_enumerator_next_files_async (enumerator,
-                                      g_file_is_native (self->file) ? 50 * FILES_PER_QUERY : FILES_PER_QUERY,
+                                      self->batch_size,
                                       self->io_priority,
                                       self->cancellable,
                                       gtk_directory_list_got_files_cb,
                                       self);
 
   if (n > 0)
-    g_list_model_items_changed (G_LIST_MODEL (self), g_sequence_get_length (self->items) - n, 0, n);
+    {
+      gboolean was_empty = g_sequence_get_length (self->items) == self->n_pending;
+
+      self->n_pending += n;
+      /* get the first files on screen right away */
+      if (was_empty)
+        gtk_directory_list_flush_pending (self);
+      else
+        gtk_directory_list_queue_announce (self);
+    }
 }
 
 static void
@@ -481,8 +748,10 @@ gtk_directory_list_got_enumerator_cb (GObject      *source,
       return;
     }
 
+  self->batch_size = FILES_PER_QUERY;
+  self->batch_start = g_get_monotonic_time ();
   g_file_enumerator_next_files_async (enumerator,
-                                      g_file_is_native (file) ? 50 * FILES_PER_QUERY : FILES_PER_QUERY,
+                                      self->batch_size,
                                       self->io_priority,
                                       self->cancellable,
                                       gtk_directory_list_got_files_cb,
@@ -507,7 +776,7 @@ gtk_directory_list_start_loading (GtkDirectoryList *self)
 
   self->cancellable = g_cancellable_new ();
   g_file_enumerate_children_async (self->file,
-                                   self->attributes,
+                                   self->eager_attributes ? self->eager_attributes : self->attributes,
                                    G_FILE_QUERY_INFO_NONE,
                                    self->io_priority,
                                    self->cancellable,
@@ -533,6 +802,9 @@ got_new_file_info_cb (GObject      *source,
     return;
 
   g_file_info_set_attribute_object (info, "standard::file", G_OBJECT (file));
+  g_object_set_qdata (G_OBJECT (info), lazy_quark, GINT_TO_POINTER (TRUE));
+
+  gtk_directory_list_flush_pending (self);
   position = g_sequence_get_length (self->items);
   g_sequence_append (self->items, info);
   g_list_model_items_changed (G_LIST_MODEL (self), position, 0, 1);
@@ -553,6 +825,9 @@ got_existing_file_info_cb (GObject      *source,
     return;
 
   g_file_info_set_attribute_object (info, "standard::file", G_OBJECT (file));
+  g_object_set_qdata (G_OBJECT (info), lazy_quark, GINT_TO_POINTER (TRUE));
+
+  gtk_directory_list_flush_pending (self);
 
   for (iter = g_sequence_get_begin_iter (self->items);
        !g_sequence_iter_is_end (iter);
@@ -576,6 +851,8 @@ gtk_directory_list_remove_file (GtkDirectoryList *self,
 {
   GSequenceIter *iter;
 
+  gtk_directory_list_flush_pending (self);
+
   for (iter = g_sequence_get_begin_iter (self->items);
        !g_sequence_iter_is_end (iter);
        iter = g_sequence_iter_next (iter))
@@ -726,6 +1003,7 @@ gtk_directory_list_set_attributes (GtkDirectoryList *self,
 
   g_free (self->attributes);
   self->attributes = g_strdup (attributes);
+  gtk_directory_list_split_attributes (self);
 
   gtk_directory_list_start_loading (self);
 
@@ -216,7 +216,7 @@ struct _GtkEmojiChooser
   EmojiSection flags;
 
   GVariant *data;
-  GtkWidget *box;
+  EmojiSection *section;
   GVariantIter *iter;
   guint populate_idle;
 
@@ -244,6 +244,7 @@ gtk_emoji_chooser_finalize (GObject *object)
   if (chooser->populate_idle)
     g_source_remove (chooser->populate_idle);
 
+  g_clear_pointer (&chooser->iter, g_variant_iter_free);
   g_clear_pointer (&chooser->data, g_variant_unref);
   g_clear_object (&chooser->settings);
 
@@ -669,6 +670,24 @@ get_emoji_data (void)
   return g_resources_lookup_data ("/org/gtk/libgtk/emoji/en.data", 0, NULL);
 }
 
+/* Sections are filled while they are hidden, so adding a child doesn't
+ * queue a resize of the whole chooser and the flow boxes that are
+ * already populated don't get measured and allocated again for every
+ * batch. A section is shown once all its emoji have been added.
+ */
+static void
+begin_populate_section (GtkEmojiChooser *chooser,
+                        EmojiSection    *section)
+{
+  if (chooser->section)
+    gtk_widget_set_visible (chooser->section->box, !chooser->section->empty);
+
+  chooser->section = section;
+
+  if (section)
+    gtk_widget_set_visible (section->box, FALSE);
+}
+
 static gboolean
 populate_emoji_chooser (gpointer data)
 {
@@ -691,35 +710,39 @@ populate_emoji_chooser (gpointer data)
   if (!chooser->iter)
     {
       chooser->iter = g_variant_iter_new (chooser->data);
-      chooser->box = chooser->people.box;
+      begin_populate_section (chooser, &chooser->people);
     }
 
   while ((item = g_variant_iter_next_value (chooser->iter)))
     {
+      EmojiSection *section = chooser->section;
       guint group;
 
       g_variant_get_child (item, 3, "u", &group);
 
       if (group == chooser->people.group)
-        chooser->box = chooser->people.box;
+        section = &chooser->people;
       else if (group == chooser->body.group)
-        chooser->box = chooser->body.box;
+        section = &chooser->body;
       else if (group == chooser->nature.group)
-        chooser->box = chooser->nature.box;
+        section = &chooser->nature;
       else if (group == chooser->food.group)
-        chooser->box = chooser->food.box;
+        section = &chooser->food;
       else if (group == chooser->travel.group)
-        chooser->box = chooser->travel.box;
+        section = &chooser->travel;
       else if (group == chooser->activities.group)
-        chooser->box = chooser->activities.box;
+        section = &chooser->activities;
       else if (group == chooser->objects.group)
-        chooser->box = chooser->objects.box;
+        section = &chooser->objects;
       else if (group == chooser->symbols.group)
-        chooser->box = chooser->symbols.box;
+        section = &chooser->symbols;
       else if (group == chooser->flags.group)
-        chooser->box = chooser->flags.box;
+        section = &chooser->flags;
+
+      if (section != chooser->section)
+        begin_populate_section (chooser, section);
 
-      add_emoji (chooser->box, FALSE, item, 0, chooser);
+      add_emoji (section->box, FALSE, item, 0, chooser);
       g_variant_unref (item);
 
       now = g_get_monotonic_time ();
@@ -730,9 +753,9 @@ populate_emoji_chooser (gpointer data)
         }
     }
 
+  begin_populate_section (chooser, NULL);
   g_variant_iter_free (chooser->iter);
   chooser->iter = NULL;
-  chooser->box = NULL;
   chooser->populate_idle = 0;
 
   gdk_profiler_end_mark (start, "emojichooser", "populate (finish)");
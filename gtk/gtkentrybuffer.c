@@ -98,6 +98,23 @@ trash_area (char *area,
     *varea++ = 0;
 }
 
+/* Convert a character offset into a byte offset into the text. This
+ * avoids walking the UTF-8 for the end of the text, which is where
+ * typing happens, and for text that is all ASCII.
+ */
+static gsize
+gtk_entry_buffer_normal_get_byte_offset (GtkEntryBufferPrivate *pv,
+                                         guint                  position)
+{
+  if (position >= pv->normal_text_chars)
+    return pv->normal_text_bytes;
+
+  if (pv->normal_text_bytes == pv->normal_text_chars)
+    return position;
+
+  return g_utf8_offset_to_pointer (pv->normal_text, position) - pv->normal_text;
+}
+
 static const char *
 gtk_entry_buffer_normal_get_text (GtkEntryBuffer *buffer,
                                   gsize          *n_bytes)
@@ -173,7 +190,7 @@ gtk_entry_buffer_normal_insert_text (GtkEntryBuffer *buffer,
     }
 
   /* Actual text insertion */
-  at = g_utf8_offset_to_pointer (pv->normal_text, position) - pv->normal_text;
+  at = gtk_entry_buffer_normal_get_byte_offset (pv, position);
   memmove (pv->normal_text + at + n_bytes, pv->normal_text + at, pv->normal_text_bytes - at);
   memcpy (pv->normal_text + at, chars, n_bytes);
 
@@ -226,8 +243,8 @@ gtk_entry_buffer_real_deleted_text (GtkEntryBuffer *buffer,
   GtkEntryBufferPrivate *pv = gtk_entry_buffer_get_instance_private (buffer);
   gsize start, end;
 
-  start = g_utf8_offset_to_pointer (pv->normal_text, position) - pv->normal_text;
-  end = g_utf8_offset_to_pointer (pv->normal_text, position + n_chars) - pv->normal_text;
+  start = gtk_entry_buffer_normal_get_byte_offset (pv, position);
+  end = gtk_entry_buffer_normal_get_byte_offset (pv, position + n_chars);
 
   memmove (pv->normal_text + start, pv->normal_text + end, pv->normal_text_bytes + 1 - end);
   pv->normal_text_chars -= n_chars;
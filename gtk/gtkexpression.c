@@ -20,7 +20,7 @@
 
 #include "config.h"
 
-#include "gtkexpression.h"
+#include "gtkexpressionprivate.h"
 
 #include <gobject/gvaluecollector.h>
 
@@ -1802,6 +1802,33 @@ gtk_expression_is_static (GtkExpression *self)
   return GTK_EXPRESSION_GET_CLASS (self)->is_static (self);
 }
 
+/*<private>
+ * gtk_expression_is_thread_safe:
+ * @self: (nullable): a #GtkExpression
+ *
+ * Checks if @self can be evaluated from multiple threads at once,
+ * provided the objects it is evaluated on aren't modified meanwhile.
+ *
+ * Constants and properties are fine, anything that calls out to
+ * application code may not be.
+ *
+ * Returns: %TRUE if @self can be evaluated in other threads
+ */
+gboolean
+gtk_expression_is_thread_safe (GtkExpression *self)
+{
+  if (self == NULL)
+    return TRUE;
+
+  if (G_TYPE_CHECK_INSTANCE_TYPE (self, GTK_TYPE_CONSTANT_EXPRESSION))
+    return TRUE;
+
+  if (G_TYPE_CHECK_INSTANCE_TYPE (self, GTK_TYPE_PROPERTY_EXPRESSION))
+    return gtk_expression_is_thread_safe (((GtkPropertyExpression *) self)->expr);
+
+  return FALSE;
+}
+
 static gboolean
 gtk_expression_watch_is_watching (GtkExpressionWatch *watch)
 {
@@ -2059,6 +2086,29 @@ gtk_expression_bind_notify (gpointer data)
   if (!gtk_expression_watch_evaluate (bind->watch, &value))
     return;
 
+  /* When many items change at once, most notifications along a
+   * property chain don't change the final value. Don't set it again
+   * in that case, so that the target doesn't emit notify and its own
+   * watchers, like filters and sorters, don't do the work again.
+   */
+  if ((bind->pspec->flags & G_PARAM_READABLE) &&
+      G_VALUE_TYPE (&value) == bind->pspec->value_type)
+    {
+      GValue current = G_VALUE_INIT;
+      gboolean unchanged;
+
+      g_value_init (&current, bind->pspec->value_type);
+      g_object_get_property (bind->target, bind->pspec->name, &current);
+      unchanged = g_param_values_cmp (bind->pspec, &value, &current) == 0;
+      g_value_unset (&current);
+
+      if (unchanged)
+        {
+          g_value_unset (&value);
+          return;
+        }
+    }
+
   g_object_set_property (bind->target, bind->pspec->name, &value);
   g_value_unset (&value);
 }
@@ -2075,7 +2125,8 @@ gtk_expression_bind_notify (gpointer data)
  *
  * The value that @self evaluates to is set via g_object_set() on
  * @target. This is repeated whenever @self changes to ensure that
- * the object's property stays synchronized with @self.
+ * the object's property stays synchronized with @self. If @property
+ * is readable and already has the new value, it is not set again.
  *
  * If @self's evaluation fails, @target's @property is not updated.
  * You can ensure that this doesn't happen by using a fallback
@@ -223,6 +223,9 @@ struct _GtkFileChooserWidget
   GtkQuery *search_query;
   GtkFileSystemModel *search_model;
   GtkFileSystemModel *model_for_search;
+  GList *search_pending_hits;
+  guint search_flush_id;
+  guint n_search_results;
 
   /* OPERATION_MODE_RECENT */
   GtkRecentManager *recent_manager;
@@ -6454,11 +6457,14 @@ get_selected_infos (GtkFileChooserWidget *impl)
   return result;
 }
 
-/* Callback used from GtkSearchEngine when we get new hits */
+/* Searching a big folder hierarchy produces many thousands of hits, so
+ * we stop once we have this many instead of growing the list forever.
+ */
+#define MAX_SEARCH_RESULTS 5000
+
 static void
-search_engine_hits_added_cb (GtkSearchEngine      *engine,
-                             GList                *hits,
-                             GtkFileChooserWidget *impl)
+search_add_hits (GtkFileChooserWidget *impl,
+                 GList                *hits)
 {
   GList *l, *files, *files_with_info, *infos;
   GFile *file;
@@ -6487,8 +6493,67 @@ search_engine_hits_added_cb (GtkSearchEngine      *engine,
   g_list_free_full (files, g_object_unref);
   g_list_free_full (files_with_info, g_object_unref);
   g_list_free_full (infos, g_object_unref);
+}
+
+/* Adds the hits that arrived since the last frame in one go, so that
+ * the search model is only re-sorted once per frame instead of once
+ * for every batch the search engines report.
+ */
+static gboolean
+search_flush_hits (GtkWidget     *widget,
+                   GdkFrameClock *frame_clock,
+                   gpointer       data)
+{
+  GtkFileChooserWidget *impl = GTK_FILE_CHOOSER_WIDGET (widget);
+  GList *hits, *rest;
+  guint n_hits;
+
+  impl->search_flush_id = 0;
+
+  hits = g_list_reverse (impl->search_pending_hits);
+  impl->search_pending_hits = NULL;
+
+  n_hits = MIN (g_list_length (hits), MAX_SEARCH_RESULTS - impl->n_search_results);
+  rest = g_list_nth (hits, n_hits);
+  if (rest)
+    {
+      if (rest->prev)
+        rest->prev->next = NULL;
+      else
+        hits = NULL;
+      rest->prev = NULL;
+      g_list_free_full (rest, (GDestroyNotify) _gtk_search_hit_free);
+    }
+
+  search_add_hits (impl, hits);
+  impl->n_search_results += n_hits;
+
+  g_list_free_full (hits, (GDestroyNotify) _gtk_search_hit_free);
 
   gtk_stack_set_visible_child_name (GTK_STACK (impl->browse_files_stack), "list");
+
+  if (impl->n_search_results >= MAX_SEARCH_RESULTS)
+    search_stop_searching (impl, FALSE);
+
+  return G_SOURCE_REMOVE;
+}
+
+/* Callback used from GtkSearchEngine when we get new hits */
+static void
+search_engine_hits_added_cb (GtkSearchEngine      *engine,
+                             GList                *hits,
+                             GtkFileChooserWidget *impl)
+{
+  GList *l;
+
+  for (l = hits; l; l = l->next)
+    impl->search_pending_hits = g_list_prepend (impl->search_pending_hits,
+                                                _gtk_search_hit_dup (l->data));
+
+  if (impl->search_flush_id == 0)
+    impl->search_flush_id = gtk_widget_add_tick_callback (GTK_WIDGET (impl),
+                                                          search_flush_hits,
+                                                          NULL, NULL);
 }
 
 /* Callback used from GtkSearchEngine when the query is done running */
@@ -6541,7 +6606,9 @@ search_clear_model (GtkFileChooserWidget *impl,
   g_clear_object (&impl->search_model);
 }
 
-/* Stops any ongoing searches; does not touch the search_model */
+/* Stops any ongoing searches and drops the hits that have not been
+ * added yet; does not touch the search_model
+ */
 static void
 search_stop_searching (GtkFileChooserWidget *impl,
                        gboolean              remove_query)
@@ -6551,6 +6618,14 @@ search_stop_searching (GtkFileChooserWidget *impl,
       gtk_editable_set_text (GTK_EDITABLE (impl->search_entry), "");
     }
 
+  if (impl->search_flush_id)
+    {
+      gtk_widget_remove_tick_callback (GTK_WIDGET (impl), impl->search_flush_id);
+      impl->search_flush_id = 0;
+    }
+  g_list_free_full (impl->search_pending_hits, (GDestroyNotify) _gtk_search_hit_free);
+  impl->search_pending_hits = NULL;
+
   if (impl->search_engine)
     {
       _gtk_search_engine_stop (impl->search_engine);
@@ -6625,6 +6700,7 @@ search_start_query (GtkFileChooserWidget *impl,
   search_stop_searching (impl, FALSE);
   search_clear_model (impl, TRUE);
   search_setup_model (impl);
+  impl->n_search_results = 0;
 
   set_busy_cursor (impl, TRUE);
   impl->show_progress_timeout = g_timeout_add (1500, show_spinner, impl);
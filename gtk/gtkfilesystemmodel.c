@@ -185,6 +185,7 @@ struct _GtkFileSystemModel
 
   gboolean              filter_on_thaw :1;/* set when filtering needs to happen upon thawing */
   gboolean              sort_on_thaw :1;/* set when sorting needs to happen upon thawing */
+  gboolean              sort_added_on_thaw :1;/* set when only nodes added while frozen need sorting upon thawing */
 
   guint                 show_hidden :1; /* whether to show hidden files */
   guint                 show_folders :1;/* whether to show folders */
@@ -776,11 +777,116 @@ gtk_file_system_model_sort (GtkFileSystemModel *model)
     }
 
   model->sort_on_thaw = FALSE;
+  model->sort_added_on_thaw = FALSE;
+}
+
+/* Sorts the nodes that were added while frozen and merges them into
+ * the already sorted nodes before them. Those nodes aren't visible
+ * yet and the relative order of all other nodes stays the same, so
+ * unlike a full sort this doesn't need to emit rows-reordered. For a
+ * big folder that is loaded in many batches, this avoids re-sorting
+ * everything that was loaded before with every batch.
+ */
+static void
+gtk_file_system_model_sort_added (GtkFileSystemModel *model)
+{
+  SortData data;
+  guint first_added, n_added, n_sorted;
+  guint *insert_pos;
+  guint i, lo, hi;
+  char *sorted;
+
+  model->sort_added_on_thaw = FALSE;
+
+  if (!sort_data_init (&data, model))
+    return;
+
+  for (first_added = model->files->len;
+       first_added > 1 && get_node (model, first_added - 1)->frozen_add;
+       first_added--)
+    ;
+  n_added = model->files->len - first_added;
+  if (n_added == 0)
+    return;
+
+  model->n_nodes_valid = MIN (model->n_nodes_valid, first_added);
+  g_hash_table_remove_all (model->file_lookup);
+
+  g_qsort_with_data (get_node (model, first_added),
+                     n_added,
+                     model->node_size,
+                     compare_array_element,
+                     &data);
+
+  n_sorted = first_added - 1; /* don't sort the editable row */
+  if (n_sorted == 0)
+    return;
+
+  /* The insert positions only ever grow, so each binary search
+   * can start where the last one ended. */
+  insert_pos = g_new (guint, n_added);
+  lo = 1;
+  for (i = 0; i < n_added; i++)
+    {
+      gpointer added = get_node (model, first_added + i);
+
+      hi = first_added;
+      while (lo < hi)
+        {
+          guint mid = lo + (hi - lo) / 2;
+
+          if (compare_array_element (get_node (model, mid), added, &data) <= 0)
+            lo = mid + 1;
+          else
+            hi = mid;
+        }
+      insert_pos[i] = lo;
+    }
+
+  if (insert_pos[0] < first_added)
+    {
+      guint src, dest;
+
+      sorted = g_malloc (model->files->len * model->node_size);
+      memcpy (sorted, get_node (model, 0), model->node_size);
+      src = 1;
+      dest = 1;
+      for (i = 0; i < n_added; i++)
+        {
+          memcpy (sorted + dest * model->node_size,
+                  get_node (model, src),
+                  (insert_pos[i] - src) * model->node_size);
+          dest += insert_pos[i] - src;
+          src = insert_pos[i];
+          memcpy (sorted + dest * model->node_size,
+                  get_node (model, first_added + i),
+                  model->node_size);
+          dest++;
+        }
+      memcpy (sorted + dest * model->node_size,
+              get_node (model, src),
+              (first_added - src) * model->node_size);
+
+      memcpy (model->files->data, sorted, model->files->len * model->node_size);
+      g_free (sorted);
+
+      model->n_nodes_valid = MIN (model->n_nodes_valid, insert_pos[0]);
+    }
+
+  g_free (insert_pos);
 }
 
 static void
 gtk_file_system_model_sort_node (GtkFileSystemModel *model, guint node)
 {
+  if (model->frozen && get_node (model, node)->frozen_add)
+    {
+      /* sorted once all new nodes are in, see thaw_updates() */
+      if (!model->sort_on_thaw)
+        model->sort_added_on_thaw = TRUE;
+      return;
+    }
+
   /* FIXME: improve */
   gtk_file_system_model_sort (model);
 }
@@ -2002,6 +2108,8 @@ thaw_updates (GtkFileSystemModel *model)
     gtk_file_system_model_refilter_all (model);
   if (model->sort_on_thaw)
     gtk_file_system_model_sort (model);
+  else if (model->sort_added_on_thaw)
+    gtk_file_system_model_sort_added (model);
   if (stuff_added)
     {
       guint i;
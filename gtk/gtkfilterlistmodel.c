@@ -22,6 +22,8 @@
 #include "gtkfilterlistmodel.h"
 
 #include "gtkbitset.h"
+#include "gtkfilterprivate.h"
+#include "gtkincrementalprivate.h"
 #include "gtkintl.h"
 #include "gtkprivate.h"
 
@@ -61,7 +63,7 @@ struct _GtkFilterListModel
 
   GtkBitset *matches; /* NULL if strictness != GTK_FILTER_MATCH_SOME */
   GtkBitset *pending; /* not yet filtered items or NULL if all filtered */
-  guint pending_cb; /* idle callback handle */
+  guint pending_cb; /* incremental work handle */
 };
 
 struct _GtkFilterListModelClass
@@ -156,6 +158,171 @@ gtk_filter_list_model_run_filter_on_item (GtkFilterListModel *self,
   return visible;
 }
 
+/* Filtering large lists at once is spread over a thread pool if the
+ * filter says that is safe. Source models don't need to be thread-safe,
+ * so the items are fetched in batches on the calling thread and only
+ * gtk_filter_match() runs in the pool.
+ */
+#define MIN_THREADED_ITEMS 4096
+#define MIN_ITEMS_PER_CHUNK 1024
+#define ITEMS_PER_BATCH (64 * 1024)
+
+typedef struct
+{
+  GMutex lock;
+  GCond cond;
+  guint n_pending;
+} FilterJob;
+
+typedef struct
+{
+  FilterJob *job;
+  GtkFilter *filter;
+  gpointer *items;
+  guint *positions;
+  guint n_items;
+  GtkBitset *matches;
+} FilterChunk;
+
+static void
+filter_chunk (gpointer data,
+              gpointer user_data)
+{
+  FilterChunk *chunk = data;
+  FilterJob *job = chunk->job;
+  guint i;
+
+  for (i = 0; i < chunk->n_items; i++)
+    {
+      if (gtk_filter_match (chunk->filter, chunk->items[i]))
+        gtk_bitset_add (chunk->matches, chunk->positions[i]);
+    }
+
+  g_mutex_lock (&job->lock);
+  job->n_pending--;
+  if (job->n_pending == 0)
+    g_cond_signal (&job->cond);
+  g_mutex_unlock (&job->lock);
+}
+
+/* Returns %NULL if we only have one processor */
+static GThreadPool *
+get_filter_pool (void)
+{
+  static GThreadPool *pool = NULL;
+  static gsize initialized = 0;
+
+  if (g_once_init_enter (&initialized))
+    {
+      guint n_processors = g_get_num_processors ();
+
+      if (n_processors > 1)
+        pool = g_thread_pool_new (filter_chunk, NULL, n_processors, FALSE, NULL);
+
+      g_once_init_leave (&initialized, 1);
+    }
+
+  return pool;
+}
+
+static void
+gtk_filter_list_model_run_filter_batch (GtkFilterListModel *self,
+                                        GThreadPool        *pool,
+                                        gpointer           *items,
+                                        guint              *positions,
+                                        guint               n_items)
+{
+  FilterChunk *chunks;
+  FilterJob job;
+  guint i, n_chunks, items_per_chunk;
+
+  n_chunks = MIN (g_get_num_processors (), (n_items + MIN_ITEMS_PER_CHUNK - 1) / MIN_ITEMS_PER_CHUNK);
+  items_per_chunk = (n_items + n_chunks - 1) / n_chunks;
+  n_chunks = (n_items + items_per_chunk - 1) / items_per_chunk;
+
+  chunks = g_newa (FilterChunk, n_chunks);
+
+  g_mutex_init (&job.lock);
+  g_cond_init (&job.cond);
+  job.n_pending = n_chunks;
+
+  for (i = 0; i < n_chunks; i++)
+    {
+      chunks[i] = (FilterChunk) {
+        .job = &job,
+        .filter = self->filter,
+        .items = items + i * items_per_chunk,
+        .positions = positions + i * items_per_chunk,
+        .n_items = MIN (items_per_chunk, n_items - i * items_per_chunk),
+        .matches = gtk_bitset_new_empty (),
+      };
+    }
+
+  /* Filter the first chunk ourselves instead of idling */
+  for (i = 1; i < n_chunks; i++)
+    g_thread_pool_push (pool, &chunks[i], NULL);
+
+  filter_chunk (&chunks[0], NULL);
+
+  g_mutex_lock (&job.lock);
+  while (job.n_pending > 0)
+    g_cond_wait (&job.cond, &job.lock);
+  g_mutex_unlock (&job.lock);
+
+  g_mutex_clear (&job.lock);
+  g_cond_clear (&job.cond);
+
+  for (i = 0; i < n_chunks; i++)
+    {
+      gtk_bitset_union (self->matches, chunks[i].matches);
+      gtk_bitset_unref (chunks[i].matches);
+    }
+}
+
+/* Filters all pending items, returns %FALSE if that needs
+ * to be done on this thread */
+static gboolean
+gtk_filter_list_model_run_filter_threaded (GtkFilterListModel *self)
+{
+  GtkBitsetIter iter;
+  GThreadPool *pool;
+  gpointer *items;
+  guint *positions;
+  guint i, pos;
+  gboolean more;
+
+  if (!gtk_filter_is_thread_safe (self->filter) ||
+      gtk_bitset_get_size (self->pending) < MIN_THREADED_ITEMS ||
+      (pool = get_filter_pool ()) == NULL)
+    return FALSE;
+
+  items = g_new (gpointer, ITEMS_PER_BATCH);
+  positions = g_new (guint, ITEMS_PER_BATCH);
+
+  more = gtk_bitset_iter_init_first (&iter, self->pending, &pos);
+  while (more)
+    {
+      for (i = 0; i < ITEMS_PER_BATCH && more; i++, more = gtk_bitset_iter_next (&iter, &pos))
+        {
+          items[i] = g_list_model_get_item (self->model, pos);
+          positions[i] = pos;
+        }
+
+      gtk_filter_list_model_run_filter_batch (self, pool, items, positions, i);
+
+      while (i-- > 0)
+        g_object_unref (items[i]);
+    }
+
+  g_free (items);
+  g_free (positions);
+
+  g_clear_pointer (&self->pending, gtk_bitset_unref);
+  g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_PENDING]);
+
+  return TRUE;
+}
+
 static void
 gtk_filter_list_model_run_filter (GtkFilterListModel *self,
                                   guint               n_steps)
@@ -169,6 +336,10 @@ gtk_filter_list_model_run_filter (GtkFilterListModel *self,
   if (self->pending == NULL)
     return;
 
+  if (n_steps == G_MAXUINT &&
+      gtk_filter_list_model_run_filter_threaded (self))
+    return;
+
   for (i = 0, more = gtk_bitset_iter_init_first (&iter, self->pending, &pos);
        i < n_steps && more;
        i++, more = gtk_bitset_iter_next (&iter, &pos))
@@ -192,7 +363,7 @@ gtk_filter_list_model_stop_filtering (GtkFilterListModel *self)
   gboolean notify_pending = self->pending != NULL;
 
   g_clear_pointer (&self->pending, gtk_bitset_unref);
-  g_clear_handle_id (&self->pending_cb, g_source_remove);
+  g_clear_handle_id (&self->pending_cb, gtk_incremental_remove);
 
   if (notify_pending)
     g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_PENDING]);
@@ -222,20 +393,27 @@ gtk_filter_list_model_emit_items_changed_for_changes (GtkFilterListModel *self,
 }
 
 static gboolean
-gtk_filter_list_model_run_filter_cb (gpointer data)
+gtk_filter_list_model_run_filter_cb (gpointer data,
+                                     gint64   end_time)
 {
   GtkFilterListModel *self = data;
   GtkBitset *old;
+  gboolean more;
 
   old = gtk_bitset_copy (self->matches);
-  gtk_filter_list_model_run_filter (self, 512);
+  do
+    {
+      gtk_filter_list_model_run_filter (self, 128);
+    }
+  while (self->pending && g_get_monotonic_time () < end_time);
 
-  if (self->pending == NULL)
+  more = self->pending != NULL;
+  if (!more)
     gtk_filter_list_model_stop_filtering (self);
 
   gtk_filter_list_model_emit_items_changed_for_changes (self, old);
 
-  return G_SOURCE_CONTINUE;
+  return more;
 }
 
 /* NB: bitset is (transfer full) */
@@ -268,8 +446,7 @@ gtk_filter_list_model_start_filtering (GtkFilterListModel *self,
 
   g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_PENDING]);
   g_assert (self->pending_cb == 0);
-  self->pending_cb = g_idle_add (gtk_filter_list_model_run_filter_cb, self);
-  g_source_set_name_by_id (self->pending_cb, "[gtk] gtk_filter_list_model_run_filter_cb");
+  self->pending_cb = gtk_incremental_add (G_LIST_MODEL (self), self->model, gtk_filter_list_model_run_filter_cb, self);
 }
 
 static void
@@ -51,6 +51,9 @@ struct _FlattenNode
 {
   GListModel *model;
   GtkFlattenListModel *list;
+  /* kept up to date by items-changed, so lookups don't need to call
+   * into the model */
+  guint n_items;
 };
 
 struct _FlattenAugment
@@ -98,7 +101,7 @@ gtk_flatten_list_model_get_nth (GtkRbTree *tree,
           position -= aug->n_items;
         }
 
-      model_n_items = g_list_model_get_n_items (node->model);
+      model_n_items = node->n_items;
       if (position < model_n_items)
         break;
       position -= model_n_items;
@@ -141,7 +144,7 @@ gtk_flatten_list_model_get_nth_model (GtkRbTree *tree,
       if (position == 0)
         break;
       position--;
-      before += g_list_model_get_n_items (node->model);
+      before += node->n_items;
 
       node = gtk_rb_tree_node_get_right (node);
     }
@@ -216,6 +219,7 @@ gtk_flatten_list_model_items_changed_cb (GListModel          *model,
   GtkFlattenListModel *self = node->list;
   guint real_position;
 
+  node->n_items = node->n_items - removed + added;
   gtk_rb_tree_node_mark_dirty (node);
   real_position = position;
 
@@ -238,7 +242,7 @@ gtk_flatten_list_model_items_changed_cb (GListModel          *model,
               FlattenAugment *aug = gtk_rb_tree_get_augment (self->items, left);
               real_position += aug->n_items;
             }
-          real_position += g_list_model_get_n_items (parent->model);
+          real_position += parent->n_items;
         }
     }
 
@@ -264,7 +268,7 @@ gtk_flatten_list_model_augment (GtkRbTree *flatten,
   FlattenNode *node = _node;
   FlattenAugment *aug = _aug;
 
-  aug->n_items = g_list_model_get_n_items (node->model);
+  aug->n_items = node->n_items;
   aug->n_models = 1;
 
   if (left)
@@ -287,20 +291,33 @@ gtk_flatten_list_model_add_items (GtkFlattenListModel *self,
                                   guint                position,
                                   guint                n)
 {
-  FlattenNode *node;
+  FlattenNode *node, *filled;
   guint added, i;
 
+  /* Build the tree in one go when setting a new model */
+  if (gtk_rb_tree_get_root (self->items) == NULL)
+    filled = gtk_rb_tree_fill (self->items, n);
+  else
+    filled = NULL;
+
   added = 0;
   for (i = 0; i < n; i++)
     {
-      node = gtk_rb_tree_insert_before (self->items, after);
+      if (filled)
+        {
+          node = filled;
+          filled = gtk_rb_tree_node_get_next (filled);
+        }
+      else
+        node = gtk_rb_tree_insert_before (self->items, after);
       node->model = g_list_model_get_item (self->model, position + i);
       g_signal_connect (node->model,
                         "items-changed",
                         G_CALLBACK (gtk_flatten_list_model_items_changed_cb),
                         node);
       node->list = self;
-      added += g_list_model_get_n_items (node->model);
+      node->n_items = g_list_model_get_n_items (node->model);
+      added += node->n_items;
     }
 
   return added;
@@ -362,7 +379,7 @@ gtk_flatten_list_model_model_items_changed_cb (GListModel          *model,
   for (i = 0; i < removed; i++)
     {
       FlattenNode *next = gtk_rb_tree_node_get_next (node);
-      real_removed += g_list_model_get_n_items (node->model);
+      real_removed += node->n_items;
       gtk_rb_tree_remove (self->items, node);
       node = next;
     }
@@ -118,6 +118,9 @@ static void gtk_flow_box_apply_sort          (GtkFlowBox      *box,
 static int gtk_flow_box_sort                 (GtkFlowBoxChild *a,
                                               GtkFlowBoxChild *b,
                                               GtkFlowBox      *box);
+static void gtk_flow_box_insert_child        (GtkFlowBox      *box,
+                                              GtkFlowBoxChild *child,
+                                              GSequenceIter   *before);
 
 static void gtk_flow_box_bound_model_changed (GListModel *list,
                                               guint       position,
@@ -3019,6 +3022,34 @@ gtk_flow_box_unmap (GtkWidget *widget)
   GTK_WIDGET_CLASS (gtk_flow_box_parent_class)->unmap (widget);
 }
 
+/* Returns whether @child was selected. The caller is responsible
+ * for emitting ::selected-children-changed.
+ */
+static gboolean
+gtk_flow_box_remove_child (GtkFlowBox      *box,
+                           GtkFlowBoxChild *child)
+{
+  GtkFlowBoxPrivate *priv = BOX_PRIV (box);
+  gboolean was_visible;
+  gboolean was_selected;
+
+  was_visible = child_is_visible (GTK_WIDGET (child));
+  was_selected = CHILD_PRIV (child)->selected;
+
+  if (child == priv->active_child)
+    priv->active_child = NULL;
+  if (child == priv->selected_child)
+    priv->selected_child = NULL;
+
+  g_sequence_remove (CHILD_PRIV (child)->iter);
+  gtk_widget_unparent (GTK_WIDGET (child));
+
+  if (was_visible && gtk_widget_get_visible (GTK_WIDGET (box)))
+    gtk_widget_queue_resize (GTK_WIDGET (box));
+
+  return was_selected;
+}
+
 /**
  * gtk_flow_box_remove:
  * @box: a #GtkFlowBox
@@ -3030,9 +3061,6 @@ void
 gtk_flow_box_remove (GtkFlowBox *box,
                      GtkWidget  *widget)
 {
-  GtkFlowBoxPrivate *priv = BOX_PRIV (box);
-  gboolean was_visible;
-  gboolean was_selected;
   GtkFlowBoxChild *child;
 
   g_return_if_fail (GTK_IS_FLOW_BOX (box));
@@ -3052,21 +3080,8 @@ gtk_flow_box_remove (GtkFlowBox *box,
         }
     }
 
-  was_visible = child_is_visible (GTK_WIDGET (child));
-  was_selected = CHILD_PRIV (child)->selected;
-
-  if (child == priv->active_child)
-    priv->active_child = NULL;
-  if (child == priv->selected_child)
-    priv->selected_child = NULL;
-
-  g_sequence_remove (CHILD_PRIV (child)->iter);
-  gtk_widget_unparent (GTK_WIDGET (child));
-
-  if (was_visible && gtk_widget_get_visible (GTK_WIDGET (box)))
-    gtk_widget_queue_resize (GTK_WIDGET (box));
-
-  if (was_selected && !gtk_widget_in_destruction (GTK_WIDGET (box)))
+  if (gtk_flow_box_remove_child (box, child) &&
+      !gtk_widget_in_destruction (GTK_WIDGET (box)))
     g_signal_emit (box, signals[SELECTED_CHILDREN_CHANGED], 0);
 }
 
@@ -3960,20 +3975,32 @@ gtk_flow_box_bound_model_changed (GListModel *list,
 {
   GtkFlowBox *box = user_data;
   GtkFlowBoxPrivate *priv = BOX_PRIV (box);
+  GSequenceIter *iter;
+  gboolean selection_changed = FALSE;
   int i;
 
+  /* Model changes come in ranges, so look up the position once and
+   * walk from there, instead of going through gtk_flow_box_remove()
+   * and gtk_flow_box_insert() which each look up their position and
+   * emit ::selected-children-changed for every selected child.
+   */
+  iter = g_sequence_get_iter_at_pos (priv->children, position);
+
   while (removed--)
     {
       GtkFlowBoxChild *child;
 
-      child = gtk_flow_box_get_child_at_index (box, position);
-      gtk_flow_box_remove (box, GTK_WIDGET (child));
+      child = g_sequence_get (iter);
+      iter = g_sequence_iter_next (iter);
+      if (gtk_flow_box_remove_child (box, child))
+        selection_changed = TRUE;
     }
 
   for (i = 0; i < added; i++)
     {
       GObject *item;
       GtkWidget *widget;
+      GtkFlowBoxChild *child;
 
       item = g_list_model_get_item (list, position + i);
       widget = priv->create_widget_func (item, priv->create_widget_func_data);
@@ -3990,11 +4017,23 @@ gtk_flow_box_bound_model_changed (GListModel *list,
         g_object_ref_sink (widget);
 
       gtk_widget_show (widget);
-      gtk_flow_box_insert (box, widget, position + i);
+
+      if (GTK_IS_FLOW_BOX_CHILD (widget))
+        child = GTK_FLOW_BOX_CHILD (widget);
+      else
+        {
+          child = GTK_FLOW_BOX_CHILD (gtk_flow_box_child_new ());
+          gtk_flow_box_child_set_child (child, widget);
+        }
+
+      gtk_flow_box_insert_child (box, child, iter);
 
       g_object_unref (widget);
       g_object_unref (item);
     }
+
+  if (selection_changed)
+    g_signal_emit (box, signals[SELECTED_CHILDREN_CHANGED], 0);
 }
 
 /* Buildable implementation {{{3 */
@@ -4053,6 +4092,28 @@ gtk_flow_box_insert_widget (GtkFlowBox    *box,
   gtk_widget_insert_after (child, GTK_WIDGET (box), sibling);
 }
 
+/* Inserts @child before @before, or at its sorted position
+ * if a sort function is set.
+ */
+static void
+gtk_flow_box_insert_child (GtkFlowBox      *box,
+                           GtkFlowBoxChild *child,
+                           GSequenceIter   *before)
+{
+  GtkFlowBoxPrivate *priv = BOX_PRIV (box);
+  GSequenceIter *iter;
+
+  if (priv->sort_func != NULL)
+    iter = g_sequence_insert_sorted (priv->children, child,
+                                     (GCompareDataFunc)gtk_flow_box_sort, box);
+  else
+    iter = g_sequence_insert_before (before, child);
+
+  CHILD_PRIV (child)->iter = iter;
+  gtk_flow_box_insert_widget (box, GTK_WIDGET (child), iter);
+  gtk_flow_box_apply_filter (box, child);
+}
+
 /**
  * gtk_flow_box_insert:
  * @box: a #GtkFlowBox
@@ -4090,22 +4151,15 @@ gtk_flow_box_insert (GtkFlowBox *box,
     }
 
   if (priv->sort_func != NULL)
-    iter = g_sequence_insert_sorted (priv->children, child,
-                                     (GCompareDataFunc)gtk_flow_box_sort, box);
+    iter = NULL;
   else if (position == 0)
-    iter = g_sequence_prepend (priv->children, child);
+    iter = g_sequence_get_begin_iter (priv->children);
   else if (position == -1)
-    iter = g_sequence_append (priv->children, child);
+    iter = g_sequence_get_end_iter (priv->children);
   else
-    {
-      GSequenceIter *pos;
-      pos = g_sequence_get_iter_at_pos (priv->children, position);
-      iter = g_sequence_insert_before (pos, child);
-    }
+    iter = g_sequence_get_iter_at_pos (priv->children, position);
 
-  CHILD_PRIV (child)->iter = iter;
-  gtk_flow_box_insert_widget (box, GTK_WIDGET (child), iter);
-  gtk_flow_box_apply_filter (box, child);
+  gtk_flow_box_insert_child (box, child, iter);
 }
 
 /**
@@ -31,6 +31,8 @@
 #include "gtknative.h"
 #include "gtkwidgetprivate.h"
 
+#include "gdk/gdkglcontextprivate.h"
+
 #include <epoxy/gl.h>
 
 /**
@@ -149,6 +151,8 @@ typedef struct {
   int width;
   int height;
   GdkTexture *holder;
+  /* Signaled when GSK is done reading the texture */
+  GLsync sync;
 } Texture;
 
 typedef struct {
@@ -390,6 +394,12 @@ delete_one_texture (gpointer data)
   if (texture->holder)
     gdk_gl_texture_release (GDK_GL_TEXTURE (texture->holder));
 
+  if (texture->sync)
+    {
+      glDeleteSync (texture->sync);
+      texture->sync = NULL;
+    }
+
   if (texture->id != 0)
     {
       glDeleteTextures (1, &texture->id);
@@ -427,7 +437,17 @@ gtk_gl_area_ensure_texture (GtkGLArea *area)
           priv->textures = g_list_delete_link (priv->textures, link);
 
           if (priv->texture == NULL)
-            priv->texture = texture;
+            {
+              /* Make the GPU wait until the renderer is done reading
+               * the texture before we draw into it again */
+              if (texture->sync)
+                {
+                  glWaitSync (texture->sync, 0, GL_TIMEOUT_IGNORED);
+                  glDeleteSync (texture->sync);
+                  texture->sync = NULL;
+                }
+              priv->texture = texture;
+            }
           else
             delete_one_texture (texture);
         }
@@ -440,6 +460,7 @@ gtk_gl_area_ensure_texture (GtkGLArea *area)
       priv->texture->width = 0;
       priv->texture->height = 0;
       priv->texture->holder = NULL;
+      priv->texture->sync = NULL;
 
       glGenTextures (1, &priv->texture->id);
     }
@@ -671,10 +692,14 @@ gtk_gl_area_draw_error_screen (GtkGLArea   *area,
 }
 
 static void
-release_texture (gpointer data)
+release_texture (GdkGLTexture *holder,
+                 gpointer      sync,
+                 gpointer      data)
 {
   Texture *texture = data;
+
   texture->holder = NULL;
+  texture->sync = sync;
 }
 
 static void
@@ -737,11 +762,16 @@ gtk_gl_area_snapshot (GtkWidget   *widget,
       priv->texture = NULL;
       priv->textures = g_list_prepend (priv->textures, texture);
 
-      texture->holder = gdk_gl_texture_new (priv->context,
-                                            texture->id,
-                                            texture->width,
-                                            texture->height,
-                                            release_texture, texture);
+      /* Hand the texture over with a fence instead of flushing, so
+       * the renderer only waits for the rendering on the GPU */
+      texture->holder = gdk_gl_texture_new_with_sync (priv->context,
+                                                      texture->id,
+                                                      texture->width,
+                                                      texture->height,
+                                                      gdk_gl_context_has_sync (priv->context)
+                                                        ? glFenceSync (GL_SYNC_GPU_COMMANDS_COMPLETE, 0)
+                                                        : NULL,
+                                                      release_texture, texture);
 
       /* Our texture is rendered by OpenGL, so it is upside down,
        * compared to what GSK expects, so flip it back.
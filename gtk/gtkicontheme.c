@@ -282,7 +282,10 @@ typedef enum
 #define DEBUG_CACHE(args)
 #endif
 
-#define LRU_CACHE_SIZE 100
+/* Budget for the decoded textures kept alive by the LRU cache,
+ * which is about a hundred 128x128 icons, or many more small ones.
+ */
+#define LRU_CACHE_MAX_BYTES (100 * 128 * 128 * 4)
 #define MAX_LRU_TEXTURE_SIZE 128
 
 typedef struct _GtkIconPaintableClass GtkIconPaintableClass;
@@ -309,8 +312,8 @@ struct _GtkIconTheme
 
   GHashTable *icon_cache;                       /* Protected by icon_cache lock */
 
-  GtkIconPaintable *lru_cache[LRU_CACHE_SIZE];  /* Protected by icon_cache lock */
-  int lru_cache_current;                        /* Protected by icon_cache lock */
+  GQueue lru_cache;                             /* Protected by icon_cache lock */
+  gsize lru_cache_size;                         /* Protected by icon_cache lock */
 
   char *current_theme;
   char **search_path;
@@ -377,6 +380,7 @@ struct _GtkIconPaintable
    */
   IconKey key;
   GtkIconTheme *in_cache; /* Protected by icon_cache lock */
+  GList lru_link;         /* Protected by icon_cache lock */
 
   char *icon_name;
   char *filename;
@@ -648,30 +652,55 @@ _icon_cache_should_lru_cache (GtkIconPaintable *icon)
   return icon->desired_size <= MAX_LRU_TEXTURE_SIZE;
 }
 
-/* This returns the old lru element because we can't unref it with
- * the lock held */
-static GtkIconPaintable *
+/* This is called with icon_cache lock held so must not take any locks */
+static gsize
+_icon_cache_get_lru_size (GtkIconPaintable *icon)
+{
+  gsize size = icon->desired_size * icon->desired_scale;
+
+  return size * size * 4;
+}
+
+/* This returns the evicted lru elements because we can't unref them
+ * with the lock held */
+static GSList *
 _icon_cache_add_to_lru_cache (GtkIconTheme     *theme,
                               GtkIconPaintable *icon)
 {
-  GtkIconPaintable *old_icon = NULL;
+  GSList *old_icons = NULL;
 
-  /* Avoid storing the same info multiple times in a row */
-  if (theme->lru_cache[theme->lru_cache_current] != icon)
+  if (icon->lru_link.data != NULL)
     {
-      theme->lru_cache_current = (theme->lru_cache_current + 1) % LRU_CACHE_SIZE;
-      old_icon = theme->lru_cache[theme->lru_cache_current];
-      theme->lru_cache[theme->lru_cache_current] = g_object_ref (icon);
+      /* Already cached, just move it to the front */
+      g_queue_unlink (&theme->lru_cache, &icon->lru_link);
+      g_queue_push_head_link (&theme->lru_cache, &icon->lru_link);
+      return NULL;
     }
 
-  return old_icon;
+  icon->lru_link.data = g_object_ref (icon);
+  g_queue_push_head_link (&theme->lru_cache, &icon->lru_link);
+  theme->lru_cache_size += _icon_cache_get_lru_size (icon);
+
+  while (theme->lru_cache_size > LRU_CACHE_MAX_BYTES &&
+         theme->lru_cache.length > 1)
+    {
+      GtkIconPaintable *old_icon = g_queue_peek_tail (&theme->lru_cache);
+
+      g_queue_unlink (&theme->lru_cache, &old_icon->lru_link);
+      old_icon->lru_link.data = NULL;
+      theme->lru_cache_size -= _icon_cache_get_lru_size (old_icon);
+
+      old_icons = g_slist_prepend (old_icons, old_icon);
+    }
+
+  return old_icons;
 }
 
 static GtkIconPaintable *
 icon_cache_lookup (GtkIconTheme *theme,
                    IconKey      *key)
 {
-  GtkIconPaintable *old_icon = NULL;
+  GSList *old_icons = NULL;
   GtkIconPaintable *icon;
 
   G_LOCK (icon_cache);
@@ -689,14 +718,13 @@ icon_cache_lookup (GtkIconTheme *theme,
 
       /* Move item to front in LRU cache */
       if (_icon_cache_should_lru_cache (icon))
-        old_icon = _icon_cache_add_to_lru_cache (theme, icon);
+        old_icons = _icon_cache_add_to_lru_cache (theme, icon);
     }
 
   G_UNLOCK (icon_cache);
 
-  /* Call potential finalizer outside the lock */
-  if (old_icon)
-    g_object_unref (old_icon);
+  /* Call potential finalizers outside the lock */
+  g_slist_free_full (old_icons, g_object_unref);
 
   return icon;
 }
@@ -720,33 +748,32 @@ icon_uncached_cb (GtkIconPaintable *icon)
 static void
 icon_cache_mark_used_if_cached (GtkIconPaintable *icon)
 {
-  GtkIconPaintable *old_icon = NULL;
+  GSList *old_icons = NULL;
 
   if (!_icon_cache_should_lru_cache (icon))
     return;
 
   G_LOCK (icon_cache);
   if (icon->in_cache)
-    old_icon = _icon_cache_add_to_lru_cache (icon->in_cache, icon);
+    old_icons = _icon_cache_add_to_lru_cache (icon->in_cache, icon);
   G_UNLOCK (icon_cache);
 
   /* Call potential finalizers outside the lock */
-  if (old_icon)
-    g_object_unref (old_icon);
+  g_slist_free_full (old_icons, g_object_unref);
 }
 
 static void
 icon_cache_add (GtkIconTheme     *theme,
                 GtkIconPaintable *icon)
 {
-  GtkIconPaintable *old_icon = NULL;
+  GSList *old_icons = NULL;
 
   G_LOCK (icon_cache);
   icon->in_cache = theme;
   g_hash_table_insert (theme->icon_cache, &icon->key, icon);
 
   if (_icon_cache_should_lru_cache (icon))
-    old_icon = _icon_cache_add_to_lru_cache (theme, icon);
+    old_icons = _icon_cache_add_to_lru_cache (theme, icon);
   DEBUG_CACHE (("adding %p (%s %d 0x%x) to cache (cache size %d)\n",
                 icon,
                 g_strjoinv (",", icon->key.icon_names),
@@ -754,9 +781,8 @@ icon_cache_add (GtkIconTheme     *theme,
                 g_hash_table_size (theme->icon_cache)));
   G_UNLOCK (icon_cache);
 
-  /* Call potential finalizer outside the lock */
-  if (old_icon)
-    g_object_unref (old_icon);
+  /* Call potential finalizers outside the lock */
+  g_slist_free_full (old_icons, g_object_unref);
 }
 
 static void
@@ -771,24 +797,23 @@ icon_cache_remove (GtkIconPaintable *icon)
 static void
 icon_cache_clear (GtkIconTheme *theme)
 {
-  int i;
-  GtkIconPaintable *old_icons[LRU_CACHE_SIZE];
+  GSList *old_icons = NULL;
 
   G_LOCK (icon_cache);
   g_hash_table_remove_all (theme->icon_cache);
-  for (i = 0; i < LRU_CACHE_SIZE; i ++)
+  while (theme->lru_cache.length > 0)
     {
-      old_icons[i] = theme->lru_cache[i];
-      theme->lru_cache[i] = NULL;
+      GtkIconPaintable *old_icon = g_queue_peek_head (&theme->lru_cache);
+
+      g_queue_unlink (&theme->lru_cache, &old_icon->lru_link);
+      old_icon->lru_link.data = NULL;
+      old_icons = g_slist_prepend (old_icons, old_icon);
     }
+  theme->lru_cache_size = 0;
   G_UNLOCK (icon_cache);
 
   /* Call potential finalizers outside the lock */
-  for (i = 0; i < LRU_CACHE_SIZE; i ++)
-    {
-      if (old_icons[i] != NULL)
-        g_object_unref (old_icons[i]);
-    }
+  g_slist_free_full (old_icons, g_object_unref);
 }
 
 /****************** End of icon cache ***********************/
@@ -2413,18 +2438,78 @@ choose_icon (GtkIconTheme      *self,
   return icon;
 }
 
+/* Preloading uses its own small pool, so that a burst of lookups
+ * doesn't flood the shared GTask pool, and so that the most recently
+ * requested icons, which are the ones likely to be on screen, are
+ * loaded first.
+ */
+#define MAX_ICON_LOAD_THREADS 4
+
+typedef struct
+{
+  GtkIconPaintable *icon;
+  guint serial;
+} IconLoad;
+
+static int
+icon_load_compare (gconstpointer a,
+                   gconstpointer b,
+                   gpointer      user_data)
+{
+  const IconLoad *load_a = a;
+  const IconLoad *load_b = b;
+
+  if (load_a->serial > load_b->serial)
+    return -1;
+  else if (load_a->serial < load_b->serial)
+    return 1;
+  else
+    return 0;
+}
+
 static void
-load_icon_thread (GTask        *task,
-                  gpointer      source_object,
-                  gpointer      task_data,
-                  GCancellable *cancellable)
+load_icon_thread (gpointer data,
+                  gpointer user_data)
 {
-  GtkIconPaintable *self = GTK_ICON_PAINTABLE (source_object);
+  IconLoad *load = data;
+  GtkIconPaintable *self = load->icon;
 
-  g_mutex_lock (&self->texture_lock);
-  icon_ensure_texture__locked (self, TRUE);
-  g_mutex_unlock (&self->texture_lock);
-  g_task_return_pointer (task, NULL, NULL);
+  /* Don't bother if the icon was dropped by everyone else
+   * while we were waiting for our turn.
+   */
+  if (g_atomic_int_get (&G_OBJECT (self)->ref_count) > 1)
+    {
+      g_mutex_lock (&self->texture_lock);
+      icon_ensure_texture__locked (self, TRUE);
+      g_mutex_unlock (&self->texture_lock);
+    }
+
+  g_object_unref (self);
+  g_free (load);
+}
+
+static void
+queue_icon_load (GtkIconPaintable *icon)
+{
+  static GThreadPool *pool = NULL;
+  static guint serial = 0;
+  IconLoad *load;
+
+  if (g_once_init_enter (&pool))
+    {
+      GThreadPool *new_pool;
+
+      new_pool = g_thread_pool_new (load_icon_thread, NULL,
+                                    MAX_ICON_LOAD_THREADS, FALSE, NULL);
+      g_thread_pool_set_sort_function (new_pool, icon_load_compare, NULL);
+      g_once_init_leave (&pool, new_pool);
+    }
+
+  load = g_new (IconLoad, 1);
+  load->icon = g_object_ref (icon);
+  load->serial = g_atomic_int_add (&serial, 1);
+
+  g_thread_pool_push (pool, load, NULL);
 }
 
 /**
@@ -2512,11 +2597,7 @@ gtk_icon_theme_lookup_icon (GtkIconTheme       *self,
           g_mutex_unlock (&icon->texture_lock);
 
           if (!has_texture)
-            {
-              GTask *task = g_task_new (icon, NULL, NULL, NULL);
-              g_task_run_in_thread (task, load_icon_thread);
-              g_object_unref (task);
-            }
+            queue_icon_load (icon);
         }
     }
 
@@ -3764,6 +3845,22 @@ icon_ensure_texture__locked (GtkIconPaintable *icon,
                                                        g_str_has_suffix (icon->filename, ".xpm") ? "xpm" : "png",
                                                        &load_error);
 
+      if (source_pixbuf == NULL)
+        {
+          g_warning ("Failed to load icon %s: %s", icon->filename, load_error->message);
+          g_clear_error (&load_error);
+        }
+    }
+  else if (icon->is_svg && gtk_icon_paintable_is_symbolic (icon))
+    {
+      /* The symbolic loader reads the file itself, so don't open
+       * a stream for it.
+       */
+      source_pixbuf = gtk_make_symbolic_pixbuf_from_path (icon->filename,
+                                                          pixel_size, pixel_size,
+                                                          icon->desired_scale,
+                                                          &load_error);
+
       if (source_pixbuf == NULL)
         {
           g_warning ("Failed to load icon %s: %s", icon->filename, load_error->message);
@@ -3788,19 +3885,11 @@ icon_ensure_texture__locked (GtkIconPaintable *icon,
            * to the desired size
            */
           if (icon->is_svg)
-            {
-              if (gtk_icon_paintable_is_symbolic (icon))
-                source_pixbuf = gtk_make_symbolic_pixbuf_from_path (icon->filename,
-                                                                    pixel_size, pixel_size,
-                                                                    icon->desired_scale,
-                                                                    &load_error);
-              else
-                source_pixbuf = _gdk_pixbuf_new_from_stream_at_scale (stream,
-                                                                      "svg",
-                                                                      pixel_size, pixel_size,
-                                                                      TRUE, NULL,
-                                                                      &load_error);
-            }
+            source_pixbuf = _gdk_pixbuf_new_from_stream_at_scale (stream,
+                                                                  "svg",
+                                                                  pixel_size, pixel_size,
+                                                                  TRUE, NULL,
+                                                                  &load_error);
           else
             source_pixbuf = _gdk_pixbuf_new_from_stream (stream,
                                                          g_str_has_suffix (icon->filename, ".xpm") ? "xpm" : "png",
@@ -3936,6 +4025,11 @@ gtk_icon_paintable_snapshot_with_colors (GtkIconPaintable *icon,
   texture = gtk_icon_paintable_ensure_texture (icon);
   symbolic = gtk_icon_paintable_is_symbolic (icon);
 
+  /* The texture of a symbolic icon does not depend on the colors; it
+   * encodes the foreground, success, warning and error masks in its
+   * channels and is recolored by a color matrix node when rendering.
+   * All color variants of an icon thus share one texture upload.
+   */
   if (symbolic)
     {
       graphene_matrix_t matrix;
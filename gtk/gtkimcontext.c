@@ -22,6 +22,7 @@
 #include "gtktypebuiltins.h"
 #include "gtkmarshalers.h"
 #include "gtkintl.h"
+#include "gdk/gdkprofilerprivate.h"
 
 /**
  * SECTION:gtkimcontext
@@ -514,12 +515,20 @@ gtk_im_context_filter_keypress (GtkIMContext *context,
 				GdkEvent     *key)
 {
   GtkIMContextClass *klass;
+  gboolean handled;
+  gint64 before G_GNUC_UNUSED;
   
   g_return_val_if_fail (GTK_IS_IM_CONTEXT (context), FALSE);
   g_return_val_if_fail (key != NULL, FALSE);
 
+  before = GDK_PROFILER_CURRENT_TIME;
+
   klass = GTK_IM_CONTEXT_GET_CLASS (context);
-  return klass->filter_keypress (context, key);
+  handled = klass->filter_keypress (context, key);
+
+  gdk_profiler_end_mark (before, "im filter keypress", G_OBJECT_TYPE_NAME (context));
+
+  return handled;
 }
 
 /**
@@ -39,6 +39,8 @@
 #include "gtkprivate.h"
 #include "gtkintl.h"
 
+#include "gdk/gdkprofilerprivate.h"
+
 #ifdef GDK_WINDOWING_X11
 #include "x11/gdkx.h"
 #endif
@@ -91,6 +93,8 @@ _gtk_im_module_create (const char *context_id)
   if (strcmp (context_id, NONE_ID) == 0)
     return NULL;
 
+  gtk_im_modules_init ();
+
   ep = g_io_extension_point_lookup (GTK_IM_MODULE_EXTENSION_POINT_NAME);
   ext = g_io_extension_point_get_extension_by_name (ep, context_id);
   if (ext)
@@ -190,6 +194,8 @@ _gtk_im_module_get_default_context_id (GdkDisplay *display)
   GList *l;
   char *tmp;
 
+  gtk_im_modules_init ();
+
   envvar = g_getenv ("GTK_IM_MODULE");
   if (envvar)
     {
@@ -254,9 +260,17 @@ gtk_im_module_ensure_extension_point (void)
 void
 gtk_im_modules_init (void)
 {
+  static gboolean initialized = FALSE;
   GIOModuleScope *scope;
   char **paths;
   int i;
+  gint64 before G_GNUC_UNUSED;
+
+  if (initialized)
+    return;
+
+  initialized = TRUE;
+  before = GDK_PROFILER_CURRENT_TIME;
 
   gtk_im_module_ensure_extension_point ();
 
@@ -287,6 +301,8 @@ gtk_im_modules_init (void)
 
   g_io_module_scope_free (scope);
 
+  gdk_profiler_end_mark (before, "load modules", "immodules");
+
   if (GTK_DEBUG_CHECK (MODULES))
     {
       GIOExtensionPoint *ep;
@@ -0,0 +1,197 @@
+/*
+ * Copyright © 2020 Benjamin Otte
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include "gtkincrementalprivate.h"
+
+/* All incremental list models share one idle handler and one time
+ * budget per main loop iteration, so that a chain of them can't take
+ * longer than that together. The idle runs below the redraw priority,
+ * so frames get drawn in between.
+ *
+ * Models that get their items from a model that still has work queued
+ * wait for that: everything they did would be invalidated by the
+ * items-changed emissions of the model they depend on anyway.
+ */
+
+/* Time we spend in the idle handler before returning to the main loop
+ *
+ * Increasing this number will make the handler take longer and potentially
+ * reduce responsiveness of an application, but will increase the amount of
+ * work done per step. And models emit an ::items-changed() signal after every
+ * step, so if we can avoid that, we reduce the overhead in the list widget
+ * and in turn reduce the total time.
+ */
+#define GTK_INCREMENTAL_TIME_US (1000) /* 1 millisecond */
+
+typedef struct _Work Work;
+
+struct _Work
+{
+  guint id;
+  GListModel *model; /* no reference, the model removes its work */
+  GListModel *source; /* no reference */
+  GtkIncrementalFunc func;
+  gpointer data;
+};
+
+static GQueue work_queue = G_QUEUE_INIT;
+static guint work_idle = 0;
+static guint next_id = 1;
+
+static GList *
+find_work (guint id)
+{
+  GList *l;
+
+  for (l = work_queue.head; l; l = l->next)
+    {
+      Work *work = l->data;
+
+      if (work->id == id)
+        return l;
+    }
+
+  return NULL;
+}
+
+static void
+free_work (GList *l)
+{
+  Work *work = l->data;
+
+  g_queue_delete_link (&work_queue, l);
+  g_slice_free (Work, work);
+}
+
+static gboolean
+is_waiting (Work *work)
+{
+  GList *l;
+
+  if (work->source == NULL)
+    return FALSE;
+
+  for (l = work_queue.head; l; l = l->next)
+    {
+      Work *other = l->data;
+
+      if (other->model == work->source)
+        return TRUE;
+    }
+
+  return FALSE;
+}
+
+static gboolean
+gtk_incremental_run (gpointer unused)
+{
+  gint64 end_time = g_get_monotonic_time () + GTK_INCREMENTAL_TIME_US;
+  GList *l;
+
+  while (g_get_monotonic_time () < end_time)
+    {
+      Work *work = NULL;
+      guint id;
+
+      for (l = work_queue.head; l; l = l->next)
+        {
+          if (!is_waiting (l->data))
+            {
+              work = l->data;
+              break;
+            }
+        }
+
+      if (work == NULL)
+        break;
+
+      /* Move to the end before running, so that the next
+       * iteration starts with somebody else. */
+      g_queue_unlink (&work_queue, l);
+      g_queue_push_tail_link (&work_queue, l);
+
+      /* The function may remove any work, including its own */
+      id = work->id;
+      if (!work->func (work->data, end_time))
+        {
+          l = find_work (id);
+          if (l)
+            free_work (l);
+        }
+    }
+
+  if (work_queue.length == 0)
+    {
+      work_idle = 0;
+      return G_SOURCE_REMOVE;
+    }
+
+  return G_SOURCE_CONTINUE;
+}
+
+/*
+ * gtk_incremental_add:
+ * @model: the model doing the work
+ * @source: (nullable): the model @model gets its items from
+ * @func: the function doing the work
+ * @data: data to pass to @func
+ *
+ * Queues work for @model. @func is called repeatedly from an idle
+ * handler until it returns %FALSE or the work is removed with
+ * gtk_incremental_remove(). Work for @model is not run while
+ * @source has work queued.
+ *
+ * Returns: an id for the work
+ */
+guint
+gtk_incremental_add (GListModel         *model,
+                     GListModel         *source,
+                     GtkIncrementalFunc  func,
+                     gpointer            data)
+{
+  Work *work;
+
+  work = g_slice_new (Work);
+  work->id = next_id++;
+  work->model = model;
+  work->source = source;
+  work->func = func;
+  work->data = data;
+
+  g_queue_push_tail (&work_queue, work);
+
+  if (work_idle == 0)
+    {
+      work_idle = g_idle_add (gtk_incremental_run, NULL);
+      g_source_set_name_by_id (work_idle, "[gtk] gtk_incremental_run");
+    }
+
+  return work->id;
+}
+
+void
+gtk_incremental_remove (guint id)
+{
+  GList *l;
+
+  l = find_work (id);
+  g_return_if_fail (l != NULL);
+
+  free_work (l);
+}
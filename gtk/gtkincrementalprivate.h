@@ -0,0 +1,38 @@
+/*
+ * Copyright © 2020 Benjamin Otte
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GTK_INCREMENTAL_PRIVATE_H__
+#define __GTK_INCREMENTAL_PRIVATE_H__
+
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+/* Does work until @end_time (in monotonic time) has passed.
+ * Returns %TRUE if there is more work to do. */
+typedef gboolean        (* GtkIncrementalFunc)                  (gpointer                data,
+                                                                 gint64                  end_time);
+
+guint                   gtk_incremental_add                     (GListModel             *model,
+                                                                 GListModel             *source,
+                                                                 GtkIncrementalFunc      func,
+                                                                 gpointer                data);
+void                    gtk_incremental_remove                  (guint                   id);
+
+G_END_DECLS
+
+#endif /* __GTK_INCREMENTAL_PRIVATE_H__ */
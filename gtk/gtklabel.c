@@ -288,6 +288,14 @@ struct _GtkLabel
   int      width_chars;
   int      max_width_chars;
   int      lines;
+
+  /* Size of the text laid out without a width, so height-for-width
+   * doesn't need to lay it out again for widths it fits in. Only
+   * valid while unwrapped_serial matches the PangoContext's serial */
+  guint    unwrapped_serial;
+  int      unwrapped_width;
+  int      unwrapped_height;
+  int      unwrapped_baseline;
 };
 
 struct _GtkLabelClass
@@ -2781,6 +2789,7 @@ static void
 gtk_label_clear_layout (GtkLabel *self)
 {
   g_clear_object (&self->layout);
+  self->unwrapped_serial = 0;
 }
 
 /**
@@ -2928,6 +2937,7 @@ gtk_label_update_layout_attributes (GtkLabel      *self,
   attrs = _gtk_pango_attr_list_merge (attrs, self->attrs);
 
   pango_layout_set_attributes (self->layout, attrs);
+  self->unwrapped_serial = 0;
 
   pango_attr_list_unref (attrs);
 }
@@ -2989,6 +2999,36 @@ gtk_label_get_request_mode (GtkWidget *widget)
 }
 
 
+static gboolean
+get_unwrapped_height_for_width (GtkLabel *self,
+                                int       width,
+                                int      *minimum_height,
+                                int      *natural_height,
+                                int      *minimum_baseline,
+                                int      *natural_baseline)
+{
+  PangoContext *context;
+
+  if (self->unwrapped_serial == 0)
+    return FALSE;
+
+  context = gtk_widget_get_pango_context (GTK_WIDGET (self));
+  if (pango_context_get_serial (context) != self->unwrapped_serial)
+    return FALSE;
+
+  /* If the text fits in a single line per paragraph, wrapping
+   * it at @width changes nothing */
+  if (width * PANGO_SCALE < self->unwrapped_width)
+    return FALSE;
+
+  *minimum_height = self->unwrapped_height;
+  *natural_height = self->unwrapped_height;
+  *minimum_baseline = self->unwrapped_baseline;
+  *natural_baseline = self->unwrapped_baseline;
+
+  return TRUE;
+}
+
 static void
 get_height_for_width (GtkLabel *self,
                       int       width,
@@ -3068,6 +3108,12 @@ gtk_label_get_preferred_layout_size (GtkLabel *self,
     char_pixels = 0;
 
   pango_layout_get_extents (layout, NULL, widest);
+
+  self->unwrapped_serial = pango_context_get_serial (pango_layout_get_context (layout));
+  self->unwrapped_width = widest->width;
+  pango_layout_get_pixel_size (layout, NULL, &self->unwrapped_height);
+  self->unwrapped_baseline = pango_layout_get_baseline (layout) / PANGO_SCALE;
+
   widest->width = MAX (widest->width, char_pixels * self->width_chars);
   widest->x = widest->y = 0;
   *widest_baseline = pango_layout_get_baseline (layout) / PANGO_SCALE;
@@ -3185,7 +3231,11 @@ gtk_label_measure (GtkWidget      *widget,
 
   if (orientation == GTK_ORIENTATION_VERTICAL && for_size != -1 && self->wrap)
     {
-      gtk_label_clear_layout (self);
+      if (get_unwrapped_height_for_width (self, for_size, minimum, natural, minimum_baseline, natural_baseline))
+        return;
+
+      /* Only drop the layout, the text it was made from hasn't changed */
+      g_clear_object (&self->layout);
 
       get_height_for_width (self, for_size, minimum, natural, minimum_baseline, natural_baseline);
     }
@@ -23,6 +23,7 @@
 
 #include "gtkadjustment.h"
 #include "gtkbitset.h"
+#include "gtkcssnodeprivate.h"
 #include "gtkdragsource.h"
 #include "gtkdropcontrollermotion.h"
 #include "gtkgesturedrag.h"
@@ -68,6 +69,10 @@ struct _GtkListBasePrivate
   GtkPackType anchor_side_across;
   guint center_widgets;
   guint above_below_widgets;
+  /* widgets created ahead of the anchor in the direction we scroll to */
+  GtkListItemTracker *prefetch;
+  guint prefetch_idle;
+  gboolean prefetch_forward;
   /* the last item that was selected - basically the location to extend selections from */
   GtkListItemTracker *selected;
   /* the item that has input focus */
@@ -169,6 +174,53 @@ gtk_list_base_get_adjustment_values (GtkListBase    *self,
     *page_size = ps;
 }
 
+/* Rows scrolling into view used to be created and styled in the
+ * frame that shows them. So after that frame, from an idle, we create
+ * the rows that come next in the direction we're scrolling and
+ * compute their styles, and the frame that shows them only has to
+ * allocate and snapshot them. */
+static gboolean
+gtk_list_base_prefetch_cb (gpointer data)
+{
+  GtkListBase *self = data;
+  GtkListBasePrivate *priv = gtk_list_base_get_instance_private (self);
+  guint pos, n_widgets;
+  GtkRoot *root;
+
+  priv->prefetch_idle = 0;
+
+  pos = gtk_list_item_tracker_get_position (priv->item_manager, priv->anchor);
+  if (pos == GTK_INVALID_LIST_POSITION)
+    return G_SOURCE_REMOVE;
+
+  n_widgets = priv->center_widgets + 2 * priv->above_below_widgets;
+  if (priv->prefetch_forward)
+    gtk_list_item_tracker_set_position (priv->item_manager, priv->prefetch, pos, 0, n_widgets);
+  else
+    gtk_list_item_tracker_set_position (priv->item_manager, priv->prefetch, pos, n_widgets, 0);
+
+  root = gtk_widget_get_root (GTK_WIDGET (self));
+  if (root)
+    gtk_css_node_validate (gtk_widget_get_css_node (GTK_WIDGET (root)));
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+gtk_list_base_queue_prefetch (GtkListBase *self,
+                              gboolean     forward)
+{
+  GtkListBasePrivate *priv = gtk_list_base_get_instance_private (self);
+
+  priv->prefetch_forward = forward;
+
+  if (priv->prefetch_idle != 0)
+    return;
+
+  priv->prefetch_idle = g_idle_add (gtk_list_base_prefetch_cb, self);
+  g_source_set_name_by_id (priv->prefetch_idle, "[gtk] gtk_list_base_prefetch_cb");
+}
+
 static void
 gtk_list_base_adjustment_value_changed_cb (GtkAdjustment *adjustment,
                                            GtkListBase   *self)
@@ -178,7 +230,7 @@ gtk_list_base_adjustment_value_changed_cb (GtkAdjustment *adjustment,
   int along, across, total_size;
   double align_across, align_along;
   GtkPackType side_across, side_along;
-  guint pos;
+  guint pos, old_pos;
 
   gtk_list_base_get_adjustment_values (self, OPPOSITE_ORIENTATION (priv->orientation), &area.x, &total_size, &area.width);
   if (total_size == area.width)
@@ -238,10 +290,15 @@ gtk_list_base_adjustment_value_changed_cb (GtkAdjustment *adjustment,
   else
     align_along = (double) (cell_area.y + cell_area.height - area.y) / area.height;
 
+  old_pos = gtk_list_item_tracker_get_position (priv->item_manager, priv->anchor);
+
   gtk_list_base_set_anchor (self,
                             pos,
                             align_across, side_across,
                             align_along, side_along);
+
+  if (old_pos != GTK_INVALID_LIST_POSITION && pos != old_pos)
+    gtk_list_base_queue_prefetch (self, pos > old_pos);
   
   gtk_widget_queue_allocate (GTK_WIDGET (self));
 }
@@ -574,11 +631,18 @@ gtk_list_base_dispose (GObject *object)
   gtk_list_base_clear_adjustment (self, GTK_ORIENTATION_HORIZONTAL);
   gtk_list_base_clear_adjustment (self, GTK_ORIENTATION_VERTICAL);
 
+  g_clear_handle_id (&priv->prefetch_idle, g_source_remove);
+
   if (priv->anchor)
     {
       gtk_list_item_tracker_free (priv->item_manager, priv->anchor);
       priv->anchor = NULL;
     }
+  if (priv->prefetch)
+    {
+      gtk_list_item_tracker_free (priv->item_manager, priv->prefetch);
+      priv->prefetch = NULL;
+    }
   if (priv->selected)
     {
       gtk_list_item_tracker_free (priv->item_manager, priv->selected);
@@ -1801,6 +1865,7 @@ gtk_list_base_init_real (GtkListBase      *self,
   priv->anchor = gtk_list_item_tracker_new (priv->item_manager);
   priv->anchor_side_along = GTK_PACK_START;
   priv->anchor_side_across = GTK_PACK_START;
+  priv->prefetch = gtk_list_item_tracker_new (priv->item_manager);
   priv->selected = gtk_list_item_tracker_new (priv->item_manager);
   priv->focus = gtk_list_item_tracker_new (priv->item_manager);
 
@@ -134,6 +134,10 @@ struct _GtkListBox
 
   int n_visible_rows;
 
+  /* Set while applying a bound model change, which updates
+   * the headers of the changed range once at the end. */
+  guint defer_header_updates : 1;
+
   GListModel *bound_model;
   GtkListBoxCreateWidgetFunc create_widget_func;
   gpointer create_widget_func_data;
@@ -2361,7 +2365,7 @@ gtk_list_box_remove (GtkListBox *box,
   row = NULL;
   child = NULL;
 
-  if (gtk_widget_get_visible (widget))
+  if (gtk_widget_get_visible (widget) && !box->defer_header_updates)
     gtk_list_box_update_header (box, next);
 
   if (was_visible && gtk_widget_get_visible (GTK_WIDGET (box)))
@@ -2669,7 +2673,7 @@ gtk_list_box_insert (GtkListBox *box,
     list_box_add_visible_rows (box, 1);
   gtk_list_box_apply_filter (box, row);
   gtk_list_box_update_row_style (box, row);
-  if (gtk_widget_get_visible (GTK_WIDGET (box)))
+  if (gtk_widget_get_visible (GTK_WIDGET (box)) && !box->defer_header_updates)
     {
       gtk_list_box_update_header (box, ROW_PRIV (row)->iter);
       gtk_list_box_update_header (box,
@@ -3550,8 +3554,16 @@ gtk_list_box_bound_model_changed (GListModel *list,
                                   gpointer    user_data)
 {
   GtkListBox *box = user_data;
+  GSequenceIter *iter;
   guint i;
 
+  /* Inserting or removing a row updates the header of the row and of
+   * the row after it, which for a range means running the header func
+   * twice per row, mostly on rows that are about to change again.
+   * Only do it once per row, after the whole range is in place.
+   */
+  box->defer_header_updates = box->sort_func == NULL;
+
   while (removed--)
     {
       GtkListBoxRow *row;
@@ -3584,6 +3596,26 @@ gtk_list_box_bound_model_changed (GListModel *list,
       g_object_unref (widget);
       g_object_unref (item);
     }
+
+  if (!box->defer_header_updates)
+    return;
+
+  box->defer_header_updates = FALSE;
+
+  if (!gtk_widget_get_visible (GTK_WIDGET (box)))
+    return;
+
+  iter = g_sequence_get_iter_at_pos (box->children, position);
+  for (i = 0; i < added; i++)
+    {
+      gtk_list_box_update_header (box, iter);
+      iter = g_sequence_iter_next (iter);
+    }
+
+  if (!g_sequence_iter_is_end (iter) &&
+      !row_is_visible (g_sequence_get (iter)))
+    iter = gtk_list_box_get_next_visible (box, iter);
+  gtk_list_box_update_header (box, iter);
 }
 
 static void
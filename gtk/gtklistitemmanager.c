@@ -24,8 +24,25 @@
 #include "gtklistitemwidgetprivate.h"
 #include "gtkwidgetprivate.h"
 
+#include "gdkprofilerprivate.h"
+
 #define GTK_LIST_VIEW_MAX_LIST_ITEMS 200
 
+/* Widgets that aren't needed anymore are kept unbound in a pool
+ * instead of being destroyed, so that the factory doesn't need to
+ * set up new ones when the view needs more widgets again. A few are
+ * created up front when the view is idle.
+ */
+#define MAX_POOLED_WIDGETS 32
+#define N_WARM_UP_WIDGETS 8
+
+static guint binds_counter;
+static guint creations_counter;
+static guint teardowns_counter;
+static guint n_binds;
+static guint n_creations;
+static guint n_teardowns;
+
 struct _GtkListItemManager
 {
   GObject parent_instance;
@@ -39,6 +56,10 @@ struct _GtkListItemManager
 
   GtkRbTree *items;
   GSList *trackers;
+
+  GQueue pool; /* unbound widgets, children of widget */
+  guint warm_up_idle;
+  guint report_tick;
 };
 
 struct _GtkListItemManagerClass
@@ -109,6 +130,124 @@ gtk_list_item_manager_clear_node (gpointer _item)
   g_assert (item->widget == NULL);
 }
 
+static gboolean
+gtk_list_item_manager_report_stats_cb (GtkWidget     *widget,
+                                       GdkFrameClock *clock,
+                                       gpointer       data)
+{
+  GtkListItemManager *self = data;
+
+  self->report_tick = 0;
+
+  if (GDK_PROFILER_IS_RUNNING && (n_binds || n_creations || n_teardowns))
+    {
+      gdk_profiler_set_int_counter (binds_counter, n_binds);
+      gdk_profiler_set_int_counter (creations_counter, n_creations);
+      gdk_profiler_set_int_counter (teardowns_counter, n_teardowns);
+    }
+
+  n_binds = 0;
+  n_creations = 0;
+  n_teardowns = 0;
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+gtk_list_item_manager_queue_report_stats (GtkListItemManager *self)
+{
+  if (self->report_tick != 0 || !GDK_PROFILER_IS_RUNNING)
+    return;
+
+  self->report_tick = gtk_widget_add_tick_callback (self->widget,
+                                                    gtk_list_item_manager_report_stats_cb,
+                                                    self,
+                                                    NULL);
+}
+
+static void
+gtk_list_item_manager_destroy_list_item (GtkListItemManager *self,
+                                         GtkWidget          *widget)
+{
+  n_teardowns++;
+  gtk_list_item_manager_queue_report_stats (self);
+
+  gtk_widget_unparent (widget);
+}
+
+/* Takes over a widget that isn't used for any position anymore */
+static void
+gtk_list_item_manager_pool_list_item (GtkListItemManager *self,
+                                      GtkWidget          *widget)
+{
+  if (self->pool.length >= MAX_POOLED_WIDGETS)
+    {
+      gtk_list_item_manager_destroy_list_item (self, widget);
+      return;
+    }
+
+  gtk_list_item_widget_update (GTK_LIST_ITEM_WIDGET (widget), GTK_INVALID_LIST_POSITION, NULL, FALSE);
+  gtk_widget_set_child_visible (widget, FALSE);
+  g_queue_push_tail (&self->pool, widget);
+}
+
+static void
+gtk_list_item_manager_clear_pool (GtkListItemManager *self)
+{
+  GtkWidget *widget;
+
+  while ((widget = g_queue_pop_head (&self->pool)))
+    gtk_list_item_manager_destroy_list_item (self, widget);
+}
+
+static GtkWidget *
+gtk_list_item_manager_create_list_item (GtkListItemManager *self)
+{
+  GtkWidget *result;
+
+  n_creations++;
+  gtk_list_item_manager_queue_report_stats (self);
+
+  result = gtk_list_item_widget_new (self->factory,
+                                     self->item_css_name,
+                                     self->item_role);
+
+  gtk_list_item_widget_set_single_click_activate (GTK_LIST_ITEM_WIDGET (result), self->single_click_activate);
+
+  return result;
+}
+
+static gboolean
+gtk_list_item_manager_warm_up_cb (gpointer data)
+{
+  GtkListItemManager *self = data;
+  GtkWidget *widget;
+
+  if (self->factory == NULL || self->pool.length >= N_WARM_UP_WIDGETS)
+    {
+      self->warm_up_idle = 0;
+      return G_SOURCE_REMOVE;
+    }
+
+  /* one per iteration to not block the main loop for long */
+  widget = gtk_list_item_manager_create_list_item (self);
+  gtk_widget_set_child_visible (widget, FALSE);
+  gtk_widget_insert_before (widget, self->widget, NULL);
+  g_queue_push_tail (&self->pool, widget);
+
+  return G_SOURCE_CONTINUE;
+}
+
+static void
+gtk_list_item_manager_queue_warm_up (GtkListItemManager *self)
+{
+  if (self->warm_up_idle != 0)
+    return;
+
+  self->warm_up_idle = g_idle_add_full (G_PRIORITY_LOW, gtk_list_item_manager_warm_up_cb, self, NULL);
+  g_source_set_name_by_id (self->warm_up_idle, "[gtk] gtk_list_item_manager_warm_up_cb");
+}
+
 GtkListItemManager *
 gtk_list_item_manager_new_for_size (GtkWidget            *widget,
                                     const char           *item_css_name,
@@ -569,7 +708,7 @@ gtk_list_item_manager_ensure_items (GtkListItemManager *self,
     }
 
   while ((widget = g_queue_pop_head (&released)))
-    gtk_list_item_manager_release_list_item (self, NULL, widget);
+    gtk_list_item_manager_pool_list_item (self, widget);
 }
 
 static void
@@ -580,6 +719,8 @@ gtk_list_item_manager_model_items_changed_cb (GListModel         *model,
                                               GtkListItemManager *self)
 {
   GHashTable *change;
+  GHashTableIter iter;
+  gpointer widget;
   GSList *l;
   guint n_items;
 
@@ -728,6 +869,13 @@ gtk_list_item_manager_model_items_changed_cb (GListModel         *model,
       tracker->widget = GTK_LIST_ITEM_WIDGET (item->widget);
     }
 
+  /* Keep the widgets of items that are gone for later */
+  g_hash_table_iter_init (&iter, change);
+  while (g_hash_table_iter_next (&iter, NULL, &widget))
+    {
+      g_hash_table_iter_steal (&iter);
+      gtk_list_item_manager_pool_list_item (self, widget);
+    }
   g_hash_table_unref (change);
 
   gtk_widget_queue_resize (self->widget);
@@ -793,6 +941,13 @@ gtk_list_item_manager_dispose (GObject *object)
   GtkListItemManager *self = GTK_LIST_ITEM_MANAGER (object);
 
   gtk_list_item_manager_clear_model (self);
+  gtk_list_item_manager_clear_pool (self);
+  g_clear_handle_id (&self->warm_up_idle, g_source_remove);
+  if (self->report_tick)
+    {
+      gtk_widget_remove_tick_callback (self->widget, self->report_tick);
+      self->report_tick = 0;
+    }
 
   g_clear_object (&self->factory);
 
@@ -807,6 +962,10 @@ gtk_list_item_manager_class_init (GtkListItemManagerClass *klass)
   GObjectClass *object_class = G_OBJECT_CLASS (klass);
 
   object_class->dispose = gtk_list_item_manager_dispose;
+
+  binds_counter = gdk_profiler_define_int_counter ("list-item-binds", "List items bound to a new position");
+  creations_counter = gdk_profiler_define_int_counter ("list-item-creations", "List item widgets created");
+  teardowns_counter = gdk_profiler_define_int_counter ("list-item-teardowns", "List item widgets destroyed");
 }
 
 static void
@@ -829,8 +988,11 @@ gtk_list_item_manager_set_factory (GtkListItemManager *self,
 
   n_items = self->model ? g_list_model_get_n_items (G_LIST_MODEL (self->model)) : 0;
   gtk_list_item_manager_remove_items (self, NULL, 0, n_items);
+  /* pooled widgets were set up by the old factory */
+  gtk_list_item_manager_clear_pool (self);
 
   g_set_object (&self->factory, factory);
+  gtk_list_item_manager_queue_warm_up (self);
 
   gtk_list_item_manager_add_items (self, 0, n_items);
 
@@ -925,12 +1087,17 @@ gtk_list_item_manager_acquire_list_item (GtkListItemManager *self,
   g_return_val_if_fail (GTK_IS_LIST_ITEM_MANAGER (self), NULL);
   g_return_val_if_fail (prev_sibling == NULL || GTK_IS_WIDGET (prev_sibling), NULL);
 
-  result = gtk_list_item_widget_new (self->factory,
-                                     self->item_css_name,
-                                     self->item_role);
+  result = g_queue_pop_head (&self->pool);
+  if (result)
+    {
+      gtk_widget_set_child_visible (result, TRUE);
+      gtk_list_item_manager_move_list_item (self, result, position, prev_sibling);
+      return result;
+    }
 
-  gtk_list_item_widget_set_single_click_activate (GTK_LIST_ITEM_WIDGET (result), self->single_click_activate);
+  result = gtk_list_item_manager_create_list_item (self);
 
+  n_binds++;
   item = g_list_model_get_item (G_LIST_MODEL (self->model), position);
   selected = gtk_selection_model_is_selected (self->model, position);
   gtk_list_item_widget_update (GTK_LIST_ITEM_WIDGET (result), position, item, selected);
@@ -1011,6 +1178,9 @@ gtk_list_item_manager_move_list_item (GtkListItemManager     *self,
   gpointer item;
   gboolean selected;
 
+  n_binds++;
+  gtk_list_item_manager_queue_report_stats (self);
+
   item = g_list_model_get_item (G_LIST_MODEL (self->model), position);
   selected = gtk_selection_model_is_selected (self->model, position);
   gtk_list_item_widget_update (GTK_LIST_ITEM_WIDGET (list_item),
@@ -1077,7 +1247,7 @@ gtk_list_item_manager_release_list_item (GtkListItemManager *self,
       return;
     }
 
-  gtk_widget_unparent (item);
+  gtk_list_item_manager_destroy_list_item (self, item);
 }
 
 void
@@ -1085,11 +1255,15 @@ gtk_list_item_manager_set_single_click_activate (GtkListItemManager *self,
                                                  gboolean            single_click_activate)
 {
   GtkListItemManagerItem *item;
+  GList *l;
 
   g_return_if_fail (GTK_IS_LIST_ITEM_MANAGER (self));
 
   self->single_click_activate = single_click_activate;
 
+  for (l = self->pool.head; l; l = l->next)
+    gtk_list_item_widget_set_single_click_activate (l->data, single_click_activate);
+
   for (item = gtk_rb_tree_get_first (self->items);
        item != NULL;
        item = gtk_rb_tree_node_get_next (item))
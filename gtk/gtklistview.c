@@ -471,6 +471,45 @@ gtk_list_view_get_unknown_row_height (GtkListView *self,
   return g_array_index (heights, int, heights->len / 2);
 }
 
+/* Only keep this many measurements around, so that the estimate
+ * follows the rows that were seen most recently. */
+#define MAX_MEASURED_HEIGHTS 1024
+
+static void
+gtk_list_view_add_measured_height (GtkListView *self,
+                                   guint        height)
+{
+  if (self->n_measured_heights >= MAX_MEASURED_HEIGHTS)
+    {
+      self->measured_height_sum /= 2;
+      self->n_measured_heights /= 2;
+    }
+
+  self->measured_height_sum += height;
+  self->n_measured_heights++;
+}
+
+static void
+gtk_list_view_clear_measured_heights (GtkListView *self)
+{
+  self->measured_height_sum = 0;
+  self->n_measured_heights = 0;
+}
+
+/* Unlike the median of the rows that currently have a widget, the mean
+ * over all rows measured so far doesn't change much when scrolling into
+ * a region with different row heights. That keeps the estimated height
+ * of the rest of the list, and with it the scrollbar, stable. */
+static guint
+gtk_list_view_get_estimated_row_height (GtkListView *self,
+                                        GArray      *heights)
+{
+  if (self->n_measured_heights == 0)
+    return gtk_list_view_get_unknown_row_height (self, heights);
+
+  return (self->measured_height_sum + self->n_measured_heights / 2) / self->n_measured_heights;
+}
+
 static void
 gtk_list_view_measure_across (GtkWidget      *widget,
                               GtkOrientation  orientation,
@@ -584,7 +623,7 @@ gtk_list_view_size_allocate (GtkWidget *widget,
   GtkListView *self = GTK_LIST_VIEW (widget);
   ListRow *row;
   GArray *heights;
-  int min, nat, row_height;
+  int min, nat, row_height, list_width;
   int x, y;
   GtkOrientation orientation, opposite_orientation;
   GtkScrollablePolicy scroll_policy;
@@ -601,11 +640,17 @@ gtk_list_view_size_allocate (GtkWidget *widget,
   gtk_widget_measure (widget, opposite_orientation,
                       -1,
                       &min, &nat, NULL, NULL);
-  self->list_width = orientation == GTK_ORIENTATION_VERTICAL ? width : height;
+  list_width = orientation == GTK_ORIENTATION_VERTICAL ? width : height;
   if (scroll_policy == GTK_SCROLL_MINIMUM)
-    self->list_width = MAX (min, self->list_width);
+    list_width = MAX (min, list_width);
   else
-    self->list_width = MAX (nat, self->list_width);
+    list_width = MAX (nat, list_width);
+  /* rows measured for a different width don't tell us anything anymore */
+  if (list_width != self->list_width)
+    {
+      gtk_list_view_clear_measured_heights (self);
+      self->list_width = list_width;
+    }
 
   /* step 2: determine height of known list items */
   heights = g_array_new (FALSE, FALSE, sizeof (int));
@@ -628,12 +673,13 @@ gtk_list_view_size_allocate (GtkWidget *widget,
         {
           row->height = row_height;
           gtk_rb_tree_node_mark_dirty (row);
+          gtk_list_view_add_measured_height (self, row_height);
         }
       g_array_append_val (heights, row_height);
     }
 
   /* step 3: determine height of unknown items */
-  row_height = gtk_list_view_get_unknown_row_height (self, heights);
+  row_height = gtk_list_view_get_estimated_row_height (self, heights);
   g_array_free (heights, TRUE);
 
   for (row = gtk_list_item_manager_get_first (self->item_manager);
@@ -1034,6 +1080,7 @@ gtk_list_view_set_factory (GtkListView        *self,
     return;
 
   gtk_list_item_manager_set_factory (self->item_manager, factory);
+  gtk_list_view_clear_measured_heights (self);
 
   g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_FACTORY]);
 }
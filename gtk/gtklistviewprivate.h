@@ -33,6 +33,11 @@ struct _GtkListView
   gboolean show_separators;
 
   int list_width;
+
+  /* running statistics of measured row heights, used to
+   * estimate the height of rows without a widget */
+  guint64 measured_height_sum;
+  guint n_measured_heights;
 };
 
 struct _GtkListViewClass
@@ -93,6 +93,7 @@
 
 #include "gdk/gdk.h"
 #include "gdk/gdk-private.h"
+#include "gdk/gdkprofilerprivate.h"
 #include "gsk/gskprivate.h"
 #include "gsk/gskrendernodeprivate.h"
 #include "gtknative.h"
@@ -147,6 +148,7 @@ static GtkWindowGroup *gtk_main_get_window_group (GtkWidget   *widget);
 
 static int pre_initialized = FALSE;
 static int gtk_initialized = FALSE;
+static gint64 init_time;
 static GList *current_events = NULL;
 
 typedef struct {
@@ -605,11 +607,9 @@ do_post_parse_initialization (void)
 
   gtk_initialized = TRUE;
 
-#ifdef G_OS_UNIX
-  gtk_print_backends_init ();
-#endif
-  gtk_im_modules_init ();
-  gtk_media_file_extension_init ();
+  /* Print backends, input methods and media backends are loaded
+   * when they are first used, to keep them out of startup.
+   */
 
   display_manager = gdk_display_manager_get ();
   if (gdk_display_manager_get_default_display (display_manager) != NULL)
@@ -620,6 +620,15 @@ do_post_parse_initialization (void)
                     NULL);
 }
 
+/* Returns the profiler time at which gtk_init() started, so that
+ * startup marks can be measured against it.
+ */
+gint64
+gtk_get_init_time (void)
+{
+  return init_time;
+}
+
 #ifdef G_PLATFORM_WIN32
 #undef gtk_init_check
 #endif
@@ -646,6 +655,8 @@ gtk_init_check (void)
   if (gtk_initialized)
     return TRUE;
 
+  init_time = GDK_PROFILER_CURRENT_TIME;
+
   gettext_initialization ();
 
   if (!check_setugid ())
@@ -656,6 +667,8 @@ gtk_init_check (void)
 
   ret = gdk_display_open_default () != NULL;
 
+  gdk_profiler_end_mark (init_time, "gtk init", NULL);
+
   if (ret && (gtk_get_debug_flags () & GTK_DEBUG_INTERACTIVE))
     gtk_window_set_interactive_debugging (TRUE);
 
@@ -1579,6 +1592,9 @@ gtk_main_do_event (GdkEvent *event)
   GtkWindowGroup *window_group;
   GdkEvent *rewritten_event = NULL;
   GList *tmp_list;
+  gint64 before G_GNUC_UNUSED;
+
+  before = GDK_PROFILER_CURRENT_TIME;
 
   if (gtk_inspector_handle_event (event))
     return;
@@ -1726,6 +1742,9 @@ gtk_main_do_event (GdkEvent *event)
 
   _gtk_tooltip_handle_event (target_widget, event);
 
+  gdk_profiler_end_markf (before, "event dispatch", "%s %p",
+                          G_OBJECT_TYPE_NAME (grab_widget), grab_widget);
+
   g_object_unref (target_widget);
 
  cleanup:
@@ -57,11 +57,14 @@
  * ]|
  *
  * #GtkMapListModel will attempt to discard the mapped objects as soon as
- * they are no longer needed and recreate them if necessary.
+ * they are no longer needed and recreate them if necessary. If creating
+ * them is expensive, #GtkMapListModel:cache-size can be used to keep
+ * the most recently used ones around.
  */
 
 enum {
   PROP_0,
+  PROP_CACHE_SIZE,
   PROP_HAS_MAP,
   PROP_MODEL,
   NUM_PROPERTIES
@@ -91,6 +94,10 @@ struct _GtkMapListModel
   GDestroyNotify user_destroy;
 
   GtkRbTree *items; /* NULL if map_func == NULL */
+
+  guint cache_size;
+  GQueue cache; /* mapped items, most recently used first */
+  GHashTable *cache_links; /* item => link in cache */
 };
 
 struct _GtkMapListModelClass
@@ -140,6 +147,41 @@ gtk_map_list_model_get_nth (GtkRbTree *tree,
   return node;
 }
 
+static void
+gtk_map_list_model_trim_cache (GtkMapListModel *self,
+                               guint            size)
+{
+  while (self->cache.length > size)
+    {
+      gpointer item = g_queue_pop_tail (&self->cache);
+
+      g_hash_table_remove (self->cache_links, item);
+      g_object_unref (item);
+    }
+}
+
+static void
+gtk_map_list_model_cache_item (GtkMapListModel *self,
+                               gpointer         item)
+{
+  GList *link;
+
+  if (self->cache_size == 0)
+    return;
+
+  link = g_hash_table_lookup (self->cache_links, item);
+  if (link)
+    {
+      g_queue_unlink (&self->cache, link);
+      g_queue_push_head_link (&self->cache, link);
+      return;
+    }
+
+  g_queue_push_head (&self->cache, g_object_ref (item));
+  g_hash_table_insert (self->cache_links, item, self->cache.head);
+  gtk_map_list_model_trim_cache (self, self->cache_size);
+}
+
 static GType
 gtk_map_list_model_get_item_type (GListModel *list)
 {
@@ -176,7 +218,10 @@ gtk_map_list_model_get_item (GListModel *list,
     return NULL;
 
   if (node->item)
-    return g_object_ref (node->item);
+    {
+      gtk_map_list_model_cache_item (self, node->item);
+      return g_object_ref (node->item);
+    }
 
   if (offset != position)
     {
@@ -196,6 +241,7 @@ gtk_map_list_model_get_item (GListModel *list,
 
   node->item = self->map_func (g_list_model_get_item (self->model, position), self->user_data);
   g_object_add_weak_pointer (node->item, &node->item);
+  gtk_map_list_model_cache_item (self, node->item);
 
   return node->item;
 }
@@ -284,6 +330,10 @@ gtk_map_list_model_set_property (GObject      *object,
 
   switch (prop_id)
     {
+    case PROP_CACHE_SIZE:
+      gtk_map_list_model_set_cache_size (self, g_value_get_uint (value));
+      break;
+
     case PROP_MODEL:
       gtk_map_list_model_set_model (self, g_value_get_object (value));
       break;
@@ -304,6 +354,10 @@ gtk_map_list_model_get_property (GObject     *object,
 
   switch (prop_id)
     {
+    case PROP_CACHE_SIZE:
+      g_value_set_uint (value, self->cache_size);
+      break;
+
     case PROP_HAS_MAP:
       g_value_set_boolean (value, self->items != NULL);
       break;
@@ -339,11 +393,22 @@ gtk_map_list_model_dispose (GObject *object)
   self->map_func = NULL;
   self->user_data = NULL;
   self->user_destroy = NULL;
+  gtk_map_list_model_trim_cache (self, 0);
   g_clear_pointer (&self->items, gtk_rb_tree_unref);
 
   G_OBJECT_CLASS (gtk_map_list_model_parent_class)->dispose (object);
 }
 
+static void
+gtk_map_list_model_finalize (GObject *object)
+{
+  GtkMapListModel *self = GTK_MAP_LIST_MODEL (object);
+
+  g_hash_table_unref (self->cache_links);
+
+  G_OBJECT_CLASS (gtk_map_list_model_parent_class)->finalize (object);
+}
+
 static void
 gtk_map_list_model_class_init (GtkMapListModelClass *class)
 {
@@ -352,6 +417,19 @@ gtk_map_list_model_class_init (GtkMapListModelClass *class)
   gobject_class->set_property = gtk_map_list_model_set_property;
   gobject_class->get_property = gtk_map_list_model_get_property;
   gobject_class->dispose = gtk_map_list_model_dispose;
+  gobject_class->finalize = gtk_map_list_model_finalize;
+
+  /**
+   * GtkMapListModel:cache-size:
+   *
+   * The number of mapped items to keep around after they were last used
+   */
+  properties[PROP_CACHE_SIZE] =
+      g_param_spec_uint ("cache-size",
+                         P_("Cache size"),
+                         P_("The number of mapped items to keep around after they were last used"),
+                         0, G_MAXUINT, 0,
+                         GTK_PARAM_READWRITE | G_PARAM_EXPLICIT_NOTIFY);
 
   /**
    * GtkMapListModel:has-map:
@@ -383,6 +461,7 @@ gtk_map_list_model_class_init (GtkMapListModelClass *class)
 static void
 gtk_map_list_model_init (GtkMapListModel *self)
 {
+  self->cache_links = g_hash_table_new (NULL, NULL);
 }
 
 
@@ -456,6 +535,8 @@ gtk_map_list_model_clear_node (gpointer _node)
 static void
 gtk_map_list_model_init_items (GtkMapListModel *self)
 {
+  gtk_map_list_model_trim_cache (self, 0);
+
   if (self->map_func && self->model)
     {
       guint n_items;
@@ -619,3 +700,48 @@ gtk_map_list_model_has_map (GtkMapListModel *self)
 
   return self->map_func != NULL;
 }
+
+/**
+ * gtk_map_list_model_set_cache_size:
+ * @self: a #GtkMapListModel
+ * @cache_size: the number of mapped items to keep
+ *
+ * Sets the number of mapped items that @self keeps a reference to
+ * after they were last retrieved, so that they don't need to be mapped
+ * again if they are needed again soon. This is useful when the map
+ * function is expensive, for example when scrolling back and forth
+ * in a list.
+ *
+ * The default is 0, which means that mapped items are discarded as
+ * soon as nobody else uses them.
+ **/
+void
+gtk_map_list_model_set_cache_size (GtkMapListModel *self,
+                                   guint            cache_size)
+{
+  g_return_if_fail (GTK_IS_MAP_LIST_MODEL (self));
+
+  if (self->cache_size == cache_size)
+    return;
+
+  self->cache_size = cache_size;
+  gtk_map_list_model_trim_cache (self, cache_size);
+
+  g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_CACHE_SIZE]);
+}
+
+/**
+ * gtk_map_list_model_get_cache_size:
+ * @self: a #GtkMapListModel
+ *
+ * Gets the value set via gtk_map_list_model_set_cache_size().
+ *
+ * Returns: the number of mapped items kept around
+ **/
+guint
+gtk_map_list_model_get_cache_size (GtkMapListModel *self)
+{
+  g_return_val_if_fail (GTK_IS_MAP_LIST_MODEL (self), 0);
+
+  return self->cache_size;
+}
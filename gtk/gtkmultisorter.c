@@ -49,139 +49,22 @@ struct _GtkMultiSorter
   GtkSorters sorters;
 };
 
-typedef struct _GtkMultiSortKey GtkMultiSortKey;
-typedef struct _GtkMultiSortKeys GtkMultiSortKeys;
-
-struct _GtkMultiSortKey
-{
-  gsize offset;
-  GtkSortKeys *keys;
-};
-
-struct _GtkMultiSortKeys
-{
-  GtkSortKeys parent_keys;
-
-  guint n_keys;
-  GtkMultiSortKey keys[];
-};
-
-static void
-gtk_multi_sort_keys_free (GtkSortKeys *keys)
-{
-  GtkMultiSortKeys *self = (GtkMultiSortKeys *) keys;
-  gsize i;
-
-  for (i = 0; i < self->n_keys; i++)
-    gtk_sort_keys_unref (self->keys[i].keys);
-
-  g_slice_free1 (sizeof (GtkMultiSortKeys) + self->n_keys * sizeof (GtkMultiSortKey), self);
-}
-
-static int
-gtk_multi_sort_keys_compare (gconstpointer a,
-                             gconstpointer b,
-                             gpointer      data)
-{
-  GtkMultiSortKeys *self = (GtkMultiSortKeys *) data;
-  gsize i;
-
-  for (i = 0; i < self->n_keys; i++)
-    {
-      GtkOrdering result = gtk_sort_keys_compare (self->keys[i].keys,
-                                                  ((const char *) a) + self->keys[i].offset,
-                                                  ((const char *) b) + self->keys[i].offset);
-      if (result != GTK_ORDERING_EQUAL)
-        return result;
-    }
-
-  return GTK_ORDERING_EQUAL;
-}
-
-static gboolean
-gtk_multi_sort_keys_is_compatible (GtkSortKeys *keys,
-                                   GtkSortKeys *other)
-{
-  GtkMultiSortKeys *self = (GtkMultiSortKeys *) keys;
-  GtkMultiSortKeys *compare = (GtkMultiSortKeys *) other;
-  gsize i;
-
-  if (keys->klass != other->klass)
-    return FALSE;
-
-  if (self->n_keys != compare->n_keys)
-    return FALSE;
-
-  for (i = 0; i < self->n_keys; i++)
-    {
-      if (!gtk_sort_keys_is_compatible (self->keys[i].keys, compare->keys[i].keys))
-        return FALSE;
-    }
-
-  return TRUE;
-}
-
-static void
-gtk_multi_sort_keys_init_key (GtkSortKeys *keys,
-                              gpointer     item,
-                              gpointer     key_memory)
-{
-  GtkMultiSortKeys *self = (GtkMultiSortKeys *) keys;
-  char *key = (char *) key_memory;
-  gsize i;
-
-  for (i = 0; i < self->n_keys; i++)
-    gtk_sort_keys_init_key (self->keys[i].keys, item, key + self->keys[i].offset);
-}
-
-static void
-gtk_multi_sort_keys_clear_key (GtkSortKeys *keys,
-                               gpointer     key_memory)
-{
-  GtkMultiSortKeys *self = (GtkMultiSortKeys *) keys;
-  char *key = (char *) key_memory;
-  gsize i;
-
-  for (i = 0; i < self->n_keys; i++)
-    gtk_sort_keys_clear_key (self->keys[i].keys, key + self->keys[i].offset);
-}
-
-static const GtkSortKeysClass GTK_MULTI_SORT_KEYS_CLASS =
-{
-  gtk_multi_sort_keys_free,
-  gtk_multi_sort_keys_compare,
-  gtk_multi_sort_keys_is_compatible,
-  gtk_multi_sort_keys_init_key,
-  gtk_multi_sort_keys_clear_key,
-};
-
 static GtkSortKeys *
 gtk_multi_sort_keys_new (GtkMultiSorter *self)
 {
-  GtkMultiSortKeys *result;
-  GtkSortKeys *keys;
-  gsize i;
-
-  if (gtk_sorters_get_size (&self->sorters) == 0)
-    return gtk_sort_keys_new_equal ();
-  else if (gtk_sorters_get_size (&self->sorters) == 1)
-    return gtk_sorter_get_keys (gtk_sorters_get (&self->sorters, 0));
-
-  keys = gtk_sort_keys_alloc (&GTK_MULTI_SORT_KEYS_CLASS,
-                              sizeof (GtkMultiSortKeys) + gtk_sorters_get_size (&self->sorters) * sizeof (GtkMultiSortKey),
-                              0, 1);
-  result = (GtkMultiSortKeys *) keys;
-
-  result->n_keys = gtk_sorters_get_size (&self->sorters);
-  for (i = 0; i < result->n_keys; i++)
-    {
-      result->keys[i].keys = gtk_sorter_get_keys (gtk_sorters_get (&self->sorters, i));
-      result->keys[i].offset = GTK_SORT_KEYS_ALIGN (keys->key_size, gtk_sort_keys_get_key_align (result->keys[i].keys));
-      keys->key_size = result->keys[i].offset + gtk_sort_keys_get_key_size (result->keys[i].keys);
-      keys->key_align = MAX (keys->key_align, gtk_sort_keys_get_key_align (result->keys[i].keys));
-    }
+  GtkSortKeys **keys;
+  GtkSortKeys *result;
+  gsize i, n_keys;
 
-  return keys;
+  n_keys = gtk_sorters_get_size (&self->sorters);
+  keys = g_new (GtkSortKeys *, n_keys);
+  for (i = 0; i < n_keys; i++)
+    keys[i] = gtk_sorter_get_keys (gtk_sorters_get (&self->sorters, i));
+
+  result = gtk_sort_keys_new_composite (keys, NULL, n_keys);
+  g_free (keys);
+
+  return result;
 }
 
 static GType
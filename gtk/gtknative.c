@@ -22,6 +22,7 @@
 #include "gtknativeprivate.h"
 #include "gtkwidgetprivate.h"
 #include "gdk/gdk-private.h"
+#include "gdk/gdkprofilerprivate.h"
 #include "gtkprivate.h"
 #include "gtkintl.h"
 #include "gtkcssnodeprivate.h"
@@ -102,8 +103,16 @@ surface_layout_cb (GdkSurface *surface,
                    int         height,
                    GtkNative  *native)
 {
+  gint64 before G_GNUC_UNUSED;
+
+  before = GDK_PROFILER_CURRENT_TIME;
+
   gtk_native_layout (native, width, height);
 
+  gdk_profiler_end_markf (before, "native layout", "%s %p",
+                          G_OBJECT_TYPE_NAME (native), native);
+  gtk_widget_report_measure_counters ();
+
   if (gtk_widget_needs_allocate (GTK_WIDGET (native)))
     gtk_native_queue_relayout (native);
 }
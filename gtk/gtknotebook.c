@@ -328,6 +328,7 @@ enum {
   PROP_ENABLE_POPUP,
   PROP_GROUP_NAME,
   PROP_PAGES,
+  PROP_HOMOGENEOUS,
   LAST_PROP
 };
 
@@ -1115,6 +1116,23 @@ gtk_notebook_class_init (GtkNotebookClass *class)
                            G_TYPE_LIST_MODEL,
                            GTK_PARAM_READABLE);
 
+  /**
+   * GtkNotebook:homogeneous:
+   *
+   * Whether all pages are given the size of the largest page.
+   *
+   * When this is %FALSE, only the current page is measured, which
+   * avoids measuring the content of every page on each resize, but
+   * the notebook changes size when switching to a page of a
+   * different size.
+   */
+  properties[PROP_HOMOGENEOUS] =
+      g_param_spec_boolean ("homogeneous",
+                            P_("Homogeneous"),
+                            P_("Whether all pages get the size of the largest page"),
+                            TRUE,
+                            GTK_PARAM_READWRITE|G_PARAM_EXPLICIT_NOTIFY);
+
   g_object_class_install_properties (gobject_class, LAST_PROP, properties);
 
   /**
@@ -1835,6 +1853,9 @@ gtk_notebook_set_property (GObject         *object,
     case PROP_GROUP_NAME:
       gtk_notebook_set_group_name (notebook, g_value_get_string (value));
       break;
+    case PROP_HOMOGENEOUS:
+      gtk_notebook_set_homogeneous (notebook, g_value_get_boolean (value));
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -1875,6 +1896,9 @@ gtk_notebook_get_property (GObject         *object,
     case PROP_PAGES:
       g_value_set_object (value, gtk_notebook_get_pages (notebook));
       break;
+    case PROP_HOMOGENEOUS:
+      g_value_set_boolean (value, gtk_notebook_get_homogeneous (notebook));
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -6306,6 +6330,51 @@ gtk_notebook_get_scrollable (GtkNotebook *notebook)
   return notebook->scrollable;
 }
 
+/**
+ * gtk_notebook_set_homogeneous:
+ * @notebook: a #GtkNotebook
+ * @homogeneous: %TRUE to give all pages the size of the largest page
+ *
+ * Sets whether all pages of @notebook are given the size of the
+ * largest page.
+ *
+ * A non-homogeneous notebook only measures its current page, so it
+ * is cheaper to resize when it has many large pages.
+ */
+void
+gtk_notebook_set_homogeneous (GtkNotebook *notebook,
+                              gboolean     homogeneous)
+{
+  g_return_if_fail (GTK_IS_NOTEBOOK (notebook));
+
+  homogeneous = (homogeneous != FALSE);
+
+  if (gtk_notebook_get_homogeneous (notebook) == homogeneous)
+    return;
+
+  gtk_stack_set_hhomogeneous (GTK_STACK (notebook->stack_widget), homogeneous);
+  gtk_stack_set_vhomogeneous (GTK_STACK (notebook->stack_widget), homogeneous);
+
+  g_object_notify_by_pspec (G_OBJECT (notebook), properties[PROP_HOMOGENEOUS]);
+}
+
+/**
+ * gtk_notebook_get_homogeneous:
+ * @notebook: a #GtkNotebook
+ *
+ * Returns whether all pages of @notebook are given the size
+ * of the largest page. See gtk_notebook_set_homogeneous().
+ *
+ * Returns: %TRUE if @notebook is homogeneous
+ */
+gboolean
+gtk_notebook_get_homogeneous (GtkNotebook *notebook)
+{
+  g_return_val_if_fail (GTK_IS_NOTEBOOK (notebook), TRUE);
+
+  return gtk_stack_get_hhomogeneous (GTK_STACK (notebook->stack_widget));
+}
+
 
 /* Public GtkNotebook Popup Menu Methods:
  *
@@ -167,6 +167,11 @@ void     gtk_notebook_set_scrollable       (GtkNotebook     *notebook,
 					    gboolean         scrollable);
 GDK_AVAILABLE_IN_ALL
 gboolean gtk_notebook_get_scrollable       (GtkNotebook     *notebook);
+GDK_AVAILABLE_IN_ALL
+void     gtk_notebook_set_homogeneous      (GtkNotebook     *notebook,
+                                            gboolean         homogeneous);
+GDK_AVAILABLE_IN_ALL
+gboolean gtk_notebook_get_homogeneous      (GtkNotebook     *notebook);
 
 /***********************************************************
  *               enable/disable PopupMenu                  *
@@ -21,6 +21,7 @@
 
 #include "gtknumericsorter.h"
 
+#include "gtkexpressionprivate.h"
 #include "gtkintl.h"
 #include "gtksorterprivate.h"
 #include "gtktypebuiltins.h"
@@ -329,6 +330,7 @@ gtk_numeric_sort_keys_new (GtkNumericSorter *self)
     }
 
   result->expression = gtk_expression_ref (self->expression);
+  result->keys.thread_safe = gtk_expression_is_thread_safe (self->expression);
 
   return (GtkSortKeys *) result;
 }
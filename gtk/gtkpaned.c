@@ -145,6 +145,8 @@ struct _GtkPaned
   int           max_position;
   int           min_position;
   int           original_position;
+  int           a11y_value_max;
+  int           a11y_value_now;
 
   guint         in_recursion  : 1;
   guint         resize_start_child : 1;
@@ -1243,6 +1245,27 @@ flip_child (int            width,
   child_pos->x = width - child_pos->x - child_pos->width;
 }
 
+/* Only push the value to the AT context when it changes; most
+ * allocations of a paned don't move the handle.
+ */
+static void
+gtk_paned_update_accessible_value (GtkPaned *paned,
+                                   int       max)
+{
+  if (paned->a11y_value_max == max &&
+      paned->a11y_value_now == paned->start_child_size)
+    return;
+
+  paned->a11y_value_max = max;
+  paned->a11y_value_now = paned->start_child_size;
+
+  gtk_accessible_update_property (GTK_ACCESSIBLE (paned),
+                                  GTK_ACCESSIBLE_PROPERTY_VALUE_MIN, 0.0,
+                                  GTK_ACCESSIBLE_PROPERTY_VALUE_MAX, (double) max,
+                                  GTK_ACCESSIBLE_PROPERTY_VALUE_NOW, (double) paned->start_child_size,
+                                  -1);
+}
+
 static void
 gtk_paned_size_allocate (GtkWidget *widget,
                          int        width,
@@ -1385,13 +1408,8 @@ gtk_paned_size_allocate (GtkWidget *widget,
       gtk_widget_set_child_visible (paned->handle_widget, FALSE);
     }
 
-  gtk_accessible_update_property (GTK_ACCESSIBLE (paned),
-                                  GTK_ACCESSIBLE_PROPERTY_VALUE_MIN, 0.0,
-                                  GTK_ACCESSIBLE_PROPERTY_VALUE_MAX,
-                                      (double) (paned->orientation == GTK_ORIENTATION_HORIZONTAL ?  width : height),
-                                  GTK_ACCESSIBLE_PROPERTY_VALUE_NOW,
-                                      (double) paned->start_child_size,
-                                  -1);
+  gtk_paned_update_accessible_value (paned,
+                                     paned->orientation == GTK_ORIENTATION_HORIZONTAL ? width : height);
 }
 
 
@@ -1450,6 +1468,8 @@ gtk_paned_init (GtkPaned *paned)
 
   paned->position_set = FALSE;
   paned->last_allocation = -1;
+  paned->a11y_value_max = -1;
+  paned->a11y_value_now = -1;
 
   paned->last_start_child_focus = NULL;
   paned->last_end_child_focus = NULL;
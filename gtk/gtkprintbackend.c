@@ -28,6 +28,8 @@
 #include "gtkprivate.h"
 #include "gtkprintbackendprivate.h"
 
+#include "gdk/gdkprofilerprivate.h"
+
 
 static void gtk_print_backend_finalize     (GObject      *object);
 static void gtk_print_backend_dispose      (GObject      *object);
@@ -83,10 +85,18 @@ gtk_print_backend_error_quark (void)
 void
 gtk_print_backends_init (void)
 {
+  static gboolean initialized = FALSE;
   GIOExtensionPoint *ep;
   GIOModuleScope *scope;
   char **paths;
   int i;
+  gint64 before G_GNUC_UNUSED;
+
+  if (initialized)
+    return;
+
+  initialized = TRUE;
+  before = GDK_PROFILER_CURRENT_TIME;
 
   GTK_NOTE (MODULES,
             g_print ("Registering extension point %s\n", GTK_PRINT_BACKEND_EXTENSION_POINT_NAME));
@@ -107,6 +117,8 @@ gtk_print_backends_init (void)
 
   g_io_module_scope_free (scope);
 
+  gdk_profiler_end_mark (before, "load modules", "printbackends");
+
   if (GTK_DEBUG_CHECK (MODULES))
     {
       GList *list, *l;
@@ -140,6 +152,8 @@ gtk_print_backend_load_modules (void)
 
   result = NULL;
 
+  gtk_print_backends_init ();
+
   ep = g_io_extension_point_lookup (GTK_PRINT_BACKEND_EXTENSION_POINT_NAME);
 
   settings = gtk_settings_get_default ();
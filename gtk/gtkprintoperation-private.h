@@ -55,6 +55,8 @@ struct _GtkPrintOperationPrivate
   guint support_selection  : 1;
   guint has_selection      : 1;
   guint embed_page_setup   : 1;
+  guint threaded_rendering : 1;
+  guint threaded_preview   : 1;
 
   GtkPageDrawingState      page_drawing_state;
 
@@ -84,6 +86,12 @@ struct _GtkPrintOperationPrivate
 
   GMainLoop *rloop; /* recursive mainloop */
 
+  /* For threaded rendering: page number -> RenderedPage */
+  GThreadPool *render_pool;
+  GHashTable *rendered_pages;
+  gpointer waiting_page;
+  gpointer replayed_page;
+
   void (*start_page) (GtkPrintOperation *operation,
 		      GtkPrintContext   *print_context,
 		      GtkPageSetup      *page_setup);
@@ -141,7 +141,8 @@ enum
   PROP_EMBED_PAGE_SETUP,
   PROP_HAS_SELECTION,
   PROP_SUPPORT_SELECTION,
-  PROP_N_PAGES_TO_PRINT
+  PROP_N_PAGES_TO_PRINT,
+  PROP_THREADED_RENDERING
 };
 
 static guint signals[LAST_SIGNAL] = { 0 };
@@ -155,6 +156,9 @@ static void          common_render_page      (GtkPrintOperation             *op,
 static void          increment_page_sequence (PrintPagesData *data);
 static void          prepare_data            (PrintPagesData *data);
 static void          clamp_page_ranges       (PrintPagesData *data);
+static void          stop_threaded_rendering (GtkPrintOperation             *op);
+static void          prefetch_preview_pages  (GtkPrintOperation             *op,
+                                              int                            page_nr);
 
 
 G_DEFINE_TYPE_WITH_CODE (GtkPrintOperation, gtk_print_operation, G_TYPE_OBJECT,
@@ -265,6 +269,9 @@ preview_iface_render_page (GtkPrintOperationPreview *preview,
 
   op = GTK_PRINT_OPERATION (preview);
   common_render_page (op, page_nr);
+
+  if (op->priv->threaded_preview)
+    prefetch_preview_pages (op, page_nr);
 }
 
 static void
@@ -275,6 +282,8 @@ preview_iface_end_preview (GtkPrintOperationPreview *preview)
   
   op = GTK_PRINT_OPERATION (preview);
 
+  stop_threaded_rendering (op);
+
   g_signal_emit (op, signals[END_PRINT], 0, op->priv->print_context);
 
   if (op->priv->rloop)
@@ -420,6 +429,9 @@ gtk_print_operation_set_property (GObject      *object,
     case PROP_SUPPORT_SELECTION:
       gtk_print_operation_set_support_selection (op, g_value_get_boolean (value));
       break;
+    case PROP_THREADED_RENDERING:
+      gtk_print_operation_set_threaded_rendering (op, g_value_get_boolean (value));
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -491,6 +503,9 @@ gtk_print_operation_get_property (GObject    *object,
     case PROP_N_PAGES_TO_PRINT:
       g_value_set_int (value, priv->nr_of_pages_to_print);
       break;
+    case PROP_THREADED_RENDERING:
+      g_value_set_boolean (value, priv->threaded_rendering);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -1382,6 +1397,22 @@ gtk_print_operation_class_init (GtkPrintOperationClass *class)
 						     G_MAXINT,
 						     -1,
 						     GTK_PARAM_READABLE|G_PARAM_EXPLICIT_NOTIFY));
+
+  /**
+   * GtkPrintOperation:threaded-rendering:
+   *
+   * If %TRUE, the #GtkPrintOperation::draw-page signal is emitted
+   * from worker threads while printing.
+   *
+   * See gtk_print_operation_set_threaded_rendering().
+   */
+  g_object_class_install_property (gobject_class,
+				   PROP_THREADED_RENDERING,
+				   g_param_spec_boolean ("threaded-rendering",
+							 P_("Threaded Rendering"),
+							 P_("TRUE if pages are drawn in worker threads."),
+							 FALSE,
+							 GTK_PARAM_READWRITE|G_PARAM_EXPLICIT_NOTIFY));
 }
 
 /**
@@ -2194,6 +2225,9 @@ print_pages_idle_done (gpointer user_data)
 
   priv->print_pages_idle_id = 0;
 
+  if (!data->is_preview)
+    stop_threaded_rendering (data->op);
+
   if (priv->show_progress_timeout_id > 0)
     {
       g_source_remove (priv->show_progress_timeout_id);
@@ -2313,6 +2347,68 @@ gtk_print_operation_get_embed_page_setup (GtkPrintOperation *op)
   return priv->embed_page_setup;
 }
 
+/**
+ * gtk_print_operation_set_threaded_rendering:
+ * @op: a #GtkPrintOperation
+ * @threaded_rendering: %TRUE to draw pages in worker threads
+ *
+ * Sets whether pages are drawn in worker threads while printing.
+ *
+ * In this mode, the #GtkPrintOperation::draw-page signal is emitted
+ * from a pool of worker threads for several pages at once, each with
+ * its own #GtkPrintContext that records the drawing. The recorded
+ * pages are sent to the printer in order on the main thread as soon
+ * as they are complete. #GtkPrintOperation::request-page-setup is
+ * emitted on the main thread before a page is handed to a worker,
+ * so it may be emitted ahead of the page that is being printed.
+ *
+ * In print previews, the recorded pages are kept while the preview is
+ * open, and the pages next to the one that was rendered last are drawn
+ * in the background, so that gtk_print_operation_preview_render_page()
+ * only replays them. With units other than %GTK_UNIT_NONE, a recorded
+ * page is reused when the resolution of the preview changes, for
+ * example when zooming.
+ *
+ * The handlers for #GtkPrintOperation::draw-page must be thread-safe
+ * and only use the #GtkPrintContext they are given. They must not
+ * call gtk_print_operation_set_defer_drawing().
+ */
+void
+gtk_print_operation_set_threaded_rendering (GtkPrintOperation *op,
+                                            gboolean           threaded_rendering)
+{
+  GtkPrintOperationPrivate *priv = gtk_print_operation_get_instance_private (op);
+
+  g_return_if_fail (GTK_IS_PRINT_OPERATION (op));
+
+  threaded_rendering = threaded_rendering != FALSE;
+
+  if (priv->threaded_rendering != threaded_rendering)
+    {
+      priv->threaded_rendering = threaded_rendering;
+
+      g_object_notify (G_OBJECT (op), "threaded-rendering");
+    }
+}
+
+/**
+ * gtk_print_operation_get_threaded_rendering:
+ * @op: a #GtkPrintOperation
+ *
+ * Gets the value of #GtkPrintOperation:threaded-rendering property.
+ *
+ * Returns: whether pages are drawn in worker threads
+ */
+gboolean
+gtk_print_operation_get_threaded_rendering (GtkPrintOperation *op)
+{
+  GtkPrintOperationPrivate *priv = gtk_print_operation_get_instance_private (op);
+
+  g_return_val_if_fail (GTK_IS_PRINT_OPERATION (op), FALSE);
+
+  return priv->threaded_rendering;
+}
+
 /**
  * gtk_print_operation_draw_page_finish:
  * @op: a #GtkPrintOperation
@@ -2347,6 +2443,296 @@ gtk_print_operation_draw_page_finish (GtkPrintOperation *op)
   priv->page_drawing_state = GTK_PAGE_DRAWING_STATE_READY;
 }
 
+/* Threaded rendering
+ *
+ * Pages are drawn by a thread pool into recording surfaces, a few pages
+ * ahead of the page that is being printed. common_render_page() then
+ * defers the drawing of the page until its recording is complete, and
+ * replays it into the real print context.
+ *
+ * Previews expect render_page() to draw synchronously, so they wait for
+ * the recording instead of deferring. They keep the recordings of the
+ * pages around the current one as a cache.
+ */
+
+/* How far from the current page preview recordings are kept */
+#define PREVIEW_CACHE_DISTANCE 8
+
+typedef struct
+{
+  GtkPrintOperation *op;
+  int page_nr;
+  GtkPageSetup *page_setup;
+  GtkPrintContext *context;
+  cairo_surface_t *recording;
+  /* The unit scale of the context, to undo it when replaying */
+  cairo_matrix_t matrix;
+  double dpi_x, dpi_y;
+  int cancelled; /* atomic */
+
+  GMutex lock;
+  GCond cond;
+  gboolean drawn; /* protected by lock */
+} RenderedPage;
+
+static void
+rendered_page_clear (gpointer data)
+{
+  RenderedPage *page = data;
+
+  g_object_unref (page->context);
+  g_object_unref (page->page_setup);
+  cairo_surface_destroy (page->recording);
+  g_object_unref (page->op);
+  g_mutex_clear (&page->lock);
+  g_cond_clear (&page->cond);
+}
+
+static gboolean
+rendered_page_is_drawn (RenderedPage *page)
+{
+  gboolean drawn;
+
+  g_mutex_lock (&page->lock);
+  drawn = page->drawn;
+  g_mutex_unlock (&page->lock);
+
+  return drawn;
+}
+
+static void
+rendered_page_wait (RenderedPage *page)
+{
+  g_mutex_lock (&page->lock);
+  while (!page->drawn)
+    g_cond_wait (&page->cond, &page->lock);
+  g_mutex_unlock (&page->lock);
+}
+
+static gboolean
+rendered_page_is_distant (gpointer key,
+                      gpointer value,
+                      gpointer user_data)
+{
+  RenderedPage *page = value;
+  int page_nr = GPOINTER_TO_INT (user_data);
+
+  if (ABS (page->page_nr - page_nr) <= PREVIEW_CACHE_DISTANCE)
+    return FALSE;
+
+  g_atomic_int_set (&page->cancelled, TRUE);
+
+  return TRUE;
+}
+
+static void
+rendered_page_unref (gpointer data)
+{
+  g_atomic_rc_box_release_full (data, rendered_page_clear);
+}
+
+static void
+replay_page (GtkPrintOperation *op,
+             RenderedPage      *page)
+{
+  GtkPrintOperationPrivate *priv = gtk_print_operation_get_instance_private (op);
+  cairo_t *cr;
+
+  cr = gtk_print_context_get_cairo_context (priv->print_context);
+
+  cairo_save (cr);
+  cairo_set_source_surface (cr, page->recording, 0, 0);
+  cairo_pattern_set_matrix (cairo_get_source (cr), &page->matrix);
+  cairo_paint (cr);
+  cairo_restore (cr);
+
+  if (priv->threaded_preview)
+    {
+      g_hash_table_foreach_remove (priv->rendered_pages,
+                                   rendered_page_is_distant,
+                                   GINT_TO_POINTER (page->page_nr));
+    }
+  else
+    {
+      /* Keep the last page around for copies that print it again */
+      if (priv->replayed_page != NULL && priv->replayed_page != page)
+        g_hash_table_remove (priv->rendered_pages,
+                             GINT_TO_POINTER (((RenderedPage *) priv->replayed_page)->page_nr));
+      priv->replayed_page = page;
+    }
+
+  gtk_print_operation_draw_page_finish (op);
+}
+
+static gboolean
+rendered_page_done (gpointer data)
+{
+  RenderedPage *page = data;
+  GtkPrintOperationPrivate *priv = gtk_print_operation_get_instance_private (page->op);
+
+  if (g_atomic_int_get (&page->cancelled))
+    return G_SOURCE_REMOVE;
+
+  if (priv->waiting_page == page)
+    {
+      priv->waiting_page = NULL;
+      replay_page (page->op, page);
+    }
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+render_page_thread (gpointer data,
+                    gpointer user_data)
+{
+  RenderedPage *page = data;
+
+  if (!g_atomic_int_get (&page->cancelled))
+    g_signal_emit (page->op, signals[DRAW_PAGE], 0, page->context, page->page_nr);
+
+  g_mutex_lock (&page->lock);
+  page->drawn = TRUE;
+  g_cond_broadcast (&page->cond);
+  g_mutex_unlock (&page->lock);
+
+  /* Hand the page back to the main thread, which also drops the
+   * last references to it */
+  g_idle_add_full (G_PRIORITY_DEFAULT, rendered_page_done, page, rendered_page_unref);
+}
+
+static void
+start_threaded_rendering (GtkPrintOperation *op,
+                          gboolean           preview)
+{
+  GtkPrintOperationPrivate *priv = gtk_print_operation_get_instance_private (op);
+
+  priv->threaded_preview = preview;
+
+  priv->render_pool = g_thread_pool_new (render_page_thread, NULL,
+                                         g_get_num_processors (), FALSE, NULL);
+  priv->rendered_pages = g_hash_table_new_full (NULL, NULL, NULL, rendered_page_unref);
+}
+
+static void
+stop_threaded_rendering (GtkPrintOperation *op)
+{
+  GtkPrintOperationPrivate *priv = gtk_print_operation_get_instance_private (op);
+  GHashTableIter iter;
+  gpointer page;
+
+  if (priv->render_pool == NULL)
+    return;
+
+  g_hash_table_iter_init (&iter, priv->rendered_pages);
+  while (g_hash_table_iter_next (&iter, NULL, &page))
+    g_atomic_int_set (&((RenderedPage *) page)->cancelled, TRUE);
+
+  /* Wait for the pages that are being drawn, and skip the queued ones */
+  g_thread_pool_free (priv->render_pool, FALSE, TRUE);
+  priv->render_pool = NULL;
+
+  priv->waiting_page = NULL;
+  priv->replayed_page = NULL;
+  priv->threaded_preview = FALSE;
+  g_clear_pointer (&priv->rendered_pages, g_hash_table_unref);
+}
+
+static RenderedPage *
+submit_page (GtkPrintOperation *op,
+             int                page_nr)
+{
+  GtkPrintOperationPrivate *priv = gtk_print_operation_get_instance_private (op);
+  RenderedPage *page;
+  double top, bottom, left, right;
+  cairo_t *cr;
+
+  page = g_hash_table_lookup (priv->rendered_pages, GINT_TO_POINTER (page_nr));
+  if (page)
+    {
+      /* Without a unit, the drawing depends on the resolution */
+      if (priv->unit != GTK_UNIT_NONE ||
+          (page->dpi_x == gtk_print_context_get_dpi_x (priv->print_context) &&
+           page->dpi_y == gtk_print_context_get_dpi_y (priv->print_context)))
+        return page;
+
+      g_atomic_int_set (&page->cancelled, TRUE);
+      g_hash_table_remove (priv->rendered_pages, GINT_TO_POINTER (page_nr));
+    }
+
+  page = g_atomic_rc_box_new0 (RenderedPage);
+  page->op = g_object_ref (op);
+  page->page_nr = page_nr;
+  page->dpi_x = gtk_print_context_get_dpi_x (priv->print_context);
+  page->dpi_y = gtk_print_context_get_dpi_y (priv->print_context);
+  g_mutex_init (&page->lock);
+  g_cond_init (&page->cond);
+
+  page->page_setup = create_page_setup (op);
+  g_signal_emit (op, signals[REQUEST_PAGE_SETUP], 0,
+                 priv->print_context, page_nr, page->page_setup);
+
+  page->recording = cairo_recording_surface_create (CAIRO_CONTENT_COLOR_ALPHA, NULL);
+  cr = cairo_create (page->recording);
+  page->context = _gtk_print_context_new (op);
+  gtk_print_context_set_cairo_context (page->context, cr,
+                                       gtk_print_context_get_dpi_x (priv->print_context),
+                                       gtk_print_context_get_dpi_y (priv->print_context));
+  cairo_get_matrix (cr, &page->matrix);
+  cairo_destroy (cr);
+
+  _gtk_print_context_set_page_setup (page->context, page->page_setup);
+  if (gtk_print_context_get_hard_margins (priv->print_context, &top, &bottom, &left, &right))
+    _gtk_print_context_set_hard_margins (page->context,
+                                         top * page->matrix.yy,
+                                         bottom * page->matrix.yy,
+                                         left * page->matrix.xx,
+                                         right * page->matrix.xx);
+
+  g_hash_table_insert (priv->rendered_pages, GINT_TO_POINTER (page_nr), page);
+  g_thread_pool_push (priv->render_pool, g_atomic_rc_box_acquire (page), NULL);
+
+  return page;
+}
+
+/* Submits the pages of the next sheets, starting with the current one */
+static void
+prefetch_pages (PrintPagesData *data)
+{
+  GtkPrintOperationPrivate *priv = gtk_print_operation_get_instance_private (data->op);
+  int number_up = MAX (priv->manual_number_up, 1);
+  int step = priv->manual_page_set == GTK_PAGE_SET_ALL ? 1 : 2;
+  int n_ahead = 2 * g_get_num_processors ();
+  int sheet, position;
+
+  sheet = priv->page_position / number_up;
+  position = priv->page_position;
+
+  while (n_ahead > 0 && sheet >= 0 && sheet < data->num_of_sheets)
+    {
+      for (;
+           n_ahead > 0 && position < MIN ((sheet + 1) * number_up, priv->nr_of_pages_to_print);
+           position++, n_ahead--)
+        submit_page (data->op, data->pages[position]);
+
+      sheet += priv->manual_reverse ? -step : step;
+      position = sheet * number_up;
+    }
+}
+
+/* Draws the pages next to @page_nr in the background */
+static void
+prefetch_preview_pages (GtkPrintOperation *op,
+                        int                page_nr)
+{
+  GtkPrintOperationPrivate *priv = gtk_print_operation_get_instance_private (op);
+
+  if (page_nr + 1 < priv->nr_of_pages)
+    submit_page (op, page_nr + 1);
+  if (page_nr > 0)
+    submit_page (op, page_nr - 1);
+}
+
 static void
 common_render_page (GtkPrintOperation *op,
 		    int                page_nr)
@@ -2354,14 +2740,23 @@ common_render_page (GtkPrintOperation *op,
   GtkPrintOperationPrivate *priv = gtk_print_operation_get_instance_private (op);
   GtkPageSetup *page_setup;
   GtkPrintContext *print_context;
+  RenderedPage *rendered_page = NULL;
   cairo_t *cr;
 
   print_context = priv->print_context;
   
-  page_setup = create_page_setup (op);
-  
-  g_signal_emit (op, signals[REQUEST_PAGE_SETUP], 0, 
-		 print_context, page_nr, page_setup);
+  if (priv->render_pool)
+    {
+      rendered_page = submit_page (op, page_nr);
+      page_setup = g_object_ref (rendered_page->page_setup);
+    }
+  else
+    {
+      page_setup = create_page_setup (op);
+
+      g_signal_emit (op, signals[REQUEST_PAGE_SETUP], 0,
+                     print_context, page_nr, page_setup);
+    }
   
   _gtk_print_context_set_page_setup (print_context, page_setup);
   
@@ -2567,6 +2962,26 @@ common_render_page (GtkPrintOperation *op,
   
   priv->page_drawing_state = GTK_PAGE_DRAWING_STATE_DRAWING;
 
+  if (rendered_page)
+    {
+      if (priv->threaded_preview)
+        {
+          rendered_page_wait (rendered_page);
+          replay_page (op, rendered_page);
+        }
+      else if (rendered_page_is_drawn (rendered_page))
+        {
+          replay_page (op, rendered_page);
+        }
+      else
+        {
+          priv->page_drawing_state = GTK_PAGE_DRAWING_STATE_DEFERRED_DRAWING;
+          priv->waiting_page = rendered_page;
+        }
+
+      return;
+    }
+
   g_signal_emit (op, signals[DRAW_PAGE], 0, 
 		 print_context, page_nr);
 
@@ -2767,7 +3182,12 @@ print_pages_idle (gpointer user_data)
       increment_page_sequence (data);
 
       if (!data->done)
-        common_render_page (data->op, data->page);
+        {
+          if (priv->render_pool)
+            prefetch_pages (data);
+
+          common_render_page (data->op, data->page);
+        }
       else
         done = priv->page_drawing_state == GTK_PAGE_DRAWING_STATE_READY;
 
@@ -2927,6 +3347,9 @@ print_pages (GtkPrintOperation       *op,
       priv->manual_number_up_layout = gtk_print_settings_get_number_up_layout (priv->print_settings);
     }
   
+  if (priv->threaded_rendering)
+    start_threaded_rendering (op, data->is_preview);
+
   priv->print_pages_idle_id = g_idle_add_full (G_PRIORITY_DEFAULT_IDLE + 10,
                                                print_pages_idle,
                                                data,
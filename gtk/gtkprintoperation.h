@@ -299,6 +299,11 @@ GDK_AVAILABLE_IN_ALL
 gboolean                gtk_print_operation_get_embed_page_setup   (GtkPrintOperation  *op);
 GDK_AVAILABLE_IN_ALL
 int                     gtk_print_operation_get_n_pages_to_print   (GtkPrintOperation  *op);
+GDK_AVAILABLE_IN_ALL
+void                    gtk_print_operation_set_threaded_rendering (GtkPrintOperation  *op,
+                                                                    gboolean            threaded_rendering);
+GDK_AVAILABLE_IN_ALL
+gboolean                gtk_print_operation_get_threaded_rendering (GtkPrintOperation  *op);
 
 GDK_AVAILABLE_IN_ALL
 GtkPageSetup           *gtk_print_run_page_setup_dialog            (GtkWindow          *parent,
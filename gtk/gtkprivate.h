@@ -68,6 +68,7 @@ char        * _gtk_get_lc_ctype           (void);
 void          _gtk_ensure_resources       (void);
 
 void          gtk_main_sync               (void);
+gint64        gtk_get_init_time           (void);
 
 GtkWidget *   gtk_window_group_get_current_grab (GtkWindowGroup *window_group);
 void          gtk_grab_add                      (GtkWidget      *widget);
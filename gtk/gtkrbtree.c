@@ -707,6 +707,57 @@ gtk_rb_tree_insert_after (GtkRbTree *tree,
   return NODE_TO_POINTER (result);
 }
 
+/* The tree is as balanced as possible, so all nodes but the ones in the
+ * last row are black and the last row is red if it isn't full */
+static GtkRbNode *
+gtk_rb_node_new_balanced (GtkRbTree *tree,
+                          guint      n,
+                          guint      depth,
+                          guint      red_depth)
+{
+  GtkRbNode *node;
+  guint n_left;
+
+  if (n == 0)
+    return NULL;
+
+  node = gtk_rb_node_new (tree);
+  node->red = depth == red_depth;
+
+  n_left = (n - 1) / 2;
+  node->left = gtk_rb_node_new_balanced (tree, n_left, depth + 1, red_depth);
+  if (node->left)
+    node->left->parent = node;
+  node->right = gtk_rb_node_new_balanced (tree, n - 1 - n_left, depth + 1, red_depth);
+  if (node->right)
+    node->right->parent = node;
+
+  return node;
+}
+
+/* Fills an empty tree with n_items elements in O(n_items) instead of
+ * inserting them one by one. Returns the first element. */
+gpointer
+gtk_rb_tree_fill (GtkRbTree *tree,
+                  guint      n_items)
+{
+  GtkRbNode *root;
+
+  g_return_val_if_fail (tree->root == NULL, NULL);
+
+#ifdef DUMP_MODIFICATION
+  g_print ("fill (tree, %u); /* 0x%p */\n", n_items, tree);
+#endif /* DUMP_MODIFICATION */
+
+  if (n_items == 0)
+    return NULL;
+
+  root = gtk_rb_node_new_balanced (tree, n_items, 0, g_bit_storage (n_items + 1) - 1);
+  set_parent (tree, root, NULL);
+
+  return NODE_TO_POINTER (gtk_rb_node_get_first (root));
+}
+
 void
 gtk_rb_tree_remove (GtkRbTree *tree,
                     gpointer   node)
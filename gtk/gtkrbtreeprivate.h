@@ -64,6 +64,8 @@ gpointer             gtk_rb_tree_insert_before          (GtkRbTree
                                                          gpointer                 node);
 gpointer             gtk_rb_tree_insert_after           (GtkRbTree               *tree,
                                                          gpointer                 node);
+gpointer             gtk_rb_tree_fill                   (GtkRbTree               *tree,
+                                                         guint                    n_items);
 void                 gtk_rb_tree_remove                 (GtkRbTree               *tree,
                                                          gpointer                 node);
 void                 gtk_rb_tree_remove_all             (GtkRbTree               *tree);
@@ -165,12 +165,14 @@ struct _GtkRecentManagerPrivate
   char *filename;
 
   guint is_dirty : 1;
+  guint reload_pending : 1;
 
   int size;
 
   GBookmarkFile *recent_items;
 
   GFileMonitor *monitor;
+  GCancellable *load_cancellable;
 
   guint changed_timeout;
   guint changed_age;
@@ -216,6 +218,7 @@ static void     gtk_recent_manager_enabled_changed     (GtkRecentManager  *manag
 
 
 static void     build_recent_items_list                (GtkRecentManager  *manager);
+static void     gtk_recent_manager_reload              (GtkRecentManager  *manager);
 static void     purge_recent_items_list                (GtkRecentManager  *manager,
                                                         GError           **error);
 
@@ -402,6 +405,12 @@ gtk_recent_manager_dispose (GObject *gobject)
       priv->monitor = NULL;
     }
 
+  if (priv->load_cancellable != NULL)
+    {
+      g_cancellable_cancel (priv->load_cancellable);
+      g_clear_object (&priv->load_cancellable);
+    }
+
   if (priv->changed_timeout != 0)
     {
       g_source_remove (priv->changed_timeout);
@@ -509,14 +518,10 @@ gtk_recent_manager_real_changed (GtkRecentManager *manager)
       /* mark us as clean */
       priv->is_dirty = FALSE;
     }
-  else
-    {
-      /* we are not marked as dirty, so we have been called
-       * because the recently used resources file has been
-       * changed (and not from us).
-       */
-      build_recent_items_list (manager);
-    }
+  /* if we are not marked as dirty, we have been called because the
+   * recently used resources file has been changed (and not from us),
+   * and gtk_recent_manager_reload() has already read it
+   */
 
   g_object_thaw_notify (G_OBJECT (manager));
 }
@@ -535,7 +540,7 @@ gtk_recent_manager_monitor_changed (GFileMonitor      *monitor,
     case G_FILE_MONITOR_EVENT_CHANGED:
     case G_FILE_MONITOR_EVENT_CREATED:
     case G_FILE_MONITOR_EVENT_DELETED:
-      gtk_recent_manager_changed (manager);
+      gtk_recent_manager_reload (manager);
       break;
 
     case G_FILE_MONITOR_EVENT_CHANGES_DONE_HINT:
@@ -595,6 +600,12 @@ gtk_recent_manager_set_filename (GtkRecentManager *manager,
     {
       g_free (priv->filename);
 
+      if (priv->load_cancellable)
+        {
+          g_cancellable_cancel (priv->load_cancellable);
+          g_clear_object (&priv->load_cancellable);
+        }
+
       if (priv->monitor)
         {
           g_signal_handlers_disconnect_by_func (priv->monitor,
@@ -645,6 +656,62 @@ gtk_recent_manager_set_filename (GtkRecentManager *manager,
   build_recent_items_list (manager);
 }
 
+/* replaces the items list with the result of reading the recently
+ * used resources file; this function resets the dirty bit of the
+ * manager.
+ */
+static void
+gtk_recent_manager_set_items (GtkRecentManager *manager,
+                              GBookmarkFile    *items,
+                              GError           *read_error)
+{
+  GtkRecentManagerPrivate *priv = manager->priv;
+  int size;
+
+  if (priv->recent_items)
+    g_bookmark_file_free (priv->recent_items);
+  priv->recent_items = items;
+
+  if (read_error)
+    {
+      /* if the file does not exist we just wait for the first write
+       * operation on this recent manager instance, to avoid creating
+       * empty files and leading to spurious file system events (Sabayon
+       * will not be happy about those)
+       */
+      if (read_error->domain == G_FILE_ERROR &&
+          read_error->code != G_FILE_ERROR_NOENT)
+        {
+          char *utf8 = g_filename_to_utf8 (priv->filename, -1, NULL, NULL, NULL);
+          g_warning ("Attempting to read the recently used resources "
+                     "file at '%s', but the parser failed: %s.",
+                     utf8 ? utf8 : "(invalid filename)",
+                     read_error->message);
+          g_free (utf8);
+        }
+
+      /* the file exists, and it's valid (we hope); if not, destroy the
+       * container object and hope for a better result when the next
+       * "changed" signal is fired.
+       */
+      if (priv->recent_items)
+        g_bookmark_file_free (priv->recent_items);
+      priv->recent_items = NULL;
+    }
+  else
+    {
+      size = g_bookmark_file_get_size (priv->recent_items);
+      if (priv->size != size)
+        {
+          priv->size = size;
+
+          g_object_notify (G_OBJECT (manager), "size");
+        }
+    }
+
+  priv->is_dirty = FALSE;
+}
+
 /* reads the recently used resources file and builds the items list.
  * we keep the items list inside the parser object, and build the
  * RecentInfo object only on user’s demand to avoid useless replication.
@@ -654,59 +721,123 @@ static void
 build_recent_items_list (GtkRecentManager *manager)
 {
   GtkRecentManagerPrivate *priv = manager->priv;
+  GBookmarkFile *items;
   GError *read_error;
-  int size;
 
-  if (!priv->recent_items)
+  if (priv->filename == NULL)
     {
-      priv->recent_items = g_bookmark_file_new ();
-      priv->size = 0;
+      if (!priv->recent_items)
+        {
+          priv->recent_items = g_bookmark_file_new ();
+          priv->size = 0;
+        }
+
+      priv->is_dirty = FALSE;
+      return;
     }
 
-  if (priv->filename != NULL)
+  items = g_bookmark_file_new ();
+  read_error = NULL;
+  g_bookmark_file_load_from_file (items, priv->filename, &read_error);
+  gtk_recent_manager_set_items (manager, items, read_error);
+  g_clear_error (&read_error);
+}
+
+static void
+load_recent_items_thread (GTask        *task,
+                          gpointer      source_object,
+                          gpointer      task_data,
+                          GCancellable *cancellable)
+{
+  GBookmarkFile *items;
+  GError *error = NULL;
+
+  items = g_bookmark_file_new ();
+  if (g_bookmark_file_load_from_file (items, task_data, &error))
+    g_task_return_pointer (task, items, (GDestroyNotify) g_bookmark_file_free);
+  else
     {
-      /* the file exists, and it's valid (we hope); if not, destroy the container
-       * object and hope for a better result when the next "changed" signal is
-       * fired.
-       */
-      read_error = NULL;
-      g_bookmark_file_load_from_file (priv->recent_items, priv->filename, &read_error);
-      if (read_error)
-        {
-          /* if the file does not exist we just wait for the first write
-           * operation on this recent manager instance, to avoid creating
-           * empty files and leading to spurious file system events (Sabayon
-           * will not be happy about those)
-           */
-          if (read_error->domain == G_FILE_ERROR &&
-              read_error->code != G_FILE_ERROR_NOENT)
-            {
-              char *utf8 = g_filename_to_utf8 (priv->filename, -1, NULL, NULL, NULL);
-              g_warning ("Attempting to read the recently used resources "
-                         "file at '%s', but the parser failed: %s.",
-                         utf8 ? utf8 : "(invalid filename)",
-                         read_error->message);
-              g_free (utf8);
-            }
+      g_bookmark_file_free (items);
+      g_task_return_error (task, error);
+    }
+}
 
-          g_bookmark_file_free (priv->recent_items);
-          priv->recent_items = NULL;
+static void
+load_recent_items_done (GObject      *source,
+                        GAsyncResult *result,
+                        gpointer      data)
+{
+  GtkRecentManager *manager = GTK_RECENT_MANAGER (source);
+  GtkRecentManagerPrivate *priv = manager->priv;
+  GBookmarkFile *items;
+  GError *error = NULL;
 
-          g_error_free (read_error);
-        }
-      else
-        {
-          size = g_bookmark_file_get_size (priv->recent_items);
-          if (priv->size != size)
-            {
-              priv->size = size;
+  items = g_task_propagate_pointer (G_TASK (result), &error);
+  if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+    {
+      g_error_free (error);
+      return;
+    }
 
-              g_object_notify (G_OBJECT (manager), "size");
-            }
-        }
+  g_clear_object (&priv->load_cancellable);
+
+  if (priv->reload_pending)
+    {
+      /* the file changed again while we were reading it */
+      g_clear_pointer (&items, g_bookmark_file_free);
+      g_clear_error (&error);
+      gtk_recent_manager_reload (manager);
+      return;
     }
 
-  priv->is_dirty = FALSE;
+  if (priv->is_dirty)
+    {
+      /* our own changes are about to be written, and they win */
+      g_clear_pointer (&items, g_bookmark_file_free);
+      g_clear_error (&error);
+      return;
+    }
+
+  gtk_recent_manager_set_items (manager, items, error);
+  g_clear_error (&error);
+
+  gtk_recent_manager_changed (manager);
+}
+
+/* reads the recently used resources file in a thread after it has
+ * been changed by someone else, and emits the "changed" signal once
+ * the new items list is in place. With a long history, parsing the
+ * file takes long enough to be noticeable in the main loop.
+ */
+static void
+gtk_recent_manager_reload (GtkRecentManager *manager)
+{
+  GtkRecentManagerPrivate *priv = manager->priv;
+  GTask *task;
+
+  /* pending changes of our own are written out by the "changed"
+   * signal, replacing the file anyway
+   */
+  if (priv->is_dirty || priv->filename == NULL)
+    {
+      gtk_recent_manager_changed (manager);
+      return;
+    }
+
+  if (priv->load_cancellable != NULL)
+    {
+      priv->reload_pending = TRUE;
+      return;
+    }
+
+  priv->reload_pending = FALSE;
+  priv->load_cancellable = g_cancellable_new ();
+
+  task = g_task_new (manager, priv->load_cancellable, load_recent_items_done, NULL);
+  g_task_set_source_tag (task, gtk_recent_manager_reload);
+  g_task_set_task_data (task, g_strdup (priv->filename), g_free);
+  g_task_run_in_thread (task, load_recent_items_thread);
+  g_object_unref (task);
 }
 
 
@@ -251,35 +251,23 @@ gtk_theming_background_snapshot_layer (GtkCssBoxes *bg,
   gtk_snapshot_pop (snapshot);
 }
 
-void
-gtk_css_style_snapshot_background (GtkCssBoxes *boxes,
-                                   GtkSnapshot *snapshot)
+static void
+snapshot_background (GtkCssBoxes   *boxes,
+                     GtkSnapshot   *snapshot,
+                     const GdkRGBA *bg_color,
+                     gboolean       has_bg_color,
+                     gboolean       has_bg_image,
+                     gboolean       has_shadow)
 {
   const GtkCssBackgroundValues *background = boxes->style->background;
   GtkCssValue *background_image;
-  const GdkRGBA *bg_color;
   const GtkCssValue *box_shadow;
-  gboolean has_bg_color;
-  gboolean has_bg_image;
-  gboolean has_shadow;
   int idx;
   guint number_of_layers;
 
-  if (background->base.type == GTK_CSS_BACKGROUND_INITIAL_VALUES)
-    return;
-
   background_image = background->background_image;
-  bg_color = gtk_css_color_value_get_rgba (background->background_color);
   box_shadow = background->box_shadow;
 
-  has_bg_color = !gdk_rgba_is_clear (bg_color);
-  has_bg_image = _gtk_css_image_value_get_image (_gtk_css_array_value_get_nth (background_image, 0)) != NULL;
-  has_shadow = !gtk_css_shadow_value_is_none (box_shadow);
-
-  /* This is the common default case of no background */
-  if (!has_bg_color && !has_bg_image && !has_shadow)
-    return;
-
   gtk_snapshot_push_debug (snapshot, "CSS background");
 
   if (has_shadow)
@@ -332,3 +320,55 @@ gtk_css_style_snapshot_background (GtkCssBoxes *boxes,
   gtk_snapshot_pop (snapshot);
 }
 
+void
+gtk_css_style_snapshot_background (GtkCssBoxes *boxes,
+                                   GtkSnapshot *snapshot)
+{
+  const GtkCssBackgroundValues *background = boxes->style->background;
+  const graphene_rect_t *border_rect;
+  const GdkRGBA *bg_color;
+  GskRenderNode *node;
+  gboolean has_bg_color;
+  gboolean has_bg_image;
+  gboolean has_shadow;
+
+  if (background->base.type == GTK_CSS_BACKGROUND_INITIAL_VALUES)
+    return;
+
+  bg_color = gtk_css_color_value_get_rgba (background->background_color);
+
+  has_bg_color = !gdk_rgba_is_clear (bg_color);
+  has_bg_image = _gtk_css_image_value_get_image (_gtk_css_array_value_get_nth (background->background_image, 0)) != NULL;
+  has_shadow = !gtk_css_shadow_value_is_none (background->box_shadow);
+
+  /* This is the common default case of no background */
+  if (!has_bg_color && !has_bg_image && !has_shadow)
+    return;
+
+  /* Plain colors are cheaper to recreate than to look up, and
+   * animated styles are gone by the next frame */
+  if ((!has_bg_image && !has_shadow) ||
+      !gtk_css_style_is_static (boxes->style))
+    {
+      snapshot_background (boxes, snapshot, bg_color, has_bg_color, has_bg_image, has_shadow);
+      return;
+    }
+
+  border_rect = gtk_css_boxes_get_border_rect (boxes);
+  node = gtk_css_style_get_render_node (boxes->style, GTK_CSS_RENDER_NODE_BACKGROUND, border_rect);
+  if (node == NULL)
+    {
+      GtkSnapshot *background_snapshot = gtk_snapshot_new ();
+
+      snapshot_background (boxes, background_snapshot, bg_color, has_bg_color, has_bg_image, has_shadow);
+      node = gtk_snapshot_free_to_node (background_snapshot);
+      if (node == NULL)
+        return;
+
+      gtk_css_style_set_render_node (boxes->style, GTK_CSS_RENDER_NODE_BACKGROUND, border_rect, node);
+      gsk_render_node_unref (node);
+    }
+
+  gtk_snapshot_append_node (snapshot, node);
+}
+
@@ -642,12 +642,59 @@ snapshot_border (GtkSnapshot          *snapshot,
   snapshot_frame_fill (snapshot, border_box, border_width, colors, hidden_side);
 }
 
+/* Border images and non-solid borders create lots of nodes, so we
+ * keep them around for static styles. Returns the snapshot to record
+ * into, or %NULL if a cached node was appended already. */
+static GtkSnapshot *
+begin_cached_border (GtkCssBoxes *boxes,
+                     GtkSnapshot *snapshot)
+{
+  GskRenderNode *node;
+
+  if (!gtk_css_style_is_static (boxes->style))
+    return snapshot;
+
+  node = gtk_css_style_get_render_node (boxes->style,
+                                        GTK_CSS_RENDER_NODE_BORDER,
+                                        gtk_css_boxes_get_border_rect (boxes));
+  if (node)
+    {
+      gtk_snapshot_append_node (snapshot, node);
+      return NULL;
+    }
+
+  return gtk_snapshot_new ();
+}
+
+static void
+end_cached_border (GtkCssBoxes *boxes,
+                   GtkSnapshot *snapshot,
+                   GtkSnapshot *record)
+{
+  GskRenderNode *node;
+
+  if (record == snapshot)
+    return;
+
+  node = gtk_snapshot_free_to_node (record);
+  if (node == NULL)
+    return;
+
+  gtk_css_style_set_render_node (boxes->style,
+                                 GTK_CSS_RENDER_NODE_BORDER,
+                                 gtk_css_boxes_get_border_rect (boxes),
+                                 node);
+  gtk_snapshot_append_node (snapshot, node);
+  gsk_render_node_unref (node);
+}
+
 void
 gtk_css_style_snapshot_border (GtkCssBoxes *boxes,
                                GtkSnapshot *snapshot)
 {
   const GtkCssBorderValues *border = boxes->style->border;
   GtkBorderImage border_image;
+  GtkSnapshot *record;
   float border_width[4];
 
   if (border->base.type == GTK_CSS_BORDER_INITIAL_VALUES)
@@ -658,6 +705,10 @@ gtk_css_style_snapshot_border (GtkCssBoxes *boxes,
       cairo_t *cr;
       const graphene_rect_t *bounds;
 
+      record = begin_cached_border (boxes, snapshot);
+      if (record == NULL)
+        return;
+
       border_width[0] = _gtk_css_number_value_get (border->border_top_width, 100);
       border_width[1] = _gtk_css_number_value_get (border->border_right_width, 100);
       border_width[2] = _gtk_css_number_value_get (border->border_bottom_width, 100);
@@ -665,11 +716,13 @@ gtk_css_style_snapshot_border (GtkCssBoxes *boxes,
 
       bounds = gtk_css_boxes_get_border_rect (boxes);
 
-      gtk_snapshot_push_debug (snapshot, "CSS border image");
-      cr = gtk_snapshot_append_cairo (snapshot, bounds);
+      gtk_snapshot_push_debug (record, "CSS border image");
+      cr = gtk_snapshot_append_cairo (record, bounds);
       gtk_border_image_render (&border_image, border_width, cr, bounds);
       cairo_destroy (cr);
-      gtk_snapshot_pop (snapshot);
+      gtk_snapshot_pop (record);
+
+      end_cached_border (boxes, snapshot, record);
     }
   else
     {
@@ -701,27 +754,35 @@ gtk_css_style_snapshot_border (GtkCssBoxes *boxes,
       border_width[2] = _gtk_css_number_value_get (border->border_bottom_width, 100);
       border_width[3] = _gtk_css_number_value_get (border->border_left_width, 100);
 
-      gtk_snapshot_push_debug (snapshot, "CSS border");
       if (border_style[0] <= GTK_BORDER_STYLE_SOLID &&
           border_style[1] <= GTK_BORDER_STYLE_SOLID &&
           border_style[2] <= GTK_BORDER_STYLE_SOLID &&
           border_style[3] <= GTK_BORDER_STYLE_SOLID)
         {
           /* The most common case of a solid border */
+          gtk_snapshot_push_debug (snapshot, "CSS border");
           gtk_snapshot_append_border (snapshot,
                                       gtk_css_boxes_get_border_box (boxes),
                                       border_width,
                                       colors);
+          gtk_snapshot_pop (snapshot);
         }
       else
         {
-          snapshot_border (snapshot,
+          record = begin_cached_border (boxes, snapshot);
+          if (record == NULL)
+            return;
+
+          gtk_snapshot_push_debug (record, "CSS border");
+          snapshot_border (record,
                            gtk_css_boxes_get_border_box (boxes),
                            border_width,
                            colors,
                            border_style);
+          gtk_snapshot_pop (record);
+
+          end_cached_border (boxes, snapshot, record);
         }
-       gtk_snapshot_pop (snapshot);
     }
 }
 
@@ -729,7 +790,7 @@ void
 gtk_css_style_snapshot_outline (GtkCssBoxes *boxes,
                                 GtkSnapshot *snapshot)
 {
-  GtkCssOutlineValues *outline = boxes->style->outline;
+  GtkCssOutlineValues *outline = gtk_css_style_get_outline_values (boxes->style);
   GtkBorderStyle border_style[4];
   float border_width[4];
   GdkRGBA colors[4];
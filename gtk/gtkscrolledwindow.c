@@ -902,6 +902,27 @@ policy_may_be_visible (GtkPolicyType policy)
   return policy == GTK_POLICY_ALWAYS || policy == GTK_POLICY_AUTOMATIC;
 }
 
+/* With scrollbars in both directions and no natural size propagation,
+ * our size request doesn't depend on the child's size, so resizes
+ * inside the child only need to reallocate us. Children with a
+ * scrollable border (like tree view headers) do affect our size. */
+static void
+gtk_scrolled_window_update_resize_boundary (GtkScrolledWindow *scrolled_window)
+{
+  GtkScrolledWindowPrivate *priv = gtk_scrolled_window_get_instance_private (scrolled_window);
+  GtkBorder border;
+
+  if (!priv->child)
+    return;
+
+  gtk_widget_set_resize_boundary (priv->child,
+                                  priv->hscrollbar_policy != GTK_POLICY_NEVER &&
+                                  priv->vscrollbar_policy != GTK_POLICY_NEVER &&
+                                  !priv->propagate_natural_width &&
+                                  !priv->propagate_natural_height &&
+                                  !gtk_scrollable_get_border (GTK_SCROLLABLE (priv->child), &border));
+}
+
 static void
 scrolled_window_drag_begin_cb (GtkScrolledWindow *scrolled_window,
                                double             start_x,
@@ -2358,6 +2379,7 @@ gtk_scrolled_window_set_policy (GtkScrolledWindow *scrolled_window,
       priv->hscrollbar_policy = hscrollbar_policy;
       priv->vscrollbar_policy = vscrollbar_policy;
 
+      gtk_scrolled_window_update_resize_boundary (scrolled_window);
       gtk_widget_queue_resize (GTK_WIDGET (scrolled_window));
 
       g_object_notify_by_pspec (object, properties[PROP_HSCROLLBAR_POLICY]);
@@ -4058,6 +4080,7 @@ gtk_scrolled_window_set_propagate_natural_width (GtkScrolledWindow *scrolled_win
     {
       priv->propagate_natural_width = propagate;
       g_object_notify_by_pspec (G_OBJECT (scrolled_window), properties [PROP_PROPAGATE_NATURAL_WIDTH]);
+      gtk_scrolled_window_update_resize_boundary (scrolled_window);
       gtk_widget_queue_resize (GTK_WIDGET (scrolled_window));
     }
 }
@@ -4103,6 +4126,7 @@ gtk_scrolled_window_set_propagate_natural_height (GtkScrolledWindow *scrolled_wi
     {
       priv->propagate_natural_height = propagate;
       g_object_notify_by_pspec (G_OBJECT (scrolled_window), properties [PROP_PROPAGATE_NATURAL_HEIGHT]);
+      gtk_scrolled_window_update_resize_boundary (scrolled_window);
       gtk_widget_queue_resize (GTK_WIDGET (scrolled_window));
     }
 }
@@ -4192,6 +4216,8 @@ gtk_scrolled_window_set_child (GtkScrolledWindow *scrolled_window,
                     "hadjustment", hadj,
                     "vadjustment", vadj,
                     NULL);
+
+      gtk_scrolled_window_update_resize_boundary (scrolled_window);
     }
 
   if (priv->child)
@@ -95,6 +95,14 @@ struct _GtkShortcutController
   guint custom_shortcuts : 1;
 
   guint last_activated;
+
+  /* Built on demand and dropped when the shortcuts or their
+   * triggers change. Maps normalized keyvals to the positions
+   * of the shortcuts whose trigger may match them.
+   */
+  GHashTable *index;
+  GArray *unindexed;
+  GPtrArray *indexed_shortcuts;
 };
 
 struct _GtkShortcutControllerClass
@@ -113,6 +121,36 @@ enum {
 
 static GParamSpec *properties[N_PROPS] = { NULL, };
 
+static void
+gtk_shortcut_controller_invalidate_index (GtkShortcutController *self)
+{
+  if (self->indexed_shortcuts)
+    {
+      guint i;
+
+      for (i = 0; i < self->indexed_shortcuts->len; i++)
+        g_signal_handlers_disconnect_by_func (g_ptr_array_index (self->indexed_shortcuts, i),
+                                              gtk_shortcut_controller_invalidate_index,
+                                              self);
+    }
+
+  g_clear_pointer (&self->indexed_shortcuts, g_ptr_array_unref);
+  g_clear_pointer (&self->index, g_hash_table_unref);
+  g_clear_pointer (&self->unindexed, g_array_unref);
+}
+
+static void
+gtk_shortcut_controller_shortcuts_changed (GListModel            *model,
+                                           guint                  position,
+                                           guint                  removed,
+                                           guint                  added,
+                                           GtkShortcutController *self)
+{
+  gtk_shortcut_controller_invalidate_index (self);
+
+  g_list_model_items_changed (G_LIST_MODEL (self), position, removed, added);
+}
+
 static GType
 gtk_shortcut_controller_list_model_get_item_type (GListModel *list)
 {
@@ -215,10 +253,10 @@ gtk_shortcut_controller_set_property (GObject      *object,
             self->custom_shortcuts = FALSE;
           }
 
-        self->shortcuts_changed_id =  g_signal_connect_swapped (self->shortcuts,
-                                                                "items-changed",
-                                                                G_CALLBACK (g_list_model_items_changed),
-                                                                self);
+        self->shortcuts_changed_id = g_signal_connect (self->shortcuts,
+                                                       "items-changed",
+                                                       G_CALLBACK (gtk_shortcut_controller_shortcuts_changed),
+                                                       self);
       }
       break;
 
@@ -270,6 +308,7 @@ gtk_shortcut_controller_finalize (GObject *object)
 {
   GtkShortcutController *self = GTK_SHORTCUT_CONTROLLER (object);
 
+  gtk_shortcut_controller_invalidate_index (self);
   g_clear_signal_handler (&self->shortcuts_changed_id, self->shortcuts);
   g_clear_object (&self->shortcuts);
 
@@ -290,6 +329,154 @@ shortcut_data_free (gpointer data)
   g_object_unref (sdata->shortcut);
 }
 
+/* Keyval and mnemonic triggers match the lowercase and uppercase
+ * variants of their keyval, and Tab matches ISO_Left_Tab.
+ */
+static guint
+normalize_keyval (guint keyval)
+{
+  if (keyval == GDK_KEY_ISO_Left_Tab)
+    return GDK_KEY_Tab;
+
+  return gdk_keyval_to_lower (keyval);
+}
+
+static void
+gtk_shortcut_controller_index_trigger (GtkShortcutController *self,
+                                       GtkShortcutTrigger    *trigger,
+                                       guint                  position)
+{
+  guint keyval;
+  GArray *positions;
+
+  if (GTK_IS_NEVER_TRIGGER (trigger))
+    return;
+
+  if (GTK_IS_ALTERNATIVE_TRIGGER (trigger))
+    {
+      gtk_shortcut_controller_index_trigger (self, gtk_alternative_trigger_get_first (GTK_ALTERNATIVE_TRIGGER (trigger)), position);
+      gtk_shortcut_controller_index_trigger (self, gtk_alternative_trigger_get_second (GTK_ALTERNATIVE_TRIGGER (trigger)), position);
+      return;
+    }
+
+  if (GTK_IS_KEYVAL_TRIGGER (trigger))
+    keyval = gtk_keyval_trigger_get_keyval (GTK_KEYVAL_TRIGGER (trigger));
+  else if (GTK_IS_MNEMONIC_TRIGGER (trigger))
+    keyval = gtk_mnemonic_trigger_get_keyval (GTK_MNEMONIC_TRIGGER (trigger));
+  else
+    {
+      g_array_append_val (self->unindexed, position);
+      return;
+    }
+
+  keyval = normalize_keyval (keyval);
+  positions = g_hash_table_lookup (self->index, GUINT_TO_POINTER (keyval));
+  if (positions == NULL)
+    {
+      positions = g_array_new (FALSE, FALSE, sizeof (guint));
+      g_hash_table_insert (self->index, GUINT_TO_POINTER (keyval), positions);
+    }
+
+  g_array_append_val (positions, position);
+}
+
+static void
+gtk_shortcut_controller_ensure_index (GtkShortcutController *self)
+{
+  guint i, n;
+
+  if (self->index)
+    return;
+
+  self->index = g_hash_table_new_full (NULL, NULL, NULL, (GDestroyNotify) g_array_unref);
+  self->unindexed = g_array_new (FALSE, FALSE, sizeof (guint));
+  self->indexed_shortcuts = g_ptr_array_new_with_free_func (g_object_unref);
+
+  for (i = 0, n = g_list_model_get_n_items (self->shortcuts); i < n; i++)
+    {
+      GtkShortcut *shortcut = g_list_model_get_item (self->shortcuts, i);
+
+      if (!GTK_IS_SHORTCUT (shortcut))
+        {
+          g_object_unref (shortcut);
+          continue;
+        }
+
+      gtk_shortcut_controller_index_trigger (self, gtk_shortcut_get_trigger (shortcut), i);
+
+      g_signal_connect_swapped (shortcut, "notify::trigger",
+                                G_CALLBACK (gtk_shortcut_controller_invalidate_index), self);
+      g_ptr_array_add (self->indexed_shortcuts, shortcut);
+    }
+}
+
+static void
+add_candidates (GtkShortcutController *self,
+                GArray                *candidates,
+                guint                  keyval)
+{
+  GArray *positions;
+
+  positions = g_hash_table_lookup (self->index, GUINT_TO_POINTER (normalize_keyval (keyval)));
+  if (positions)
+    g_array_append_vals (candidates, positions->data, positions->len);
+}
+
+static int
+compare_positions (gconstpointer a,
+                   gconstpointer b)
+{
+  guint pa = *(const guint *) a;
+  guint pb = *(const guint *) b;
+
+  return pa < pb ? -1 : (pa > pb ? 1 : 0);
+}
+
+/* Returns the sorted positions of all shortcuts that may be
+ * triggered by @event, or %NULL if all of them need to be tried.
+ *
+ * Key events match triggers for any keyval on the same key, in
+ * any layout, so all of those are looked up.
+ */
+static GArray *
+gtk_shortcut_controller_get_candidates (GtkShortcutController *self,
+                                        GdkEvent              *event)
+{
+  GArray *candidates;
+  guint *keyvals;
+  int i, n_keyvals;
+  guint j;
+
+  if (!gdk_display_map_keycode (gdk_event_get_display (event),
+                                gdk_key_event_get_keycode (event),
+                                NULL, &keyvals, &n_keyvals))
+    return NULL;
+
+  gtk_shortcut_controller_ensure_index (self);
+
+  candidates = g_array_new (FALSE, FALSE, sizeof (guint));
+  g_array_append_vals (candidates, self->unindexed->data, self->unindexed->len);
+
+  add_candidates (self, candidates, gdk_key_event_get_keyval (event));
+  for (i = 0; i < n_keyvals; i++)
+    add_candidates (self, candidates, keyvals[i]);
+
+  g_free (keyvals);
+
+  g_array_sort (candidates, compare_positions);
+
+  /* An alternative trigger or several keyvals may have added a position twice */
+  for (i = 0, j = 1; j < candidates->len; j++)
+    {
+      if (g_array_index (candidates, guint, j) != g_array_index (candidates, guint, i))
+        g_array_index (candidates, guint, ++i) = g_array_index (candidates, guint, j);
+    }
+  if (candidates->len > 0)
+    g_array_set_size (candidates, i + 1);
+
+  return candidates;
+}
+
 static gboolean
 gtk_shortcut_controller_run_controllers (GtkEventController *controller,
                                          GdkEvent           *event,
@@ -300,10 +487,26 @@ gtk_shortcut_controller_run_controllers (GtkEventController *controller,
   GtkShortcutController *self = GTK_SHORTCUT_CONTROLLER (controller);
   int i, p;
   GArray *shortcuts = NULL;
+  GArray *candidates;
+  guint first = 0;
   gboolean has_exact = FALSE;
   gboolean retval = FALSE;
 
-  for (i = 0, p = g_list_model_get_n_items (self->shortcuts); i < p; i++)
+  candidates = gtk_shortcut_controller_get_candidates (self, event);
+  if (candidates)
+    {
+      /* Keep trying shortcuts in the order they would be tried without
+       * the index, starting after the last activated one.
+       */
+      while (first < candidates->len &&
+             g_array_index (candidates, guint, first) <= self->last_activated)
+        first++;
+      p = candidates->len;
+    }
+  else
+    p = g_list_model_get_n_items (self->shortcuts);
+
+  for (i = 0; i < p; i++)
     {
       GtkShortcut *shortcut;
       ShortcutData *data;
@@ -311,7 +514,10 @@ gtk_shortcut_controller_run_controllers (GtkEventController *controller,
       GtkWidget *widget;
       GtkNative *native;
 
-      index = (self->last_activated + 1 + i) % g_list_model_get_n_items (self->shortcuts);
+      if (candidates)
+        index = g_array_index (candidates, guint, (first + i) % p);
+      else
+        index = (self->last_activated + 1 + i) % p;
       shortcut = g_list_model_get_item (self->shortcuts, index);
       if (!GTK_IS_SHORTCUT (shortcut))
         {
@@ -380,6 +586,8 @@ gtk_shortcut_controller_run_controllers (GtkEventController *controller,
       data->widget = widget;
     }
 
+  g_clear_pointer (&candidates, g_array_unref);
+
 #ifdef G_ENABLE_DEBUG
   if (GTK_DEBUG_CHECK (KEYBINDINGS))
     {
@@ -32,7 +32,12 @@
 #include "gtkcssnodeprivate.h"
 #include "gtkcssnumbervalueprivate.h"
 #include "gtklayoutmanagerprivate.h"
+#include "gdkprofilerprivate.h"
 
+static guint measure_calls_counter;
+static guint measure_cache_hits_counter;
+static guint measure_calls;
+static guint measure_cache_hits;
 
 #ifdef G_ENABLE_CONSISTENCY_CHECKS
 static GQuark recursion_check_quark = 0;
@@ -170,6 +175,10 @@ gtk_widget_query_size_for_orientation (GtkWidget        *widget,
                                                    &min_baseline,
                                                    &nat_baseline);
 
+  measure_calls++;
+  if (found_in_cache)
+    measure_cache_hits++;
+
   if (!found_in_cache)
     {
       GtkWidgetClass *widget_class;
@@ -183,6 +192,7 @@ gtk_widget_query_size_for_orientation (GtkWidget        *widget,
       int css_extra_for_size;
       int css_extra_size;
       int widget_margins_for_size;
+      GtkWidgetCostFrame cost_frame;
 
       style = gtk_css_node_get_style (gtk_widget_get_css_node (widget));
       get_box_margin (style, &margin);
@@ -210,6 +220,8 @@ gtk_widget_query_size_for_orientation (GtkWidget        *widget,
 
       GtkLayoutManager *layout_manager = gtk_widget_get_layout_manager (widget);
 
+      gtk_widget_cost_begin (&cost_frame);
+
       if (layout_manager != NULL)
         {
           if (for_size < 0)
@@ -290,6 +302,8 @@ gtk_widget_query_size_for_orientation (GtkWidget        *widget,
             }
         }
 
+      gtk_widget_cost_end (&cost_frame, widget, GTK_WIDGET_COST_MEASURE);
+
       min_size = MAX (0, MAX (reported_min_size, css_min_size)) + css_extra_size;
       nat_size = MAX (0, MAX (reported_nat_size, css_min_size)) + css_extra_size;
 
@@ -543,6 +557,26 @@ gtk_widget_measure (GtkWidget        *widget,
     }
 }
 
+/* Called once per frame, after the layout phase */
+void
+gtk_widget_report_measure_counters (void)
+{
+  if (GDK_PROFILER_IS_RUNNING)
+    {
+      if (measure_calls_counter == 0)
+        {
+          measure_calls_counter = gdk_profiler_define_int_counter ("measure-calls", "Widget size queries");
+          measure_cache_hits_counter = gdk_profiler_define_int_counter ("measure-cache-hits", "Widget size queries answered from the cache");
+        }
+
+      gdk_profiler_set_int_counter (measure_calls_counter, measure_calls);
+      gdk_profiler_set_int_counter (measure_cache_hits_counter, measure_cache_hits);
+    }
+
+  measure_calls = 0;
+  measure_cache_hits = 0;
+}
+
 /**
  * gtk_widget_get_request_mode:
  * @widget: a #GtkWidget instance
@@ -69,6 +69,35 @@ _gtk_size_request_cache_clear (SizeRequestCache *cache)
   _gtk_size_request_cache_init (cache);
 }
 
+/* Moves the request at @i to the front, the requests before it
+ * move back by one. Keeps the array in most recently used order. */
+static void
+bump_request (gpointer *requests,
+              guint     i)
+{
+  gpointer request;
+
+  if (i == 0)
+    return;
+
+  request = requests[i];
+  memmove (requests + 1, requests, sizeof (gpointer) * i);
+  requests[0] = request;
+}
+
+/* Returns the index of the slot that a new result should go to.
+ * That is a free slot if there is one, and the least recently
+ * used one otherwise. */
+static guint
+pull_request (SizeRequestCache *cache,
+              GtkOrientation    orientation)
+{
+  if (cache->flags[orientation].n_cached_requests < GTK_SIZE_REQUEST_CACHED_SIZES)
+    cache->flags[orientation].n_cached_requests++;
+
+  return cache->flags[orientation].n_cached_requests - 1;
+}
+
 void
 _gtk_size_request_cache_commit (SizeRequestCache *cache,
                                 GtkOrientation    orientation,
@@ -125,31 +154,23 @@ _gtk_size_request_cache_commit (SizeRequestCache *cache,
 	    {
 	      cached_sizes[i]->lower_for_size = MIN (cached_sizes[i]->lower_for_size, for_size);
 	      cached_sizes[i]->upper_for_size = MAX (cached_sizes[i]->upper_for_size, for_size);
+	      bump_request ((gpointer *) cached_sizes, i);
 	      return;
 	    }
 	}
 
-      /* If not found, pull a new size from the cache, the returned size cache
-       * will immediately be used to cache the new computed size so we go ahead
-       * and increment the last_cached_request right away */
-      if (n_sizes < GTK_SIZE_REQUEST_CACHED_SIZES)
-	{
-	  cache->flags[orientation].n_cached_requests++;
-	  cache->flags[orientation].last_cached_request = cache->flags[orientation].n_cached_requests - 1;
-	}
-      else
-	{
-	  if (++cache->flags[orientation].last_cached_request == GTK_SIZE_REQUEST_CACHED_SIZES)
-	    cache->flags[orientation].last_cached_request = 0;
-	}
+      /* If not found, pull a new size from the cache, reusing the least
+       * recently used one if the cache is full */
+      i = pull_request (cache, orientation);
 
       if (cache->requests_x == NULL)
 	cache->requests_x = g_slice_alloc0 (sizeof (SizeRequestX *) * GTK_SIZE_REQUEST_CACHED_SIZES);
 
-      if (cache->requests_x[cache->flags[orientation].last_cached_request] == NULL)
-	cache->requests_x[cache->flags[orientation].last_cached_request] = g_slice_new (SizeRequestX);
+      if (cache->requests_x[i] == NULL)
+	cache->requests_x[i] = g_slice_new (SizeRequestX);
 
-      cached_size = cache->requests_x[cache->flags[orientation].last_cached_request];
+      bump_request ((gpointer *) cache->requests_x, i);
+      cached_size = cache->requests_x[0];
       cached_size->lower_for_size = for_size;
       cached_size->upper_for_size = for_size;
       cached_size->cached_size.minimum_size = minimum_size;
@@ -169,31 +190,23 @@ _gtk_size_request_cache_commit (SizeRequestCache *cache,
 	    {
 	      cached_sizes[i]->lower_for_size = MIN (cached_sizes[i]->lower_for_size, for_size);
 	      cached_sizes[i]->upper_for_size = MAX (cached_sizes[i]->upper_for_size, for_size);
+	      bump_request ((gpointer *) cached_sizes, i);
 	      return;
 	    }
 	}
 
-      /* If not found, pull a new size from the cache, the returned size cache
-       * will immediately be used to cache the new computed size so we go ahead
-       * and increment the last_cached_request right away */
-      if (n_sizes < GTK_SIZE_REQUEST_CACHED_SIZES)
-	{
-	  cache->flags[orientation].n_cached_requests++;
-	  cache->flags[orientation].last_cached_request = cache->flags[orientation].n_cached_requests - 1;
-	}
-      else
-	{
-	  if (++cache->flags[orientation].last_cached_request == GTK_SIZE_REQUEST_CACHED_SIZES)
-	    cache->flags[orientation].last_cached_request = 0;
-	}
+      /* If not found, pull a new size from the cache, reusing the least
+       * recently used one if the cache is full */
+      i = pull_request (cache, orientation);
 
       if (cache->requests_y == NULL)
 	cache->requests_y = g_slice_alloc0 (sizeof (SizeRequestY *) * GTK_SIZE_REQUEST_CACHED_SIZES);
 
-      if (cache->requests_y[cache->flags[orientation].last_cached_request] == NULL)
-	cache->requests_y[cache->flags[orientation].last_cached_request] = g_slice_new (SizeRequestY);
+      if (cache->requests_y[i] == NULL)
+	cache->requests_y[i] = g_slice_new (SizeRequestY);
 
-      cached_size = cache->requests_y[cache->flags[orientation].last_cached_request];
+      bump_request ((gpointer *) cache->requests_y, i);
+      cached_size = cache->requests_y[0];
       cached_size->lower_for_size = for_size;
       cached_size->upper_for_size = for_size;
       cached_size->cached_size.minimum_size = minimum_size;
@@ -204,18 +217,20 @@ _gtk_size_request_cache_commit (SizeRequestCache *cache,
 }
 
 /* looks for a cached size request for this for_size.
+ *
+ * A hit moves the request to the front, see bump_request().
  *
  * Note that this caching code was originally derived from
  * the Clutter toolkit but has evolved for other GTK requirements.
  */
 gboolean
-_gtk_size_request_cache_lookup (const SizeRequestCache *cache,
-                                GtkOrientation          orientation,
-                                int                     for_size,
-                                int                    *minimum,
-                                int                    *natural,
-                                int                    *minimum_baseline,
-                                int                    *natural_baseline)
+_gtk_size_request_cache_lookup (SizeRequestCache *cache,
+                                GtkOrientation    orientation,
+                                int               for_size,
+                                int              *minimum,
+                                int              *natural,
+                                int              *minimum_baseline,
+                                int              *natural_baseline)
 {
   guint i, p;
 
@@ -249,6 +264,7 @@ _gtk_size_request_cache_lookup (const SizeRequestCache *cache,
                   *minimum = result->minimum_size;
                   *natural = result->natural_size;
 
+                  bump_request ((gpointer *) cache->requests_x, i);
                   return TRUE;
                 }
             }
@@ -289,6 +305,8 @@ _gtk_size_request_cache_lookup (const SizeRequestCache *cache,
                   *natural = result->natural_size;
                   *minimum_baseline = result->minimum_baseline;
                   *natural_baseline = result->natural_baseline;
+
+                  bump_request ((gpointer *) cache->requests_y, i);
                   return TRUE;
                 }
             }
@@ -31,6 +31,7 @@
 #include "gsktransformprivate.h"
 
 #include "gsk/gskrendernodeprivate.h"
+#include "gdkprofilerprivate.h"
 
 #include "gtk/gskpango.h"
 
@@ -72,6 +73,10 @@ struct _GtkSnapshotState {
   guint                  n_nodes;
 
   GskTransform *         transform;
+  /* A 2D translation applied before transform, so that
+   * gtk_snapshot_translate() doesn't need to allocate */
+  float                  translate_x;
+  float                  translate_y;
 
   GtkSnapshotCollectFunc collect_func;
   GtkSnapshotClearFunc   clear_func;
@@ -156,6 +161,11 @@ struct _GtkSnapshotClass {
 
 G_DEFINE_TYPE (GtkSnapshot, gtk_snapshot, GDK_TYPE_SNAPSHOT)
 
+/* Nodes that were not created, or dropped, by folding since the last
+ * gtk_snapshot_to_node() */
+static int folded_nodes;
+static guint folded_nodes_counter;
+
 static void
 gtk_snapshot_dispose (GObject *object)
 {
@@ -176,6 +186,9 @@ gtk_snapshot_class_init (GtkSnapshotClass *klass)
   GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
 
   gobject_class->dispose = gtk_snapshot_dispose;
+
+  if (folded_nodes_counter == 0)
+    folded_nodes_counter = gdk_profiler_define_int_counter ("folded-nodes", "Render nodes folded by snapshots");
 }
 
 static void
@@ -183,30 +196,117 @@ gtk_snapshot_init (GtkSnapshot *self)
 {
 }
 
+/* Two color nodes of the same color can be drawn as one if they
+ * share an edge, and together make up a rectangle. */
+static gboolean
+color_nodes_can_merge (GskRenderNode   *node1,
+                       GskRenderNode   *node2,
+                       graphene_rect_t *merged)
+{
+  const graphene_rect_t *r1, *r2;
+
+  if (gsk_render_node_get_node_type (node1) != GSK_COLOR_NODE ||
+      gsk_render_node_get_node_type (node2) != GSK_COLOR_NODE ||
+      !gdk_rgba_equal (gsk_color_node_get_color (node1), gsk_color_node_get_color (node2)))
+    return FALSE;
+
+  r1 = &node1->bounds;
+  r2 = &node2->bounds;
+
+  if (r1->origin.y == r2->origin.y && r1->size.height == r2->size.height &&
+      (r1->origin.x + r1->size.width == r2->origin.x ||
+       r2->origin.x + r2->size.width == r1->origin.x))
+    {
+      graphene_rect_union (r1, r2, merged);
+      return TRUE;
+    }
+
+  if (r1->origin.x == r2->origin.x && r1->size.width == r2->size.width &&
+      (r1->origin.y + r1->size.height == r2->origin.y ||
+       r2->origin.y + r2->size.height == r1->origin.y))
+    {
+      graphene_rect_union (r1, r2, merged);
+      return TRUE;
+    }
+
+  return FALSE;
+}
+
 static GskRenderNode *
 gtk_snapshot_collect_default (GtkSnapshot       *snapshot,
                               GtkSnapshotState  *state,
                               GskRenderNode    **nodes,
                               guint              n_nodes)
 {
+  GskRenderNode **children;
   GskRenderNode *node;
+  guint i, n_children;
 
   if (n_nodes == 0)
+    return NULL;
+
+  if (n_nodes == 1)
     {
-      node = NULL;
+      folded_nodes++;
+      return gsk_render_node_ref (nodes[0]);
     }
-  else if (n_nodes == 1)
+
+  /* Drop empty containers and merge runs of color nodes
+   * that fill a rectangle together */
+  children = g_new (GskRenderNode *, n_nodes);
+  n_children = 0;
+
+  for (i = 0; i < n_nodes; i++)
     {
-      node = gsk_render_node_ref (nodes[0]);
+      GskRenderNode *child = nodes[i];
+      graphene_rect_t merged;
+
+      if (gsk_render_node_get_node_type (child) == GSK_CONTAINER_NODE &&
+          gsk_container_node_get_n_children (child) == 0)
+        {
+          folded_nodes++;
+          continue;
+        }
+
+      if (n_children > 0 &&
+          color_nodes_can_merge (children[n_children - 1], child, &merged))
+        {
+          GskRenderNode *prev = children[n_children - 1];
+
+          children[n_children - 1] = gsk_color_node_new (gsk_color_node_get_color (prev), &merged);
+          gsk_render_node_unref (prev);
+          folded_nodes++;
+          continue;
+        }
+
+      children[n_children++] = gsk_render_node_ref (child);
     }
+
+  if (n_children == 0)
+    node = NULL;
+  else if (n_children == 1)
+    node = gsk_render_node_ref (children[0]);
   else
-    {
-      node = gsk_container_node_new (nodes, n_nodes);
-    }
+    node = gsk_container_node_new (children, n_children);
+
+  for (i = 0; i < n_children; i++)
+    gsk_render_node_unref (children[i]);
+  g_free (children);
 
   return node;
 }
 
+static guint n_states_pushed;
+
+/* The number of states pushed so far, see
+ * gsk_render_node_get_n_allocated()
+ */
+guint
+gtk_snapshot_get_n_states_pushed (void)
+{
+  return n_states_pushed;
+}
+
 static GtkSnapshotState *
 gtk_snapshot_push_state (GtkSnapshot            *snapshot,
                          GskTransform           *transform,
@@ -216,10 +316,14 @@ gtk_snapshot_push_state (GtkSnapshot            *snapshot,
   const gsize n_states = gtk_snapshot_states_get_size (&snapshot->state_stack);
   GtkSnapshotState *state;
 
+  n_states_pushed++;
+
   gtk_snapshot_states_set_size (&snapshot->state_stack, n_states + 1);
   state = gtk_snapshot_states_get (&snapshot->state_stack, n_states);
 
   state->transform = gsk_transform_ref (transform);
+  state->translate_x = 0;
+  state->translate_y = 0;
   state->collect_func = collect_func;
   state->clear_func = clear_func;
   state->start_node_index = gtk_snapshot_nodes_get_size (&snapshot->nodes);
@@ -238,6 +342,41 @@ gtk_snapshot_get_current_state (const GtkSnapshot *snapshot)
   return gtk_snapshot_states_get (&snapshot->state_stack, size - 1);
 }
 
+/* Pushes a state that keeps the coordinate system of the current one */
+static GtkSnapshotState *
+gtk_snapshot_push_child_state (GtkSnapshot            *snapshot,
+                               GtkSnapshotCollectFunc  collect_func,
+                               GtkSnapshotClearFunc    clear_func)
+{
+  const GtkSnapshotState *current_state = gtk_snapshot_get_current_state (snapshot);
+  GskTransform *transform = current_state->transform;
+  float translate_x = current_state->translate_x;
+  float translate_y = current_state->translate_y;
+  GtkSnapshotState *state;
+
+  state = gtk_snapshot_push_state (snapshot, transform, collect_func, clear_func);
+  state->translate_x = translate_x;
+  state->translate_y = translate_y;
+
+  return state;
+}
+
+/* Folds the pending translation into the transform of @state */
+static GskTransform *
+gtk_snapshot_state_get_transform (GtkSnapshotState *state)
+{
+  if (state->translate_x != 0 || state->translate_y != 0)
+    {
+      state->transform = gsk_transform_translate (state->transform,
+                                                  &GRAPHENE_POINT_INIT (state->translate_x,
+                                                                        state->translate_y));
+      state->translate_x = 0;
+      state->translate_y = 0;
+    }
+
+  return state->transform;
+}
+
 static GtkSnapshotState *
 gtk_snapshot_get_previous_state (const GtkSnapshot *snapshot)
 {
@@ -352,7 +491,29 @@ gtk_snapshot_collect_autopush_transform (GtkSnapshot      *snapshot,
   if (node == NULL)
     return NULL;
 
-  transform_node = gsk_transform_node_new (node, previous_state->transform);
+  /* Fold a translation into a translated child, like the ones
+   * widgets create for their children */
+  if (gsk_render_node_get_node_type (node) == GSK_TRANSFORM_NODE &&
+      gsk_transform_get_category (gtk_snapshot_state_get_transform (previous_state)) >= GSK_TRANSFORM_CATEGORY_2D_TRANSLATE &&
+      gsk_transform_get_category (gsk_transform_node_get_transform (node)) >= GSK_TRANSFORM_CATEGORY_2D_TRANSLATE)
+    {
+      GskTransform *transform;
+
+      transform = gsk_transform_transform (gsk_transform_ref (previous_state->transform),
+                                           gsk_transform_node_get_transform (node));
+      if (gsk_transform_get_category (transform) == GSK_TRANSFORM_CATEGORY_IDENTITY)
+        transform_node = gsk_render_node_ref (gsk_transform_node_get_child (node));
+      else
+        transform_node = gsk_transform_node_new (gsk_transform_node_get_child (node), transform);
+
+      gsk_transform_unref (transform);
+      gsk_render_node_unref (node);
+      folded_nodes++;
+
+      return transform_node;
+    }
+
+  transform_node = gsk_transform_node_new (node, gtk_snapshot_state_get_transform (previous_state));
 
   gsk_render_node_unref (node);
 
@@ -415,17 +576,15 @@ gtk_snapshot_push_debug (GtkSnapshot *snapshot,
                          const char  *message,
                          ...)
 {
-  GtkSnapshotState *current_state = gtk_snapshot_get_current_state (snapshot);
 
   if (GTK_DEBUG_CHECK (SNAPSHOT))
     {
       va_list args;
       GtkSnapshotState *state;
 
-      state = gtk_snapshot_push_state (snapshot,
-                                       current_state->transform,
-                                       gtk_snapshot_collect_debug,
-                                       gtk_snapshot_clear_debug);
+      state = gtk_snapshot_push_child_state (snapshot,
+                                             gtk_snapshot_collect_debug,
+                                             gtk_snapshot_clear_debug);
 
 
 
@@ -435,10 +594,9 @@ gtk_snapshot_push_debug (GtkSnapshot *snapshot,
     }
   else
     {
-      gtk_snapshot_push_state (snapshot,
-                               current_state->transform,
-                               gtk_snapshot_collect_default,
-                               NULL);
+      gtk_snapshot_push_child_state (snapshot,
+                                     gtk_snapshot_collect_default,
+                                     NULL);
     }
 }
 
@@ -457,11 +615,13 @@ gtk_snapshot_collect_opacity (GtkSnapshot      *snapshot,
   if (state->data.opacity.opacity == 1.0)
     {
       opacity_node = node;
+      folded_nodes++;
     }
   else if (state->data.opacity.opacity == 0.0)
     {
       gsk_render_node_unref (node);
       opacity_node = NULL;
+      folded_nodes++;
     }
   else
     {
@@ -485,13 +645,11 @@ void
 gtk_snapshot_push_opacity (GtkSnapshot *snapshot,
                            double       opacity)
 {
-  GtkSnapshotState *current_state = gtk_snapshot_get_current_state (snapshot);
   GtkSnapshotState *state;
 
-  state = gtk_snapshot_push_state (snapshot,
-                                   current_state->transform,
-                                   gtk_snapshot_collect_opacity,
-                                   NULL);
+  state = gtk_snapshot_push_child_state (snapshot,
+                                         gtk_snapshot_collect_opacity,
+                                         NULL);
   state->data.opacity.opacity = CLAMP (opacity, 0.0, 1.0);
 }
 
@@ -533,13 +691,11 @@ void
 gtk_snapshot_push_blur (GtkSnapshot *snapshot,
                         double       radius)
 {
-  const GtkSnapshotState *current_state = gtk_snapshot_get_current_state (snapshot);
   GtkSnapshotState *state;
 
-  state = gtk_snapshot_push_state (snapshot,
-                                   current_state->transform,
-                                   gtk_snapshot_collect_blur,
-                                   NULL);
+  state = gtk_snapshot_push_child_state (snapshot,
+                                         gtk_snapshot_collect_blur,
+                                         NULL);
   state->data.blur.radius = radius;
 }
 
@@ -644,13 +800,11 @@ gtk_snapshot_push_color_matrix (GtkSnapshot             *snapshot,
                                 const graphene_matrix_t *color_matrix,
                                 const graphene_vec4_t   *color_offset)
 {
-  const GtkSnapshotState *current_state = gtk_snapshot_get_current_state (snapshot);
   GtkSnapshotState *state;
 
-  state = gtk_snapshot_push_state (snapshot,
-                                   current_state->transform,
-                                   gtk_snapshot_collect_color_matrix,
-                                   NULL);
+  state = gtk_snapshot_push_child_state (snapshot,
+                                         gtk_snapshot_collect_color_matrix,
+                                         NULL);
 
   graphene_matrix_init_from_matrix (&state->data.color_matrix.matrix, color_matrix);
   graphene_vec4_init_from_vec4 (&state->data.color_matrix.offset, color_offset);
@@ -760,6 +914,9 @@ gtk_snapshot_ensure_affine (GtkSnapshot *snapshot,
     {
       gsk_transform_to_affine (state->transform, scale_x, scale_y, dx, dy);
     }
+
+  *dx += *scale_x * state->translate_x;
+  *dy += *scale_y * state->translate_y;
 }
 
 static void
@@ -776,6 +933,8 @@ gtk_snapshot_ensure_translate (GtkSnapshot *snapshot,
     }
   
   gsk_transform_to_translate (state->transform, dx, dy);
+  *dx += state->translate_x;
+  *dy += state->translate_y;
 }
 
 static void
@@ -783,7 +942,8 @@ gtk_snapshot_ensure_identity (GtkSnapshot *snapshot)
 {
   const GtkSnapshotState *state = gtk_snapshot_get_current_state (snapshot);
 
-  if (gsk_transform_get_category (state->transform) < GSK_TRANSFORM_CATEGORY_IDENTITY)
+  if (gsk_transform_get_category (state->transform) < GSK_TRANSFORM_CATEGORY_IDENTITY ||
+      state->translate_x != 0 || state->translate_y != 0)
     gtk_snapshot_autopush_transform (snapshot);
 }
 
@@ -812,10 +972,9 @@ gtk_snapshot_push_repeat (GtkSnapshot           *snapshot,
   if (child_bounds)
     gtk_graphene_rect_scale_affine (child_bounds, scale_x, scale_y, dx, dy, &real_child_bounds);
 
-  state = gtk_snapshot_push_state (snapshot,
-                                   gtk_snapshot_get_current_state (snapshot)->transform,
-                                   gtk_snapshot_collect_repeat,
-                                   NULL);
+  state = gtk_snapshot_push_child_state (snapshot,
+                                         gtk_snapshot_collect_repeat,
+                                         NULL);
 
   gtk_graphene_rect_scale_affine (bounds, scale_x, scale_y, dx, dy, &state->data.repeat.bounds);
   state->data.repeat.child_bounds = real_child_bounds;
@@ -835,7 +994,10 @@ gtk_snapshot_collect_clip (GtkSnapshot      *snapshot,
 
   /* Check if the child node will even be clipped */
   if (graphene_rect_contains_rect (&state->data.clip.bounds, &node->bounds))
-    return node;
+    {
+      folded_nodes++;
+      return node;
+    }
 
   if (state->data.clip.bounds.size.width == 0 ||
       state->data.clip.bounds.size.height == 0)
@@ -866,10 +1028,9 @@ gtk_snapshot_push_clip (GtkSnapshot           *snapshot,
  
   gtk_snapshot_ensure_affine (snapshot, &scale_x, &scale_y, &dx, &dy);
 
-  state = gtk_snapshot_push_state (snapshot,
-                                   gtk_snapshot_get_current_state (snapshot)->transform,
-                                   gtk_snapshot_collect_clip,
-                                   NULL);
+  state = gtk_snapshot_push_child_state (snapshot,
+                                         gtk_snapshot_collect_clip,
+                                         NULL);
 
   gtk_graphene_rect_scale_affine (bounds, scale_x, scale_y, dx, dy, &state->data.clip.bounds);
 }
@@ -1009,10 +1170,9 @@ gtk_snapshot_push_gl_shader (GtkSnapshot           *snapshot,
 
   gtk_snapshot_ensure_affine (snapshot, &scale_x, &scale_y, &dx, &dy);
 
-  state = gtk_snapshot_push_state (snapshot,
-                                   gtk_snapshot_get_current_state (snapshot)->transform,
-                                   gtk_snapshot_collect_gl_shader,
-                                   gtk_snapshot_clear_gl_shader);
+  state = gtk_snapshot_push_child_state (snapshot,
+                                         gtk_snapshot_collect_gl_shader,
+                                         gtk_snapshot_clear_gl_shader);
   gtk_graphene_rect_scale_affine (bounds, scale_x, scale_y, dx, dy, &transformed_bounds);
   state->data.glshader.bounds = transformed_bounds;
   state->data.glshader.shader = g_object_ref (shader);
@@ -1024,10 +1184,9 @@ gtk_snapshot_push_gl_shader (GtkSnapshot           *snapshot,
 
   for (int i = 0; i  < n_children; i++)
     {
-      state = gtk_snapshot_push_state (snapshot,
-                                       gtk_snapshot_get_current_state (snapshot)->transform,
-                                       gtk_snapshot_collect_gl_shader_texture,
-                                       NULL);
+      state = gtk_snapshot_push_child_state (snapshot,
+                                             gtk_snapshot_collect_gl_shader_texture,
+                                             NULL);
       state->data.glshader_texture.bounds = transformed_bounds;
       state->data.glshader_texture.node_idx = n_children - 1 - i;/* We pop in reverse order */
       state->data.glshader_texture.n_children = n_children;
@@ -1051,14 +1210,20 @@ gtk_snapshot_collect_rounded_clip (GtkSnapshot      *snapshot,
     {
       /* ... and do the same optimization */
       if (graphene_rect_contains_rect (&state->data.rounded_clip.bounds.bounds, &node->bounds))
-        return node;
+        {
+          folded_nodes++;
+          return node;
+        }
 
       clip_node = gsk_clip_node_new (node, &state->data.rounded_clip.bounds.bounds);
     }
   else
     {
       if (gsk_rounded_rect_contains_rect (&state->data.rounded_clip.bounds, &node->bounds))
-        return node;
+        {
+          folded_nodes++;
+          return node;
+        }
 
       clip_node = gsk_rounded_clip_node_new (node, &state->data.rounded_clip.bounds);
     }
@@ -1094,10 +1259,9 @@ gtk_snapshot_push_rounded_clip (GtkSnapshot          *snapshot,
 
   gtk_snapshot_ensure_affine (snapshot, &scale_x, &scale_y, &dx, &dy);
 
-  state = gtk_snapshot_push_state (snapshot,
-                                   gtk_snapshot_get_current_state (snapshot)->transform,
-                                   gtk_snapshot_collect_rounded_clip,
-                                   NULL);
+  state = gtk_snapshot_push_child_state (snapshot,
+                                         gtk_snapshot_collect_rounded_clip,
+                                         NULL);
 
   gtk_rounded_rect_scale_affine (&state->data.rounded_clip.bounds, bounds, scale_x, scale_y, dx, dy);
 }
@@ -1146,13 +1310,11 @@ gtk_snapshot_push_shadow (GtkSnapshot     *snapshot,
                           const GskShadow *shadow,
                           gsize            n_shadows)
 {
-  const GtkSnapshotState *current_state = gtk_snapshot_get_current_state (snapshot);
   GtkSnapshotState *state;
 
-  state = gtk_snapshot_push_state (snapshot,
-                                   current_state->transform,
-                                   gtk_snapshot_collect_shadow,
-                                   gtk_snapshot_clear_shadow);
+  state = gtk_snapshot_push_child_state (snapshot,
+                                         gtk_snapshot_collect_shadow,
+                                         gtk_snapshot_clear_shadow);
 
   state->data.shadow.n_shadows = n_shadows;
   if (n_shadows == 1)
@@ -1236,19 +1398,16 @@ void
 gtk_snapshot_push_blend (GtkSnapshot  *snapshot,
                          GskBlendMode  blend_mode)
 {
-  GtkSnapshotState *current_state = gtk_snapshot_get_current_state (snapshot);
   GtkSnapshotState *top_state;
 
-  top_state = gtk_snapshot_push_state (snapshot,
-                                       current_state->transform,
-                                       gtk_snapshot_collect_blend_top,
-                                       gtk_snapshot_clear_blend_top);
+  top_state = gtk_snapshot_push_child_state (snapshot,
+                                             gtk_snapshot_collect_blend_top,
+                                             gtk_snapshot_clear_blend_top);
   top_state->data.blend.blend_mode = blend_mode;
 
-  gtk_snapshot_push_state (snapshot,
-                           top_state->transform,
-                           gtk_snapshot_collect_blend_bottom,
-                           NULL);
+  gtk_snapshot_push_child_state (snapshot,
+                                 gtk_snapshot_collect_blend_bottom,
+                                 NULL);
 }
 
 static GskRenderNode *
@@ -1343,19 +1502,16 @@ void
 gtk_snapshot_push_cross_fade (GtkSnapshot *snapshot,
                               double       progress)
 {
-  const GtkSnapshotState *current_state = gtk_snapshot_get_current_state (snapshot);
   GtkSnapshotState *end_state;
 
-  end_state = gtk_snapshot_push_state (snapshot,
-                                       current_state->transform,
-                                       gtk_snapshot_collect_cross_fade_end,
-                                       gtk_snapshot_clear_cross_fade_end);
+  end_state = gtk_snapshot_push_child_state (snapshot,
+                                             gtk_snapshot_collect_cross_fade_end,
+                                             gtk_snapshot_clear_cross_fade_end);
   end_state->data.cross_fade.progress = progress;
 
-  gtk_snapshot_push_state (snapshot,
-                           end_state->transform,
-                           gtk_snapshot_collect_cross_fade_start,
-                           NULL);
+  gtk_snapshot_push_child_state (snapshot,
+                                 gtk_snapshot_collect_cross_fade_start,
+                                 NULL);
 }
 
 static GskRenderNode *
@@ -1506,6 +1662,12 @@ gtk_snapshot_to_node (GtkSnapshot *snapshot)
   gtk_snapshot_states_clear (&snapshot->state_stack);
   gtk_snapshot_nodes_clear (&snapshot->nodes);
 
+  if (GDK_PROFILER_IS_RUNNING)
+    {
+      gdk_profiler_set_int_counter (folded_nodes_counter, folded_nodes);
+      folded_nodes = 0;
+    }
+
   return result;
 }
 
@@ -1621,10 +1783,7 @@ gtk_snapshot_save (GtkSnapshot *snapshot)
 {
   g_return_if_fail (GTK_IS_SNAPSHOT (snapshot));
 
-  gtk_snapshot_push_state (snapshot,
-                           gtk_snapshot_get_current_state (snapshot)->transform,
-                           NULL,
-                           NULL);
+  gtk_snapshot_push_child_state (snapshot, NULL, NULL);
 }
 
 /**
@@ -1676,7 +1835,7 @@ gtk_snapshot_transform (GtkSnapshot  *snapshot,
   g_return_if_fail (GTK_IS_SNAPSHOT (snapshot));
 
   state = gtk_snapshot_get_current_state (snapshot);
-  state->transform = gsk_transform_transform (state->transform, transform);
+  state->transform = gsk_transform_transform (gtk_snapshot_state_get_transform (state), transform);
 }
 
 /**
@@ -1696,7 +1855,7 @@ gtk_snapshot_transform_matrix (GtkSnapshot             *snapshot,
   g_return_if_fail (matrix != NULL);
 
   state = gtk_snapshot_get_current_state (snapshot);
-  state->transform = gsk_transform_matrix (state->transform, matrix);
+  state->transform = gsk_transform_matrix (gtk_snapshot_state_get_transform (state), matrix);
 }
 
 /**
@@ -1716,7 +1875,8 @@ gtk_snapshot_translate (GtkSnapshot            *snapshot,
   g_return_if_fail (point != NULL);
 
   state = gtk_snapshot_get_current_state (snapshot);
-  state->transform = gsk_transform_translate (state->transform, point);
+  state->translate_x += point->x;
+  state->translate_y += point->y;
 }
 
 /**
@@ -1736,7 +1896,7 @@ gtk_snapshot_translate_3d (GtkSnapshot              *snapshot,
   g_return_if_fail (point != NULL);
 
   state = gtk_snapshot_get_current_state (snapshot);
-  state->transform = gsk_transform_translate_3d (state->transform, point);
+  state->transform = gsk_transform_translate_3d (gtk_snapshot_state_get_transform (state), point);
 }
 
 /**
@@ -1756,7 +1916,7 @@ gtk_snapshot_rotate (GtkSnapshot *snapshot,
   g_return_if_fail (GTK_IS_SNAPSHOT (snapshot));
 
   state = gtk_snapshot_get_current_state (snapshot);
-  state->transform = gsk_transform_rotate (state->transform, angle);
+  state->transform = gsk_transform_rotate (gtk_snapshot_state_get_transform (state), angle);
 }
 
 /**
@@ -1780,7 +1940,7 @@ gtk_snapshot_rotate_3d (GtkSnapshot           *snapshot,
   g_return_if_fail (axis != NULL);
 
   state = gtk_snapshot_get_current_state (snapshot);
-  state->transform = gsk_transform_rotate_3d (state->transform, angle, axis);
+  state->transform = gsk_transform_rotate_3d (gtk_snapshot_state_get_transform (state), angle, axis);
 }
 
 /**
@@ -1804,7 +1964,7 @@ gtk_snapshot_scale (GtkSnapshot *snapshot,
   g_return_if_fail (GTK_IS_SNAPSHOT (snapshot));
 
   state = gtk_snapshot_get_current_state (snapshot);
-  state->transform = gsk_transform_scale (state->transform, factor_x, factor_y);
+  state->transform = gsk_transform_scale (gtk_snapshot_state_get_transform (state), factor_x, factor_y);
 }
 
 /**
@@ -1827,7 +1987,7 @@ gtk_snapshot_scale_3d (GtkSnapshot *snapshot,
   g_return_if_fail (GTK_IS_SNAPSHOT (snapshot));
 
   state = gtk_snapshot_get_current_state (snapshot);
-  state->transform = gsk_transform_scale_3d (state->transform, factor_x, factor_y, factor_z);
+  state->transform = gsk_transform_scale_3d (gtk_snapshot_state_get_transform (state), factor_x, factor_y, factor_z);
 }
 
 /**
@@ -1848,7 +2008,7 @@ gtk_snapshot_perspective (GtkSnapshot *snapshot,
   g_return_if_fail (GTK_IS_SNAPSHOT (snapshot));
 
   state = gtk_snapshot_get_current_state (snapshot);
-  state->transform = gsk_transform_perspective (state->transform, depth);
+  state->transform = gsk_transform_perspective (gtk_snapshot_state_get_transform (state), depth);
 }
 
 /**
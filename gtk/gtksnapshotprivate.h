@@ -34,6 +34,8 @@ void                    gtk_snapshot_append_text                (GtkSnapshot
 void                    gtk_snapshot_push_collect               (GtkSnapshot            *snapshot);
 GskRenderNode *         gtk_snapshot_pop_collect                (GtkSnapshot            *snapshot);
 
+guint                   gtk_snapshot_get_n_states_pushed        (void);
+
 G_END_DECLS
 
 #endif /* __GTK_SNAPSHOT_PRIVATE_H__ */
@@ -95,6 +95,12 @@ gtk_sort_keys_needs_clear_key (GtkSortKeys *self)
   return self->klass->clear_key != NULL;
 }
 
+gboolean
+gtk_sort_keys_is_thread_safe (GtkSortKeys *self)
+{
+  return self->thread_safe;
+}
+
 static void
 gtk_equal_sort_keys_free (GtkSortKeys *keys)
 {
@@ -143,8 +149,223 @@ static const GtkSortKeysClass GTK_EQUAL_SORT_KEYS_CLASS =
 GtkSortKeys *
 gtk_sort_keys_new_equal (void)
 {
-  return gtk_sort_keys_new (GtkSortKeys,
-                            &GTK_EQUAL_SORT_KEYS_CLASS,
-                            0, 1);
+  GtkSortKeys *result;
+
+  result = gtk_sort_keys_new (GtkSortKeys,
+                              &GTK_EQUAL_SORT_KEYS_CLASS,
+                              0, 1);
+  result->thread_safe = TRUE;
+
+  return result;
+}
+
+typedef struct _GtkCompositeSortKey GtkCompositeSortKey;
+typedef struct _GtkCompositeSortKeys GtkCompositeSortKeys;
+
+struct _GtkCompositeSortKey
+{
+  gsize offset;
+  GtkSortKeys *keys;
+  gboolean inverted;
+};
+
+struct _GtkCompositeSortKeys
+{
+  GtkSortKeys parent_keys;
+
+  gsize n_keys;
+  GtkCompositeSortKey keys[];
+};
+
+static void
+gtk_composite_sort_keys_free (GtkSortKeys *keys)
+{
+  GtkCompositeSortKeys *self = (GtkCompositeSortKeys *) keys;
+  gsize i;
+
+  for (i = 0; i < self->n_keys; i++)
+    gtk_sort_keys_unref (self->keys[i].keys);
+
+  g_slice_free1 (sizeof (GtkCompositeSortKeys) + self->n_keys * sizeof (GtkCompositeSortKey), self);
+}
+
+static int
+gtk_composite_sort_keys_compare (gconstpointer a,
+                                 gconstpointer b,
+                                 gpointer      data)
+{
+  GtkCompositeSortKeys *self = (GtkCompositeSortKeys *) data;
+  gsize i;
+
+  for (i = 0; i < self->n_keys; i++)
+    {
+      GtkOrdering result = gtk_sort_keys_compare (self->keys[i].keys,
+                                                  ((const char *) a) + self->keys[i].offset,
+                                                  ((const char *) b) + self->keys[i].offset);
+      if (result != GTK_ORDERING_EQUAL)
+        return self->keys[i].inverted ? - result : result;
+    }
+
+  return GTK_ORDERING_EQUAL;
+}
+
+static gboolean
+gtk_composite_sort_keys_is_compatible (GtkSortKeys *keys,
+                                       GtkSortKeys *other)
+{
+  GtkCompositeSortKeys *self = (GtkCompositeSortKeys *) keys;
+  GtkCompositeSortKeys *compare = (GtkCompositeSortKeys *) other;
+  gsize i;
+
+  if (keys->klass != other->klass)
+    return FALSE;
+
+  if (self->n_keys != compare->n_keys)
+    return FALSE;
+
+  for (i = 0; i < self->n_keys; i++)
+    {
+      if (self->keys[i].inverted != compare->keys[i].inverted ||
+          !gtk_sort_keys_is_compatible (self->keys[i].keys, compare->keys[i].keys))
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
+static void
+gtk_composite_sort_keys_init_key (GtkSortKeys *keys,
+                                  gpointer     item,
+                                  gpointer     key_memory)
+{
+  GtkCompositeSortKeys *self = (GtkCompositeSortKeys *) keys;
+  char *key = (char *) key_memory;
+  gsize i;
+
+  for (i = 0; i < self->n_keys; i++)
+    gtk_sort_keys_init_key (self->keys[i].keys, item, key + self->keys[i].offset);
+}
+
+static void
+gtk_composite_sort_keys_clear_key (GtkSortKeys *keys,
+                                   gpointer     key_memory)
+{
+  GtkCompositeSortKeys *self = (GtkCompositeSortKeys *) keys;
+  char *key = (char *) key_memory;
+  gsize i;
+
+  for (i = 0; i < self->n_keys; i++)
+    gtk_sort_keys_clear_key (self->keys[i].keys, key + self->keys[i].offset);
+}
+
+static const GtkSortKeysClass GTK_COMPOSITE_SORT_KEYS_CLASS =
+{
+  gtk_composite_sort_keys_free,
+  gtk_composite_sort_keys_compare,
+  gtk_composite_sort_keys_is_compatible,
+  gtk_composite_sort_keys_init_key,
+  gtk_composite_sort_keys_clear_key,
+};
+
+static void
+gtk_composite_sort_keys_append (GtkCompositeSortKeys *self,
+                                GtkSortKeys          *keys,
+                                gboolean              inverted)
+{
+  GtkSortKeys *parent = (GtkSortKeys *) self;
+  GtkCompositeSortKey *key = &self->keys[self->n_keys];
+
+  key->keys = gtk_sort_keys_ref (keys);
+  key->inverted = inverted;
+  key->offset = GTK_SORT_KEYS_ALIGN (parent->key_size, gtk_sort_keys_get_key_align (keys));
+  parent->key_size = key->offset + gtk_sort_keys_get_key_size (keys);
+  parent->key_align = MAX (parent->key_align, gtk_sort_keys_get_key_align (keys));
+  parent->thread_safe &= gtk_sort_keys_is_thread_safe (keys);
+  self->n_keys++;
 }
 
+/*<private>
+ * gtk_sort_keys_new_composite:
+ * @keys: (array length=n_keys) (transfer full): the keys to combine
+ * @inverted: (array length=n_keys) (nullable): whether to invert
+ *   the order of each of the @keys
+ * @n_keys: the number of keys
+ *
+ * Creates a new #GtkSortKeys that compares with each of @keys in
+ * turn, until one of them does not compare as equal.
+ *
+ * The result is kept flat, so that comparing does not need to go
+ * through several levels of composite keys: Composite keys in @keys
+ * are merged into the result and keys that compare everything as
+ * equal are dropped.
+ *
+ * Returns: a new #GtkSortKeys
+ **/
+GtkSortKeys *
+gtk_sort_keys_new_composite (GtkSortKeys    **keys,
+                             const gboolean  *inverted,
+                             gsize            n_keys)
+{
+  GtkCompositeSortKeys *self;
+  GtkSortKeys *result;
+  gsize i, j, n_leaves;
+
+  n_leaves = 0;
+  for (i = 0; i < n_keys; i++)
+    {
+      if (keys[i]->klass == &GTK_COMPOSITE_SORT_KEYS_CLASS)
+        n_leaves += ((GtkCompositeSortKeys *) keys[i])->n_keys;
+      else if (keys[i]->klass != &GTK_EQUAL_SORT_KEYS_CLASS)
+        n_leaves += 1;
+    }
+
+  if (n_leaves == 1)
+    {
+      for (i = 0; i < n_keys; i++)
+        {
+          if (keys[i]->klass != &GTK_EQUAL_SORT_KEYS_CLASS &&
+              keys[i]->klass != &GTK_COMPOSITE_SORT_KEYS_CLASS &&
+              (inverted == NULL || !inverted[i]))
+            {
+              result = gtk_sort_keys_ref (keys[i]);
+              goto out;
+            }
+        }
+    }
+  else if (n_leaves == 0)
+    {
+      result = gtk_sort_keys_new_equal ();
+      goto out;
+    }
+
+  result = gtk_sort_keys_alloc (&GTK_COMPOSITE_SORT_KEYS_CLASS,
+                                sizeof (GtkCompositeSortKeys) + n_leaves * sizeof (GtkCompositeSortKey),
+                                0, 1);
+  result->thread_safe = TRUE;
+  self = (GtkCompositeSortKeys *) result;
+
+  for (i = 0; i < n_keys; i++)
+    {
+      gboolean invert = inverted != NULL && inverted[i];
+
+      if (keys[i]->klass == &GTK_COMPOSITE_SORT_KEYS_CLASS)
+        {
+          GtkCompositeSortKeys *composite = (GtkCompositeSortKeys *) keys[i];
+
+          for (j = 0; j < composite->n_keys; j++)
+            gtk_composite_sort_keys_append (self,
+                                            composite->keys[j].keys,
+                                            composite->keys[j].inverted != invert);
+        }
+      else if (keys[i]->klass != &GTK_EQUAL_SORT_KEYS_CLASS)
+        {
+          gtk_composite_sort_keys_append (self, keys[i], invert);
+        }
+    }
+
+out:
+  for (i = 0; i < n_keys; i++)
+    gtk_sort_keys_unref (keys[i]);
+
+  return result;
+}
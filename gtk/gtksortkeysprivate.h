@@ -32,6 +32,7 @@ struct _GtkSortKeys
 
   gsize key_size;
   gsize key_align; /* must be power of 2 */
+  gboolean thread_safe; /* init_key() and comparing can run in other threads */
 };
 
 struct _GtkSortKeysClass
@@ -60,6 +61,9 @@ GtkSortKeys *           gtk_sort_keys_ref                       (GtkSortKeys
 void                    gtk_sort_keys_unref                     (GtkSortKeys            *self);
 
 GtkSortKeys *           gtk_sort_keys_new_equal                 (void);
+GtkSortKeys *           gtk_sort_keys_new_composite             (GtkSortKeys           **keys,
+                                                                 const gboolean         *inverted,
+                                                                 gsize                   n_keys);
 
 gsize                   gtk_sort_keys_get_key_size              (GtkSortKeys            *self);
 gsize                   gtk_sort_keys_get_key_align             (GtkSortKeys            *self);
@@ -67,6 +71,7 @@ GCompareDataFunc        gtk_sort_keys_get_key_compare_func      (GtkSortKeys
 gboolean                gtk_sort_keys_is_compatible             (GtkSortKeys            *self,
                                                                  GtkSortKeys            *other);
 gboolean                gtk_sort_keys_needs_clear_key           (GtkSortKeys            *self);
+gboolean                gtk_sort_keys_is_thread_safe            (GtkSortKeys            *self);
 
 #define GTK_SORT_KEYS_ALIGN(_size,_align) (((_size) + (_align) - 1) & ~((_align) - 1))
 static inline int
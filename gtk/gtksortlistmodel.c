@@ -22,6 +22,7 @@
 #include "gtksortlistmodel.h"
 
 #include "gtkbitset.h"
+#include "gtkincrementalprivate.h"
 #include "gtkintl.h"
 #include "gtkprivate.h"
 #include "gtksorterprivate.h"
@@ -42,16 +43,6 @@
  */
 #define GTK_SORT_MAX_MERGE_SIZE (1024)
 
-/* Time we spend in the sort callback before returning to the main loop
- *
- * Increasing this number will make the callback take longer and potentially
- * reduce responsiveness of an application, but will increase the amount of
- * work done per step. And we emit an ::items-changed() signal after every
- * step, so if we can avoid that, we recuce the overhead in the list widget
- * and in turn reduce the total sort time.
- */
-#define GTK_SORT_STEP_TIME_US (1000) /* 1 millisecond */
-
 /**
  * SECTION:gtksortlistmodel
  * @title: GtkSortListModel
@@ -195,7 +186,7 @@ gtk_sort_list_model_stop_sorting (GtkSortListModel *self,
   if (runs)
     gtk_tim_sort_get_runs (&self->sort, runs);
   gtk_tim_sort_finish (&self->sort);
-  g_clear_handle_id (&self->sort_cb, g_source_remove);
+  g_clear_handle_id (&self->sort_cb, gtk_incremental_remove);
 
   g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_PENDING]);
 }
@@ -203,16 +194,14 @@ gtk_sort_list_model_stop_sorting (GtkSortListModel *self,
 static gboolean
 gtk_sort_list_model_sort_step (GtkSortListModel *self,
                                gboolean          finish,
+                               gint64            end_time,
                                guint            *out_position,
                                guint            *out_n_items)
 {
-  gint64 end_time = g_get_monotonic_time ();
   gboolean result = FALSE;
   GtkTimSortRun change;
   gpointer *start_change, *end_change;
 
-  end_time += GTK_SORT_STEP_TIME_US;
-
   if (!gtk_bitset_is_empty (self->missing_keys))
     {
       GtkBitsetIter iter;
@@ -269,21 +258,22 @@ gtk_sort_list_model_sort_step (GtkSortListModel *self,
 }
 
 static gboolean
-gtk_sort_list_model_sort_cb (gpointer data)
+gtk_sort_list_model_sort_cb (gpointer data,
+                             gint64   end_time)
 {
   GtkSortListModel *self = data;
   guint pos, n_items;
 
-  if (gtk_sort_list_model_sort_step (self, FALSE, &pos, &n_items))
+  if (gtk_sort_list_model_sort_step (self, FALSE, end_time, &pos, &n_items))
     {
       if (n_items)
         g_list_model_items_changed (G_LIST_MODEL (self), pos, n_items, n_items);
       g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_PENDING]);
-      return G_SOURCE_CONTINUE;
+      return TRUE;
     }
 
   gtk_sort_list_model_stop_sorting (self, NULL);
-  return G_SOURCE_REMOVE;
+  return FALSE;
 }
 
 static int
@@ -302,6 +292,195 @@ sort_func (gconstpointer a,
   return *sa < *sb ? -1 : 1;
 }
 
+/* When sorting everything at once with keys that can be used from other
+ * threads, keys are created in a thread pool and the array is split into
+ * one run per thread that gets sorted there. The runs are then merged
+ * by the usual timsort steps.
+ * Items are fetched on the calling thread, source models don't need
+ * to be thread-safe.
+ */
+#define MIN_THREADED_ITEMS 4096
+#define MIN_ITEMS_PER_CHUNK 1024
+#define MAX_SORT_CHUNKS 32
+#define KEYS_PER_BATCH (64 * 1024)
+
+typedef struct
+{
+  GMutex lock;
+  GCond cond;
+  guint n_pending;
+} SortJob;
+
+typedef struct
+{
+  SortJob *job;
+  GtkSortKeys *sort_keys;
+  /* either create the keys for items... */
+  gpointer *items;
+  gpointer *keys;
+  /* ...or sort a run of positions */
+  gpointer *run;
+  gsize n;
+} SortChunk;
+
+static void
+sort_chunk (gpointer data,
+            gpointer user_data)
+{
+  SortChunk *chunk = data;
+  SortJob *job = chunk->job;
+  gsize i;
+
+  if (chunk->items)
+    {
+      for (i = 0; i < chunk->n; i++)
+        gtk_sort_keys_init_key (chunk->sort_keys, chunk->items[i], chunk->keys[i]);
+    }
+  else
+    {
+      gtk_tim_sort (chunk->run, chunk->n, sizeof (gpointer), sort_func, chunk->sort_keys);
+    }
+
+  g_mutex_lock (&job->lock);
+  job->n_pending--;
+  if (job->n_pending == 0)
+    g_cond_signal (&job->cond);
+  g_mutex_unlock (&job->lock);
+}
+
+/* Returns %NULL if we only have one processor */
+static GThreadPool *
+get_sort_pool (void)
+{
+  static GThreadPool *pool = NULL;
+  static gsize initialized = 0;
+
+  if (g_once_init_enter (&initialized))
+    {
+      guint n_processors = g_get_num_processors ();
+
+      if (n_processors > 1)
+        pool = g_thread_pool_new (sort_chunk, NULL, n_processors, FALSE, NULL);
+
+      g_once_init_leave (&initialized, 1);
+    }
+
+  return pool;
+}
+
+static guint
+get_n_chunks (gsize n_items)
+{
+  return MIN (MIN (g_get_num_processors (), MAX_SORT_CHUNKS),
+              (n_items + MIN_ITEMS_PER_CHUNK - 1) / MIN_ITEMS_PER_CHUNK);
+}
+
+static void
+run_chunks (GThreadPool *pool,
+            SortChunk   *chunks,
+            guint        n_chunks)
+{
+  SortJob job;
+  guint i;
+
+  g_mutex_init (&job.lock);
+  g_cond_init (&job.cond);
+  job.n_pending = n_chunks;
+
+  for (i = 0; i < n_chunks; i++)
+    chunks[i].job = &job;
+
+  /* Do the first chunk ourselves instead of idling */
+  for (i = 1; i < n_chunks; i++)
+    g_thread_pool_push (pool, &chunks[i], NULL);
+
+  sort_chunk (&chunks[0], NULL);
+
+  g_mutex_lock (&job.lock);
+  while (job.n_pending > 0)
+    g_cond_wait (&job.cond, &job.lock);
+  g_mutex_unlock (&job.lock);
+
+  g_mutex_clear (&job.lock);
+  g_cond_clear (&job.cond);
+}
+
+static void
+gtk_sort_list_model_create_keys_threaded (GtkSortListModel *self,
+                                          GThreadPool      *pool)
+{
+  SortChunk chunks[MAX_SORT_CHUNKS];
+  GtkBitsetIter iter;
+  gpointer *items, *keys;
+  guint i, n, n_chunks, per_chunk, pos;
+  gboolean more;
+
+  items = g_new (gpointer, KEYS_PER_BATCH);
+  keys = g_new (gpointer, KEYS_PER_BATCH);
+
+  more = gtk_bitset_iter_init_first (&iter, self->missing_keys, &pos);
+  while (more)
+    {
+      for (n = 0; n < KEYS_PER_BATCH && more; n++, more = gtk_bitset_iter_next (&iter, &pos))
+        {
+          items[n] = g_list_model_get_item (self->model, pos);
+          keys[n] = key_from_pos (self, pos);
+        }
+
+      n_chunks = get_n_chunks (n);
+      per_chunk = (n + n_chunks - 1) / n_chunks;
+      n_chunks = (n + per_chunk - 1) / per_chunk;
+      for (i = 0; i < n_chunks; i++)
+        {
+          chunks[i] = (SortChunk) {
+            .sort_keys = self->sort_keys,
+            .items = items + i * per_chunk,
+            .keys = keys + i * per_chunk,
+            .n = MIN (per_chunk, n - i * per_chunk),
+          };
+        }
+
+      run_chunks (pool, chunks, n_chunks);
+
+      while (n-- > 0)
+        g_object_unref (items[n]);
+    }
+
+  g_free (items);
+  g_free (keys);
+
+  gtk_bitset_remove_all (self->missing_keys);
+}
+
+/* Must be called on a freshly started sort without runs */
+static void
+gtk_sort_list_model_sort_runs_threaded (GtkSortListModel *self,
+                                        GThreadPool      *pool)
+{
+  SortChunk chunks[MAX_SORT_CHUNKS];
+  gsize runs[MAX_SORT_CHUNKS + 1];
+  guint i, n_chunks, per_chunk;
+
+  n_chunks = get_n_chunks (self->n_items);
+  per_chunk = (self->n_items + n_chunks - 1) / n_chunks;
+  n_chunks = (self->n_items + per_chunk - 1) / per_chunk;
+
+  for (i = 0; i < n_chunks; i++)
+    {
+      chunks[i] = (SortChunk) {
+        .sort_keys = self->sort_keys,
+        .run = self->positions + i * per_chunk,
+        .n = MIN (per_chunk, self->n_items - i * per_chunk),
+      };
+      runs[i] = chunks[i].n;
+    }
+  runs[n_chunks] = 0;
+
+  run_chunks (pool, chunks, n_chunks);
+
+  gtk_tim_sort_set_runs (&self->sort, runs);
+}
+
 static gboolean
 gtk_sort_list_model_start_sorting (GtkSortListModel *self,
                                    gsize            *runs)
@@ -322,7 +501,7 @@ gtk_sort_list_model_start_sorting (GtkSortListModel *self,
   if (!self->incremental)
     return FALSE;
 
-  self->sort_cb = g_idle_add (gtk_sort_list_model_sort_cb, self);
+  self->sort_cb = gtk_incremental_add (G_LIST_MODEL (self), self->model, gtk_sort_list_model_sort_cb, self);
   g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_PENDING]);
   return TRUE;
 }
@@ -332,9 +511,34 @@ gtk_sort_list_model_finish_sorting (GtkSortListModel *self,
                                     guint            *pos,
                                     guint            *n_items)
 {
+  GThreadPool *pool;
+  gboolean sorted_runs = FALSE;
+
   gtk_tim_sort_set_max_merge_size (&self->sort, 0);
 
-  gtk_sort_list_model_sort_step (self, TRUE, pos, n_items);
+  if (gtk_sort_keys_is_thread_safe (self->sort_keys) &&
+      self->n_items >= MIN_THREADED_ITEMS &&
+      (pool = get_sort_pool ()) != NULL)
+    {
+      if (gtk_bitset_get_size (self->missing_keys) >= MIN_THREADED_ITEMS)
+        gtk_sort_list_model_create_keys_threaded (self, pool);
+      if (gtk_bitset_is_empty (self->missing_keys) &&
+          self->sort.pending_runs == 0 &&
+          self->sort.base == (gpointer) self->positions)
+        {
+          gtk_sort_list_model_sort_runs_threaded (self, pool);
+          sorted_runs = TRUE;
+        }
+    }
+
+  gtk_sort_list_model_sort_step (self, TRUE, 0, pos, n_items);
+
+  /* The steps only know about the merges */
+  if (sorted_runs)
+    {
+      *pos = 0;
+      *n_items = self->n_items;
+    }
   gtk_tim_sort_finish (&self->sort);
 
   gtk_sort_list_model_stop_sorting (self, NULL);
@@ -558,6 +762,78 @@ gtk_sort_list_model_update_items (GtkSortListModel *self,
   *unmodified_end = end;
 }
 
+/* Instead of sorting the whole model again, only the few items added
+ * at the end of the positions can be inserted into the sorted items
+ * before them.
+ * That is O(k log n) comparisons and moves less memory, which matters
+ * for models that keep replacing rows, for example to update them.
+ */
+static gboolean
+gtk_sort_list_model_can_insert_items (GtkSortListModel *self,
+                                      gsize             runs[GTK_TIM_SORT_MAX_PENDING + 1],
+                                      guint             added)
+{
+  guint n_sorted = self->n_items - added;
+
+  if (n_sorted == 0 || runs[0] != n_sorted || runs[1] != 0)
+    return FALSE;
+
+  return added * 8 <= n_sorted;
+}
+
+static void
+gtk_sort_list_model_insert_items (GtkSortListModel *self,
+                                  guint             position,
+                                  guint             added,
+                                  guint            *unmodified_start,
+                                  guint            *unmodified_end)
+{
+  gpointer *inserted;
+  guint i, lo, hi, mid, n_sorted;
+
+  for (i = 0; i < added; i++)
+    {
+      gpointer item = g_list_model_get_item (self->model, position + i);
+      gtk_sort_keys_init_key (self->sort_keys, item, key_from_pos (self, position + i));
+      g_object_unref (item);
+    }
+  gtk_bitset_remove_range (self->missing_keys, position, added);
+
+  n_sorted = self->n_items - added;
+  inserted = g_new (gpointer, added);
+  memcpy (inserted, self->positions + n_sorted, sizeof (gpointer) * added);
+  gtk_tim_sort (inserted, added, sizeof (gpointer), sort_func, self->sort_keys);
+
+  /* Merge from the back, so every item is moved at most once */
+  hi = n_sorted;
+  for (i = added; i > 0; i--)
+    {
+      lo = 0;
+      while (lo < hi)
+        {
+          mid = (lo + hi) / 2;
+          /* sort_func() never returns 0 */
+          if (sort_func (&self->positions[mid], &inserted[i - 1], self->sort_keys) < 0)
+            lo = mid + 1;
+          else
+            hi = mid;
+        }
+
+      memmove (&self->positions[lo + i],
+               &self->positions[lo],
+               sizeof (gpointer) * (n_sorted - lo));
+      self->positions[lo + i - 1] = inserted[i - 1];
+
+      if (i == added)
+        *unmodified_end = MIN (*unmodified_end, self->n_items - (lo + i));
+      n_sorted = lo;
+      hi = lo;
+    }
+  *unmodified_start = MIN (*unmodified_start, n_sorted);
+
+  g_free (inserted);
+}
+
 static void
 gtk_sort_list_model_items_changed_cb (GListModel       *model,
                                       guint             position,
@@ -586,7 +862,11 @@ gtk_sort_list_model_items_changed_cb (GListModel       *model,
 
   if (added > 0)
     {
-      if (gtk_sort_list_model_start_sorting (self, runs))
+      if (!was_sorting && gtk_sort_list_model_can_insert_items (self, runs, added))
+        {
+          gtk_sort_list_model_insert_items (self, position, added, &start, &end);
+        }
+      else if (gtk_sort_list_model_start_sorting (self, runs))
         {
           end = 0;
         }
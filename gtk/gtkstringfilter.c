@@ -21,6 +21,8 @@
 
 #include "gtkstringfilter.h"
 
+#include "gtkexpressionprivate.h"
+#include "gtkfilterprivate.h"
 #include "gtkintl.h"
 #include "gtktypebuiltins.h"
 
@@ -84,6 +86,54 @@ gtk_string_filter_prepare (GtkStringFilter *self,
   return result;
 }
 
+/* Normalizing and case-folding is the expensive part of matching, and
+ * typing into a search entry refilters the same items over and over.
+ * So the prepared string is kept on the item, together with the string
+ * it was prepared from, as "string\0prepared\0". It only depends on
+ * the string and on ignore-case, so all filters can share it.
+ */
+static const char *
+gtk_string_filter_lookup_prepared (GtkStringFilter *self,
+                                   gpointer         item,
+                                   const char      *s)
+{
+  static GQuark quarks[2];
+  GQuark quark;
+  char *cached;
+  gsize len;
+
+  if (G_UNLIKELY (quarks[0] == 0))
+    {
+      quarks[0] = g_quark_from_static_string ("gtk-string-filter-normalized");
+      quarks[1] = g_quark_from_static_string ("gtk-string-filter-casefolded");
+    }
+  quark = quarks[self->ignore_case ? 1 : 0];
+
+  if (s == NULL || s[0] == '\0')
+    return NULL;
+
+  len = strlen (s);
+  cached = g_object_get_qdata (item, quark);
+  if (cached == NULL || strcmp (cached, s) != 0)
+    {
+      char *prepared = gtk_string_filter_prepare (self, s);
+      gsize prepared_len;
+
+      if (prepared == NULL)
+        return NULL;
+
+      prepared_len = strlen (prepared);
+      cached = g_malloc (len + prepared_len + 2);
+      memcpy (cached, s, len + 1);
+      memcpy (cached + len + 1, prepared, prepared_len + 1);
+      g_free (prepared);
+
+      g_object_set_qdata_full (item, quark, cached, g_free);
+    }
+
+  return cached + len + 1;
+}
+
 /* This is necessary because code just looks at self->search otherwise
  * and that can be the empty string...
  */
@@ -99,8 +149,7 @@ gtk_string_filter_match (GtkFilter *filter,
 {
   GtkStringFilter *self = GTK_STRING_FILTER (filter);
   GValue value = G_VALUE_INIT;
-  char *prepared;
-  const char *s;
+  const char *s, *prepared;
   gboolean result;
 
   if (!gtk_string_filter_has_search (self))
@@ -110,9 +159,12 @@ gtk_string_filter_match (GtkFilter *filter,
       !gtk_expression_evaluate (self->expression, item, &value))
     return FALSE;
   s = g_value_get_string (&value);
-  prepared = gtk_string_filter_prepare (self, s);
+  prepared = gtk_string_filter_lookup_prepared (self, item, s);
   if (prepared == NULL)
-    return FALSE;
+    {
+      g_value_unset (&value);
+      return FALSE;
+    }
 
   switch (self->match_mode)
     {
@@ -133,7 +185,6 @@ gtk_string_filter_match (GtkFilter *filter,
   g_print ("%s (%s) %s %s (%s)\n", s, prepared, result ? "==" : "!=", self->search, self->search_prepared);
 #endif
 
-  g_free (prepared);
   g_value_unset (&value);
 
   return result;
@@ -299,6 +350,8 @@ gtk_string_filter_init (GtkStringFilter *self)
 {
   self->ignore_case = TRUE;
   self->match_mode = GTK_STRING_FILTER_MATCH_MODE_SUBSTRING;
+
+  gtk_filter_set_thread_safe (GTK_FILTER (self), TRUE);
 }
 
 /**
@@ -362,10 +415,19 @@ gtk_string_filter_set_search (GtkStringFilter *self,
   if (g_strcmp0 (self->search, search) == 0)
     return;
 
+  /* Narrowing the search only needs to look at the previous matches */
   if (search == NULL || search[0] == 0)
     change = GTK_FILTER_CHANGE_LESS_STRICT;
   else if (!gtk_string_filter_has_search (self))
     change = GTK_FILTER_CHANGE_MORE_STRICT;
+  else if (self->match_mode == GTK_STRING_FILTER_MATCH_MODE_EXACT)
+    change = GTK_FILTER_CHANGE_DIFFERENT;
+  else if (self->match_mode == GTK_STRING_FILTER_MATCH_MODE_SUBSTRING &&
+           strstr (search, self->search))
+    change = GTK_FILTER_CHANGE_MORE_STRICT;
+  else if (self->match_mode == GTK_STRING_FILTER_MATCH_MODE_SUBSTRING &&
+           strstr (self->search, search))
+    change = GTK_FILTER_CHANGE_LESS_STRICT;
   else if (g_str_has_prefix (search, self->search))
     change = GTK_FILTER_CHANGE_MORE_STRICT;
   else if (g_str_has_prefix (self->search, search))
@@ -422,6 +484,7 @@ gtk_string_filter_set_expression (GtkStringFilter *self,
 
   g_clear_pointer (&self->expression, gtk_expression_unref);
   self->expression = gtk_expression_ref (expression);
+  gtk_filter_set_thread_safe (GTK_FILTER (self), gtk_expression_is_thread_safe (expression));
 
   if (gtk_string_filter_has_search (self))
     gtk_filter_changed (GTK_FILTER (self), GTK_FILTER_CHANGE_DIFFERENT);
@@ -60,10 +60,29 @@
 
  */
 
-#define GDK_ARRAY_ELEMENT_TYPE GtkStringObject *
-#define GDK_ARRAY_NAME objects
-#define GDK_ARRAY_TYPE_NAME Objects
-#define GDK_ARRAY_FREE_FUNC g_object_unref
+/* Most strings in big lists are never looked at, so the list only
+ * keeps the strings and creates the objects when they are requested.
+ * Items are either a #GtkStringObject or a string tagged by setting
+ * the lowest bit, which malloc()ed strings never have set.
+ * Once created, objects are kept so that they stay the same object.
+ */
+#define IS_STRING(item) (GPOINTER_TO_SIZE (item) & 0x1)
+#define TO_STRING(item) ((char *) (GPOINTER_TO_SIZE (item) & ~0x1))
+#define FROM_STRING(str) ((gpointer) (GPOINTER_TO_SIZE (str) | 0x1))
+
+static void
+free_item (gpointer item)
+{
+  if (IS_STRING (item))
+    g_free (TO_STRING (item));
+  else
+    g_object_unref (item);
+}
+
+#define GDK_ARRAY_ELEMENT_TYPE gpointer
+#define GDK_ARRAY_NAME items
+#define GDK_ARRAY_TYPE_NAME Items
+#define GDK_ARRAY_FREE_FUNC free_item
 #include "gdk/gdkarrayimpl.c"
 
 struct _GtkStringObject
@@ -177,7 +196,7 @@ struct _GtkStringList
 {
   GObject parent_instance;
 
-  Objects items;
+  Items items;
 };
 
 struct _GtkStringListClass
@@ -196,7 +215,7 @@ gtk_string_list_get_n_items (GListModel *list)
 {
   GtkStringList *self = GTK_STRING_LIST (list);
 
-  return objects_get_size (&self->items);
+  return items_get_size (&self->items);
 }
 
 static gpointer
@@ -205,10 +224,19 @@ gtk_string_list_get_item (GListModel *list,
 {
   GtkStringList *self = GTK_STRING_LIST (list);
 
-  if (position >= objects_get_size (&self->items))
+  gpointer item;
+
+  if (position >= items_get_size (&self->items))
     return NULL;
 
-  return g_object_ref (objects_get (&self->items, position));
+  item = items_get (&self->items, position);
+  if (IS_STRING (item))
+    {
+      item = gtk_string_object_new_take (TO_STRING (item));
+      *items_index (&self->items, position) = item;
+    }
+
+  return g_object_ref (item);
 }
 
 static void
@@ -395,7 +423,7 @@ gtk_string_list_dispose (GObject *object)
 {
   GtkStringList *self = GTK_STRING_LIST (object);
 
-  objects_clear (&self->items);
+  items_clear (&self->items);
 
   G_OBJECT_CLASS (gtk_string_list_parent_class)->dispose (object);
 }
@@ -411,7 +439,7 @@ gtk_string_list_class_init (GtkStringListClass *class)
 static void
 gtk_string_list_init (GtkStringList *self)
 {
-  objects_init (&self->items);
+  items_init (&self->items);
 }
 
 /**
@@ -464,18 +492,18 @@ gtk_string_list_splice (GtkStringList      *self,
 
   g_return_if_fail (GTK_IS_STRING_LIST (self));
   g_return_if_fail (position + n_removals >= position); /* overflow */
-  g_return_if_fail (position + n_removals <= objects_get_size (&self->items));
+  g_return_if_fail (position + n_removals <= items_get_size (&self->items));
 
   if (additions)
     n_additions = g_strv_length ((char **) additions);
   else
     n_additions = 0;
 
-  objects_splice (&self->items, position, n_removals, NULL, n_additions);
+  items_splice (&self->items, position, n_removals, NULL, n_additions);
 
   for (i = 0; i < n_additions; i++)
     {
-      *objects_index (&self->items, position + i) = gtk_string_object_new (additions[i]);
+      *items_index (&self->items, position + i) = FROM_STRING (g_strdup (additions[i]));
     }
 
   if (n_removals || n_additions)
@@ -498,9 +526,9 @@ gtk_string_list_append (GtkStringList *self,
 {
   g_return_if_fail (GTK_IS_STRING_LIST (self));
 
-  objects_append (&self->items, gtk_string_object_new (string));
+  items_append (&self->items, FROM_STRING (g_strdup (string)));
 
-  g_list_model_items_changed (G_LIST_MODEL (self), objects_get_size (&self->items) - 1, 0, 1);
+  g_list_model_items_changed (G_LIST_MODEL (self), items_get_size (&self->items) - 1, 0, 1);
 }
 
 /**
@@ -524,9 +552,9 @@ gtk_string_list_take (GtkStringList *self,
 {
   g_return_if_fail (GTK_IS_STRING_LIST (self));
 
-  objects_append (&self->items, gtk_string_object_new_take (string));
+  items_append (&self->items, FROM_STRING (string));
 
-  g_list_model_items_changed (G_LIST_MODEL (self), objects_get_size (&self->items) - 1, 0, 1);
+  g_list_model_items_changed (G_LIST_MODEL (self), items_get_size (&self->items) - 1, 0, 1);
 }
 
 /**
@@ -565,8 +593,14 @@ gtk_string_list_get_string (GtkStringList *self,
 {
   g_return_val_if_fail (GTK_IS_STRING_LIST (self), NULL);
 
-  if (position >= objects_get_size (&self->items))
+  gpointer item;
+
+  if (position >= items_get_size (&self->items))
     return NULL;
 
-  return objects_get (&self->items, position)->string;
+  item = items_get (&self->items, position);
+  if (IS_STRING (item))
+    return TO_STRING (item);
+
+  return GTK_STRING_OBJECT (item)->string;
 }
@@ -21,6 +21,7 @@
 
 #include "gtkstringsorter.h"
 
+#include "gtkexpressionprivate.h"
 #include "gtkintl.h"
 #include "gtksorterprivate.h"
 #include "gtktypebuiltins.h"
@@ -211,6 +212,7 @@ gtk_string_sort_keys_new (GtkStringSorter *self)
 
   result->expression = gtk_expression_ref (self->expression);
   result->ignore_case = self->ignore_case;
+  result->keys.thread_safe = gtk_expression_is_thread_safe (self->expression);
 
   return (GtkSortKeys *) result;
 }
@@ -30,6 +30,24 @@ _gtk_style_animation_advance (GtkStyleAnimation *animation,
   return animation->class->advance (animation, timestamp);
 }
 
+/* Like _gtk_style_animation_advance(), but the caller promises that
+ * the style owning @animation is going away, so when nobody else holds
+ * a reference, the animation is advanced in place and a new reference
+ * to it is returned. */
+GtkStyleAnimation *
+gtk_style_animation_advance_reuse (GtkStyleAnimation *animation,
+                                   gint64             timestamp)
+{
+  g_assert (animation != NULL);
+
+  if (animation->ref_count > 1)
+    return animation->class->advance (animation, timestamp);
+
+  animation->class->advance_in_place (animation, timestamp);
+
+  return gtk_style_animation_ref (animation);
+}
+
 void
 _gtk_style_animation_apply_values (GtkStyleAnimation    *animation,
                                    GtkCssAnimatedStyle  *style)
@@ -43,12 +43,17 @@ struct _GtkStyleAnimationClass
                                                          GtkCssAnimatedStyle    *style);
   GtkStyleAnimation *  (* advance)                      (GtkStyleAnimation      *animation,
                                                          gint64                  timestamp);
+  /* like advance, but modifies @animation instead of copying it */
+  void          (* advance_in_place)                    (GtkStyleAnimation      *animation,
+                                                         gint64                  timestamp);
 };
 
 GType           _gtk_style_animation_get_type           (void) G_GNUC_CONST;
 
 GtkStyleAnimation * _gtk_style_animation_advance        (GtkStyleAnimation      *animation,
                                                          gint64                  timestamp);
+GtkStyleAnimation * gtk_style_animation_advance_reuse   (GtkStyleAnimation      *animation,
+                                                         gint64                  timestamp);
 void            _gtk_style_animation_apply_values       (GtkStyleAnimation      *animation,
                                                          GtkCssAnimatedStyle    *style);
 gboolean        _gtk_style_animation_is_finished        (GtkStyleAnimation      *animation);
@@ -123,6 +123,37 @@ gtk_style_provider_changed (GtkStyleProvider *provider)
   g_signal_emit (provider, signals[CHANGED], 0);
 }
 
+static const GtkCssSelectorTree *changed_selectors;
+
+/* Emits the changed signal for a provider that only changed the
+ * declarations of rules with the given selectors. While the signal
+ * is emitted, gtk_style_provider_get_changed_selectors() returns them,
+ * so only nodes matching them need a new style.
+ */
+void
+gtk_style_provider_changed_selectors (GtkStyleProvider         *provider,
+                                      const GtkCssSelectorTree *selectors)
+{
+  const GtkCssSelectorTree *saved;
+
+  gtk_internal_return_if_fail (GTK_IS_STYLE_PROVIDER (provider));
+  gtk_internal_return_if_fail (selectors != NULL);
+
+  saved = changed_selectors;
+  changed_selectors = selectors;
+
+  g_signal_emit (provider, signals[CHANGED], 0);
+
+  changed_selectors = saved;
+}
+
+/* Returns %NULL if everything might have changed */
+const GtkCssSelectorTree *
+gtk_style_provider_get_changed_selectors (void)
+{
+  return changed_selectors;
+}
+
 GtkSettings *
 gtk_style_provider_get_settings (GtkStyleProvider *provider)
 {
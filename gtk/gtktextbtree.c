@@ -1090,6 +1090,52 @@ _gtk_text_btree_delete (GtkTextIter *start,
   gtk_text_btree_resolve_bidi (start, end);
 }
 
+/* Same as pango_find_paragraph_boundary(), but looks at bytes rather
+ * than decoding every character. None of the delimiters can appear as
+ * part of another UTF-8 sequence, so this is safe on valid UTF-8.
+ */
+static void
+find_paragraph_boundary (const char *text,
+                         int         length,
+                         int        *paragraph_delimiter_index,
+                         int        *next_paragraph_start)
+{
+  const char *p = text;
+  const char *end = text + length;
+
+  for (; p < end; p++)
+    {
+      if (*p == '\n')
+        {
+          *paragraph_delimiter_index = p - text;
+          *next_paragraph_start = p - text + 1;
+          return;
+        }
+      else if (*p == '\r')
+        {
+          *paragraph_delimiter_index = p - text;
+          if (p + 1 < end && p[1] == '\n')
+            *next_paragraph_start = p - text + 2;
+          else
+            *next_paragraph_start = p - text + 1;
+          return;
+        }
+      else if ((guchar) *p == 0xE2 &&
+               p + 2 < end &&
+               (guchar) p[1] == 0x80 &&
+               (guchar) p[2] == 0xA9)
+        {
+          /* U+2029 PARAGRAPH SEPARATOR */
+          *paragraph_delimiter_index = p - text;
+          *next_paragraph_start = p - text + 3;
+          return;
+        }
+    }
+
+  *paragraph_delimiter_index = length;
+  *next_paragraph_start = length;
+}
+
 void
 _gtk_text_btree_insert (GtkTextIter *iter,
                         const char *text,
@@ -1112,6 +1158,7 @@ _gtk_text_btree_insert (GtkTextIter *iter,
                                        * one in current chunk.
                                        */
   int delim;                          /* index of paragraph delimiter */
+  int sos;                            /* start of current segment */
   int line_count_delta;                /* Counts change to total number of
                                         * lines in file.
                                         */
@@ -1119,6 +1166,7 @@ _gtk_text_btree_insert (GtkTextIter *iter,
   int char_count_delta;                /* change to number of chars */
   GtkTextBTree *tree;
   int start_byte_index;
+  int end_byte_index;
   GtkTextLine *start_line;
 
   g_return_if_fail (text != NULL);
@@ -1156,14 +1204,15 @@ _gtk_text_btree_insert (GtkTextIter *iter,
   sol = 0;
   line_count_delta = 0;
   char_count_delta = 0;
+  end_byte_index = start_byte_index;
   while (eol < len)
     {
       sol = eol;
       
-      pango_find_paragraph_boundary (text + sol,
-                                     len - sol,
-                                     &delim,
-                                     &eol);      
+      find_paragraph_boundary (text + sol,
+                               len - sol,
+                               &delim,
+                               &eol);
 
       /* make these relative to the start of the text */
       delim += sol;
@@ -1178,7 +1227,37 @@ _gtk_text_btree_insert (GtkTextIter *iter,
       chunk_len = eol - sol;
 
       g_assert (g_utf8_validate (&text[sol], chunk_len, NULL));
-      seg = _gtk_char_segment_new (&text[sol], chunk_len);
+
+      /* Break long lines up into several segments, keeping the
+       * paragraph delimiter in the last one.
+       */
+      sos = sol;
+      while (delim - sos > GTK_TEXT_CHAR_SEGMENT_MAX_BYTES)
+        {
+          int eos = sos + GTK_TEXT_CHAR_SEGMENT_MAX_BYTES;
+
+          while (!gtk_text_byte_begins_utf8_char (&text[eos]))
+            eos--;
+
+          seg = _gtk_char_segment_new (&text[sos], eos - sos);
+          char_count_delta += seg->char_count;
+
+          if (cur_seg == NULL)
+            {
+              seg->next = line->segments;
+              line->segments = seg;
+            }
+          else
+            {
+              seg->next = cur_seg->next;
+              cur_seg->next = seg;
+            }
+
+          cur_seg = seg;
+          sos = eos;
+        }
+
+      seg = _gtk_char_segment_new (&text[sos], eol - sos);
 
       char_count_delta += seg->char_count;
 
@@ -1197,6 +1276,7 @@ _gtk_text_btree_insert (GtkTextIter *iter,
         {
           /* chunk didn't end with a paragraph separator */
           g_assert (eol == len);
+          end_byte_index += chunk_len;
           break;
         }
 
@@ -1214,6 +1294,7 @@ _gtk_text_btree_insert (GtkTextIter *iter,
       line = newline;
       cur_seg = NULL;
       line_count_delta++;
+      end_byte_index = 0;
     }
 
   /*
@@ -1240,12 +1321,15 @@ _gtk_text_btree_insert (GtkTextIter *iter,
                                       &start,
                                       start_line,
                                       start_byte_index);
-    end = start;
 
-    /* We could almost certainly be more efficient here
-       by saving the information from the insertion loop
-       above. FIXME */
-    gtk_text_iter_forward_chars (&end, char_count_delta);
+    /* The insertion loop knows where the text ended, so don't go
+     * through char offsets, which are expensive to compute for
+     * large insertions.
+     */
+    _gtk_text_btree_get_iter_at_line (tree,
+                                      &end,
+                                      line,
+                                      end_byte_index);
 
     DV (g_print ("invalidating due to inserting some text (%s)\n", G_STRLOC));
     _gtk_text_btree_invalidate_region (tree, &start, &end, FALSE);
@@ -1806,8 +1890,6 @@ _gtk_text_btree_tag (const GtkTextIter *start_orig,
 
   tree = _gtk_text_iter_get_btree (&start);
 
-  queue_tag_redisplay (tree, tag, &start, &end);
-
   info = gtk_text_btree_get_tag_info (tree, tag);
 
   start_line = _gtk_text_iter_get_text_line (&start);
@@ -1835,13 +1917,25 @@ _gtk_text_btree_tag (const GtkTextIter *start_orig,
   /* We need to traverse the toggles in order. */
   iter_stack_invert (stack);
 
+  toggled_on = gtk_text_iter_has_tag (&start, tag);
+
+  /* Highlighters tend to reapply the same tags to text that didn't
+   * change. If the whole range is already in the state we want,
+   * there is nothing to change and nothing to redisplay.
+   */
+  if (stack->count == 0 && toggled_on == (add != FALSE))
+    {
+      iter_stack_free (stack);
+      return;
+    }
+
+  queue_tag_redisplay (tree, tag, &start, &end);
+
   /*
    * See whether the tag is present at the start of the range.  If
    * the state doesn't already match what we want then add a toggle
    * there.
    */
-
-  toggled_on = gtk_text_iter_has_tag (&start, tag);
   if ( (add && !toggled_on) ||
        (!add && toggled_on) )
     {
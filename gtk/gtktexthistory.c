@@ -38,6 +38,9 @@
  * changes tracked by the GtkTextHistory to be discarded.
  */
 
+/* Upper bound on the amount of text kept for undo/redo, in bytes */
+#define MAX_UNDO_BYTES (64 * 1024 * 1024)
+
 typedef struct _Action     Action;
 typedef enum   _ActionKind ActionKind;
 
@@ -98,6 +101,7 @@ struct _GtkTextHistory
   guint               irreversible;
   guint               in_user;
   guint               max_undo_levels;
+  gsize               n_bytes;
 
   guint               can_undo : 1;
   guint               can_redo : 1;
@@ -180,6 +184,34 @@ action_free (Action *action)
   g_slice_free (Action, action);
 }
 
+static gsize
+action_get_n_bytes (const Action *action)
+{
+  const GList *iter;
+  gsize n_bytes = 0;
+
+  switch (action->kind)
+    {
+    case ACTION_KIND_INSERT:
+      return action->u.insert.istr.n_bytes;
+
+    case ACTION_KIND_DELETE_BACKSPACE:
+    case ACTION_KIND_DELETE_KEY:
+    case ACTION_KIND_DELETE_PROGRAMMATIC:
+    case ACTION_KIND_DELETE_SELECTION:
+      return action->u.delete.istr.n_bytes;
+
+    case ACTION_KIND_GROUP:
+      for (iter = action->u.group.actions.head; iter; iter = iter->next)
+        n_bytes += action_get_n_bytes (iter->data);
+      return n_bytes;
+
+    case ACTION_KIND_BARRIER:
+    default:
+      return 0;
+    }
+}
+
 static gboolean
 action_group_is_empty (const Action *action)
 {
@@ -384,21 +416,35 @@ gtk_text_history_do_select (GtkTextHistory *self,
   self->funcs.select (self->funcs_data, selection_insert, selection_bound);
 }
 
+static void
+gtk_text_history_drop (GtkTextHistory *self,
+                       GQueue         *queue,
+                       Action         *action)
+{
+  gsize n_bytes = action_get_n_bytes (action);
+
+  g_assert (self->n_bytes >= n_bytes);
+
+  self->n_bytes -= n_bytes;
+  g_queue_unlink (queue, &action->link);
+  action_free (action);
+}
+
+static void
+gtk_text_history_clear_queue (GtkTextHistory *self,
+                              GQueue         *queue)
+{
+  while (queue->length > 0)
+    gtk_text_history_drop (self, queue, g_queue_peek_head (queue));
+}
+
 static void
 gtk_text_history_truncate_one (GtkTextHistory *self)
 {
   if (self->undo_queue.length > 0)
-    {
-      Action *action = g_queue_peek_head (&self->undo_queue);
-      g_queue_unlink (&self->undo_queue, &action->link);
-      action_free (action);
-    }
+    gtk_text_history_drop (self, &self->undo_queue, g_queue_peek_head (&self->undo_queue));
   else if (self->redo_queue.length > 0)
-    {
-      Action *action = g_queue_peek_tail (&self->redo_queue);
-      g_queue_unlink (&self->redo_queue, &action->link);
-      action_free (action);
-    }
+    gtk_text_history_drop (self, &self->redo_queue, g_queue_peek_tail (&self->redo_queue));
   else
     {
       g_assert_not_reached ();
@@ -410,10 +456,16 @@ gtk_text_history_truncate (GtkTextHistory *self)
 {
   g_assert (GTK_IS_TEXT_HISTORY (self));
 
-  if (self->max_undo_levels == 0)
-    return;
+  if (self->max_undo_levels > 0)
+    {
+      while (self->undo_queue.length + self->redo_queue.length > self->max_undo_levels)
+        gtk_text_history_truncate_one (self);
+    }
 
-  while (self->undo_queue.length + self->redo_queue.length > self->max_undo_levels)
+  /* Drop the oldest actions once too much text is kept, but never the
+   * most recent one as we may still be chaining into it.
+   */
+  while (self->n_bytes > MAX_UNDO_BYTES && self->undo_queue.length > 1)
     gtk_text_history_truncate_one (self);
 }
 
@@ -498,12 +550,9 @@ gtk_text_history_push (GtkTextHistory *self,
   g_assert (self->enabled);
   g_assert (action != NULL);
 
-  while (self->redo_queue.length > 0)
-    {
-      peek = g_queue_peek_head (&self->redo_queue);
-      g_queue_unlink (&self->redo_queue, &peek->link);
-      action_free (peek);
-    }
+  gtk_text_history_clear_queue (self, &self->redo_queue);
+
+  self->n_bytes += action_get_n_bytes (action);
 
   peek = g_queue_peek_tail (&self->undo_queue);
   in_user_action = self->in_user > 0;
@@ -791,7 +840,7 @@ gtk_text_history_end_user_action (GtkTextHistory *self)
   return_if_applying (self);
   return_if_irreversible (self);
 
-  clear_action_queue (&self->redo_queue);
+  gtk_text_history_clear_queue (self, &self->redo_queue);
 
   peek = g_queue_peek_tail (&self->undo_queue);
 
@@ -813,8 +862,7 @@ gtk_text_history_end_user_action (GtkTextHistory *self)
   /* Unlikely, but if the group is empty, just remove it */
   if (action_group_is_empty (peek))
     {
-      g_queue_unlink (&self->undo_queue, &peek->link);
-      action_free (peek);
+      gtk_text_history_drop (self, &self->undo_queue, peek);
       goto update_state;
     }
 
@@ -843,8 +891,8 @@ gtk_text_history_begin_irreversible_action (GtkTextHistory *self)
 
   self->irreversible++;
 
-  clear_action_queue (&self->undo_queue);
-  clear_action_queue (&self->redo_queue);
+  gtk_text_history_clear_queue (self, &self->undo_queue);
+  gtk_text_history_clear_queue (self, &self->redo_queue);
 
   gtk_text_history_update_state (self);
 }
@@ -865,8 +913,8 @@ gtk_text_history_end_irreversible_action (GtkTextHistory *self)
 
   self->irreversible--;
 
-  clear_action_queue (&self->undo_queue);
-  clear_action_queue (&self->redo_queue);
+  gtk_text_history_clear_queue (self, &self->undo_queue);
+  gtk_text_history_clear_queue (self, &self->redo_queue);
 
   gtk_text_history_update_state (self);
 }
@@ -1034,8 +1082,8 @@ gtk_text_history_set_enabled (GtkTextHistory *self,
         {
           self->irreversible = 0;
           self->in_user = 0;
-          clear_action_queue (&self->undo_queue);
-          clear_action_queue (&self->redo_queue);
+          gtk_text_history_clear_queue (self, &self->undo_queue);
+          gtk_text_history_clear_queue (self, &self->redo_queue);
         }
 
       gtk_text_history_update_state (self);
@@ -4409,6 +4409,15 @@ forward_chars_with_skipping (GtkTextIter *iter,
 
   g_return_if_fail (count >= 0);
 
+  /* Nothing to skip, so we can move by whole segments instead of
+   * looking at every character.
+   */
+  if (!skip_invisible && !skip_nontext && !skip_decomp)
+    {
+      gtk_text_iter_forward_chars (iter, count);
+      return;
+    }
+
   i = count;
 
   while (i > 0)
@@ -98,7 +98,17 @@
 
 #define GTK_TEXT_LAYOUT_GET_PRIVATE(o)  ((GtkTextLayoutPrivate *) gtk_text_layout_get_instance_private ((o)))
 
+#define N_CACHED_STYLES 8
+
 typedef struct _GtkTextLayoutPrivate GtkTextLayoutPrivate;
+typedef struct _CachedStyle          CachedStyle;
+
+struct _CachedStyle
+{
+  GtkTextTag **tags;
+  guint n_tags;
+  GtkTextAttributes *style;
+};
 
 struct _GtkTextLayoutPrivate
 {
@@ -109,6 +119,16 @@ struct _GtkTextLayoutPrivate
 
   /* Cache for GtkTextLineDisplay to reduce overhead creating layouts */
   GtkTextLineDisplayCache *cache;
+
+  /* Styles computed for the most recent sets of tags. Unlike the
+   * one-style cache, these survive toggles, so runs that switch
+   * back and forth between the same tags don't recompute their
+   * style. They are only kept until the end of the wrap loop, as
+   * tags can change in between.
+   */
+  CachedStyle cached_styles[N_CACHED_STYLES];
+  guint n_cached_styles;
+  guint next_cached_style;
 };
 
 static void gtk_text_layout_invalidated     (GtkTextLayout     *layout);
@@ -196,6 +216,7 @@ gtk_text_layout_dispose (GObject *object)
   g_clear_pointer (&priv->cache, gtk_text_line_display_cache_free);
 
   gtk_text_layout_set_buffer (layout, NULL);
+  free_cached_styles (layout);
 
   if (layout->default_style != NULL)
     {
@@ -299,6 +320,22 @@ free_style_cache (GtkTextLayout *text_layout)
     }
 }
 
+static void
+free_cached_styles (GtkTextLayout *text_layout)
+{
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (text_layout);
+  guint i;
+
+  for (i = 0; i < priv->n_cached_styles; i++)
+    {
+      g_clear_pointer (&priv->cached_styles[i].tags, g_free);
+      g_clear_pointer (&priv->cached_styles[i].style, gtk_text_attributes_unref);
+    }
+
+  priv->n_cached_styles = 0;
+  priv->next_cached_style = 0;
+}
+
 /*
  * gtk_text_layout_set_buffer:
  * @buffer: (allow-none):
@@ -314,6 +351,7 @@ gtk_text_layout_set_buffer (GtkTextLayout *layout,
     return;
 
   free_style_cache (layout);
+  free_cached_styles (layout);
 
   if (layout->buffer)
     {
@@ -765,6 +803,7 @@ gtk_text_layout_wrap_loop_end (GtkTextLayout *layout)
        */
       /* Nuke our cached style */
       invalidate_cached_style (layout);
+      free_cached_styles (layout);
       g_assert (layout->one_style_cache == NULL);
     }
 }
@@ -1136,7 +1175,10 @@ static GtkTextAttributes*
 get_style (GtkTextLayout *layout,
 	   GPtrArray     *tags)
 {
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
   GtkTextAttributes *style;
+  CachedStyle *cached;
+  guint i;
 
   /* If we have the one-style cache, then it means
      that we haven't seen a toggle since we filled in the
@@ -1162,6 +1204,24 @@ get_style (GtkTextLayout *layout,
       return layout->default_style;
     }
 
+  /* The tags are sorted by priority, so equal sets of tags have
+   * equal arrays.
+   */
+  for (i = 0; i < priv->n_cached_styles; i++)
+    {
+      cached = &priv->cached_styles[i];
+
+      if (cached->n_tags == tags->len &&
+          memcmp (cached->tags, tags->pdata, tags->len * sizeof (gpointer)) == 0)
+        {
+          gtk_text_attributes_ref (cached->style);
+          gtk_text_attributes_ref (cached->style);
+          layout->one_style_cache = cached->style;
+
+          return cached->style;
+        }
+    }
+
   style = gtk_text_attributes_new ();
 
   gtk_text_attributes_copy_values (layout->default_style,
@@ -1173,6 +1233,17 @@ get_style (GtkTextLayout *layout,
 
   g_assert (style->refcount == 1);
 
+  cached = &priv->cached_styles[priv->next_cached_style];
+  g_clear_pointer (&cached->tags, g_free);
+  g_clear_pointer (&cached->style, gtk_text_attributes_unref);
+  cached->tags = g_new (GtkTextTag *, tags->len);
+  memcpy (cached->tags, tags->pdata, tags->len * sizeof (gpointer));
+  cached->n_tags = tags->len;
+  cached->style = gtk_text_attributes_ref (style);
+  priv->next_cached_style = (priv->next_cached_style + 1) % N_CACHED_STYLES;
+  if (priv->n_cached_styles < N_CACHED_STYLES)
+    priv->n_cached_styles++;
+
   /* Leave this style as the last one seen */
   g_assert (layout->one_style_cache == NULL);
   gtk_text_attributes_ref (style); /* ref held by layout->one_style_cache */
@@ -2663,7 +2734,10 @@ gtk_text_layout_create_display (GtkTextLayout *layout,
   
   /* Free this if we aren't in a loop */
   if (layout->wrap_loop_count == 0)
-    invalidate_cached_style (layout);
+    {
+      invalidate_cached_style (layout);
+      free_cached_styles (layout);
+    }
 
   g_free (text);
   pango_attr_list_unref (attrs);
@@ -4209,7 +4283,10 @@ gtk_text_layout_snapshot (GtkTextLayout      *layout,
         {
           g_assert (line_display->layout != NULL);
 
-          if (have_selection)
+          /* The selection is only needed to render the line, which
+           * we can skip when the cached render node is still valid.
+           */
+          if (have_selection && line_display->node == NULL)
             {
               GtkTextIter line_start;
               int current_line;
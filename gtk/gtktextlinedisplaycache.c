@@ -25,6 +25,7 @@
 #include "gtktextlinedisplaycacheprivate.h"
 
 #define DEFAULT_MRU_SIZE         250
+#define MAX_CACHED_CHARS         (512 * 1024)
 #define BLOW_CACHE_TIMEOUT_SEC   20
 #define DEBUG_LINE_DISPLAY_CACHE 0
 
@@ -36,6 +37,7 @@ struct _GtkTextLineDisplayCache
   GQueue       mru;
   GSource     *evict_source;
   guint        mru_size;
+  gsize        mru_chars;
 
 #if DEBUG_LINE_DISPLAY_CACHE
   guint       log_source;
@@ -56,11 +58,11 @@ static gboolean
 dump_stats (gpointer data)
 {
   GtkTextLineDisplayCache *cache = data;
-  g_printerr ("%p: size=%u hits=%d misses=%d inval_total=%d "
+  g_printerr ("%p: size=%u chars=%"G_GSIZE_FORMAT" hits=%d misses=%d inval_total=%d "
               "inval_cursors=%d inval_by_line=%d "
               "inval_by_range=%d inval_by_y_range=%d\n",
               cache, g_hash_table_size (cache->line_to_display),
-              cache->hits, cache->misses,
+              cache->mru_chars, cache->hits, cache->misses,
               cache->inval, cache->inval_cursors,
               cache->inval_by_line, cache->inval_by_range,
               cache->inval_by_y_range);
@@ -145,6 +147,29 @@ gtk_text_line_display_cache_delay_eviction (GtkTextLineDisplayCache *cache)
     }
 }
 
+/* The text of a display is set once when it is created, so this
+ * stays stable for as long as the display is in the cache.
+ */
+static inline guint
+gtk_text_line_display_get_n_chars (GtkTextLineDisplay *display)
+{
+  if (display->layout == NULL)
+    return 0;
+
+  return pango_layout_get_character_count (display->layout);
+}
+
+static inline gboolean
+gtk_text_line_display_cache_is_full (GtkTextLineDisplayCache *cache)
+{
+  /* Bound the cache by the amount of text it holds as well as by the
+   * number of lines, so that a few very long lines don't keep huge
+   * layouts alive. The most recently used display is always kept.
+   */
+  return cache->mru.length > cache->mru_size ||
+         (cache->mru.length > 1 && cache->mru_chars > MAX_CACHED_CHARS);
+}
+
 #if DEBUG_LINE_DISPLAY_CACHE
 static void
 check_disposition (GtkTextLineDisplayCache *cache,
@@ -200,9 +225,10 @@ gtk_text_line_display_cache_take_display (GtkTextLineDisplayCache *cache,
                               layout);
   g_hash_table_insert (cache->line_to_display, display->line, display);
   g_queue_push_head_link (&cache->mru, &display->mru_link);
+  cache->mru_chars += gtk_text_line_display_get_n_chars (display);
 
   /* Cull the cache if we're at capacity */
-  while (cache->mru.length > cache->mru_size)
+  while (gtk_text_line_display_cache_is_full (cache))
     {
       display = g_queue_peek_tail (&cache->mru);
 
@@ -247,6 +273,7 @@ gtk_text_line_display_cache_invalidate_display (GtkTextLineDisplayCache *cache,
 
       g_hash_table_remove (cache->line_to_display, display->line);
       g_queue_unlink (&cache->mru, &display->mru_link);
+      cache->mru_chars -= gtk_text_line_display_get_n_chars (display);
 
       if (iter != NULL)
         g_sequence_remove (iter);
@@ -753,7 +780,7 @@ gtk_text_line_display_cache_set_mru_size (GtkTextLineDisplayCache *cache,
     {
       cache->mru_size = mru_size;
 
-      while (cache->mru.length > cache->mru_size)
+      while (gtk_text_line_display_cache_is_full (cache))
         {
           display = g_queue_peek_tail (&cache->mru);
 
@@ -337,6 +337,11 @@ char_segment_cleanup_func (GtkTextLineSegment *segPtr, GtkTextLine *line)
       return segPtr;
     }
 
+  if (segPtr->byte_count + segPtr2->byte_count > GTK_TEXT_CHAR_SEGMENT_MAX_BYTES)
+    {
+      return segPtr;
+    }
+
   newPtr =
     _gtk_char_segment_new_from_two_strings (segPtr->body.chars, 
 					    segPtr->byte_count,
@@ -415,7 +420,8 @@ char_segment_check_func (GtkTextLineSegment *segPtr, GtkTextLine *line)
 
   if (segPtr->next != NULL)
     {
-      if (segPtr->next->type == &gtk_text_char_type)
+      if (segPtr->next->type == &gtk_text_char_type &&
+          segPtr->byte_count + segPtr->next->byte_count <= GTK_TEXT_CHAR_SEGMENT_MAX_BYTES)
         {
           g_error ("adjacent character segments weren't merged");
         }
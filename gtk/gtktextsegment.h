@@ -124,6 +124,13 @@ struct _GtkTextLineSegmentClass {
                                         * segment. */
 };
 
+/*
+ * Adjacent character segments are only merged while the result stays
+ * below this size, so that locating an offset inside a segment does
+ * not need to scan the whole of a very long line.
+ */
+#define GTK_TEXT_CHAR_SEGMENT_MAX_BYTES 4096
+
 /*
  * The data structure below defines line segments.
  */
@@ -145,6 +145,9 @@
 
 #define SPACE_FOR_CURSOR 1
 
+/* How long the idle that validates offscreen lines may run each time */
+#define GTK_TEXT_VIEW_TIME_MS_PER_IDLE 8
+
 typedef struct _GtkTextWindow GtkTextWindow;
 typedef struct _GtkTextPendingScroll GtkTextPendingScroll;
 
@@ -4662,10 +4665,19 @@ incremental_validate_callback (gpointer data)
 {
   GtkTextView *text_view = data;
   gboolean result = TRUE;
+  gint64 end_time;
 
   DV(g_print(G_STRLOC"\n"));
-  
-  gtk_text_layout_validate (text_view->priv->layout, 2000);
+
+  /* Validate in small chunks until the time for this idle is used up,
+   * so the scroll range of large buffers converges in far fewer idles
+   * instead of one per 2000 pixels of text.
+   */
+  end_time = g_get_monotonic_time () + GTK_TEXT_VIEW_TIME_MS_PER_IDLE * 1000;
+  do
+    gtk_text_layout_validate (text_view->priv->layout, 2000);
+  while (!gtk_text_layout_is_valid (text_view->priv->layout) &&
+         g_get_monotonic_time () < end_time);
 
   gtk_text_view_update_adjustments (text_view);
   
@@ -19,7 +19,7 @@
 
 #include "config.h"
 
-#include "gtktreelistmodel.h"
+#include "gtktreelistmodelprivate.h"
 
 #include "gtkrbtreeprivate.h"
 #include "gtkintl.h"
@@ -43,14 +43,22 @@ enum {
   NUM_PROPERTIES
 };
 
+/* Child models of collapsed rows (and the ones created to check if a
+ * row is expandable) are kept around for a while, so that expanding a
+ * row again doesn't need to create them again. */
+#define MAX_CACHED_MODELS 64
+#define CACHE_TIMEOUT_SECONDS 5
+
 typedef struct _TreeNode TreeNode;
 typedef struct _TreeAugment TreeAugment;
+typedef struct _CachedModel CachedModel;
 
 struct _TreeNode
 {
   GListModel *model;
   GtkTreeListRow *row;
   GtkRbTree *children;
+  GList *cached; /* link in cached_models while collapsed */
   union {
     TreeNode *parent;
     GtkTreeListModel *list;
@@ -60,6 +68,13 @@ struct _TreeNode
   guint is_root : 1;
 };
 
+struct _CachedModel
+{
+  TreeNode *node;
+  GListModel *model;
+  gint64 time;
+};
+
 struct _TreeAugment
 {
   guint n_items;
@@ -76,6 +91,10 @@ struct _GtkTreeListModel
   gpointer user_data;
   GDestroyNotify user_destroy;
 
+  GQueue cached_models; /* most recently used first */
+  guint cache_timeout;
+  guint n_expanded;
+
   guint autoexpand : 1;
   guint passthrough : 1;
 };
@@ -315,6 +334,84 @@ gtk_tree_list_model_get_nth (GtkTreeListModel *self,
   g_return_val_if_reached (NULL);
 }
 
+static void
+cached_model_free (gpointer data)
+{
+  CachedModel *cached = data;
+
+  cached->node->cached = NULL;
+  g_object_unref (cached->model);
+  g_slice_free (CachedModel, cached);
+}
+
+static GListModel *
+gtk_tree_list_model_steal_cached_model (GtkTreeListModel *self,
+                                        TreeNode         *node)
+{
+  GListModel *model;
+  GList *link;
+
+  if (node->cached == NULL)
+    return NULL;
+
+  link = node->cached;
+  model = g_object_ref (((CachedModel *) link->data)->model);
+  g_queue_unlink (&self->cached_models, link);
+  cached_model_free (link->data);
+  g_list_free_1 (link);
+
+  return model;
+}
+
+static gboolean
+gtk_tree_list_model_cache_timeout_cb (gpointer data)
+{
+  GtkTreeListModel *self = data;
+  gint64 cutoff = g_get_monotonic_time () - CACHE_TIMEOUT_SECONDS * G_USEC_PER_SEC;
+
+  while (self->cached_models.tail &&
+         ((CachedModel *) self->cached_models.tail->data)->time <= cutoff)
+    cached_model_free (g_queue_pop_tail (&self->cached_models));
+
+  if (g_queue_is_empty (&self->cached_models))
+    {
+      self->cache_timeout = 0;
+      return G_SOURCE_REMOVE;
+    }
+
+  return G_SOURCE_CONTINUE;
+}
+
+/* Takes ownership of model */
+static void
+gtk_tree_list_model_cache_model (GtkTreeListModel *self,
+                                 TreeNode         *node,
+                                 GListModel       *model)
+{
+  CachedModel *cached;
+
+  g_assert (node->cached == NULL);
+
+  cached = g_slice_new (CachedModel);
+  cached->node = node;
+  cached->model = model;
+  cached->time = g_get_monotonic_time ();
+
+  g_queue_push_head (&self->cached_models, cached);
+  node->cached = self->cached_models.head;
+
+  if (self->cached_models.length > MAX_CACHED_MODELS)
+    cached_model_free (g_queue_pop_tail (&self->cached_models));
+
+  if (self->cache_timeout == 0)
+    {
+      self->cache_timeout = g_timeout_add_seconds (CACHE_TIMEOUT_SECONDS,
+                                                   gtk_tree_list_model_cache_timeout_cb,
+                                                   self);
+      g_source_set_name_by_id (self->cache_timeout, "[gtk] gtk_tree_list_model_cache_timeout_cb");
+    }
+}
+
 static GListModel *
 tree_node_create_model (GtkTreeListModel *self,
                         TreeNode         *node)
@@ -323,6 +420,10 @@ tree_node_create_model (GtkTreeListModel *self,
   GListModel *model;
   GObject *item;
 
+  model = gtk_tree_list_model_steal_cached_model (self, node);
+  if (model)
+    return model;
+
   item = g_list_model_get_item (parent->model,
                                 tree_node_get_local_position (parent->children, node));
   model = self->create_func (item, self->user_data);
@@ -448,12 +549,24 @@ gtk_tree_list_model_clear_node (gpointer data)
   if (node->row)
     gtk_tree_list_row_destroy (node->row);
 
+  if (node->cached)
+    {
+      GtkTreeListModel *self = tree_node_get_tree_list_model (node);
+      GList *link = node->cached;
+
+      g_queue_unlink (&self->cached_models, link);
+      cached_model_free (link->data);
+      g_list_free_1 (link);
+    }
+
   if (node->model)
     {
       g_signal_handlers_disconnect_by_func (node->model,
                                             gtk_tree_list_model_items_changed_cb,
                                             node);
       g_object_unref (node->model);
+      if (!node->is_root)
+        tree_node_get_tree_list_model (node)->n_expanded--;
     }
   if (node->children)
     gtk_rb_tree_unref (node->children);
@@ -534,6 +647,7 @@ gtk_tree_list_model_expand_node (GtkTreeListModel *self,
     return 0;
   
   gtk_tree_list_model_init_node (self, node, model);
+  self->n_expanded++;
 
   tree_node_mark_dirty (node);
   
@@ -552,7 +666,11 @@ gtk_tree_list_model_collapse_node (GtkTreeListModel *self,
   n_items = tree_node_get_n_children (node);
 
   g_clear_pointer (&node->children, gtk_rb_tree_unref);
-  g_clear_object (&node->model);
+  g_signal_handlers_disconnect_by_func (node->model,
+                                        gtk_tree_list_model_items_changed_cb,
+                                        node);
+  gtk_tree_list_model_cache_model (self, node, g_steal_pointer (&node->model));
+  self->n_expanded--;
 
   tree_node_mark_dirty (node);
 
@@ -669,6 +787,8 @@ gtk_tree_list_model_finalize (GObject *object)
   GtkTreeListModel *self = GTK_TREE_LIST_MODEL (object);
 
   gtk_tree_list_model_clear_node (&self->root_node);
+  g_queue_clear_full (&self->cached_models, cached_model_free);
+  g_clear_handle_id (&self->cache_timeout, g_source_remove);
   if (self->user_destroy)
     self->user_destroy (self->user_data);
 
@@ -853,6 +973,20 @@ gtk_tree_list_model_get_autoexpand (GtkTreeListModel *self)
   return self->autoexpand;
 }
 
+/* For the inspector and benchmarks */
+void
+gtk_tree_list_model_get_stats (GtkTreeListModel *self,
+                               guint            *n_expanded,
+                               guint            *n_cached)
+{
+  g_return_if_fail (GTK_IS_TREE_LIST_MODEL (self));
+
+  if (n_expanded)
+    *n_expanded = self->n_expanded;
+  if (n_cached)
+    *n_cached = self->cached_models.length;
+}
+
 /**
  * gtk_tree_list_model_get_row:
  * @self: a #GtkTreeListModel
@@ -1267,7 +1401,8 @@ gtk_tree_list_row_is_expandable (GtkTreeListRow *self)
   model = tree_node_create_model (list, self->node);
   if (model)
     {
-      g_object_unref (model);
+      /* the row is likely going to be expanded next */
+      gtk_tree_list_model_cache_model (list, self->node, model);
       return TRUE;
     }
 
@@ -757,30 +757,45 @@ gtk_tree_rbtree_mark_invalid (GtkTreeRBTree *tree)
     }
 }
 
-void
-gtk_tree_rbtree_set_fixed_height (GtkTreeRBTree *tree,
+static void
+gtk_tree_rbnode_set_fixed_height (GtkTreeRBTree *tree,
+                                  GtkTreeRBNode *node,
                                   int            height,
                                   gboolean       mark_valid)
 {
-  GtkTreeRBNode *node;
+  if (gtk_tree_rbtree_is_nil (node))
+    return;
 
-  if (tree == NULL)
+  /* Invalid nodes mark all their ancestors, so when marking valid
+   * we can skip the subtrees that have nothing left to do. */
+  if (mark_valid &&
+      !GTK_TREE_RBNODE_FLAG_SET (node, GTK_TREE_RBNODE_DESCENDANTS_INVALID))
     return;
 
-  for (node = gtk_tree_rbtree_first (tree);
-       node != NULL;
-       node = gtk_tree_rbtree_next (tree, node))
-    {
-      if (GTK_TREE_RBNODE_FLAG_SET (node, GTK_TREE_RBNODE_INVALID))
-        {
-          gtk_tree_rbtree_node_set_height (tree, node, height);
-          if (mark_valid)
-            gtk_tree_rbtree_node_mark_valid (tree, node);
-        }
+  gtk_tree_rbnode_set_fixed_height (tree, node->left, height, mark_valid);
 
-      if (node->children)
-        gtk_tree_rbtree_set_fixed_height (node->children, height, mark_valid);
+  if (GTK_TREE_RBNODE_FLAG_SET (node, GTK_TREE_RBNODE_INVALID))
+    {
+      gtk_tree_rbtree_node_set_height (tree, node, height);
+      if (mark_valid)
+        gtk_tree_rbtree_node_mark_valid (tree, node);
     }
+
+  if (node->children)
+    gtk_tree_rbnode_set_fixed_height (node->children, node->children->root, height, mark_valid);
+
+  gtk_tree_rbnode_set_fixed_height (tree, node->right, height, mark_valid);
+}
+
+void
+gtk_tree_rbtree_set_fixed_height (GtkTreeRBTree *tree,
+                                  int            height,
+                                  gboolean       mark_valid)
+{
+  if (tree == NULL)
+    return;
+
+  gtk_tree_rbnode_set_fixed_height (tree, tree->root, height, mark_valid);
 }
 
 static void
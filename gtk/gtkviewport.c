@@ -552,6 +552,11 @@ gtk_viewport_size_allocate (GtkWidget *widget,
     {
       GtkAllocation child_allocation;
 
+      /* The child gets its full size, not just the visible part, so
+       * it is snapshot as a whole and content just outside the view is
+       * already recorded when scrolling brings it in. Scrolling only
+       * moves the child, which keeps its render node.
+       */
       child_allocation.x = - gtk_adjustment_get_value (hadjustment);
       child_allocation.y = - gtk_adjustment_get_value (vadjustment);
       child_allocation.width = gtk_adjustment_get_upper (hadjustment);
@@ -38,6 +38,7 @@
 #include "gtkcsstransformvalueprivate.h"
 #include "gtkcssfontvariationsvalueprivate.h"
 #include "gtkcssnumbervalueprivate.h"
+#include "gtkcssstaticstyleprivate.h"
 #include "gtkcssstylepropertyprivate.h"
 #include "gtkcsswidgetnodeprivate.h"
 #include "gtkdebug.h"
@@ -583,6 +584,13 @@ static gboolean		gtk_widget_real_keynav_failed		(GtkWidget        *widget,
 								 GtkDirectionType  direction);
 #ifdef G_ENABLE_CONSISTENCY_CHECKS
 static void             gtk_widget_verify_invariants            (GtkWidget        *widget);
+static void             gtk_widget_invalidate_pick_bounds       (GtkWidget        *widget);
+static gboolean         gtk_widget_ensure_pick_bounds           (GtkWidget        *widget);
+static void             gtk_widget_pick_index_free              (GtkWidgetPickIndex *index);
+static GtkWidget *      gtk_widget_do_pick                      (GtkWidget        *widget,
+                                                                 double            x,
+                                                                 double            y,
+                                                                 GtkPickFlags      flags);
 static void             gtk_widget_push_verify_invariants       (GtkWidget        *widget);
 static void             gtk_widget_pop_verify_invariants        (GtkWidget        *widget);
 #else
@@ -670,6 +678,14 @@ static GQuark           quark_action_muxer = 0;
 static GQuark           quark_font_options = 0;
 static GQuark           quark_font_map = 0;
 
+static GHashTable      *widget_costs = NULL;
+static GtkWidgetCostFrame *current_cost_frame = NULL;
+static gint64           widget_mark_threshold = -1;
+
+static guint            n_pango_layouts_created = 0;
+static GtkAllocationCounts allocation_totals = { 0, };
+static GtkAllocationCounts frame_allocations = { 0, };
+
 /* --- functions --- */
 GType
 gtk_widget_get_type (void)
@@ -878,6 +894,9 @@ gtk_widget_class_init (GtkWidgetClass *klass)
   quark_auto_children = g_quark_from_static_string ("gtk-widget-auto-children");
   quark_action_muxer = g_quark_from_static_string ("gtk-widget-action-muxer");
   quark_font_options = g_quark_from_static_string ("gtk-widget-font-options");
+
+  if (g_getenv ("GTK_PROFILER_WIDGET_THRESHOLD"))
+    widget_mark_threshold = g_ascii_strtoll (g_getenv ("GTK_PROFILER_WIDGET_THRESHOLD"), NULL, 10);
   quark_font_map = g_quark_from_static_string ("gtk-widget-font-map");
 
   gobject_class->constructed = gtk_widget_constructed;
@@ -2298,8 +2317,13 @@ gtk_widget_init (GTypeInstance *instance, gpointer g_class)
   priv->at_context = gtk_accessible_get_at_context (GTK_ACCESSIBLE (widget));
 }
 
+/* Only the ATContext of the root is realized when a widget gets
+ * rooted. The contexts of other widgets are prepared here, and get
+ * realized by the AT backend when an assistive technology actually
+ * looks at them, or when they receive focus.
+ */
 static void
-gtk_widget_realize_at_context (GtkWidget *self)
+gtk_widget_prepare_at_context (GtkWidget *self)
 {
   GtkWidgetPrivate *priv = gtk_widget_get_instance_private (self);
   GtkAccessibleRole role = priv->accessible_role;
@@ -2307,10 +2331,6 @@ gtk_widget_realize_at_context (GtkWidget *self)
   if (priv->at_context == NULL || gtk_at_context_is_realized (priv->at_context))
     return;
 
-  /* Realize the root ATContext first */
-  if (!GTK_IS_ROOT (self))
-    gtk_widget_realize_at_context (GTK_WIDGET (priv->root));
-
   /* Reset the accessible role to its current value */
   if (role == GTK_ACCESSIBLE_ROLE_WIDGET)
     {
@@ -2321,7 +2341,9 @@ gtk_widget_realize_at_context (GtkWidget *self)
 
   gtk_at_context_set_accessible_role (priv->at_context, role);
   gtk_at_context_set_display (priv->at_context, gtk_root_get_display (priv->root));
-  gtk_at_context_realize (priv->at_context);
+
+  if (GTK_IS_ROOT (self))
+    gtk_at_context_realize (priv->at_context);
 }
 
 void
@@ -2352,7 +2374,7 @@ gtk_widget_root (GtkWidget *widget)
   if (priv->layout_manager)
     gtk_layout_manager_set_root (priv->layout_manager, priv->root);
 
-  gtk_widget_realize_at_context (widget);
+  gtk_widget_prepare_at_context (widget);
 
   GTK_WIDGET_GET_CLASS (widget)->root (widget);
 
@@ -2467,6 +2489,8 @@ gtk_widget_unparent (GtkWidget *widget)
   old_parent = priv->parent;
   if (old_parent)
     {
+      gtk_widget_invalidate_pick_bounds (old_parent);
+
       if (old_parent->priv->first_child == widget)
         old_parent->priv->first_child = priv->next_sibling;
 
@@ -2482,6 +2506,7 @@ gtk_widget_unparent (GtkWidget *widget)
   priv->parent = NULL;
   priv->prev_sibling = NULL;
   priv->next_sibling = NULL;
+  priv->resize_boundary = FALSE;
 
   /* parent may no longer expand if the removed
    * child was expand=TRUE and could therefore
@@ -3477,7 +3502,7 @@ gtk_widget_queue_resize_internal (GtkWidget *widget)
       GtkWidget *parent = _gtk_widget_get_parent (widget);
       if (parent)
         {
-          if (GTK_IS_NATIVE (widget))
+          if (GTK_IS_NATIVE (widget) || priv->resize_boundary)
             gtk_widget_queue_allocate (parent);
           else
             gtk_widget_queue_resize_internal (parent);
@@ -3773,6 +3798,7 @@ gtk_widget_allocate (GtkWidget    *widget,
   GtkCssStyle *style;
   GtkBorder margin, border, padding;
   GskTransform *css_transform;
+  GtkWidgetCostFrame cost_frame;
 
   g_return_if_fail (GTK_IS_WIDGET (widget));
   g_return_if_fail (baseline >= -1);
@@ -3881,6 +3907,9 @@ gtk_widget_allocate (GtkWidget    *widget,
   if (adjusted.x || adjusted.y)
     transform = gsk_transform_translate (transform, &GRAPHENE_POINT_INIT (adjusted.x, adjusted.y));
 
+  if (alloc_needed || !gsk_transform_equal (priv->transform, transform))
+    gtk_widget_invalidate_pick_bounds (widget);
+
   gsk_transform_unref (priv->transform);
   priv->transform = transform;
 
@@ -3894,6 +3923,8 @@ gtk_widget_allocate (GtkWidget    *widget,
   adjusted.height -= border.top + padding.top +
                      border.bottom + padding.bottom;
   size_changed = (priv->width != adjusted.width) || (priv->height != adjusted.height);
+  if (size_changed)
+    gtk_widget_invalidate_pick_bounds (widget);
 
   if (!alloc_needed && !size_changed && !baseline_changed)
     goto skip_allocate;
@@ -3902,6 +3933,8 @@ gtk_widget_allocate (GtkWidget    *widget,
   priv->height = adjusted.height;
   priv->baseline = baseline;
 
+  gtk_widget_cost_begin (&cost_frame);
+
   if (priv->layout_manager != NULL)
     {
       gtk_layout_manager_allocate (priv->layout_manager, widget,
@@ -3917,6 +3950,8 @@ gtk_widget_allocate (GtkWidget    *widget,
                                                     baseline);
     }
 
+  gtk_widget_cost_end (&cost_frame, widget, GTK_WIDGET_COST_ALLOCATE);
+
   /* Size allocation is god... after consulting god, no further requests or allocations are needed */
 #ifdef G_ENABLE_DEBUG
   if (GTK_DISPLAY_DEBUG_CHECK (_gtk_widget_get_display (widget), GEOMETRY) &&
@@ -3937,6 +3972,11 @@ gtk_widget_allocate (GtkWidget    *widget,
     gtk_accessible_bounds_changed (GTK_ACCESSIBLE (widget));
 
 skip_allocate:
+  /* If only the position changed, our render node is still good:
+   * gtk_widget_snapshot_child() wraps it with the new transform when
+   * the parent gets snapshot, so only the parent needs to redraw.
+   * This is what keeps scrolling and moving widgets cheap, don't
+   * queue a draw on the widget itself in that case. */
   if (size_changed || baseline_changed)
     gtk_widget_queue_draw (widget);
   else if (transform_changed && priv->parent)
@@ -5788,6 +5828,8 @@ gtk_widget_reposition_after (GtkWidget *widget,
   prev_parent = priv->parent;
   prev_previous = priv->prev_sibling;
 
+  gtk_widget_invalidate_pick_bounds (parent);
+
   if (priv->parent != NULL && priv->parent != parent)
     {
       g_warning ("Can't set new parent %s %p on widget %s %p, "
@@ -6453,6 +6495,7 @@ gtk_widget_create_pango_layout (GtkWidget   *widget,
 
   context = gtk_widget_get_pango_context (widget);
   layout = pango_layout_new (context);
+  n_pango_layouts_created++;
 
   if (text)
     pango_layout_set_text (layout, text, -1);
@@ -7353,6 +7396,7 @@ gtk_widget_finalize (GObject *object)
 
   g_clear_pointer (&priv->transform, gsk_transform_unref);
   g_clear_pointer (&priv->allocated_transform, gsk_transform_unref);
+  g_clear_pointer (&priv->pick_index, gtk_widget_pick_index_free);
 
   gtk_css_widget_node_widget_destroyed (GTK_CSS_WIDGET_NODE (priv->cssnode));
   g_object_unref (priv->cssnode);
@@ -9840,6 +9884,272 @@ gtk_widget_can_be_picked (GtkWidget    *widget,
   return TRUE;
 }
 
+/* Containers with at least this many children keep a grid of their
+ * children's pick bounds, so that picking doesn't need to look at all
+ * of them. Smaller ones just check the pick bounds of each child.
+ */
+#define PICK_INDEX_MIN_CHILDREN 64
+
+struct _GtkWidgetPickIndex
+{
+  graphene_rect_t bounds;
+  guint n_columns;
+  guint n_rows;
+  float cell_width;
+  float cell_height;
+  GtkWidget **children; /* in sibling order, no reference */
+  GArray **cells; /* of indexes into children, ascending */
+};
+
+static void
+gtk_widget_pick_index_free (GtkWidgetPickIndex *index)
+{
+  guint i;
+
+  for (i = 0; i < index->n_columns * index->n_rows; i++)
+    {
+      if (index->cells[i])
+        g_array_unref (index->cells[i]);
+    }
+  g_free (index->cells);
+  g_free (index->children);
+  g_slice_free (GtkWidgetPickIndex, index);
+}
+
+/* The pick bounds of a widget contain everything in it and its children
+ * that gtk_widget_do_pick() can return. Allocating a widget and changing
+ * children invalidates them for the widget and all its ancestors.
+ */
+static void
+gtk_widget_invalidate_pick_bounds (GtkWidget *widget)
+{
+  for (; widget; widget = widget->priv->parent)
+    {
+      GtkWidgetPrivate *priv = widget->priv;
+
+      if (!priv->pick_bounds_valid)
+        break;
+
+      priv->pick_bounds_valid = FALSE;
+      g_clear_pointer (&priv->pick_index, gtk_widget_pick_index_free);
+    }
+}
+
+/* Returns FALSE if the child can't be bounded in parent coordinates */
+static gboolean
+gtk_widget_get_child_pick_bounds (GtkWidget       *child,
+                                  graphene_rect_t *bounds)
+{
+  GtkWidgetPrivate *priv = child->priv;
+
+  if (!gtk_widget_ensure_pick_bounds (child))
+    return FALSE;
+
+  if (priv->transform == NULL)
+    {
+      *bounds = priv->pick_bounds;
+    }
+  else if (gsk_transform_get_category (priv->transform) >= GSK_TRANSFORM_CATEGORY_2D_AFFINE)
+    {
+      graphene_point_t offset;
+
+      /* gtk_widget_do_pick() only looks at the offset for these */
+      gsk_transform_transform_point (priv->transform, &GRAPHENE_POINT_INIT (0, 0), &offset);
+      graphene_rect_offset_r (&priv->pick_bounds, offset.x, offset.y, bounds);
+    }
+  else if (gsk_transform_get_category (priv->transform) == GSK_TRANSFORM_CATEGORY_2D)
+    {
+      gsk_transform_transform_bounds (priv->transform, &priv->pick_bounds, bounds);
+    }
+  else
+    {
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+static GtkWidgetPickIndex *
+gtk_widget_pick_index_new (GtkWidget *widget,
+                           guint      n_children)
+{
+  GtkWidgetPickIndex *index;
+  graphene_rect_t *child_bounds;
+  GtkWidget *child;
+  gboolean have_bounds;
+  guint i, side;
+
+  index = g_slice_new0 (GtkWidgetPickIndex);
+  index->children = g_new (GtkWidget *, n_children);
+  child_bounds = g_new (graphene_rect_t, n_children);
+  have_bounds = FALSE;
+
+  for (child = _gtk_widget_get_first_child (widget), i = 0;
+       child;
+       child = _gtk_widget_get_next_sibling (child), i++)
+    {
+      if (GTK_IS_NATIVE (child))
+        {
+          index->children[i] = NULL;
+          continue;
+        }
+
+      index->children[i] = child;
+      gtk_widget_get_child_pick_bounds (child, &child_bounds[i]);
+      /* leave some room for rounding errors */
+      graphene_rect_inset (&child_bounds[i], -1, -1);
+
+      if (have_bounds)
+        graphene_rect_union (&index->bounds, &child_bounds[i], &index->bounds);
+      else
+        index->bounds = child_bounds[i];
+      have_bounds = TRUE;
+    }
+
+  side = ceil (sqrt (n_children));
+  index->n_columns = side;
+  index->n_rows = side;
+  index->cell_width = MAX (index->bounds.size.width / side, 1);
+  index->cell_height = MAX (index->bounds.size.height / side, 1);
+  index->cells = g_new0 (GArray *, side * side);
+
+  for (i = 0; i < n_children; i++)
+    {
+      guint x0, x1, y0, y1, x, y;
+
+      if (index->children[i] == NULL)
+        continue;
+
+      x0 = MIN ((child_bounds[i].origin.x - index->bounds.origin.x) / index->cell_width, side - 1);
+      x1 = MIN ((child_bounds[i].origin.x + child_bounds[i].size.width - index->bounds.origin.x) / index->cell_width, side - 1);
+      y0 = MIN ((child_bounds[i].origin.y - index->bounds.origin.y) / index->cell_height, side - 1);
+      y1 = MIN ((child_bounds[i].origin.y + child_bounds[i].size.height - index->bounds.origin.y) / index->cell_height, side - 1);
+
+      for (y = y0; y <= y1; y++)
+        for (x = x0; x <= x1; x++)
+          {
+            GArray **cell = &index->cells[y * side + x];
+
+            if (*cell == NULL)
+              *cell = g_array_new (FALSE, FALSE, sizeof (guint));
+            g_array_append_val (*cell, i);
+          }
+    }
+
+  g_free (child_bounds);
+
+  return index;
+}
+
+/* Returns FALSE if the widget can't be bounded */
+static gboolean
+gtk_widget_ensure_pick_bounds (GtkWidget *widget)
+{
+  GtkWidgetPrivate *priv = widget->priv;
+  GtkCssBoxes boxes;
+  GtkWidget *child;
+  graphene_rect_t child_bounds;
+  gboolean children_bounded;
+  guint n_children;
+
+  if (priv->pick_bounds_valid)
+    return !priv->pick_bounds_unbounded;
+
+  priv->pick_bounds_valid = TRUE;
+  gtk_css_boxes_init (&boxes, widget);
+  priv->pick_bounds = *gtk_css_boxes_get_border_rect (&boxes);
+  /* we don't know what custom contains() implementations do */
+  priv->pick_bounds_unbounded = GTK_WIDGET_GET_CLASS (widget)->contains != gtk_widget_real_contains;
+
+  children_bounded = TRUE;
+  n_children = 0;
+  for (child = _gtk_widget_get_first_child (widget);
+       child;
+       child = _gtk_widget_get_next_sibling (child))
+    {
+      n_children++;
+
+      if (GTK_IS_NATIVE (child))
+        continue;
+
+      if (!gtk_widget_get_child_pick_bounds (child, &child_bounds))
+        children_bounded = FALSE;
+      else if (priv->overflow != GTK_OVERFLOW_HIDDEN)
+        graphene_rect_union (&priv->pick_bounds, &child_bounds, &priv->pick_bounds);
+    }
+
+  /* children are clipped to the padding box, which is inside the border box */
+  if (!children_bounded && priv->overflow != GTK_OVERFLOW_HIDDEN)
+    priv->pick_bounds_unbounded = TRUE;
+
+  if (children_bounded && n_children >= PICK_INDEX_MIN_CHILDREN)
+    priv->pick_index = gtk_widget_pick_index_new (widget, n_children);
+
+  return !priv->pick_bounds_unbounded;
+}
+
+static GtkWidget *
+gtk_widget_do_pick_child (GtkWidget    *child,
+                          double        x,
+                          double        y,
+                          GtkPickFlags  flags)
+{
+  GtkWidgetPrivate *child_priv = gtk_widget_get_instance_private (child);
+  graphene_point3d_t res;
+
+  if (!gtk_widget_can_be_picked (child, flags))
+    return NULL;
+
+  if (GTK_IS_NATIVE (child))
+    return NULL;
+
+  if (child_priv->transform)
+    {
+      if (gsk_transform_get_category (child_priv->transform) >= GSK_TRANSFORM_CATEGORY_2D_AFFINE)
+        {
+          graphene_point_t transformed_p;
+
+          gsk_transform_transform_point (child_priv->transform,
+                                         &(graphene_point_t) { 0, 0 },
+                                         &transformed_p);
+
+          graphene_point3d_init (&res, x - transformed_p.x, y - transformed_p.y, 0.);
+        }
+      else
+        {
+          GskTransform *transform;
+          graphene_matrix_t inv;
+          graphene_point3d_t p0, p1;
+
+          transform = gsk_transform_invert (gsk_transform_ref (child_priv->transform));
+          if (transform == NULL)
+            return NULL;
+
+          gsk_transform_to_matrix (transform, &inv);
+          gsk_transform_unref (transform);
+          graphene_point3d_init (&p0, x, y, 0);
+          graphene_point3d_init (&p1, x, y, 1);
+          graphene_matrix_transform_point3d (&inv, &p0, &p0);
+          graphene_matrix_transform_point3d (&inv, &p1, &p1);
+          if (fabs (p0.z - p1.z) < 1.f / 4096)
+            return NULL;
+
+          graphene_point3d_interpolate (&p0, &p1, p0.z / (p0.z - p1.z), &res);
+        }
+    }
+  else
+    {
+      graphene_point3d_init (&res, x, y, 0);
+    }
+
+  /* Skip the whole subtree if the point is outside of it */
+  if (gtk_widget_ensure_pick_bounds (child) &&
+      !graphene_rect_contains_point (&child_priv->pick_bounds, &GRAPHENE_POINT_INIT (res.x, res.y)))
+    return NULL;
+
+  return gtk_widget_do_pick (child, res.x, res.y, flags);
+}
+
 static GtkWidget *
 gtk_widget_do_pick (GtkWidget    *widget,
                     double        x,
@@ -9860,62 +10170,44 @@ gtk_widget_do_pick (GtkWidget    *widget,
         return NULL;
     }
 
-  for (child = _gtk_widget_get_last_child (widget);
-       child;
-       child = _gtk_widget_get_prev_sibling (child))
-    {
-      GtkWidgetPrivate *child_priv = gtk_widget_get_instance_private (child);
-      GtkWidget *picked;
-      graphene_point3d_t res;
-
-      if (!gtk_widget_can_be_picked (child, flags))
-        continue;
+  gtk_widget_ensure_pick_bounds (widget);
 
-      if (GTK_IS_NATIVE (child))
-        continue;
+  if (priv->pick_index)
+    {
+      GtkWidgetPickIndex *index = priv->pick_index;
 
-      if (child_priv->transform)
+      if (graphene_rect_contains_point (&index->bounds, &GRAPHENE_POINT_INIT (x, y)))
         {
-          if (gsk_transform_get_category (child_priv->transform) >= GSK_TRANSFORM_CATEGORY_2D_AFFINE)
-            {
-              graphene_point_t transformed_p;
+          guint column, row, i;
+          GArray *cell;
 
-              gsk_transform_transform_point (child_priv->transform,
-                                             &(graphene_point_t) { 0, 0 },
-                                             &transformed_p);
+          column = MIN ((x - index->bounds.origin.x) / index->cell_width, index->n_columns - 1);
+          row = MIN ((y - index->bounds.origin.y) / index->cell_height, index->n_rows - 1);
+          cell = index->cells[row * index->n_columns + column];
 
-              graphene_point3d_init (&res, x - transformed_p.x, y - transformed_p.y, 0.);
-            }
-          else
+          for (i = cell ? cell->len : 0; i-- > 0; )
             {
-              GskTransform *transform;
-              graphene_matrix_t inv;
-              graphene_point3d_t p0, p1;
+              GtkWidget *picked;
 
-              transform = gsk_transform_invert (gsk_transform_ref (child_priv->transform));
-              if (transform == NULL)
-                continue;
-
-              gsk_transform_to_matrix (transform, &inv);
-              gsk_transform_unref (transform);
-              graphene_point3d_init (&p0, x, y, 0);
-              graphene_point3d_init (&p1, x, y, 1);
-              graphene_matrix_transform_point3d (&inv, &p0, &p0);
-              graphene_matrix_transform_point3d (&inv, &p1, &p1);
-              if (fabs (p0.z - p1.z) < 1.f / 4096)
-                continue;
-
-              graphene_point3d_interpolate (&p0, &p1, p0.z / (p0.z - p1.z), &res);
+              child = index->children[g_array_index (cell, guint, i)];
+              picked = gtk_widget_do_pick_child (child, x, y, flags);
+              if (picked)
+                return picked;
             }
         }
-      else
+    }
+  else
+    {
+      for (child = _gtk_widget_get_last_child (widget);
+           child;
+           child = _gtk_widget_get_prev_sibling (child))
         {
-          graphene_point3d_init (&res, x, y, 0);
-        }
+          GtkWidget *picked;
 
-      picked = gtk_widget_do_pick (child, res.x, res.y, flags);
-      if (picked)
-        return picked;
+          picked = gtk_widget_do_pick_child (child, x, y, flags);
+          if (picked)
+            return picked;
+        }
     }
 
   if (!GTK_WIDGET_GET_CLASS (widget)->contains (widget, x, y))
@@ -10250,6 +10542,7 @@ gtk_widget_set_overflow (GtkWidget   *widget,
 
   priv->overflow = overflow;
 
+  gtk_widget_invalidate_pick_bounds (widget);
   gtk_widget_queue_draw (widget);
 
   g_object_notify_by_pspec (G_OBJECT (widget), widget_props[PROP_OVERFLOW]);
@@ -10401,6 +10694,31 @@ gtk_widget_ensure_allocate (GtkWidget *widget)
     }
 }
 
+/*
+ * gtk_widget_set_resize_boundary:
+ * @widget: a #GtkWidget
+ * @resize_boundary: %TRUE if the size of @widget's parent does
+ *     not depend on the size of @widget
+ *
+ * Marks @widget as a resize boundary. A gtk_widget_queue_resize()
+ * inside @widget then only reallocates the parent instead of
+ * propagating further up, so none of the ancestors get measured
+ * again.
+ *
+ * This is for parents like scrolled windows whose size request
+ * doesn't take the size of this child into account. The parent
+ * needs to clear the flag again when that stops being true. It
+ * gets cleared when @widget is unparented.
+ */
+void
+gtk_widget_set_resize_boundary (GtkWidget *widget,
+                                gboolean   resize_boundary)
+{
+  GtkWidgetPrivate *priv = gtk_widget_get_instance_private (widget);
+
+  priv->resize_boundary = !!resize_boundary;
+}
+
 void
 gtk_widget_ensure_resize (GtkWidget *widget)
 {
@@ -10714,6 +11032,7 @@ template_data_free (GtkWidgetTemplate *template_data)
   if (template_data)
     {
       g_bytes_unref (template_data->data);
+      g_clear_pointer (&template_data->cache, _gtk_builder_parse_cache_free);
       g_slist_free_full (template_data->children, (GDestroyNotify)template_child_class_free);
 
       g_object_unref (template_data->scope);
@@ -10845,6 +11164,7 @@ gtk_widget_init_template (GtkWidget *widget)
     gtk_builder_set_scope (builder, template->scope);
 
   gtk_builder_set_current_object (builder, G_OBJECT (widget));
+  _gtk_builder_set_parse_cache (builder, template->cache);
 
   /* This will build the template XML as children to the widget instance, also it
    * will validate that the template is created for the correct GType and assert that
@@ -10933,6 +11253,10 @@ gtk_widget_class_set_template (GtkWidgetClass    *widget_class,
     widget_class->priv->template->data = data;
   else
     widget_class->priv->template->data = g_bytes_ref (template_bytes);
+
+  if (_gtk_buildable_parser_is_precompiled (g_bytes_get_data (widget_class->priv->template->data, NULL),
+                                            g_bytes_get_size (widget_class->priv->template->data)))
+    widget_class->priv->template->cache = _gtk_builder_parse_cache_new (widget_class->priv->template->data);
 }
 
 /**
@@ -11409,6 +11733,8 @@ gtk_widget_create_render_node (GtkWidget   *widget,
   GtkCssValue *filter_value;
   double css_opacity, opacity;
   GtkCssStyle *style;
+  GtkWidgetCostFrame cost_frame;
+  GskRenderNode *node;
 
   style = gtk_css_node_get_style (priv->cssnode);
 
@@ -11418,6 +11744,8 @@ gtk_widget_create_render_node (GtkWidget   *widget,
   if (opacity <= 0.0)
     return NULL;
 
+  gtk_widget_cost_begin (&cost_frame);
+
   gtk_css_boxes_init (&boxes, widget);
 
   gtk_snapshot_push_collect (snapshot);
@@ -11454,7 +11782,11 @@ gtk_widget_create_render_node (GtkWidget   *widget,
 
   gtk_snapshot_pop (snapshot);
 
-  return gtk_snapshot_pop_collect (snapshot);
+  node = gtk_snapshot_pop_collect (snapshot);
+
+  gtk_widget_cost_end (&cost_frame, widget, GTK_WIDGET_COST_SNAPSHOT);
+
+  return node;
 }
 
 static void
@@ -11504,6 +11836,56 @@ gtk_widget_snapshot (GtkWidget   *widget,
     gtk_snapshot_append_node (snapshot, priv->render_node);
 }
 
+/* Called once per frame, after rendering. The allocation
+ * counters only ever increase, so the difference to the
+ * previous frame is what was allocated for this one.
+ */
+static void
+gtk_widget_report_allocation_counters (void)
+{
+  static guint render_nodes_counter, css_values_counter, css_styles_counter;
+  static guint snapshot_states_counter, pango_layouts_counter;
+  GtkAllocationCounts totals;
+
+  totals.render_nodes = gsk_render_node_get_n_allocated ();
+  totals.css_values = gtk_css_value_get_n_allocated ();
+  totals.css_styles = gtk_css_static_style_get_n_computed ();
+  totals.snapshot_states = gtk_snapshot_get_n_states_pushed ();
+  totals.pango_layouts = n_pango_layouts_created;
+
+  frame_allocations.render_nodes = totals.render_nodes - allocation_totals.render_nodes;
+  frame_allocations.css_values = totals.css_values - allocation_totals.css_values;
+  frame_allocations.css_styles = totals.css_styles - allocation_totals.css_styles;
+  frame_allocations.snapshot_states = totals.snapshot_states - allocation_totals.snapshot_states;
+  frame_allocations.pango_layouts = totals.pango_layouts - allocation_totals.pango_layouts;
+
+  allocation_totals = totals;
+
+  if (GDK_PROFILER_IS_RUNNING)
+    {
+      if (render_nodes_counter == 0)
+        {
+          render_nodes_counter = gdk_profiler_define_int_counter ("render-nodes", "Render nodes allocated per frame");
+          css_values_counter = gdk_profiler_define_int_counter ("css-values", "CSS values allocated per frame");
+          css_styles_counter = gdk_profiler_define_int_counter ("css-styles", "CSS styles computed per frame");
+          snapshot_states_counter = gdk_profiler_define_int_counter ("snapshot-states", "Snapshot states pushed per frame");
+          pango_layouts_counter = gdk_profiler_define_int_counter ("pango-layouts", "Pango layouts created per frame");
+        }
+
+      gdk_profiler_set_int_counter (render_nodes_counter, frame_allocations.render_nodes);
+      gdk_profiler_set_int_counter (css_values_counter, frame_allocations.css_values);
+      gdk_profiler_set_int_counter (css_styles_counter, frame_allocations.css_styles);
+      gdk_profiler_set_int_counter (snapshot_states_counter, frame_allocations.snapshot_states);
+      gdk_profiler_set_int_counter (pango_layouts_counter, frame_allocations.pango_layouts);
+    }
+}
+
+void
+gtk_widget_get_frame_allocations (GtkAllocationCounts *counts)
+{
+  *counts = frame_allocations;
+}
+
 void
 gtk_widget_render (GtkWidget            *widget,
                    GdkSurface           *surface,
@@ -11552,6 +11934,8 @@ gtk_widget_render (GtkWidget            *widget,
 
       gdk_profiler_end_mark (before_render, "widget render", "");
     }
+
+  gtk_widget_report_allocation_counters ();
 }
 
 static void
@@ -12797,3 +13181,96 @@ gtk_widget_set_active_state (GtkWidget *widget,
         gtk_widget_unset_state_flags (widget, GTK_STATE_FLAG_ACTIVE);
     }
 }
+
+/* While tracking is enabled, the time spent in measure, allocate,
+ * snapshot and style updates is accumulated per widget type. The
+ * time spent in nested widgets is subtracted, so the numbers can be
+ * compared across types.
+ *
+ * Independently, if GTK_PROFILER_WIDGET_THRESHOLD is set and sysprof
+ * is recording, a mark is emitted for every widget subtree that took
+ * at least that many microseconds in one of these phases.
+ */
+void
+gtk_widget_set_track_costs (gboolean track_costs)
+{
+  if (track_costs == (widget_costs != NULL))
+    return;
+
+  if (track_costs)
+    widget_costs = g_hash_table_new_full (NULL, NULL, NULL, g_free);
+  else
+    g_clear_pointer (&widget_costs, g_hash_table_unref);
+}
+
+/* Returns a table mapping widget GTypes to GtkWidgetCosts,
+ * or %NULL if tracking is not enabled
+ */
+GHashTable *
+gtk_widget_get_costs (void)
+{
+  return widget_costs;
+}
+
+void
+gtk_widget_cost_begin (GtkWidgetCostFrame *frame)
+{
+  if (G_LIKELY (widget_costs == NULL) &&
+      (widget_mark_threshold < 0 || !GDK_PROFILER_IS_RUNNING))
+    {
+      frame->start = 0;
+      return;
+    }
+
+  frame->parent = current_cost_frame;
+  frame->start = g_get_monotonic_time ();
+  frame->children = 0;
+  current_cost_frame = frame;
+}
+
+static const char *cost_mark_names[GTK_WIDGET_N_COSTS] G_GNUC_UNUSED = {
+  "widget measure",
+  "widget allocate",
+  "widget snapshot",
+  "widget css",
+};
+
+void
+gtk_widget_cost_end (GtkWidgetCostFrame *frame,
+                     GtkWidget          *widget,
+                     GtkWidgetCost       cost)
+{
+  GtkWidgetCosts *costs;
+  gint64 elapsed;
+
+  if (G_LIKELY (frame->start == 0))
+    return;
+
+  elapsed = g_get_monotonic_time () - frame->start;
+
+  current_cost_frame = frame->parent;
+  if (current_cost_frame)
+    current_cost_frame->children += elapsed;
+
+  if (widget == NULL)
+    return;
+
+  if (widget_mark_threshold >= 0 && elapsed >= widget_mark_threshold)
+    gdk_profiler_add_markf (frame->start * 1000, elapsed * 1000,
+                            cost_mark_names[cost],
+                            "%s %p", G_OBJECT_TYPE_NAME (widget), widget);
+
+  /* Tracking may have been turned off in the meantime */
+  if (widget_costs == NULL)
+    return;
+
+  costs = g_hash_table_lookup (widget_costs, GSIZE_TO_POINTER (G_OBJECT_TYPE (widget)));
+  if (costs == NULL)
+    {
+      costs = g_new0 (GtkWidgetCosts, 1);
+      g_hash_table_insert (widget_costs, GSIZE_TO_POINTER (G_OBJECT_TYPE (widget)), costs);
+    }
+
+  costs->time[cost] += elapsed - frame->children;
+  costs->calls[cost]++;
+}
@@ -34,6 +34,57 @@ struct _CompareInfo
   guint axis : 1;
 };
 
+/* The sort functions compare child bounds. Computing them once per
+ * child instead of twice per comparison keeps sorting large
+ * containers from being dominated by transform computations.
+ */
+typedef struct
+{
+  GtkWidget *widget;
+  graphene_rect_t bounds;
+  gboolean has_bounds;
+} FocusSortEntry;
+
+static FocusSortEntry *
+focus_sort_entries_new (GPtrArray *focus_order,
+                        GtkWidget *relative_to)
+{
+  FocusSortEntry *entries;
+  int i;
+
+  entries = g_new (FocusSortEntry, focus_order->len);
+
+  for (i = 0; i < focus_order->len; i ++)
+    {
+      GtkWidget *child = g_ptr_array_index (focus_order, i);
+
+      entries[i].widget = child;
+      entries[i].has_bounds = gtk_widget_compute_bounds (child,
+                                                         relative_to ? relative_to : gtk_widget_get_parent (child),
+                                                         &entries[i].bounds);
+    }
+
+  return entries;
+}
+
+/* Replaces the contents of @focus_order with the widgets of @entries,
+ * in order, and frees @entries.
+ */
+static void
+focus_sort_entries_apply (FocusSortEntry *entries,
+                          guint           n_entries,
+                          GPtrArray      *focus_order)
+{
+  guint i;
+
+  g_ptr_array_set_size (focus_order, 0);
+
+  for (i = 0; i < n_entries; i ++)
+    g_ptr_array_add (focus_order, entries[i].widget);
+
+  g_free (entries);
+}
+
 static inline void
 get_axis_info (const graphene_rect_t *bounds,
                int                    axis,
@@ -75,23 +126,21 @@ tab_sort_func (gconstpointer a,
                gconstpointer b,
                gpointer      user_data)
 {
-  graphene_rect_t child_bounds1, child_bounds2;
-  GtkWidget *child1 = *((GtkWidget **)a);
-  GtkWidget *child2 = *((GtkWidget **)b);
+  const FocusSortEntry *entry1 = a;
+  const FocusSortEntry *entry2 = b;
   GtkTextDirection text_direction = GPOINTER_TO_INT (user_data);
   float y1, y2;
 
-  if (!gtk_widget_compute_bounds (child1, gtk_widget_get_parent (child1), &child_bounds1) ||
-      !gtk_widget_compute_bounds (child2, gtk_widget_get_parent (child2), &child_bounds2))
+  if (!entry1->has_bounds || !entry2->has_bounds)
     return 0;
 
-  y1 = child_bounds1.origin.y + (child_bounds1.size.height / 2.0f);
-  y2 = child_bounds2.origin.y + (child_bounds2.size.height / 2.0f);
+  y1 = entry1->bounds.origin.y + (entry1->bounds.size.height / 2.0f);
+  y2 = entry2->bounds.origin.y + (entry2->bounds.size.height / 2.0f);
 
   if (y1 == y2)
     {
-      const float x1 = child_bounds1.origin.x + (child_bounds1.size.width / 2.0f);
-      const float x2 = child_bounds2.origin.x + (child_bounds2.size.width / 2.0f);
+      const float x1 = entry1->bounds.origin.x + (entry1->bounds.size.width / 2.0f);
+      const float x2 = entry2->bounds.origin.x + (entry2->bounds.size.width / 2.0f);
 
       if (text_direction == GTK_TEXT_DIR_RTL)
         return (x1 < x2) ? 1 : ((x1 == x2) ? 0 : -1);
@@ -108,8 +157,14 @@ focus_sort_tab (GtkWidget        *widget,
                 GPtrArray        *focus_order)
 {
   GtkTextDirection text_direction = _gtk_widget_get_direction (widget);
+  FocusSortEntry *entries;
+  guint n_entries;
 
-  g_ptr_array_sort_with_data (focus_order, tab_sort_func, GINT_TO_POINTER (text_direction));
+  n_entries = focus_order->len;
+  entries = focus_sort_entries_new (focus_order, NULL);
+  g_qsort_with_data (entries, n_entries, sizeof (FocusSortEntry),
+                     tab_sort_func, GINT_TO_POINTER (text_direction));
+  focus_sort_entries_apply (entries, n_entries, focus_order);
 
   if (direction == GTK_DIR_TAB_BACKWARD)
     reverse_ptr_array (focus_order);
@@ -170,18 +225,17 @@ axis_compare (gconstpointer a,
               gconstpointer b,
               gpointer      user_data)
 {
-  graphene_rect_t bounds1;
-  graphene_rect_t bounds2;
+  const FocusSortEntry *entry1 = a;
+  const FocusSortEntry *entry2 = b;
   CompareInfo *compare = user_data;
   int start1, end1;
   int start2, end2;
 
-  if (!gtk_widget_compute_bounds (*((GtkWidget **)a), compare->widget, &bounds1) ||
-      !gtk_widget_compute_bounds (*((GtkWidget **)b), compare->widget, &bounds2))
+  if (!entry1->has_bounds || !entry2->has_bounds)
     return 0;
 
-  get_axis_info (&bounds1, compare->axis, &start1, &end1);
-  get_axis_info (&bounds2, compare->axis, &start2, &end2);
+  get_axis_info (&entry1->bounds, compare->axis, &start1, &end1);
+  get_axis_info (&entry2->bounds, compare->axis, &start2, &end2);
 
   start1 = start1 + (end1 / 2);
   start2 = start2 + (end2 / 2);
@@ -189,8 +243,8 @@ axis_compare (gconstpointer a,
   if (start1 == start2)
     {
       /* Now use origin/bounds to compare the 2 widgets on the other axis */
-      get_axis_info (&bounds1, 1 - compare->axis, &start1, &end1);
-      get_axis_info (&bounds2, 1 - compare->axis, &start2, &end2);
+      get_axis_info (&entry1->bounds, 1 - compare->axis, &start1, &end1);
+      get_axis_info (&entry2->bounds, 1 - compare->axis, &start2, &end2);
 
       int x1 = abs (start1 + (end1 / 2) - compare->x);
       int x2 = abs (start2 + (end2 / 2) - compare->x);
@@ -212,6 +266,8 @@ focus_sort_left_right (GtkWidget        *widget,
   CompareInfo compare_info;
   GtkWidget *old_focus = gtk_widget_get_focus_child (widget);
   graphene_rect_t old_bounds;
+  FocusSortEntry *entries;
+  guint n_entries;
 
   compare_info.widget = widget;
   compare_info.reverse = (direction == GTK_DIR_LEFT);
@@ -219,12 +275,15 @@ focus_sort_left_right (GtkWidget        *widget,
   if (!old_focus)
     old_focus = find_old_focus (widget, focus_order);
 
+  n_entries = focus_order->len;
+  entries = focus_sort_entries_new (focus_order, widget);
+
   if (old_focus && gtk_widget_compute_bounds (old_focus, widget, &old_bounds))
     {
       float compare_y1;
       float compare_y2;
       float compare_x;
-      int i;
+      guint i, j;
 
       /* Delete widgets from list that don't match minimum criteria */
 
@@ -236,34 +295,29 @@ focus_sort_left_right (GtkWidget        *widget,
       else
         compare_x = old_bounds.origin.x + old_bounds.size.width;
 
-      for (i = 0; i < focus_order->len; i ++)
+      for (i = 0, j = 0; i < n_entries; i ++)
         {
-          GtkWidget *child = g_ptr_array_index (focus_order, i);
+          FocusSortEntry *entry = &entries[i];
 
-          if (child != old_focus)
+          if (entry->widget != old_focus)
             {
-              graphene_rect_t child_bounds;
-
-              if (gtk_widget_compute_bounds (child, widget, &child_bounds))
-                {
-                  const float child_y1 = child_bounds.origin.y;
-                  const float child_y2 = child_bounds.origin.y + child_bounds.size.height;
-
-                  if ((child_y2 <= compare_y1 || child_y1 >= compare_y2) /* No vertical overlap */ ||
-                      (direction == GTK_DIR_RIGHT && child_bounds.origin.x + child_bounds.size.width < compare_x) || /* Not to left */
-                      (direction == GTK_DIR_LEFT && child_bounds.origin.x > compare_x)) /* Not to right */
-                    {
-                      g_ptr_array_remove_index (focus_order, i);
-                      i --;
-                    }
-                }
-              else
-                {
-                  g_ptr_array_remove_index (focus_order, i);
-                  i --;
-                }
+              float child_y1, child_y2;
+
+              if (!entry->has_bounds)
+                continue;
+
+              child_y1 = entry->bounds.origin.y;
+              child_y2 = entry->bounds.origin.y + entry->bounds.size.height;
+
+              if ((child_y2 <= compare_y1 || child_y1 >= compare_y2) /* No vertical overlap */ ||
+                  (direction == GTK_DIR_RIGHT && entry->bounds.origin.x + entry->bounds.size.width < compare_x) || /* Not to left */
+                  (direction == GTK_DIR_LEFT && entry->bounds.origin.x > compare_x)) /* Not to right */
+                continue;
             }
+
+          entries[j++] = *entry;
         }
+      n_entries = j;
 
       compare_info.y = (compare_y1 + compare_y2) / 2;
       compare_info.x = old_bounds.origin.x + (old_bounds.size.width / 2.0f);
@@ -300,7 +354,9 @@ focus_sort_left_right (GtkWidget        *widget,
 
 
   compare_info.axis = HORIZONTAL;
-  g_ptr_array_sort_with_data (focus_order, axis_compare, &compare_info);
+  g_qsort_with_data (entries, n_entries, sizeof (FocusSortEntry),
+                     axis_compare, &compare_info);
+  focus_sort_entries_apply (entries, n_entries, focus_order);
 
   if (compare_info.reverse)
     reverse_ptr_array (focus_order);
@@ -314,6 +370,8 @@ focus_sort_up_down (GtkWidget        *widget,
   CompareInfo compare_info;
   GtkWidget *old_focus = gtk_widget_get_focus_child (widget);
   graphene_rect_t old_bounds;
+  FocusSortEntry *entries;
+  guint n_entries;
 
   compare_info.widget = widget;
   compare_info.reverse = (direction == GTK_DIR_UP);
@@ -321,12 +379,15 @@ focus_sort_up_down (GtkWidget        *widget,
   if (!old_focus)
     old_focus = find_old_focus (widget, focus_order);
 
+  n_entries = focus_order->len;
+  entries = focus_sort_entries_new (focus_order, widget);
+
   if (old_focus && gtk_widget_compute_bounds (old_focus, widget, &old_bounds))
     {
       float compare_x1;
       float compare_x2;
       float compare_y;
-      int i;
+      guint i, j;
 
       /* Delete widgets from list that don't match minimum criteria */
 
@@ -338,34 +399,29 @@ focus_sort_up_down (GtkWidget        *widget,
       else
         compare_y = old_bounds.origin.y + old_bounds.size.height;
 
-      for (i = 0; i < focus_order->len; i ++)
+      for (i = 0, j = 0; i < n_entries; i ++)
         {
-          GtkWidget *child = g_ptr_array_index (focus_order, i);
+          FocusSortEntry *entry = &entries[i];
 
-          if (child != old_focus)
+          if (entry->widget != old_focus)
             {
-              graphene_rect_t child_bounds;
-
-              if (gtk_widget_compute_bounds (child, widget, &child_bounds))
-                {
-                  const float child_x1 = child_bounds.origin.x;
-                  const float child_x2 = child_bounds.origin.x + child_bounds.size.width;
-
-                  if ((child_x2 <= compare_x1 || child_x1 >= compare_x2) /* No horizontal overlap */ ||
-                      (direction == GTK_DIR_DOWN && child_bounds.origin.y + child_bounds.size.height < compare_y) || /* Not below */
-                      (direction == GTK_DIR_UP && child_bounds.origin.y > compare_y)) /* Not above */
-                    {
-                      g_ptr_array_remove_index (focus_order, i);
-                      i --;
-                    }
-                }
-              else
-                {
-                  g_ptr_array_remove_index (focus_order, i);
-                  i --;
-                }
+              float child_x1, child_x2;
+
+              if (!entry->has_bounds)
+                continue;
+
+              child_x1 = entry->bounds.origin.x;
+              child_x2 = entry->bounds.origin.x + entry->bounds.size.width;
+
+              if ((child_x2 <= compare_x1 || child_x1 >= compare_x2) /* No horizontal overlap */ ||
+                  (direction == GTK_DIR_DOWN && entry->bounds.origin.y + entry->bounds.size.height < compare_y) || /* Not below */
+                  (direction == GTK_DIR_UP && entry->bounds.origin.y > compare_y)) /* Not above */
+                continue;
             }
+
+          entries[j++] = *entry;
         }
+      n_entries = j;
 
       compare_info.x = (compare_x1 + compare_x2) / 2;
       compare_info.y = old_bounds.origin.y + (old_bounds.size.height / 2.0f);
@@ -401,7 +457,9 @@ focus_sort_up_down (GtkWidget        *widget,
     }
 
   compare_info.axis = VERTICAL;
-  g_ptr_array_sort_with_data (focus_order, axis_compare, &compare_info);
+  g_qsort_with_data (entries, n_entries, sizeof (FocusSortEntry),
+                     axis_compare, &compare_info);
+  focus_sort_entries_apply (entries, n_entries, focus_order);
 
   if (compare_info.reverse)
     reverse_ptr_array (focus_order);
@@ -58,6 +58,8 @@ typedef struct _GtkWidgetSurfaceTransformData
   GList *callbacks;
 } GtkWidgetSurfaceTransformData;
 
+typedef struct _GtkWidgetPickIndex GtkWidgetPickIndex;
+
 struct _GtkWidgetPrivate
 {
   /* The state of the widget. Needs to be able to hold all GtkStateFlags bits
@@ -86,6 +88,7 @@ struct _GtkWidgetPrivate
   guint resize_needed         : 1; /* queue_resize() has been called but no get_preferred_size() yet */
   guint alloc_needed          : 1; /* this widget needs a size_allocate() call */
   guint alloc_needed_on_child : 1; /* 0 or more children - or this widget - need a size_allocate() call */
+  guint resize_boundary       : 1; /* the parent's size doesn't depend on ours, queue_resize() stops here */
 
   /* Queue-draw related flags */
   guint draw_needed           : 1;
@@ -99,6 +102,10 @@ struct _GtkWidgetPrivate
   guint vexpand_set           : 1; /* instead of computing from children */
   guint has_tooltip           : 1;
 
+  /* Picking */
+  guint pick_bounds_valid     : 1;
+  guint pick_bounds_unbounded : 1;
+
   /* SizeGroup related flags */
   guint have_size_groups      : 1;
 
@@ -162,6 +169,11 @@ struct _GtkWidgetPrivate
   int baseline;
   GskTransform *transform;
 
+  /* What can be picked in the widget and its children, in widget
+   * coordinates. Only meaningful if pick_bounds_valid is set. */
+  graphene_rect_t pick_bounds;
+  GtkWidgetPickIndex *pick_index;
+
   /* The widget's requested sizes */
   SizeRequestCache requests;
 
@@ -205,6 +217,7 @@ typedef struct
   GBytes *data;
   GSList *children;
   GtkBuilderScope *scope;
+  struct _GtkBuilderParseCache *cache;
 } GtkWidgetTemplate;
 
 struct _GtkWidgetClassPrivate
@@ -226,6 +239,8 @@ void         _gtk_widget_set_visible_flag   (GtkWidget *widget,
 gboolean     _gtk_widget_get_alloc_needed   (GtkWidget *widget);
 gboolean     gtk_widget_needs_allocate      (GtkWidget *widget);
 void         gtk_widget_ensure_resize       (GtkWidget *widget);
+void         gtk_widget_set_resize_boundary (GtkWidget *widget,
+                                             gboolean   resize_boundary);
 void         gtk_widget_ensure_allocate     (GtkWidget *widget);
 void          _gtk_widget_scale_changed     (GtkWidget *widget);
 
@@ -307,6 +322,7 @@ void              gtk_widget_adjust_size_request           (GtkWidget      *widg
 void              gtk_widget_adjust_baseline_request       (GtkWidget *widget,
                                                             int       *minimum_baseline,
                                                             int       *natural_baseline);
+void              gtk_widget_report_measure_counters       (void);
 
 typedef void    (*GtkCallback)     (GtkWidget        *widget,
                                     gpointer          data);
@@ -373,6 +389,52 @@ gboolean gtk_widget_focus_self       (GtkWidget        *widget,
 void    gtk_widget_update_orientation   (GtkWidget      *widget,
                                          GtkOrientation  orientation);
 
+/* Per-type cost accounting, used by the inspector */
+typedef enum {
+  GTK_WIDGET_COST_MEASURE,
+  GTK_WIDGET_COST_ALLOCATE,
+  GTK_WIDGET_COST_SNAPSHOT,
+  GTK_WIDGET_COST_CSS,
+  GTK_WIDGET_N_COSTS
+} GtkWidgetCost;
+
+typedef struct {
+  gint64 time[GTK_WIDGET_N_COSTS]; /* in µs, excluding nested widgets */
+  guint calls[GTK_WIDGET_N_COSTS];
+} GtkWidgetCosts;
+
+typedef struct _GtkWidgetCostFrame GtkWidgetCostFrame;
+struct _GtkWidgetCostFrame
+{
+  GtkWidgetCostFrame *parent;
+  gint64 start;
+  gint64 children;
+};
+
+void              gtk_widget_set_track_costs               (gboolean             track_costs);
+GHashTable *      gtk_widget_get_costs                     (void);
+void              gtk_widget_cost_begin                    (GtkWidgetCostFrame  *frame);
+void              gtk_widget_cost_end                      (GtkWidgetCostFrame  *frame,
+                                                            GtkWidget           *widget,
+                                                            GtkWidgetCost        cost);
+
+/* Allocations done while producing the last frame */
+typedef struct {
+  guint render_nodes;
+  guint css_values;
+  guint css_styles;
+  guint snapshot_states;
+  guint pango_layouts;
+} GtkAllocationCounts;
+
+void              gtk_widget_get_frame_allocations         (GtkAllocationCounts *counts);
+
+static inline gboolean
+gtk_widget_cost_frame_is_active (GtkWidgetCostFrame *frame)
+{
+  return frame->start != 0;
+}
+
 /* inline getters */
 
 static inline GtkWidget *
@@ -4025,6 +4025,9 @@ gtk_window_compute_default_size (GtkWindow *window,
                                  int       *nat_height)
 {
   GtkWidget *widget = GTK_WIDGET (window);
+  gint64 before G_GNUC_UNUSED;
+
+  before = GDK_PROFILER_CURRENT_TIME;
 
   if (gtk_widget_get_request_mode (widget) == GTK_SIZE_REQUEST_WIDTH_FOR_HEIGHT)
     {
@@ -4060,6 +4063,9 @@ gtk_window_compute_default_size (GtkWindow *window,
       *min_height = minimum;
       *nat_height = MAX (minimum, MIN (max_height, natural));
     }
+
+  gdk_profiler_end_markf (before, "window measure", "%s %p",
+                          G_OBJECT_TYPE_NAME (window), window);
 }
 
 static gboolean
@@ -4542,8 +4548,16 @@ surface_render (GdkSurface     *surface,
                 cairo_region_t *region,
                 GtkWidget      *widget)
 {
+  static gboolean first_frame = TRUE;
+
   gtk_widget_render (widget, surface, region);
 
+  if (G_UNLIKELY (first_frame))
+    {
+      first_frame = FALSE;
+      gdk_profiler_end_mark (gtk_get_init_time (), "first frame", G_OBJECT_TYPE_NAME (widget));
+    }
+
   return TRUE;
 }
 
@@ -52,6 +52,8 @@ enum {
   COLUMN_NODE_CLASSES,
   COLUMN_NODE_ID,
   COLUMN_NODE_STATE,
+  COLUMN_NODE_RESTYLES,
+  COLUMN_NODE_RESTYLE_REASONS,
   /* add more */
   N_NODE_COLUMNS
 };
@@ -309,6 +311,7 @@ gtk_inspector_css_node_tree_get_node_value (GtkTreeModelCssNode *model,
                                             int                  column,
                                             GValue              *value)
 {
+  const GtkCssNodeStats *stats;
   char **strv;
   char *s;
 
@@ -338,6 +341,24 @@ gtk_inspector_css_node_tree_get_node_value (GtkTreeModelCssNode *model,
       g_value_take_string (value, format_state_flags (gtk_css_node_get_state (node)));
       break;
 
+    case COLUMN_NODE_RESTYLES:
+      stats = gtk_css_node_get_stats (node);
+      if (stats)
+        g_value_take_string (value, g_strdup_printf ("%u (%.2f ms)",
+                                                     stats->n_restyles,
+                                                     stats->restyle_time / 1000.0));
+      else
+        g_value_set_string (value, "");
+      break;
+
+    case COLUMN_NODE_RESTYLE_REASONS:
+      stats = gtk_css_node_get_stats (node);
+      if (stats)
+        g_value_take_string (value, gtk_css_change_to_string (stats->changes));
+      else
+        g_value_set_string (value, "");
+      break;
+
     default:
       g_assert_not_reached ();
       break;
@@ -354,12 +375,17 @@ gtk_inspector_css_node_tree_init (GtkInspectorCssNodeTree *cnt)
   gtk_widget_init_template (GTK_WIDGET (cnt));
   priv = cnt->priv;
 
+  /* Nodes restyled from now on show up in the restyle columns */
+  gtk_css_node_set_collect_stats (TRUE);
+
   priv->node_model = gtk_tree_model_css_node_new (gtk_inspector_css_node_tree_get_node_value,
                                                   N_NODE_COLUMNS,
                                                   G_TYPE_STRING,
                                                   G_TYPE_BOOLEAN,
                                                   G_TYPE_STRING,
                                                   G_TYPE_STRING,
+                                                  G_TYPE_STRING,
+                                                  G_TYPE_STRING,
                                                   G_TYPE_STRING);
   gtk_tree_view_set_model (GTK_TREE_VIEW (priv->node_tree), priv->node_model);
   g_object_unref (priv->node_model);
@@ -25,15 +25,26 @@
 #include "gtkwidget.h"
 #include "gtkwindow.h"
 #include "gtknative.h"
+#include "gtkwidgetprivate.h"
+#include "gdk/gdk-private.h"
+
+#include <string.h>
 
 /* duration before we start fading in us */
 #define GDK_FPS_OVERLAY_LINGER_DURATION (1000 * 1000)
 /* duration when fade is finished in us */
 #define GDK_FPS_OVERLAY_FADE_DURATION (500 * 1000)
+/* number of frames with input that latencies are computed over */
+#define GDK_FPS_OVERLAY_LATENCY_HISTORY 120
 
 typedef struct _GtkFpsInfo {
   gint64 last_frame;
   GskRenderNode *last_node;
+
+  gint64 last_latency_frame;
+  gint64 latencies[GDK_FPS_OVERLAY_LATENCY_HISTORY];
+  guint n_latencies;
+  guint next_latency;
 } GtkFpsInfo;
 
 struct _GtkFpsOverlay
@@ -72,6 +83,72 @@ gtk_fps_overlay_get_fps (GtkWidget *widget)
   return gdk_frame_clock_get_fps (frame_clock);
 }
 
+/* Collects the input-to-presentation latency of all frames that
+ * completed since we last looked
+ */
+static void
+gtk_fps_overlay_collect_latencies (GtkFpsInfo *info,
+                                   GtkWidget  *widget)
+{
+  GdkFrameClock *frame_clock;
+  gint64 frame;
+
+  frame_clock = gtk_widget_get_frame_clock (widget);
+  if (frame_clock == NULL)
+    return;
+
+  frame = MAX (info->last_latency_frame + 1, gdk_frame_clock_get_history_start (frame_clock));
+  for (; frame <= gdk_frame_clock_get_frame_counter (frame_clock); frame++)
+    {
+      GdkFrameTimings *timings;
+      gint64 input_time, presentation_time;
+
+      timings = gdk_frame_clock_get_timings (frame_clock, frame);
+      if (timings == NULL || !gdk_frame_timings_get_complete (timings))
+        break;
+
+      info->last_latency_frame = frame;
+
+      input_time = gdk_frame_timings_get_input_time (timings);
+      presentation_time = gdk_frame_timings_get_presentation_time (timings);
+      if (input_time == 0 || presentation_time == 0)
+        continue;
+
+      info->latencies[info->next_latency] = presentation_time - input_time;
+      info->next_latency = (info->next_latency + 1) % GDK_FPS_OVERLAY_LATENCY_HISTORY;
+      info->n_latencies = MIN (info->n_latencies + 1, GDK_FPS_OVERLAY_LATENCY_HISTORY);
+    }
+}
+
+static int
+compare_latencies (gconstpointer a,
+                   gconstpointer b,
+                   gpointer      unused)
+{
+  gint64 la = *(const gint64 *) a;
+  gint64 lb = *(const gint64 *) b;
+
+  return la < lb ? -1 : (la > lb ? 1 : 0);
+}
+
+static char *
+gtk_fps_overlay_format_latency (GtkFpsInfo *info)
+{
+  gint64 sorted[GDK_FPS_OVERLAY_LATENCY_HISTORY];
+  guint n = info->n_latencies;
+
+  if (n == 0)
+    return g_strdup ("--- latency");
+
+  memcpy (sorted, info->latencies, sizeof (gint64) * n);
+  g_qsort_with_data (sorted, n, sizeof (gint64), compare_latencies, NULL);
+
+  return g_strdup_printf ("latency p50 %.1f p95 %.1f p99 %.1f ms",
+                          sorted[(n - 1) * 50 / 100] / 1000.0,
+                          sorted[(n - 1) * 95 / 100] / 1000.0,
+                          sorted[(n - 1) * 99 / 100] / 1000.0);
+}
+
 static gboolean
 gtk_fps_overlay_force_redraw (GtkWidget     *widget,
                               GdkFrameClock *clock,
@@ -94,7 +171,8 @@ gtk_fps_overlay_snapshot (GtkInspectorOverlay *overlay,
   PangoAttrList *attrs;
   gint64 now;
   double fps;
-  char *fps_string;
+  char *fps_string, *latency_string, *stats_string;
+  GtkAllocationCounts allocations;
   graphene_rect_t bounds;
   gboolean has_bounds;
   int width, height;
@@ -138,6 +216,26 @@ gtk_fps_overlay_snapshot (GtkInspectorOverlay *overlay,
   else
     fps_string = g_strdup_printf ("%.2f fps", fps);
 
+  gtk_fps_overlay_collect_latencies (info, widget);
+  latency_string = gtk_fps_overlay_format_latency (info);
+
+  /* Allocations of the previous frame, to spot churn */
+  gtk_widget_get_frame_allocations (&allocations);
+  stats_string = g_strdup_printf ("%s\n"
+                                  "%s\n"
+                                  "%u nodes\n"
+                                  "%u css values\n"
+                                  "%u css styles\n"
+                                  "%u snapshot states\n"
+                                  "%u layouts",
+                                  fps_string,
+                                  latency_string,
+                                  allocations.render_nodes,
+                                  allocations.css_values,
+                                  allocations.css_styles,
+                                  allocations.snapshot_states,
+                                  allocations.pango_layouts);
+
   if (GTK_IS_WINDOW (widget))
     {
       GtkWidget *child = gtk_window_get_child (GTK_WINDOW (widget));
@@ -152,7 +250,9 @@ gtk_fps_overlay_snapshot (GtkInspectorOverlay *overlay,
       has_bounds = gtk_widget_compute_bounds (widget, widget, &bounds);
     }
 
-  layout = gtk_widget_create_pango_layout (widget, fps_string);
+  /* Don't use gtk_widget_create_pango_layout(), it would show up in the count */
+  layout = pango_layout_new (gtk_widget_get_pango_context (widget));
+  pango_layout_set_text (layout, stats_string, -1);
   attrs = pango_attr_list_new ();
   pango_attr_list_insert (attrs, pango_attr_font_features_new ("tnum=1"));
   pango_layout_set_attributes (layout, attrs);
@@ -174,6 +274,8 @@ gtk_fps_overlay_snapshot (GtkInspectorOverlay *overlay,
     gtk_snapshot_pop (snapshot);
   gtk_snapshot_restore (snapshot);
   g_free (fps_string);
+  g_free (latency_string);
+  g_free (stats_string);
 
   gtk_widget_add_tick_callback (widget, gtk_fps_overlay_force_redraw, NULL, NULL);
 }
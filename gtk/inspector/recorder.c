@@ -72,6 +72,8 @@ struct _GtkInspectorRecorder
   GtkInspectorRecording *recording; /* start recording if recording or NULL if not */
 
   gboolean debug_nodes;
+  gboolean ring_buffer;
+  guint n_frames;
 };
 
 typedef struct _GtkInspectorRecorderClass
@@ -85,11 +87,17 @@ enum
   PROP_0,
   PROP_RECORDING,
   PROP_DEBUG_NODES,
+  PROP_RING_BUFFER,
   LAST_PROP
 };
 
 static GParamSpec *props[LAST_PROP] = { NULL, };
 
+/* How many frames to keep in ring buffer mode. At 60Hz, this
+ * is the last 5 seconds of an animation.
+ */
+#define RING_BUFFER_FRAMES 300
+
 G_DEFINE_TYPE (GtkInspectorRecorder, gtk_inspector_recorder, GTK_TYPE_WIDGET)
 
 static GListModel *
@@ -233,6 +241,7 @@ recordings_clear_all (GtkButton            *button,
                       GtkInspectorRecorder *recorder)
 {
   g_list_store_remove_all (G_LIST_STORE (recorder->recordings));
+  recorder->n_frames = 0;
 }
 
 static const char *
@@ -1272,6 +1281,66 @@ toggle_dark_mode (GtkToggleButton *button,
     }
 }
 
+static guint
+count_render_nodes (GskRenderNode *node)
+{
+  GListModel *children;
+  guint i, n_children, n_nodes;
+
+  n_nodes = 1;
+
+  children = create_list_model_for_render_node (node);
+  n_children = g_list_model_get_n_items (children);
+  for (i = 0; i < n_children; i++)
+    {
+      GdkPaintable *paintable = g_list_model_get_item (children, i);
+
+      n_nodes += count_render_nodes (gtk_render_node_paintable_get_render_node (GTK_RENDER_NODE_PAINTABLE (paintable)));
+      g_object_unref (paintable);
+    }
+  g_object_unref (children);
+
+  return n_nodes;
+}
+
+/* A one-line summary of the frame, so that slow or
+ * complex frames stand out when scrolling through the
+ * recordings
+ */
+static GtkWidget *
+create_frame_summary (GtkInspectorRenderRecording *recording)
+{
+  GtkWidget *label;
+  GString *string;
+  gint64 interval;
+  guint dropped;
+
+  string = g_string_new (NULL);
+  g_string_append_printf (string, "#%" G_GINT64_FORMAT,
+                          gtk_inspector_render_recording_get_frame_counter (recording));
+
+  interval = gtk_inspector_render_recording_get_frame_interval (recording);
+  if (interval > 0)
+    g_string_append_printf (string, ", +%.1f ms", interval / 1000.0);
+
+  g_string_append_printf (string, ", %u nodes",
+                          count_render_nodes (gtk_inspector_render_recording_get_node (recording)));
+
+  dropped = gtk_inspector_render_recording_get_dropped_frames (recording);
+  if (dropped > 0)
+    g_string_append_printf (string, ", %u dropped", dropped);
+
+  label = gtk_label_new (string->str);
+  gtk_label_set_xalign (GTK_LABEL (label), 0.0f);
+  gtk_widget_add_css_class (label, "dim-label");
+  if (dropped > 0)
+    gtk_widget_add_css_class (label, "error");
+
+  g_string_free (string, TRUE);
+
+  return label;
+}
+
 static GtkWidget *
 gtk_inspector_recorder_recordings_list_create_widget (gpointer item,
                                                       gpointer user_data)
@@ -1301,6 +1370,8 @@ gtk_inspector_recorder_recordings_list_create_widget (gpointer item,
       gtk_label_set_use_markup (GTK_LABEL (label), TRUE);
       gtk_box_append (GTK_BOX (hbox), label);
 
+      gtk_box_append (GTK_BOX (widget), create_frame_summary (GTK_INSPECTOR_RENDER_RECORDING (recording)));
+
       button = gtk_toggle_button_new ();
       gtk_button_set_has_frame (GTK_BUTTON (button), FALSE);
       gtk_button_set_icon_name (GTK_BUTTON (button), "view-more-symbolic");
@@ -1385,6 +1456,10 @@ gtk_inspector_recorder_get_property (GObject    *object,
       g_value_set_boolean (value, recorder->debug_nodes);
       break;
 
+    case PROP_RING_BUFFER:
+      g_value_set_boolean (value, recorder->ring_buffer);
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, param_id, pspec);
       break;
@@ -1409,6 +1484,10 @@ gtk_inspector_recorder_set_property (GObject      *object,
       gtk_inspector_recorder_set_debug_nodes (recorder, g_value_get_boolean (value));
       break;
 
+    case PROP_RING_BUFFER:
+      gtk_inspector_recorder_set_ring_buffer (recorder, g_value_get_boolean (value));
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, param_id, pspec);
       break;
@@ -1450,6 +1529,12 @@ gtk_inspector_recorder_class_init (GtkInspectorRecorderClass *klass)
                           "Whether to insert extra debug nodes in the tree",
                           FALSE,
                           G_PARAM_READWRITE);
+  props[PROP_RING_BUFFER] =
+    g_param_spec_boolean ("ring-buffer",
+                          "Ring buffer",
+                          "Whether to only keep the most recent frames",
+                          FALSE,
+                          G_PARAM_READWRITE);
 
   g_object_class_install_properties (object_class, LAST_PROP, props);
 
@@ -1508,10 +1593,46 @@ gtk_inspector_recorder_init (GtkInspectorRecorder *recorder)
   g_object_unref (recorder->render_node_properties);
 }
 
+/* Drops the oldest frames until at most @max_frames are left.
+ * Start markers are kept, so it stays visible where recording
+ * was resumed.
+ */
+static void
+gtk_inspector_recorder_trim_frames (GtkInspectorRecorder *recorder,
+                                    guint                 max_frames)
+{
+  guint i;
+
+  i = 0;
+  while (recorder->n_frames > max_frames)
+    {
+      GtkInspectorRecording *recording = g_list_model_get_item (recorder->recordings, i);
+
+      if (GTK_INSPECTOR_IS_RENDER_RECORDING (recording))
+        {
+          g_list_store_remove (G_LIST_STORE (recorder->recordings), i);
+          recorder->n_frames--;
+        }
+      else
+        {
+          i++;
+        }
+
+      g_object_unref (recording);
+    }
+}
+
 static void
 gtk_inspector_recorder_add_recording (GtkInspectorRecorder  *recorder,
                                       GtkInspectorRecording *recording)
 {
+  if (GTK_INSPECTOR_IS_RENDER_RECORDING (recording))
+    {
+      if (recorder->ring_buffer)
+        gtk_inspector_recorder_trim_frames (recorder, RING_BUFFER_FRAMES - 1);
+      recorder->n_frames++;
+    }
+
   g_list_store_append (G_LIST_STORE (recorder->recordings), recording);
 }
 
@@ -1551,13 +1672,32 @@ gtk_inspector_recorder_record_render (GtkInspectorRecorder *recorder,
 {
   GtkInspectorRecording *recording;
   GdkFrameClock *frame_clock;
+  gint64 frame_time, frame_interval, refresh_interval;
+  guint n_recordings;
 
   if (!gtk_inspector_recorder_is_recording (recorder))
     return;
 
   frame_clock = gtk_widget_get_frame_clock (widget);
+  frame_time = gdk_frame_clock_get_frame_time (frame_clock);
+  gdk_frame_clock_get_refresh_info (frame_clock, frame_time, &refresh_interval, NULL);
+
+  frame_interval = 0;
+  n_recordings = g_list_model_get_n_items (recorder->recordings);
+  if (n_recordings > 0)
+    {
+      GtkInspectorRecording *previous = g_list_model_get_item (recorder->recordings, n_recordings - 1);
 
-  recording = gtk_inspector_render_recording_new (gdk_frame_clock_get_frame_time (frame_clock),
+      if (GTK_INSPECTOR_IS_RENDER_RECORDING (previous))
+        frame_interval = frame_time - gtk_inspector_recording_get_timestamp (previous);
+
+      g_object_unref (previous);
+    }
+
+  recording = gtk_inspector_render_recording_new (frame_time,
+                                                  gdk_frame_clock_get_frame_counter (frame_clock),
+                                                  frame_interval,
+                                                  refresh_interval,
                                                   gsk_renderer_get_profiler (renderer),
                                                   &(GdkRectangle) { 0, 0,
                                                     gdk_surface_get_width (surface),
@@ -1591,4 +1731,19 @@ gtk_inspector_recorder_set_debug_nodes (GtkInspectorRecorder *recorder,
   g_object_notify_by_pspec (G_OBJECT (recorder), props[PROP_DEBUG_NODES]);
 }
 
+void
+gtk_inspector_recorder_set_ring_buffer (GtkInspectorRecorder *recorder,
+                                        gboolean              ring_buffer)
+{
+  if (recorder->ring_buffer == ring_buffer)
+    return;
+
+  recorder->ring_buffer = ring_buffer;
+
+  if (ring_buffer)
+    gtk_inspector_recorder_trim_frames (recorder, RING_BUFFER_FRAMES);
+
+  g_object_notify_by_pspec (G_OBJECT (recorder), props[PROP_RING_BUFFER]);
+}
+
 // vim: set et sw=2 ts=2:
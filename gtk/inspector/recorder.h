@@ -37,6 +37,9 @@ gboolean        gtk_inspector_recorder_is_recording             (GtkInspectorRec
 void            gtk_inspector_recorder_set_debug_nodes          (GtkInspectorRecorder   *recorder,
                                                                  gboolean                debug_nodes);
 
+void            gtk_inspector_recorder_set_ring_buffer          (GtkInspectorRecorder   *recorder,
+                                                                 gboolean                ring_buffer);
+
 void            gtk_inspector_recorder_record_render            (GtkInspectorRecorder   *recorder,
                                                                  GtkWidget              *widget,
                                                                  GskRenderer            *renderer,
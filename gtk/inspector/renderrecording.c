@@ -61,6 +61,9 @@ collect_profiler_info (GtkInspectorRenderRecording *recording,
 
 GtkInspectorRecording *
 gtk_inspector_render_recording_new (gint64                timestamp,
+                                    gint64                frame_counter,
+                                    gint64                frame_interval,
+                                    gint64                refresh_interval,
                                     GskProfiler          *profiler,
                                     const GdkRectangle   *area,
                                     const cairo_region_t *clip_region,
@@ -73,6 +76,9 @@ gtk_inspector_render_recording_new (gint64                timestamp,
                             NULL);
 
   collect_profiler_info (recording, profiler);
+  recording->frame_counter = frame_counter;
+  recording->frame_interval = frame_interval;
+  recording->refresh_interval = refresh_interval;
   recording->area = *area;
   recording->clip_region = cairo_region_copy (clip_region);
   recording->node = gsk_render_node_ref (node);
@@ -104,4 +110,37 @@ gtk_inspector_render_recording_get_profiler_info (GtkInspectorRenderRecording *r
   return recording->profiler_info;
 }
 
+gint64
+gtk_inspector_render_recording_get_frame_counter (GtkInspectorRenderRecording *recording)
+{
+  return recording->frame_counter;
+}
+
+/* The time since the previous frame that was recorded, or 0
+ * if this is the first frame of the recording
+ */
+gint64
+gtk_inspector_render_recording_get_frame_interval (GtkInspectorRenderRecording *recording)
+{
+  return recording->frame_interval;
+}
+
+/* How many refresh cycles passed between the previous recorded
+ * frame and this one without a frame being drawn. This is only
+ * meaningful while something is animating, as idle periods look
+ * like dropped frames, too.
+ */
+guint
+gtk_inspector_render_recording_get_dropped_frames (GtkInspectorRenderRecording *recording)
+{
+  gint64 n_frames;
+
+  if (recording->frame_interval == 0 || recording->refresh_interval == 0)
+    return 0;
+
+  n_frames = (recording->frame_interval + recording->refresh_interval / 2) / recording->refresh_interval;
+
+  return n_frames > 1 ? n_frames - 1 : 0;
+}
+
 // vim: set et sw=2 ts=2:
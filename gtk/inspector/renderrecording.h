@@ -44,6 +44,9 @@ typedef struct _GtkInspectorRenderRecording
   cairo_region_t *clip_region;
   GskRenderNode *node;
   char *profiler_info;
+  gint64 frame_counter;
+  gint64 frame_interval;
+  gint64 refresh_interval;
 } GtkInspectorRenderRecording;
 
 typedef struct _GtkInspectorRenderRecordingClass
@@ -55,6 +58,9 @@ GType           gtk_inspector_render_recording_get_type      (void);
 
 GtkInspectorRecording *
                 gtk_inspector_render_recording_new           (gint64                             timestamp,
+                                                              gint64                             frame_counter,
+                                                              gint64                             frame_interval,
+                                                              gint64                             refresh_interval,
                                                               GskProfiler                       *profiler,
                                                               const GdkRectangle                *area,
                                                               const cairo_region_t              *clip_region,
@@ -67,6 +73,9 @@ const cairo_rectangle_int_t *
                 gtk_inspector_render_recording_get_area      (GtkInspectorRenderRecording       *recording);
 const char *    gtk_inspector_render_recording_get_profiler_info
                                                              (GtkInspectorRenderRecording       *recording);
+gint64          gtk_inspector_render_recording_get_frame_counter (GtkInspectorRenderRecording   *recording);
+gint64          gtk_inspector_render_recording_get_frame_interval (GtkInspectorRenderRecording  *recording);
+guint           gtk_inspector_render_recording_get_dropped_frames (GtkInspectorRenderRecording  *recording);
 
 
 G_END_DECLS
@@ -32,6 +32,7 @@
 #include "gtkeventcontrollerkey.h"
 #include "gtkmain.h"
 #include "gtkliststore.h"
+#include "gtkwidgetprivate.h"
 
 #include <glib/gi18n-lib.h>
 
@@ -61,6 +62,9 @@ struct _GtkInspectorStatisticsPrivate
   guint update_source_id;
   GtkWidget *search_entry;
   GtkWidget *search_bar;
+  GtkTreeModel *costs_model;
+  GtkTreeView *costs_view;
+  GHashTable *cost_rows;
 };
 
 typedef struct {
@@ -82,6 +86,18 @@ enum
   COLUMN_CUMULATIVE_DATA
 };
 
+enum
+{
+  COSTS_COLUMN_TYPE,
+  COSTS_COLUMN_TYPE_NAME,
+  COSTS_COLUMN_MEASURE,
+  COSTS_COLUMN_ALLOCATE,
+  COSTS_COLUMN_SNAPSHOT,
+  COSTS_COLUMN_CSS,
+  COSTS_COLUMN_TOTAL,
+  COSTS_COLUMN_SHARE
+};
+
 G_DEFINE_TYPE_WITH_PRIVATE (GtkInspectorStatistics, gtk_inspector_statistics, GTK_TYPE_BOX)
 
 static int
@@ -149,6 +165,83 @@ update_type_counts (gpointer data)
   return TRUE;
 }
 
+static void
+update_costs (GtkInspectorStatistics *sl)
+{
+  GHashTable *costs;
+  GHashTableIter iter;
+  gpointer type, value;
+  gint64 all_total;
+
+  costs = gtk_widget_get_costs ();
+  if (costs == NULL)
+    return;
+
+  all_total = 0;
+  g_hash_table_iter_init (&iter, costs);
+  while (g_hash_table_iter_next (&iter, NULL, &value))
+    {
+      GtkWidgetCosts *c = value;
+      int i;
+
+      for (i = 0; i < GTK_WIDGET_N_COSTS; i++)
+        all_total += c->time[i];
+    }
+
+  g_hash_table_iter_init (&iter, costs);
+  while (g_hash_table_iter_next (&iter, &type, &value))
+    {
+      GtkWidgetCosts *c = value;
+      GtkTreeIter *treeiter;
+      gint64 total;
+      int i;
+
+      treeiter = g_hash_table_lookup (sl->priv->cost_rows, type);
+      if (treeiter == NULL)
+        {
+          treeiter = g_new (GtkTreeIter, 1);
+          gtk_list_store_append (GTK_LIST_STORE (sl->priv->costs_model), treeiter);
+          gtk_list_store_set (GTK_LIST_STORE (sl->priv->costs_model), treeiter,
+                              COSTS_COLUMN_TYPE, GPOINTER_TO_SIZE (type),
+                              COSTS_COLUMN_TYPE_NAME, g_type_name (GPOINTER_TO_SIZE (type)),
+                              -1);
+          g_hash_table_insert (sl->priv->cost_rows, type, treeiter);
+        }
+
+      total = 0;
+      for (i = 0; i < GTK_WIDGET_N_COSTS; i++)
+        total += c->time[i];
+
+      gtk_list_store_set (GTK_LIST_STORE (sl->priv->costs_model), treeiter,
+                          COSTS_COLUMN_MEASURE, c->time[GTK_WIDGET_COST_MEASURE],
+                          COSTS_COLUMN_ALLOCATE, c->time[GTK_WIDGET_COST_ALLOCATE],
+                          COSTS_COLUMN_SNAPSHOT, c->time[GTK_WIDGET_COST_SNAPSHOT],
+                          COSTS_COLUMN_CSS, c->time[GTK_WIDGET_COST_CSS],
+                          COSTS_COLUMN_TOTAL, total,
+                          COSTS_COLUMN_SHARE, all_total > 0 ? 100.0 * total / all_total : 0.0,
+                          -1);
+    }
+}
+
+static gboolean
+has_instance_counts (void)
+{
+  return g_type_get_instance_count (GTK_TYPE_LABEL) > 0;
+}
+
+static gboolean
+update_statistics (gpointer data)
+{
+  GtkInspectorStatistics *sl = data;
+
+  if (has_instance_counts ())
+    update_type_counts (sl);
+
+  update_costs (sl);
+
+  return TRUE;
+}
+
 static void
 toggle_record (GtkToggleButton        *button,
                GtkInspectorStatistics *sl)
@@ -158,20 +251,22 @@ toggle_record (GtkToggleButton        *button,
 
   if (gtk_toggle_button_get_active (button))
     {
-      sl->priv->update_source_id = g_timeout_add_seconds (1, update_type_counts, sl);
-      update_type_counts (sl);
+      /* Each recording starts a new window for the costs */
+      g_hash_table_remove_all (sl->priv->cost_rows);
+      gtk_list_store_clear (GTK_LIST_STORE (sl->priv->costs_model));
+      gtk_widget_set_track_costs (TRUE);
+
+      sl->priv->update_source_id = g_timeout_add_seconds (1, update_statistics, sl);
+      update_statistics (sl);
     }
   else
     {
       g_source_remove (sl->priv->update_source_id);
       sl->priv->update_source_id = 0;
-    }
-}
 
-static gboolean
-has_instance_counts (void)
-{
-  return g_type_get_instance_count (GTK_TYPE_LABEL) > 0;
+      update_costs (sl);
+      gtk_widget_set_track_costs (FALSE);
+    }
 }
 
 static gboolean
@@ -241,6 +336,40 @@ cell_data_delta (GtkCellLayout   *layout,
   g_free (text);
 }
 
+static void
+cell_data_time (GtkTreeViewColumn *column,
+                GtkCellRenderer   *cell,
+                GtkTreeModel      *model,
+                GtkTreeIter       *iter,
+                gpointer           data)
+{
+  gint64 time;
+  char *text;
+
+  gtk_tree_model_get (model, iter, GPOINTER_TO_INT (data), &time, -1);
+
+  text = g_strdup_printf ("%.1f ms", time / 1000.0);
+  g_object_set (cell, "text", text, NULL);
+  g_free (text);
+}
+
+static void
+cell_data_share (GtkTreeViewColumn *column,
+                 GtkCellRenderer   *cell,
+                 GtkTreeModel      *model,
+                 GtkTreeIter       *iter,
+                 gpointer           data)
+{
+  double share;
+  char *text;
+
+  gtk_tree_model_get (model, iter, GPOINTER_TO_INT (data), &share, -1);
+
+  text = g_strdup_printf ("%.1f%%", share);
+  g_object_set (cell, "text", text, NULL);
+  g_free (text);
+}
+
 static void
 type_data_free (gpointer data)
 {
@@ -360,6 +489,8 @@ unroot (GtkWidget *widget)
 static void
 gtk_inspector_statistics_init (GtkInspectorStatistics *sl)
 {
+  int i;
+
   sl->priv = gtk_inspector_statistics_get_instance_private (sl);
   gtk_widget_init_template (GTK_WIDGET (sl));
   gtk_cell_layout_set_cell_data_func (GTK_CELL_LAYOUT (sl->priv->column_self1),
@@ -380,6 +511,21 @@ gtk_inspector_statistics_init (GtkInspectorStatistics *sl)
                                       GINT_TO_POINTER (COLUMN_CUMULATIVE2), NULL);
   sl->priv->counts = g_hash_table_new_full (NULL, NULL, NULL, type_data_free);
 
+  for (i = COSTS_COLUMN_MEASURE; i <= COSTS_COLUMN_SHARE; i++)
+    {
+      GtkTreeViewColumn *column;
+      GList *cells;
+
+      /* The type name is the first column in the view */
+      column = gtk_tree_view_get_column (sl->priv->costs_view, i - COSTS_COLUMN_TYPE_NAME);
+      cells = gtk_cell_layout_get_cells (GTK_CELL_LAYOUT (column));
+      gtk_tree_view_column_set_cell_data_func (column, cells->data,
+                                               i == COSTS_COLUMN_SHARE ? cell_data_share : cell_data_time,
+                                               GINT_TO_POINTER (i), NULL);
+      g_list_free (cells);
+    }
+  sl->priv->cost_rows = g_hash_table_new_full (NULL, NULL, NULL, g_free);
+
   gtk_tree_view_set_search_entry (sl->priv->view, GTK_EDITABLE (sl->priv->search_entry));
   gtk_tree_view_set_search_equal_func (sl->priv->view, match_row, sl, NULL);
 }
@@ -392,6 +538,7 @@ constructed (GObject *object)
   g_signal_connect (sl->priv->button, "toggled",
                     G_CALLBACK (toggle_record), sl);
 
+  /* Widget costs are recorded even without instance counts */
   if (has_instance_counts ())
     update_type_counts (sl);
   else
@@ -399,7 +546,6 @@ constructed (GObject *object)
       if (instance_counts_enabled ())
         gtk_label_set_text (GTK_LABEL (sl->priv->excuse), _("GLib must be configured with -Dbuildtype=debug"));
       gtk_stack_set_visible_child_name (GTK_STACK (sl->priv->stack), "excuse");
-      gtk_widget_set_sensitive (sl->priv->button, FALSE);
     }
 }
 
@@ -409,9 +555,13 @@ finalize (GObject *object)
   GtkInspectorStatistics *sl = GTK_INSPECTOR_STATISTICS (object);
 
   if (sl->priv->update_source_id)
-    g_source_remove (sl->priv->update_source_id);
+    {
+      g_source_remove (sl->priv->update_source_id);
+      gtk_widget_set_track_costs (FALSE);
+    }
 
   g_hash_table_unref (sl->priv->counts);
+  g_hash_table_unref (sl->priv->cost_rows);
 
   G_OBJECT_CLASS (gtk_inspector_statistics_parent_class)->finalize (object);
 }
@@ -489,6 +639,8 @@ gtk_inspector_statistics_class_init (GtkInspectorStatisticsClass *klass)
   gtk_widget_class_bind_template_child_private (widget_class, GtkInspectorStatistics, search_entry);
   gtk_widget_class_bind_template_child_private (widget_class, GtkInspectorStatistics, search_bar);
   gtk_widget_class_bind_template_child_private (widget_class, GtkInspectorStatistics, excuse);
+  gtk_widget_class_bind_template_child_private (widget_class, GtkInspectorStatistics, costs_model);
+  gtk_widget_class_bind_template_child_private (widget_class, GtkInspectorStatistics, costs_view);
 
 }
 
@@ -0,0 +1,284 @@
+/*  Copyright 2021 Red Hat, Inc.
+ *
+ * GTK+ is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * GLib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GTK+; see the file COPYING.  If not,
+ * see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include <glib/gi18n.h>
+#include <glib/gprintf.h>
+#include <glib/gstdio.h>
+#include <gtk/gtk.h>
+#include "gtkbuilderprivate.h"
+#include "gtk-builder-tool.h"
+
+typedef struct {
+  GType type;
+  guint count;
+} TypeCount;
+
+static int
+compare_type_count (gconstpointer a,
+                    gconstpointer b)
+{
+  const TypeCount *ca = a;
+  const TypeCount *cb = b;
+
+  if (ca->count != cb->count)
+    return cb->count - ca->count;
+
+  return strcmp (g_type_name (ca->type), g_type_name (cb->type));
+}
+
+static GtkBuilder *
+load (const char *buffer,
+      gsize       length)
+{
+  GtkBuilder *builder;
+  GError *error = NULL;
+
+  builder = gtk_builder_new ();
+  if (!gtk_builder_add_from_string (builder, buffer, length, &error))
+    {
+      g_printerr ("%s\n", error->message);
+      exit (1);
+    }
+
+  return builder;
+}
+
+static void
+destroy (GtkBuilder *builder)
+{
+  GSList *objects, *l;
+
+  objects = gtk_builder_get_objects (builder);
+  for (l = objects; l; l = l->next)
+    {
+      if (GTK_IS_WINDOW (l->data))
+        gtk_window_destroy (GTK_WINDOW (l->data));
+    }
+  g_slist_free (objects);
+
+  g_object_unref (builder);
+}
+
+/* Measures all widgets that are not inside another widget,
+ * which makes them compute their style and size requests
+ * for the first time.
+ */
+static void
+measure (GtkBuilder *builder)
+{
+  GSList *objects, *l;
+
+  objects = gtk_builder_get_objects (builder);
+  for (l = objects; l; l = l->next)
+    {
+      GtkWidget *widget = l->data;
+
+      if (!GTK_IS_WIDGET (widget) || gtk_widget_get_parent (widget) != NULL)
+        continue;
+
+      gtk_widget_measure (widget, GTK_ORIENTATION_HORIZONTAL, -1, NULL, NULL, NULL, NULL);
+      gtk_widget_measure (widget, GTK_ORIENTATION_VERTICAL, -1, NULL, NULL, NULL, NULL);
+    }
+  g_slist_free (objects);
+}
+
+static void
+print_time (const char *what,
+            gint64      total,
+            int         iterations)
+{
+  g_print ("%-24s %10.3f ms\n", what, total / (1000.0 * iterations));
+}
+
+static void
+profile_file (const char *filename,
+              int         iterations)
+{
+  char *contents;
+  gsize length;
+  GBytes *bytes;
+  GtkBuilder *builder;
+  GHashTable *counts;
+  GHashTableIter iter;
+  GArray *types;
+  GSList *objects, *l;
+  gpointer key, value;
+  GError *error = NULL;
+  gint64 start, precompile_time, xml_time, precompiled_time, measure_time;
+  guint n_objects, j;
+  int i;
+
+  if (!g_file_get_contents (filename, &contents, &length, &error))
+    {
+      g_printerr ("%s\n", error->message);
+      exit (1);
+    }
+
+  /* Load once before timing anything, so that type and class
+   * initialization does not end up in the numbers.
+   */
+  builder = load (contents, length);
+
+  counts = g_hash_table_new (NULL, NULL);
+  n_objects = 0;
+  objects = gtk_builder_get_objects (builder);
+  for (l = objects; l; l = l->next)
+    {
+      key = GSIZE_TO_POINTER (G_OBJECT_TYPE (l->data));
+      value = g_hash_table_lookup (counts, key);
+      g_hash_table_insert (counts, key, GUINT_TO_POINTER (GPOINTER_TO_UINT (value) + 1));
+      n_objects++;
+    }
+  g_slist_free (objects);
+  destroy (builder);
+
+  if (_gtk_buildable_parser_is_precompiled (contents, length))
+    {
+      bytes = g_bytes_new_take (contents, length);
+      contents = NULL;
+      precompile_time = 0;
+    }
+  else
+    {
+      start = g_get_monotonic_time ();
+      for (i = 0; i < iterations; i++)
+        {
+          bytes = _gtk_buildable_parser_precompile (contents, length, &error);
+          if (bytes == NULL)
+            {
+              g_printerr (_("Can’t parse “%s”: %s\n"), filename, error->message);
+              exit (1);
+            }
+          if (i + 1 < iterations)
+            g_bytes_unref (bytes);
+        }
+      precompile_time = g_get_monotonic_time () - start;
+    }
+
+  xml_time = 0;
+  if (contents)
+    {
+      for (i = 0; i < iterations; i++)
+        {
+          start = g_get_monotonic_time ();
+          builder = load (contents, length);
+          xml_time += g_get_monotonic_time () - start;
+          destroy (builder);
+        }
+    }
+
+  precompiled_time = 0;
+  measure_time = 0;
+  for (i = 0; i < iterations; i++)
+    {
+      start = g_get_monotonic_time ();
+      builder = load (g_bytes_get_data (bytes, NULL), g_bytes_get_size (bytes));
+      precompiled_time += g_get_monotonic_time () - start;
+
+      start = g_get_monotonic_time ();
+      measure (builder);
+      measure_time += g_get_monotonic_time () - start;
+
+      destroy (builder);
+    }
+
+  g_print ("%s: %u objects, %d iterations\n\n", filename, n_objects, iterations);
+
+  g_print ("Average times:\n");
+  if (contents)
+    {
+      print_time ("Parse XML", precompile_time, iterations);
+      print_time ("Load from XML", xml_time, iterations);
+    }
+  print_time ("Load precompiled", precompiled_time, iterations);
+  print_time ("First measure", measure_time, iterations);
+
+  types = g_array_new (FALSE, FALSE, sizeof (TypeCount));
+  g_hash_table_iter_init (&iter, counts);
+  while (g_hash_table_iter_next (&iter, &key, &value))
+    {
+      TypeCount tc = { GPOINTER_TO_SIZE (key), GPOINTER_TO_UINT (value) };
+      g_array_append_val (types, tc);
+    }
+  g_array_sort (types, compare_type_count);
+
+  g_print ("\nObjects per type:\n");
+  for (j = 0; j < types->len; j++)
+    {
+      TypeCount *tc = &g_array_index (types, TypeCount, j);
+      g_print ("%-32s %6u\n", g_type_name (tc->type), tc->count);
+    }
+
+  g_array_unref (types);
+  g_hash_table_unref (counts);
+  g_bytes_unref (bytes);
+  g_free (contents);
+}
+
+void
+do_profile (int          *argc,
+            const char ***argv)
+{
+  char **filenames = NULL;
+  int iterations = 100;
+  GOptionContext *ctx;
+  const GOptionEntry entries[] = {
+    { "iterations", 0, 0, G_OPTION_ARG_INT, &iterations, NULL, NULL },
+    { G_OPTION_REMAINING, 0, 0, G_OPTION_ARG_FILENAME_ARRAY, &filenames, NULL, NULL },
+    { NULL, }
+  };
+  GError *error = NULL;
+  int i;
+
+  ctx = g_option_context_new (NULL);
+  g_option_context_set_help_enabled (ctx, FALSE);
+  g_option_context_add_main_entries (ctx, entries, NULL);
+
+  if (!g_option_context_parse (ctx, argc, (char ***)argv, &error))
+    {
+      g_printerr ("%s\n", error->message);
+      g_error_free (error);
+      exit (1);
+    }
+
+  g_option_context_free (ctx);
+
+  if (filenames == NULL)
+    {
+      g_printerr (_("No .ui file specified\n"));
+      exit (1);
+    }
+
+  if (iterations < 1)
+    {
+      g_printerr (_("Iterations must be a positive number\n"));
+      exit (1);
+    }
+
+  for (i = 0; filenames[i]; i++)
+    {
+      if (i > 0)
+        g_print ("\n");
+      profile_file (filenames[i], iterations);
+    }
+
+  g_strfreev (filenames);
+}
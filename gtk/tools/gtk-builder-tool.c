@@ -39,6 +39,8 @@ usage (void)
              "  simplify     Simplify the file\n"
              "  enumerate    List all named objects\n"
              "  preview      Preview the file\n"
+             "  precompile   Precompile the file\n"
+             "  profile      Measure the cost of loading the file\n"
              "\n"
              "Simplify Options:\n"
              "  --replace    Replace the file\n"
@@ -48,6 +50,12 @@ usage (void)
              "  --id=ID      Preview only the named object\n"
              "  --css=FILE   Use style from CSS file\n"
              "\n"
+             "Precompile Options:\n"
+             "  --output=FILE  Write to FILE instead of stdout\n"
+             "\n"
+             "Profile Options:\n"
+             "  --iterations=N  Load the file N times\n"
+             "\n"
              "Perform various tasks on GtkBuilder .ui files.\n"));
   exit (1);
 }
@@ -134,6 +142,10 @@ main (int argc, const char *argv[])
     do_enumerate (&argc, &argv);
   else if (strcmp (argv[0], "preview") == 0)
     do_preview (&argc, &argv);
+  else if (strcmp (argv[0], "precompile") == 0)
+    do_precompile (&argc, &argv);
+  else if (strcmp (argv[0], "profile") == 0)
+    do_profile (&argc, &argv);
   else
     usage ();
 
@@ -6,5 +6,7 @@ void do_simplify  (int *argc, const char ***argv);
 void do_validate  (int *argc, const char ***argv);
 void do_enumerate (int *argc, const char ***argv);
 void do_preview   (int *argc, const char ***argv);
+void do_precompile (int *argc, const char ***argv);
+void do_profile   (int *argc, const char ***argv);
 
 #endif
@@ -31,6 +31,31 @@
 #include <libswscale/swscale.h>
 
 typedef struct _GtkVideoFrameFFMpeg GtkVideoFrameFFMpeg;
+typedef struct _GtkFfBufferPool GtkFfBufferPool;
+typedef struct _GtkFfBuffer GtkFfBuffer;
+
+/* Keeps the pixel memory of decoded frames around when their textures
+ * are released, so that playback doesn't allocate a new frame buffer
+ * for every frame. Textures can outlive the media file, so the pool is
+ * refcounted and every buffer holds a reference.
+ */
+struct _GtkFfBufferPool
+{
+  gsize size;
+  GSList *buffers;
+  guint n_buffers;
+};
+
+struct _GtkFfBuffer
+{
+  GtkFfBufferPool *pool;
+  guchar *data;
+  gsize size;
+};
+
+/* Enough for the current frame, the next frame and the textures the
+ * renderer still holds on to */
+#define MAX_POOLED_BUFFERS 4
 
 struct _GtkVideoFrameFFMpeg
 {
@@ -51,6 +76,7 @@ struct _GtkFfMediaFile
   struct SwsContext *sws_ctx;
   enum AVPixelFormat sws_pix_fmt;
   GdkMemoryFormat memory_format;
+  GtkFfBufferPool *pool;
 
   GtkVideoFrameFFMpeg current_frame;
   GtkVideoFrameFFMpeg next_frame;
@@ -64,6 +90,82 @@ struct _GtkFfMediaFileClass
   GtkMediaFileClass parent_class;
 };
 
+static void
+gtk_ff_buffer_pool_clear (gpointer data)
+{
+  GtkFfBufferPool *pool = data;
+
+  g_slist_free_full (pool->buffers, g_free);
+  pool->buffers = NULL;
+  pool->n_buffers = 0;
+}
+
+static GtkFfBufferPool *
+gtk_ff_buffer_pool_new (void)
+{
+  return g_rc_box_new0 (GtkFfBufferPool);
+}
+
+static void
+gtk_ff_buffer_pool_unref (GtkFfBufferPool *pool)
+{
+  g_rc_box_release_full (pool, gtk_ff_buffer_pool_clear);
+}
+
+static void
+gtk_ff_buffer_free (gpointer data)
+{
+  GtkFfBuffer *buffer = data;
+  GtkFfBufferPool *pool = buffer->pool;
+
+  if (buffer->size == pool->size && pool->n_buffers < MAX_POOLED_BUFFERS)
+    {
+      pool->buffers = g_slist_prepend (pool->buffers, buffer->data);
+      pool->n_buffers++;
+    }
+  else
+    g_free (buffer->data);
+
+  gtk_ff_buffer_pool_unref (pool);
+  g_slice_free (GtkFfBuffer, buffer);
+}
+
+/* Returns bytes of the given size whose memory goes back to the pool
+ * when they are freed. The contents are undefined. */
+static GBytes *
+gtk_ff_buffer_pool_get_bytes (GtkFfBufferPool *pool,
+                              gsize            size)
+{
+  GtkFfBuffer *buffer;
+  guchar *data;
+
+  if (size != pool->size)
+    {
+      gtk_ff_buffer_pool_clear (pool);
+      pool->size = size;
+    }
+
+  if (pool->buffers)
+    {
+      data = pool->buffers->data;
+      pool->buffers = g_slist_delete_link (pool->buffers, pool->buffers);
+      pool->n_buffers--;
+    }
+  else
+    {
+      data = g_try_malloc (size);
+      if (data == NULL)
+        return NULL;
+    }
+
+  buffer = g_slice_new (GtkFfBuffer);
+  buffer->pool = g_rc_box_acquire (pool);
+  buffer->data = data;
+  buffer->size = size;
+
+  return g_bytes_new_with_free_func (data, size, gtk_ff_buffer_free, buffer);
+}
+
 static void
 gtk_video_frame_ffmpeg_init (GtkVideoFrameFFMpeg *frame,
                              GdkTexture          *texture,
@@ -313,8 +415,9 @@ gtk_ff_media_file_decode_frame (GtkFfMediaFile      *video,
       return FALSE;
     }
 
-  data = g_try_malloc0 (video->codec_ctx->width * video->codec_ctx->height * 4);
-  if (data == NULL)
+  bytes = gtk_ff_buffer_pool_get_bytes (video->pool,
+                                        video->codec_ctx->width * video->codec_ctx->height * 4);
+  if (bytes == NULL)
     {
       gtk_media_stream_error (GTK_MEDIA_STREAM (video),
                               G_IO_ERROR,
@@ -324,6 +427,8 @@ gtk_ff_media_file_decode_frame (GtkFfMediaFile      *video,
       return FALSE;
     }
 
+  data = (guchar *) g_bytes_get_data (bytes, NULL);
+
   if (video->sws_ctx == NULL ||
       video->sws_pix_fmt != frame->format)
     {
@@ -358,7 +463,6 @@ gtk_ff_media_file_decode_frame (GtkFfMediaFile      *video,
             0, video->codec_ctx->height,
             (uint8_t *[1]) { data }, (int[1]) { video->codec_ctx->width * 4 });
 
-  bytes = g_bytes_new_take (data, video->codec_ctx->width * video->codec_ctx->height * 4);
   texture = gdk_memory_texture_new (video->codec_ctx->width,
                                     video->codec_ctx->height,
                                     video->memory_format,
@@ -748,6 +852,16 @@ gtk_ff_media_file_dispose (GObject *object)
   G_OBJECT_CLASS (gtk_ff_media_file_parent_class)->dispose (object);
 }
 
+static void
+gtk_ff_media_file_finalize (GObject *object)
+{
+  GtkFfMediaFile *video = GTK_FF_MEDIA_FILE (object);
+
+  gtk_ff_buffer_pool_unref (video->pool);
+
+  G_OBJECT_CLASS (gtk_ff_media_file_parent_class)->finalize (object);
+}
+
 static void
 gtk_ff_media_file_class_init (GtkFfMediaFileClass *klass)
 {
@@ -762,12 +876,14 @@ gtk_ff_media_file_class_init (GtkFfMediaFileClass *klass)
   stream_class->seek = gtk_ff_media_file_seek;
 
   gobject_class->dispose = gtk_ff_media_file_dispose;
+  gobject_class->finalize = gtk_ff_media_file_finalize;
 }
 
 static void
 gtk_ff_media_file_init (GtkFfMediaFile *video)
 {
   video->stream_id = -1;
+  video->pool = gtk_ff_buffer_pool_new ();
 }
 
 
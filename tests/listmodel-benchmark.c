@@ -0,0 +1,470 @@
+#include <gtk/gtk.h>
+
+/* Benchmarks the list models at sizes from 10^4 up to --max-size items
+ * and prints the timings as tab-separated values, one line per
+ * benchmark, model and size, so that runs can be compared by scripts.
+ *
+ * All random numbers come from a fixed seed, so every run performs
+ * the same operations.
+ */
+
+static int runs = 5;
+static int max_size = 1000000;
+
+static GOptionEntry options[] = {
+  { "runs", 'r', 0, G_OPTION_ARG_INT, &runs, "Run each benchmark N times", "N" },
+  { "max-size", 's', 0, G_OPTION_ARG_INT, &max_size, "Largest number of items, up to 10000000", "N" },
+  { NULL }
+};
+
+/* The number of changes in an items-changed storm */
+#define N_CHANGES 1000
+/* The most items that are looked up in the random access benchmarks */
+#define N_LOOKUPS 100000
+
+typedef struct
+{
+  GObject parent;
+
+  guint value;
+} BenchItem;
+
+typedef struct
+{
+  GObjectClass parent_class;
+} BenchItemClass;
+
+static GType bench_item_get_type (void);
+G_DEFINE_TYPE (BenchItem, bench_item, G_TYPE_OBJECT)
+
+static void
+bench_item_init (BenchItem *item)
+{
+}
+
+static void
+bench_item_class_init (BenchItemClass *klass)
+{
+}
+
+static BenchItem *
+bench_item_new (guint value)
+{
+  BenchItem *item = g_object_new (bench_item_get_type (), NULL);
+
+  item->value = value;
+
+  return item;
+}
+
+static int
+compare_times (gconstpointer a,
+               gconstpointer b,
+               gpointer      unused)
+{
+  gint64 ta = *(const gint64 *) a;
+  gint64 tb = *(const gint64 *) b;
+
+  return ta < tb ? -1 : (ta > tb ? 1 : 0);
+}
+
+static void
+report (const char *benchmark,
+        const char *model,
+        guint       size,
+        gint64     *times)
+{
+  g_qsort_with_data (times, runs, sizeof (gint64), compare_times, NULL);
+
+  g_print ("%s\t%s\t%u\t%d\t%" G_GINT64_FORMAT "\t%" G_GINT64_FORMAT "\t%" G_GINT64_FORMAT "\n",
+           benchmark,
+           model,
+           size,
+           runs,
+           times[0],
+           times[runs / 2],
+           times[runs - 1]);
+}
+
+static GListStore *
+create_store (guint size)
+{
+  GListStore *store;
+  gpointer *items;
+  guint i;
+
+  items = g_new (gpointer, size);
+  for (i = 0; i < size; i++)
+    items[i] = bench_item_new (i);
+
+  store = g_list_store_new (bench_item_get_type ());
+  g_list_store_splice (store, 0, 0, items, size);
+
+  for (i = 0; i < size; i++)
+    g_object_unref (items[i]);
+  g_free (items);
+
+  return store;
+}
+
+static gboolean
+filter_keep_all (gpointer item,
+                 gpointer unused)
+{
+  return TRUE;
+}
+
+static gboolean
+filter_not_multiple (gpointer item,
+                     gpointer data)
+{
+  return ((BenchItem *) item)->value % GPOINTER_TO_UINT (data) != 0;
+}
+
+static int
+sort_by_value (gconstpointer a,
+               gconstpointer b,
+               gpointer      data)
+{
+  guint va = ((const BenchItem *) a)->value;
+  guint vb = ((const BenchItem *) b)->value;
+  int result = va < vb ? -1 : (va > vb ? 1 : 0);
+
+  return GPOINTER_TO_INT (data) < 0 ? -result : result;
+}
+
+static gpointer
+map_identity (gpointer item,
+              gpointer unused)
+{
+  return item;
+}
+
+static const char *wrappers[] = { "store", "filter", "sort", "slice", "map", "flatten" };
+
+/* Returns a model of the given type that contains all items of @store */
+static GListModel *
+wrap_store (const char *wrapper,
+            GListStore *store)
+{
+  GListModel *model = g_object_ref (G_LIST_MODEL (store));
+
+  if (g_str_equal (wrapper, "store"))
+    return model;
+  else if (g_str_equal (wrapper, "filter"))
+    return G_LIST_MODEL (gtk_filter_list_model_new (model, GTK_FILTER (gtk_custom_filter_new (filter_keep_all, NULL, NULL))));
+  else if (g_str_equal (wrapper, "sort"))
+    return G_LIST_MODEL (gtk_sort_list_model_new (model, GTK_SORTER (gtk_custom_sorter_new (sort_by_value, NULL, NULL))));
+  else if (g_str_equal (wrapper, "slice"))
+    return G_LIST_MODEL (gtk_slice_list_model_new (model, 0, G_MAXUINT));
+  else if (g_str_equal (wrapper, "map"))
+    return G_LIST_MODEL (gtk_map_list_model_new (model, map_identity, NULL, NULL));
+  else if (g_str_equal (wrapper, "flatten"))
+    {
+      GListStore *models = g_list_store_new (G_TYPE_LIST_MODEL);
+
+      g_list_store_append (models, model);
+      g_object_unref (model);
+
+      return G_LIST_MODEL (gtk_flatten_list_model_new (G_LIST_MODEL (models)));
+    }
+
+  g_assert_not_reached ();
+}
+
+/* Many single item changes to the store, each of which the wrapping
+ * model has to handle and forward.
+ */
+static void
+bench_items_changed (guint size)
+{
+  gint64 *times = g_new (gint64, runs);
+  GRand *rand = g_rand_new_with_seed (42);
+  guint i;
+  int run;
+
+  for (i = 0; i < G_N_ELEMENTS (wrappers); i++)
+    {
+      GListStore *store = create_store (size);
+      GListModel *model = wrap_store (wrappers[i], store);
+
+      for (run = 0; run < runs; run++)
+        {
+          gint64 start = g_get_monotonic_time ();
+          guint j;
+
+          for (j = 0; j < N_CHANGES; j++)
+            {
+              guint position = g_rand_int_range (rand, 0, size);
+
+              if (j % 2 == 0)
+                g_list_store_remove (store, position);
+              else
+                {
+                  BenchItem *item = bench_item_new (position);
+                  g_list_store_insert (store, position, item);
+                  g_object_unref (item);
+                }
+            }
+
+          times[run] = g_get_monotonic_time () - start;
+        }
+
+      report ("items-changed", wrappers[i], size, times);
+
+      g_object_unref (model);
+      g_object_unref (store);
+    }
+
+  g_rand_free (rand);
+  g_free (times);
+}
+
+static void
+bench_filter (guint    size,
+              gboolean incremental)
+{
+  gint64 *times = g_new (gint64, runs);
+  GtkCustomFilter *filter;
+  GtkFilterListModel *model;
+  GListStore *store;
+  int run;
+
+  store = create_store (size);
+  filter = gtk_custom_filter_new (filter_not_multiple, GUINT_TO_POINTER (2), NULL);
+  model = gtk_filter_list_model_new (G_LIST_MODEL (store), g_object_ref (GTK_FILTER (filter)));
+  gtk_filter_list_model_set_incremental (model, incremental);
+
+  while (gtk_filter_list_model_get_pending (model) > 0)
+    g_main_context_iteration (NULL, TRUE);
+
+  for (run = 0; run < runs; run++)
+    {
+      gint64 start = g_get_monotonic_time ();
+
+      gtk_custom_filter_set_filter_func (filter,
+                                         filter_not_multiple,
+                                         GUINT_TO_POINTER (run % 2 == 0 ? 3 : 2),
+                                         NULL);
+
+      while (gtk_filter_list_model_get_pending (model) > 0)
+        g_main_context_iteration (NULL, TRUE);
+
+      times[run] = g_get_monotonic_time () - start;
+    }
+
+  report ("filter", incremental ? "incremental" : "full", size, times);
+
+  g_object_unref (model);
+  g_object_unref (filter);
+  g_free (times);
+}
+
+static void
+bench_sort (guint    size,
+            gboolean incremental)
+{
+  gint64 *times = g_new (gint64, runs);
+  GtkCustomSorter *sorter;
+  GtkSortListModel *model;
+  GListStore *store;
+  int run;
+
+  store = create_store (size);
+  sorter = gtk_custom_sorter_new (sort_by_value, GINT_TO_POINTER (1), NULL);
+  model = gtk_sort_list_model_new (G_LIST_MODEL (store), g_object_ref (GTK_SORTER (sorter)));
+  gtk_sort_list_model_set_incremental (model, incremental);
+
+  while (gtk_sort_list_model_get_pending (model) > 0)
+    g_main_context_iteration (NULL, TRUE);
+
+  for (run = 0; run < runs; run++)
+    {
+      gint64 start = g_get_monotonic_time ();
+
+      gtk_custom_sorter_set_sort_func (sorter,
+                                       sort_by_value,
+                                       GINT_TO_POINTER (run % 2 == 0 ? -1 : 1),
+                                       NULL);
+
+      while (gtk_sort_list_model_get_pending (model) > 0)
+        g_main_context_iteration (NULL, TRUE);
+
+      times[run] = g_get_monotonic_time () - start;
+    }
+
+  report ("sort", incremental ? "incremental" : "full", size, times);
+
+  g_object_unref (model);
+  g_object_unref (sorter);
+  g_free (times);
+}
+
+static void
+bench_get_item (guint    size,
+                gboolean random)
+{
+  gint64 *times = g_new (gint64, runs);
+  GRand *rand = g_rand_new_with_seed (42);
+  guint n_lookups = MIN (size, N_LOOKUPS);
+  guint *positions;
+  guint i, j;
+  int run;
+
+  positions = g_new (guint, n_lookups);
+  for (j = 0; j < n_lookups; j++)
+    positions[j] = random ? g_rand_int_range (rand, 0, size) : j;
+
+  for (i = 0; i < G_N_ELEMENTS (wrappers); i++)
+    {
+      GListStore *store = create_store (size);
+      GListModel *model = wrap_store (wrappers[i], store);
+
+      for (run = 0; run < runs; run++)
+        {
+          gint64 start = g_get_monotonic_time ();
+
+          for (j = 0; j < n_lookups; j++)
+            g_object_unref (g_list_model_get_item (model, positions[j]));
+
+          times[run] = g_get_monotonic_time () - start;
+        }
+
+      report (random ? "get-item-random" : "get-item-sequential", wrappers[i], size, times);
+
+      g_object_unref (model);
+      g_object_unref (store);
+    }
+
+  g_free (positions);
+  g_rand_free (rand);
+  g_free (times);
+}
+
+static const char *bitset_ops[] = { "add", "union", "intersect", "subtract", "difference", "iterate" };
+
+static void
+bench_bitset (guint size)
+{
+  gint64 *times = g_new (gint64, runs);
+  GtkBitset *random_set, *range_set;
+  GRand *rand = g_rand_new_with_seed (42);
+  guint *values;
+  guint i, j;
+  int run;
+
+  /* Half of the items chosen at random, as a selection built by hand,
+   * and every other block of 64 items, as a selection built from ranges.
+   */
+  values = g_new (guint, size / 2);
+  for (j = 0; j < size / 2; j++)
+    values[j] = g_rand_int_range (rand, 0, size);
+
+  random_set = gtk_bitset_new_empty ();
+  for (j = 0; j < size / 2; j++)
+    gtk_bitset_add (random_set, values[j]);
+
+  range_set = gtk_bitset_new_empty ();
+  for (j = 0; j < size; j += 128)
+    gtk_bitset_add_range (range_set, j, 64);
+
+  for (i = 0; i < G_N_ELEMENTS (bitset_ops); i++)
+    {
+      for (run = 0; run < runs; run++)
+        {
+          GtkBitset *set;
+          GtkBitsetIter iter;
+          gint64 start;
+
+          set = i == 0 ? gtk_bitset_new_empty () : gtk_bitset_copy (random_set);
+
+          start = g_get_monotonic_time ();
+
+          switch (i)
+            {
+            case 0:
+              for (j = 0; j < size / 2; j++)
+                gtk_bitset_add (set, values[j]);
+              break;
+            case 1:
+              gtk_bitset_union (set, range_set);
+              break;
+            case 2:
+              gtk_bitset_intersect (set, range_set);
+              break;
+            case 3:
+              gtk_bitset_subtract (set, range_set);
+              break;
+            case 4:
+              gtk_bitset_difference (set, range_set);
+              break;
+            case 5:
+              for (gtk_bitset_iter_init_first (&iter, set, &j);
+                   gtk_bitset_iter_is_valid (&iter);
+                   gtk_bitset_iter_next (&iter, &j))
+                ;
+              break;
+            default:
+              g_assert_not_reached ();
+            }
+
+          times[run] = g_get_monotonic_time () - start;
+
+          gtk_bitset_unref (set);
+        }
+
+      report ("bitset", bitset_ops[i], size, times);
+    }
+
+  gtk_bitset_unref (random_set);
+  gtk_bitset_unref (range_set);
+  g_free (values);
+  g_rand_free (rand);
+  g_free (times);
+}
+
+int
+main (int argc, char **argv)
+{
+  GOptionContext *context;
+  GError *error = NULL;
+  guint size;
+
+  context = g_option_context_new ("");
+  g_option_context_add_main_entries (context, options, NULL);
+  if (!g_option_context_parse (context, &argc, &argv, &error))
+    {
+      g_printerr ("Option parsing failed: %s\n", error->message);
+      return 1;
+    }
+
+  if (runs < 1)
+    {
+      g_printerr ("Number of runs given with -r/--runs must be at least 1 and not %d.\n", runs);
+      return 1;
+    }
+
+  if (max_size < 10000 || max_size > 10000000)
+    {
+      g_printerr ("Size given with -s/--max-size must be between 10000 and 10000000 and not %d.\n", max_size);
+      return 1;
+    }
+
+  gtk_init ();
+
+  g_print ("benchmark\tmodel\tsize\truns\tmin_us\tmedian_us\tmax_us\n");
+
+  for (size = 10000; size <= (guint) max_size; size *= 10)
+    {
+      bench_items_changed (size);
+      bench_filter (size, FALSE);
+      bench_filter (size, TRUE);
+      bench_sort (size, FALSE);
+      bench_sort (size, TRUE);
+      bench_get_item (size, FALSE);
+      bench_get_item (size, TRUE);
+      bench_bitset (size);
+    }
+
+  return 0;
+}
@@ -3,6 +3,8 @@
 
 GtkAdjustment *adjustment;
 int cursor_x, cursor_y;
+GdkTimeCoord *history;
+guint n_history;
 
 static void
 motion_cb (GtkEventControllerMotion *motion,
@@ -11,8 +13,14 @@ motion_cb (GtkEventControllerMotion *motion,
            GtkWidget                *widget)
 {
   float processing_ms = gtk_adjustment_get_value (adjustment);
+  GdkEvent *event;
   g_usleep (processing_ms * 1000);
 
+  /* The motions that got compressed into this one */
+  event = gtk_event_controller_get_current_event (GTK_EVENT_CONTROLLER (motion));
+  g_free (history);
+  history = gdk_event_get_history (event, &n_history);
+
   cursor_x = x;
   cursor_y = y;
   gtk_widget_queue_draw (widget);
@@ -32,6 +40,22 @@ on_draw (GtkDrawingArea *da,
 
   cairo_arc (cr, cursor_x, cursor_y, 10, 0, 2 * M_PI);
   cairo_stroke (cr);
+
+  for (guint i = 0; i < n_history; i++)
+    {
+      GtkNative *native = gtk_widget_get_native (GTK_WIDGET (da));
+      double nx, ny, hx, hy;
+
+      /* The history is in surface coordinates */
+      gtk_native_get_surface_transform (native, &nx, &ny);
+      gtk_widget_translate_coordinates (GTK_WIDGET (native),
+                                        GTK_WIDGET (da),
+                                        history[i].axes[GDK_AXIS_X] - nx,
+                                        history[i].axes[GDK_AXIS_Y] - ny,
+                                        &hx, &hy);
+      cairo_arc (cr, hx, hy, 2, 0, 2 * M_PI);
+      cairo_fill (cr);
+    }
 }
 
 static void
@@ -0,0 +1,233 @@
+#include <gtk/gtk.h>
+#include <gsk/gl/gskglrenderer.h>
+#ifdef GDK_RENDERING_VULKAN
+#include <gsk/vulkan/gskvulkanrenderer.h>
+#endif
+#ifdef GDK_WINDOWING_BROADWAY
+#include <gsk/broadway/gskbroadwayrenderer.h>
+#endif
+
+/* Renders every .node file in a directory a number of times with
+ * each renderer that can be realized, and prints the timings as
+ * tab-separated values, one line per file and renderer, so that
+ * runs can be compared by scripts.
+ *
+ * The render time is the time gsk_renderer_render_texture() takes.
+ * The download time additionally includes downloading the texture,
+ * which waits for the GPU to finish.
+ */
+
+static int runs = 10;
+static char **renderer_names = NULL;
+
+static GOptionEntry options[] = {
+  { "runs", 'r', 0, G_OPTION_ARG_INT, &runs, "Render each file N times", "N" },
+  { "renderer", '\0', 0, G_OPTION_ARG_STRING_ARRAY, &renderer_names, "Only use the given renderer", "RENDERER" },
+  { NULL }
+};
+
+static const struct {
+  const char *name;
+  GskRenderer * (* create) (void);
+} renderers[] = {
+  { "cairo", gsk_cairo_renderer_new },
+  { "gl", gsk_gl_renderer_new },
+#ifdef GDK_RENDERING_VULKAN
+  { "vulkan", gsk_vulkan_renderer_new },
+#endif
+#ifdef GDK_WINDOWING_BROADWAY
+  { "broadway", gsk_broadway_renderer_new },
+#endif
+};
+
+static gboolean
+renderer_requested (const char *name)
+{
+  if (renderer_names == NULL)
+    return TRUE;
+
+  return g_strv_contains ((const char * const *) renderer_names, name);
+}
+
+static int
+compare_times (gconstpointer a,
+               gconstpointer b,
+               gpointer      unused)
+{
+  gint64 ta = *(const gint64 *) a;
+  gint64 tb = *(const gint64 *) b;
+
+  return ta < tb ? -1 : (ta > tb ? 1 : 0);
+}
+
+static void
+benchmark_node (const char    *filename,
+                GskRenderNode *node,
+                const char    *renderer_name,
+                GskRenderer   *renderer)
+{
+  gint64 *render_times, *download_times;
+  guchar *data = NULL;
+  int run;
+
+  render_times = g_new (gint64, runs);
+  download_times = g_new (gint64, runs);
+
+  for (run = 0; run < runs; run++)
+    {
+      GdkTexture *texture;
+      gint64 start, rendered, downloaded;
+      int width, height;
+
+      start = g_get_monotonic_time ();
+      texture = gsk_renderer_render_texture (renderer, node, NULL);
+      rendered = g_get_monotonic_time ();
+
+      width = gdk_texture_get_width (texture);
+      height = gdk_texture_get_height (texture);
+      if (data == NULL)
+        data = g_malloc (width * height * 4);
+      gdk_texture_download (texture, data, width * 4);
+      downloaded = g_get_monotonic_time ();
+
+      render_times[run] = rendered - start;
+      download_times[run] = downloaded - start;
+
+      g_object_unref (texture);
+    }
+
+  g_qsort_with_data (render_times, runs, sizeof (gint64), compare_times, NULL);
+  g_qsort_with_data (download_times, runs, sizeof (gint64), compare_times, NULL);
+
+  g_print ("%s\t%s\t%d\t%" G_GINT64_FORMAT "\t%" G_GINT64_FORMAT "\t%" G_GINT64_FORMAT "\t%" G_GINT64_FORMAT "\n",
+           filename,
+           renderer_name,
+           runs,
+           render_times[0],
+           render_times[runs / 2],
+           render_times[runs - 1],
+           download_times[runs / 2]);
+
+  g_free (data);
+  g_free (render_times);
+  g_free (download_times);
+}
+
+static GskRenderNode *
+load_node (const char *path)
+{
+  GskRenderNode *node;
+  GError *error = NULL;
+  GBytes *bytes;
+  char *contents;
+  gsize len;
+
+  if (!g_file_get_contents (path, &contents, &len, &error))
+    {
+      g_printerr ("Could not open node file: %s\n", error->message);
+      g_error_free (error);
+      return NULL;
+    }
+
+  bytes = g_bytes_new_take (contents, len);
+  node = gsk_render_node_deserialize (bytes, NULL, NULL);
+  g_bytes_unref (bytes);
+
+  if (node == NULL)
+    g_printerr ("Could not parse %s\n", path);
+
+  return node;
+}
+
+int
+main (int argc, char **argv)
+{
+  GOptionContext *context;
+  GError *error = NULL;
+  GdkSurface *surface;
+  GPtrArray *files;
+  GDir *dir;
+  const char *name;
+  guint i, j;
+
+  context = g_option_context_new ("DIRECTORY");
+  g_option_context_add_main_entries (context, options, NULL);
+  if (!g_option_context_parse (context, &argc, &argv, &error))
+    {
+      g_printerr ("Option parsing failed: %s\n", error->message);
+      return 1;
+    }
+
+  if (argc != 2)
+    {
+      g_printerr ("Usage: %s [OPTIONS] DIRECTORY\n", argv[0]);
+      return 1;
+    }
+
+  if (runs < 1)
+    {
+      g_printerr ("Number of runs given with -r/--runs must be at least 1 and not %d.\n", runs);
+      return 1;
+    }
+
+  gtk_init ();
+
+  dir = g_dir_open (argv[1], 0, &error);
+  if (dir == NULL)
+    {
+      g_printerr ("Could not open directory: %s\n", error->message);
+      return 1;
+    }
+
+  files = g_ptr_array_new_with_free_func (g_free);
+  while ((name = g_dir_read_name (dir)))
+    {
+      if (g_str_has_suffix (name, ".node"))
+        g_ptr_array_add (files, g_build_filename (argv[1], name, NULL));
+    }
+  g_dir_close (dir);
+  g_ptr_array_sort (files, (GCompareFunc) g_strcmp0);
+
+  surface = gdk_surface_new_toplevel (gdk_display_get_default ());
+
+  g_print ("file\trenderer\truns\tmin_us\tmedian_us\tmax_us\tmedian_download_us\n");
+
+  for (i = 0; i < G_N_ELEMENTS (renderers); i++)
+    {
+      GskRenderer *renderer;
+
+      if (!renderer_requested (renderers[i].name))
+        continue;
+
+      renderer = renderers[i].create ();
+      if (!gsk_renderer_realize (renderer, surface, &error))
+        {
+          g_printerr ("Skipping %s renderer: %s\n", renderers[i].name, error->message);
+          g_clear_error (&error);
+          g_object_unref (renderer);
+          continue;
+        }
+
+      for (j = 0; j < files->len; j++)
+        {
+          const char *path = g_ptr_array_index (files, j);
+          GskRenderNode *node;
+
+          node = load_node (path);
+          if (node == NULL)
+            continue;
+
+          benchmark_node (path, node, renderers[i].name, renderer);
+
+          gsk_render_node_unref (node);
+        }
+
+      gsk_renderer_unrealize (renderer);
+      g_object_unref (renderer);
+    }
+
+  g_ptr_array_unref (files);
+  gdk_surface_destroy (surface);
+
+  return 0;
+}
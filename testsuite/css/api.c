@@ -20,6 +20,8 @@
 
 #include <gtk/gtk.h>
 
+#include <string.h>
+
 static void
 gtk_css_provider_load_data_not_null_terminated (void)
 {
@@ -33,14 +35,178 @@ gtk_css_provider_load_data_not_null_terminated (void)
   g_object_unref (p);
 }
 
+static void
+gtk_css_provider_load_precompiled (void)
+{
+  const char *css = "@define-color fg #123456;\n"
+                    "/* a comment */\n"
+                    "button.text-button > label:hover, .foo #bar {\n"
+                    "  color: @fg;\n"
+                    "  font-family: \"Cantarell\", sans-serif;\n"
+                    "  margin: 2px 1.5em -3px 0;\n"
+                    "  background-image: linear-gradient(to bottom, alpha(red, 0.5), rgb(0, 0, 255));\n"
+                    "}\n";
+  GtkCssProvider *p;
+  GFile *file;
+  GFileIOStream *stream;
+  GError *error = NULL;
+  char *parsed, *replayed, *dir;
+  GDir *cache;
+
+  file = g_file_new_tmp ("precompiledXXXXXX.css", &stream, &error);
+  g_assert_no_error (error);
+  g_object_unref (stream);
+  g_file_replace_contents (file, css, strlen (css), NULL, FALSE, 0, NULL, NULL, &error);
+  g_assert_no_error (error);
+
+  p = gtk_css_provider_new ();
+  gtk_css_provider_load_from_file (p, file);
+  parsed = gtk_css_provider_to_string (p);
+  g_object_unref (p);
+
+  /* The first load must have left a precompiled copy behind */
+  dir = g_build_filename (g_get_user_cache_dir (), "gtk-4.0", "css", NULL);
+  cache = g_dir_open (dir, 0, &error);
+  g_assert_no_error (error);
+  g_assert_nonnull (g_dir_read_name (cache));
+  g_dir_close (cache);
+  g_free (dir);
+
+  p = gtk_css_provider_new ();
+  gtk_css_provider_load_from_file (p, file);
+  replayed = gtk_css_provider_to_string (p);
+  g_object_unref (p);
+
+  g_assert_cmpstr (parsed, ==, replayed);
+
+  g_free (parsed);
+  g_free (replayed);
+  g_file_delete (file, NULL, NULL);
+  g_object_unref (file);
+}
+
+static void
+load_async_done (GObject      *source,
+                 GAsyncResult *result,
+                 gpointer      data)
+{
+  gboolean *done = data;
+  GError *error = NULL;
+
+  g_assert_true (gtk_css_provider_load_from_file_finish (GTK_CSS_PROVIDER (source), result, &error));
+  g_assert_no_error (error);
+
+  *done = TRUE;
+  g_main_context_wakeup (NULL);
+}
+
+static void
+gtk_css_provider_load_file_async (void)
+{
+  const char *css = "label:hover { color: red; }\n"
+                    ".foo > #bar { margin: 2px; }\n";
+  GtkCssProvider *p;
+  GFile *file;
+  GFileIOStream *stream;
+  GError *error = NULL;
+  char *sync, *async;
+  gboolean done = FALSE;
+
+  file = g_file_new_tmp ("asyncXXXXXX.css", &stream, &error);
+  g_assert_no_error (error);
+  g_object_unref (stream);
+  g_file_replace_contents (file, css, strlen (css), NULL, FALSE, 0, NULL, NULL, &error);
+  g_assert_no_error (error);
+
+  p = gtk_css_provider_new ();
+  gtk_css_provider_load_from_file (p, file);
+  sync = gtk_css_provider_to_string (p);
+  g_object_unref (p);
+
+  p = gtk_css_provider_new ();
+  gtk_css_provider_load_from_file_async (p, file, NULL, load_async_done, &done);
+  while (!done)
+    g_main_context_iteration (NULL, TRUE);
+  async = gtk_css_provider_to_string (p);
+  g_object_unref (p);
+
+  g_assert_cmpstr (sync, ==, async);
+
+  g_free (sync);
+  g_free (async);
+  g_file_delete (file, NULL, NULL);
+  g_object_unref (file);
+}
+
+static void
+assert_color (GtkWidget  *widget,
+              const char *expected)
+{
+  GdkRGBA color, expected_color;
+
+  gtk_style_context_get_color (gtk_widget_get_style_context (widget), &color);
+  gdk_rgba_parse (&expected_color, expected);
+  g_assert_true (gdk_rgba_equal (&color, &expected_color));
+}
+
+static void
+gtk_css_provider_reload_changed_rules (void)
+{
+  GtkCssProvider *p;
+  GtkWidget *box, *label, *button;
+
+  box = gtk_box_new (GTK_ORIENTATION_HORIZONTAL, 0);
+  label = gtk_label_new ("label");
+  button = gtk_button_new ();
+  gtk_box_append (GTK_BOX (box), label);
+  gtk_box_append (GTK_BOX (box), button);
+  g_object_ref_sink (box);
+
+  p = gtk_css_provider_new ();
+  gtk_style_context_add_provider_for_display (gdk_display_get_default (),
+                                              GTK_STYLE_PROVIDER (p),
+                                              GTK_STYLE_PROVIDER_PRIORITY_USER);
+
+  gtk_css_provider_load_from_data (p, "box label { color: red; } button { color: blue; }", -1);
+  assert_color (label, "red");
+  assert_color (button, "blue");
+
+  /* Only the declarations change, so only the label gets restyled */
+  gtk_css_provider_load_from_data (p, "box label { color: lime; } button { color: blue; }", -1);
+  assert_color (label, "lime");
+  assert_color (button, "blue");
+
+  /* Rules change, so everything gets restyled */
+  gtk_css_provider_load_from_data (p, "label { color: red; } button { color: red; }", -1);
+  assert_color (label, "red");
+  assert_color (button, "red");
+
+  gtk_style_context_remove_provider_for_display (gdk_display_get_default (),
+                                                 GTK_STYLE_PROVIDER (p));
+  g_object_unref (p);
+  g_object_unref (box);
+}
 
 int
 main (int argc, char *argv[])
 {
+  char *cache_dir;
+
+  /* Don't put precompiled CSS into the user's cache */
+  cache_dir = g_dir_make_tmp ("css-api-XXXXXX", NULL);
+  g_setenv ("XDG_CACHE_HOME", cache_dir, TRUE);
+  g_free (cache_dir);
+
   gtk_test_init (&argc, &argv, NULL);
 
   g_test_add_func ("/gtk_css_provider_load_data/not_null_terminated",
       gtk_css_provider_load_data_not_null_terminated);
+  g_test_add_func ("/gtk_css_provider_load_file/precompiled",
+      gtk_css_provider_load_precompiled);
+  g_test_add_func ("/gtk_css_provider_load_file/async",
+      gtk_css_provider_load_file_async);
+  g_test_add_func ("/gtk_css_provider/reload/changed_rules",
+      gtk_css_provider_reload_changed_rules);
 
   return g_test_run ();
 }
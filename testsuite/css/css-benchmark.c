@@ -0,0 +1,325 @@
+#include <gtk/gtk.h>
+
+/* Benchmarks the CSS machinery on synthetic widget trees with the
+ * builtin themes and prints the timings as tab-separated values,
+ * one line per benchmark, theme and tree.
+ *
+ * The trees consist of plain widgets that only have a CSS node, so
+ * the timings are dominated by style work:
+ *
+ * - parse: loading the theme into a new provider
+ * - style: computing the styles of a freshly created tree. The Empty
+ *   theme has no selectors, so comparing it to the other themes
+ *   shows the cost of selector matching
+ * - class-toggle and state-toggle: recomputing the styles after
+ *   changing a class or the backdrop state of the root
+ *
+ * The list tree has identical rows, which share their styles through
+ * the style cache, and the unique-list tree gives every row its own
+ * class, which defeats the cache. Comparing the two shows how
+ * effective the cache is.
+ */
+
+static int runs = 10;
+static int size = 10000;
+
+static GOptionEntry options[] = {
+  { "runs", 'r', 0, G_OPTION_ARG_INT, &runs, "Run each benchmark N times", "N" },
+  { "size", 's', 0, G_OPTION_ARG_INT, &size, "Number of widgets in each tree", "N" },
+  { NULL }
+};
+
+static const char *themes[] = { "Empty", "Adwaita", "HighContrast" };
+
+/* The depth of the chains in the deep tree */
+#define CHAIN_DEPTH 200
+
+typedef GtkWidget BenchNode;
+typedef GtkWidgetClass BenchNodeClass;
+
+static GType bench_node_get_type (void);
+G_DEFINE_TYPE (BenchNode, bench_node, GTK_TYPE_WIDGET)
+
+static void
+bench_node_dispose (GObject *object)
+{
+  GtkWidget *child;
+
+  while ((child = gtk_widget_get_first_child (GTK_WIDGET (object))))
+    gtk_widget_unparent (child);
+
+  G_OBJECT_CLASS (bench_node_parent_class)->dispose (object);
+}
+
+static void
+bench_node_class_init (BenchNodeClass *klass)
+{
+  G_OBJECT_CLASS (klass)->dispose = bench_node_dispose;
+}
+
+static void
+bench_node_init (BenchNode *node)
+{
+}
+
+static GtkWidget *
+bench_node_new (GtkWidget  *parent,
+                const char *css_name)
+{
+  GtkWidget *node = g_object_new (bench_node_get_type (), "css-name", css_name, NULL);
+
+  if (parent)
+    gtk_widget_set_parent (node, parent);
+
+  return node;
+}
+
+static GtkWidget *
+create_wide (void)
+{
+  GtkWidget *root = bench_node_new (NULL, "box");
+  int i;
+
+  for (i = 1; i < size; i++)
+    {
+      GtkWidget *child = bench_node_new (root, i % 2 ? "button" : "label");
+      gtk_widget_add_css_class (child, "flat");
+    }
+
+  return root;
+}
+
+static GtkWidget *
+create_deep (void)
+{
+  GtkWidget *root = bench_node_new (NULL, "box");
+  int i;
+
+  for (i = 1; i < size; i += CHAIN_DEPTH)
+    {
+      GtkWidget *parent = root;
+      int j;
+
+      for (j = 0; j < CHAIN_DEPTH && i + j < size; j++)
+        parent = bench_node_new (parent, j % 2 ? "box" : "frame");
+    }
+
+  return root;
+}
+
+static GtkWidget *
+create_list_with_classes (gboolean unique)
+{
+  GtkWidget *root = bench_node_new (NULL, "list");
+  int i;
+
+  gtk_widget_add_css_class (root, "boxed-list");
+
+  for (i = 1; i + 3 < size; i += 4)
+    {
+      GtkWidget *row = bench_node_new (root, "row");
+
+      gtk_widget_add_css_class (row, "activatable");
+      if (unique)
+        {
+          char *class = g_strdup_printf ("row-%d", i);
+          gtk_widget_add_css_class (row, class);
+          g_free (class);
+        }
+
+      bench_node_new (row, "image");
+      bench_node_new (row, "label");
+      gtk_widget_add_css_class (bench_node_new (row, "label"), "dim-label");
+    }
+
+  return root;
+}
+
+static GtkWidget *
+create_list (void)
+{
+  return create_list_with_classes (FALSE);
+}
+
+static GtkWidget *
+create_unique_list (void)
+{
+  return create_list_with_classes (TRUE);
+}
+
+static const struct {
+  const char *name;
+  GtkWidget * (* create) (void);
+} trees[] = {
+  { "wide", create_wide },
+  { "deep", create_deep },
+  { "list", create_list },
+  { "unique-list", create_unique_list },
+};
+
+/* Looking up a style property makes the CSS node compute its style
+ * if it is not up to date.
+ */
+static void
+ensure_styles (GtkWidget *widget)
+{
+  GtkWidget *child;
+  GdkRGBA color;
+
+  gtk_style_context_get_color (gtk_widget_get_style_context (widget), &color);
+
+  for (child = gtk_widget_get_first_child (widget);
+       child != NULL;
+       child = gtk_widget_get_next_sibling (child))
+    ensure_styles (child);
+}
+
+static int
+compare_times (gconstpointer a,
+               gconstpointer b,
+               gpointer      unused)
+{
+  gint64 ta = *(const gint64 *) a;
+  gint64 tb = *(const gint64 *) b;
+
+  return ta < tb ? -1 : (ta > tb ? 1 : 0);
+}
+
+static void
+report (const char *benchmark,
+        const char *theme,
+        const char *tree,
+        gint64     *times)
+{
+  g_qsort_with_data (times, runs, sizeof (gint64), compare_times, NULL);
+
+  g_print ("%s\t%s\t%s\t%d\t%d\t%" G_GINT64_FORMAT "\t%" G_GINT64_FORMAT "\t%" G_GINT64_FORMAT "\n",
+           benchmark,
+           theme,
+           tree,
+           size,
+           runs,
+           times[0],
+           times[runs / 2],
+           times[runs - 1]);
+}
+
+static void
+bench_parse (const char *theme)
+{
+  gint64 *times = g_new (gint64, runs);
+  char *path;
+  int run;
+
+  path = g_strdup_printf ("/org/gtk/libgtk/theme/%s/gtk.css", theme);
+
+  for (run = 0; run < runs; run++)
+    {
+      GtkCssProvider *provider = gtk_css_provider_new ();
+      gint64 start = g_get_monotonic_time ();
+
+      gtk_css_provider_load_from_resource (provider, path);
+
+      times[run] = g_get_monotonic_time () - start;
+
+      g_object_unref (provider);
+    }
+
+  report ("parse", theme, "-", times);
+
+  g_free (path);
+  g_free (times);
+}
+
+static void
+bench_tree (GtkWidget  *window,
+            const char *theme,
+            guint       tree)
+{
+  gint64 *style_times = g_new (gint64, runs);
+  gint64 *class_times = g_new (gint64, runs);
+  gint64 *state_times = g_new (gint64, runs);
+  int run;
+
+  for (run = 0; run < runs; run++)
+    {
+      GtkWidget *root;
+      gint64 start;
+
+      root = trees[tree].create ();
+      gtk_window_set_child (GTK_WINDOW (window), root);
+
+      start = g_get_monotonic_time ();
+      ensure_styles (root);
+      style_times[run] = g_get_monotonic_time () - start;
+
+      start = g_get_monotonic_time ();
+      gtk_widget_add_css_class (root, "toggled");
+      ensure_styles (root);
+      class_times[run] = g_get_monotonic_time () - start;
+
+      start = g_get_monotonic_time ();
+      gtk_widget_set_state_flags (root, GTK_STATE_FLAG_BACKDROP, FALSE);
+      ensure_styles (root);
+      state_times[run] = g_get_monotonic_time () - start;
+
+      gtk_window_set_child (GTK_WINDOW (window), NULL);
+    }
+
+  report ("style", theme, trees[tree].name, style_times);
+  report ("class-toggle", theme, trees[tree].name, class_times);
+  report ("state-toggle", theme, trees[tree].name, state_times);
+
+  g_free (style_times);
+  g_free (class_times);
+  g_free (state_times);
+}
+
+int
+main (int argc, char **argv)
+{
+  GOptionContext *context;
+  GError *error = NULL;
+  GtkWidget *window;
+  guint i, j;
+
+  context = g_option_context_new ("");
+  g_option_context_add_main_entries (context, options, NULL);
+  if (!g_option_context_parse (context, &argc, &argv, &error))
+    {
+      g_printerr ("Option parsing failed: %s\n", error->message);
+      return 1;
+    }
+
+  if (runs < 1)
+    {
+      g_printerr ("Number of runs given with -r/--runs must be at least 1 and not %d.\n", runs);
+      return 1;
+    }
+
+  if (size < 2)
+    {
+      g_printerr ("Size given with -s/--size must be at least 2 and not %d.\n", size);
+      return 1;
+    }
+
+  gtk_init ();
+
+  window = gtk_window_new ();
+
+  g_print ("benchmark\ttheme\ttree\tsize\truns\tmin_us\tmedian_us\tmax_us\n");
+
+  for (i = 0; i < G_N_ELEMENTS (themes); i++)
+    {
+      g_object_set (gtk_settings_get_default (), "gtk-theme-name", themes[i], NULL);
+
+      bench_parse (themes[i]);
+
+      for (j = 0; j < G_N_ELEMENTS (trees); j++)
+        bench_tree (window, themes[i], j);
+    }
+
+  gtk_window_destroy (GTK_WINDOW (window));
+
+  return 0;
+}
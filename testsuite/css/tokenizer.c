@@ -0,0 +1,171 @@
+/*
+ * Copyright © 2020 Red Hat Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include "../../gtk/css/gtkcsstokenizerprivate.h"
+
+#include <locale.h>
+#include <string.h>
+
+static GtkCssTokenizer *
+tokenizer_new (const char *css)
+{
+  GBytes *bytes;
+  GtkCssTokenizer *tokenizer;
+
+  bytes = g_bytes_new_static (css, strlen (css));
+  tokenizer = gtk_css_tokenizer_new (bytes);
+  g_bytes_unref (bytes);
+
+  return tokenizer;
+}
+
+static void
+assert_token (GtkCssTokenizer *tokenizer,
+              GtkCssTokenType  type,
+              const char      *string)
+{
+  GtkCssToken token;
+  GError *error = NULL;
+
+  gtk_css_tokenizer_read_token (tokenizer, &token, &error);
+  g_assert_no_error (error);
+  g_assert_cmpint (token.type, ==, type);
+  if (string)
+    g_assert_cmpstr (token.string.string, ==, string);
+  gtk_css_token_clear (&token);
+}
+
+static void
+assert_location (GtkCssTokenizer *tokenizer,
+                 gsize            bytes,
+                 gsize            chars,
+                 gsize            lines,
+                 gsize            line_chars)
+{
+  const GtkCssLocation *location = gtk_css_tokenizer_get_location (tokenizer);
+
+  g_assert_cmpuint (location->bytes, ==, bytes);
+  g_assert_cmpuint (location->chars, ==, chars);
+  g_assert_cmpuint (location->lines, ==, lines);
+  g_assert_cmpuint (location->line_chars, ==, line_chars);
+}
+
+/* Comments, strings and names are consumed in runs,
+ * make sure the locations still come out right */
+static void
+test_locations (void)
+{
+  GtkCssTokenizer *tokenizer;
+
+  tokenizer = tokenizer_new ("/* ** área\n * --- */  \t\n"
+                             "\"a 'quoted' stríng with a lot of text \\\" in it\""
+                             "\tgrüße-is_a-name");
+
+  assert_token (tokenizer, GTK_CSS_TOKEN_COMMENT, NULL);
+  assert_location (tokenizer, 21, 20, 1, 9);
+  assert_token (tokenizer, GTK_CSS_TOKEN_WHITESPACE, NULL);
+  assert_location (tokenizer, 25, 24, 2, 0);
+  assert_token (tokenizer, GTK_CSS_TOKEN_STRING, "a 'quoted' stríng with a lot of text \" in it");
+  assert_location (tokenizer, 73, 71, 2, 47);
+  assert_token (tokenizer, GTK_CSS_TOKEN_WHITESPACE, NULL);
+  assert_token (tokenizer, GTK_CSS_TOKEN_IDENT, "grüße-is_a-name");
+  assert_location (tokenizer, 91, 87, 2, 63);
+  assert_token (tokenizer, GTK_CSS_TOKEN_EOF, NULL);
+
+  gtk_css_tokenizer_unref (tokenizer);
+}
+
+static char *
+create_stylesheet (gsize size)
+{
+  GString *string = g_string_new (NULL);
+  guint i;
+
+  for (i = 0; string->len < size; i++)
+    {
+      g_string_append_printf (string,
+                              "/* Generated rule %u, this comment is long\n"
+                              " * enough to span multiple lines. */\n"
+                              "window.background > box.vertical button.text-button-%u:hover label {\n"
+                              "  font-family: \"Cantarell\", \"Droid Sans\", sans-serif;\n"
+                              "  background-image: linear-gradient(to bottom, #%06x, alpha(@theme_bg_color, 0.5));\n"
+                              "  margin: calc(%upx + 1em) 2px;\n"
+                              "}\n\n",
+                              i, i, i & 0xFFFFFF, i % 17);
+    }
+
+  return g_string_free (string, FALSE);
+}
+
+static void
+test_performance (void)
+{
+  GtkCssTokenizer *tokenizer;
+  GtkCssToken token;
+  GError *error = NULL;
+  char *css;
+  guint i, n_runs;
+  gsize n_tokens;
+  gboolean eof;
+
+  css = create_stylesheet (g_test_perf () ? 1500 * 1000 : 50 * 1000);
+  n_runs = g_test_perf () ? 10 : 1;
+
+  g_test_timer_start ();
+
+  for (i = 0; i < n_runs; i++)
+    {
+      tokenizer = tokenizer_new (css);
+      n_tokens = 0;
+
+      do
+        {
+          gtk_css_tokenizer_read_token (tokenizer, &token, &error);
+          g_assert_no_error (error);
+          g_assert_cmpint (token.type, !=, GTK_CSS_TOKEN_BAD_STRING);
+          eof = gtk_css_token_is (&token, GTK_CSS_TOKEN_EOF);
+          gtk_css_token_clear (&token);
+          n_tokens++;
+        }
+      while (!eof);
+
+      g_assert_cmpuint (gtk_css_tokenizer_get_location (tokenizer)->bytes, ==, strlen (css));
+
+      gtk_css_tokenizer_unref (tokenizer);
+    }
+
+  if (g_test_perf ())
+    g_test_minimized_result (g_test_timer_elapsed () / n_runs,
+                             "Tokenized %zu bytes into %zu tokens in %.4f secs",
+                             strlen (css), n_tokens, g_test_timer_elapsed () / n_runs);
+
+  g_free (css);
+}
+
+int
+main (int argc, char *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+  setlocale (LC_ALL, "C");
+
+  g_test_add_func ("/css/tokenizer/locations", test_locations);
+  g_test_add_func ("/css/tokenizer/performance", test_performance);
+
+  return g_test_run ();
+}
@@ -70,6 +70,66 @@ test_clipboard_basic (void)
   g_value_unset (&value);
 }
 
+static void
+serialize_done (GObject      *source,
+                GAsyncResult *res,
+                gpointer      data)
+{
+  gboolean *done = data;
+  GError *error = NULL;
+  gboolean ret;
+
+  ret = gdk_content_serialize_finish (res, &error);
+
+  g_assert_no_error (error);
+  g_assert_true (ret);
+
+  *done = TRUE;
+
+  g_main_context_wakeup (NULL);
+}
+
+/* Bigger than the chunks that strings are written in */
+static void
+test_clipboard_serialize_big_text (void)
+{
+  const char *mime_types[] = { "text/plain;charset=utf-8", "text/plain" };
+  GValue value = G_VALUE_INIT;
+  GString *text;
+  guint i;
+
+  text = g_string_new (NULL);
+  for (i = 0; text->len < 300 * 1024; i++)
+    g_string_append_printf (text, "line %u\n", i);
+
+  g_value_init (&value, G_TYPE_STRING);
+  g_value_set_string (&value, text->str);
+
+  for (i = 0; i < G_N_ELEMENTS (mime_types); i++)
+    {
+      GOutputStream *stream;
+      gboolean done = FALSE;
+
+      stream = g_memory_output_stream_new_resizable ();
+
+      gdk_content_serialize_async (stream, mime_types[i], &value,
+                                   G_PRIORITY_DEFAULT, NULL,
+                                   serialize_done, &done);
+
+      while (!done)
+        g_main_context_iteration (NULL, TRUE);
+
+      g_assert_cmpmem (g_memory_output_stream_get_data (G_MEMORY_OUTPUT_STREAM (stream)),
+                       g_memory_output_stream_get_data_size (G_MEMORY_OUTPUT_STREAM (stream)),
+                       text->str, text->len);
+
+      g_object_unref (stream);
+    }
+
+  g_value_unset (&value);
+  g_string_free (text, TRUE);
+}
+
 int
 main (int argc, char *argv[])
 {
@@ -78,6 +138,7 @@ main (int argc, char *argv[])
   gtk_init ();
 
   g_test_add_func ("/clipboard/basic", test_clipboard_basic);
+  g_test_add_func ("/clipboard/serialize-big-text", test_clipboard_serialize_big_text);
 
   return g_test_run ();
 }
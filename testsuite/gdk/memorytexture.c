@@ -2,7 +2,7 @@
 #include <gdk/gdk.h>
 
 /* maximum bytes per pixel */
-#define MAX_BPP 4
+#define MAX_BPP 16
 
 typedef enum {
   BLUE,
@@ -44,8 +44,55 @@ static MemoryData tests[GDK_MEMORY_N_FORMATS] = {
   { 4, FALSE, { RGBA(FF,FF,00,00), RGBA(FF,00,FF,00), RGBA(FF,00,00,FF), RGBA(00,00,00,00), RGBA(AA,99,33,66) } },
   { 3, TRUE,  { RGBA(00,00,FF,00), RGBA(00,FF,00,00), RGBA(FF,00,00,00), RGBA(00,00,00,00), RGBA(44,22,66,00) } },
   { 3, TRUE,  { RGBA(FF,00,00,00), RGBA(00,FF,00,00), RGBA(00,00,FF,00), RGBA(00,00,00,00), RGBA(66,22,44,00) } },
+  /* filled in by init_wide_formats() */
+  { 8, FALSE, },
+  { 8, FALSE, },
+  { 16, FALSE, },
 };
 
+static guint16
+float_to_half (float value)
+{
+  guint32 bits, exponent, mantissa;
+
+  /* good enough for the values we need, which are all normal */
+  if (value == 0.f)
+    return 0;
+
+  memcpy (&bits, &value, sizeof (float));
+  exponent = ((bits >> 23) & 0xFF) - 112;
+  mantissa = bits & 0x7FFFFF;
+
+  return ((exponent << 10) | (mantissa >> 13)) + ((mantissa >> 12) & 1);
+}
+
+/* The wide formats store channels in host byte order, so compute
+ * their contents from the 8 bit RGBA data */
+static void
+init_wide_formats (void)
+{
+  Color color;
+  int i;
+
+  for (color = 0; color < N_COLORS; color++)
+    {
+      const guchar *rgba = tests[GDK_MEMORY_R8G8B8A8_PREMULTIPLIED].data[color];
+      guint16 u16[4], f16[4];
+      float f32[4];
+
+      for (i = 0; i < 4; i++)
+        {
+          u16[i] = rgba[i] * 257;
+          f32[i] = rgba[i] / 255.f;
+          f16[i] = float_to_half (f32[i]);
+        }
+
+      memcpy (tests[GDK_MEMORY_R16G16B16A16_PREMULTIPLIED].data[color], u16, sizeof (u16));
+      memcpy (tests[GDK_MEMORY_R16G16B16A16_FLOAT_PREMULTIPLIED].data[color], f16, sizeof (f16));
+      memcpy (tests[GDK_MEMORY_R32G32B32A32_FLOAT_PREMULTIPLIED].data[color], f32, sizeof (f32));
+    }
+}
+
 static void
 compare_textures (GdkTexture *expected,
                   GdkTexture *test,
@@ -182,6 +229,8 @@ main (int argc, char *argv[])
 
   g_test_init (&argc, &argv, NULL);
 
+  init_wide_formats ();
+
   enum_class = g_type_class_ref (GDK_TYPE_MEMORY_FORMAT);
 
   for (format = 0; format < GDK_MEMORY_N_FORMATS; format++)
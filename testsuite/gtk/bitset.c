@@ -555,6 +555,32 @@ test_splice_overflow (void)
   g_assert_true (gtk_bitset_equals (set, compare));
 }
 
+static void
+test_serialize (void)
+{
+  GtkBitset *set, *copy;
+  GBytes *bytes, *truncated;
+  guint i;
+
+  for (i = 0; i < G_N_ELEMENTS (bitsets); i++)
+    {
+      set = bitsets[i].create();
+
+      bytes = gtk_bitset_serialize (set);
+      copy = gtk_bitset_deserialize (bytes);
+      g_assert_nonnull (copy);
+      g_assert_true (gtk_bitset_equals (set, copy));
+      gtk_bitset_unref (copy);
+
+      truncated = g_bytes_new_from_bytes (bytes, 0, g_bytes_get_size (bytes) - 1);
+      g_assert_null (gtk_bitset_deserialize (truncated));
+      g_bytes_unref (truncated);
+
+      g_bytes_unref (bytes);
+      gtk_bitset_unref (set);
+    }
+}
+
 int
 main (int argc, char *argv[])
 {
@@ -575,6 +601,7 @@ main (int argc, char *argv[])
   g_test_add_func ("/bitset/rectangle", test_rectangle);
   g_test_add_func ("/bitset/iter", test_iter);
   g_test_add_func ("/bitset/splice-overflow", test_splice_overflow);
+  g_test_add_func ("/bitset/serialize", test_serialize);
 
   return g_test_run ();
 }
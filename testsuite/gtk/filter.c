@@ -320,6 +320,14 @@ test_string_properties (void)
   gtk_string_filter_set_match_mode (GTK_STRING_FILTER (filter), GTK_STRING_FILTER_MATCH_MODE_SUBSTRING);
   assert_model (model, "13 113 213 313 413 513 613 713 813 913");
 
+  /* a longer search is not more strict for exact matches */
+  gtk_string_filter_set_match_mode (GTK_STRING_FILTER (filter), GTK_STRING_FILTER_MATCH_MODE_EXACT);
+  gtk_string_filter_set_search (GTK_STRING_FILTER (filter), "one");
+  assert_model (model, "1");
+
+  gtk_string_filter_set_search (GTK_STRING_FILTER (filter), "one hundred");
+  assert_model (model, "100");
+
   g_object_unref (model);
   g_object_unref (filter);
 }
@@ -18,6 +18,7 @@
  */
 
 #include <locale.h>
+#include <string.h>
 
 #include <gtk/gtk.h>
 
@@ -376,6 +377,58 @@ test_incremental (void)
   g_object_unref (filter);
 }
 
+static void
+count_changes (GListModel *model,
+               guint       position,
+               guint       removed,
+               guint       added,
+               guint      *n_changes)
+{
+  (*n_changes)++;
+}
+
+/* large enough to be run in the thread pool */
+static void
+test_threaded (void)
+{
+  GtkFilterListModel *filter;
+  GtkStringFilter *string_filter;
+  GtkStringList *list;
+  guint i, n_expected, n_changes;
+  char buf[32];
+
+  list = gtk_string_list_new (NULL);
+  n_expected = 0;
+  for (i = 0; i < 20000; i++)
+    {
+      g_snprintf (buf, sizeof (buf), "item %u", i);
+      gtk_string_list_append (list, buf);
+      if (strchr (buf, '7'))
+        n_expected++;
+    }
+
+  string_filter = gtk_string_filter_new (gtk_property_expression_new (GTK_TYPE_STRING_OBJECT, NULL, "string"));
+  filter = gtk_filter_list_model_new (G_LIST_MODEL (list), GTK_FILTER (string_filter));
+  n_changes = 0;
+  g_signal_connect (filter, "items-changed", G_CALLBACK (count_changes), &n_changes);
+
+  gtk_string_filter_set_search (string_filter, "7");
+  g_assert_cmpuint (n_changes, ==, 1);
+  g_assert_cmpuint (g_list_model_get_n_items (G_LIST_MODEL (filter)), ==, n_expected);
+  for (i = 0; i < n_expected; i++)
+    {
+      GtkStringObject *object = g_list_model_get_item (G_LIST_MODEL (filter), i);
+      g_assert_nonnull (strchr (gtk_string_object_get_string (object), '7'));
+      g_object_unref (object);
+    }
+
+  gtk_string_filter_set_search (string_filter, "item 1999");
+  g_assert_cmpuint (n_changes, ==, 2);
+  g_assert_cmpuint (g_list_model_get_n_items (G_LIST_MODEL (filter)), ==, 11);
+
+  g_object_unref (filter);
+}
+
 int
 main (int argc, char *argv[])
 {
@@ -389,6 +442,7 @@ main (int argc, char *argv[])
   g_test_add_func ("/filterlistmodel/empty_set_filter", test_empty_set_filter);
   g_test_add_func ("/filterlistmodel/change_filter", test_change_filter);
   g_test_add_func ("/filterlistmodel/incremental", test_incremental);
+  g_test_add_func ("/filterlistmodel/threaded", test_threaded);
 
   return g_test_run ();
 }
@@ -286,6 +286,50 @@ test_set_map_func (void)
   g_object_unref (map);
 }
 
+static gpointer
+map_count (gpointer item,
+           gpointer data)
+{
+  guint *n_mapped = data;
+
+  (*n_mapped)++;
+
+  return map_multiply (item, GUINT_TO_POINTER (2));
+}
+
+static void
+test_cache_size (void)
+{
+  GtkMapListModel *map;
+  GListStore *store;
+  guint n_mapped = 0;
+
+  store = new_store (1, 5, 1);
+  map = gtk_map_list_model_new (G_LIST_MODEL (store), map_count, &n_mapped, NULL);
+
+  assert_model (map, "2 4 6 8 10");
+  assert_model (map, "2 4 6 8 10");
+  g_assert_cmpuint (n_mapped, ==, 10);
+
+  gtk_map_list_model_set_cache_size (map, 3);
+  n_mapped = 0;
+  assert_model (map, "2 4 6 8 10");
+  g_assert_cmpuint (n_mapped, ==, 5);
+  /* the last 3 items are cached */
+  g_assert_cmpuint (get (G_LIST_MODEL (map), 4), ==, 10);
+  g_assert_cmpuint (get (G_LIST_MODEL (map), 2), ==, 6);
+  g_assert_cmpuint (n_mapped, ==, 5);
+  g_assert_cmpuint (get (G_LIST_MODEL (map), 0), ==, 2);
+  g_assert_cmpuint (n_mapped, ==, 6);
+
+  gtk_map_list_model_set_cache_size (map, 0);
+  n_mapped = 0;
+  assert_model (map, "2 4 6 8 10");
+  g_assert_cmpuint (n_mapped, ==, 5);
+
+  g_object_unref (map);
+}
+
 int
 main (int argc, char *argv[])
 {
@@ -299,6 +343,7 @@ main (int argc, char *argv[])
   g_test_add_func ("/maplistmodel/create", test_create);
   g_test_add_func ("/maplistmodel/set-model", test_set_model);
   g_test_add_func ("/maplistmodel/set-map-func", test_set_map_func);
+  g_test_add_func ("/maplistmodel/cache-size", test_cache_size);
 
   return g_test_run ();
 }
@@ -0,0 +1,105 @@
+#include <gtk/gtk.h>
+
+#define N_COLUMNS 20
+#define N_ROWS 20
+#define SIZE 10
+
+static gboolean
+is_at (GtkWidget *widget,
+       GtkWidget *parent,
+       double     x,
+       double     y)
+{
+  graphene_rect_t bounds;
+
+  if (!gtk_widget_get_mapped (widget) ||
+      !gtk_widget_compute_bounds (widget, parent, &bounds))
+    return FALSE;
+
+  return bounds.origin.x == x && bounds.origin.y == y;
+}
+
+static void
+wait_for_position (GtkWidget *widget,
+                   GtkWidget *parent,
+                   double     x,
+                   double     y)
+{
+  while (!is_at (widget, parent, x, y))
+    g_main_context_iteration (NULL, TRUE);
+}
+
+static GtkWidget *
+create_child (void)
+{
+  GtkWidget *child = gtk_label_new (NULL);
+
+  gtk_widget_set_size_request (child, SIZE, SIZE);
+
+  return child;
+}
+
+/* Enough children to make the container use its pick index */
+static void
+test_many_children (void)
+{
+  GtkWidget *window, *fixed, *child, *last;
+  GtkWidget *children[N_ROWS][N_COLUMNS];
+  int x, y;
+
+  window = gtk_window_new ();
+  fixed = gtk_fixed_new ();
+  gtk_window_set_child (GTK_WINDOW (window), fixed);
+
+  for (y = 0; y < N_ROWS; y++)
+    for (x = 0; x < N_COLUMNS; x++)
+      {
+        children[y][x] = create_child ();
+        gtk_fixed_put (GTK_FIXED (fixed), children[y][x], x * SIZE, y * SIZE);
+      }
+
+  /* overlaps four children and is on top of them */
+  last = create_child ();
+  gtk_fixed_put (GTK_FIXED (fixed), last, 5 * SIZE + SIZE / 2, 5 * SIZE + SIZE / 2);
+
+  gtk_widget_show (window);
+  wait_for_position (last, fixed, 5 * SIZE + SIZE / 2, 5 * SIZE + SIZE / 2);
+
+  for (y = 0; y < N_ROWS; y++)
+    for (x = 0; x < N_COLUMNS; x++)
+      {
+        child = gtk_widget_pick (fixed, x * SIZE + 1, y * SIZE + 1, GTK_PICK_DEFAULT);
+        g_assert_true (child == children[y][x]);
+      }
+
+  child = gtk_widget_pick (fixed, 6 * SIZE + 1, 6 * SIZE + 1, GTK_PICK_DEFAULT);
+  g_assert_true (child == last);
+  child = gtk_widget_pick (fixed, N_COLUMNS * SIZE + 1, 1, GTK_PICK_DEFAULT);
+  g_assert_true (child == fixed || child == NULL);
+
+  /* moving a child must update the index */
+  gtk_fixed_move (GTK_FIXED (fixed), last, N_COLUMNS * SIZE, 0);
+  wait_for_position (last, fixed, N_COLUMNS * SIZE, 0);
+
+  child = gtk_widget_pick (fixed, 6 * SIZE + 1, 6 * SIZE + 1, GTK_PICK_DEFAULT);
+  g_assert_true (child == children[6][6]);
+  child = gtk_widget_pick (fixed, N_COLUMNS * SIZE + 1, 1, GTK_PICK_DEFAULT);
+  g_assert_true (child == last);
+
+  /* and so must removing one */
+  gtk_fixed_remove (GTK_FIXED (fixed), children[3][3]);
+  child = gtk_widget_pick (fixed, 3 * SIZE + 1, 3 * SIZE + 1, GTK_PICK_DEFAULT);
+  g_assert_true (child == fixed || child == NULL);
+
+  gtk_window_destroy (GTK_WINDOW (window));
+}
+
+int
+main (int argc, char *argv[])
+{
+  gtk_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/pick/many-children", test_many_children);
+
+  return g_test_run ();
+}
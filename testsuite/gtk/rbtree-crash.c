@@ -289,6 +289,52 @@ test_crash2 (void)
   gtk_rb_tree_unref (tree);
 }
 
+static guint
+count (GtkRbTree *tree)
+{
+  Node *node;
+  Aug *aug;
+  guint n;
+
+  node = gtk_rb_tree_get_root (tree);
+  if (node == NULL)
+    return 0;
+
+  aug = gtk_rb_tree_get_augment (tree, node);
+  n = 0;
+  for (node = gtk_rb_tree_get_first (tree); node; node = gtk_rb_tree_node_get_next (node))
+    n++;
+  g_assert_cmpuint (aug->n_items, ==, n);
+
+  return n;
+}
+
+/* Filled trees must stay valid red-black trees when modified */
+static void
+test_fill (void)
+{
+  GtkRbTree *tree;
+  guint n, i;
+
+  for (n = 0; n < 70; n++)
+    {
+      tree = gtk_rb_tree_new (Node, Aug, augment, NULL, NULL);
+
+      gtk_rb_tree_fill (tree, n);
+      g_assert_cmpuint (count (tree), ==, n);
+
+      for (i = 0; i < 50; i++)
+        add (tree, g_test_rand_int_range (0, n + i + 1));
+      g_assert_cmpuint (count (tree), ==, n + 50);
+
+      for (i = 0; i < n + 50; i++)
+        delete (tree, g_test_rand_int_range (0, n + 50 - i));
+      g_assert_cmpuint (count (tree), ==, 0);
+
+      gtk_rb_tree_unref (tree);
+    }
+}
+
 int
 main (int argc, char *argv[])
 {
@@ -297,6 +343,7 @@ main (int argc, char *argv[])
 
   g_test_add_func ("/rbtree/crash", test_crash);
   g_test_add_func ("/rbtree/crash2", test_crash2);
+  g_test_add_func ("/rbtree/fill", test_fill);
 
   return g_test_run ();
 }
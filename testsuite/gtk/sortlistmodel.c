@@ -372,6 +372,27 @@ test_add_items (void)
   g_object_unref (sort);
 }
 
+static void
+test_replace_items (void)
+{
+  GtkSortListModel *sort;
+  GListStore *store;
+
+  /* replacing a single item inserts it instead of resorting */
+  store = new_store ((guint[]) { 20, 2, 38, 10, 4, 30, 6, 14, 8, 12, 16, 18, 22, 24, 26, 28, 32, 34, 36, 40, 0 });
+  sort = new_model (store);
+  assert_model (sort, "2 4 6 8 10 12 14 16 18 20 22 24 26 28 30 32 34 36 38 40");
+  assert_changes (sort, "");
+  splice (store, 0, 1, (guint[]) { 17 }, 1);
+  assert_model (sort, "2 4 6 8 10 12 14 16 17 18 22 24 26 28 30 32 34 36 38 40");
+  assert_changes (sort, "8-2+2");
+  splice (store, 2, 1, (guint[]) { 1 }, 1);
+  assert_model (sort, "1 2 4 6 8 10 12 14 16 17 18 22 24 26 28 30 32 34 36 40");
+  assert_changes (sort, "0-19+19");
+  g_object_unref (store);
+  g_object_unref (sort);
+}
+
 static void
 test_remove_items (void)
 {
@@ -534,6 +555,47 @@ test_out_of_bounds_access (void)
   g_object_unref (sort);
 }
 
+/* large enough to be sorted in the thread pool */
+static void
+test_threaded (void)
+{
+  GtkSortListModel *sort;
+  GtkStringSorter *sorter;
+  GtkStringList *list;
+  GRand *rand;
+  char *prev, *cur;
+  guint i;
+  char buf[32];
+
+  rand = g_rand_new_with_seed (42);
+  list = gtk_string_list_new (NULL);
+  for (i = 0; i < 20000; i++)
+    {
+      g_snprintf (buf, sizeof (buf), "%08x", g_rand_int (rand));
+      gtk_string_list_append (list, buf);
+    }
+  g_rand_free (rand);
+
+  sorter = gtk_string_sorter_new (gtk_property_expression_new (GTK_TYPE_STRING_OBJECT, NULL, "string"));
+  sort = gtk_sort_list_model_new (G_LIST_MODEL (list), GTK_SORTER (sorter));
+
+  g_assert_cmpuint (g_list_model_get_n_items (G_LIST_MODEL (sort)), ==, 20000);
+  prev = NULL;
+  for (i = 0; i < 20000; i++)
+    {
+      GtkStringObject *object = g_list_model_get_item (G_LIST_MODEL (sort), i);
+      cur = g_strdup (gtk_string_object_get_string (object));
+      if (prev)
+        g_assert_cmpstr (prev, <=, cur);
+      g_free (prev);
+      prev = cur;
+      g_object_unref (object);
+    }
+  g_free (prev);
+
+  g_object_unref (sort);
+}
+
 int
 main (int argc, char *argv[])
 {
@@ -550,10 +612,12 @@ main (int argc, char *argv[])
 #if GLIB_CHECK_VERSION (2, 58, 0) /* g_list_store_splice() is broken before 2.58 */
   g_test_add_func ("/sortlistmodel/add_items", test_add_items);
   g_test_add_func ("/sortlistmodel/remove_items", test_remove_items);
+  g_test_add_func ("/sortlistmodel/replace_items", test_replace_items);
 #endif
   g_test_add_func ("/sortlistmodel/stability", test_stability);
   g_test_add_func ("/sortlistmodel/incremental/remove", test_incremental_remove);
   g_test_add_func ("/sortlistmodel/oob-access", test_out_of_bounds_access);
+  g_test_add_func ("/sortlistmodel/threaded", test_threaded);
 
   return g_test_run ();
 }
@@ -252,6 +252,45 @@ test_remove_some (void)
   g_object_unref (tree);
 }
 
+static GListModel *
+count_sub_model_cb (gpointer item,
+                    gpointer data)
+{
+  guint *n_created = data;
+
+  if (!G_IS_LIST_MODEL (item))
+    return NULL;
+
+  (*n_created)++;
+  return g_object_ref (item);
+}
+
+/* Collapsing and expanding a row again reuses its child model */
+static void
+test_expand_cached (void)
+{
+  GtkTreeListModel *tree;
+  GtkTreeListRow *row;
+  guint n_created = 0;
+
+  tree = gtk_tree_list_model_new (G_LIST_MODEL (new_store (100, 100, 100)), TRUE, FALSE, count_sub_model_cb, &n_created, NULL);
+
+  row = gtk_tree_list_model_get_row (tree, 0);
+  g_assert_true (gtk_tree_list_row_is_expandable (row));
+  g_assert_cmpuint (n_created, ==, 1);
+
+  gtk_tree_list_row_set_expanded (row, TRUE);
+  g_assert_cmpuint (g_list_model_get_n_items (G_LIST_MODEL (tree)), ==, 11);
+  gtk_tree_list_row_set_expanded (row, FALSE);
+  g_assert_cmpuint (g_list_model_get_n_items (G_LIST_MODEL (tree)), ==, 1);
+  gtk_tree_list_row_set_expanded (row, TRUE);
+  g_assert_cmpuint (g_list_model_get_n_items (G_LIST_MODEL (tree)), ==, 11);
+  g_assert_cmpuint (n_created, ==, 1);
+
+  g_object_unref (row);
+  g_object_unref (tree);
+}
+
 int
 main (int argc, char *argv[])
 {
@@ -263,6 +302,7 @@ main (int argc, char *argv[])
 
   g_test_add_func ("/treelistmodel/expand", test_expand);
   g_test_add_func ("/treelistmodel/remove_some", test_remove_some);
+  g_test_add_func ("/treelistmodel/expand_cached", test_expand_cached);
 
   return g_test_run ();
 }
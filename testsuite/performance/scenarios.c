@@ -0,0 +1,450 @@
+#include <glib/gstdio.h>
+#include <gtk/gtk.h>
+
+/* Scripted scenarios for test-performance --frames.
+ *
+ * Each scenario builds a window, changes something on every frame
+ * and quits after a fixed number of frames. The window is redrawn
+ * on every frame, so GDK reports the timings of every frame to
+ * sysprof, and test-performance turns them into percentiles.
+ */
+
+#define N_FRAMES 300
+
+static GtkWidget *window;
+static gboolean done;
+
+/* columnview: scroll through a million rows */
+
+#define N_ROWS 1000000
+
+static GtkAdjustment *scroll_adjustment;
+
+static void
+setup_label (GtkSignalListItemFactory *factory,
+             GtkListItem              *item)
+{
+  gtk_list_item_set_child (item, gtk_label_new (NULL));
+}
+
+static void
+bind_label (GtkSignalListItemFactory *factory,
+            GtkListItem              *item)
+{
+  GtkStringObject *string = gtk_list_item_get_item (item);
+
+  gtk_label_set_label (GTK_LABEL (gtk_list_item_get_child (item)),
+                       gtk_string_object_get_string (string));
+}
+
+static GtkWidget *
+create_column_view (void)
+{
+  GtkStringList *list;
+  GtkWidget *view, *sw;
+  guint i;
+
+  list = gtk_string_list_new (NULL);
+  for (i = 0; i < N_ROWS; i++)
+    gtk_string_list_take (list, g_strdup_printf ("Row %u", i));
+
+  view = gtk_column_view_new (GTK_SELECTION_MODEL (gtk_no_selection_new (G_LIST_MODEL (list))));
+
+  for (i = 0; i < 3; i++)
+    {
+      GtkListItemFactory *factory;
+      GtkColumnViewColumn *column;
+      char *title;
+
+      factory = gtk_signal_list_item_factory_new ();
+      g_signal_connect (factory, "setup", G_CALLBACK (setup_label), NULL);
+      g_signal_connect (factory, "bind", G_CALLBACK (bind_label), NULL);
+
+      title = g_strdup_printf ("Column %u", i);
+      column = gtk_column_view_column_new (title, factory);
+      gtk_column_view_append_column (GTK_COLUMN_VIEW (view), column);
+      g_object_unref (column);
+      g_free (title);
+    }
+
+  scroll_adjustment = gtk_scrollable_get_vadjustment (GTK_SCROLLABLE (view));
+
+  sw = gtk_scrolled_window_new ();
+  gtk_scrolled_window_set_child (GTK_SCROLLED_WINDOW (sw), view);
+
+  return sw;
+}
+
+static void
+frame_column_view (guint frame)
+{
+  double upper, page_size;
+
+  upper = gtk_adjustment_get_upper (scroll_adjustment);
+  page_size = gtk_adjustment_get_page_size (scroll_adjustment);
+
+  gtk_adjustment_set_value (scroll_adjustment, (upper - page_size) * frame / N_FRAMES);
+}
+
+/* textview: type into a 50 MB buffer */
+
+#define TEXT_SIZE (50 * 1024 * 1024)
+
+static GtkTextBuffer *text_buffer;
+
+static GtkWidget *
+create_text_view (void)
+{
+  GtkWidget *view, *sw;
+  GtkTextIter iter;
+  GString *text;
+  guint line;
+
+  text = g_string_sized_new (TEXT_SIZE + 128);
+  for (line = 0; text->len < TEXT_SIZE; line++)
+    g_string_append_printf (text, "%u: The quick brown fox jumps over the lazy dog.\n", line);
+
+  text_buffer = gtk_text_buffer_new (NULL);
+  gtk_text_buffer_set_text (text_buffer, text->str, text->len);
+  g_string_free (text, TRUE);
+
+  gtk_text_buffer_get_iter_at_line (text_buffer, &iter, line / 2);
+  gtk_text_buffer_place_cursor (text_buffer, &iter);
+
+  view = gtk_text_view_new_with_buffer (text_buffer);
+  g_object_unref (text_buffer);
+
+  sw = gtk_scrolled_window_new ();
+  gtk_scrolled_window_set_child (GTK_SCROLLED_WINDOW (sw), view);
+
+  gtk_text_view_scroll_to_mark (GTK_TEXT_VIEW (view),
+                                gtk_text_buffer_get_insert (text_buffer),
+                                0.0, TRUE, 0.0, 0.5);
+
+  return sw;
+}
+
+static void
+frame_text_view (guint frame)
+{
+  if (frame % 60 == 59)
+    gtk_text_buffer_insert_at_cursor (text_buffer, "\n", 1);
+  else
+    gtk_text_buffer_insert_at_cursor (text_buffer, &"abcdefghijklmnopqrstuvwxyz"[frame % 26], 1);
+}
+
+/* theme: switch between the light and dark theme with 20000 widgets */
+
+#define N_THEME_WIDGETS 20000
+
+static GtkWidget *
+create_theme (void)
+{
+  GtkWidget *box, *row = NULL, *sw;
+  guint i;
+
+  box = gtk_box_new (GTK_ORIENTATION_VERTICAL, 0);
+  for (i = 0; i < N_THEME_WIDGETS; i++)
+    {
+      GtkWidget *child;
+
+      if (i % 20 == 0)
+        {
+          row = gtk_box_new (GTK_ORIENTATION_HORIZONTAL, 0);
+          gtk_box_append (GTK_BOX (box), row);
+        }
+
+      switch (i % 4)
+        {
+        case 0:
+          child = gtk_button_new_with_label ("Button");
+          break;
+        case 1:
+          child = gtk_check_button_new_with_label ("Check");
+          break;
+        case 2:
+          child = gtk_entry_new ();
+          gtk_editable_set_width_chars (GTK_EDITABLE (child), 4);
+          break;
+        default:
+          child = gtk_label_new ("Label");
+          break;
+        }
+
+      gtk_box_append (GTK_BOX (row), child);
+    }
+
+  sw = gtk_scrolled_window_new ();
+  gtk_scrolled_window_set_child (GTK_SCROLLED_WINDOW (sw), box);
+
+  return sw;
+}
+
+static void
+frame_theme (guint frame)
+{
+  if (frame % 10 == 0)
+    g_object_set (gtk_settings_get_default (),
+                  "gtk-application-prefer-dark-theme", (frame / 10) % 2 == 1,
+                  NULL);
+}
+
+/* filechooser: show a directory with 100000 files */
+
+#define N_FILES 100000
+
+static char *file_chooser_dir;
+
+static GtkWidget *
+create_file_chooser (void)
+{
+  GError *error = NULL;
+  GtkWidget *chooser;
+  GFile *file;
+  guint i;
+
+  file_chooser_dir = g_dir_make_tmp ("gtk-performance-XXXXXX", &error);
+  if (file_chooser_dir == NULL)
+    g_error ("Creating directory: %s", error->message);
+
+  for (i = 0; i < N_FILES; i++)
+    {
+      char *name, *path;
+
+      name = g_strdup_printf ("file-%06u.txt", i);
+      path = g_build_filename (file_chooser_dir, name, NULL);
+      if (!g_file_set_contents (path, "", 0, &error))
+        g_error ("Creating file: %s", error->message);
+      g_free (path);
+      g_free (name);
+    }
+
+  chooser = gtk_file_chooser_widget_new (GTK_FILE_CHOOSER_ACTION_OPEN);
+
+  file = g_file_new_for_path (file_chooser_dir);
+  if (!gtk_file_chooser_set_current_folder (GTK_FILE_CHOOSER (chooser), file, &error))
+    g_error ("Setting folder: %s", error->message);
+  g_object_unref (file);
+
+  return chooser;
+}
+
+static void
+frame_file_chooser (guint frame)
+{
+  /* Nothing to do, the directory is loaded while frames are drawn */
+}
+
+static void
+cleanup_file_chooser (void)
+{
+  const char *name;
+  GDir *dir;
+
+  dir = g_dir_open (file_chooser_dir, 0, NULL);
+  while ((name = g_dir_read_name (dir)))
+    {
+      char *path = g_build_filename (file_chooser_dir, name, NULL);
+      g_remove (path);
+      g_free (path);
+    }
+  g_dir_close (dir);
+
+  g_rmdir (file_chooser_dir);
+  g_free (file_chooser_dir);
+}
+
+/* constraints: resize a window with a constraint layout */
+
+#define N_CONSTRAINT_ROWS 10
+#define N_CONSTRAINT_COLUMNS 10
+
+typedef GtkWidget ConstraintGrid;
+typedef GtkWidgetClass ConstraintGridClass;
+
+G_DEFINE_TYPE (ConstraintGrid, constraint_grid, GTK_TYPE_WIDGET)
+
+static void
+constraint_grid_dispose (GObject *object)
+{
+  GtkWidget *child;
+
+  while ((child = gtk_widget_get_first_child (GTK_WIDGET (object))))
+    gtk_widget_unparent (child);
+
+  G_OBJECT_CLASS (constraint_grid_parent_class)->dispose (object);
+}
+
+static void
+constraint_grid_class_init (ConstraintGridClass *klass)
+{
+  G_OBJECT_CLASS (klass)->dispose = constraint_grid_dispose;
+
+  gtk_widget_class_set_layout_manager_type (klass, GTK_TYPE_CONSTRAINT_LAYOUT);
+}
+
+static void
+constraint_grid_init (ConstraintGrid *grid)
+{
+}
+
+static GtkWidget *
+create_constraints (void)
+{
+  GtkLayoutManager *layout;
+  GHashTable *views;
+  GPtrArray *lines;
+  GError *error = NULL;
+  GtkWidget *grid;
+  GList *constraints;
+  GString *line;
+  guint r, c;
+
+  grid = g_object_new (constraint_grid_get_type (), NULL);
+  layout = gtk_widget_get_layout_manager (grid);
+
+  views = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+  lines = g_ptr_array_new_with_free_func (g_free);
+
+  for (r = 0; r < N_CONSTRAINT_ROWS; r++)
+    {
+      for (c = 0; c < N_CONSTRAINT_COLUMNS; c++)
+        {
+          GtkWidget *button = gtk_button_new_with_label ("Button");
+
+          gtk_widget_set_parent (button, grid);
+          g_hash_table_insert (views, g_strdup_printf ("b%u_%u", r, c), button);
+        }
+    }
+
+  /* Every row and every column spans the layout with equally sized cells */
+  for (r = 0; r < N_CONSTRAINT_ROWS; r++)
+    {
+      line = g_string_new ("H:|-");
+      for (c = 0; c < N_CONSTRAINT_COLUMNS; c++)
+        {
+          if (c == 0)
+            g_string_append_printf (line, "[b%u_%u]-", r, c);
+          else
+            g_string_append_printf (line, "[b%u_%u(==b%u_0)]-", r, c, r);
+        }
+      g_string_append (line, "|");
+      g_ptr_array_add (lines, g_string_free (line, FALSE));
+    }
+
+  for (c = 0; c < N_CONSTRAINT_COLUMNS; c++)
+    {
+      line = g_string_new ("V:|-");
+      for (r = 0; r < N_CONSTRAINT_ROWS; r++)
+        {
+          if (r == 0)
+            g_string_append_printf (line, "[b%u_%u]-", r, c);
+          else
+            g_string_append_printf (line, "[b%u_%u(==b0_%u)]-", r, c, c);
+        }
+      g_string_append (line, "|");
+      g_ptr_array_add (lines, g_string_free (line, FALSE));
+    }
+
+  constraints = gtk_constraint_layout_add_constraints_from_descriptionv (GTK_CONSTRAINT_LAYOUT (layout),
+                                                                         (const char * const *) lines->pdata,
+                                                                         lines->len,
+                                                                         8, 8,
+                                                                         views,
+                                                                         &error);
+  if (error)
+    g_error ("Adding constraints: %s", error->message);
+
+  g_list_free (constraints);
+  g_ptr_array_unref (lines);
+  g_hash_table_unref (views);
+
+  return grid;
+}
+
+static void
+frame_constraints (guint frame)
+{
+  /* Grow and shrink the window over a second */
+  guint step = frame % 60 < 30 ? frame % 30 : 30 - frame % 30;
+
+  gtk_window_set_default_size (GTK_WINDOW (window), 800 + 20 * step, 600 + 10 * step);
+}
+
+static const struct {
+  const char *name;
+  GtkWidget * (* create) (void);
+  void (* frame) (guint frame);
+  void (* cleanup) (void);
+} scenarios[] = {
+  { "columnview", create_column_view, frame_column_view, NULL },
+  { "textview", create_text_view, frame_text_view, NULL },
+  { "theme", create_theme, frame_theme, NULL },
+  { "filechooser", create_file_chooser, frame_file_chooser, cleanup_file_chooser },
+  { "constraints", create_constraints, frame_constraints, NULL },
+};
+
+static gboolean
+tick_cb (GtkWidget     *widget,
+         GdkFrameClock *frame_clock,
+         gpointer       data)
+{
+  guint scenario = GPOINTER_TO_UINT (data);
+  static guint n_frames = 0;
+
+  if (n_frames == N_FRAMES)
+    {
+      done = TRUE;
+      return G_SOURCE_REMOVE;
+    }
+
+  scenarios[scenario].frame (n_frames++);
+  gtk_widget_queue_draw (widget);
+
+  return G_SOURCE_CONTINUE;
+}
+
+int
+main (int argc, char *argv[])
+{
+  guint i;
+
+  if (argc != 2)
+    {
+      g_printerr ("Usage: %s SCENARIO\n", argv[0]);
+      return 1;
+    }
+
+  gtk_init ();
+
+  for (i = 0; i < G_N_ELEMENTS (scenarios); i++)
+    {
+      if (g_str_equal (scenarios[i].name, argv[1]))
+        break;
+    }
+
+  if (i == G_N_ELEMENTS (scenarios))
+    {
+      g_printerr ("Unknown scenario %s. Available scenarios:", argv[1]);
+      for (i = 0; i < G_N_ELEMENTS (scenarios); i++)
+        g_printerr (" %s", scenarios[i].name);
+      g_printerr ("\n");
+      return 1;
+    }
+
+  window = gtk_window_new ();
+  gtk_window_set_default_size (GTK_WINDOW (window), 800, 600);
+  gtk_window_set_child (GTK_WINDOW (window), scenarios[i].create ());
+  gtk_widget_add_tick_callback (window, tick_cb, GUINT_TO_POINTER (i), NULL);
+  gtk_window_present (GTK_WINDOW (window));
+
+  while (!done)
+    g_main_context_iteration (NULL, TRUE);
+
+  gtk_window_destroy (GTK_WINDOW (window));
+
+  if (scenarios[i].cleanup)
+    scenarios[i].cleanup ();
+
+  return 0;
+}
@@ -39,6 +39,92 @@ callback (const SysprofCaptureFrame *frame,
   return TRUE;
 }
 
+typedef struct {
+  GArray *presented;
+  GArray *drawn;
+} FrameData;
+
+/* GDK adds a mark for the drawn and presented time of every frame
+ * from its GdkFrameTimings, see _gdk_frame_clock_add_timings_to_profiler().
+ */
+static bool
+frame_callback (const SysprofCaptureFrame *frame,
+                gpointer                   user_data)
+{
+  FrameData *data = user_data;
+
+  if (frame->type == SYSPROF_CAPTURE_FRAME_MARK)
+    {
+      SysprofCaptureMark *mark = (SysprofCaptureMark *)frame;
+      if (strcmp (mark->group, "gtk") == 0)
+        {
+          if (strcmp (mark->name, "presented window") == 0)
+            g_array_append_val (data->presented, frame->time);
+          else if (strcmp (mark->name, "drawn window") == 0)
+            g_array_append_val (data->drawn, frame->time);
+        }
+    }
+
+  return TRUE;
+}
+
+/* The first frames of a run include startup work */
+#define FRAME_WARMUP 10
+
+static void
+collect_frame_times (SysprofCaptureReader *reader,
+                     GArray               *frame_times)
+{
+  SysprofCaptureCursor *cursor;
+  SysprofCaptureCondition *condition;
+  SysprofCaptureFrameType type;
+  FrameData data;
+  GArray *times;
+  guint i;
+
+  data.presented = g_array_new (FALSE, FALSE, sizeof (gint64));
+  data.drawn = g_array_new (FALSE, FALSE, sizeof (gint64));
+
+  cursor = sysprof_capture_cursor_new (reader);
+
+  type = SYSPROF_CAPTURE_FRAME_MARK;
+  condition = sysprof_capture_condition_new_where_type_in (1, &type);
+  sysprof_capture_cursor_add_condition (cursor, condition);
+
+  sysprof_capture_cursor_foreach (cursor, frame_callback, &data);
+
+  sysprof_capture_cursor_unref (cursor);
+
+  /* Not all backends report presentation times */
+  times = data.presented->len > 0 ? data.presented : data.drawn;
+
+  for (i = FRAME_WARMUP + 1; i < times->len; i++)
+    {
+      gint64 frame_time = g_array_index (times, gint64, i) - g_array_index (times, gint64, i - 1);
+      g_array_append_val (frame_times, frame_time);
+    }
+
+  g_array_unref (data.presented);
+  g_array_unref (data.drawn);
+}
+
+static int
+compare_times (gconstpointer a,
+               gconstpointer b)
+{
+  gint64 ta = *(const gint64 *) a;
+  gint64 tb = *(const gint64 *) b;
+
+  return ta < tb ? -1 : (ta > tb ? 1 : 0);
+}
+
+static gint64
+percentile (GArray *sorted,
+            guint   p)
+{
+  return g_array_index (sorted, gint64, (sorted->len - 1) * p / 100);
+}
+
 #define MILLISECONDS(v) ((v) / (1000.0 * G_TIME_SPAN_MILLISECOND))
 
 static int opt_rep = 10;
@@ -47,6 +133,7 @@ static char *opt_detail;
 static char *opt_name;
 static char *opt_output;
 static gboolean opt_start_time;
+static gboolean opt_frames;
 static GMainLoop *main_loop;
 static GError *failure;
 
@@ -54,6 +141,7 @@ static GOptionEntry options[] = {
   { "mark", 0, G_OPTION_FLAG_NONE, G_OPTION_ARG_STRING, &opt_mark, "Name of the mark", "NAME" },
   { "detail", 0, G_OPTION_FLAG_NONE, G_OPTION_ARG_STRING, &opt_detail, "Detail of the mark", "DETAIL" },
   { "start", 0, G_OPTION_FLAG_NONE, G_OPTION_ARG_NONE, &opt_start_time, "Measure the start time", NULL },
+  { "frames", 0, G_OPTION_FLAG_NONE, G_OPTION_ARG_NONE, &opt_frames, "Measure frame times instead of a mark", NULL },
   { "runs", '0', G_OPTION_FLAG_NONE, G_OPTION_ARG_INT, &opt_rep, "Number of runs", "COUNT" },
   { "name", '0', G_OPTION_FLAG_NONE, G_OPTION_ARG_STRING, &opt_name, "Name of this test", "NAME" },
   { "output", '0', G_OPTION_FLAG_NONE, G_OPTION_ARG_STRING, &opt_output, "Directory to save syscap files", "DIRECTORY" },
@@ -91,6 +179,7 @@ main (int argc, char *argv[])
   Data data;
   SysprofCaptureFrameType type;
   gint64 *values;
+  GArray *frame_times;
   gint64 min, max, total;
   int count;
   char *output_dir = NULL;
@@ -147,6 +236,7 @@ main (int argc, char *argv[])
   opt_rep++;
 
   values = g_new (gint64, opt_rep);
+  frame_times = g_array_new (FALSE, FALSE, sizeof (gint64));
 
   for (i = 0; i < opt_rep; i++)
     {
@@ -198,6 +288,10 @@ main (int argc, char *argv[])
 
       sysprof_capture_writer_unref (writer);
 
+      /* Ignore the first run, to avoid cache effects */
+      if (opt_frames && i > 0)
+        collect_frame_times (reader, frame_times);
+
       data.mark = opt_mark ? opt_mark : "css validation";
       data.detail = opt_detail ? opt_detail : NULL;
       data.do_start = opt_start_time;
@@ -244,6 +338,27 @@ main (int argc, char *argv[])
 
   g_free (workdir);
 
+  if (opt_frames)
+    {
+      if (frame_times->len == 0)
+        g_error ("No frames were recorded");
+
+      g_array_sort (frame_times, compare_times);
+
+      g_print ("%d runs, %u frames, p50 %g, p95 %g, p99 %g, max %g\n",
+               opt_rep - 1,
+               frame_times->len,
+               MILLISECONDS (percentile (frame_times, 50)),
+               MILLISECONDS (percentile (frame_times, 95)),
+               MILLISECONDS (percentile (frame_times, 99)),
+               MILLISECONDS (percentile (frame_times, 100)));
+
+      g_array_unref (frame_times);
+      return 0;
+    }
+
+  g_array_unref (frame_times);
+
   min = G_MAXINT64;
   max = 0;
   count = 0;